@@ -30,10 +30,13 @@ class SqlToolAccess(object):
     beginnings of ODBC tooltable access
     '''
 
-    def __init__(self,inifile,random_toolchanger):
+    def __init__(self,inifile,random_toolchanger,filename):
         print "SQL tt init"
         self.inifile = inifile
         self.random_toolchanger = random_toolchanger
+        # the tools are loaded through this file, which task, halui and
+        # the GUIs reload from
+        self.filename = filename
         self.persist =  int(self.inifile.find("TOOL", "SAVE_TOOLSTATE") or 0)
 
         self.connectstring = self.inifile.find("TOOL", "ODBC_CONNECT")
@@ -46,57 +49,57 @@ class SqlToolAccess(object):
         conn.close()
 
 
-    def load_table(self, tooltable,comments,fms):
+    def load_table(self, tools):
         ''' populate the table'''
         try:
             conn = pyodbc.connect(self.connectstring)
             conn.autocommit = True
 
             cursor = conn.cursor()
-            cursor.execute("select * from tools;")
+            cursor.execute("select * from tools order by pocket;")
 
+            fp = open(self.filename + '.tmp', 'w')
             for row in cursor.fetchall():
-                pocket = row.pocket
-                t = tooltable[pocket]
-                t.toolno = row.toolno
-                t.orientation = row.orientation
-                t.diameter = row.diameter
-                t.frontangle = row.frontangle
-                t.backangle = row.backangle
-                t.offset.tran.x = row.x_offset
-                t.offset.y = row.y_offset
-                t.offset.z = row.z_offset
-                t.offset.a = row.a_offset
-                t.offset.b = row.b_offset
-                t.offset.c = row.c_offset
-                t.offset.u = row.u_offset
-                t.offset.v = row.v_offset
-                t.offset.w = row.w_offset
+                print >> fp, "T%d P%d D%f I%+f J%+f Q%d" % (row.toolno, row.pocket,
+                    row.diameter, row.frontangle, row.backangle, row.orientation),
+                print >> fp, "X%+f Y%+f Z%+f A%+f B%+f C%+f U%+f V%+f W%+f" % (
+                    row.x_offset, row.y_offset, row.z_offset,
+                    row.a_offset, row.b_offset, row.c_offset,
+                    row.u_offset, row.v_offset, row.w_offset),
+                print >> fp, ";%s" % (row.comment or "")
+            fp.close()
+            os.rename(self.filename + '.tmp', self.filename)
+            if tools.load(self.filename, self.random_toolchanger):
+                raise IOError, "can't read tool table %s" % (self.filename)
 
         except pyodbc.Error, e:
             traceback.print_exc(file=sys.stdout)
         else:
             start = 0 if self.random_toolchanger else 1
-            for p in range(start,len(tooltable)):
-                t = tooltable[p]
+            for p in range(start,tools.pockets()):
+                t = tools.get(p)
                 if t.toolno != -1: print str(t)
         finally:
             cursor.close()
             conn.close()
 
-    def save_table(self, tooltable, comments,fms):
+    def save_table(self, tools):
+        # the file first, for the followers
+        if tools.save(self.filename, self.random_toolchanger):
+            print "saving %s failed" % (self.filename)
         try:
             conn = pyodbc.connect(self.connectstring)
             conn.autocommit = True
             cursor = conn.cursor()
             cursor.execute("delete from tools;")
             start = 0 if self.random_toolchanger else 1
-            for p in range(start,len(tooltable)):
-                t = tooltable[p]
+            for p in range(start,tools.pockets()):
+                t = tools.get(p)
                 if t.toolno != -1:
-                    cursor.execute("insert into tools values(?,?,?,?,?,?,'?',?,?,?,?,?,?,?,?,?);",
-                                        (t.toolno, p, t.diameter, t.backangle,t.frontangle,t.orientation,
-                                         comment[p],t.offset.x,t.offset.y,t.offset.z,t.offset.a,t.offset.b,
+                    pocket = p if self.random_toolchanger else tools.fms(p)
+                    cursor.execute("insert into tools values(?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?);",
+                                        (t.toolno, pocket, t.diameter, t.backangle,t.frontangle,t.orientation,
+                                         tools.comment(p),t.offset.x,t.offset.y,t.offset.z,t.offset.a,t.offset.b,
                                          t.offset.c,t.offset.u,t.offset.v,t.offset.w))
         except pyodbc.Error, msg:
             print "saving tooltable failed:"
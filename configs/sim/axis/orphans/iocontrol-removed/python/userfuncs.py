@@ -52,7 +52,7 @@ class UserFuncs(object):
         print "state=",e.task.state
         print "file=",e.task.file
         print "toolOffset=",str(e.task.toolOffset)
-        print "tooltable[0]=",e.io.tool.toolTable[0]
+        print "tooltable[0]=",self.tools.get(0)
         print "g5x_offset=", e.task.g5x_offset, "system=",e.task.g5x_index
         return emctask.RCS_STATUS.RCS_DONE
 
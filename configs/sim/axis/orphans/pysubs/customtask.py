@@ -105,9 +105,9 @@ class CustomTask(emctask.Task,UserFuncs):
             self.io.aux.estop = 1
             self._callback = None
             self._check = None
-            tt = self.io.tool.toolTable
-            for p in range(0,len(tt)):
-                tt[p].zero()
+            # the tool table; changes reach task and the GUIs through
+            # publish(), which fills in self.io.tool
+            self.tools = emctask.ToolStore()
             UserFuncs.__init__(self)
             self.enqueue = EnqueueCall(self)
         except Exception,e:
@@ -132,21 +132,21 @@ class CustomTask(emctask.Task,UserFuncs):
             self.hal_init_pins()
             # on nonrandom machines, always start by assuming the spindle is empty
             if not self.random_toolchanger:
-                 self.io.tool.toolTable[0].zero()
+                self.set_spindle(0)
 
             if self.inifile.find("TOOL", "ODBC_CONNECT"):
                 import sqltoolaccess
-                self.tt = sqltoolaccess.SqlToolAccess(self.inifile, self.random_toolchanger)
+                self.tt = sqltoolaccess.SqlToolAccess(self.inifile, self.random_toolchanger,
+                                                      self.tooltable_filename)
             else:
                 import tooltable
                 self.tt = tooltable.EmcToolTable(self.tooltable_filename, self.random_toolchanger)
 
-            self.comments = dict()
-            self.fms = dict()
-            self.tt.load_table(self.io.tool.toolTable,self.comments,self.fms)
+            self.tt.load_table(self.tools)
             self.tt.restore_state(emctask.emcstat)
             # self.io.tool.toolInSpindle = 2 # works
             self.reload_tool_number(self.io.tool.toolInSpindle)
+            self.tools.publish(self.io.tool)
 
         except Exception,e:
             print "emcIoInit",e
@@ -160,15 +160,14 @@ class CustomTask(emctask.Task,UserFuncs):
     def emcToolLoadToolTable(self,file):
         # triggered by UI if tooltable was edited
         if debug(): print "py:  emcToolLoadToolTable file = '%s'" % (file)
-        self.comments = dict()
-        self.fms = dict()
         try:
-            self.tt.load_table(self.io.tool.toolTable,self.comments,self.fms)
+            self.tt.load_table(self.tools)
         except Exception,e:
             print_exc_plus()
             self.io.status  = emctask.RCS_STATUS.RCS_ERROR
         else:
             self.reload_tool_number(self.io.tool.toolInSpindle)
+            self.tools.publish(self.io.tool)
             self.io.status  = emctask.RCS_STATUS.RCS_DONE
         return 0
 
@@ -190,7 +189,7 @@ class CustomTask(emctask.Task,UserFuncs):
             if not self.random_toolchanger and (p == 0):
                 self.hal["tool-prep-number"] = 0
             else:
-                self.hal["tool-prep-number"] = self.io.tool.toolTable[p].toolno
+                self.hal["tool-prep-number"] = self.tools.get(p).toolno
 
                 self.hal["tool-prepare"] = 1
 
@@ -203,28 +202,33 @@ class CustomTask(emctask.Task,UserFuncs):
 
     def reload_tool_number(self, toolno):
         if self.random_toolchanger: return
-        t = self.io.tool.toolTable
-        for p in range(1,len(t)):
-            if toolno == t[p].toolno:
-                self.load_tool(p)
+        p = self.tools.find(toolno)
+        if p > 0:
+            self.load_tool(p)
+
+    def set_spindle(self,pocket):
+        # nonrandom toolchanger: pocket 0 holds a copy of the tool loaded
+        if pocket == 0:
+            t = self.tools.get(0)
+            t.zero()
+            self.tools.set(0, t)
+        else:
+            self.tools.set(0, self.tools.get(pocket))
 
     def load_tool(self,pocket):
         if self.random_toolchanger:
-            self.io.tool.toolTable[0],self.io.tool.toolTable[pocket] = self.io.tool.toolTable[pocket],self.io.tool.toolTable[0]
-            self.comments[0],self.comments[pocket] = self.comments[pocket],self.comments[0]
-            self.tt.save_table(self.io.tool.toolTable,self.comments,self.fms)
+            self.tools.swap(0, pocket)
+            self.tt.save_table(self.tools)
         else:
-            if pocket == 0:
-                self.io.tool.toolTable[0].zero()
-            else:
-                self.io.tool.toolTable[0] = self.io.tool.toolTable[pocket]
+            self.set_spindle(pocket)
+        self.tools.publish(self.io.tool)
 
     def change_complete(self):
         if debug(): print "change complete"
         if not self.random_toolchanger and (self.io.tool.pocketPrepped == 0):
             self.io.tool.toolInSpindle = 0
         else:
-            self.io.tool.toolInSpindle = self.io.tool.toolTable[self.io.tool.pocketPrepped].toolno
+            self.io.tool.toolInSpindle = self.tools.get(self.io.tool.pocketPrepped).toolno
         self.hal["tool-number"] = self.io.tool.toolInSpindle
         self.load_tool(self.io.tool.pocketPrepped)
         self.io.tool.pocketPrepped = -1
@@ -241,7 +245,7 @@ class CustomTask(emctask.Task,UserFuncs):
 
         if not self.random_toolchanger and (self.io.tool.pocketPrepped > 0) and (
             self.io.tool.toolInSpindle ==
-            self.io.tool.toolTable[self.io.tool.pocketPrepped].toolno):
+            self.tools.get(self.io.tool.pocketPrepped).toolno):
 
             self.io.status  = emctask.RCS_STATUS.RCS_DONE
             return 0
@@ -258,7 +262,7 @@ class CustomTask(emctask.Task,UserFuncs):
             if not self.random_toolchanger and (self.io.tool.pocketPrepped == 0):
                 self.io.tool.toolInSpindle = 0
             else:
-                self.io.tool.toolInSpindle = self.io.tool.toolTable[self.io.tool.pocketPrepped].toolno
+                self.io.tool.toolInSpindle = self.tools.get(self.io.tool.pocketPrepped).toolno
             self.load_tool(self.io.tool.pocketPrepped)
             self.io.tool.pocketPrepped = -1
             self.io.status  = emctask.RCS_STATUS.RCS_DONE
@@ -283,19 +287,22 @@ class CustomTask(emctask.Task,UserFuncs):
     def emcToolSetOffset(self,pocket,toolno,offset,diameter,frontangle,backangle,orientation):
         if debug(): print "py:  emcToolSetOffset", pocket,toolno,str(offset),diameter,frontangle,backangle,orientation
 
-        self.io.tool.toolTable[pocket].toolno = toolno
-        self.io.tool.toolTable[pocket].orientation = orientation
-        self.io.tool.toolTable[pocket].diameter = diameter
-        self.io.tool.toolTable[pocket].frontangle = frontangle
-        self.io.tool.toolTable[pocket].backangle = backangle
-        self.io.tool.toolTable[pocket].offset = offset
+        t = self.tools.get(pocket)
+        t.toolno = toolno
+        t.orientation = orientation
+        t.diameter = diameter
+        t.frontangle = frontangle
+        t.backangle = backangle
+        t.offset = offset
+        self.tools.set(pocket, t)
 
-        if debug(): print "new tool enttry: ",str(self.io.tool.toolTable[pocket])
+        if debug(): print "new tool enttry: ",str(t)
 
         if self.io.tool.toolInSpindle  == toolno:
-            self.io.tool.toolTable[0] = self.io.tool.toolTable[pocket]
+            self.tools.set(0, t)
 
-        self.tt.save_table(self.io.tool.toolTable,self.comments,self.fms)
+        self.tt.save_table(self.tools)
+        self.tools.publish(self.io.tool)
         self.io.status  = emctask.RCS_STATUS.RCS_DONE
         return 0
 
@@ -69,3 +69,24 @@ class component(_hal.component):
 
     def getpin(self, *a, **kw): return Pin(_hal.component.getpin(self, *a, **kw))
     def getparam(self, *a, **kw): return Param(_hal.component.getparam(self, *a, **kw))
+
+class batch(object):
+    """Make a set of configuration changes all at once:
+
+    with hal.batch():
+        hal.new_sig("spindle-on", hal.HAL_BIT)
+        hal.connect("motion.spindle-on", "spindle-on")
+        hal.set_p("pid.0.Pgain", "100")
+
+    The changes are queued and made when the block ends.  If one of
+    them fails, or the block raises an exception, none are made."""
+    def __enter__(self):
+        _hal.begin_batch()
+        return self
+
+    def __exit__(self, exc_type, exc_value, tb):
+        if exc_type is not None:
+            _hal.abort_batch()
+        else:
+            _hal.commit_batch()
+        return False
@@ -145,6 +145,9 @@ class StatMixin:
         else:
             self.tools[0] = self.tools[pocket]
 
+    def get_pockets_max(self):
+        return len(self.tools)
+
     def get_tool(self, pocket):
         if pocket >= 0 and pocket < len(self.tools):
             return tuple(self.tools[pocket])
@@ -47,16 +47,27 @@
   which typically come out of one of Tom Kramer's interpreters.
   The first two columns are ignored, the rest is converted to
   equivalent canonical calls.
+
+  It also replays binary canon traces written by 'rs274 -o', see
+  canon_trace.hh.  A trace is mapped rather than read, each read()
+  steps to the next record and execute() makes its call with the
+  record's source line number, so the status shows the line of the
+  original program.
 */
 
 #include <stdio.h>		// FILE, fopen(), fclose()
 #include <string.h>		// strcpy()
 #include <ctype.h>		// isspace()
 #include <limits.h>
+#include <fcntl.h>		// open()
+#include <unistd.h>		// close()
+#include <sys/mman.h>		// mmap()
+#include <sys/stat.h>		// fstat()
 #include <algorithm>
 #include "config.h"
 #include "emc/nml_intf/interp_return.hh"
 #include "emc/nml_intf/canon.hh"
+#include "emc/nml_intf/canon_trace.hh"
 #include "emc/rs274ngc/interp_base.hh"
 
 static char the_command[LINELEN] = { 0 };	// our current command
@@ -65,7 +76,7 @@ static char the_command_args[LINELEN] = { 0 };	// just the args part
 
 class Canterp : public InterpBase {
 public:
-    Canterp () : f(0) {}
+    Canterp () : f(0), trace(0), trace_len(0), trace_next(0), rec(0) {}
     char *error_text(int errcode, char *buf, size_t buflen);
     char *stack_name(int index, char *buf, size_t buflen);
     char *line_text(char *buf, size_t buflen);
@@ -96,6 +107,15 @@ public:
     void set_loop_on_main_m99(bool state);
     FILE *f;
     char filename[PATH_MAX];
+
+    // the binary canon trace, if that is what's open
+    int open_trace(const char *newfilename);
+    int execute_record();
+    const char *trace;
+    size_t trace_len;
+    size_t trace_next;		// offset of the record read() returns next
+    const canon_trace_record *rec;	// the record read() returned last
+    char source[CANON_TRACE_SOURCE_LEN];
 };
 
 char *Canterp::error_text(int errcode, char *buf, size_t buflen) {
@@ -241,6 +261,17 @@ int Canterp::read(const char *line) {
 
 int Canterp::read() {
     char buf[LINELEN];
+    if(trace) {
+	const canon_trace_record *r;
+	if(trace_next + sizeof(*r) > trace_len) return INTERP_ERROR;
+	r = (const canon_trace_record *) (trace + trace_next);
+	if(trace_next + canon_trace_record_size(r) > trace_len)
+	    return INTERP_ERROR;
+	rec = r;
+	if(r->op == CANON_TRACE_END) return INTERP_ENDFILE;
+	trace_next += canon_trace_record_size(r);
+	return INTERP_OK;
+    }
     if(!f) return INTERP_ERROR;
     if(!fgets(buf, sizeof(buf), f)) return INTERP_ENDFILE;
     return canterp_parse(buf);
@@ -252,6 +283,10 @@ int Canterp::execute(const char *line) {
     int i1, ln=-1;
     char s1[256];
 
+    if (!line && trace) {
+	if (!rec) return INTERP_ERROR;
+	return execute_record();
+    }
     if (line) {
 	retval = canterp_parse((char *) line);
 	if (retval)
@@ -674,21 +709,311 @@ int Canterp::execute() {
     return execute(0);
 }
 
+int Canterp::execute_record() {
+    const double *d = canon_trace_doubles(rec);
+    const int32_t *i = canon_trace_ints(rec);
+    int ln = rec->line;
+    char text[256];
+    EmcPose pose;
+
+    // the writer and the reader agree on the arguments of each op, but
+    // make sure a damaged trace can't send us past the record
+    static const unsigned char min_args[][2] = {
+	// ndoubles, nints, indexed by op
+	{0, 0}, {0, 0},				// END, UNSUPPORTED
+	{9, 0}, {9, 0}, {11, 1}, {3, 0},	// motion
+	{9, 1}, {9, 0}, {1, 0},			// offsets, rotation
+	{0, 1}, {0, 1}, {1, 0}, {1, 0}, {0, 1}, {0, 1}, {1, 1}, {1, 0},
+	{1, 0}, {0, 1}, {0, 0},			// cutter radius compensation
+	{1, 1}, {0, 0}, {1, 0},			// synch, dwell
+	{1, 0}, {1, 0}, {0, 1}, {0, 1}, {0, 0}, {1, 1}, {1, 0},	// spindle
+	{12, 3}, {9, 0}, {0, 1}, {0, 2}, {0, 1}, {0, 0},	// tools
+	{0, 0}, {0, 0},				// COMMENT, MESSAGE
+	{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},	// overrides
+	{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},	// feed hold, coolant
+	{0, 1}, {0, 1}, {1, 1}, {0, 1}, {0, 1}, {1, 1},	// outputs
+    };
+    if (rec->op < sizeof(min_args) / sizeof(min_args[0])
+	&& (rec->ndoubles < min_args[rec->op][0]
+	    || rec->nints < min_args[rec->op][1])) {
+	fprintf(stderr, "canterp: short trace record %d at line %d\n",
+		rec->op, ln);
+	return INTERP_ERROR;
+    }
+    snprintf(text, sizeof(text), "%s", canon_trace_text(rec));
+
+    switch (rec->op) {
+    case CANON_TRACE_UNSUPPORTED:
+	fprintf(stderr, "canterp: %s at line %d can't be replayed\n",
+		text, ln);
+	return INTERP_ERROR;
+    case CANON_TRACE_STRAIGHT_TRAVERSE:
+	STRAIGHT_TRAVERSE(ln, d[0], d[1], d[2], d[3], d[4], d[5],
+			  d[6], d[7], d[8]);
+	break;
+    case CANON_TRACE_STRAIGHT_FEED:
+	STRAIGHT_FEED(ln, d[0], d[1], d[2], d[3], d[4], d[5],
+		      d[6], d[7], d[8]);
+	break;
+    case CANON_TRACE_ARC_FEED:
+	ARC_FEED(ln, d[0], d[1], d[2], d[3], i[0], d[4], d[5], d[6], d[7],
+		 d[8], d[9], d[10]);
+	break;
+    case CANON_TRACE_RIGID_TAP:
+	RIGID_TAP(ln, d[0], d[1], d[2]);
+	break;
+    case CANON_TRACE_SET_G5X_OFFSET:
+	SET_G5X_OFFSET(i[0], d[0], d[1], d[2], d[3], d[4], d[5],
+		       d[6], d[7], d[8]);
+	break;
+    case CANON_TRACE_SET_G92_OFFSET:
+	SET_G92_OFFSET(d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8]);
+	break;
+    case CANON_TRACE_SET_XY_ROTATION:
+	SET_XY_ROTATION(d[0]);
+	break;
+    case CANON_TRACE_USE_LENGTH_UNITS:
+	USE_LENGTH_UNITS((CANON_UNITS) i[0]);
+	break;
+    case CANON_TRACE_SELECT_PLANE:
+	SELECT_PLANE((CANON_PLANE) i[0]);
+	break;
+    case CANON_TRACE_SET_TRAVERSE_RATE:
+	SET_TRAVERSE_RATE(d[0]);
+	break;
+    case CANON_TRACE_SET_FEED_RATE:
+	SET_FEED_RATE(d[0]);
+	break;
+    case CANON_TRACE_SET_FEED_MODE:
+	SET_FEED_MODE(i[0]);
+	break;
+    case CANON_TRACE_SET_FEED_REFERENCE:
+	SET_FEED_REFERENCE((CANON_FEED_REFERENCE) i[0]);
+	break;
+    case CANON_TRACE_SET_MOTION_CONTROL_MODE:
+	SET_MOTION_CONTROL_MODE((CANON_MOTION_MODE) i[0], d[0]);
+	break;
+    case CANON_TRACE_SET_NAIVECAM_TOLERANCE:
+	SET_NAIVECAM_TOLERANCE(d[0]);
+	break;
+    case CANON_TRACE_SET_CUTTER_RADIUS_COMPENSATION:
+	SET_CUTTER_RADIUS_COMPENSATION(d[0]);
+	break;
+    case CANON_TRACE_START_CUTTER_RADIUS_COMPENSATION:
+	START_CUTTER_RADIUS_COMPENSATION(i[0]);
+	break;
+    case CANON_TRACE_STOP_CUTTER_RADIUS_COMPENSATION:
+	STOP_CUTTER_RADIUS_COMPENSATION();
+	break;
+    case CANON_TRACE_START_SPEED_FEED_SYNCH:
+	START_SPEED_FEED_SYNCH(d[0], i[0]);
+	break;
+    case CANON_TRACE_STOP_SPEED_FEED_SYNCH:
+	STOP_SPEED_FEED_SYNCH();
+	break;
+    case CANON_TRACE_DWELL:
+	DWELL(d[0]);
+	break;
+    case CANON_TRACE_SET_SPINDLE_MODE:
+	SET_SPINDLE_MODE(d[0]);
+	break;
+    case CANON_TRACE_SET_SPINDLE_SPEED:
+	SET_SPINDLE_SPEED(d[0]);
+	break;
+    case CANON_TRACE_START_SPINDLE_CLOCKWISE:
+	START_SPINDLE_CLOCKWISE(i[0]);
+	break;
+    case CANON_TRACE_START_SPINDLE_COUNTERCLOCKWISE:
+	START_SPINDLE_COUNTERCLOCKWISE(i[0]);
+	break;
+    case CANON_TRACE_STOP_SPINDLE_TURNING:
+	STOP_SPINDLE_TURNING();
+	break;
+    case CANON_TRACE_ORIENT_SPINDLE:
+	ORIENT_SPINDLE(d[0], i[0]);
+	break;
+    case CANON_TRACE_WAIT_SPINDLE_ORIENT_COMPLETE:
+	WAIT_SPINDLE_ORIENT_COMPLETE(d[0]);
+	break;
+    case CANON_TRACE_SET_TOOL_TABLE_ENTRY:
+	pose.tran.x = d[0]; pose.tran.y = d[1]; pose.tran.z = d[2];
+	pose.a = d[3]; pose.b = d[4]; pose.c = d[5];
+	pose.u = d[6]; pose.v = d[7]; pose.w = d[8];
+	SET_TOOL_TABLE_ENTRY(i[0], i[1], pose, d[9], d[10], d[11], i[2]);
+	break;
+    case CANON_TRACE_USE_TOOL_LENGTH_OFFSET:
+	pose.tran.x = d[0]; pose.tran.y = d[1]; pose.tran.z = d[2];
+	pose.a = d[3]; pose.b = d[4]; pose.c = d[5];
+	pose.u = d[6]; pose.v = d[7]; pose.w = d[8];
+	USE_TOOL_LENGTH_OFFSET(pose);
+	break;
+    case CANON_TRACE_CHANGE_TOOL:
+	CHANGE_TOOL(i[0]);
+	break;
+    case CANON_TRACE_SELECT_POCKET:
+	SELECT_POCKET(i[0], i[1]);
+	break;
+    case CANON_TRACE_CHANGE_TOOL_NUMBER:
+	CHANGE_TOOL_NUMBER(i[0]);
+	break;
+    case CANON_TRACE_START_CHANGE:
+	START_CHANGE();
+	break;
+    case CANON_TRACE_COMMENT:
+	COMMENT(text);
+	break;
+    case CANON_TRACE_MESSAGE:
+	MESSAGE(text);
+	break;
+    case CANON_TRACE_DISABLE_ADAPTIVE_FEED:
+	DISABLE_ADAPTIVE_FEED();
+	break;
+    case CANON_TRACE_ENABLE_ADAPTIVE_FEED:
+	ENABLE_ADAPTIVE_FEED();
+	break;
+    case CANON_TRACE_DISABLE_FEED_OVERRIDE:
+	DISABLE_FEED_OVERRIDE();
+	break;
+    case CANON_TRACE_ENABLE_FEED_OVERRIDE:
+	ENABLE_FEED_OVERRIDE();
+	break;
+    case CANON_TRACE_DISABLE_SPEED_OVERRIDE:
+	DISABLE_SPEED_OVERRIDE();
+	break;
+    case CANON_TRACE_ENABLE_SPEED_OVERRIDE:
+	ENABLE_SPEED_OVERRIDE();
+	break;
+    case CANON_TRACE_DISABLE_FEED_HOLD:
+	DISABLE_FEED_HOLD();
+	break;
+    case CANON_TRACE_ENABLE_FEED_HOLD:
+	ENABLE_FEED_HOLD();
+	break;
+    case CANON_TRACE_FLOOD_OFF:
+	FLOOD_OFF();
+	break;
+    case CANON_TRACE_FLOOD_ON:
+	FLOOD_ON();
+	break;
+    case CANON_TRACE_MIST_OFF:
+	MIST_OFF();
+	break;
+    case CANON_TRACE_MIST_ON:
+	MIST_ON();
+	break;
+    case CANON_TRACE_SET_MOTION_OUTPUT_BIT:
+	SET_MOTION_OUTPUT_BIT(i[0]);
+	break;
+    case CANON_TRACE_CLEAR_MOTION_OUTPUT_BIT:
+	CLEAR_MOTION_OUTPUT_BIT(i[0]);
+	break;
+    case CANON_TRACE_SET_MOTION_OUTPUT_VALUE:
+	SET_MOTION_OUTPUT_VALUE(i[0], d[0]);
+	break;
+    case CANON_TRACE_SET_AUX_OUTPUT_BIT:
+	SET_AUX_OUTPUT_BIT(i[0]);
+	break;
+    case CANON_TRACE_CLEAR_AUX_OUTPUT_BIT:
+	CLEAR_AUX_OUTPUT_BIT(i[0]);
+	break;
+    case CANON_TRACE_SET_AUX_OUTPUT_VALUE:
+	SET_AUX_OUTPUT_VALUE(i[0], d[0]);
+	break;
+    case CANON_TRACE_PALLET_SHUTTLE:
+	PALLET_SHUTTLE();
+	break;
+    case CANON_TRACE_TURN_PROBE_OFF:
+	TURN_PROBE_OFF();
+	break;
+    case CANON_TRACE_TURN_PROBE_ON:
+	TURN_PROBE_ON();
+	break;
+    case CANON_TRACE_PROGRAM_STOP:
+	PROGRAM_STOP();
+	return INTERP_EXECUTE_FINISH;
+    case CANON_TRACE_OPTIONAL_PROGRAM_STOP:
+	// written whenever rs274 had optional stop on; honor the switch
+	// the operator has now
+	if (!GET_OPTIONAL_PROGRAM_STOP()) break;
+	OPTIONAL_PROGRAM_STOP();
+	return INTERP_EXECUTE_FINISH;
+    case CANON_TRACE_PROGRAM_END:
+	PROGRAM_END();
+	return INTERP_EXIT;
+    case CANON_TRACE_FINISH:
+	FINISH();
+	break;
+    default:
+	fprintf(stderr, "canterp: unknown trace record %d at line %d\n",
+		rec->op, ln);
+	return INTERP_ERROR;
+    }
+    return INTERP_OK;
+}
+
+int Canterp::open_trace(const char *newfilename) {
+    const canon_trace_header *h;
+    struct stat st;
+    void *p;
+    int fd;
+
+    fd = ::open(newfilename, O_RDONLY);
+    if (fd < 0) return INTERP_ERROR;
+    if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(*h)) {
+	::close(fd);
+	return INTERP_ERROR;
+    }
+    p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return INTERP_ERROR;
+    h = (const canon_trace_header *) p;
+    if (h->version != CANON_TRACE_VERSION
+	|| h->byte_order != CANON_TRACE_BYTE_ORDER) {
+	fprintf(stderr, "canterp: %s: trace version %u or byte order "
+		"not supported\n", newfilename, (unsigned) h->version);
+	munmap(p, st.st_size);
+	return INTERP_ERROR;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    trace = (const char *) p;
+    trace_len = st.st_size;
+    trace_next = sizeof(*h);
+    rec = 0;
+    snprintf(source, sizeof(source), "%s", h->source);
+    return INTERP_OK;
+}
+
 int Canterp::open(const char *newfilename) {
+    char magic[CANON_TRACE_MAGIC_LEN];
+    close();
     if(f) fclose(f);
     f = fopen(newfilename, "r");
-    if(f) snprintf(filename, sizeof(filename), "%s", newfilename);
-    return f ? INTERP_OK : INTERP_ERROR;
+    if(!f) return INTERP_ERROR;
+    snprintf(filename, sizeof(filename), "%s", newfilename);
+    if(fread(magic, 1, sizeof(magic), f) == sizeof(magic)
+	    && !memcmp(magic, CANON_TRACE_MAGIC, sizeof(magic))) {
+	fclose(f);
+	f = 0;
+	return open_trace(newfilename);
+    }
+    rewind(f);
+    return INTERP_OK;
 }
 
 int Canterp::close() {
+    if(trace) {
+	munmap((void *) trace, trace_len);
+	trace = 0;
+	trace_len = 0;
+	rec = 0;
+    }
     return INTERP_OK;
 }
 
 int Canterp::exit() { return 0; }
 int Canterp::synch() { return 0; }
 int Canterp::reset() { return 0; }
-int Canterp::line() { return 0; }
+int Canterp::line() { return rec ? rec->line : 0; }
 int Canterp::call_level() { return 0; }
 
 char *Canterp::line_text(char *buf, size_t bufsize) {
@@ -696,11 +1021,11 @@ char *Canterp::line_text(char *buf, size_t bufsize) {
    return buf;
 }
 char *Canterp::file_name(char *buf, size_t bufsize) {
-   snprintf(buf, bufsize, "%s", filename);
+   snprintf(buf, bufsize, "%s", trace && source[0] ? source : filename);
    return buf;
 }
 char *Canterp::file(char *buf, size_t bufsize) {
-   snprintf(buf, bufsize, "%s", filename);
+   snprintf(buf, bufsize, "%s", trace && source[0] ? source : filename);
    return buf;
 }
 int Canterp::on_abort(int reason, const char *message)
@@ -717,7 +1042,7 @@ size_t Canterp::line_length() {
    return 0;
 }
 int Canterp::sequence_number() {
-   return -1;
+   return rec ? rec->line : -1;
 }
 int Canterp::init() { return INTERP_OK; }
 void Canterp::active_g_codes(int gees[]) { std::fill(gees, gees + ACTIVE_G_CODES, 0); }
@@ -68,7 +68,7 @@
 #include "nml_oi.hh"
 #include "timer.hh"
 #include "rcs_print.hh"
-#include "tool_parse.h"
+#include "toolstore.hh"
 
 static RCS_CMD_CHANNEL *emcioCommandBuffer = 0;
 static RCS_CMD_MSG *emcioCommand = 0;
@@ -76,8 +76,7 @@ static RCS_STAT_CHANNEL *emcioStatusBuffer = 0;
 static EMC_IO_STAT emcioStatus;
 static NML *emcErrorBuffer = 0;
 
-static char *ttcomments[CANON_POCKETS_MAX];
-static int fms[CANON_POCKETS_MAX];
+static ToolStore tools;
 static int random_toolchanger = 0;
 
 
@@ -253,9 +252,8 @@ static int iniLoad(const char *filename)
 
 /********************************************************************
 *
-* Description: saveToolTable(const char *filename, CANON_TOOL_TABLE toolTable[])
-*		Saves the tool table from toolTable[] array into file filename.
-*		  Array is CANON_TOOL_MAX + 1 entries, since 0 is included.
+* Description: saveToolTable(const char *filename)
+*		Saves the tool table into file filename.
 *
 * Return Value: Zero on success or -1 if file not found.
 *
@@ -265,13 +263,9 @@ static int iniLoad(const char *filename)
 * Called By: main()
 *
 ********************************************************************/
-static int saveToolTable(const char *filename,
-			 CANON_TOOL_TABLE toolTable[])
+static int saveToolTable(const char *filename)
 {
-    int pocket;
-    FILE *fp;
     const char *name;
-    int start_pocket;
 
     // check filename
     if (filename[0] == 0) {
@@ -281,39 +275,7 @@ static int saveToolTable(const char *filename,
 	name = filename;
     }
 
-    // open tool table file
-    if (NULL == (fp = fopen(name, "w"))) {
-	// can't open file
-	return -1;
-    }
-
-    if(random_toolchanger) {
-        start_pocket = 0;
-    } else {
-        start_pocket = 1;
-    }
-    for (pocket = start_pocket; pocket < CANON_POCKETS_MAX; pocket++) {
-        if (toolTable[pocket].toolno != -1) {
-            fprintf(fp, "T%d P%d", toolTable[pocket].toolno, random_toolchanger? pocket: fms[pocket]);
-            if (toolTable[pocket].diameter) fprintf(fp, " D%f", toolTable[pocket].diameter);
-            if (toolTable[pocket].offset.tran.x) fprintf(fp, " X%+f", toolTable[pocket].offset.tran.x);
-            if (toolTable[pocket].offset.tran.y) fprintf(fp, " Y%+f", toolTable[pocket].offset.tran.y);
-            if (toolTable[pocket].offset.tran.z) fprintf(fp, " Z%+f", toolTable[pocket].offset.tran.z);
-            if (toolTable[pocket].offset.a) fprintf(fp, " A%+f", toolTable[pocket].offset.a);
-            if (toolTable[pocket].offset.b) fprintf(fp, " B%+f", toolTable[pocket].offset.b);
-            if (toolTable[pocket].offset.c) fprintf(fp, " C%+f", toolTable[pocket].offset.c);
-            if (toolTable[pocket].offset.u) fprintf(fp, " U%+f", toolTable[pocket].offset.u);
-            if (toolTable[pocket].offset.v) fprintf(fp, " V%+f", toolTable[pocket].offset.v);
-            if (toolTable[pocket].offset.w) fprintf(fp, " W%+f", toolTable[pocket].offset.w);
-            if (toolTable[pocket].frontangle) fprintf(fp, " I%+f", toolTable[pocket].frontangle);
-            if (toolTable[pocket].backangle) fprintf(fp, " J%+f", toolTable[pocket].backangle);
-            if (toolTable[pocket].orientation) fprintf(fp, " Q%d", toolTable[pocket].orientation);
-            fprintf(fp, " ;%s\n", ttcomments[pocket]);
-        }
-    }
-
-    fclose(fp);
-    return 0;
+    return tools.save(name, random_toolchanger);
 }
 
 static int done = 0;
@@ -591,41 +553,33 @@ int read_hal_inputs(void)
 void load_tool(int pocket) {
     if(random_toolchanger) {
         // swap the tools between the desired pocket and the spindle pocket
-        CANON_TOOL_TABLE temp;
-        char *comment_temp;
+        tools.swap(0, pocket);
 
-        temp = emcioStatus.tool.toolTable[0];
-        emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[pocket];
-        emcioStatus.tool.toolTable[pocket] = temp;
-
-        comment_temp = ttcomments[0];
-        ttcomments[0] = ttcomments[pocket];
-        ttcomments[pocket] = comment_temp;
-
-        if (0 != saveToolTable(tool_table_file, emcioStatus.tool.toolTable))
+        if (0 != saveToolTable(tool_table_file))
             emcioStatus.status = RCS_ERROR;
     } else if(pocket == 0) {
         // on non-random tool-changers, asking for pocket 0 is the secret
         // handshake for "unload the tool from the spindle"
-	emcioStatus.tool.toolTable[0].toolno = 0;
-        ZERO_EMC_POSE(emcioStatus.tool.toolTable[0].offset);
-        emcioStatus.tool.toolTable[0].diameter = 0.0;
-        emcioStatus.tool.toolTable[0].frontangle = 0.0;
-        emcioStatus.tool.toolTable[0].backangle = 0.0;
-        emcioStatus.tool.toolTable[0].orientation = 0;
+        CANON_TOOL_TABLE empty;
+
+	empty.toolno = 0;
+        ZERO_EMC_POSE(empty.offset);
+        empty.diameter = 0.0;
+        empty.frontangle = 0.0;
+        empty.backangle = 0.0;
+        empty.orientation = 0;
+        tools.set(0, empty);
     } else {
         // just copy the desired tool to the spindle
-        emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[pocket];
+        tools.set(0, tools.get(pocket));
     }
 }
 
 void reload_tool_number(int toolno) {
     if(random_toolchanger) return; // doesn't need special handling here
-    for(int i=1; i<CANON_POCKETS_MAX; i++) {
-        if(emcioStatus.tool.toolTable[i].toolno == toolno) {
-            load_tool(i);
-            break;
-        }
+    int pocket = tools.find(toolno);
+    if(pocket > 0) {
+        load_tool(pocket);
     }
 }
 
@@ -658,7 +612,7 @@ int read_tool_inputs(void)
             emcioStatus.tool.toolInSpindle = 0;
         } else {
             // the tool now in the spindle is the one that was prepared
-            emcioStatus.tool.toolInSpindle = emcioStatus.tool.toolTable[emcioStatus.tool.pocketPrepped].toolno; 
+            emcioStatus.tool.toolInSpindle = tools.get(emcioStatus.tool.pocketPrepped).toolno;
         }
 	*(iocontrol_data->tool_number) = emcioStatus.tool.toolInSpindle; //likewise in HAL
 	load_tool(emcioStatus.tool.pocketPrepped);
@@ -746,25 +700,9 @@ int main(int argc, char *argv[])
 	return -1;
     }
 
-    for(int i=0; i<CANON_POCKETS_MAX; i++) {
-        ttcomments[i] = (char *)malloc(CANON_TOOL_ENTRY_LEN);
-    }
-
-
-    // on nonrandom machines, always start by assuming the spindle is empty
-    if(!random_toolchanger) {
-	emcioStatus.tool.toolTable[0].toolno = -1;
-        ZERO_EMC_POSE(emcioStatus.tool.toolTable[0].offset);
-	emcioStatus.tool.toolTable[0].diameter = 0.0;
-        emcioStatus.tool.toolTable[0].frontangle = 0.0;
-        emcioStatus.tool.toolTable[0].backangle = 0.0;
-        emcioStatus.tool.toolTable[0].orientation = 0;
-        fms[0] = 0;
-        ttcomments[0][0] = '\0';
-    }
-
-    if (0 != loadToolTable(tool_table_file, emcioStatus.tool.toolTable,
-		fms, ttcomments, random_toolchanger)) {
+    // on nonrandom machines, always start by assuming the spindle is
+    // empty, which is how the store starts out
+    if (0 != tools.load(tool_table_file, random_toolchanger)) {
 	rcs_print_error("can't load tool table.\n");
     }
 
@@ -774,7 +712,7 @@ int main(int argc, char *argv[])
     emcioStatus.aux.estop = 1; //estop=1 means to emc that ESTOP condition is met
     emcioStatus.tool.pocketPrepped = -1;
     if (random_toolchanger) {
-        emcioStatus.tool.toolInSpindle = emcioStatus.tool.toolTable[0].toolno;
+        emcioStatus.tool.toolInSpindle = tools.get(0).toolno;
     } else {
         emcioStatus.tool.toolInSpindle = 0;
     }
@@ -795,6 +733,7 @@ int main(int argc, char *argv[])
 	    emcioStatus.echo_serial_number =
 		emcioCommand->serial_number+1; //need for different serial number, because we are pushing a new message
 	    emcioStatus.heartbeat++;
+	    tools.publish(emcioStatus.tool);
 	    emcioStatusBuffer->write(&emcioStatus);
 	}
 	;
@@ -803,6 +742,7 @@ int main(int argc, char *argv[])
 	    emcioStatus.echo_serial_number =
 		emcioCommand->serial_number;
 	    emcioStatus.heartbeat++;
+	    tools.publish(emcioStatus.tool);
 	    emcioStatusBuffer->write(&emcioStatus);
 	}
 
@@ -837,8 +777,7 @@ int main(int argc, char *argv[])
 
 	case EMC_TOOL_INIT_TYPE:
 	    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_INIT\n");
-	    loadToolTable(tool_table_file, emcioStatus.tool.toolTable,
-		    fms, ttcomments, random_toolchanger);
+	    tools.load(tool_table_file, random_toolchanger);
 	    reload_tool_number(emcioStatus.tool.toolInSpindle);
 	    break;
 
@@ -866,11 +805,11 @@ int main(int argc, char *argv[])
 
                 // Set HAL pins/params for tool number, pocket, and index.
                 iocontrol_data->tool_prep_index = p;
-                *(iocontrol_data->tool_prep_pocket) = random_toolchanger? p: fms[p];
+                *(iocontrol_data->tool_prep_pocket) = random_toolchanger? p: tools.fms(p);
                 if(!random_toolchanger && p == 0) {
                     *(iocontrol_data->tool_prep_number) = 0;
                 } else {
-                    *(iocontrol_data->tool_prep_number) = emcioStatus.tool.toolTable[p].toolno;
+                    *(iocontrol_data->tool_prep_number) = tools.get(p).toolno;
                 }
 
                 // it doesn't make sense to prep the spindle pocket
@@ -898,7 +837,7 @@ int main(int argc, char *argv[])
 
             // it's not necessary to load the tool already in the spindle
             if (!random_toolchanger && emcioStatus.tool.pocketPrepped > 0 &&
-                emcioStatus.tool.toolInSpindle == emcioStatus.tool.toolTable[emcioStatus.tool.pocketPrepped].toolno) {
+                emcioStatus.tool.toolInSpindle == tools.get(emcioStatus.tool.pocketPrepped).toolno) {
                 break;
             }
 
@@ -926,8 +865,7 @@ int main(int argc, char *argv[])
 		    ((EMC_TOOL_LOAD_TOOL_TABLE *) emcioCommand)->file;
 		if(!strlen(filename)) filename = tool_table_file;
 		rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_LOAD_TOOL_TABLE\n");
-		if (0 != loadToolTable(filename, emcioStatus.tool.toolTable,
-				  fms, ttcomments, random_toolchanger))
+		if (0 != tools.load(filename, random_toolchanger))
 		    emcioStatus.status = RCS_ERROR;
 		else
 		    reload_tool_number(emcioStatus.tool.toolInSpindle);
@@ -939,6 +877,7 @@ int main(int argc, char *argv[])
                 int p, t, o;
                 double d, f, b;
                 EmcPose offs;
+                CANON_TOOL_TABLE tool;
 
                 p = ((EMC_TOOL_SET_OFFSET *) emcioCommand)->pocket;
                 t = ((EMC_TOOL_SET_OFFSET *) emcioCommand)->toolno;
@@ -953,18 +892,19 @@ int main(int argc, char *argv[])
                                 " frontangle=%lf, backangle=%lf, orientation=%d\n",
                                 p, t, offs.tran.z, offs.tran.x, d, f, b, o);
 
-                emcioStatus.tool.toolTable[p].toolno = t;
-                emcioStatus.tool.toolTable[p].offset = offs;
-                emcioStatus.tool.toolTable[p].diameter = d;
-                emcioStatus.tool.toolTable[p].frontangle = f;
-                emcioStatus.tool.toolTable[p].backangle = b;
-                emcioStatus.tool.toolTable[p].orientation = o;
+                tool.toolno = t;
+                tool.offset = offs;
+                tool.diameter = d;
+                tool.frontangle = f;
+                tool.backangle = b;
+                tool.orientation = o;
+                tools.set(p, tool);
 
                 if (emcioStatus.tool.toolInSpindle == t) {
-                    emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[p];
+                    tools.set(0, tool);
                 }                    
             }
-	    if (0 != saveToolTable(tool_table_file, emcioStatus.tool.toolTable))
+	    if (0 != saveToolTable(tool_table_file))
 		emcioStatus.status = RCS_ERROR;
 	    break;
 
@@ -973,9 +913,9 @@ int main(int argc, char *argv[])
 		int pocket_number;
 		
 		pocket_number = ((EMC_TOOL_SET_NUMBER *) emcioCommand)->tool;
-		rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_SET_NUMBER old_loaded_tool=%d new_pocket_number=%d new_tool=%d\n", emcioStatus.tool.toolInSpindle, pocket_number, emcioStatus.tool.toolTable[pocket_number].toolno);
+		rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_SET_NUMBER old_loaded_tool=%d new_pocket_number=%d new_tool=%d\n", emcioStatus.tool.toolInSpindle, pocket_number, tools.get(pocket_number).toolno);
                 load_tool(pocket_number);
-		emcioStatus.tool.toolInSpindle = emcioStatus.tool.toolTable[pocket_number].toolno;
+		emcioStatus.tool.toolInSpindle = tools.get(pocket_number).toolno;
 		*(iocontrol_data->tool_number) = emcioStatus.tool.toolInSpindle; //likewise in HAL
 	    }
 	    break;
@@ -1058,6 +998,7 @@ int main(int argc, char *argv[])
 	//set above, to allow some commands to fail this
 	//emcioStatus.status = RCS_DONE;
 	emcioStatus.heartbeat++;
+	tools.publish(emcioStatus.tool);
 	emcioStatusBuffer->write(&emcioStatus);
 
 	esleep(emc_io_cycle_time);
@@ -1081,9 +1022,5 @@ int main(int argc, char *argv[])
 	emcioCommandBuffer = 0;
     }
 
-    for(int i=0; i<CANON_POCKETS_MAX; i++) {
-        free(ttcomments[i]);
-    }
-
     return 0;
 }
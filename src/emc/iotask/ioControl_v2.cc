@@ -69,7 +69,7 @@
 #include "nml_oi.hh"
 #include "timer.hh"
 #include "rcs_print.hh"
-#include "tool_parse.h"
+#include "toolstore.hh"
 
 static RCS_CMD_CHANNEL *emcioCommandBuffer = 0;
 static RCS_CMD_MSG *emcioCommand = 0;
@@ -77,8 +77,7 @@ static RCS_STAT_CHANNEL *emcioStatusBuffer = 0;
 static EMC_IO_STAT emcioStatus;
 static NML *emcErrorBuffer = 0;
 
-static char *ttcomments[CANON_POCKETS_MAX];
-static int fms[CANON_POCKETS_MAX];
+static ToolStore tools;
 static int random_toolchanger = 0;
 static int support_start_change = 0;
 static const char *progname;
@@ -348,9 +347,8 @@ static int iniLoad(const char *filename)
 
 /********************************************************************
  *
- * Description: saveToolTable(const char *filename, CANON_TOOL_TABLE toolTable[])
- *		Saves the tool table from toolTable[] array into file filename.
- *		  Array is CANON_TOOL_MAX + 1 entries, since 0 is included.
+ * Description: saveToolTable(const char *filename)
+ *		Saves the tool table into file filename.
  *
  * Return Value: Zero on success or -1 if file not found.
  *
@@ -360,13 +358,9 @@ static int iniLoad(const char *filename)
  * Called By: main()
  *
  ********************************************************************/
-static int saveToolTable(const char *filename,
-			 CANON_TOOL_TABLE toolTable[])
+static int saveToolTable(const char *filename)
 {
-    int pocket;
-    FILE *fp;
     const char *name;
-    int start_pocket;
 
     // check filename
     if (filename[0] == 0) {
@@ -376,39 +370,7 @@ static int saveToolTable(const char *filename,
 	name = filename;
     }
 
-    // open tool table file
-    if (NULL == (fp = fopen(name, "w"))) {
-	// can't open file
-	return -1;
-    }
-
-    if(random_toolchanger) {
-	start_pocket = 0;
-    } else {
-	start_pocket = 1;
-    }
-    for (pocket = start_pocket; pocket < CANON_POCKETS_MAX; pocket++) {
-	if (toolTable[pocket].toolno != -1) {
-	    fprintf(fp, "T%d P%d", toolTable[pocket].toolno, random_toolchanger? pocket: fms[pocket]);
-	    if (toolTable[pocket].diameter) fprintf(fp, " D%f", toolTable[pocket].diameter);
-	    if (toolTable[pocket].offset.tran.x) fprintf(fp, " X%+f", toolTable[pocket].offset.tran.x);
-	    if (toolTable[pocket].offset.tran.y) fprintf(fp, " Y%+f", toolTable[pocket].offset.tran.y);
-	    if (toolTable[pocket].offset.tran.z) fprintf(fp, " Z%+f", toolTable[pocket].offset.tran.z);
-	    if (toolTable[pocket].offset.a) fprintf(fp, " A%+f", toolTable[pocket].offset.a);
-	    if (toolTable[pocket].offset.b) fprintf(fp, " B%+f", toolTable[pocket].offset.b);
-	    if (toolTable[pocket].offset.c) fprintf(fp, " C%+f", toolTable[pocket].offset.c);
-	    if (toolTable[pocket].offset.u) fprintf(fp, " U%+f", toolTable[pocket].offset.u);
-	    if (toolTable[pocket].offset.v) fprintf(fp, " V%+f", toolTable[pocket].offset.v);
-	    if (toolTable[pocket].offset.w) fprintf(fp, " W%+f", toolTable[pocket].offset.w);
-	    if (toolTable[pocket].frontangle) fprintf(fp, " I%+f", toolTable[pocket].frontangle);
-	    if (toolTable[pocket].backangle) fprintf(fp, " J%+f", toolTable[pocket].backangle);
-	    if (toolTable[pocket].orientation) fprintf(fp, " Q%d", toolTable[pocket].orientation);
-	    fprintf(fp, " ;%s\n", ttcomments[pocket]);
-	}
-    }
-
-    fclose(fp);
-    return 0;
+    return tools.save(name, random_toolchanger);
 }
 
 static int done = 0;
@@ -560,40 +522,32 @@ void hal_init_pins(void)
 void load_tool(int pocket) {
     if(random_toolchanger) {
 	// swap the tools between the desired pocket and the spindle pocket
-	CANON_TOOL_TABLE temp;
-	char *comment_temp;
+	tools.swap(0, pocket);
 
-	temp = emcioStatus.tool.toolTable[0];
-	emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[pocket];
-	emcioStatus.tool.toolTable[pocket] = temp;
-
-	comment_temp = ttcomments[0];
-	ttcomments[0] = ttcomments[pocket];
-	ttcomments[pocket] = comment_temp;
-
-	if (0 != saveToolTable(tool_table_file, emcioStatus.tool.toolTable))
+	if (0 != saveToolTable(tool_table_file))
 	    emcioStatus.status = RCS_ERROR;
     } else if (pocket == 0) {
 	// magic T0 = pocket 0 = no tool
-	emcioStatus.tool.toolTable[0].toolno = -1;
-	ZERO_EMC_POSE(emcioStatus.tool.toolTable[0].offset);
-	emcioStatus.tool.toolTable[0].diameter = 0.0;
-	emcioStatus.tool.toolTable[0].frontangle = 0.0;
-	emcioStatus.tool.toolTable[0].backangle = 0.0;
-	emcioStatus.tool.toolTable[0].orientation = 0;
+	CANON_TOOL_TABLE empty;
+
+	empty.toolno = -1;
+	ZERO_EMC_POSE(empty.offset);
+	empty.diameter = 0.0;
+	empty.frontangle = 0.0;
+	empty.backangle = 0.0;
+	empty.orientation = 0;
+	tools.set(0, empty);
     } else {
 	// just copy the desired tool to the spindle
-	emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[pocket];
+	tools.set(0, tools.get(pocket));
     }
 }
 
 void reload_tool_number(int toolno) {
     if(random_toolchanger) return; // doesn't need special handling here
-    for(int i=1; i<CANON_POCKETS_MAX; i++) {
-	if(emcioStatus.tool.toolTable[i].toolno == toolno) {
-	    load_tool(i);
-	    break;
-	}
+    int pocket = tools.find(toolno);
+    if(pocket > 0) {
+	load_tool(pocket);
     }
 }
 
@@ -751,7 +705,7 @@ int read_inputs(void)
 		emcioStatus.tool.toolInSpindle = 0;
 	    } else {
 		// the tool now in the spindle is the one that was prepared
-		emcioStatus.tool.toolInSpindle = emcioStatus.tool.toolTable[emcioStatus.tool.pocketPrepped].toolno;
+		emcioStatus.tool.toolInSpindle = tools.get(emcioStatus.tool.pocketPrepped).toolno;
 	    }
 	    *(iocontrol_data->tool_number) = emcioStatus.tool.toolInSpindle; // likewise in HAL
 	    load_tool(emcioStatus.tool.pocketPrepped);
@@ -789,6 +743,7 @@ void update_status(int status, int serial)
     emcioStatus.command_type = EMC_IO_STAT_TYPE;
     emcioStatus.echo_serial_number = serial;
     emcioStatus.heartbeat++;
+    tools.publish(emcioStatus.tool);
     emcioStatusBuffer->write(&emcioStatus);
 }
 
@@ -865,24 +820,9 @@ int main(int argc, char *argv[])
 	exit(-1);
     }
 
-    for(int i = 0; i < CANON_POCKETS_MAX; i++) {
-	ttcomments[i] = (char *)malloc(CANON_TOOL_ENTRY_LEN);
-    }
-
-    // on nonrandom machines, always start by assuming the spindle is empty
-    if(!random_toolchanger) {
-	emcioStatus.tool.toolTable[0].toolno = -1;
-	ZERO_EMC_POSE(emcioStatus.tool.toolTable[0].offset);
-	emcioStatus.tool.toolTable[0].diameter = 0.0;
-	emcioStatus.tool.toolTable[0].frontangle = 0.0;
-	emcioStatus.tool.toolTable[0].backangle = 0.0;
-	emcioStatus.tool.toolTable[0].orientation = 0;
-	fms[0] = 0;
-	ttcomments[0][0] = '\0';
-    }
-
-    if (0 != loadToolTable(tool_table_file, emcioStatus.tool.toolTable,
-			   fms, ttcomments, random_toolchanger)) {
+    // on nonrandom machines, always start by assuming the spindle is
+    // empty, which is how the store starts out
+    if (0 != tools.load(tool_table_file, random_toolchanger)) {
 	rcs_print_error("%s: can't load tool table.\n",progname);
     }
 
@@ -984,8 +924,7 @@ int main(int argc, char *argv[])
 
 	case EMC_TOOL_INIT_TYPE:
 	    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_INIT\n");
-	    loadToolTable(tool_table_file, emcioStatus.tool.toolTable,
-			  fms, ttcomments, random_toolchanger);
+	    tools.load(tool_table_file, random_toolchanger);
 	    reload_tool_number(emcioStatus.tool.toolInSpindle);
 	    break;
 
@@ -1031,14 +970,14 @@ int main(int argc, char *argv[])
 
 	    /* set tool number first */
             iocontrol_data->tool_prep_index = p;
-            *(iocontrol_data->tool_prep_pocket) = random_toolchanger? p: fms[p];
+            *(iocontrol_data->tool_prep_pocket) = random_toolchanger? p: tools.fms(p);
 	    if (!random_toolchanger && p == 0) {
 		*(iocontrol_data->tool_prep_number) = 0;
 	    } else {
-		*(iocontrol_data->tool_prep_number) = emcioStatus.tool.toolTable[p].toolno;
-		if (emcioStatus.tool.toolTable[p].toolno != t) // sanity check
+		*(iocontrol_data->tool_prep_number) = tools.get(p).toolno;
+		if (tools.get(p).toolno != t) // sanity check
 		    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_PREPARE: mismatch: tooltable[%d]=%d, got %d\n", 
-				    p, emcioStatus.tool.toolTable[p].toolno, t);
+				    p, tools.get(p).toolno, t);
 	    }
 
 	    if ((proto > V1) && *(iocontrol_data->toolchanger_faulted)) { // informational
@@ -1067,7 +1006,7 @@ int main(int argc, char *argv[])
 
 	    // it's not necessary to load the tool already in the spindle
 	    if (!random_toolchanger && emcioStatus.tool.pocketPrepped > 0 &&
-		emcioStatus.tool.toolInSpindle == emcioStatus.tool.toolTable[emcioStatus.tool.pocketPrepped].toolno) {
+		emcioStatus.tool.toolInSpindle == tools.get(emcioStatus.tool.pocketPrepped).toolno) {
 		break;
 	    }
 
@@ -1107,8 +1046,7 @@ int main(int argc, char *argv[])
 		((EMC_TOOL_LOAD_TOOL_TABLE *) emcioCommand)->file;
 	    if (!strlen(filename)) filename = tool_table_file;
 	    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_LOAD_TOOL_TABLE\n");
-	    if (0 != loadToolTable(filename, emcioStatus.tool.toolTable,
-				   fms, ttcomments, random_toolchanger))
+	    if (0 != tools.load(filename, random_toolchanger))
 		emcioStatus.status = RCS_ERROR;
 	    else
 		reload_tool_number(emcioStatus.tool.toolInSpindle);
@@ -1120,6 +1058,7 @@ int main(int argc, char *argv[])
 	    int p, t, o;
 	    double d, f, b;
 	    EmcPose offs;
+	    CANON_TOOL_TABLE tool;
 
 	    p = ((EMC_TOOL_SET_OFFSET *) emcioCommand)->pocket;
 	    t = ((EMC_TOOL_SET_OFFSET *) emcioCommand)->toolno;
@@ -1134,32 +1073,33 @@ int main(int argc, char *argv[])
 			    " frontangle=%lf, backangle=%lf, orientation=%d\n",
 			    p, t, offs.tran.z, offs.tran.x, d, f, b, o);
 
-	    emcioStatus.tool.toolTable[p].toolno = t;
-	    emcioStatus.tool.toolTable[p].offset = offs;
-	    emcioStatus.tool.toolTable[p].diameter = d;
-	    emcioStatus.tool.toolTable[p].frontangle = f;
-	    emcioStatus.tool.toolTable[p].backangle = b;
-	    emcioStatus.tool.toolTable[p].orientation = o;
+	    tool.toolno = t;
+	    tool.offset = offs;
+	    tool.diameter = d;
+	    tool.frontangle = f;
+	    tool.backangle = b;
+	    tool.orientation = o;
+	    tools.set(p, tool);
 
 	    if (emcioStatus.tool.toolInSpindle == t) {
-		emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[p];
+		tools.set(0, tool);
 	    }
 	}
-	if (0 != saveToolTable(tool_table_file, emcioStatus.tool.toolTable))
+	if (0 != saveToolTable(tool_table_file))
 	    emcioStatus.status = RCS_ERROR;
 	break;
 
 	case EMC_TOOL_SET_NUMBER_TYPE:
 	{
 	    // changed als in interp_convert.cc to convey the pocket number, not the tool number
-	    // needed so toolTable[0] can be properly set including offsets
+	    // needed so pocket 0 can be properly set including offsets
 	    int number;
 
 	    number = ((EMC_TOOL_SET_NUMBER *) emcioCommand)->tool;
 	    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_SET_NUMBER pocket=%d old_loaded=%d new_number=%d\n",
 			    number, emcioStatus.tool.toolInSpindle,
-			    emcioStatus.tool.toolTable[number].toolno);
-	    emcioStatus.tool.toolInSpindle = emcioStatus.tool.toolTable[number].toolno;
+			    tools.get(number).toolno);
+	    emcioStatus.tool.toolInSpindle = tools.get(number).toolno;
 	    load_tool(number);
 	    *(iocontrol_data->tool_number) = emcioStatus.tool.toolInSpindle; //likewise in HAL
 	}
@@ -1237,6 +1177,7 @@ int main(int argc, char *argv[])
 	emcioStatus.echo_serial_number = emcioCommand->serial_number;
 	emcioStatus.heartbeat++;
 	emcioStatus.reason = toolchanger_reason;  // always piggyback current fault code
+	tools.publish(emcioStatus.tool);
 	emcioStatusBuffer->write(&emcioStatus);
 
 	esleep(emc_io_cycle_time);
@@ -1260,9 +1201,6 @@ int main(int argc, char *argv[])
 	emcioCommandBuffer = 0;
     }
 
-    for(int i=0; i<CANON_POCKETS_MAX; i++) {
-	free(ttcomments[i]);
-    }
     rtapi_print("%s: exiting\n",progname);
     exit(0);
 }
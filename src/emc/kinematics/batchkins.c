@@ -0,0 +1,418 @@
+/********************************************************************
+* Description: batchkins.c
+*   Kinematics over whole arrays of poses, see batchkins.h.
+*
+*   The poses are handled BLOCK at a time: each block is transposed
+*   into one array per coordinate, so that the per-pose math, shared
+*   with the realtime modules through the *-common.h headers, is run
+*   by simple loops over plain arrays which the compiler vectorises.
+*
+* Author: LinuxCNC developers
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 LinuxCNC developers
+********************************************************************/
+
+#include <math.h>
+#include <string.h>
+
+#include "posemath.h"
+#include "emcpos.h"
+#include "batchkins.h"
+
+#include "lineardeltakins-common.h"
+#include "scarakins-common.h"
+#include "trtkins-common.h"
+
+#define BLOCK 256
+
+/* BLOCK poses or sets of joints, one array per coordinate */
+typedef struct {
+    double v[BATCHKINS_COORDS][BLOCK];
+} block_t;
+
+/* the kinematics of a block of n, from in to out */
+typedef void (*block_fn)(const batchkins_t *kins,
+                         const block_t *restrict in, block_t *restrict out,
+                         int n);
+
+static void load(block_t *b, const double *in, int n)
+{
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+	for (j = 0; j < BATCHKINS_COORDS; j++) {
+	    b->v[j][i] = in[i * BATCHKINS_COORDS + j];
+	}
+    }
+}
+
+static void store(const block_t *b, double *out, int n)
+{
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+	for (j = 0; j < BATCHKINS_COORDS; j++) {
+	    out[i * BATCHKINS_COORDS + j] = b->v[j][i];
+	}
+    }
+}
+
+static void zero(block_t *b, int first, int n)
+{
+    int j;
+
+    for (j = first; j < BATCHKINS_COORDS; j++) {
+	memset(b->v[j], 0, n * sizeof(double));
+    }
+}
+
+/* the first of n with a NaN coordinate, or -1 */
+static int first_nan(const block_t *b, int n)
+{
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+	for (j = 0; j < BATCHKINS_COORDS; j++) {
+	    if (isnan(b->v[j][i])) {
+		return i;
+	    }
+	}
+    }
+    return -1;
+}
+
+static void trivkins_forward(const batchkins_t *kins,
+                             const block_t *restrict in, block_t *restrict out,
+                             int n)
+{
+    int j;
+
+    zero(out, 0, n);
+    for (j = 0; j < BATCHKINS_COORDS; j++) {
+	if (kins->axis[j] >= 0 && kins->axis[j] < BATCHKINS_COORDS) {
+	    memcpy(out->v[kins->axis[j]], in->v[j], n * sizeof(double));
+	}
+    }
+}
+
+static void trivkins_inverse(const batchkins_t *kins,
+                             const block_t *restrict in, block_t *restrict out,
+                             int n)
+{
+    int j;
+
+    for (j = 0; j < BATCHKINS_COORDS; j++) {
+	if (kins->axis[j] >= 0 && kins->axis[j] < BATCHKINS_COORDS) {
+	    memcpy(out->v[j], in->v[kins->axis[j]], n * sizeof(double));
+	} else {
+	    memset(out->v[j], 0, n * sizeof(double));
+	}
+    }
+}
+
+static void corexykins_forward(const batchkins_t *kins,
+                               const block_t *restrict in,
+                               block_t *restrict out, int n)
+{
+    const double *j0 = in->v[0], *j1 = in->v[1];
+    double *x = out->v[0], *y = out->v[1];
+    int i;
+
+    for (i = 0; i < n; i++) {
+	x[i] = 0.5 * (j0[i] + j1[i]);
+	y[i] = 0.5 * (j0[i] - j1[i]);
+    }
+    memcpy(out->v[2], in->v[2], (BATCHKINS_COORDS - 2) * sizeof(out->v[0]));
+}
+
+static void corexykins_inverse(const batchkins_t *kins,
+                               const block_t *restrict in,
+                               block_t *restrict out, int n)
+{
+    const double *x = in->v[0], *y = in->v[1];
+    double *j0 = out->v[0], *j1 = out->v[1];
+    int i;
+
+    for (i = 0; i < n; i++) {
+	j0[i] = x[i] + y[i];
+	j1[i] = x[i] - y[i];
+    }
+    memcpy(out->v[2], in->v[2], (BATCHKINS_COORDS - 2) * sizeof(out->v[0]));
+}
+
+static void xyzac_trt_forward_block(const batchkins_t *kins,
+                                    const block_t *restrict in,
+                                    block_t *restrict out, int n)
+{
+    double dy = kins->param[0], dz = kins->param[1] + kins->param[2];
+    const double *jx = in->v[0], *jy = in->v[1], *jz = in->v[2];
+    const double *ja = in->v[3], *jc = in->v[4];
+    double *x = out->v[0], *y = out->v[1], *z = out->v[2];
+    int i;
+
+    for (i = 0; i < n; i++) {
+	xyzac_trt_forward(jx[i], jy[i], jz[i], ja[i], jc[i], dy, dz,
+	                  &x[i], &y[i], &z[i]);
+    }
+    zero(out, 3, n);
+    memcpy(out->v[3], ja, n * sizeof(double));
+    memcpy(out->v[5], jc, n * sizeof(double));
+}
+
+static void xyzac_trt_inverse_block(const batchkins_t *kins,
+                                    const block_t *restrict in,
+                                    block_t *restrict out, int n)
+{
+    double dy = kins->param[0], dz = kins->param[1] + kins->param[2];
+    const double *x = in->v[0], *y = in->v[1], *z = in->v[2];
+    const double *a = in->v[3], *c = in->v[5];
+    double *jx = out->v[0], *jy = out->v[1], *jz = out->v[2];
+    int i;
+
+    for (i = 0; i < n; i++) {
+	xyzac_trt_inverse(x[i], y[i], z[i], a[i], c[i], dy, dz,
+	                  &jx[i], &jy[i], &jz[i]);
+    }
+    zero(out, 3, n);
+    memcpy(out->v[3], a, n * sizeof(double));
+    memcpy(out->v[4], c, n * sizeof(double));
+}
+
+static void xyzbc_trt_forward_block(const batchkins_t *kins,
+                                    const block_t *restrict in,
+                                    block_t *restrict out, int n)
+{
+    double dx = kins->param[0], dz = kins->param[1] + kins->param[2];
+    const double *jx = in->v[0], *jy = in->v[1], *jz = in->v[2];
+    const double *jb = in->v[3], *jc = in->v[4];
+    double *x = out->v[0], *y = out->v[1], *z = out->v[2];
+    int i;
+
+    for (i = 0; i < n; i++) {
+	xyzbc_trt_forward(jx[i], jy[i], jz[i], jb[i], jc[i], dx, dz,
+	                  &x[i], &y[i], &z[i]);
+    }
+    zero(out, 3, n);
+    memcpy(out->v[4], jb, n * sizeof(double));
+    memcpy(out->v[5], jc, n * sizeof(double));
+}
+
+static void xyzbc_trt_inverse_block(const batchkins_t *kins,
+                                    const block_t *restrict in,
+                                    block_t *restrict out, int n)
+{
+    double dx = kins->param[0], dz = kins->param[1] + kins->param[2];
+    const double *x = in->v[0], *y = in->v[1], *z = in->v[2];
+    const double *b = in->v[4], *c = in->v[5];
+    double *jx = out->v[0], *jy = out->v[1], *jz = out->v[2];
+    int i;
+
+    for (i = 0; i < n; i++) {
+	xyzbc_trt_inverse(x[i], y[i], z[i], b[i], c[i], dx, dz,
+	                  &jx[i], &jy[i], &jz[i]);
+    }
+    zero(out, 3, n);
+    memcpy(out->v[3], b, n * sizeof(double));
+    memcpy(out->v[4], c, n * sizeof(double));
+}
+
+static void scarakins_forward_block(const batchkins_t *kins,
+                                    const block_t *restrict in,
+                                    block_t *restrict out, int n)
+{
+    const double *d = kins->param;
+    const double *j0 = in->v[0], *j1 = in->v[1], *j2 = in->v[2];
+    const double *j3 = in->v[3];
+    double *x = out->v[0], *y = out->v[1], *z = out->v[2], *c = out->v[5];
+    int i;
+
+    for (i = 0; i < n; i++) {
+	scara_forward(d, j0[i], j1[i], j2[i], j3[i], &x[i], &y[i], &z[i], &c[i]);
+    }
+    zero(out, 6, n);
+    memcpy(out->v[3], in->v[4], n * sizeof(double));
+    memcpy(out->v[4], in->v[5], n * sizeof(double));
+}
+
+static void scarakins_inverse_block(const batchkins_t *kins,
+                                    const block_t *restrict in,
+                                    block_t *restrict out, int n)
+{
+    const double *d = kins->param;
+    const double *x = in->v[0], *y = in->v[1], *z = in->v[2];
+    const double *c = in->v[5];
+    double *j0 = out->v[0], *j1 = out->v[1], *j2 = out->v[2];
+    double *j3 = out->v[3];
+    int elbow = kins->iflags;
+    int i;
+
+    for (i = 0; i < n; i++) {
+	scara_inverse(d, elbow, x[i], y[i], z[i], c[i],
+	              &j0[i], &j1[i], &j2[i], &j3[i]);
+    }
+    zero(out, 6, n);
+    memcpy(out->v[4], in->v[3], n * sizeof(double));
+    memcpy(out->v[5], in->v[4], n * sizeof(double));
+}
+
+static void lineardeltakins_forward(const batchkins_t *kins,
+                                    const block_t *restrict in,
+                                    block_t *restrict out, int n)
+{
+    const double *q1 = in->v[0], *q2 = in->v[1], *q3 = in->v[2];
+    double *x = out->v[0], *y = out->v[1], *z = out->v[2];
+    int i;
+
+    set_geometry(kins->param[0], kins->param[1]);
+    for (i = 0; i < n; i++) {
+	double xi, yi, zi;
+	int result = delta_forward_xyz(q1[i], q2[i], q3[i], &xi, &yi, &zi);
+
+	x[i] = result ? NAN : xi;
+	y[i] = result ? NAN : yi;
+	z[i] = result ? NAN : zi;
+    }
+    memcpy(out->v[3], in->v[3], (BATCHKINS_COORDS - 3) * sizeof(out->v[0]));
+}
+
+static void lineardeltakins_inverse(const batchkins_t *kins,
+                                    const block_t *restrict in,
+                                    block_t *restrict out, int n)
+{
+    const double *x = in->v[0], *y = in->v[1], *z = in->v[2];
+    double *j0 = out->v[0], *j1 = out->v[1], *j2 = out->v[2];
+    int i;
+
+    set_geometry(kins->param[0], kins->param[1]);
+    for (i = 0; i < n; i++) {
+	delta_inverse_xyz(x[i], y[i], z[i], &j0[i], &j1[i], &j2[i]);
+    }
+    memcpy(out->v[3], in->v[3], (BATCHKINS_COORDS - 3) * sizeof(out->v[0]));
+}
+
+int batchkins_init(batchkins_t *kins, batchkins_type type)
+{
+    int j;
+
+    memset(kins, 0, sizeof(*kins));
+    kins->type = type;
+    for (j = 0; j < BATCHKINS_COORDS; j++) {
+	kins->axis[j] = j;
+    }
+    switch (type) {
+    case BATCHKINS_TRIVKINS:
+    case BATCHKINS_COREXYKINS:
+    case BATCHKINS_XYZAC_TRT:
+    case BATCHKINS_XYZBC_TRT:
+	return 0;
+    case BATCHKINS_SCARAKINS:
+	/* the defaults of scarakins.c */
+	kins->param[0] = 490;
+	kins->param[1] = 340;
+	kins->param[2] = 50;
+	kins->param[3] = 250;
+	kins->param[4] = 50;
+	kins->param[5] = 50;
+	return 0;
+    case BATCHKINS_LINEARDELTAKINS:
+	kins->param[0] = DELTA_RADIUS;
+	kins->param[1] = DELTA_DIAGONAL_ROD;
+	return 0;
+    }
+    return -1;
+}
+
+static long run(const batchkins_t *kins, block_fn fn,
+                const double *in, double *out, long n)
+{
+    block_t bin, bout;
+    long first = -1, start;
+
+    if (!fn) {
+	return 0;
+    }
+    for (start = 0; start < n; start += BLOCK) {
+	int m = n - start < BLOCK ? n - start : BLOCK;
+	int bad;
+
+	load(&bin, in + start * BATCHKINS_COORDS, m);
+	fn(kins, &bin, &bout, m);
+	store(&bout, out + start * BATCHKINS_COORDS, m);
+	if (first < 0 && (bad = first_nan(&bout, m)) >= 0) {
+	    first = start + bad;
+	}
+    }
+    return first;
+}
+
+long batchkins_inverse(const batchkins_t *kins,
+                       const double *poses, double *joints, long n)
+{
+    block_fn fn = NULL;
+
+    switch (kins->type) {
+    case BATCHKINS_TRIVKINS: fn = trivkins_inverse; break;
+    case BATCHKINS_COREXYKINS: fn = corexykins_inverse; break;
+    case BATCHKINS_XYZAC_TRT: fn = xyzac_trt_inverse_block; break;
+    case BATCHKINS_XYZBC_TRT: fn = xyzbc_trt_inverse_block; break;
+    case BATCHKINS_SCARAKINS: fn = scarakins_inverse_block; break;
+    case BATCHKINS_LINEARDELTAKINS: fn = lineardeltakins_inverse; break;
+    }
+    return run(kins, fn, poses, joints, n);
+}
+
+long batchkins_forward(const batchkins_t *kins,
+                       const double *joints, double *poses, long n)
+{
+    block_fn fn = NULL;
+
+    switch (kins->type) {
+    case BATCHKINS_TRIVKINS: fn = trivkins_forward; break;
+    case BATCHKINS_COREXYKINS: fn = corexykins_forward; break;
+    case BATCHKINS_XYZAC_TRT: fn = xyzac_trt_forward_block; break;
+    case BATCHKINS_XYZBC_TRT: fn = xyzbc_trt_forward_block; break;
+    case BATCHKINS_SCARAKINS: fn = scarakins_forward_block; break;
+    case BATCHKINS_LINEARDELTAKINS: fn = lineardeltakins_forward; break;
+    }
+    return run(kins, fn, joints, poses, n);
+}
+
+long batchkins_check_limits(const double *joints, long n, int njoints,
+                            const double *min, const double *max)
+{
+    long start, i;
+    int j;
+
+    if (njoints > BATCHKINS_COORDS) {
+	njoints = BATCHKINS_COORDS;
+    }
+    /* a block at a time without branches, which vectorises, then the
+       first point of the block that failed */
+    for (start = 0; start < n; start += BLOCK) {
+	long end = n - start < BLOCK ? n : start + BLOCK;
+	int bad = 0;
+
+	for (i = start; i < end; i++) {
+	    const double *p = joints + i * BATCHKINS_COORDS;
+
+	    for (j = 0; j < njoints; j++) {
+		bad |= !(p[j] >= min[j] && p[j] <= max[j]);
+	    }
+	}
+	if (!bad) {
+	    continue;
+	}
+	for (i = start; i < end; i++) {
+	    const double *p = joints + i * BATCHKINS_COORDS;
+
+	    for (j = 0; j < njoints; j++) {
+		if (!(p[j] >= min[j] && p[j] <= max[j])) {
+		    return i;
+		}
+	    }
+	}
+    }
+    return -1;
+}
@@ -0,0 +1,74 @@
+/********************************************************************
+* Description: batchkins.h
+*   Kinematics over whole arrays of poses, for userspace programs
+*   which map a toolpath to joint space at once: limit checking a
+*   loaded program, joint space preview, simulation.
+*
+*   Poses and joints are stored as BATCHKINS_COORDS doubles each,
+*   one after the other: X Y Z A B C U V W for a pose, joints 0..8
+*   for the joints.  Angles are in degrees, as for the realtime
+*   kinematics modules, whose math these share.
+*
+* Author: LinuxCNC developers
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 LinuxCNC developers
+********************************************************************/
+#ifndef BATCHKINS_H
+#define BATCHKINS_H
+
+#define BATCHKINS_COORDS 9
+
+typedef enum {
+    BATCHKINS_TRIVKINS,
+    BATCHKINS_COREXYKINS,
+    BATCHKINS_XYZAC_TRT,
+    BATCHKINS_XYZBC_TRT,
+    BATCHKINS_SCARAKINS,
+    BATCHKINS_LINEARDELTAKINS
+} batchkins_type;
+
+typedef struct {
+    batchkins_type type;
+    /* trivkins: the coordinate (0..8 for X..W) of each joint, -1 for
+       an unused joint, as set by the coordinates= module parameter */
+    int axis[BATCHKINS_COORDS];
+    /* scarakins: the elbow solution, KINEMATICS_INVERSE_FLAGS */
+    int iflags;
+    /* xyzac-trt: y-offset, z-offset, tool-offset
+       xyzbc-trt: x-offset, z-offset, tool-offset
+       scarakins: D1..D6
+       lineardeltakins: R, L */
+    double param[6];
+} batchkins_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Set up kins for type with the defaults of its realtime module.
+   Returns 0, or -1 for an unknown type. */
+extern int batchkins_init(batchkins_t *kins, batchkins_type type);
+
+/* The joints for n poses.  Returns the index of the first pose with
+   no solution, whose joints are NaN, or -1 if all have one. */
+extern long batchkins_inverse(const batchkins_t *kins,
+                              const double *poses, double *joints, long n);
+
+/* The poses for n sets of joints.  Returns the index of the first
+   with no solution, whose pose is NaN, or -1 if all have one. */
+extern long batchkins_forward(const batchkins_t *kins,
+                              const double *joints, double *poses, long n);
+
+/* Check joints 0..njoints-1 of n sets of joints against min and max.
+   Returns the index of the first set outside them (or NaN), or -1. */
+extern long batchkins_check_limits(const double *joints, long n,
+                                   int njoints,
+                                   const double *min, const double *max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif				/* BATCHKINS_H */
@@ -0,0 +1,137 @@
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Python interface to batchkins.h.  Poses and joints are passed in
+// buffers of doubles, 9 per pose: array.array('d') or a numpy array of
+// float64 of shape (n, 9), so a whole program is mapped in one call.
+//
+//   k = batchkins.Kins(batchkins.XYZAC_TRT)
+//   k.param = (y_offset, z_offset, tool_offset)
+//   bad = k.inverse(poses, joints)
+//   bad = batchkins.check_limits(joints, min, max)
+
+#define BOOST_PYTHON_MAX_ARITY 4
+#include <boost/python.hpp>
+using namespace boost::python;
+#include "batchkins.h"
+
+static const double *read_buffer(object o, long &n)
+{
+    const void *buf;
+    Py_ssize_t len;
+
+    if(PyObject_AsReadBuffer(o.ptr(), &buf, &len) < 0)
+        throw_error_already_set();
+    if(len % (BATCHKINS_COORDS * sizeof(double))) {
+        PyErr_SetString(PyExc_ValueError,
+                "buffer must hold 9 doubles per pose");
+        throw_error_already_set();
+    }
+    n = len / (BATCHKINS_COORDS * sizeof(double));
+    return (const double *)buf;
+}
+
+static double *write_buffer(object o, long n)
+{
+    void *buf;
+    Py_ssize_t len;
+
+    if(PyObject_AsWriteBuffer(o.ptr(), &buf, &len) < 0)
+        throw_error_already_set();
+    if(len < (Py_ssize_t)(n * BATCHKINS_COORDS * sizeof(double))) {
+        PyErr_SetString(PyExc_ValueError, "output buffer too small");
+        throw_error_already_set();
+    }
+    return (double *)buf;
+}
+
+struct Kins : batchkins_t {
+    Kins(int type_) {
+        if(batchkins_init(this, (batchkins_type)type_) < 0) {
+            PyErr_SetString(PyExc_ValueError, "unknown kinematics type");
+            throw_error_already_set();
+        }
+    }
+
+    long inverse(object poses, object joints) {
+        long n;
+        const double *in = read_buffer(poses, n);
+        double *out = write_buffer(joints, n);
+        return batchkins_inverse(this, in, out, n);
+    }
+
+    long forward(object joints, object poses) {
+        long n;
+        const double *in = read_buffer(joints, n);
+        double *out = write_buffer(poses, n);
+        return batchkins_forward(this, in, out, n);
+    }
+
+    object get_param() const {
+        list result;
+        for(int i = 0; i < 6; i++) result.append(param[i]);
+        return tuple(result);
+    }
+
+    void set_param(object o) {
+        int n = len(o);
+        for(int i = 0; i < 6; i++) param[i] = i < n ? extract<double>(o[i]) : 0.;
+    }
+
+    object get_axes() const {
+        list result;
+        for(int i = 0; i < BATCHKINS_COORDS; i++) result.append(axis[i]);
+        return tuple(result);
+    }
+
+    void set_axes(object o) {
+        int n = len(o);
+        for(int i = 0; i < BATCHKINS_COORDS; i++)
+            axis[i] = i < n ? extract<int>(o[i]) : -1;
+    }
+};
+
+static long check_limits(object joints, object min, object max)
+{
+    long n;
+    const double *in = read_buffer(joints, n);
+    int njoints = std::min(len(min), len(max));
+    double mn[BATCHKINS_COORDS], mx[BATCHKINS_COORDS];
+
+    if(njoints > BATCHKINS_COORDS) njoints = BATCHKINS_COORDS;
+    for(int i = 0; i < njoints; i++) {
+        mn[i] = extract<double>(min[i]);
+        mx[i] = extract<double>(max[i]);
+    }
+    return batchkins_check_limits(in, n, njoints, mn, mx);
+}
+
+BOOST_PYTHON_MODULE(batchkins)
+{
+    scope().attr("TRIVKINS") = (int)BATCHKINS_TRIVKINS;
+    scope().attr("COREXYKINS") = (int)BATCHKINS_COREXYKINS;
+    scope().attr("XYZAC_TRT") = (int)BATCHKINS_XYZAC_TRT;
+    scope().attr("XYZBC_TRT") = (int)BATCHKINS_XYZBC_TRT;
+    scope().attr("SCARAKINS") = (int)BATCHKINS_SCARAKINS;
+    scope().attr("LINEARDELTAKINS") = (int)BATCHKINS_LINEARDELTAKINS;
+
+    class_<Kins>("Kins", init<int>())
+        .def("inverse", &Kins::inverse)
+        .def("forward", &Kins::forward)
+        .add_property("param", &Kins::get_param, &Kins::set_param)
+        .add_property("axes", &Kins::get_axes, &Kins::set_axes)
+        .def_readwrite("iflags", &Kins::iflags)
+        ;
+    def("check_limits", check_limits);
+}
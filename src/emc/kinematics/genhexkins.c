@@ -282,17 +282,17 @@ int StrutLengthCorrection(const PmCartesian * StrutVectUnit,
   double dotprod;
 
   /* define base joints axis vectors */
-  pmCartCartCross(&nb1[strut_number], StrutVectUnit, &nb2);
-  pmCartCartCross(StrutVectUnit, &nb2, &nb3);
+  nb2 = pmCartCross(nb1[strut_number], *StrutVectUnit);
+  nb3 = pmCartCross(*StrutVectUnit, nb2);
   pmCartUnitEq(&nb3);
 
   /* define platform joints axis vectors */
-  pmMatCartMult(RMatrix, &na0[strut_number], &na1);
-  pmCartCartCross(&na1, StrutVectUnit, &na2);
+  na1 = pmMatApply(RMatrix, na0[strut_number]);
+  na2 = pmCartCross(na1, *StrutVectUnit);
   pmCartUnitEq(&na2);
 
   /* define dot product */
-  pmCartCartDot(&nb3, &na2, &dotprod);
+  dotprod = pmCartDot(nb3, na2);
 
   *correction = haldata->screw_lead * asin(dotprod) / PM_2_PI;
 
@@ -375,13 +375,13 @@ int kinematicsForward(const double * joints,
      estimate to get joint estimate, subtract joints to get joint deltas,
      and compute inv J while we're at it */
     for (i = 0; i < NUM_STRUTS; i++) {
-      pmMatCartMult(&RMatrix, &a[i], &RMatrix_a);
-      pmCartCartAdd(&q_trans, &RMatrix_a, &aw);
-      pmCartCartSub(&aw, &b[i], &InvKinStrutVect);
+      RMatrix_a = pmMatApply(&RMatrix, a[i]);
+      aw = pmCartAdd(q_trans, RMatrix_a);
+      InvKinStrutVect = pmCartSub(aw, b[i]);
       if (0 != pmCartUnit(&InvKinStrutVect, &InvKinStrutVectUnit)) {
         return -1;
       }
-      pmCartMag(&InvKinStrutVect, &InvKinStrutLength);
+      InvKinStrutLength = pmCartLength(InvKinStrutVect);
 
       if (haldata->screw_lead != 0.0) {
         /* enable strut length correction */
@@ -393,7 +393,7 @@ int kinematicsForward(const double * joints,
       StrutLengthDiff[i] = InvKinStrutLength - joints[i];
 
       /* Determine RMatrix_a_cross_strut */
-      pmCartCartCross(&RMatrix_a, &InvKinStrutVectUnit, &RMatrix_a_cross_Strut);
+      RMatrix_a_cross_Strut = pmCartCross(RMatrix_a, InvKinStrutVectUnit);
 
       /* Build Inverse Jacobian Matrix */
       InverseJacobian[i][0] = InvKinStrutVectUnit.x;
@@ -483,12 +483,12 @@ int kinematicsInverse(const EmcPose * pos,
   for (i = 0; i < NUM_STRUTS; i++) {
     /* convert location of platform strut end from platform
        to world coordinates */
-    pmMatCartMult(&RMatrix, &a[i], &temp);
-    pmCartCartAdd(&pos->tran, &temp, &aw);
+    temp = pmMatApply(&RMatrix, a[i]);
+    aw = pmCartAdd(pos->tran, temp);
 
     /* define strut lengths */
-    pmCartCartSub(&aw, &b[i], &InvKinStrutVect);
-    pmCartMag(&InvKinStrutVect, &InvKinStrutLength);
+    InvKinStrutVect = pmCartSub(aw, b[i]);
+    InvKinStrutLength = pmCartLength(InvKinStrutVect);
 
     if (haldata->screw_lead != 0.0) {
       /* enable strut length correction */
@@ -63,29 +63,20 @@ static void set_geometry(double r_, double l_)
     Cy = -COS_60 * R;
 }
 
-static int kinematics_inverse(const EmcPose *pos, double *joints)
+// the xyz part of the kinematics, which batchkins.c runs over whole arrays.
+// An unreachable point gives NaN joints.
+static inline void delta_inverse_xyz(double x, double y, double z,
+	double *j0, double *j1, double *j2)
 {
-    double x = pos->tran.x, y = pos->tran.y, z = pos->tran.z;
-    joints[0] = z + sqrt(L2 - sq(Ax-x) - sq(Ay-y));
-    joints[1] = z + sqrt(L2 - sq(Bx-x) - sq(By-y));
-    joints[2] = z + sqrt(L2 - sq(Cx-x) - sq(Cy-y));
-    joints[3] = pos->a;
-    joints[4] = pos->b;
-    joints[5] = pos->c;
-    joints[6] = pos->u;
-    joints[7] = pos->v;
-    joints[8] = pos->w;
-
-    return isnan(joints[0]) || isnan(joints[1]) || isnan(joints[2])
-	? -1 : 0;
+    *j0 = z + sqrt(L2 - sq(Ax-x) - sq(Ay-y));
+    *j1 = z + sqrt(L2 - sq(Bx-x) - sq(By-y));
+    *j2 = z + sqrt(L2 - sq(Cx-x) - sq(Cy-y));
 }
 
-static int kinematics_forward(const double *joints, EmcPose *pos)
+// Returns -1, leaving x, y and z meaningless, for joints with no solution.
+static inline int delta_forward_xyz(double q1, double q2, double q3,
+	double *x, double *y, double *z)
 {
-    double q1 = joints[0];
-    double q2 = joints[1];
-    double q3 = joints[2];
-
     double den = (By-Ay)*Cx-(Cy-Ay)*Bx;
 
     double w1 = Ay*Ay + q1*q1; // n.b. assumption that Ax is 0 all through here
@@ -104,12 +95,40 @@ static int kinematics_forward(const double *joints, EmcPose *pos)
     double c = (b2-Ay*den)*(b2-Ay*den) + b1*b1 + den*den*(q1*q1 - L*L);
 
     double discr = b*b - 4.0*a*c;
-    if (discr < 0) return -1; // non-existing point
+    int result = discr < 0 ? -1 : 0; // non-existing point
+
+    *z = -0.5*(b+sqrt(result ? 0 : discr))/a;
+    *x = (a1 * *z + b1)/den;
+    *y = (a2 * *z + b2)/den;
+
+    return result;
+}
+
+static int kinematics_inverse(const EmcPose *pos, double *joints)
+{
+    delta_inverse_xyz(pos->tran.x, pos->tran.y, pos->tran.z,
+	    &joints[0], &joints[1], &joints[2]);
+    joints[3] = pos->a;
+    joints[4] = pos->b;
+    joints[5] = pos->c;
+    joints[6] = pos->u;
+    joints[7] = pos->v;
+    joints[8] = pos->w;
+
+    return isnan(joints[0]) || isnan(joints[1]) || isnan(joints[2])
+	? -1 : 0;
+}
+
+static int kinematics_forward(const double *joints, EmcPose *pos)
+{
+    double x, y, z;
+
+    if (delta_forward_xyz(joints[0], joints[1], joints[2], &x, &y, &z) < 0)
+	return -1; // non-existing point
 
-    double z = -0.5*(b+sqrt(discr))/a;
+    pos->tran.x = x;
+    pos->tran.y = y;
     pos->tran.z = z;
-    pos->tran.x = (a1*z + b1)/den;
-    pos->tran.y = (a2*z + b2)/den;
     pos->a = joints[3];
     pos->b = joints[4];
     pos->c = joints[5];
@@ -0,0 +1,93 @@
+#ifndef LINUXCNCSCARAKINS_COMMON_H
+#define LINUXCNCSCARAKINS_COMMON_H
+/*****************************************************************
+* Description: scarakins-common.h
+*   Kinematics for scara typed robots, shared by the realtime
+*   module scarakins.c and the batch kinematics in batchkins.c.
+*   See scarakins.c for the meaning of D1..D6, passed here as
+*   d[0]..d[5].
+*
+*   User must include a math.h-type header and posemath.h first.
+*
+*   Derived from a work by Sagar Behere
+*
+* Author: Sagar Behere
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2003 All rights reserved.
+*******************************************************************
+*/
+
+/* joint 0, 1 and 3 and c are in degrees, joint 2 is in length units */
+static inline void scara_forward(const double *d,
+                                 double j0, double j1, double j2, double j3,
+                                 double *x, double *y, double *z, double *c)
+{
+    double a0, a1, a3;
+
+/* convert joint angles to radians for sin() and cos() */
+
+    a0 = j0 * ( PM_PI / 180 );
+    a1 = j1 * ( PM_PI / 180 );
+    a3 = j3 * ( PM_PI / 180 );
+/* convert angles into world coords */
+
+    a1 = a1 + a0;
+    a3 = a3 + a1;
+
+    *x = d[1]*cos(a0) + d[3]*cos(a1) + d[5]*cos(a3);
+    *y = d[1]*sin(a0) + d[3]*sin(a1) + d[5]*sin(a3);
+    *z = d[0] + d[2] - j2 - d[4];
+    *c = a3 * 180 / PM_PI;
+}
+
+/* elbow is the inverse flag: nonzero for the other elbow solution */
+static inline void scara_inverse(const double *d, int elbow,
+                                 double x, double y, double z, double c,
+                                 double *j0, double *j1, double *j2, double *j3)
+{
+    double a3;
+    double q0, q1;
+    double xt, yt, rsq, cc;
+
+    /* convert degrees to radians */
+    a3 = c * ( PM_PI / 180 );
+
+    /* center of end effector (correct for D6) */
+    xt = x - d[5]*cos(a3);
+    yt = y - d[5]*sin(a3);
+
+    /* horizontal distance (squared) from end effector centerline
+	to main column centerline */
+    rsq = xt*xt + yt*yt;
+    /* joint 1 angle needed to make arm length match sqrt(rsq) */
+    cc = (rsq - d[1]*d[1] - d[3]*d[3]) / (2*d[1]*d[3]);
+    if(cc < -1) cc = -1;
+    if(cc > 1) cc = 1;
+    q1 = acos(cc);
+
+    if (elbow)
+	q1 = -q1;
+
+    /* angle to end effector */
+    q0 = atan2(yt, xt);
+
+    /* end effector coords in inner arm coord system */
+    xt = d[1] + d[3]*cos(q1);
+    yt = d[3]*sin(q1);
+
+    /* inner arm angle */
+    q0 = q0 - atan2(yt, xt);
+
+    /* q0 and q1 are still in radians. convert them to degrees */
+    q0 = q0 * (180 / PM_PI);
+    q1 = q1 * (180 / PM_PI);
+
+    *j0 = q0;
+    *j1 = q1;
+    *j2 = d[0] + d[2] - d[4] - z;
+    *j3 = c - ( q0 + q1);
+}
+
+#endif
@@ -18,6 +18,7 @@
 #include "posemath.h"
 #include "rtapi_math.h"
 #include "kinematics.h"             /* decls for kinematicsForward, etc. */
+#include "scarakins-common.h"
 
 #include "rtapi.h"		/* RTAPI realtime OS API */
 #include "rtapi_app.h"		/* RTAPI realtime module decls */
@@ -76,24 +77,11 @@ int kinematicsForward(const double * joint,
                       const KINEMATICS_FORWARD_FLAGS * fflags,
                       KINEMATICS_INVERSE_FLAGS * iflags)
 {
-    double a0, a1, a3;
+    double d[6] = { D1, D2, D3, D4, D5, D6 };
     double x, y, z, c;
 
-/* convert joint angles to radians for sin() and cos() */
+    scara_forward(d, joint[0], joint[1], joint[2], joint[3], &x, &y, &z, &c);
 
-    a0 = joint[0] * ( PM_PI / 180 );
-    a1 = joint[1] * ( PM_PI / 180 );
-    a3 = joint[3] * ( PM_PI / 180 );
-/* convert angles into world coords */
-
-    a1 = a1 + a0;
-    a3 = a3 + a1;
-
-    x = D2*cos(a0) + D4*cos(a1) + D6*cos(a3);
-    y = D2*sin(a0) + D4*sin(a1) + D6*sin(a3);
-    z = D1 + D3 - joint[2] - D5;
-    c = a3;
-	
     *iflags = 0;
     if (joint[1] < 90)
 	*iflags = 1;
@@ -101,7 +89,7 @@ int kinematicsForward(const double * joint,
     world->tran.x = x;
     world->tran.y = y;
     world->tran.z = z;
-    world->c = c * 180 / PM_PI;
+    world->c = c;
 	
     world->a = joint[4];
     world->b = joint[5];
@@ -114,53 +102,10 @@ int kinematicsInverse(const EmcPose * world,
                       const KINEMATICS_INVERSE_FLAGS * iflags,
                       KINEMATICS_FORWARD_FLAGS * fflags)
 {
-    double a3;
-    double q0, q1;
-    double xt, yt, rsq, cc;
-    double x, y, z, c;
-
-    x = world->tran.x;
-    y = world->tran.y;
-    z = world->tran.z;
-    c = world->c;
-
-    /* convert degrees to radians */
-    a3 = c * ( PM_PI / 180 );
-
-    /* center of end effector (correct for D6) */
-    xt = x - D6*cos(a3);
-    yt = y - D6*sin(a3);
-
-    /* horizontal distance (squared) from end effector centerline
-	to main column centerline */
-    rsq = xt*xt + yt*yt;
-    /* joint 1 angle needed to make arm length match sqrt(rsq) */
-    cc = (rsq - D2*D2 - D4*D4) / (2*D2*D4);
-    if(cc < -1) cc = -1;
-    if(cc > 1) cc = 1;
-    q1 = acos(cc);
-
-    if (*iflags)
-	q1 = -q1;
-
-    /* angle to end effector */
-    q0 = atan2(yt, xt);
-
-    /* end effector coords in inner arm coord system */
-    xt = D2 + D4*cos(q1);
-    yt = D4*sin(q1);
-
-    /* inner arm angle */
-    q0 = q0 - atan2(yt, xt);
-
-    /* q0 and q1 are still in radians. convert them to degrees */
-    q0 = q0 * (180 / PM_PI);
-    q1 = q1 * (180 / PM_PI);
+    double d[6] = { D1, D2, D3, D4, D5, D6 };
 
-    joint[0] = q0;
-    joint[1] = q1;
-    joint[2] = D1 + D3 - D5 - z;
-    joint[3] = c - ( q0 + q1);
+    scara_inverse(d, *iflags, world->tran.x, world->tran.y, world->tran.z,
+                  world->c, &joint[0], &joint[1], &joint[2], &joint[3]);
     joint[4] = world->a;
     joint[5] = world->b;
 
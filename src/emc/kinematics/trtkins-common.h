@@ -0,0 +1,129 @@
+#ifndef LINUXCNCTRTKINS_COMMON_H
+#define LINUXCNCTRTKINS_COMMON_H
+/**************************************************************************
+* Copyright 2016 Rudy du Preez <rudy@asmsa.co.za>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**************************************************************************/
+
+/********************************************************************
+* The XYZ part of the kinematics for the tilting table / rotary table
+* mills 'xyzac-trt' and 'xyzbc-trt', shared by the realtime modules
+* and the batch kinematics in batchkins.c.
+*
+* Rotary angles are in degrees.  dz is the z offset plus the tool
+* offset.  The rotary joints are the rotary coordinates, which the
+* callers copy.
+*
+* User must include a math.h-type header and posemath.h first.
+********************************************************************/
+
+static inline void xyzac_trt_forward(double jx, double jy, double jz,
+                                     double a, double c,
+                                     double dy, double dz,
+                                     double *x, double *y, double *z)
+{
+    double a_rad = a*TO_RAD;
+    double c_rad = c*TO_RAD;
+
+    *x = + cos(c_rad)              * (jx     )
+         + sin(c_rad) * cos(a_rad) * (jy - dy)
+         + sin(c_rad) * sin(a_rad) * (jz - dz)
+         + sin(c_rad) * dy;
+
+    *y = - sin(c_rad)              * (jx     )
+         + cos(c_rad) * cos(a_rad) * (jy - dy)
+         + cos(c_rad) * sin(a_rad) * (jz - dz)
+         + cos(c_rad) * dy;
+
+    *z = + 0
+         - sin(a_rad) * (jy - dy)
+         + cos(a_rad) * (jz - dz)
+         + dz;
+}
+
+static inline void xyzac_trt_inverse(double x, double y, double z,
+                                     double a, double c,
+                                     double dy, double dz,
+                                     double *jx, double *jy, double *jz)
+{
+    double a_rad = a*TO_RAD;
+    double c_rad = c*TO_RAD;
+
+    *jx = + cos(c_rad) * x
+          - sin(c_rad) * y;
+
+    *jy = + sin(c_rad) * cos(a_rad) * x
+          + cos(c_rad) * cos(a_rad) * y
+          - sin(a_rad)              * z
+          - cos(a_rad) * dy
+          + sin(a_rad) * dz + dy;
+
+    *jz = + sin(c_rad) * sin(a_rad) * x
+          + cos(c_rad) * sin(a_rad) * y
+          + cos(a_rad)              * z
+          - sin(a_rad) * dy
+          - cos(a_rad) * dz
+          + dz;
+}
+
+static inline void xyzbc_trt_forward(double jx, double jy, double jz,
+                                     double b, double c,
+                                     double dx, double dz,
+                                     double *x, double *y, double *z)
+{
+    double b_rad = b*TO_RAD;
+    double c_rad = c*TO_RAD;
+
+    *x =   cos(c_rad) * cos(b_rad) * (jx - dx)
+         + sin(c_rad) *              (jy)
+         - cos(c_rad) * sin(b_rad) * (jz - dz)
+         + cos(c_rad) * dx;
+
+    *y = - sin(c_rad) * cos(b_rad) * (jx - dx)
+         + cos(c_rad) *              (jy)
+         + sin(c_rad) * sin(b_rad) * (jz - dz)
+         - sin(c_rad) * dx;
+
+    *z =   sin(b_rad) * (jx - dx)
+         + cos(b_rad) * (jz - dz)
+         + dz;
+}
+
+static inline void xyzbc_trt_inverse(double x, double y, double z,
+                                     double b, double c,
+                                     double dx, double dz,
+                                     double *jx, double *jy, double *jz)
+{
+    double b_rad = b*TO_RAD;
+    double c_rad = c*TO_RAD;
+    double   dpx = -cos(b_rad)*dx - sin(b_rad)*dz + dx;
+    double   dpz = sin(b_rad)*dx - cos(b_rad)*dz + dz;
+
+    *jx =   cos(c_rad) * cos(b_rad) * x
+          - sin(c_rad) * cos(b_rad) * y
+          + sin(b_rad) * z
+          + dpx;
+
+    *jy =   sin(c_rad) * x
+          + cos(c_rad) * y;
+
+    *jz = - cos(c_rad) * sin(b_rad) * x
+          + sin(c_rad) * sin(b_rad) * y
+          + cos(b_rad) * z
+          + dpz;
+}
+
+#endif
@@ -27,6 +27,7 @@
 #include "hal.h"
 #include "rtapi.h"
 #include "rtapi_math.h"
+#include "trtkins-common.h"
 
 // sequential joint number assignments
 #define JX 0
@@ -50,25 +51,10 @@ int kinematicsForward(const double *joints,
     double    dy = *(haldata->y_offset);
     double    dz = *(haldata->z_offset);
     double    dt = *(haldata->tool_offset);
-    double a_rad = joints[JA]*TO_RAD;
-    double c_rad = joints[JC]*TO_RAD;
 
-    dz = dz + dt;
-
-    pos->tran.x = + cos(c_rad)              * (joints[JX]     )
-                  + sin(c_rad) * cos(a_rad) * (joints[JY] - dy)
-                  + sin(c_rad) * sin(a_rad) * (joints[JZ] - dz)
-                  + sin(c_rad) * dy;
-
-    pos->tran.y = - sin(c_rad)              * (joints[JX]     )
-                  + cos(c_rad) * cos(a_rad) * (joints[JY] - dy)
-                  + cos(c_rad) * sin(a_rad) * (joints[JZ] - dz)
-                  + cos(c_rad) * dy;
-
-    pos->tran.z = + 0
-                  - sin(a_rad) * (joints[JY] - dy)
-                  + cos(a_rad) * (joints[JZ] - dz)
-                  + dz;
+    xyzac_trt_forward(joints[JX], joints[JY], joints[JZ],
+                      joints[JA], joints[JC], dy, dz + dt,
+                      &pos->tran.x, &pos->tran.y, &pos->tran.z);
 
     pos->a = joints[JA];
     pos->c = joints[JC];
@@ -89,26 +75,10 @@ int kinematicsInverse(const EmcPose * pos,
     double    dz = *(haldata->z_offset);
     double    dy = *(haldata->y_offset);
     double    dt = *(haldata->tool_offset);
-    double c_rad = pos->c*TO_RAD;
-    double a_rad = pos->a*TO_RAD;
-
-    dz = dz + dt;
-
-    joints[JX] = + cos(c_rad) * pos->tran.x
-                 - sin(c_rad) * pos->tran.y;
-
-    joints[JY] = + sin(c_rad) * cos(a_rad) * pos->tran.x
-                 + cos(c_rad) * cos(a_rad) * pos->tran.y
-                 - sin(a_rad)              * pos->tran.z
-                 - cos(a_rad) * dy
-                 + sin(a_rad) * dz + dy;
-
-    joints[JZ] = + sin(c_rad) * sin(a_rad) * pos->tran.x
-                 + cos(c_rad) * sin(a_rad) * pos->tran.y
-                 + cos(a_rad)              * pos->tran.z
-                 - sin(a_rad) * dy
-                 - cos(a_rad) * dz
-                 + dz;
+
+    xyzac_trt_inverse(pos->tran.x, pos->tran.y, pos->tran.z,
+                      pos->a, pos->c, dy, dz + dt,
+                      &joints[JX], &joints[JY], &joints[JZ]);
 
     joints[JA] = pos->a;
     joints[JC] = pos->c;
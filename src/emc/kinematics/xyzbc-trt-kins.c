@@ -27,6 +27,7 @@
 #include "hal.h"
 #include "rtapi.h"
 #include "rtapi_math.h"
+#include "trtkins-common.h"
 
 // sequential joint number assignments
 #define JX 0
@@ -50,24 +51,10 @@ int kinematicsForward(const double *joints,
     double    dx = *(haldata->x_offset);
     double    dz = *(haldata->z_offset);
     double    dt = *(haldata->tool_offset);
-              dz = dz + dt;
-    double b_rad = joints[JB]*TO_RAD;
-    double c_rad = joints[JC]*TO_RAD;
 
-
-    pos->tran.x =   cos(c_rad) * cos(b_rad) * (joints[JX] - dx)
-                  + sin(c_rad) *              (joints[JY])
-                  - cos(c_rad) * sin(b_rad) * (joints[JZ] - dz)
-                  + cos(c_rad) * dx;
-
-    pos->tran.y = - sin(c_rad) * cos(b_rad) * (joints[JX] - dx)
-                  + cos(c_rad) *              (joints[JY])
-                  + sin(c_rad) * sin(b_rad) * (joints[JZ] - dz)
-                  - sin(c_rad) * dx;
-
-    pos->tran.z =   sin(b_rad) * (joints[JX] - dx)
-                  + cos(b_rad) * (joints[JZ] - dz)
-                  + dz;
+    xyzbc_trt_forward(joints[JX], joints[JY], joints[JZ],
+                      joints[JB], joints[JC], dx, dz + dt,
+                      &pos->tran.x, &pos->tran.y, &pos->tran.z);
 
     pos->b = joints[JB];
     pos->c = joints[JC];
@@ -88,25 +75,10 @@ int kinematicsInverse(const EmcPose * pos,
     double    dx = *(haldata->x_offset);
     double    dz = *(haldata->z_offset);
     double    dt = *(haldata->tool_offset);
-              dz = dz + dt;
-    double b_rad = pos->b*TO_RAD;
-    double c_rad = pos->c*TO_RAD;
-    double   dpx = -cos(b_rad)*dx - sin(b_rad)*dz + dx;
-    double   dpz = sin(b_rad)*dx - cos(b_rad)*dz + dz;
-
-
-    joints[JX] =   cos(c_rad) * cos(b_rad) * (pos->tran.x)
-                 - sin(c_rad) * cos(b_rad) * (pos->tran.y)
-                 + sin(b_rad) * (pos->tran.z)
-                 + dpx;
-
-    joints[JY] =   sin(c_rad) * (pos->tran.x)
-                 + cos(c_rad) * (pos->tran.y);
 
-    joints[JZ] = - cos(c_rad) * sin(b_rad) * (pos->tran.x)
-                 + sin(c_rad) * sin(b_rad) * (pos->tran.y)
-                 + cos(b_rad) * (pos->tran.z)
-                 + dpz;
+    xyzbc_trt_inverse(pos->tran.x, pos->tran.y, pos->tran.z,
+                      pos->b, pos->c, dx, dz + dt,
+                      &joints[JX], &joints[JY], &joints[JZ]);
 
     joints[JB] = pos->b;
     joints[JC] = pos->c ;
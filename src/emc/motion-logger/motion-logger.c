@@ -287,6 +287,35 @@ void log_print(const char *fmt, ...) {
 }
 
 
+static void log_segment(emcmot_segment_t const *seg) {
+    if (seg->command == EMCMOT_SET_LINE) {
+        log_print(
+            "SET_LINE x=%.6f, y=%.6f, z=%.6f, a=%.6f, b=%.6f, c=%.6f, u=%.6f, v=%.6f, w=%.6f, id=%d, motion_type=%d, vel=%.6f, ini_maxvel=%.6f, acc=%.6f, turn=%d\n",
+            seg->pos.tran.x, seg->pos.tran.y, seg->pos.tran.z,
+            seg->pos.a, seg->pos.b, seg->pos.c,
+            seg->pos.u, seg->pos.v, seg->pos.w,
+            seg->id, seg->motion_type,
+            seg->vel, seg->ini_maxvel,
+            seg->acc, seg->turn
+        );
+    } else {
+        log_print("SET_CIRCLE:\n");
+        log_print(
+            "    pos: x=%.6f, y=%.6f, z=%.6f, a=%.6f, b=%.6f, c=%.6f, u=%.6f, v=%.6f, w=%.6f\n",
+            seg->pos.tran.x, seg->pos.tran.y, seg->pos.tran.z,
+            seg->pos.a, seg->pos.b, seg->pos.c,
+            seg->pos.u, seg->pos.v, seg->pos.w
+        );
+        log_print("    center: x=%.6f, y=%.6f, z=%.6f\n", seg->center.x, seg->center.y, seg->center.z);
+        log_print("    normal: x=%.6f, y=%.6f, z=%.6f\n", seg->normal.x, seg->normal.y, seg->normal.z);
+        log_print("    id=%d, motion_type=%d, vel=%.6f, ini_maxvel=%.6f, acc=%.6f, turn=%d\n",
+            seg->id, seg->motion_type,
+            seg->vel, seg->ini_maxvel,
+            seg->acc, seg->turn
+        );
+    }
+}
+
 int main(int argc, char* argv[]) {
     if (argc == 1) {
         logfile = stdout;
@@ -466,32 +495,29 @@ int main(int argc, char* argv[]) {
                 break;
 
             case EMCMOT_SET_LINE:
-                log_print(
-                    "SET_LINE x=%.6f, y=%.6f, z=%.6f, a=%.6f, b=%.6f, c=%.6f, u=%.6f, v=%.6f, w=%.6f, id=%d, motion_type=%d, vel=%.6f, ini_maxvel=%.6f, acc=%.6f, turn=%d\n",
-                    c->pos.tran.x, c->pos.tran.y, c->pos.tran.z,
-                    c->pos.a, c->pos.b, c->pos.c,
-                    c->pos.u, c->pos.v, c->pos.w,
-                    c->id, c->motion_type,
-                    c->vel, c->ini_maxvel,
-                    c->acc, c->turn
-                );
+            case EMCMOT_SET_CIRCLE: {
+                emcmot_segment_t seg = {
+                    .command = c->command,
+                    .pos = c->pos,
+                    .center = c->center,
+                    .normal = c->normal,
+                    .turn = c->turn,
+                    .motion_type = c->motion_type,
+                    .vel = c->vel,
+                    .ini_maxvel = c->ini_maxvel,
+                    .acc = c->acc,
+                    .id = c->id
+                };
+                log_segment(&seg);
                 break;
+            }
 
-            case EMCMOT_SET_CIRCLE:
-                log_print("SET_CIRCLE:\n");
-                log_print(
-                    "    pos: x=%.6f, y=%.6f, z=%.6f, a=%.6f, b=%.6f, c=%.6f, u=%.6f, v=%.6f, w=%.6f\n",
-                    c->pos.tran.x, c->pos.tran.y, c->pos.tran.z,
-                    c->pos.a, c->pos.b, c->pos.c,
-                    c->pos.u, c->pos.v, c->pos.w
-                );
-                log_print("    center: x=%.6f, y=%.6f, z=%.6f\n", c->center.x, c->center.y, c->center.z);
-                log_print("    normal: x=%.6f, y=%.6f, z=%.6f\n", c->normal.x, c->normal.y, c->normal.z);
-                log_print("    id=%d, motion_type=%d, vel=%.6f, ini_maxvel=%.6f, acc=%.6f, turn=%d\n",
-                    c->id, c->motion_type,
-                    c->vel, c->ini_maxvel,
-                    c->acc, c->turn
-                );
+            case EMCMOT_SET_SEGMENTS:
+                // logged as if each move had come in its own command, so
+                // the log doesn't depend on how task batched them
+                for (int i = 0; i < c->nsegments; i ++) {
+                    log_segment(&c->segments[i]);
+                }
                 break;
 
             case EMCMOT_SET_TELEOP_VECTOR:
@@ -399,6 +399,176 @@ STATIC int is_feed_type(int motion_type)
     }
 }
 
+/* segment_from_command() copies the move of an EMCMOT_SET_LINE or
+   EMCMOT_SET_CIRCLE command into an emcmot_segment_t */
+STATIC void segment_from_command(emcmot_segment_t *seg)
+{
+    seg->command = emcmotCommand->command;
+    seg->pos = emcmotCommand->pos;
+    seg->center = emcmotCommand->center;
+    seg->normal = emcmotCommand->normal;
+    seg->turn = emcmotCommand->turn;
+    seg->motion_type = emcmotCommand->motion_type;
+    seg->vel = emcmotCommand->vel;
+    seg->ini_maxvel = emcmotCommand->ini_maxvel;
+    seg->acc = emcmotCommand->acc;
+    seg->id = emcmotCommand->id;
+}
+
+/* set_line() and set_circle() append one move to the coordinated mode
+   trajectory planner.  They return 0 if the move was accepted, -1 if it
+   was rejected, in which case the error has been reported and
+   emcmotStatus->commandStatus set. */
+STATIC int set_line(emcmot_segment_t const *seg)
+{
+    char issue_atspeed = 0;
+
+    if (!GET_MOTION_COORD_FLAG() || !GET_MOTION_ENABLE_FLAG()) {
+	reportError(_("need to be enabled, in coord mode for linear move"));
+	emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_COMMAND;
+	SET_MOTION_ERROR_FLAG(1);
+	return -1;
+    } else if (!inRange(seg->pos, seg->id, "Linear")) {
+	emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
+	tpAbort(&emcmotDebug->coord_tp);
+	SET_MOTION_ERROR_FLAG(1);
+	return -1;
+    } else if (!limits_ok()) {
+	reportError(_("can't do linear move with limits exceeded"));
+	emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
+	tpAbort(&emcmotDebug->coord_tp);
+	SET_MOTION_ERROR_FLAG(1);
+	return -1;
+    }
+    if(emcmotStatus->atspeed_next_feed && is_feed_type(seg->motion_type) ) {
+	issue_atspeed = 1;
+	emcmotStatus->atspeed_next_feed = 0;
+    }
+    if(!is_feed_type(seg->motion_type) && emcmotStatus->spindle.css_factor) {
+	emcmotStatus->atspeed_next_feed = 1;
+    }
+    /* append it to the emcmotDebug->coord_tp */
+    tpSetId(&emcmotDebug->coord_tp, seg->id);
+    int res_addline = tpAddLine(&emcmotDebug->coord_tp, seg->pos, seg->motion_type,
+			    seg->vel, seg->ini_maxvel,
+			    seg->acc, emcmotStatus->enables_new, issue_atspeed,
+			    seg->turn);
+    //KLUDGE ignore zero length line
+    if (res_addline < 0) {
+	reportError(_("can't add linear move at line %d, error code %d"),
+		seg->id, res_addline);
+	emcmotStatus->commandStatus = EMCMOT_COMMAND_BAD_EXEC;
+	tpAbort(&emcmotDebug->coord_tp);
+	SET_MOTION_ERROR_FLAG(1);
+	return -1;
+    } else if (res_addline != 0) {
+	//TODO make this hand-shake more explicit
+	//KLUDGE Non fatal error, need to restore state so that the next
+	//line properly handles at_speed
+	if (issue_atspeed) {
+	    emcmotStatus->atspeed_next_feed = 1;
+	}
+    } else {
+	SET_MOTION_ERROR_FLAG(0);
+	/* set flag that indicates all joints need rehoming, if any
+	   joint is moved in joint mode, for machines with no forward
+	   kins */
+	rehomeAll = 1;
+    }
+    return 0;
+}
+
+STATIC int set_circle(emcmot_segment_t const *seg)
+{
+    char issue_atspeed = 0;
+
+    if (!GET_MOTION_COORD_FLAG() || !GET_MOTION_ENABLE_FLAG()) {
+	reportError(_("need to be enabled, in coord mode for circular move"));
+	emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_COMMAND;
+	SET_MOTION_ERROR_FLAG(1);
+	return -1;
+    } else if (!inRange(seg->pos, seg->id, "Circular")) {
+	emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
+	tpAbort(&emcmotDebug->coord_tp);
+	SET_MOTION_ERROR_FLAG(1);
+	return -1;
+    } else if (!limits_ok()) {
+	reportError(_("can't do circular move with limits exceeded"));
+	emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
+	tpAbort(&emcmotDebug->coord_tp);
+	SET_MOTION_ERROR_FLAG(1);
+	return -1;
+    }
+    if(emcmotStatus->atspeed_next_feed) {
+	issue_atspeed = 1;
+	emcmotStatus->atspeed_next_feed = 0;
+    }
+    /* append it to the emcmotDebug->coord_tp */
+    tpSetId(&emcmotDebug->coord_tp, seg->id);
+    int res_addcircle = tpAddCircle(&emcmotDebug->coord_tp, seg->pos,
+			    seg->center, seg->normal,
+			    seg->turn, seg->motion_type,
+			    seg->vel, seg->ini_maxvel,
+			    seg->acc, emcmotStatus->enables_new, issue_atspeed);
+    if (res_addcircle < 0) {
+	reportError(_("can't add circular move at line %d, error code %d"),
+		seg->id, res_addcircle);
+	emcmotStatus->commandStatus = EMCMOT_COMMAND_BAD_EXEC;
+	tpAbort(&emcmotDebug->coord_tp);
+	SET_MOTION_ERROR_FLAG(1);
+	return -1;
+    } else if (res_addcircle != 0) {
+	//FIXME! This is a band-aid for a single issue, but there may be
+	//other consequences of non-fatal errors from AddXXX functions. We
+	//either need to fix the root cause (subtle position error after
+	//homing), or have a full restore here.
+	if (issue_atspeed) {
+	    emcmotStatus->atspeed_next_feed = 1;
+	}
+    } else {
+	SET_MOTION_ERROR_FLAG(0);
+	/* set flag that indicates all joints need rehoming, if any
+	   joint is moved in joint mode, for machines with no forward
+	   kins */
+	rehomeAll = 1;
+    }
+    return 0;
+}
+
+/* check_comp_grid() checks the description user space wrote into the
+   compensation grid segment, so the servo thread can use it without
+   range checks.  Returns 1 if it is good. */
+static int check_comp_grid(const emcmot_comp_grid_t *grid)
+{
+    long stride;
+    int d, n;
+
+    if (grid == 0 ||
+	grid->dims < 1 || grid->dims > EMCMOT_COMP_GRID_MAX_DIMS ||
+	grid->outputs < 1 || grid->outputs > EMCMOT_MAX_JOINTS) {
+	return 0;
+    }
+    for (n = 0; n < grid->outputs; n++) {
+	if (grid->output_joint[n] < 0 ||
+	    grid->output_joint[n] >= emcmotConfig->numJoints) {
+	    return 0;
+	}
+    }
+    stride = (long) grid->outputs * EMCMOT_COMP_GRID_TERMS(grid->dims);
+    for (d = 0; d < grid->dims; d++) {
+	const emcmot_comp_grid_dim_t *dim = &grid->dim[d];
+
+	if (dim->joint < 0 || dim->joint >= emcmotConfig->numJoints ||
+	    dim->cells < 1 || !(dim->scale > 0.0) ||
+	    dim->stride != stride ||
+	    stride > grid->capacity / dim->cells) {
+	    return 0;
+	}
+	stride *= dim->cells;
+    }
+    return grid->size == stride && stride <= grid->capacity;
+}
+
 /*
   emcmotCommandHandler() is called each main cycle to read the
   shared memory buffer
@@ -411,7 +581,7 @@ void emcmotCommandHandler(void *arg, long period)
     emcmot_axis_t *axis;
     double tmp1;
     emcmot_comp_entry_t *comp_entry;
-    char issue_atspeed = 0;
+    emcmot_segment_t segment;
     int abort = 0;
     char* emsg;
 
@@ -1033,113 +1203,39 @@ void emcmotCommandHandler(void *arg, long period)
 	    /* emcmotDebug->coord_tp up a linear move */
 	    /* requires motion enabled, coordinated mode, not on limits */
 	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_LINE");
-	    if (!GET_MOTION_COORD_FLAG() || !GET_MOTION_ENABLE_FLAG()) {
-		reportError(_("need to be enabled, in coord mode for linear move"));
-		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_COMMAND;
-		SET_MOTION_ERROR_FLAG(1);
-		break;
-	    } else if (!inRange(emcmotCommand->pos, emcmotCommand->id, "Linear")) {
-		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
-		tpAbort(&emcmotDebug->coord_tp);
-		SET_MOTION_ERROR_FLAG(1);
-		break;
-	    } else if (!limits_ok()) {
-		reportError(_("can't do linear move with limits exceeded"));
-		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
-		tpAbort(&emcmotDebug->coord_tp);
-		SET_MOTION_ERROR_FLAG(1);
-		break;
-	    }
-            if(emcmotStatus->atspeed_next_feed && is_feed_type(emcmotCommand->motion_type) ) {
-                issue_atspeed = 1;
-                emcmotStatus->atspeed_next_feed = 0;
-            }
-            if(!is_feed_type(emcmotCommand->motion_type) && emcmotStatus->spindle.css_factor) {
-                emcmotStatus->atspeed_next_feed = 1;
-            }
-	    /* append it to the emcmotDebug->coord_tp */
-	    tpSetId(&emcmotDebug->coord_tp, emcmotCommand->id);
-        int res_addline = tpAddLine(&emcmotDebug->coord_tp, emcmotCommand->pos, emcmotCommand->motion_type, 
-                                emcmotCommand->vel, emcmotCommand->ini_maxvel, 
-                                emcmotCommand->acc, emcmotStatus->enables_new, issue_atspeed,
-                                emcmotCommand->turn);
-        //KLUDGE ignore zero length line
-        if (res_addline < 0) {
-            reportError(_("can't add linear move at line %d, error code %d"),
-                    emcmotCommand->id, res_addline);
-            emcmotStatus->commandStatus = EMCMOT_COMMAND_BAD_EXEC;
-            tpAbort(&emcmotDebug->coord_tp);
-            SET_MOTION_ERROR_FLAG(1);
-            break;
-        } else if (res_addline != 0) {
-            //TODO make this hand-shake more explicit
-            //KLUDGE Non fatal error, need to restore state so that the next
-            //line properly handles at_speed
-            if (issue_atspeed) {
-                emcmotStatus->atspeed_next_feed = 1;
-            }
-        } else {
-		SET_MOTION_ERROR_FLAG(0);
-		/* set flag that indicates all joints need rehoming, if any
-		   joint is moved in joint mode, for machines with no forward
-		   kins */
-		rehomeAll = 1;
-	    }
+	    segment_from_command(&segment);
+	    set_line(&segment);
 	    break;
 
 	case EMCMOT_SET_CIRCLE:
 	    /* emcmotDebug->coord_tp up a circular move */
 	    /* requires coordinated mode, enable on, not on limits */
 	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_CIRCLE");
-	    if (!GET_MOTION_COORD_FLAG() || !GET_MOTION_ENABLE_FLAG()) {
-		reportError(_("need to be enabled, in coord mode for circular move"));
-		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_COMMAND;
-		SET_MOTION_ERROR_FLAG(1);
-		break;
-	    } else if (!inRange(emcmotCommand->pos, emcmotCommand->id, "Circular")) {
-		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
-		tpAbort(&emcmotDebug->coord_tp);
-		SET_MOTION_ERROR_FLAG(1);
-		break;
-	    } else if (!limits_ok()) {
-		reportError(_("can't do circular move with limits exceeded"));
+	    segment_from_command(&segment);
+	    set_circle(&segment);
+	    break;
+
+	case EMCMOT_SET_SEGMENTS:
+	    /* queue a batch of lines and circles, as if they had come in
+	       one command each; stop at the first one that fails */
+	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_SEGMENTS");
+	    if (emcmotCommand->nsegments < 0 ||
+		emcmotCommand->nsegments > EMCMOT_MAX_SEGMENTS) {
 		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
-		tpAbort(&emcmotDebug->coord_tp);
-		SET_MOTION_ERROR_FLAG(1);
 		break;
 	    }
-            if(emcmotStatus->atspeed_next_feed) {
-                issue_atspeed = 1;
-                emcmotStatus->atspeed_next_feed = 0;
-            }
-	    /* append it to the emcmotDebug->coord_tp */
-	    tpSetId(&emcmotDebug->coord_tp, emcmotCommand->id);
-	    int res_addcircle = tpAddCircle(&emcmotDebug->coord_tp, emcmotCommand->pos,
-                            emcmotCommand->center, emcmotCommand->normal,
-                            emcmotCommand->turn, emcmotCommand->motion_type,
-                            emcmotCommand->vel, emcmotCommand->ini_maxvel,
-                            emcmotCommand->acc, emcmotStatus->enables_new, issue_atspeed);
-        if (res_addcircle < 0) {
-            reportError(_("can't add circular move at line %d, error code %d"),
-                    emcmotCommand->id, res_addcircle);
-		emcmotStatus->commandStatus = EMCMOT_COMMAND_BAD_EXEC;
-		tpAbort(&emcmotDebug->coord_tp);
-		SET_MOTION_ERROR_FLAG(1);
-		break;
-        } else if (res_addcircle != 0) {
-            //FIXME! This is a band-aid for a single issue, but there may be
-            //other consequences of non-fatal errors from AddXXX functions. We
-            //either need to fix the root cause (subtle position error after
-            //homing), or have a full restore here.
-            if (issue_atspeed) {
-                emcmotStatus->atspeed_next_feed = 1;
-            }
-        } else {
-		SET_MOTION_ERROR_FLAG(0);
-		/* set flag that indicates all joints need rehoming, if any
-		   joint is moved in joint mode, for machines with no forward
-		   kins */
-		rehomeAll = 1;
+	    for (n = 0; n < emcmotCommand->nsegments; n++) {
+		emcmot_segment_t const *seg = &emcmotCommand->segments[n];
+		if (seg->command == EMCMOT_SET_LINE) {
+		    rtapi_print_msg(RTAPI_MSG_DBG, " LINE");
+		    if (set_line(seg) != 0) break;
+		} else if (seg->command == EMCMOT_SET_CIRCLE) {
+		    rtapi_print_msg(RTAPI_MSG_DBG, " CIRCLE");
+		    if (set_circle(seg) != 0) break;
+		} else {
+		    emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
+		    break;
+		}
 	    }
 	    break;
 
@@ -1773,6 +1869,32 @@ void emcmotCommandHandler(void *arg, long period)
 	    joint->comp.entries++;
 	    break;
 
+	case EMCMOT_SET_COMP_GRID:
+	    /* switching the grid on or off moves the joints by its
+	       correction, so only with the machine off */
+	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_COMP_GRID %d", emcmotCommand->comp_grid);
+	    if (GET_MOTION_ENABLE_FLAG()) {
+		reportError(_("can't change the compensation grid with the machine on"));
+		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_COMMAND;
+		break;
+	    }
+	    emcmotCompGridActive = 0;
+	    for (n = 0; n < EMCMOT_MAX_JOINTS; n++) {
+		joints[n].grid_corr = 0.0;
+		joints[n].grid_filt = 0.0;
+		joints[n].grid_vel = 0.0;
+	    }
+	    if (!emcmotCommand->comp_grid) {
+		break;
+	    }
+	    if (!check_comp_grid(emcmotCompGrid)) {
+		reportError(_("invalid compensation grid"));
+		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
+		break;
+	    }
+	    emcmotCompGridActive = 1;
+	    break;
+
         case EMCMOT_SET_OFFSET:
             emcmotStatus->tool_offset = emcmotCommand->tool_offset;
             break;
@@ -0,0 +1,139 @@
+/********************************************************************
+* Description: compgrid.cc
+*   Reads a compensation grid file (format in compgrid.h) and turns
+*   the corrections at its points into each cell's interpolation
+*   coefficients, so the servo thread only evaluates them.
+*
+* Author: LinuxCNC developers
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 LinuxCNC developers
+********************************************************************/
+
+#include <stdio.h>
+#include <string.h>		/* memcmp() */
+#include <stdint.h>		/* int32_t */
+#include <vector>
+#include "compgrid.h"		/* these decls */
+
+static bool read_grid(FILE *fp, void *p, size_t size, size_t n = 1)
+{
+    return fread(p, size, n, fp) == n;
+}
+
+int emcmotCompGridRead(const char *file, emcmot_comp_grid_t *grid)
+{
+    char magic[8];
+    int32_t dims, outputs, joint, count[EMCMOT_COMP_GRID_MAX_DIMS];
+    double origin, spacing;
+    long capacity = grid->capacity, nodes = 1, stride, cell, cells;
+    int d, out, s, t, terms;
+    FILE *fp;
+
+    if (NULL == (fp = fopen(file, "rb"))) {
+	fprintf(stderr, "can't open compensation grid file %s\n", file);
+	return -1;
+    }
+    memset(grid, 0, sizeof(*grid));
+    grid->capacity = capacity;
+    if (!read_grid(fp, magic, sizeof(magic)) ||
+	0 != memcmp(magic, EMCMOT_COMP_GRID_MAGIC, sizeof(magic)) ||
+	!read_grid(fp, &dims, sizeof(dims)) ||
+	!read_grid(fp, &outputs, sizeof(outputs)) ||
+	dims < 1 || dims > EMCMOT_COMP_GRID_MAX_DIMS ||
+	outputs < 1 || outputs > EMCMOT_MAX_JOINTS) {
+	fprintf(stderr, "%s: not a compensation grid file\n", file);
+	fclose(fp);
+	return -1;
+    }
+    grid->dims = dims;
+    grid->outputs = outputs;
+    terms = EMCMOT_COMP_GRID_TERMS(dims);
+    stride = (long) outputs * terms;
+    for (d = 0; d < dims; d++) {
+	if (!read_grid(fp, &joint, sizeof(joint)) ||
+	    !read_grid(fp, &count[d], sizeof(count[d])) ||
+	    !read_grid(fp, &origin, sizeof(origin)) ||
+	    !read_grid(fp, &spacing, sizeof(spacing)) ||
+	    count[d] < 2 || !(spacing > 0.0)) {
+	    fprintf(stderr, "%s: bad grid coordinate %d\n", file, d);
+	    fclose(fp);
+	    return -1;
+	}
+	grid->dim[d].joint = joint;
+	grid->dim[d].cells = count[d] - 1;
+	grid->dim[d].origin = origin;
+	grid->dim[d].scale = 1.0 / spacing;
+	grid->dim[d].stride = stride;
+	if (stride > capacity / grid->dim[d].cells) {
+	    fprintf(stderr, "%s: grid too big, motion has room for %ld "
+		"coefficients\n", file, capacity);
+	    fclose(fp);
+	    return -1;
+	}
+	stride *= grid->dim[d].cells;
+	nodes *= count[d];
+    }
+    grid->size = stride;
+    for (out = 0; out < outputs; out++) {
+	if (!read_grid(fp, &joint, sizeof(joint))) {
+	    fprintf(stderr, "%s: truncated\n", file);
+	    fclose(fp);
+	    return -1;
+	}
+	grid->output_joint[out] = joint;
+    }
+    std::vector<double> value(nodes * outputs);
+    if (!read_grid(fp, &value[0], sizeof(double), value.size())) {
+	fprintf(stderr, "%s: truncated\n", file);
+	fclose(fp);
+	return -1;
+    }
+    fclose(fp);
+
+    /* each cell's coefficient for the product of the coordinates in s
+       is the alternating sum of the values at the corners along them:
+       sum over corners t in s of (-1)^(|s|-|t|) value(t) */
+    float *coef = EMCMOT_COMP_GRID_COEF(grid);
+    cells = 1;
+    for (d = 0; d < dims; d++) {
+	cells *= grid->dim[d].cells;
+    }
+    for (cell = 0; cell < cells; cell++) {
+	long corner[1 << EMCMOT_COMP_GRID_MAX_DIMS];
+	long rest = cell, node = 0, place = 1;
+
+	/* the node at the cell's low corner, and the offsets of the
+	   others */
+	for (d = 0; d < dims; d++) {
+	    node += (rest % grid->dim[d].cells) * place;
+	    rest /= grid->dim[d].cells;
+	    place *= count[d];
+	}
+	for (t = 0; t < terms; t++) {
+	    corner[t] = node;
+	    for (d = 0, place = 1; d < dims; place *= count[d], d++) {
+		if (t & (1 << d)) {
+		    corner[t] += place;
+		}
+	    }
+	}
+	for (out = 0; out < outputs; out++) {
+	    for (s = 0; s < terms; s++) {
+		double c = 0.0;
+
+		for (t = s; ; t = (t - 1) & s) {
+		    int odd = __builtin_popcount(s ^ t) & 1;
+
+		    c += (odd ? -1 : 1) * value[corner[t] * outputs + out];
+		    if (t == 0) {
+			break;
+		    }
+		}
+		*coef++ = c;
+	    }
+	}
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+/********************************************************************
+* Description: compgrid.h
+*   Compensation grid: a correction for one or more joints, given on
+*   a uniformly spaced 1, 2 or 3 dimensional grid over the positions
+*   of up to three joints, e.g. a volumetric XYZ error map.
+*
+*   The grid lives in its own shared memory segment, created by the
+*   motion module (key COMP_GRID_SHMEM_KEY(key), size comp_grid_size
+*   bytes, both set at insmod time).  User space fills it while the
+*   grid is off and then switches it on with EMCMOT_SET_COMP_GRID,
+*   see usrmotLoadCompGrid().  It holds the grid description followed
+*   by the interpolation coefficients of every cell, so the servo
+*   thread finds the cell by arithmetic and evaluates one polynomial
+*   per corrected joint, at the same cost whatever the grid's size.
+*
+*   Grid file format, read by usrmotLoadCompGrid(), in the host's
+*   byte order:
+*
+*	char    magic[8]		"EMCGRID\0"
+*	int32   dims			1, 2 or 3
+*	int32   outputs			corrected joints, 1..EMCMOT_MAX_JOINTS
+*	dims times:
+*	    int32   joint		joint whose position is this coordinate
+*	    int32   count		grid points, at least 2
+*	    double  origin		position of the first point
+*	    double  spacing		distance between points, positive
+*	outputs times:
+*	    int32   joint		joint the correction is added to
+*	count[0] * ... * count[dims-1] times, coordinate 0 varying fastest:
+*	    double  correction[outputs]
+*
+*   Positions outside the grid get the correction at its edge.
+*
+*   emcmotCompGridRead() reads a grid file and turns it into the
+*   coefficients, emcmot_comp_grid_eval() evaluates them; the servo
+*   thread and the test in tests/comp-grid both use these.
+*
+* Author: LinuxCNC developers
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 LinuxCNC developers
+********************************************************************/
+#ifndef COMPGRID_H
+#define COMPGRID_H
+
+#include "emcmotcfg.h"		/* EMCMOT_MAX_JOINTS */
+
+#define EMCMOT_COMP_GRID_MAX_DIMS 3
+#define EMCMOT_COMP_GRID_MAGIC "EMCGRID"
+
+/* coefficients per cell and output: cell-local multilinear polynomial
+   sum of coef[s] * (product of u[d] for each bit d set in s), where
+   u[d] is the position in the cell along coordinate d, 0..1 */
+#define EMCMOT_COMP_GRID_TERMS(dims) (1 << (dims))
+
+typedef struct {
+    int joint;			/* joint whose position is the coordinate */
+    int cells;			/* grid points - 1 */
+    double origin;		/* position of the first point */
+    double scale;		/* 1 / spacing */
+    long stride;		/* floats from a cell to the next along this
+				   coordinate */
+} emcmot_comp_grid_dim_t;
+
+typedef struct {
+    long capacity;		/* floats of coefficients the segment holds,
+				   set by motion */
+    int dims;			/* 0 for no grid */
+    int outputs;
+    int output_joint[EMCMOT_MAX_JOINTS];
+    emcmot_comp_grid_dim_t dim[EMCMOT_COMP_GRID_MAX_DIMS];
+    long size;			/* floats of coefficients used */
+} emcmot_comp_grid_t;
+
+/* the coefficients follow the description */
+#define EMCMOT_COMP_GRID_COEF(grid) ((float *)((grid) + 1))
+
+/* the corrections corr[0..outputs-1] at the positions pos[0..dims-1]
+   of the grid's joints */
+static inline void emcmot_comp_grid_eval(const emcmot_comp_grid_t *grid,
+					 const double *pos, double *corr)
+{
+    const float *coef;
+    double term[EMCMOT_COMP_GRID_TERMS(EMCMOT_COMP_GRID_MAX_DIMS)];
+    double x;
+    long base = 0;
+    int d, i, n, s, terms, out;
+
+    /* term[s] is the product of the positions in the cell along the
+       coordinates whose bits are set in s */
+    term[0] = 1.0;
+    for (d = 0; d < grid->dims; d++) {
+	const emcmot_comp_grid_dim_t *dim = &grid->dim[d];
+
+	x = (pos[d] - dim->origin) * dim->scale;
+	/* outside the grid, use the correction at its edge */
+	if (x <= 0.0) {
+	    i = 0;
+	    x = 0.0;
+	} else if (x >= dim->cells) {
+	    i = dim->cells - 1;
+	    x = 1.0;
+	} else {
+	    i = (int) x;
+	    x -= i;
+	}
+	base += i * dim->stride;
+	n = 1 << d;
+	for (s = 0; s < n; s++) {
+	    term[n + s] = term[s] * x;
+	}
+    }
+    terms = EMCMOT_COMP_GRID_TERMS(grid->dims);
+    coef = EMCMOT_COMP_GRID_COEF(grid) + base;
+    for (out = 0; out < grid->outputs; out++) {
+	corr[out] = 0.0;
+	for (s = 0; s < terms; s++) {
+	    corr[out] += coef[s] * term[s];
+	}
+	coef += terms;
+    }
+}
+
+#ifdef __cplusplus
+/* Reads the grid file into grid, whose capacity must be set and which
+   must have room for that many coefficients.  Returns 0, or -1 after
+   printing why on stderr. */
+extern int emcmotCompGridRead(const char *file, emcmot_comp_grid_t *grid);
+#endif
+
+#endif				/* COMPGRID_H */
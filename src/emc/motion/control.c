@@ -51,6 +51,9 @@ static unsigned long last_period = 0;
 /* servo cycle time */
 static double servo_period;
 
+/* clocks spent in each stage of this cycle, see emcmot_stage_t */
+static unsigned long stage_clocks[EMCMOT_STAGES];
+
 /***********************************************************************
 *                      LOCAL FUNCTION PROTOTYPES                       *
 ************************************************************************/
@@ -150,6 +153,13 @@ static void get_pos_cmds(long period);
 */
 static void compute_screw_comp(void);
 
+/* 'compute_grid_comp()' looks up the correction of each joint corrected
+   by the compensation grid (see compgrid.h) in the cell holding the
+   commanded positions, and puts it in grid_corr, or 0 until the joints
+   the grid is over are homed.  grid_filt is the ramped version that is
+   applied, as for backlash: the correction steps when they are homed. */
+static void compute_grid_comp(void);
+
 /* 'output_to_hal()' writes the handles the final stages of the
    control function.  It applies screw comp and writes the
    final motor position to the HAL (which routes it to the PID
@@ -165,6 +175,23 @@ static void output_to_hal(void);
 */
 static void update_status(void);
 
+/* 'stage_start()' returns the current clock count, where a stage
+   starts.  'stage_done()' adds the clocks since 'start' to this
+   cycle's time of 'stage', and returns the current clock count, which
+   is where the next stage starts.  Stages run more than once per
+   cycle, like the trajectory planner, add up.  Both return 0 without
+   reading the clock unless motmod was loaded with stage_timing=1.
+*/
+static long long int stage_start(void);
+static long long int stage_done(emcmot_stage_t stage, long long int start);
+
+/* 'update_stage_times()' copies this cycle's time of each stage, its
+   maximum and the histogram of times to the HAL and to emcmotStatus,
+   clearing the latter two first if motion.servo.stage-reset is set.
+   It does nothing without stage_timing=1.
+*/
+static void update_stage_times(void);
+
 /***********************************************************************
 *                        PUBLIC FUNCTION CODE                          *
 ************************************************************************/
@@ -182,6 +209,7 @@ static void update_status(void);
 void emcmotController(void *arg, long period)
 {
     static long long int last = 0;
+    long long int t;
 
     long long int now = rtapi_get_clocks();
     long int this_run = (long int)(now - last);
@@ -207,19 +235,34 @@ void emcmotController(void *arg, long period)
     emcmotStatus->head++;
     /* here begins the core of the controller */
 
+    t = stage_start();
     process_inputs();
+    t = stage_done(EMCMOT_STAGE_INPUTS, t);
     do_forward_kins();
+    t = stage_done(EMCMOT_STAGE_FORWARD_KINS, t);
     process_probe_inputs();
+    t = stage_done(EMCMOT_STAGE_PROBE, t);
     check_for_faults();
+    t = stage_done(EMCMOT_STAGE_FAULTS, t);
     set_operating_mode();
+    t = stage_done(EMCMOT_STAGE_MODE, t);
     handle_jjogwheels();
     handle_ajogwheels();
+    t = stage_done(EMCMOT_STAGE_JOG, t);
     do_homing_sequence();
     do_homing();
+    t = stage_done(EMCMOT_STAGE_HOMING, t);
     get_pos_cmds(period);
+    t = stage_done(EMCMOT_STAGE_POS_CMDS, t);
     compute_screw_comp();
+    t = stage_done(EMCMOT_STAGE_SCREW_COMP, t);
+    compute_grid_comp();
+    t = stage_done(EMCMOT_STAGE_GRID_COMP, t);
     output_to_hal();
+    t = stage_done(EMCMOT_STAGE_OUTPUT, t);
     update_status();
+    stage_done(EMCMOT_STAGE_STATUS, t);
+    update_stage_times();
     /* here ends the core of the controller */
     emcmotStatus->heartbeat++;
     /* set tail to head, to indicate work complete */
@@ -323,9 +366,9 @@ static void process_inputs(void)
 	       to match the commanded value instead. */
 	    joint->pos_fb = joint->pos_cmd;
 	} else {
-	    /* normal case: subtract backlash comp and motor offset */
+	    /* normal case: subtract backlash comp, grid comp and motor offset */
 	    joint->pos_fb = joint->motor_pos_fb -
-		(joint->backlash_filt + joint->motor_offset);
+		(joint->backlash_filt + joint->grid_filt + joint->motor_offset);
 	}
 	/* calculate following error */
 	joint->ferror = joint->pos_cmd - joint->pos_fb;
@@ -1083,6 +1126,7 @@ static void get_pos_cmds(long period)
     emcmot_axis_t *axis;
     double positions[EMCMOT_MAX_JOINTS];
     double vel_lim;
+    long long int t;
 
     /* used in teleop mode to compute the max accell requested */
     int onlimit = 0;
@@ -1238,13 +1282,16 @@ static void get_pos_cmds(long period)
 	while (cubicNeedNextPoint(&(joints[0].cubic))) {
 	    /* they're empty, pull next point(s) off Cartesian planner */
 	    /* run coordinated trajectory planning cycle */
+	    t = stage_start();
 	    tpRunCycle(&emcmotDebug->coord_tp, period);
 	    /* gt new commanded traj pos */
 	    tpGetPos(&emcmotDebug->coord_tp, &emcmotStatus->carte_pos_cmd);
+	    t = stage_done(EMCMOT_STAGE_TP, t);
 
 	    /* OUTPUT KINEMATICS - convert to joints in local array */
 	    result = kinematicsInverse(&emcmotStatus->carte_pos_cmd, positions,
 		&iflags, &fflags);
+	    stage_done(EMCMOT_STAGE_INVERSE_KINS, t);
 	    if(result == 0)
 	    {
 		/* copy to joint structures and spline them up */
@@ -1322,7 +1369,9 @@ static void get_pos_cmds(long period)
 	    to compute the next positions of the joints */
 
 	/* OUTPUT KINEMATICS - convert to joints in local array */
+	t = stage_start();
 	result = kinematicsInverse(&emcmotStatus->carte_pos_cmd, positions, &iflags, &fflags);
+	stage_done(EMCMOT_STAGE_INVERSE_KINS, t);
 	/* copy to joint structures and spline them up */
 	if(result == 0)
 	{
@@ -1537,13 +1586,154 @@ Their exact contents and meaning are as follows:
 
 */
 
+/* 'slew_comp()' moves filt towards the correction corr, at most at
+ * v_max and a_max, with vel its velocity.
+ *
+ * 07/09/2005 - S-curve implementation by Bas Laarhoven
+ *
+ * Implementation:
+ *   Generate a ramped velocity profile for backlash or screw error comp.
+ *   The velocity is ramped up to the maximum speed setting (if possible),
+ *   using the maximum acceleration setting.
+ *   At the end, the speed is ramped dowm using the same acceleration.
+ *   The algorithm keeps looking ahead. Depending on the distance to go,
+ *   the speed is increased, kept constant or decreased.
+ *   
+ * Limitations:
+ *   Since the compensation adds up to the normal movement, total
+ *   accelleration and total velocity may exceed maximum settings!
+ *   Currently this is limited to 150% by implementation.
+ *   To fix this, the calculations in get_pos_cmd should include
+ *   information from the backlash corection. This makes things
+ *   rather complicated and it might be better to implement the
+ *   backlash compensation at another place to prevent this kind
+ *   of interaction.
+ *   More testing under different circumstances will show if this
+ *   needs a more complicate solution.
+ *   For now this implementation seems to generate smoother
+ *   movements and less following errors than the original code.
+ */
+static void slew_comp(double corr, double *filt, double *vel,
+		      double v_max, double a_max)
+{
+    double v, s_to_go, ds_stop, ds_vel, ds_acc, dv_acc;
+
+    v = *vel;
+    if (corr >= *filt) {
+	s_to_go = corr - *filt; /* abs val */
+	if (s_to_go > 0) {
+	    // off target, need to move
+	    ds_vel  = v * servo_period;           /* abs val */
+	    dv_acc  = a_max * servo_period;       /* abs val */
+	    ds_stop = 0.5 * (v + dv_acc) *
+			    (v + dv_acc) / a_max; /* abs val */
+	    if (s_to_go <= ds_stop + ds_vel) {
+		// ramp down
+		if (v > dv_acc) {
+		    // decellerate one period
+		    ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
+		    *vel  -= dv_acc;
+		    *filt += ds_vel - ds_acc;
+		} else {
+		    // last step to target
+		    *vel  = 0.0;
+		    *filt = corr;
+		}
+	    } else {
+		if (v + dv_acc > v_max) {
+		    dv_acc = v_max - v;                /* abs val */
+		}
+		ds_acc  = 0.5 * dv_acc * servo_period; /* abs val */
+		ds_stop = 0.5 * (v + dv_acc) *
+				(v + dv_acc) / a_max;  /* abs val */
+		if (s_to_go > ds_stop + ds_vel + ds_acc) {
+		    // ramp up
+		   *vel  += dv_acc;
+		   *filt += ds_vel + ds_acc;
+		} else {
+		   // constant velocity
+		   *filt += ds_vel;
+		}
+	    }
+	} else if (s_to_go < 0) {
+	    // safely handle overshoot (should not occur)
+	   *vel = 0.0;
+	   *filt = corr;
+	}
+    } else {  /* corr < 0.0 */
+	s_to_go = *filt - corr; /* abs val */
+	if (s_to_go > 0) {
+	    // off target, need to move
+	    ds_vel  = -v * servo_period;          /* abs val */
+	    dv_acc  = a_max * servo_period;       /* abs val */
+	    ds_stop = 0.5 * (v - dv_acc) *
+			    (v - dv_acc) / a_max; /* abs val */
+	    if (s_to_go <= ds_stop + ds_vel) {
+		// ramp down
+		if (-v > dv_acc) {
+		    // decellerate one period
+		    ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
+		    *vel  += dv_acc;   /* decrease */
+		    *filt -= ds_vel - ds_acc;
+		} else {
+		    // last step to target
+		    *vel = 0.0;
+		    *filt = corr;
+		}
+	    } else {
+		if (-v + dv_acc > v_max) {
+		    dv_acc = v_max + v;               /* abs val */
+		}
+		ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
+		ds_stop = 0.5 * (v - dv_acc) *
+				(v - dv_acc) / a_max; /* abs val */
+		if (s_to_go > ds_stop + ds_vel + ds_acc) {
+		    // ramp up
+		    *vel  -= dv_acc;   /* increase */
+		    *filt -= ds_vel + ds_acc;
+		} else {
+		    // constant velocity
+		    *filt -= ds_vel;
+		}
+	    }
+	} else if (s_to_go < 0) {
+	    // safely handle overshoot (should not occur)
+	    *vel = 0.0;
+	    *filt = corr;
+	}
+    }
+}
+
+/* 'comp_share()' is the fraction of a joint's velocity and acceleration
+   limits that backlash or screw comp and the compensation grid may each
+   use to ramp their correction.  Together they get 50%, so with the
+   planner's 100% the joint stays within 150%: a joint corrected by both
+   splits it between them. */
+static double comp_share(int joint_num)
+{
+    const emcmot_comp_grid_t *grid = emcmotCompGrid;
+    emcmot_joint_t *joint = &joints[joint_num];
+    int out;
+
+    if (!emcmotCompGridActive ||
+	(joint->backlash == 0.0 && joint->comp.entries == 0)) {
+	return 0.5;
+    }
+    for (out = 0; out < grid->outputs; out++) {
+	if (grid->output_joint[out] == joint_num) {
+	    return 0.25;
+	}
+    }
+    return 0.5;
+}
+
 static void compute_screw_comp(void)
 {
     int joint_num;
     emcmot_joint_t *joint;
     emcmot_comp_t *comp;
     double dpos;
-    double a_max, v_max, v, s_to_go, ds_stop, ds_vel, ds_acc, dv_acc;
+    double a_max, v_max;
 
 
     /* compute the correction */
@@ -1598,129 +1788,56 @@ static void compute_screw_comp(void)
 	}
 	/* at this point, the correction has been computed, but
 	   the value may make abrupt jumps on direction reversal */
-    /*
-     * 07/09/2005 - S-curve implementation by Bas Laarhoven
-     *
-     * Implementation:
-     *   Generate a ramped velocity profile for backlash or screw error comp.
-     *   The velocity is ramped up to the maximum speed setting (if possible),
-     *   using the maximum acceleration setting.
-     *   At the end, the speed is ramped dowm using the same acceleration.
-     *   The algorithm keeps looking ahead. Depending on the distance to go,
-     *   the speed is increased, kept constant or decreased.
-     *   
-     * Limitations:
-     *   Since the compensation adds up to the normal movement, total
-     *   accelleration and total velocity may exceed maximum settings!
-     *   Currently this is limited to 150% by implementation.
-     *   To fix this, the calculations in get_pos_cmd should include
-     *   information from the backlash corection. This makes things
-     *   rather complicated and it might be better to implement the
-     *   backlash compensation at another place to prevent this kind
-     *   of interaction.
-     *   More testing under different circumstances will show if this
-     *   needs a more complicate solution.
-     *   For now this implementation seems to generate smoother
-     *   movements and less following errors than the original code.
-     */
-
 	/* Limit maximum accelleration and velocity 'overshoot'
 	 * to 150% of the maximum settings.
 	 * The TP and backlash shouldn't use more than 100%
 	 * (together) but this requires some interaction that
 	 * isn't implemented yet.
 	 */ 
-        v_max = 0.5 * joint->vel_limit * emcmotStatus->net_feed_scale;
-        a_max = 0.5 * joint->acc_limit;
-        v = joint->backlash_vel;
-        if (joint->backlash_corr >= joint->backlash_filt) {
-            s_to_go = joint->backlash_corr - joint->backlash_filt; /* abs val */
-            if (s_to_go > 0) {
-                // off target, need to move
-                ds_vel  = v * servo_period;           /* abs val */
-                dv_acc  = a_max * servo_period;       /* abs val */
-                ds_stop = 0.5 * (v + dv_acc) *
-		                (v + dv_acc) / a_max; /* abs val */
-                if (s_to_go <= ds_stop + ds_vel) {
-                    // ramp down
-                    if (v > dv_acc) {
-                        // decellerate one period
-                        ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
-                        joint->backlash_vel  -= dv_acc;
-                        joint->backlash_filt += ds_vel - ds_acc;
-                    } else {
-                        // last step to target
-                        joint->backlash_vel  = 0.0;
-                        joint->backlash_filt = joint->backlash_corr;
-                    }
-                } else {
-                    if (v + dv_acc > v_max) {
-                        dv_acc = v_max - v;                /* abs val */
-                    }
-                    ds_acc  = 0.5 * dv_acc * servo_period; /* abs val */
-                    ds_stop = 0.5 * (v + dv_acc) *
-                                    (v + dv_acc) / a_max;  /* abs val */
-                    if (s_to_go > ds_stop + ds_vel + ds_acc) {
-                        // ramp up
-                       joint->backlash_vel  += dv_acc;
-                       joint->backlash_filt += ds_vel + ds_acc;
-                    } else {
-                       // constant velocity
-                       joint->backlash_filt += ds_vel;
-                    }
-                }
-            } else if (s_to_go < 0) {
-                // safely handle overshoot (should not occur)
-               joint->backlash_vel = 0.0;
-               joint->backlash_filt = joint->backlash_corr;
-            }
-        } else {  /* joint->backlash_corr < 0.0 */
-            s_to_go = joint->backlash_filt - joint->backlash_corr; /* abs val */
-            if (s_to_go > 0) {
-                // off target, need to move
-                ds_vel  = -v * servo_period;          /* abs val */
-                dv_acc  = a_max * servo_period;       /* abs val */
-                ds_stop = 0.5 * (v - dv_acc) *
-			        (v - dv_acc) / a_max; /* abs val */
-                if (s_to_go <= ds_stop + ds_vel) {
-                    // ramp down
-                    if (-v > dv_acc) {
-                        // decellerate one period
-                        ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
-                        joint->backlash_vel  += dv_acc;   /* decrease */
-                        joint->backlash_filt -= ds_vel - ds_acc;
-                    } else {
-                        // last step to target
-                        joint->backlash_vel = 0.0;
-                        joint->backlash_filt = joint->backlash_corr;
-                    }
-                } else {
-                    if (-v + dv_acc > v_max) {
-                        dv_acc = v_max + v;               /* abs val */
-                    }
-                    ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
-                    ds_stop = 0.5 * (v - dv_acc) *
-                                    (v - dv_acc) / a_max; /* abs val */
-                    if (s_to_go > ds_stop + ds_vel + ds_acc) {
-                        // ramp up
-                        joint->backlash_vel  -= dv_acc;   /* increase */
-                        joint->backlash_filt -= ds_vel + ds_acc;
-                    } else {
-                        // constant velocity
-                        joint->backlash_filt -= ds_vel;
-                    }
-                }
-            } else if (s_to_go < 0) {
-                // safely handle overshoot (should not occur)
-                joint->backlash_vel = 0.0;
-                joint->backlash_filt = joint->backlash_corr;
-            }
-        }
+        v_max = comp_share(joint_num) * joint->vel_limit *
+		emcmotStatus->net_feed_scale;
+        a_max = comp_share(joint_num) * joint->acc_limit;
+	slew_comp(joint->backlash_corr, &joint->backlash_filt,
+		  &joint->backlash_vel, v_max, a_max);
         /* backlash (and motor offset) will be applied to output later */
         /* end of joint loop */
     }
 }
 
+static void compute_grid_comp(void)
+{
+    const emcmot_comp_grid_t *grid = emcmotCompGrid;
+    double pos[EMCMOT_COMP_GRID_MAX_DIMS], corr[EMCMOT_MAX_JOINTS];
+    double a_max, v_max;
+    emcmot_joint_t *joint;
+    int d, out, homed = 1;
+
+    if (!emcmotCompGridActive) {
+	return;
+    }
+    /* the grid is over machine positions, which the joints only have
+       once homed; until then ramp the correction out */
+    for (d = 0; d < grid->dims; d++) {
+	joint = &joints[grid->dim[d].joint];
+	pos[d] = joint->pos_cmd;
+	homed = homed && GET_JOINT_HOMED_FLAG(joint);
+    }
+    if (homed) {
+	emcmot_comp_grid_eval(grid, pos, corr);
+    }
+    for (out = 0; out < grid->outputs; out++) {
+	joint = &joints[grid->output_joint[out]];
+	joint->grid_corr = homed ? corr[out] : 0.0;
+	/* homing switches the correction on in one step, so it is
+	   ramped like backlash, out of the same share of the limits */
+	v_max = comp_share(grid->output_joint[out]) * joint->vel_limit *
+		emcmotStatus->net_feed_scale;
+	a_max = comp_share(grid->output_joint[out]) * joint->acc_limit;
+	slew_comp(joint->grid_corr, &joint->grid_filt, &joint->grid_vel,
+		  v_max, a_max);
+    }
+}
+
 /*! \todo FIXME - once the HAL refactor is done so that metadata isn't stored
    in shared memory, I want to seriously consider moving some of the
    structures into the HAL memory block.  This will eliminate most of
@@ -1844,9 +1961,9 @@ static void output_to_hal(void)
     for (joint_num = 0; joint_num < emcmotConfig->numJoints; joint_num++) {
 	/* point to joint struct */
 	joint = &joints[joint_num];
-	/* apply backlash and motor offset to output */
-	joint->motor_pos_cmd =
-	    joint->pos_cmd + joint->backlash_filt + joint->motor_offset;
+	/* apply backlash, grid comp and motor offset to output */
+	joint->motor_pos_cmd = joint->pos_cmd + joint->backlash_filt +
+	    joint->grid_filt + joint->motor_offset;
 	/* point to HAL data */
 	joint_data = &(emcmot_hal_data->joint[joint_num]);
 	/* write to HAL pins */
@@ -1862,6 +1979,9 @@ static void output_to_hal(void)
 	*(joint_data->joint_acc_cmd) = joint->acc_cmd;
 	*(joint_data->backlash_corr) = joint->backlash_corr;
 	*(joint_data->backlash_filt) = joint->backlash_filt;
+	*(joint_data->grid_corr) = joint->grid_corr;
+	*(joint_data->grid_filt) = joint->grid_filt;
+	*(joint_data->grid_vel) = joint->grid_vel;
 	*(joint_data->backlash_vel) = joint->backlash_vel;
 	*(joint_data->f_error) = joint->ferror;
 	*(joint_data->f_error_lim) = joint->ferror_limit;
@@ -2008,3 +2128,64 @@ static void update_status(void)
     }
 #endif
 }
+
+static long long int stage_start(void)
+{
+    if (!emcmotStageTiming) {
+	return 0;
+    }
+    return rtapi_get_clocks();
+}
+
+static long long int stage_done(emcmot_stage_t stage, long long int start)
+{
+    long long int now;
+
+    if (!emcmotStageTiming) {
+	return 0;
+    }
+    now = rtapi_get_clocks();
+    stage_clocks[stage] += (unsigned long)(now - start);
+    return now;
+}
+
+static void update_stage_times(void)
+{
+    int n, h;
+    unsigned long clocks, v;
+    emcmot_stage_time_t *st;
+
+    if (!emcmotStageTiming) {
+	return;
+    }
+    if (*(emcmot_hal_data->stage_reset)) {
+	for (n = 0; n < EMCMOT_STAGES; n++) {
+	    st = &(emcmotStatus->stage[n]);
+	    st->tmax = 0;
+	    for (h = 0; h < EMCMOT_STAGE_HIST; h++) {
+		st->hist[h] = 0;
+		*(emcmot_hal_data->stage[n].hist[h]) = 0;
+	    }
+	}
+	*(emcmot_hal_data->stage_reset) = 0;
+    }
+
+    for (n = 0; n < EMCMOT_STAGES; n++) {
+	st = &(emcmotStatus->stage[n]);
+	clocks = stage_clocks[n];
+	stage_clocks[n] = 0;
+	/* bucket by the number of significant bits above the shift */
+	h = 0;
+	for (v = clocks >> EMCMOT_STAGE_HIST_SHIFT; v && h < EMCMOT_STAGE_HIST - 1; v >>= 1) {
+	    h++;
+	}
+	st->time = clocks;
+	if (st->time > st->tmax) {
+	    st->tmax = st->time;
+	}
+	st->hist[h]++;
+	*(emcmot_hal_data->stage[n].time) = st->time;
+	*(emcmot_hal_data->stage[n].tmax) = st->tmax;
+	*(emcmot_hal_data->stage[n].hist[h]) = st->hist[h];
+    }
+}
@@ -39,6 +39,8 @@
   values need to be computed, since operating system does this for us
   */
 #define DEFAULT_SHMEM_KEY 100
+/* the compensation grid's segment, see compgrid.h */
+#define COMP_GRID_SHMEM_KEY(key) ((key) + 1)
 
 /* default comm timeout, in seconds */
 #define DEFAULT_EMCMOT_COMM_TIMEOUT 1.0
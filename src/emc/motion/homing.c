@@ -841,7 +841,8 @@ void do_homing(void)
 		/* set the current position to 'home_offset' */
 		joint->motor_offset = -joint->home_offset;
 		joint->pos_fb = joint->motor_pos_fb -
-		    (joint->backlash_filt + joint->motor_offset);
+		    (joint->backlash_filt + joint->grid_filt +
+		     joint->motor_offset);
 		joint->pos_cmd = joint->pos_fb;
 		joint->free_tp.curr_pos = joint->pos_fb;
 		/* next state */
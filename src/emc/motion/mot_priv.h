@@ -29,6 +29,7 @@
 /* joint data */
 #include "hal.h"
 #include "../motion/motion.h"
+#include "compgrid.h"
 
 typedef struct {
     hal_float_t *coarse_pos_cmd;/* RPI: commanded position, w/o comp */
@@ -37,6 +38,9 @@ typedef struct {
     hal_float_t *backlash_corr;	/* RPI: correction for backlash */
     hal_float_t *backlash_filt;	/* RPI: filtered backlash correction */
     hal_float_t *backlash_vel;	/* RPI: backlash speed variable */
+    hal_float_t *grid_corr;	/* RPI: correction from the compensation grid */
+    hal_float_t *grid_filt;	/* RPI: filtered grid correction */
+    hal_float_t *grid_vel;	/* RPI: grid correction speed variable */
     hal_float_t *motor_offset;	/* RPI: motor offset, for checking homing stability */
     hal_float_t *motor_pos_cmd;	/* WPI: commanded position, with comp */
     hal_float_t *motor_pos_fb;	/* RPI: position feedback, with comp */
@@ -183,6 +187,14 @@ typedef struct {
     hal_u32_t   *last_period;	/* pin: last period in clocks */
     hal_float_t *last_period_ns;	/* pin: last period in nanoseconds */
 
+    // time spent in each stage of the servo cycle, see emcmot_stage_t
+    struct {
+	hal_u32_t *time;	/* pin: clocks spent in the last cycle */
+	hal_u32_t *tmax;	/* pin: most clocks spent in a cycle */
+	hal_u32_t *hist[EMCMOT_STAGE_HIST];	/* pins: cycles by clocks */
+    } stage[EMCMOT_STAGES];
+    hal_bit_t *stage_reset;	/* pin: clears tmax and hist, then itself */
+
     hal_float_t *tooloffset_x;
     hal_float_t *tooloffset_y;
     hal_float_t *tooloffset_z;
@@ -227,6 +239,15 @@ extern struct emcmot_config_t *emcmotConfig;
 extern struct emcmot_debug_t *emcmotDebug;
 extern struct emcmot_error_t *emcmotError;
 
+/* the compensation grid segment, 0 if comp_grid_size is 0, and whether
+   the grid in it is in use */
+extern emcmot_comp_grid_t *emcmotCompGrid;
+extern int emcmotCompGridActive;
+
+/* the stage_timing module parameter: whether emcmotController() times
+   its stages and the motion.servo.<stage> pins exist */
+extern int emcmotStageTiming;
+
 /***********************************************************************
 *                    PUBLIC FUNCTION PROTOTYPES                        *
 ************************************************************************/
@@ -44,6 +44,10 @@ int base_thread_fp = 0;	/* default is no floating point in base thread */
 RTAPI_MP_INT(base_thread_fp, "floating point in base thread?");
 static long servo_period_nsec = 1000000;	/* servo thread period */
 RTAPI_MP_LONG(servo_period_nsec, "servo thread period (nsecs)");
+static int base_thread_cpu = -1;	/* cpu for base thread, -1 = automatic */
+RTAPI_MP_INT(base_thread_cpu, "cpu to run the base thread on");
+static int servo_thread_cpu = -1;	/* cpu for servo thread, -1 = automatic */
+RTAPI_MP_INT(servo_thread_cpu, "cpu to run the servo thread on");
 static long traj_period_nsec = 0;	/* trajectory planner period */
 RTAPI_MP_LONG(traj_period_nsec, "trajectory planner period (nsecs)");
 static int num_joints = EMCMOT_MAX_JOINTS;	/* default number of joints present */
@@ -53,8 +57,14 @@ RTAPI_MP_INT(num_dio, "number of digital inputs/outputs");
 static int num_aio = DEFAULT_AIO;	/* default number of motion synched AIO */
 RTAPI_MP_INT(num_aio, "number of analog inputs/outputs");
 
+static long comp_grid_size = 0;	/* bytes for the compensation grid */
+RTAPI_MP_LONG(comp_grid_size, "size of the compensation grid segment (bytes)");
+
 static int unlock_joints_mask = 0;/* mask to select joints for unlock pins */
 RTAPI_MP_INT(unlock_joints_mask, "mask to select joints for unlock pins");
+
+static int stage_timing = 0;	/* time the stages of the servo cycle? */
+RTAPI_MP_INT(stage_timing, "time each stage of the servo cycle");
 /***********************************************************************
 *                  GLOBAL VARIABLE DEFINITIONS                         *
 ************************************************************************/
@@ -95,12 +105,18 @@ struct emcmot_config_t *emcmotConfig = 0;
 struct emcmot_debug_t *emcmotDebug = 0;
 struct emcmot_error_t *emcmotError = 0;	/* unused for RT_FIFO */
 
+emcmot_comp_grid_t *emcmotCompGrid = 0;
+int emcmotCompGridActive = 0;
+
+int emcmotStageTiming = 0;
+
 /***********************************************************************
 *                  LOCAL VARIABLE DECLARATIONS                         *
 ************************************************************************/
 
 /* RTAPI shmem ID - for comms with higher level user space stuff */
 static int emc_shmem_id;	/* the shared memory ID */
+static int comp_grid_shmem_id = -1;	/* the compensation grid's */
 
 static int mot_comp_id;	/* component ID for motion module */
 
@@ -279,6 +295,9 @@ void rtapi_app_exit(void)
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    _("MOTION: rtapi_shmem_delete() failed, returned %d\n"), retval);
     }
+    if (comp_grid_shmem_id >= 0) {
+	rtapi_shmem_delete(comp_grid_shmem_id, mot_comp_id);
+    }
     /* disconnect from HAL and RTAPI */
     retval = hal_exit(mot_comp_id);
     if (retval < 0) {
@@ -295,9 +314,16 @@ void rtapi_app_exit(void)
 /* init_hal_io() exports HAL pins and parameters making data from
    the realtime control module visible and usable by the world
 */
+/* HAL names of the emcmot_stage_t stages */
+static const char *stage_names[EMCMOT_STAGES] = {
+    "inputs", "forward-kins", "probe", "faults", "mode", "jog", "homing",
+    "pos-cmds", "tp", "inverse-kins", "screw-comp", "grid-comp", "output",
+    "status"
+};
+
 static int init_hal_io(void)
 {
-    int n, retval;
+    int n, h, retval;
     joint_hal_t *joint_data;
     axis_hal_t  *axis_data;
 
@@ -404,6 +430,17 @@ static int init_hal_io(void)
 #ifdef HAVE_CPU_KHZ
     if ((retval = hal_pin_float_newf(HAL_OUT, &(emcmot_hal_data->last_period_ns), mot_comp_id, "motion.servo.last-period-ns")) != 0) goto error;
 #endif
+    emcmotStageTiming = stage_timing;
+    if (emcmotStageTiming) {
+	for (n = 0; n < EMCMOT_STAGES; n++) {
+	    if ((retval = hal_pin_u32_newf(HAL_OUT, &(emcmot_hal_data->stage[n].time), mot_comp_id, "motion.servo.%s.time", stage_names[n])) != 0) goto error;
+	    if ((retval = hal_pin_u32_newf(HAL_OUT, &(emcmot_hal_data->stage[n].tmax), mot_comp_id, "motion.servo.%s.tmax", stage_names[n])) != 0) goto error;
+	    for (h = 0; h < EMCMOT_STAGE_HIST; h++) {
+		if ((retval = hal_pin_u32_newf(HAL_OUT, &(emcmot_hal_data->stage[n].hist[h]), mot_comp_id, "motion.servo.%s.hist-%02d", stage_names[n], h)) != 0) goto error;
+	    }
+	}
+	if ((retval = hal_pin_bit_newf(HAL_IO, &(emcmot_hal_data->stage_reset), mot_comp_id, "motion.servo.stage-reset")) != 0) goto error;
+    }
 
     // export timing related HAL pins so they can be scoped
     if ((retval = hal_pin_float_newf(HAL_OUT, &(emcmot_hal_data->tooloffset_x), mot_comp_id, "motion.tooloffset.x")) != 0) goto error;
@@ -458,6 +495,16 @@ static int init_hal_io(void)
     emcmot_hal_data->debug_float_3 = 0.0;
 
     *(emcmot_hal_data->last_period) = 0;
+    if (emcmotStageTiming) {
+	for (n = 0; n < EMCMOT_STAGES; n++) {
+	    *(emcmot_hal_data->stage[n].time) = 0;
+	    *(emcmot_hal_data->stage[n].tmax) = 0;
+	    for (h = 0; h < EMCMOT_STAGE_HIST; h++) {
+		*(emcmot_hal_data->stage[n].hist[h]) = 0;
+	    }
+	}
+	*(emcmot_hal_data->stage_reset) = 0;
+    }
 
     /* export joint pins and parameters */
     for (n = 0; n < num_joints; n++) {
@@ -539,6 +586,9 @@ static int export_joint(int num, joint_hal_t * addr)
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->joint_acc_cmd), mot_comp_id, "joint.%d.acc-cmd", num)) != 0) return retval;
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->backlash_corr), mot_comp_id, "joint.%d.backlash-corr", num)) != 0) return retval;
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->backlash_filt), mot_comp_id, "joint.%d.backlash-filt", num)) != 0) return retval;
+    if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->grid_corr), mot_comp_id, "joint.%d.grid-corr", num)) != 0) return retval;
+    if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->grid_filt), mot_comp_id, "joint.%d.grid-filt", num)) != 0) return retval;
+    if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->grid_vel), mot_comp_id, "joint.%d.grid-vel", num)) != 0) return retval;
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->backlash_vel), mot_comp_id, "joint.%d.backlash-vel", num)) != 0) return retval;
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->f_error), mot_comp_id, "joint.%d.f-error", num)) != 0) return retval;
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->f_error_lim), mot_comp_id, "joint.%d.f-error-lim", num)) != 0) return retval;
@@ -665,6 +715,34 @@ static int init_comm_buffers(void)
     emcmotConfig->numDIO = num_dio;
     emcmotConfig->numAIO = num_aio;
 
+    /* allocate the compensation grid segment, see compgrid.h */
+    emcmotConfig->compGridSize = 0;
+    if (comp_grid_size > 0) {
+	if (comp_grid_size < (long) sizeof(emcmot_comp_grid_t)) {
+	    comp_grid_size = sizeof(emcmot_comp_grid_t);
+	}
+	comp_grid_shmem_id = rtapi_shmem_new(COMP_GRID_SHMEM_KEY(key),
+	    mot_comp_id, comp_grid_size);
+	if (comp_grid_shmem_id < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"MOTION: rtapi_shmem_new for the compensation grid failed, returned %d\n",
+		comp_grid_shmem_id);
+	    return -1;
+	}
+	retval = rtapi_shmem_getptr(comp_grid_shmem_id, (void **) &emcmotCompGrid);
+	if (retval < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"MOTION: rtapi_shmem_getptr for the compensation grid failed, returned %d\n",
+		retval);
+	    return -1;
+	}
+	memset(emcmotCompGrid, 0, sizeof(emcmot_comp_grid_t));
+	emcmotCompGrid->capacity = (comp_grid_size - sizeof(emcmot_comp_grid_t))
+	    / sizeof(float);
+	emcmotConfig->compGridSize = comp_grid_size;
+    }
+    emcmotCompGridActive = 0;
+
     ZERO_EMC_POSE(emcmotStatus->carte_pos_cmd);
     ZERO_EMC_POSE(emcmotStatus->carte_pos_fb);
     emcmotStatus->vel = 0.0;
@@ -756,6 +834,9 @@ static int init_comm_buffers(void)
 	joint->acc_cmd = 0.0;
 	joint->backlash_corr = 0.0;
 	joint->backlash_filt = 0.0;
+	joint->grid_corr = 0.0;
+	joint->grid_filt = 0.0;
+	joint->grid_vel = 0.0;
 	joint->backlash_vel = 0.0;
 	joint->motor_pos_cmd = 0.0;
 	joint->motor_pos_fb = 0.0;
@@ -827,7 +908,8 @@ static int init_threads(void)
     /* create HAL threads for each period */
     /* only create base thread if it is faster than servo thread */
     if (servo_base_ratio > 1) {
-	retval = hal_create_thread("base-thread", base_period_nsec, base_thread_fp);
+	retval = hal_create_thread_cpu("base-thread", base_period_nsec,
+	    base_thread_fp, base_thread_cpu);
 	if (retval < 0) {
 	    rtapi_print_msg(RTAPI_MSG_ERR,
 		"MOTION: failed to create %ld nsec base thread\n",
@@ -835,7 +917,8 @@ static int init_threads(void)
 	    return -1;
 	}
     }
-    retval = hal_create_thread("servo-thread", servo_period_nsec, 1);
+    retval = hal_create_thread_cpu("servo-thread", servo_period_nsec, 1,
+	servo_thread_cpu);
     if (retval < 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "MOTION: failed to create %ld nsec servo thread\n",
@@ -124,6 +124,7 @@ extern "C" {
 
 	EMCMOT_SET_LINE,	/* queue up a linear move */
 	EMCMOT_SET_CIRCLE,	/* queue up a circular move */
+	EMCMOT_SET_SEGMENTS,	/* queue up several lines and circles */
 	EMCMOT_SET_TELEOP_VECTOR,	/* Move at a given velocity but in
 					   world cartesian coordinates, not
 					   in joint space like EMCMOT_JOG_* */
@@ -179,6 +180,7 @@ extern "C" {
 	EMCMOT_UPDATE_JOINT_HOMING_PARAMS, /* updates some joint homing parameters */
 	EMCMOT_SET_JOINT_MOTOR_OFFSET,  /* set the offset between joint and motor */
 	EMCMOT_SET_JOINT_COMP,          /* set a compensation triplet for a joint (nominal, forw., rev.) */
+	EMCMOT_SET_COMP_GRID,           /* turn the compensation grid on or off */
 
         EMCMOT_SET_AXIS_POSITION_LIMITS, /* set the axis position +/- limits */
         EMCMOT_SET_AXIS_VEL_LIMIT,      /* set the max axis vel */
@@ -202,6 +204,26 @@ extern "C" {
 #define EMCMOT_TERM_COND_BLEND 2
 #define EMCMOT_TERM_COND_TANGENT 3
 
+/* maximum number of moves in one EMCMOT_SET_SEGMENTS command; with
+   blend arcs each one may take two queue entries, so this has to stay
+   well inside the TC_QUEUE_MARGIN that tcqFull() keeps free */
+#define EMCMOT_MAX_SEGMENTS 8
+
+/* one line or circle of an EMCMOT_SET_SEGMENTS command, with the same
+   meaning as the fields of the same name in emcmot_command_t */
+    typedef struct emcmot_segment_t {
+	cmd_code_t command;	/* EMCMOT_SET_LINE or EMCMOT_SET_CIRCLE */
+	EmcPose pos;
+	PmCartesian center;
+	PmCartesian normal;
+	int turn;
+	int motion_type;
+	double vel;
+	double ini_maxvel;
+	double acc;
+	int id;
+    } emcmot_segment_t;
+
 /*********************************
        COMMAND STRUCTURE
 *********************************/
@@ -249,6 +271,7 @@ extern "C" {
 	unsigned char now, out, start, end;	/* these are related to synched AOUT/DOUT. now=wether now or synched, out = which gets set, start=start value, end=end value */
 	unsigned char mode;	/* used for turning overrides etc. on/off */
 	double comp_nominal, comp_forward, comp_reverse; /* compensation triplet, nominal, forward, reverse */
+	int comp_grid;		/* EMCMOT_SET_COMP_GRID: 1 = use the grid now in its segment */
         unsigned char probe_type; /* ~1 = error if probe operation is unsuccessful (ngc default)
                                      |1 = suppress error, report in # instead
                                      ~2 = move until probe trips (ngc default)
@@ -268,6 +291,8 @@ extern "C" {
         double arcBlendRampFreq;
         double arcBlendTangentKinkRatio;
         double maxFeedScale;
+	int nsegments;		/* number of valid entries in segments[] */
+	emcmot_segment_t segments[EMCMOT_MAX_SEGMENTS];
     } emcmot_command_t;
 
 /*! \todo FIXME - these packed bits might be replaced with chars
@@ -529,6 +554,9 @@ Suggestion: Split this in to an Error and a Status flag register..
 	double backlash_corr;	/* correction for backlash */
 	double backlash_filt;	/* filtered backlash correction */
 	double backlash_vel;	/* backlash velocity variable */
+	double grid_corr;	/* correction from the compensation grid */
+	double grid_filt;	/* filtered grid correction */
+	double grid_vel;	/* grid correction velocity variable */
 	double motor_pos_cmd;	/* commanded position, with comp */
 	double motor_pos_fb;	/* position feedback, with comp */
 	double pos_fb;		/* position feedback, comp removed */
@@ -623,6 +651,39 @@ Suggestion: Split this in to an Error and a Status flag register..
 	double min_pos_limit;	/* lower soft limit on axis pos */
     } emcmot_axis_status_t;
 
+/* the stages of the servo cycle emcmotController() times; TP and
+   INVERSE_KINS are the trajectory planner and inverse kinematics runs
+   within POS_CMDS, whose time includes theirs */
+    typedef enum {
+	EMCMOT_STAGE_INPUTS,
+	EMCMOT_STAGE_FORWARD_KINS,
+	EMCMOT_STAGE_PROBE,
+	EMCMOT_STAGE_FAULTS,
+	EMCMOT_STAGE_MODE,
+	EMCMOT_STAGE_JOG,
+	EMCMOT_STAGE_HOMING,
+	EMCMOT_STAGE_POS_CMDS,
+	EMCMOT_STAGE_TP,
+	EMCMOT_STAGE_INVERSE_KINS,
+	EMCMOT_STAGE_SCREW_COMP,
+	EMCMOT_STAGE_GRID_COMP,
+	EMCMOT_STAGE_OUTPUT,
+	EMCMOT_STAGE_STATUS,
+	EMCMOT_STAGES
+    } emcmot_stage_t;
+
+/* time histogram buckets: [0] counts cycles taking under
+   1 << EMCMOT_STAGE_HIST_SHIFT clocks, [i] those under 1 << (SHIFT + i)
+   and not in [i-1], the last one all longer */
+#define EMCMOT_STAGE_HIST 12
+#define EMCMOT_STAGE_HIST_SHIFT 10
+
+    typedef struct {
+	unsigned int time;	/* clocks spent in the last cycle */
+	unsigned int tmax;	/* most clocks spent in a cycle */
+	unsigned int hist[EMCMOT_STAGE_HIST];	/* cycles by clocks spent */
+    } emcmot_stage_time_t;
+
 /*********************************
         STATUS STRUCTURE
 *********************************/
@@ -722,6 +783,7 @@ Suggestion: Split this in to an Error and a Status flag register..
         EmcPose tool_offset;
         int atspeed_next_feed;  /* at next feed move, wait for spindle to be at speed  */
         int spindle_is_atspeed; /* hal input */
+	emcmot_stage_time_t stage[EMCMOT_STAGES];	/* servo cycle timing */
 	unsigned char tail;	/* flag count for mutex detect */
         
     } emcmot_status_t;
@@ -765,6 +827,9 @@ Suggestion: Split this in to an Error and a Status flag register..
         int numAIO;             /* userdefined number of analog IO. default is 4. (EMCMOT_MAX_AIO=16), 
                                    but can be altered at motmod insmod time */
 
+	long compGridSize;	/* bytes in the compensation grid segment, 0 for
+				   none.  Set at motmod insmod time */
+
 /*! \todo FIXME - all structure members beyond this point are in limbo */
 
 	double trajCycleTime;	/* the rate at which the trajectory loop
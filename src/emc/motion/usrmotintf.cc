@@ -18,11 +18,13 @@
 #include <sys/stat.h>
 #include <string.h>		/* memcpy() */
 #include <float.h>		/* DBL_MIN */
+#include <vector>
 #include "motion.h"		/* emcmot_status_t,CMD */
 #include "motion_debug.h"       /* emcmot_debug_t */
 #include "motion_struct.h"      /* emcmot_struct_t */
 #include "emcmotcfg.h"		/* EMCMOT_ERROR_NUM,LEN */
 #include "emcmotglb.h"		/* SHMEM_KEY */
+#include "compgrid.h"		/* emcmot_comp_grid_t */
 #include "usrmotintf.h"		/* these decls */
 #include "_timer.h"
 #include "rcs_print.hh"
@@ -644,6 +646,8 @@ void usrmotPrintEmcmotStatus(emcmot_status_t *s, int which)
 
 static int module_id;
 static int shmem_id;
+static int comp_grid_shmem_id = -1;
+static emcmot_comp_grid_t *compGrid = 0;
 
 int usrmotInit(const char *modname)
 {
@@ -686,9 +690,14 @@ int usrmotInit(const char *modname)
 int usrmotExit(void)
 {
     if (NULL != emcmotStruct) {
+	if (comp_grid_shmem_id >= 0) {
+	    rtapi_shmem_delete(comp_grid_shmem_id, module_id);
+	}
 	rtapi_shmem_delete(shmem_id, module_id);
 	rtapi_exit(module_id);
     }
+    comp_grid_shmem_id = -1;
+    compGrid = 0;
 
     emcmotStruct = 0;
     emcmotCommand = 0;
@@ -765,6 +774,59 @@ int usrmotLoadComp(int joint, const char *file, int type)
 }
 
 
+static int send_comp_grid(int on)
+{
+    emcmot_command_t emcmotCommand;
+
+    memset(&emcmotCommand, 0, sizeof(emcmotCommand));
+    emcmotCommand.command = EMCMOT_SET_COMP_GRID;
+    emcmotCommand.comp_grid = on;
+    return usrmotWriteEmcmotCommand(&emcmotCommand);
+}
+
+/* Loads a compensation grid file (format in compgrid.h) into the
+   motion controller's grid segment, replacing the grid in use.  The
+   machine must be off.  The file is read and checked before the grid
+   in use is switched off. */
+int usrmotLoadCompGrid(const char *file)
+{
+    emcmot_config_t config;
+    emcmot_comp_grid_t *grid;
+    int ret;
+
+    if (0 != usrmotReadEmcmotConfig(&config) || config.compGridSize <= 0) {
+	fprintf(stderr, "no compensation grid in motion, load motmod with comp_grid_size\n");
+	return -1;
+    }
+    if (compGrid == 0) {
+	comp_grid_shmem_id = rtapi_shmem_new(COMP_GRID_SHMEM_KEY(SHMEM_KEY),
+	    module_id, config.compGridSize);
+	if (comp_grid_shmem_id < 0 ||
+	    rtapi_shmem_getptr(comp_grid_shmem_id, (void **) &compGrid) < 0) {
+	    fprintf(stderr, "can't open the compensation grid shared memory\n");
+	    comp_grid_shmem_id = -1;
+	    compGrid = 0;
+	    return -1;
+	}
+    }
+
+    std::vector<char> buf(sizeof(emcmot_comp_grid_t) +
+	compGrid->capacity * sizeof(float));
+    grid = (emcmot_comp_grid_t *) &buf[0];
+    grid->capacity = compGrid->capacity;
+    if (0 != emcmotCompGridRead(file, grid)) {
+	return -1;
+    }
+
+    /* the grid in use can only be replaced once motion stops using it */
+    if (0 != (ret = send_comp_grid(0))) {
+	return ret;
+    }
+    memcpy(compGrid, grid,
+	sizeof(emcmot_comp_grid_t) + grid->size * sizeof(float));
+    return send_comp_grid(1);
+}
+
 int usrmotPrintComp(int joint)
 {
 /* FIXME-AJ: comp isn't in shmem atm
@@ -79,6 +79,10 @@ extern "C" {
 /* usrmotLoadComp() loads the compensation data in file into the joint */
     extern int usrmotLoadComp(int joint, const char *file, int type);
 
+/* usrmotLoadCompGrid() loads the compensation grid in file into motion,
+   replacing the one in use; see compgrid.h */
+    extern int usrmotLoadCompGrid(const char *file);
+
 /* usrmotPrintComp() prints the joint compensation data for the specified joint */
     extern int usrmotPrintComp(int joint);
 
@@ -927,9 +927,13 @@ extern double GET_EXTERNAL_ANALOG_INPUT(int index, double def);
 // Returns the mask of axes present in the system
 extern int GET_EXTERNAL_AXIS_MASK();
 
+// Returns the number of canonical commands issued so far; only the
+// difference between two calls is meaningful
+extern long GET_EXTERNAL_CANON_COUNT();
+
 extern FILE *_outfile;		/* where to print, set in main */
-extern CANON_TOOL_TABLE _tools[];	/* in canon.cc */
-extern int _pockets_max;		/* in canon.cc */
+class ToolStore;
+extern ToolStore _tools;		/* in canon.cc */
 extern char _parameter_file_name[];	/* in canon.cc */
 #define PARAMETER_FILE_NAME_LENGTH 100
 
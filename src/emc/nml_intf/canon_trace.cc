@@ -0,0 +1,101 @@
+/********************************************************************
+* Description: canon_trace.cc
+*
+*   Fingerprint of the machine state a canon trace assumes.  Both
+*   'rs274 -o' and task use the canonical interface of their own
+*   executable, so the writer and the reader of a trace hash the
+*   same things the same way.
+*
+* Author: LinuxCNC developers
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 LinuxCNC developers
+********************************************************************/
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include "canon.hh"
+#include "canon_trace.hh"
+
+/* G28, G30, G92 and the G54..G59.3 offsets and rotations */
+#define FIRST_OFFSET_PARAMETER 5161
+#define LAST_OFFSET_PARAMETER 5390
+
+/* FNV-1a */
+static uint64_t fnv(uint64_t h, const void *data, size_t len)
+{
+    const unsigned char *p = (const unsigned char *) data;
+
+    while (len--) {
+	h ^= *p++;
+	h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static uint64_t fnv_double(uint64_t h, double d)
+{
+    if (d == 0)
+	d = 0;			/* -0 */
+    return fnv(h, &d, sizeof(d));
+}
+
+static uint64_t fnv_int(uint64_t h, int32_t i)
+{
+    return fnv(h, &i, sizeof(i));
+}
+
+void canon_trace_fingerprint(uint64_t *offsets, uint64_t *tools)
+{
+    double params[LAST_OFFSET_PARAMETER - FIRST_OFFSET_PARAMETER + 1];
+    char filename[PATH_MAX], line[PATH_MAX];
+    uint64_t h;
+    double value;
+    int k, n;
+    FILE *fp;
+
+    /* the parameters as saved in the var file; missing ones are 0, as
+       the interpreter reads them */
+    memset(params, 0, sizeof(params));
+    filename[0] = 0;
+    GET_EXTERNAL_PARAMETER_FILE_NAME(filename, sizeof(filename) - 1);
+    fp = fopen(filename[0] ? filename : "rs274ngc.var", "r");
+    if (fp) {
+	while (fgets(line, sizeof(line), fp)) {
+	    if (sscanf(line, "%d %lf", &n, &value) == 2
+		&& n >= FIRST_OFFSET_PARAMETER && n <= LAST_OFFSET_PARAMETER)
+		params[n - FIRST_OFFSET_PARAMETER] = value;
+	}
+	fclose(fp);
+    }
+    h = 0xcbf29ce484222325ULL;
+    for (k = 0; k < (int) (sizeof(params) / sizeof(params[0])); k++)
+	h = fnv_double(h, params[k]);
+    *offsets = h;
+
+    /* the tools loaded in pockets; pocket 0 is the spindle, which the
+       trace's own tool changes set */
+    h = 0xcbf29ce484222325ULL;
+    for (k = 1; k < GET_EXTERNAL_POCKETS_MAX(); k++) {
+	CANON_TOOL_TABLE t = GET_EXTERNAL_TOOL_TABLE(k);
+	if (t.toolno <= 0)
+	    continue;
+	h = fnv_int(h, k);
+	h = fnv_int(h, t.toolno);
+	h = fnv_double(h, t.offset.tran.x);
+	h = fnv_double(h, t.offset.tran.y);
+	h = fnv_double(h, t.offset.tran.z);
+	h = fnv_double(h, t.offset.a);
+	h = fnv_double(h, t.offset.b);
+	h = fnv_double(h, t.offset.c);
+	h = fnv_double(h, t.offset.u);
+	h = fnv_double(h, t.offset.v);
+	h = fnv_double(h, t.offset.w);
+	h = fnv_double(h, t.diameter);
+	h = fnv_double(h, t.frontangle);
+	h = fnv_double(h, t.backangle);
+	h = fnv_int(h, t.orientation);
+    }
+    *tools = h;
+}
@@ -0,0 +1,164 @@
+/********************************************************************
+* Description: canon_trace.hh
+*
+*   Binary canon trace format.  A canon trace is the list of
+*   canonical calls made while interpreting a program, with the
+*   source line number of each.  'rs274 -o file' writes one, and
+*   libcanterp.so replays it (task switches to it when a program
+*   file starts with CANON_TRACE_MAGIC), so a verified program can
+*   run again without being interpreted.
+*
+*   A trace is only valid for a machine in the state the program was
+*   interpreted for: same parameters, tool table, offsets and starting
+*   position.  Calls whose outcome the program could depend on
+*   (probing, waiting on inputs, plugins) are written as
+*   CANON_TRACE_UNSUPPORTED, and the replay stops with an error
+*   there.  The replay re-issues the offsets and tool table entries
+*   the program set, so the header holds a fingerprint of the var
+*   file offsets and of the tool table the trace was made with, and
+*   task refuses to run a trace on a machine where they differ.
+*
+*   The file is the header below, then records, each one a
+*   canon_trace_record followed by its doubles, ints and text, padded
+*   to 8 bytes, so the records can be used in place from an mmap.
+*   The last record is CANON_TRACE_END.  The file is in the byte
+*   order of the machine that wrote it.
+*
+* Author: LinuxCNC developers
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 LinuxCNC developers
+********************************************************************/
+#ifndef CANON_TRACE_HH
+#define CANON_TRACE_HH
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CANON_TRACE_MAGIC "EMCCANON"
+#define CANON_TRACE_MAGIC_LEN 8
+#define CANON_TRACE_VERSION 2
+#define CANON_TRACE_BYTE_ORDER 0x01020304
+#define CANON_TRACE_SOURCE_LEN 1024
+
+struct canon_trace_header {
+    char magic[CANON_TRACE_MAGIC_LEN];
+    uint32_t version;
+    uint32_t byte_order;
+    char source[CANON_TRACE_SOURCE_LEN];	/* program interpreted */
+    uint64_t offsets;		/* canon_trace_fingerprint() */
+    uint64_t tools;
+};
+
+struct canon_trace_record {
+    uint8_t op;			/* CANON_TRACE_... */
+    uint8_t ndoubles;
+    uint8_t nints;
+    uint8_t textlen;		/* including the terminating NUL, 0 if none */
+    int32_t line;		/* source line number, -1 if unknown */
+};
+
+/* Arguments are listed as doubles / ints / text, in the order of the
+   canonical call. */
+enum canon_trace_op {
+    CANON_TRACE_END = 0,
+    CANON_TRACE_UNSUPPORTED,		/* text: the call */
+    CANON_TRACE_STRAIGHT_TRAVERSE,	/* x y z a b c u v w */
+    CANON_TRACE_STRAIGHT_FEED,		/* x y z a b c u v w */
+    CANON_TRACE_ARC_FEED,		/* 11 doubles / rotation */
+    CANON_TRACE_RIGID_TAP,		/* x y z */
+    CANON_TRACE_SET_G5X_OFFSET,		/* x y z a b c u v w / origin */
+    CANON_TRACE_SET_G92_OFFSET,		/* x y z a b c u v w */
+    CANON_TRACE_SET_XY_ROTATION,	/* t */
+    CANON_TRACE_USE_LENGTH_UNITS,	/* / units */
+    CANON_TRACE_SELECT_PLANE,		/* / plane */
+    CANON_TRACE_SET_TRAVERSE_RATE,	/* rate */
+    CANON_TRACE_SET_FEED_RATE,		/* rate */
+    CANON_TRACE_SET_FEED_MODE,		/* / mode */
+    CANON_TRACE_SET_FEED_REFERENCE,	/* / reference */
+    CANON_TRACE_SET_MOTION_CONTROL_MODE,	/* tolerance / mode */
+    CANON_TRACE_SET_NAIVECAM_TOLERANCE,	/* tolerance */
+    CANON_TRACE_SET_CUTTER_RADIUS_COMPENSATION,	/* radius */
+    CANON_TRACE_START_CUTTER_RADIUS_COMPENSATION,	/* / side */
+    CANON_TRACE_STOP_CUTTER_RADIUS_COMPENSATION,
+    CANON_TRACE_START_SPEED_FEED_SYNCH,	/* feed per rev / velocity mode */
+    CANON_TRACE_STOP_SPEED_FEED_SYNCH,
+    CANON_TRACE_DWELL,			/* seconds */
+    CANON_TRACE_SET_SPINDLE_MODE,	/* arg */
+    CANON_TRACE_SET_SPINDLE_SPEED,	/* rpm */
+    CANON_TRACE_START_SPINDLE_CLOCKWISE,	/* / wait for at-speed */
+    CANON_TRACE_START_SPINDLE_COUNTERCLOCKWISE,	/* / wait for at-speed */
+    CANON_TRACE_STOP_SPINDLE_TURNING,
+    CANON_TRACE_ORIENT_SPINDLE,		/* orientation / mode */
+    CANON_TRACE_WAIT_SPINDLE_ORIENT_COMPLETE,	/* timeout */
+    CANON_TRACE_SET_TOOL_TABLE_ENTRY,	/* offset x..w diameter frontangle
+					   backangle / pocket toolno
+					   orientation */
+    CANON_TRACE_USE_TOOL_LENGTH_OFFSET,	/* x y z a b c u v w */
+    CANON_TRACE_CHANGE_TOOL,		/* / slot */
+    CANON_TRACE_SELECT_POCKET,		/* / pocket tool */
+    CANON_TRACE_CHANGE_TOOL_NUMBER,	/* / number */
+    CANON_TRACE_START_CHANGE,
+    CANON_TRACE_COMMENT,		/* text */
+    CANON_TRACE_MESSAGE,		/* text */
+    CANON_TRACE_DISABLE_ADAPTIVE_FEED,
+    CANON_TRACE_ENABLE_ADAPTIVE_FEED,
+    CANON_TRACE_DISABLE_FEED_OVERRIDE,
+    CANON_TRACE_ENABLE_FEED_OVERRIDE,
+    CANON_TRACE_DISABLE_SPEED_OVERRIDE,
+    CANON_TRACE_ENABLE_SPEED_OVERRIDE,
+    CANON_TRACE_DISABLE_FEED_HOLD,
+    CANON_TRACE_ENABLE_FEED_HOLD,
+    CANON_TRACE_FLOOD_OFF,
+    CANON_TRACE_FLOOD_ON,
+    CANON_TRACE_MIST_OFF,
+    CANON_TRACE_MIST_ON,
+    CANON_TRACE_SET_MOTION_OUTPUT_BIT,	/* / index */
+    CANON_TRACE_CLEAR_MOTION_OUTPUT_BIT,	/* / index */
+    CANON_TRACE_SET_MOTION_OUTPUT_VALUE,	/* value / index */
+    CANON_TRACE_SET_AUX_OUTPUT_BIT,	/* / index */
+    CANON_TRACE_CLEAR_AUX_OUTPUT_BIT,	/* / index */
+    CANON_TRACE_SET_AUX_OUTPUT_VALUE,	/* value / index */
+    CANON_TRACE_PALLET_SHUTTLE,
+    CANON_TRACE_TURN_PROBE_OFF,
+    CANON_TRACE_TURN_PROBE_ON,
+    CANON_TRACE_PROGRAM_STOP,
+    CANON_TRACE_OPTIONAL_PROGRAM_STOP,
+    CANON_TRACE_PROGRAM_END,
+    CANON_TRACE_FINISH,
+};
+
+/* Hash the G28/G30/G92/G5x parameters saved in the var file and the
+   tools in pockets, as seen through the canonical interface of the
+   calling executable. */
+void canon_trace_fingerprint(uint64_t *offsets, uint64_t *tools);
+
+static inline size_t canon_trace_record_size(const canon_trace_record *r)
+{
+    size_t n = sizeof(*r) + r->ndoubles * sizeof(double)
+	+ r->nints * sizeof(int32_t) + r->textlen;
+    return (n + 7) & ~(size_t) 7;
+}
+
+static inline const double *canon_trace_doubles(const canon_trace_record *r)
+{
+    return (const double *) (r + 1);
+}
+
+static inline const int32_t *canon_trace_ints(const canon_trace_record *r)
+{
+    return (const int32_t *) (canon_trace_doubles(r) + r->ndoubles);
+}
+
+static inline const char *canon_trace_text(const canon_trace_record *r)
+{
+    return r->textlen ? (const char *) (canon_trace_ints(r) + r->nints) : "";
+}
+
+/* The writer, in the rs274 standalone interpreter (saicanon.cc).  Both
+   return 0 on success, -1 on error. */
+extern int canon_trace_open(const char *filename, const char *source);
+extern int canon_trace_close();
+
+#endif				/* CANON_TRACE_HH */
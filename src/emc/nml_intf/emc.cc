@@ -901,8 +901,13 @@ void EMC_TOOL_STAT::update(CMS * cms)
     EMC_TOOL_STAT_MSG::update(cms);
     cms->update(pocketPrepped);
     cms->update(toolInSpindle);
-    for (int i_toolTable = 0; i_toolTable < CANON_POCKETS_MAX; i_toolTable++)
-	CANON_TOOL_TABLE_update(cms, &(toolTable[i_toolTable]));
+    cms->update(toolTableSerial);
+    cms->update(randomToolchanger);
+    cms->update(toolTableFile, LINELEN);
+    cms->update(changes);
+    cms->update(changePocket, EMC_TOOL_CHANGES_MAX);
+    for (int i_changeTool = 0; i_changeTool < EMC_TOOL_CHANGES_MAX; i_changeTool++)
+	CANON_TOOL_TABLE_update(cms, &(changeTool[i_changeTool]));
 
 }
 
@@ -1621,6 +1621,9 @@ class EMC_TOOL_STAT_MSG:public RCS_STAT_MSG {
     void update(CMS * cms);
 };
 
+// most pockets one tool table change touches (a swap)
+#define EMC_TOOL_CHANGES_MAX 2
+
 class EMC_TOOL_STAT:public EMC_TOOL_STAT_MSG {
   public:
     EMC_TOOL_STAT();
@@ -1631,7 +1634,14 @@ class EMC_TOOL_STAT:public EMC_TOOL_STAT_MSG {
 
     int pocketPrepped;		// pocket ready for loading from
     int toolInSpindle;		// tool loaded, 0 is no tool
-    CANON_TOOL_TABLE toolTable[CANON_POCKETS_MAX];
+
+    // The tool table itself isn't here, see toolstore.hh.
+    int toolTableSerial;	// bumped on every change to the table
+    int randomToolchanger;
+    char toolTableFile[LINELEN];	// the table, as of the last save
+    int changes;		// pockets changed by this serial, 0: reload
+    int changePocket[EMC_TOOL_CHANGES_MAX];
+    CANON_TOOL_TABLE changeTool[EMC_TOOL_CHANGES_MAX];
 };
 
 // EMC_AUX type declarations
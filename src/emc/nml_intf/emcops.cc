@@ -15,6 +15,8 @@
 * Last change:
 ********************************************************************/
 
+#include <string.h>
+
 #include "emc.hh"
 #include "emc_nml.hh"
 
@@ -160,14 +162,19 @@ EMC_TOOL_STAT_MSG(EMC_TOOL_STAT_TYPE, sizeof(EMC_TOOL_STAT))
 
     pocketPrepped = 0;
     toolInSpindle = 0;
-
-    for (t = 0; t < CANON_POCKETS_MAX; t++) {
-	toolTable[t].toolno = 0;
-        ZERO_EMC_POSE(toolTable[t].offset);
-	toolTable[t].diameter = 0.0;
-	toolTable[t].orientation = 0;
-	toolTable[t].frontangle = 0.0;
-	toolTable[t].backangle = 0.0;
+    toolTableSerial = 0;
+    randomToolchanger = 0;
+    toolTableFile[0] = 0;
+    changes = 0;
+
+    for (t = 0; t < EMC_TOOL_CHANGES_MAX; t++) {
+	changePocket[t] = 0;
+	changeTool[t].toolno = -1;
+        ZERO_EMC_POSE(changeTool[t].offset);
+	changeTool[t].diameter = 0.0;
+	changeTool[t].orientation = 0;
+	changeTool[t].frontangle = 0.0;
+	changeTool[t].backangle = 0.0;
     }
 }
 
@@ -209,14 +216,14 @@ EMC_TOOL_STAT EMC_TOOL_STAT::operator =(EMC_TOOL_STAT s)
 
     pocketPrepped = s.pocketPrepped;
     toolInSpindle = s.toolInSpindle;
-
-    for (t = 0; t < CANON_POCKETS_MAX; t++) {
-	toolTable[t].toolno = s.toolTable[t].toolno;
-	toolTable[t].offset = s.toolTable[t].offset;
-	toolTable[t].diameter = s.toolTable[t].diameter;
-	toolTable[t].frontangle = s.toolTable[t].frontangle;
-	toolTable[t].backangle = s.toolTable[t].backangle;
-	toolTable[t].orientation = s.toolTable[t].orientation;
+    toolTableSerial = s.toolTableSerial;
+    randomToolchanger = s.randomToolchanger;
+    strcpy(toolTableFile, s.toolTableFile);
+    changes = s.changes;
+
+    for (t = 0; t < EMC_TOOL_CHANGES_MAX; t++) {
+	changePocket[t] = s.changePocket[t];
+	changeTool[t] = s.changeTool[t];
     }
 
     return s;
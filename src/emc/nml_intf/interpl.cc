@@ -17,12 +17,12 @@
 
 
 #include <string.h>		/* memcpy() */
+#include <stdlib.h>		/* malloc(), free() */
 
-#include "rcs.hh"		// LinkedList
+#include "rcs.hh"		// NMLmsg
 #include "interpl.hh"		// these decls
 #include "emc.hh"
 #include "emcglb.h"
-#include "linklist.hh"
 #include "nmlmsg.hh"            /* class NMLmsg */
 #include "rcs_print.hh"
 
@@ -30,7 +30,13 @@ NML_INTERP_LIST interp_list;	/* NML Union, for interpreter */
 
 NML_INTERP_LIST::NML_INTERP_LIST()
 {
-    linked_list_ptr = new LinkedList;
+    ring = (NML_INTERP_LIST_NODE *)
+	malloc(NML_INTERP_LIST_INITIAL_SIZE * sizeof(NML_INTERP_LIST_NODE));
+    ring_size = (NULL != ring) ? NML_INTERP_LIST_INITIAL_SIZE : 0;
+    head = 0;
+    count = 0;
+    total = 0;
+    pthread_mutex_init(&mutex, NULL);
 
     next_line_number = 0;
     line_number = 0;
@@ -38,10 +44,37 @@ NML_INTERP_LIST::NML_INTERP_LIST()
 
 NML_INTERP_LIST::~NML_INTERP_LIST()
 {
-    if (NULL != linked_list_ptr) {
-	delete linked_list_ptr;
-	linked_list_ptr = NULL;
+    if (NULL != ring) {
+	free(ring);
+	ring = NULL;
     }
+    ring_size = 0;
+    count = 0;
+    pthread_mutex_destroy(&mutex);
+}
+
+// doubles the ring, keeping the nodes in order; called with mutex held
+int NML_INTERP_LIST::grow()
+{
+    int new_size = ring_size > 0 ? 2 * ring_size : NML_INTERP_LIST_INITIAL_SIZE;
+    NML_INTERP_LIST_NODE *new_ring = (NML_INTERP_LIST_NODE *)
+	malloc(new_size * sizeof(NML_INTERP_LIST_NODE));
+
+    if (NULL == new_ring) {
+	return -1;
+    }
+    for (int i = 0; i < count; i++) {
+	NML_INTERP_LIST_NODE *node = &ring[(head + i) % ring_size];
+	new_ring[i].line_number = node->line_number;
+	memcpy(new_ring[i].command.commandbuf, node->command.commandbuf,
+	       ((NMLmsg *) node->command.commandbuf)->size);
+    }
+    free(ring);
+    ring = new_ring;
+    ring_size = new_size;
+    head = 0;
+
+    return 0;
 }
 
 int NML_INTERP_LIST::append(NMLmsg & nml_msg)
@@ -59,6 +92,8 @@ int NML_INTERP_LIST::set_line_number(int line)
 
 int NML_INTERP_LIST::append(NMLmsg * nml_msg_ptr)
 {
+    NML_INTERP_LIST_NODE *node_ptr;
+
     /* check for invalid data */
     if (NULL == nml_msg_ptr) {
 	rcs_print_error
@@ -82,65 +117,60 @@ int NML_INTERP_LIST::append(NMLmsg * nml_msg_ptr)
 	    ("NML_INTERP_LIST::append : command size is invalid.");
 	return -1;
     }
-#ifdef DEBUG_INTERPL
-    if (sizeof(temp_node) < MAX_NML_COMMAND_SIZE + 4 ||
-	sizeof(temp_node) > MAX_NML_COMMAND_SIZE + 16 ||
-	((void *) &temp_node.line_number) >
-	((void *) &temp_node.command.commandbuf)) {
+
+    pthread_mutex_lock(&mutex);
+
+    if (count == ring_size && 0 != grow()) {
+	pthread_mutex_unlock(&mutex);
 	rcs_print_error
-	    ("NML_INTERP_LIST::append : assumptions about NML_INTERP_LIST_NODE have been violated.");
+	    ("NML_INTERP_LIST::append : can't grow list beyond %d commands.\n",
+	     ring_size);
 	return -1;
     }
-#endif
 
-    if (NULL == linked_list_ptr) {
-	return -1;
-    }
-    // fill in the NML_INTERP_LIST_NODE
-    temp_node.line_number = next_line_number;
-    memcpy(temp_node.command.commandbuf, nml_msg_ptr, nml_msg_ptr->size);
-
-    // stick it on the list
-    linked_list_ptr->store_at_tail(&temp_node,
-				   nml_msg_ptr->size +
-				   sizeof(temp_node.line_number) +
-				   sizeof(temp_node.dummy) + 32 + (32 -
-								   nml_msg_ptr->
-								   size %
-								   32), 1);
+    // fill in the NML_INTERP_LIST_NODE in the next free slot
+    node_ptr = &ring[(head + count) % ring_size];
+    node_ptr->line_number = next_line_number;
+    memcpy(node_ptr->command.commandbuf, nml_msg_ptr, nml_msg_ptr->size);
+    count++;
+    total++;
 
     if (emc_debug & EMC_DEBUG_INTERP_LIST) {
 	rcs_print
 	    ("NML_INTERP_LIST(%p)::append(nml_msg_ptr{size=%ld,type=%s}) : list_size=%d, line_number=%d\n",
              this,
 	     nml_msg_ptr->size, emc_symbol_lookup(nml_msg_ptr->type),
-	     linked_list_ptr->list_size, temp_node.line_number);
+	     count, node_ptr->line_number);
     }
 
+    pthread_mutex_unlock(&mutex);
     return 0;
 }
 
+// returns the oldest command, which stays valid until the next get()
 NMLmsg *NML_INTERP_LIST::get()
 {
     NMLmsg *ret;
     NML_INTERP_LIST_NODE *node_ptr;
 
-    if (NULL == linked_list_ptr) {
-	line_number = 0;
-	return NULL;
-    }
+    pthread_mutex_lock(&mutex);
 
-    node_ptr = (NML_INTERP_LIST_NODE *) linked_list_ptr->retrieve_head();
-
-    if (NULL == node_ptr) {
+    if (0 == count) {
 	line_number = 0;
+	pthread_mutex_unlock(&mutex);
 	return NULL;
     }
+    // copy it out of the ring, so the slot can be reused right away
+    node_ptr = &ring[head];
+    ret = (NMLmsg *) ((char *) node_ptr->command.commandbuf);
+    memcpy(retrieved.command.commandbuf, ret, ret->size);
+    head = (head + 1) % ring_size;
+    count--;
+
     // save line number of this one, for use by get_line_number
     line_number = node_ptr->line_number;
 
-    // get it off the front
-    ret = (NMLmsg *) ((char *) node_ptr->command.commandbuf);
+    ret = (NMLmsg *) ((char *) retrieved.command.commandbuf);
 
     if (emc_debug & EMC_DEBUG_INTERP_LIST) {
         rcs_print(
@@ -148,22 +178,38 @@ NMLmsg *NML_INTERP_LIST::get()
             this,
             ret->size,
             emc_symbol_lookup(ret->type),
-            linked_list_ptr->list_size
+            count
         );
     }
 
+    pthread_mutex_unlock(&mutex);
     return ret;
 }
 
-void NML_INTERP_LIST::clear()
+// returns the type of the command get() would return, 0 if none
+NMLTYPE NML_INTERP_LIST::peek_type()
 {
-    if (NULL != linked_list_ptr) {
-        if (emc_debug & EMC_DEBUG_INTERP_LIST) {
-            rcs_print("NML_INTERP_LIST(%p)::clear(): discarding %d items\n", this, linked_list_ptr->list_size);
-        }
+    NMLTYPE type = 0;
+
+    pthread_mutex_lock(&mutex);
+    if (count > 0) {
+	type = ((NMLmsg *) ring[head].command.commandbuf)->type;
+    }
+    pthread_mutex_unlock(&mutex);
 
-	linked_list_ptr->delete_members();
+    return type;
+}
+
+void NML_INTERP_LIST::clear()
+{
+    pthread_mutex_lock(&mutex);
+    if (emc_debug & EMC_DEBUG_INTERP_LIST) {
+        rcs_print("NML_INTERP_LIST(%p)::clear(): discarding %d items\n", this, count);
     }
+
+    head = 0;
+    count = 0;
+    pthread_mutex_unlock(&mutex);
 }
 
 void NML_INTERP_LIST::print()
@@ -172,30 +218,42 @@ void NML_INTERP_LIST::print()
     NML_INTERP_LIST_NODE *node_ptr;
     int line_number;
 
-    if (NULL == linked_list_ptr) {
-	return;
-    }
-    node_ptr = (NML_INTERP_LIST_NODE *) linked_list_ptr->get_head();
-
-    rcs_print("NML_INTERP_LIST::print(): list size=%d\n",linked_list_ptr->list_size);
-    while (NULL != node_ptr) {
+    pthread_mutex_lock(&mutex);
+    rcs_print("NML_INTERP_LIST::print(): list size=%d\n", count);
+    for (int i = 0; i < count; i++) {
+	node_ptr = &ring[(head + i) % ring_size];
 	line_number = node_ptr->line_number;
 	ret = (NMLmsg *) ((char *) node_ptr->command.commandbuf);
 	rcs_print("--> type=%s,  line_number=%d\n",
 		  emc_symbol_lookup((int)ret->type),
 		  line_number);
-	node_ptr = (NML_INTERP_LIST_NODE *) linked_list_ptr->get_next();
     }
+    pthread_mutex_unlock(&mutex);
     rcs_print("\n");
 }
 
 int NML_INTERP_LIST::len()
 {
-    if (NULL == linked_list_ptr) {
-	return 0;
-    }
+    int size;
+
+    pthread_mutex_lock(&mutex);
+    size = count;
+    pthread_mutex_unlock(&mutex);
+
+    return size;
+}
+
+// number of commands appended so far, including those already retrieved
+// or cleared; the interpreter's profiler counts canon calls with it
+long NML_INTERP_LIST::appended()
+{
+    long n;
+
+    pthread_mutex_lock(&mutex);
+    n = total;
+    pthread_mutex_unlock(&mutex);
 
-    return ((int) linked_list_ptr->list_size);
+    return n;
 }
 
 int NML_INTERP_LIST::get_line_number()
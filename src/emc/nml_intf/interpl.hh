@@ -18,6 +18,8 @@
 #define INTERP_LIST_HH
 
 #include <stdint.h>
+#include <pthread.h>
+#include "nml_type.hh"
 
 #define MAX_NML_COMMAND_SIZE 1000
 
@@ -44,7 +46,15 @@ struct NML_INTERP_LIST_NODE {
     } command;
 };
 
-// here's the interp list itself
+// initial number of slots in an NML_INTERP_LIST, doubled when full
+#define NML_INTERP_LIST_INITIAL_SIZE 64
+
+// here's the interp list itself; append(), get(), clear() and len() may
+// be called from different threads (interpreter readahead thread and task)
+//
+// Messages are kept in a ring of preallocated NML_INTERP_LIST_NODE
+// slots, so appending and retrieving does not touch the heap once the
+// ring has grown to the working size of the program.
 class NML_INTERP_LIST {
   public:
     NML_INTERP_LIST();
@@ -55,14 +65,23 @@ class NML_INTERP_LIST {
     int append(NMLmsg &);
     int append(NMLmsg *);
     NMLmsg *get();
+    NMLTYPE peek_type();
     void clear();
     void print();
     int len();
+    long appended();
 
   private:
-    class LinkedList * linked_list_ptr;
-    NML_INTERP_LIST_NODE temp_node;	// filled in and put on the list
-    int next_line_number;	// line number used to fill temp_node
+    int grow();
+
+    NML_INTERP_LIST_NODE *ring;	// slots, ring_size of them
+    int ring_size;
+    int head;			// index of the oldest node
+    int count;			// number of nodes in the ring
+    long total;			// nodes appended since construction
+    pthread_mutex_t mutex;	// serializes access to the ring
+    NML_INTERP_LIST_NODE retrieved;	// copy of the node from get()
+    int next_line_number;	// line number used for appended nodes
     int line_number;		// line number of node from get()
 };
 
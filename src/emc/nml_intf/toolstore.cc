@@ -0,0 +1,293 @@
+/********************************************************************
+* Description: toolstore.cc
+*
+*   The tool table, see toolstore.hh.
+*
+* Author: LinuxCNC developers
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 LinuxCNC developers
+********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "emc_nml.hh"
+#include "toolstore.hh"
+
+static CANON_TOOL_TABLE empty_tool()
+{
+    CANON_TOOL_TABLE t;
+
+    t.toolno = -1;
+    ZERO_EMC_POSE(t.offset);
+    t.diameter = 0.0;
+    t.frontangle = 0.0;
+    t.backangle = 0.0;
+    t.orientation = 0;
+    return t;
+}
+
+static const CANON_TOOL_TABLE no_tool = empty_tool();
+
+ToolStore::ToolStore() : random_toolchanger(0), serial(0), reloaded(false)
+{
+    reserve(0);
+}
+
+void ToolStore::reserve(int pocket)
+{
+    if (pocket < (int) table.size()) {
+	return;
+    }
+    table.resize(pocket + 1, no_tool);
+    fms_.resize(pocket + 1, 0);
+    comments.resize(pocket + 1);
+}
+
+void ToolStore::unindex(int pocket)
+{
+    std::unordered_map<int, std::set<int> >::iterator it =
+	pockets_of.find(table[pocket].toolno);
+
+    if (it == pockets_of.end()) {
+	return;
+    }
+    it->second.erase(pocket);
+    if (it->second.empty()) {
+	pockets_of.erase(it);
+    }
+}
+
+void ToolStore::index(int pocket)
+{
+    if (table[pocket].toolno != -1) {
+	pockets_of[table[pocket].toolno].insert(pocket);
+    }
+}
+
+void ToolStore::changed(int pocket)
+{
+    if (std::find(pending.begin(), pending.end(), pocket) == pending.end()) {
+	pending.push_back(pocket);
+    }
+}
+
+int ToolStore::load(const char *filename_, int random_toolchanger_)
+{
+    if (0 != loadToolTable(filename_, *this, random_toolchanger_)) {
+	return -1;
+    }
+    filename = filename_;
+    random_toolchanger = random_toolchanger_;
+
+    pockets_of.clear();
+    for (int pocket = 0; pocket < (int) table.size(); pocket++) {
+	index(pocket);
+    }
+    reloaded = true;
+    pending.clear();
+    return 0;
+}
+
+int ToolStore::save(const char *filename_, int random_toolchanger_)
+{
+    std::string tmp = std::string(filename_) + ".tmp";
+    FILE *fp;
+
+    if (NULL == (fp = fopen(tmp.c_str(), "w"))) {
+	return -1;
+    }
+    for (int pocket = random_toolchanger_? 0: 1;
+	 pocket < (int) table.size(); pocket++) {
+	const CANON_TOOL_TABLE &t = table[pocket];
+
+	if (t.toolno == -1) {
+	    continue;
+	}
+	fprintf(fp, "T%d P%d", t.toolno,
+		random_toolchanger_? pocket: fms_[pocket]);
+	if (t.diameter) fprintf(fp, " D%f", t.diameter);
+	if (t.offset.tran.x) fprintf(fp, " X%+f", t.offset.tran.x);
+	if (t.offset.tran.y) fprintf(fp, " Y%+f", t.offset.tran.y);
+	if (t.offset.tran.z) fprintf(fp, " Z%+f", t.offset.tran.z);
+	if (t.offset.a) fprintf(fp, " A%+f", t.offset.a);
+	if (t.offset.b) fprintf(fp, " B%+f", t.offset.b);
+	if (t.offset.c) fprintf(fp, " C%+f", t.offset.c);
+	if (t.offset.u) fprintf(fp, " U%+f", t.offset.u);
+	if (t.offset.v) fprintf(fp, " V%+f", t.offset.v);
+	if (t.offset.w) fprintf(fp, " W%+f", t.offset.w);
+	if (t.frontangle) fprintf(fp, " I%+f", t.frontangle);
+	if (t.backangle) fprintf(fp, " J%+f", t.backangle);
+	if (t.orientation) fprintf(fp, " Q%d", t.orientation);
+	fprintf(fp, " ;%s\n", comments[pocket].c_str());
+    }
+    if (0 != fclose(fp) || 0 != rename(tmp.c_str(), filename_)) {
+	remove(tmp.c_str());
+	return -1;
+    }
+    filename = filename_;
+    return 0;
+}
+
+const CANON_TOOL_TABLE &ToolStore::get(int pocket) const
+{
+    if (pocket < 0 || pocket >= (int) table.size()) {
+	return no_tool;
+    }
+    return table[pocket];
+}
+
+void ToolStore::set(int pocket, const CANON_TOOL_TABLE &entry)
+{
+    if (pocket < 0 || pocket >= CANON_POCKETS_MAX) {
+	return;
+    }
+    reserve(pocket);
+    unindex(pocket);
+    table[pocket] = entry;
+    index(pocket);
+    changed(pocket);
+}
+
+void ToolStore::swap(int pocket1, int pocket2)
+{
+    if (pocket1 < 0 || pocket1 >= CANON_POCKETS_MAX ||
+	pocket2 < 0 || pocket2 >= CANON_POCKETS_MAX) {
+	return;
+    }
+    reserve(std::max(pocket1, pocket2));
+    unindex(pocket1);
+    unindex(pocket2);
+    std::swap(table[pocket1], table[pocket2]);
+    std::swap(fms_[pocket1], fms_[pocket2]);
+    std::swap(comments[pocket1], comments[pocket2]);
+    index(pocket1);
+    index(pocket2);
+    changed(pocket1);
+    changed(pocket2);
+}
+
+int ToolStore::find(int toolno) const
+{
+    std::unordered_map<int, std::set<int> >::const_iterator it =
+	pockets_of.find(toolno);
+
+    if (it == pockets_of.end()) {
+	return -1;
+    }
+    // pocket 0, the spindle, sorts first
+    std::set<int>::const_iterator p = it->second.begin();
+    if (*p == 0 && it->second.size() > 1) {
+	++p;
+    }
+    return *p;
+}
+
+int ToolStore::fms(int pocket) const
+{
+    if (pocket < 0 || pocket >= (int) fms_.size()) {
+	return 0;
+    }
+    return fms_[pocket];
+}
+
+const char *ToolStore::comment(int pocket) const
+{
+    if (pocket < 0 || pocket >= (int) comments.size()) {
+	return "";
+    }
+    return comments[pocket].c_str();
+}
+
+void ToolStore::publish(EMC_TOOL_STAT &stat)
+{
+    if (!reloaded && pending.empty()) {
+	return;
+    }
+    stat.toolTableSerial = ++serial;
+    stat.randomToolchanger = random_toolchanger;
+    strncpy(stat.toolTableFile, filename.c_str(), LINELEN - 1);
+    stat.toolTableFile[LINELEN - 1] = '\0';
+    if (reloaded || pending.size() > EMC_TOOL_CHANGES_MAX) {
+	stat.changes = 0;
+    } else {
+	stat.changes = pending.size();
+	for (int i = 0; i < stat.changes; i++) {
+	    stat.changePocket[i] = pending[i];
+	    stat.changeTool[i] = table[pending[i]];
+	}
+    }
+    reloaded = false;
+    pending.clear();
+}
+
+int ToolStore::follow(const EMC_TOOL_STAT &stat)
+{
+    if (stat.toolTableSerial == serial) {
+	return 0;
+    }
+    if (stat.changes > 0 && stat.toolTableSerial == serial + 1) {
+	for (int i = 0; i < stat.changes && i < EMC_TOOL_CHANGES_MAX; i++) {
+	    set(stat.changePocket[i], stat.changeTool[i]);
+	}
+    } else if (0 != load(stat.toolTableFile, stat.randomToolchanger)) {
+	clear(0);
+	pockets_of.clear();
+    } else if (!random_toolchanger) {
+	// a nonrandom toolchanger's spindle isn't in the file
+	int pocket = find(stat.toolInSpindle);
+	CANON_TOOL_TABLE spindle = no_tool;
+
+	if (stat.toolInSpindle > 0 && pocket > 0) {
+	    spindle = table[pocket];
+	} else {
+	    spindle.toolno = 0;
+	}
+	set(0, spindle);
+    }
+    serial = stat.toolTableSerial;
+    reloaded = false;
+    pending.clear();
+    return 1;
+}
+
+int ToolStore::pockets_max()
+{
+    return CANON_POCKETS_MAX;
+}
+
+void ToolStore::clear(int first)
+{
+    int n = std::max(first, 1);
+
+    reserve(n - 1);
+    table.resize(n);
+    fms_.resize(n);
+    comments.resize(n);
+    if (first == 0) {
+	table[0] = no_tool;
+	fms_[0] = 0;
+	comments[0].clear();
+    }
+}
+
+CANON_TOOL_TABLE &ToolStore::tool(int pocket)
+{
+    reserve(pocket);
+    return table[pocket];
+}
+
+void ToolStore::set_fms(int pocket, int fms)
+{
+    reserve(pocket);
+    fms_[pocket] = fms;
+}
+
+void ToolStore::set_comment(int pocket, const char *comment)
+{
+    reserve(pocket);
+    comments[pocket] = comment;
+}
@@ -0,0 +1,93 @@
+/********************************************************************
+* Description: toolstore.hh
+*
+*   The tool table, sized to the file it is loaded from and indexed
+*   by tool number.
+*
+*   iocontrol owns the table: it loads and saves the file and makes
+*   every change through a ToolStore, then publish()es the store into
+*   its EMC_TOOL_STAT.  The status message does not carry the table,
+*   only a serial number and the pockets changed by the last serial.
+*   Task, halui and the GUIs keep their own ToolStore and follow() the
+*   status: a follower one serial behind applies the changed pockets,
+*   one further behind (or after a table load) reloads the file named
+*   in the status.
+*
+* Author: LinuxCNC developers
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 LinuxCNC developers
+********************************************************************/
+#ifndef TOOLSTORE_HH
+#define TOOLSTORE_HH
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "emctool.h"
+#include "tool_parse.h"
+
+class EMC_TOOL_STAT;
+
+class ToolStore : public ToolTableSink {
+public:
+    ToolStore();
+
+    /* Read filename, replacing the table (pocket 0 too for a random
+       toolchanger).  Returns 0, or -1 if the file can't be opened. */
+    int load(const char *filename, int random_toolchanger);
+    /* Write the table to filename, in the format load() reads.  The
+       file is replaced in one step, so followers never see half of it,
+       and is the one they reload from from now on.  Returns 0, or -1
+       on error. */
+    int save(const char *filename, int random_toolchanger);
+
+    /* 1 + the highest pocket in the table */
+    int pockets() const { return table.size(); }
+    /* the entry for pocket, an empty one (toolno -1) if out of range */
+    const CANON_TOOL_TABLE &get(int pocket) const;
+    void set(int pocket, const CANON_TOOL_TABLE &entry);
+    void swap(int pocket1, int pocket2);
+    /* The pocket holding toolno: the lowest one above 0, else 0 if the
+       tool is only in the spindle, else -1. */
+    int find(int toolno) const;
+    /* the P word the tool in pocket was read with (nonrandom toolchanger) */
+    int fms(int pocket) const;
+    const char *comment(int pocket) const;
+
+    /* Owner: put the changes since the last publish() into stat. */
+    void publish(EMC_TOOL_STAT &stat);
+    /* Follower: bring the table up to date with stat.  Returns 1 if
+       it changed, 0 if not. */
+    int follow(const EMC_TOOL_STAT &stat);
+
+    // ToolTableSink, for loadToolTable
+    int pockets_max();
+    void clear(int first);
+    CANON_TOOL_TABLE &tool(int pocket);
+    void set_fms(int pocket, int fms);
+    void set_comment(int pocket, const char *comment);
+
+private:
+    void reserve(int pocket);
+    void unindex(int pocket);
+    void index(int pocket);
+    void changed(int pocket);
+
+    std::vector<CANON_TOOL_TABLE> table;
+    std::vector<int> fms_;
+    std::vector<std::string> comments;
+    /* tool number -> the pockets holding it; empty pockets aren't in it */
+    std::unordered_map<int, std::set<int> > pockets_of;
+
+    std::string filename;
+    int random_toolchanger;
+    int serial;
+    bool reloaded;			/* since the last publish() */
+    std::vector<int> pending;		/* pockets changed since then */
+};
+
+#endif				/* TOOLSTORE_HH */
@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <time.h>
 
 #define BOOST_PYTHON_MAX_ARITY 4
 #include <boost/python/exec.hpp>
@@ -63,6 +64,8 @@ bp::object working_execfile(const char *filename, bp::object globals, bp::object
 int PythonPlugin::run_string(const char *cmd, bp::object &retval, bool as_file)
 {
     reload();
+    callables.clear();    // cmd may bind new names
+    generation++;
     try {
 	if (as_file)
 	    retval = working_execfile(cmd, main_namespace, main_namespace);
@@ -116,8 +119,15 @@ int PythonPlugin::call_method(bp::object method, bp::object &retval)
 int PythonPlugin::call(const char *module, const char *callable,
 		       bp::object tupleargs, bp::object kwargs, bp::object &retval)
 {
-    bp::object function;
+    python_callable cached;
+
+    return call(module, callable, cached, tupleargs, kwargs, retval);
+}
 
+int PythonPlugin::call(const char *module, const char *callable,
+		       python_callable &cached,
+		       bp::object tupleargs, bp::object kwargs, bp::object &retval)
+{
     if (callable == NULL)
 	return PLUGIN_NO_CALLABLE;
 
@@ -127,12 +137,14 @@ int PythonPlugin::call(const char *module, const char *callable,
 	return status;
 
     try {
-	if (module == NULL) {  // default to function in toplevel module
-	    function = main_namespace[callable];
-	} else {
-	    bp::object submod =  main_namespace[module];
-	    bp::object submod_namespace = submod.attr("__dict__");
-	    function = submod_namespace[callable];
+	if (cached.generation != generation) {
+	    cached.function = lookup(module, callable);
+	    cached.generation = generation;
+	}
+	bp::object function = cached.function;
+	if (function.ptr() == Py_None) {
+	    PyErr_SetString(PyExc_KeyError, callable);
+	    bp::throw_error_already_set();
 	}
 	// this wont work with boost-python1.34 - needs 1.40
 	//retval = function(*tupleargs, **kwargs);
@@ -178,22 +190,13 @@ bool PythonPlugin::is_callable(const char *module,
 	return false;
     }
     try {
-	if (module == NULL) {  // default to function in toplevel module
-	   function = main_namespace[funcname];
-	} else {
-	    bp::object submod =  main_namespace[module];
-	    bp::object submod_namespace = submod.attr("__dict__");
-	    function = submod_namespace[funcname];
-	}
-	result = PyCallable_Check(function.ptr());
+	function = lookup(module, funcname);
+	result = (function.ptr() != Py_None) && PyCallable_Check(function.ptr());
     }
     catch (bp::error_already_set) {
-	// KeyError expected if not callable
-	if (!PyErr_ExceptionMatches(PyExc_KeyError)) {
-	    // something else, strange
-	    exception_msg = handle_pyerror();
-	    unexpected = true;
-	}
+	// something else than the KeyError lookup() expects, strange
+	exception_msg = handle_pyerror();
+	unexpected = true;
 	result = false;
 	PyErr_Clear();
     }
@@ -209,6 +212,36 @@ bool PythonPlugin::is_callable(const char *module,
     return result;
 }
 
+// The object named [module.]funcname, or None if there is none.
+// Remaps and O-word subs look up the same few names on every call, so
+// the answers are kept until the namespace may have changed: on
+// initialize() and run_string().
+bp::object PythonPlugin::lookup(const char *module, const char *funcname)
+{
+    std::string key = module ? std::string(module) + "." + funcname : funcname;
+    std::map<std::string, bp::object>::iterator it = callables.find(key);
+    if (it != callables.end())
+	return it->second;
+
+    bp::object function;
+    try {
+	if (module == NULL) {  // default to function in toplevel module
+	   function = main_namespace[funcname];
+	} else {
+	    bp::object submod =  main_namespace[module];
+	    bp::object submod_namespace = submod.attr("__dict__");
+	    function = submod_namespace[funcname];
+	}
+    }
+    catch (bp::error_already_set) {
+	if (!PyErr_ExceptionMatches(PyExc_KeyError))
+	    throw;
+	PyErr_Clear();
+    }
+    callables[key] = function;
+    return function;
+}
+
 // this should be moved to an inotify-based solution and be done with it
 int PythonPlugin::reload()
 {
@@ -216,6 +249,14 @@ int PythonPlugin::reload()
     if (!reload_on_change)
 	return PLUGIN_OK;
 
+    // st_mtime has a resolution of a second, so look at most once a second
+    time_t now = time(NULL);
+    if ((now < next_check) && (status != PLUGIN_STAT_FAILED)) {
+	status = PLUGIN_OK;
+	return status;
+    }
+    next_check = now + 1;
+
     if (stat(abs_path, &st)) {
 	logPP(0, "reload: stat(%s) returned %s", abs_path, strerror(errno));
 	status = PLUGIN_STAT_FAILED;
@@ -256,6 +297,8 @@ std::string handle_pyerror()
 int PythonPlugin::initialize()
 {
     std::string msg;
+    callables.clear();
+    generation++;
     if (Py_IsInitialized()) {
 	try {
 	    bp::object module = bp::import("__main__");
@@ -291,8 +334,10 @@ int PythonPlugin::initialize()
 }
 
 PythonPlugin::PythonPlugin(struct _inittab *inittab) :
+    generation(1),
     status(0),
     module_mtime(0),
+    next_check(0),
     reload_on_change(0),
     toplevel(0),
     abs_path(0),
@@ -26,6 +26,7 @@
 
 #include <vector>
 #include <string>
+#include <map>
 #include <sys/types.h>
 
 
@@ -56,6 +57,15 @@ enum pp_status   {
     PLUGIN_EXCEPTION = 2
 };
 
+// [module.]funcname as last looked up by PythonPlugin::call(), kept by
+// the caller so a handler called over and over is not looked up by name
+// each time; it is looked up again once the namespace may have changed
+struct python_callable {
+    python_callable() : generation(0) {}
+    boost::python::object function;
+    unsigned generation;                  // plugin's when it was looked up
+};
+
 class PythonPlugin {
 public:
     // factory method
@@ -64,6 +74,8 @@ public:
     bool is_callable(const char *module, const char *funcname);
     int call(const char *module,const char *callable,
 	     boost::python::object tupleargs, boost::python::object kwargs, boost::python::object &retval);
+    int call(const char *module, const char *callable, python_callable &cached,
+	     boost::python::object tupleargs, boost::python::object kwargs, boost::python::object &retval);
     int run_string(const char *cmd, boost::python::object &retval, bool as_file = false);
     int call_method(boost::python::object method, boost::python::object &retval);
 
@@ -81,9 +93,14 @@ private:
     ~PythonPlugin() {};
 
     int reload();
+    boost::python::object lookup(const char *module, const char *funcname);
     std::vector<std::string> inittab_entries;
+    // [module.]funcname resolved by lookup(), None if there is none
+    std::map<std::string, boost::python::object> callables;
+    unsigned generation;                  // bumped whenever callables is cleared
     int status;
     time_t module_mtime;                  // toplevel module - last modification time
+    time_t next_check;                    // no stat() of it before this
     bool reload_on_change;                // auto-reload if toplevel module was changed
     const char *toplevel;          // toplevel script
     //    const char *plugin_dir;               // directory prefix
@@ -18,6 +18,13 @@
 
 #include <Python.h>
 #include <structmember.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
 
 #include "rs274ngc.hh"
 #include "rs274ngc_interp.hh"
@@ -141,13 +148,35 @@ static PyObject *callback;
 static int interp_error;
 static int last_sequence_number;
 static bool metric;
+static int plane;
 static double _pos_x, _pos_y, _pos_z, _pos_a, _pos_b, _pos_c, _pos_u, _pos_v, _pos_w;
 EmcPose tool_offset;
 
 static InterpBase *pinterp;
 #define interp_new (*pinterp)
 
-#define callmethod(o, m, f, ...) PyObject_CallMethod((o), (char*)(m), (char*)(f), ## __VA_ARGS__)
+// In a preview worker (see parse_parallel) the calls to the callback are
+// written to canon_record, or dropped while the worker brings the
+// interpreter to the state at the start of its chunk.
+enum { CANON_CALLBACK, CANON_RECORD, CANON_DISCARD };
+static int canon_output = CANON_CALLBACK;
+static FILE *canon_record;
+
+// The callback's answers to the interpreter's queries, asked by the
+// parent before it starts the workers
+static struct {
+    bool block_delete;
+    double length_units, angle_units;
+    int pockets_max, axis_mask;
+    std::vector<CANON_TOOL_TABLE> tools;
+} worker_query;
+
+static PyObject *record_call(const char *m, const char *f, ...);
+
+#define callmethod(o, m, f, ...) \
+    (canon_output == CANON_CALLBACK ? \
+        PyObject_CallMethod((o), (char*)(m), (char*)(f), ## __VA_ARGS__) : \
+        record_call((m), (f), ## __VA_ARGS__))
 
 static void maybe_new_line(int sequence_number=interp_new.sequence_number());
 static void maybe_new_line(int sequence_number) {
@@ -155,8 +184,10 @@ static void maybe_new_line(int sequence_number) {
     if(interp_error) return;
     if(sequence_number == last_sequence_number)
         return;
-    LineCode *new_line_code =
-        (LineCode*)(PyObject_New(LineCode, &LineCodeType));
+    LineCode recorded_line_code;
+    LineCode *new_line_code = canon_output == CANON_CALLBACK ?
+        (LineCode*)(PyObject_New(LineCode, &LineCodeType)) :
+        &recorded_line_code;
     interp_new.active_settings(new_line_code->settings);
     interp_new.active_g_codes(new_line_code->gcodes);
     interp_new.active_m_codes(new_line_code->mcodes);
@@ -164,7 +195,7 @@ static void maybe_new_line(int sequence_number) {
     last_sequence_number = sequence_number;
     PyObject *result = 
         callmethod(callback, "next_line", "O", new_line_code);
-    Py_DECREF(new_line_code);
+    if(new_line_code != &recorded_line_code) Py_DECREF(new_line_code);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
 }
@@ -192,7 +223,16 @@ void ARC_FEED(int line_number,
               double second_axis, int rotation, double axis_end_point,
               double a_position, double b_position, double c_position,
               double u_position, double v_position, double w_position) {
-    // XXX: set _pos_*
+    switch(plane) {
+    case CANON_PLANE_XY:
+        _pos_x=first_end; _pos_y=second_end; _pos_z=axis_end_point; break;
+    case CANON_PLANE_YZ:
+        _pos_y=first_end; _pos_z=second_end; _pos_x=axis_end_point; break;
+    case CANON_PLANE_XZ:
+        _pos_z=first_end; _pos_x=second_end; _pos_y=axis_end_point; break;
+    }
+    _pos_a=a_position; _pos_b=b_position; _pos_c=c_position;
+    _pos_u=u_position; _pos_v=v_position; _pos_w=w_position;
     if(metric) {
         first_end /= 25.4;
         second_end /= 25.4;
@@ -288,6 +328,7 @@ void SET_XY_ROTATION(double t) {
 void USE_LENGTH_UNITS(CANON_UNITS u) { metric = u == CANON_UNITS_MM; }
 
 void SELECT_PLANE(CANON_PLANE pl) {
+    plane = pl;
     maybe_new_line();   
     if(interp_error) return;
     PyObject *result =
@@ -422,6 +463,7 @@ int  GET_EXTERNAL_TC_REASON() {return 0;}
 extern bool GET_BLOCK_DELETE(void) { 
     int bd = 0;
     if(interp_error) return 0;
+    if(canon_output != CANON_CALLBACK) return worker_query.block_delete;
     PyObject *result =
         callmethod(callback, "get_block_delete", "");
     if(result == NULL) {
@@ -529,6 +571,9 @@ int GET_EXTERNAL_LENGTH_UNIT_TYPE() { return CANON_UNITS_INCHES; }
 CANON_TOOL_TABLE GET_EXTERNAL_TOOL_TABLE(int pocket) {
     CANON_TOOL_TABLE t = {-1,{{0,0,0},0,0,0,0,0,0},0,0,0,0};
     if(interp_error) return t;
+    if(canon_output != CANON_CALLBACK)
+        return pocket >= 0 && pocket < (int)worker_query.tools.size() ?
+            worker_query.tools[pocket] : t;
     PyObject *result =
         callmethod(callback, "get_tool", "i", pocket);
     if(result == NULL ||
@@ -566,7 +611,21 @@ int GET_EXTERNAL_FLOOD() { return 0; }
 int GET_EXTERNAL_MIST() { return 0; }
 CANON_PLANE GET_EXTERNAL_PLANE() { return 1; }
 double GET_EXTERNAL_SPEED() { return 0; }
-int GET_EXTERNAL_POCKETS_MAX() { return CANON_POCKETS_MAX; }
+int GET_EXTERNAL_POCKETS_MAX() {
+    // the callback can say how big its tool table is, to save the
+    // interpreter asking for pockets that aren't there
+    if(canon_output != CANON_CALLBACK) return worker_query.pockets_max;
+    if(interp_error || !PyObject_HasAttrString(callback, "get_pockets_max"))
+        return CANON_POCKETS_MAX;
+    PyObject *result =
+        callmethod(callback, "get_pockets_max", "");
+    if(!result) { interp_error ++; return CANON_POCKETS_MAX; }
+    if(!PyInt_Check(result)) { interp_error ++; Py_DECREF(result); return CANON_POCKETS_MAX; }
+    int pockets = PyInt_AsLong(result);
+    Py_DECREF(result);
+    if(pockets < 1 || pockets > CANON_POCKETS_MAX) return CANON_POCKETS_MAX;
+    return pockets;
+}
 void DISABLE_ADAPTIVE_FEED() {} 
 void ENABLE_ADAPTIVE_FEED() {} 
 
@@ -575,8 +634,12 @@ int GET_EXTERNAL_SPINDLE_OVERRIDE_ENABLE() {return 1;}
 int GET_EXTERNAL_ADAPTIVE_FEED_ENABLE() {return 0;}
 int GET_EXTERNAL_FEED_HOLD_ENABLE() {return 1;}
 
+// the preview is never profiled, see parse_file()
+long GET_EXTERNAL_CANON_COUNT() { return 0; }
+
 int GET_EXTERNAL_AXIS_MASK() {
     if(interp_error) return 7;
+    if(canon_output != CANON_CALLBACK) return worker_query.axis_mask;
     PyObject *result =
         callmethod(callback, "get_axis_mask", "");
     if(!result) { interp_error ++; return 7 /* XYZABC */; }
@@ -629,6 +692,7 @@ static bool PyFloat_CheckAndError(const char *func, PyObject *p)  {
 }
 
 double GET_EXTERNAL_ANGLE_UNITS() {
+    if(canon_output != CANON_CALLBACK) return worker_query.angle_units;
     PyObject *result =
         callmethod(callback, "get_external_angular_units", "");
     if(result == NULL) interp_error++;
@@ -644,6 +708,7 @@ double GET_EXTERNAL_ANGLE_UNITS() {
 }
 
 double GET_EXTERNAL_LENGTH_UNITS() {
+    if(canon_output != CANON_CALLBACK) return worker_query.length_units;
     PyObject *result =
         callmethod(callback, "get_external_length_units", "");
     if(result == NULL) interp_error++;
@@ -681,6 +746,730 @@ CANON_MOTION_MODE GET_EXTERNAL_MOTION_CONTROL_MODE() { return motion_mode; }
 void SET_NAIVECAM_TOLERANCE(double tolerance) { }
 
 #define RESULT_OK (result == INTERP_OK || result == INTERP_EXECUTE_FINISH)
+
+/* Parallel preview
+
+   A long program is split into chunks of lines, one per job, and each
+   chunk is interpreted by a worker process forked from this one after
+   the init codes.  Processes rather than threads, because the
+   interpreter and the canon above keep their state in globals.
+
+   A worker first brings its interpreter to the state at the start of
+   its chunk, found by a prescan of the lines before it: it runs the
+   "complex" lines, and for each run of "simple" lines between them
+   (nothing but a G0..G3 motion, axis words, IJKR, F and S) one block
+   setting their last feed, speed, position and motion mode.  It then
+   interprets its chunk, recording the calls to the callback in a file
+   instead of making them.
+
+   That state is only a guess, so it is checked: the parent replays the
+   chunks in order, and takes a worker's chunk only if the checkpoint
+   of the state it started from is the one the previous chunk ended in.
+   If not, the worker of the previous chunk goes on with this one.
+   Either way the callback sees the calls of the serial parse, in the
+   same order.
+
+   The prescan leaves to the serial parse the programs it cannot split:
+   O-words, M98/M99, assignments of named parameters, cutter
+   compensation, NURBS and G91. */
+
+#define PREVIEW_MIN_LINES 100000	// shorter programs are parsed serially
+#define PREVIEW_MAX_JOBS 16
+
+static PyObject *record_call(const char *m, const char *f, ...) {
+    va_list ap;
+    unsigned char len;
+
+    if(canon_output == CANON_DISCARD) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    va_start(ap, f);
+    len = strlen(m); fwrite(&len, 1, 1, canon_record); fwrite(m, 1, len, canon_record);
+    len = strlen(f); fwrite(&len, 1, 1, canon_record); fwrite(f, 1, len, canon_record);
+    for(; *f; f++) {
+        switch(*f) {
+        case 'f': case 'd': {
+            double d = va_arg(ap, double);
+            fwrite(&d, sizeof(d), 1, canon_record);
+            break;
+        }
+        case 'i': {
+            int i = va_arg(ap, int);
+            fwrite(&i, sizeof(i), 1, canon_record);
+            break;
+        }
+        case 's': {
+            const char *s = va_arg(ap, const char *);
+            int n = s ? strlen(s) : -1;
+            fwrite(&n, sizeof(n), 1, canon_record);
+            if(s) fwrite(s, 1, n, canon_record);
+            break;
+        }
+        case 'O': {		// only next_line's LineCode
+            LineCode *l = va_arg(ap, LineCode *);
+            fwrite(l->settings, sizeof(l->settings), 1, canon_record);
+            fwrite(l->gcodes, sizeof(l->gcodes), 1, canon_record);
+            fwrite(l->mcodes, sizeof(l->mcodes), 1, canon_record);
+            break;
+        }
+        }
+    }
+    va_end(ap);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// Reads a range of a worker's record file, which the worker may still
+// be appending to
+struct preview_reader {
+    int fd;
+    long pos, end;
+    char buf[65536];
+    size_t head, tail;
+
+    preview_reader(int fd_, long pos_, long end_)
+        : fd(fd_), pos(pos_), end(end_), head(0), tail(0) {}
+
+    bool get(void *data, size_t n) {
+        char *p = (char *)data;
+        while(n) {
+            if(head == tail) {
+                long want = std::min((long)sizeof(buf), end - pos);
+                if(want <= 0) return false;
+                ssize_t r = pread(fd, buf, want, pos);
+                if(r <= 0) return false;
+                pos += r; head = 0; tail = r;
+            }
+            size_t c = std::min(n, tail - head);
+            memcpy(p, buf + head, c);
+            head += c; p += c; n -= c;
+        }
+        return true;
+    }
+
+    bool done() { return head == tail && pos >= end; }
+};
+
+// Makes one recorded call to the callback.  Returns false if it fails
+// (interp_error is set) or the record is cut short.
+static bool replay_call(preview_reader &r) {
+    char m[256], f[256];
+    unsigned char len;
+
+    if(!r.get(&len, 1) || !r.get(m, len)) return false;
+    m[len] = 0;
+    if(!r.get(&len, 1) || !r.get(f, len)) return false;
+    f[len] = 0;
+
+    PyObject *args = PyTuple_New(len);
+    for(int i = 0; i < len; i++) {
+        PyObject *item = 0;
+        switch(f[i]) {
+        case 'f': case 'd': {
+            double d;
+            if(r.get(&d, sizeof(d))) item = PyFloat_FromDouble(d);
+            break;
+        }
+        case 'i': {
+            int n;
+            if(r.get(&n, sizeof(n))) item = PyInt_FromLong(n);
+            break;
+        }
+        case 's': {
+            int n;
+            if(!r.get(&n, sizeof(n))) break;
+            if(n < 0) { Py_INCREF(Py_None); item = Py_None; break; }
+            std::string s(n, 0);
+            if(r.get(&s[0], n)) item = PyString_FromStringAndSize(s.data(), n);
+            break;
+        }
+        case 'O': {
+            LineCode *l = (LineCode*)(PyObject_New(LineCode, &LineCodeType));
+            if(r.get(l->settings, sizeof(l->settings))
+                    && r.get(l->gcodes, sizeof(l->gcodes))
+                    && r.get(l->mcodes, sizeof(l->mcodes))) {
+                last_sequence_number = l->gcodes[0];
+                item = (PyObject*)l;
+            } else {
+                Py_DECREF(l);
+            }
+            break;
+        }
+        }
+        if(!item) {
+            Py_DECREF(args);
+            PyErr_Format(PyExc_RuntimeError, "preview worker record cut short");
+            interp_error ++;
+            return false;
+        }
+        PyTuple_SET_ITEM(args, i, item);
+    }
+
+    PyObject *func = PyObject_GetAttrString(callback, m);
+    PyObject *result = func ? PyObject_CallObject(func, args) : NULL;
+    Py_XDECREF(func);
+    Py_DECREF(args);
+    if(result == NULL) interp_error ++;
+    Py_XDECREF(result);
+    return result != NULL;
+}
+
+template<class T> static void checkpoint_put(std::string &c, const T &v) {
+    c.append((const char *)&v, sizeof(v));
+}
+
+// Everything the rest of the program's preview may depend on, but the
+// call stack and O-word state, which the prescan keeps out of chunked
+// programs
+static std::string checkpoint(Interp *interp) {
+    setup &s = interp->_setup;
+    std::string c;
+
+    checkpoint_put(c, s.AA_axis_offset); checkpoint_put(c, s.AA_current);
+    checkpoint_put(c, s.AA_origin_offset); checkpoint_put(c, s.BB_axis_offset);
+    checkpoint_put(c, s.BB_current); checkpoint_put(c, s.BB_origin_offset);
+    checkpoint_put(c, s.CC_axis_offset); checkpoint_put(c, s.CC_current);
+    checkpoint_put(c, s.CC_origin_offset);
+    checkpoint_put(c, s.u_axis_offset); checkpoint_put(c, s.u_current);
+    checkpoint_put(c, s.u_origin_offset); checkpoint_put(c, s.v_axis_offset);
+    checkpoint_put(c, s.v_current); checkpoint_put(c, s.v_origin_offset);
+    checkpoint_put(c, s.w_axis_offset); checkpoint_put(c, s.w_current);
+    checkpoint_put(c, s.w_origin_offset);
+    // element 0 of the active code arrays is the line number
+    for(int i = 1; i < ACTIVE_G_CODES; i++) checkpoint_put(c, s.active_g_codes[i]);
+    for(int i = 1; i < ACTIVE_M_CODES; i++) checkpoint_put(c, s.active_m_codes[i]);
+    for(int i = 1; i < ACTIVE_SETTINGS; i++) checkpoint_put(c, s.active_settings[i]);
+    checkpoint_put(c, s.arc_not_allowed);
+    checkpoint_put(c, s.axis_offset_x); checkpoint_put(c, s.axis_offset_y);
+    checkpoint_put(c, s.axis_offset_z); checkpoint_put(c, s.control_mode);
+    checkpoint_put(c, s.current_pocket); checkpoint_put(c, s.current_x);
+    checkpoint_put(c, s.current_y); checkpoint_put(c, s.current_z);
+    checkpoint_put(c, s.cutter_comp_radius);
+    checkpoint_put(c, s.cutter_comp_orientation);
+    checkpoint_put(c, s.cutter_comp_side); checkpoint_put(c, s.cycle_cc);
+    checkpoint_put(c, s.cycle_i); checkpoint_put(c, s.cycle_j);
+    checkpoint_put(c, s.cycle_k); checkpoint_put(c, s.cycle_l);
+    checkpoint_put(c, s.cycle_p); checkpoint_put(c, s.cycle_q);
+    checkpoint_put(c, s.cycle_r); checkpoint_put(c, s.cycle_il);
+    checkpoint_put(c, s.cycle_il_flag); checkpoint_put(c, s.distance_mode);
+    checkpoint_put(c, s.ijk_distance_mode); checkpoint_put(c, s.feed_mode);
+    checkpoint_put(c, s.feed_override); checkpoint_put(c, s.feed_rate);
+    checkpoint_put(c, s.flood); checkpoint_put(c, s.length_units);
+    checkpoint_put(c, s.mist); checkpoint_put(c, s.motion_mode);
+    checkpoint_put(c, s.origin_index); checkpoint_put(c, s.origin_offset_x);
+    checkpoint_put(c, s.origin_offset_y); checkpoint_put(c, s.origin_offset_z);
+    checkpoint_put(c, s.rotation_xy);
+    // read() sets #5420-#5428 from current_x etc. before each line
+    for(int i = 0; i < RS274NGC_MAX_PARAMETERS; i++)
+        if(i < 5420 || i > 5428) checkpoint_put(c, s.parameters[i]);
+    checkpoint_put(c, s.plane); checkpoint_put(c, s.probe_flag);
+    checkpoint_put(c, s.input_flag); checkpoint_put(c, s.toolchange_flag);
+    checkpoint_put(c, s.cutter_comp_firstmove); checkpoint_put(c, s.program_x);
+    checkpoint_put(c, s.program_y); checkpoint_put(c, s.program_z);
+    checkpoint_put(c, s.retract_mode); checkpoint_put(c, s.selected_pocket);
+    checkpoint_put(c, s.selected_tool); checkpoint_put(c, s.speed);
+    checkpoint_put(c, s.spindle_mode); checkpoint_put(c, s.speed_feed_mode);
+    checkpoint_put(c, s.speed_override); checkpoint_put(c, s.spindle_turning);
+    checkpoint_put(c, s.tool_offset); checkpoint_put(c, s.traverse_rate);
+    checkpoint_put(c, s.adaptive_feed); checkpoint_put(c, s.feed_hold);
+    checkpoint_put(c, s.lathe_diameter_mode);
+    for(size_t i = 0; i < s.tool_table.size(); i++) {
+        checkpoint_put(c, s.tool_table[i].toolno);
+        checkpoint_put(c, s.tool_table[i].offset);
+        checkpoint_put(c, s.tool_table[i].diameter);
+        checkpoint_put(c, s.tool_table[i].frontangle);
+        checkpoint_put(c, s.tool_table[i].backangle);
+        checkpoint_put(c, s.tool_table[i].orientation);
+    }
+
+    // and this module's canon
+    checkpoint_put(c, metric); checkpoint_put(c, plane);
+    checkpoint_put(c, _pos_x); checkpoint_put(c, _pos_y); checkpoint_put(c, _pos_z);
+    checkpoint_put(c, _pos_a); checkpoint_put(c, _pos_b); checkpoint_put(c, _pos_c);
+    checkpoint_put(c, _pos_u); checkpoint_put(c, _pos_v); checkpoint_put(c, _pos_w);
+    checkpoint_put(c, tool_offset); checkpoint_put(c, motion_mode);
+    return c;
+}
+
+enum { PREVIEW_BLANK, PREVIEW_SIMPLE, PREVIEW_COMPLEX, PREVIEW_SERIAL,
+    PREVIEW_PERCENT };
+
+#define PREVIEW_KEEP_MOTION -1		// after a step, the motion it set
+#define PREVIEW_RESTORE_MOTION -2	// the motion from before the step
+
+static const char preview_words[] = "xyzabcuvwfs";
+
+// The words of the simple lines since the last complex line
+struct preview_simple {
+    std::string word[sizeof(preview_words) - 1];
+    int motion;
+
+    preview_simple() : motion(-1) {}
+};
+
+// A block run to bring a worker's interpreter to the start of its chunk
+struct preview_step {
+    std::string block;
+    int motion;
+
+    preview_step(const std::string &b, int m) : block(b), motion(m) {}
+};
+
+struct preview_chunk {
+    long offset;		// in the file, of its first line
+    int start;			// sequence number before its first line
+    size_t steps;		// prescan steps before it
+    std::vector<preview_step> tail;	// and for the simple lines before it
+};
+
+// The G or M code number at p, times ten.  Not strtod, which would read
+// "g0x1" as hex.
+static int preview_code(const char *p) {
+    char number[32];
+    size_t n = 0;
+
+    while((isdigit(*p) || *p == '.') && n < sizeof(number) - 1)
+        number[n++] = *p++;
+    number[n] = 0;
+    return lround(atof(number) * 10);
+}
+
+// Strips comments and blanks from the line and sorts it.  Simple lines'
+// words are added to *simple; tool changes set *tool_change.
+static int preview_classify(const char *raw, preview_simple *simple,
+        bool *tool_change) {
+    char line[LINELEN];
+    int n = 0, comment = 0;
+    bool complex = false;
+
+    for(const char *p = raw; *p; p++) {
+        if(comment) { if(*p == ')') comment = 0; }
+        else if(*p == '(') comment = 1;
+        else if(*p == ';') break;
+        else if(!isspace(*p)) line[n++] = tolower(*p);
+    }
+    line[n] = 0;
+
+    const char *p = line;
+    if(!*p) return PREVIEW_BLANK;
+    if(!strcmp(p, "%")) return PREVIEW_PERCENT;
+    if(*p == '/') { complex = true; p++; }
+    if(*p == 'n') { p++; while(isdigit(*p)) p++; }
+    if(*p == 'o') return PREVIEW_SERIAL;
+
+    // G and M codes and named parameter assignments anywhere, also after
+    // expressions, which are not split into words below
+    for(const char *q = p; *q; q++) {
+        if(*q == '<') {
+            q = strchr(q, '>');
+            if(!q) return PREVIEW_SERIAL;
+            if(q[1] == '=') return PREVIEW_SERIAL;
+        } else if((*q == 'g' || *q == 'm') && (isdigit(q[1]) || q[1] == '.')) {
+            int code = preview_code(q + 1);
+            if(*q == 'g' && (code == 52 || code == 410 || code == 411
+                        || code == 420 || code == 421 || code == 910))
+                return PREVIEW_SERIAL;
+            if(*q == 'm' && (code == 980 || code == 990))
+                return PREVIEW_SERIAL;
+            if(*q == 'm' && (code == 60 || code == 610))
+                *tool_change = true;
+        }
+    }
+
+    preview_simple words;
+    while(*p && !complex) {
+        char letter = *p++;
+        const char *number = p;
+        if(*p == '+' || *p == '-') p++;
+        while(isdigit(*p) || *p == '.') p++;
+        if(!isalpha(letter) || p == number || (p == number + 1 && !isdigit(*number))) {
+            complex = true;
+            break;
+        }
+        const char *w = strchr(preview_words, letter);
+        if(w) {
+            words.word[w - preview_words].assign(number, p - number);
+        } else if(letter == 'g') {
+            int code = preview_code(number);
+            if(words.motion == -1 && (code == G_0 || code == G_1
+                        || code == G_2 || code == G_3))
+                words.motion = code;
+            else
+                complex = true;
+        } else if(!strchr("nijkr", letter)) {
+            complex = true;
+        }
+    }
+    if(complex) return PREVIEW_COMPLEX;
+
+    for(size_t i = 0; i < sizeof(preview_words) - 1; i++)
+        if(!words.word[i].empty()) simple->word[i] = words.word[i];
+    if(words.motion != -1) simple->motion = words.motion;
+    return PREVIEW_SIMPLE;
+}
+
+// The steps for the simple lines since the last complex one: their last
+// feed and speed, then a rapid to their last position, restoring the
+// motion mode
+static void preview_simple_steps(const preview_simple &simple,
+        std::vector<preview_step> &steps) {
+    std::string feed, move;
+
+    for(int i = 0; i < 9; i++)
+        if(!simple.word[i].empty()) move += preview_words[i] + simple.word[i];
+    for(int i = 9; i < 11; i++)
+        if(!simple.word[i].empty()) feed += preview_words[i] + simple.word[i];
+    if(!feed.empty())
+        steps.push_back(preview_step(feed, PREVIEW_KEEP_MOTION));
+    if(!move.empty())
+        steps.push_back(preview_step("g0" + move, simple.motion != -1 ?
+                    simple.motion : PREVIEW_RESTORE_MOTION));
+    else if(simple.motion != -1)
+        steps.push_back(preview_step("", simple.motion));
+}
+
+// Splits the program, from the interpreter's position in it, into
+// chunks.  Returns false if it cannot be split.
+static bool preview_prescan(Interp *interp, int jobs, bool &has_block_delete,
+        bool &has_tool_change, std::vector<preview_step> &steps,
+        std::vector<preview_chunk> &chunks) {
+    char raw[LINELEN];
+    long start = ftell(interp->_setup.file_pointer);
+    FILE *fp = fopen(interp->_setup.filename, "r");
+    int lines = 0;
+
+    if(!fp) return false;
+    has_block_delete = has_tool_change = false;
+    for(int pass = 0; pass < 2; pass++) {
+        preview_simple simple;
+        int line = 0;
+
+        fseek(fp, start, SEEK_SET);
+        for(;;) {
+            if(pass && (size_t)line * jobs >= (size_t)lines * chunks.size()
+                    && chunks.size() < (size_t)jobs) {
+                preview_chunk c;
+                c.offset = ftell(fp);
+                c.start = interp->_setup.sequence_number + line;
+                c.steps = steps.size();
+                preview_simple_steps(simple, c.tail);
+                chunks.push_back(c);
+            }
+            if(!fgets(raw, LINELEN, fp)) break;
+            if(strlen(raw) == LINELEN - 1) { fclose(fp); return false; }
+            int kind = preview_classify(raw, &simple, &has_tool_change);
+            if(kind == PREVIEW_PERCENT || kind == PREVIEW_SERIAL) {
+                if(kind == PREVIEW_SERIAL) { fclose(fp); return false; }
+                break;
+            }
+            if(pass && kind == PREVIEW_COMPLEX) {
+                std::string block(raw);
+                while(!block.empty() && isspace(block[block.size() - 1]))
+                    block.erase(block.size() - 1);
+                preview_simple_steps(simple, steps);
+                simple = preview_simple();
+                steps.push_back(preview_step(block, PREVIEW_KEEP_MOTION));
+            }
+            if(raw[strspn(raw, " \t")] == '/') has_block_delete = true;
+            line++;
+        }
+        lines = line;
+        if(lines < PREVIEW_MIN_LINES) { fclose(fp); return false; }
+    }
+    fclose(fp);
+    return true;
+}
+
+// A worker's report on its chunk
+struct preview_message {
+    int finished;		// the program ended, or failed, in the chunk
+    int result, error_line_offset, last_sequence_number;
+    long records, records_end;		// the calls made in the chunk
+    long checkpoint, checkpoint_end;	// the state it started from or
+					// ended in, empty for none
+    char error[LINELEN];
+};
+
+struct preview_worker {
+    pid_t pid;
+    int cmd, status;		// pipes to and from the worker
+    FILE *record;		// the calls and checkpoints it writes
+    FILE *program;		// its own handle on the program
+};
+
+static bool preview_run_step(Interp *interp, const preview_step &step) {
+    int motion = interp->_setup.motion_mode;
+    int result = INTERP_OK;
+
+    if(!step.block.empty()) {
+        result = interp->read(step.block.c_str());
+        if(RESULT_OK) result = interp->execute();
+        if(!RESULT_OK) return false;
+    }
+    if(step.motion != PREVIEW_KEEP_MOTION) {
+        if(step.motion != PREVIEW_RESTORE_MOTION) motion = step.motion;
+        interp->_setup.motion_mode = motion;
+        interp->_setup.active_g_codes[1] = motion;
+    }
+    return true;
+}
+
+static void preview_checkpoint(Interp *interp, FILE *record, preview_message &m) {
+    std::string c = checkpoint(interp);
+    m.checkpoint = ftell(record);
+    fwrite(c.data(), 1, c.size(), record);
+    m.checkpoint_end = ftell(record);
+}
+
+static bool preview_send(int fd, const preview_message &m) {
+    return write(fd, &m, sizeof(m)) == sizeof(m);
+}
+
+// Runs in the worker for chunk k, and exits
+static void preview_work(Interp *interp, preview_worker &w, size_t k,
+        const std::vector<preview_step> &steps,
+        const std::vector<preview_chunk> &chunks) {
+    preview_message m;
+    int result = INTERP_OK;
+    bool valid = true;
+    char cmd;
+
+    canon_record = w.record;
+    canon_output = CANON_DISCARD;
+    for(size_t i = 0; k && valid && i < chunks[k].steps; i++)
+        valid = preview_run_step(interp, steps[i]);
+    for(size_t i = 0; k && valid && i < chunks[k].tail.size(); i++)
+        valid = preview_run_step(interp, chunks[k].tail[i]);
+    memset(&m, 0, sizeof(m));
+    if(valid) preview_checkpoint(interp, w.record, m);
+    fflush(w.record);
+    if(!preview_send(w.status, m) || !valid) _exit(0);
+
+    interp->_setup.file_pointer = w.program;
+    fseek(w.program, chunks[k].offset, SEEK_SET);
+    interp->_setup.sequence_number = chunks[k].start;
+    if(k) {
+        // as if the line before the chunk had been the last one executed
+        interp->_setup.active_g_codes[0] = chunks[k].start;
+        interp->_setup.active_m_codes[0] = chunks[k].start;
+        interp->_setup.active_settings[0] = chunks[k].start;
+        last_sequence_number = -1;
+    }
+    canon_output = CANON_RECORD;
+
+    for(;; k++) {
+        int end = k + 1 < chunks.size() ? chunks[k + 1].start : INT_MAX;
+        int error_line_offset = 0;
+
+        memset(&m, 0, sizeof(m));
+        m.records = ftell(w.record);
+        while(RESULT_OK) {
+            error_line_offset = 1;
+            result = interp->read();
+            if(!RESULT_OK) break;
+            error_line_offset = 0;
+            result = interp->execute();
+            if(interp->_setup.sequence_number >= end) break;
+        }
+        m.finished = !RESULT_OK;
+        if(m.finished) {
+            maybe_new_line();
+            m.result = result;
+            m.error_line_offset = error_line_offset;
+            interp->error_text(result, m.error, LINELEN);
+        }
+        m.last_sequence_number = last_sequence_number;
+        m.records_end = ftell(w.record);
+        if(!m.finished) preview_checkpoint(interp, w.record, m);
+        fflush(w.record);
+        if(!preview_send(w.status, m) || m.finished
+                || read(w.cmd, &cmd, 1) != 1)
+            break;
+    }
+    _exit(0);
+}
+
+// Waits for a worker's message, checking for an abort as the serial
+// parse does
+static bool preview_receive(int fd, preview_message &m,
+        struct timeval &t0, int wait) {
+    size_t got = 0;
+    struct timeval t1;
+
+    while(got < sizeof(m)) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int r = poll(&pfd, 1, 100);
+        if(r < 0 && errno != EINTR) return false;
+        if(r > 0) {
+            ssize_t n = read(fd, (char *)&m + got, sizeof(m) - got);
+            if(n <= 0) {
+                PyErr_Format(PyExc_RuntimeError, "preview worker exited");
+                return false;
+            }
+            got += n;
+        }
+        gettimeofday(&t1, NULL);
+        if(t1.tv_sec > t0.tv_sec + wait) {
+            if(check_abort()) return false;
+            t0 = t1;
+        }
+    }
+    return true;
+}
+
+static std::string preview_range(const preview_worker &w, long start, long end) {
+    std::string c(end - start, 0);
+    if(end > start && pread(fileno(w.record), &c[0], end - start, start) != end - start)
+        return std::string();
+    return c;
+}
+
+static void preview_stop(std::vector<preview_worker> &workers) {
+    for(size_t k = 0; k < workers.size(); k++) {
+        preview_worker &w = workers[k];
+        if(w.pid > 0) kill(w.pid, SIGKILL);
+        if(w.cmd >= 0) close(w.cmd);
+        if(w.status >= 0) close(w.status);
+        if(w.record) fclose(w.record);
+        if(w.program) fclose(w.program);
+        if(w.pid > 0) waitpid(w.pid, NULL, 0);
+    }
+    workers.clear();
+}
+
+// Parses the rest of the program with jobs workers, 0 for one per CPU.
+// Returns false, having done nothing, if the program is better parsed
+// serially.  Errors are counted in interp_error.
+static bool parse_parallel(Interp *interp, int jobs, struct timeval &t0,
+        int wait, int &result, int &error_line_offset) {
+    std::vector<preview_step> steps;
+    std::vector<preview_chunk> chunks;
+    bool has_block_delete, has_tool_change;
+
+    if(jobs <= 0) jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if(jobs > PREVIEW_MAX_JOBS) jobs = PREVIEW_MAX_JOBS;
+    if(jobs < 2 || !interp->_setup.file_pointer || interp->_setup.call_level
+            || interp->_setup.cutter_comp_side || !interp->_setup.remaps.empty()
+            || !preview_prescan(interp, jobs, has_block_delete,
+                has_tool_change, steps, chunks))
+        return false;
+    if(has_block_delete) worker_query.block_delete = GET_BLOCK_DELETE();
+    worker_query.length_units = GET_EXTERNAL_LENGTH_UNITS();
+    worker_query.angle_units = GET_EXTERNAL_ANGLE_UNITS();
+    worker_query.axis_mask = GET_EXTERNAL_AXIS_MASK();
+    worker_query.pockets_max = GET_EXTERNAL_POCKETS_MAX();
+    worker_query.tools.clear();
+    if(has_tool_change)
+        for(int i = 0; i < worker_query.pockets_max && !interp_error; i++)
+            worker_query.tools.push_back(GET_EXTERNAL_TOOL_TABLE(i));
+    if(interp_error) return true;
+
+    std::vector<preview_worker> workers(chunks.size());
+    for(size_t k = 0; k < workers.size(); k++) {
+        workers[k].pid = -1;
+        workers[k].cmd = workers[k].status = -1;
+        workers[k].record = workers[k].program = 0;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    for(size_t k = 0; k < workers.size(); k++) {
+        preview_worker &w = workers[k];
+        int cmd[2], status[2];
+
+        w.record = tmpfile();
+        w.program = fopen(interp->_setup.filename, "r");
+        if(!w.record || !w.program || pipe(cmd)) {
+            preview_stop(workers);
+            return false;
+        }
+        if(pipe(status)) {
+            close(cmd[0]); close(cmd[1]);
+            preview_stop(workers);
+            return false;
+        }
+        w.pid = fork();
+        if(w.pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            for(size_t j = 0; j < k; j++) {
+                close(workers[j].cmd);
+                close(workers[j].status);
+            }
+            close(cmd[1]);
+            close(status[0]);
+            w.cmd = cmd[0];
+            w.status = status[1];
+            preview_work(interp, w, k, steps, chunks);
+        }
+        close(cmd[0]);
+        close(status[1]);
+        w.cmd = cmd[1];
+        w.status = status[0];
+        fclose(w.program);
+        w.program = 0;
+        if(w.pid < 0) {
+            preview_stop(workers);
+            return false;
+        }
+    }
+
+    // Replay the chunks in order, each from the worker which started it
+    // in the state the previous one ended in, or else from the worker
+    // of the previous chunk
+    size_t src = 0;
+    std::string last;
+    preview_message m;
+    struct timeval t1;
+
+    for(size_t k = 0; k < chunks.size() && !interp_error; k++) {
+        if(!preview_receive(workers[k].status, m, t0, wait)) {
+            interp_error ++;
+            break;
+        }
+        if(k) {
+            char cmd = 'c';
+            if(m.checkpoint_end > m.checkpoint
+                    && preview_range(workers[k], m.checkpoint, m.checkpoint_end) == last) {
+                kill(workers[src].pid, SIGKILL);
+                src = k;
+            } else {
+                kill(workers[k].pid, SIGKILL);
+                if(write(workers[src].cmd, &cmd, 1) != 1) {
+                    PyErr_Format(PyExc_RuntimeError, "preview worker exited");
+                    interp_error ++;
+                    break;
+                }
+            }
+        }
+        if(!preview_receive(workers[src].status, m, t0, wait)) {
+            interp_error ++;
+            break;
+        }
+
+        preview_reader r(fileno(workers[src].record), m.records, m.records_end);
+        for(int n = 0; !r.done() && replay_call(r); n++) {
+            if(n % 1000) continue;
+            gettimeofday(&t1, NULL);
+            if(t1.tv_sec > t0.tv_sec + wait) {
+                if(check_abort()) { interp_error ++; break; }
+                t0 = t1;
+            }
+        }
+        if(interp_error) break;
+
+        if(m.finished) {
+            result = m.result;
+            error_line_offset = m.error_line_offset;
+            last_sequence_number = m.last_sequence_number;
+            if(result == INTERP_ERROR) interp->setSavedError(m.error);
+            break;
+        }
+        last = preview_range(workers[src], m.checkpoint, m.checkpoint_end);
+    }
+    preview_stop(workers);
+    return true;
+}
+
 static PyObject *parse_file(PyObject *self, PyObject *args) {
     char *f;
     char *unitcode=0, *initcode=0, *interpname=0;
@@ -688,9 +1477,11 @@ static PyObject *parse_file(PyObject *self, PyObject *args) {
     int error_line_offset = 0;
     struct timeval t0, t1;
     int wait = 1;
+    int jobs = 1;
+    bool parallel = false;
 
-    if(!PyArg_ParseTuple(args, "sOO!|s:new-parse",
-            &f, &callback, &PyList_Type, &initcodes, &interpname))
+    if(!PyArg_ParseTuple(args, "sOO!|si:new-parse",
+            &f, &callback, &PyList_Type, &initcodes, &interpname, &jobs))
     {
         initcodes = nullptr;
         PyErr_Clear();
@@ -714,6 +1505,7 @@ static PyObject *parse_file(PyObject *self, PyObject *args) {
     gettimeofday(&t0, NULL);
 
     metric=false;
+    plane = CANON_PLANE_XY;
     interp_error = 0;
     last_sequence_number = -1;
 
@@ -721,6 +1513,10 @@ static PyObject *parse_file(PyObject *self, PyObject *args) {
     _pos_u = _pos_v = _pos_w = 0;
 
     interp_new.init();
+    // [RS274NGC]PROFILE_* are task's files, which the preview must not
+    // overwrite; a parallel parse would only time its own share anyway
+    if(auto interp = dynamic_cast<Interp*>(pinterp))
+        interp->set_profile(NULL, NULL);
     interp_new.open(f);
 
     maybe_new_line();
@@ -748,7 +1544,13 @@ static PyObject *parse_file(PyObject *self, PyObject *args) {
         if(!RESULT_OK) goto out_error;
         result = interp_new.execute();
     }
-    while(!interp_error && RESULT_OK) {
+    if(!interp_error && RESULT_OK && !(interpname && *interpname)) {
+        auto interp = dynamic_cast<Interp*>(pinterp);
+        if(interp)
+            parallel = parse_parallel(interp, jobs, t0, wait,
+                    result, error_line_offset);
+    }
+    while(!parallel && !interp_error && RESULT_OK) {
         error_line_offset = 1;
         result = interp_new.read();
         gettimeofday(&t1, NULL);
@@ -775,7 +1577,7 @@ out_error:
         return NULL;
     }
     PyErr_Clear();
-    maybe_new_line();
+    if(!parallel) maybe_new_line();	// a worker did it
     if(PyErr_Occurred()) { interp_error = 1; goto out_error; }
     PyObject *retval = PyTuple_New(2);
     PyTuple_SetItem(retval, 0, PyInt_FromLong(result));
@@ -1015,7 +1817,10 @@ static PyObject *rs274_arc_to_segments(PyObject *self, PyObject *args) {
 }
 
 static PyMethodDef gcode_methods[] = {
-    {"parse", (PyCFunction)parse_file, METH_VARARGS, "Parse a G-Code file"},
+    {"parse", (PyCFunction)parse_file, METH_VARARGS,
+        "Parse a G-Code file: parse(filename, canon, initcodes[, interpname[, jobs]])\n"
+        "Long programs are parsed by jobs processes if asked, 0 for one per CPU;\n"
+        "by default, and with 1, the whole program is parsed in this one"},
     {"strerror", (PyCFunction)rs274_strerror, METH_VARARGS,
         "Convert a numeric error to a string"},
     {"calc_extents", (PyCFunction)rs274_calc_extents, METH_VARARGS,
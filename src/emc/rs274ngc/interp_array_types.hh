@@ -22,7 +22,6 @@ typedef pp::array_1_t< double, ACTIVE_SETTINGS> active_settings_array, (*active_
 typedef pp::array_1_t< block, MAX_NESTED_REMAPS> blocks_array, (*blocks_w)( Interp & );
 
 typedef pp::array_1_t< double, RS274NGC_MAX_PARAMETERS > parameters_array, (*parameters_w)( Interp & );
-typedef pp::array_1_t< CANON_TOOL_TABLE, CANON_POCKETS_MAX> tool_table_array, (*tool_table_w)( Interp & );
 typedef pp::array_1_t< context, INTERP_SUB_ROUTINE_LEVELS> sub_context_array, (*sub_context_w)( Interp & );
 typedef pp::array_1_t< int, 16> g_modes_array, (*g_modes_w)( block & );
 typedef pp::array_1_t< int, 11> m_modes_array, (*m_modes_w)( block & );
@@ -30,4 +29,29 @@ typedef pp::array_1_t< double, INTERP_SUB_PARAMS> params_array,
     (*params_w)( block &),
     (*saved_params_w) (context &);
 
+// the tool table has pockets_max entries and is resized by
+// load_tool_table(), so index the vector rather than its storage;
+// entries taken from it are valid until the next load_tool_table()
+struct tool_table_array {
+    tool_table_array(std::vector<CANON_TOOL_TABLE> &table) : m_table(&table) {}
+
+    long unsigned int len() const {
+        return m_table->size();
+    }
+
+    CANON_TOOL_TABLE &item_ref(long unsigned int index) const {
+        pp::raise_on_out_of_range(m_table->size(), index);
+        return (*m_table)[index];
+    }
+
+    void set_item(long unsigned int index, const CANON_TOOL_TABLE &value) {
+        pp::raise_on_out_of_range(m_table->size(), index);
+        (*m_table)[index] = value;
+    }
+
+private:
+    std::vector<CANON_TOOL_TABLE> *m_table;
+};
+typedef tool_table_array (*tool_table_w)( Interp & );
+
 
@@ -713,7 +713,16 @@ int Interp::find_tool_pocket(setup_pointer settings, int toolno, int *pocket)
         return INTERP_OK;
     }
     *pocket = -1;
-    for(int i=0; i<CANON_POCKETS_MAX; i++) {
+    // the index is right unless the table was changed since it was
+    // loaded, which the scan below catches
+    std::unordered_map<int, int>::const_iterator it =
+        settings->tool_index.find(toolno);
+    if(it != settings->tool_index.end() &&
+       settings->tool_table[it->second].toolno == toolno) {
+        *pocket = it->second;
+        return INTERP_OK;
+    }
+    for(int i=0; i<(int)settings->tool_table.size(); i++) {
         if(settings->tool_table[i].toolno == toolno)
             *pocket = i;
     }
@@ -17,8 +17,11 @@
 #include "config.h"
 #include <limits.h>
 #include <stdio.h>
+#include <time.h>
 #include <set>
 #include <map>
+#include <string>
+#include <unordered_map>
 #include <bitset>
 #include "canon.hh"
 #include "emcpos.h"
@@ -339,6 +342,8 @@ enum phases  {
 typedef struct remap_struct remap;
 typedef remap *remap_pointer;
 
+struct pyhandler;	// a resolved Python handler, see interp_python.hh
+
 // the remap configuration descriptor
 typedef struct remap_struct {
     const char *name;
@@ -352,6 +357,8 @@ typedef struct remap_struct {
     const char *remap_py;    // Py function maybe  null, OR
     const char *remap_ngc;   // NGC file, maybe  null
     const char *epilog_func; // Py function or null
+    // the Py functions' handlers, set by their first call
+    pyhandler *prolog_handler, *remap_py_handler, *epilog_handler;
 } remap;
 
 
@@ -367,6 +374,36 @@ struct nocase_cmp
 typedef std::map<const char *,remap,nocase_cmp> remap_map;
 typedef remap_map::iterator remap_iterator;
 
+// calls of a Python remap handler or O-word sub, and the time they took
+// including the interpreter's glue if pycall_timing is set; see
+// Interp::pycall()
+struct pycall_stat {
+    unsigned long calls;
+    double seconds;
+};
+typedef std::map<std::string, pyhandler *> pyhandler_map;
+
+// time and canon calls spent reading and executing the lines of one
+// call stack; see interp_profile.cc
+struct profile_stat {
+    unsigned long blocks;
+    long canon;
+    double seconds;
+};
+typedef std::map<std::string, profile_stat> profile_stat_map;
+
+struct profile_state {
+    std::string report;		// sorted report written on close, or empty
+    std::string folded;		// flamegraph stacks written on close, or empty
+    int depth;			// nesting of read() and execute()
+    bool pending;		// the outermost call has yet to read its block
+    bool mdi;			// the block is an MDI command
+    profile_stat *current;	// the stack of the block last read
+    struct timespec t0;		// when the outermost call started
+    long canon0;		// canon count when it started
+    profile_stat_map stacks;	// keyed by folded call stack
+};
+
 typedef std::map<int, remap_pointer> int_remap_map;
 typedef int_remap_map::iterator int_remap_iterator;
 
@@ -720,7 +757,8 @@ struct setup
   int stack_index;              // index into the stack
   EmcPose tool_offset;          // tool length offset
   int pockets_max;                 // number of pockets in carousel (including pocket 0, the spindle)
-  CANON_TOOL_TABLE tool_table[CANON_POCKETS_MAX];      // index is pocket number
+  std::vector<CANON_TOOL_TABLE> tool_table;      // index is pocket number, pockets_max entries
+  std::unordered_map<int, int> tool_index;  // tool number -> last pocket load_tool_table found it in
   double traverse_rate;         // rate for traverse motions
   double orient_offset;         // added to M19 R word, from [RS274NGC]ORIENT_OFFSET
 
@@ -784,6 +822,10 @@ struct setup
 #define FEATURE_OWORD_WARNONLY       0x00000020
 
     boost::python::object *pythis;  // boost::cref to 'this'
+    boost::python::object *pyargs;  // the tuple (this,), reused for handler calls
+    pyhandler_map pyhandlers;       // keyed by module.funcname
+    bool pycall_timing;             // add up the time of handler calls
+    profile_state profile;          // off unless a report file is set
     const char *on_abort_command;
     int_remap_map  g_remapped,m_remapped;
     remap_map remaps;
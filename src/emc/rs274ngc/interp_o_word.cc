@@ -300,7 +300,8 @@ int Interp::execute_call(setup_pointer settings,
 		CHP(read_inputs(settings));
 	    status = pycall(settings, current_frame, OWORD_MODULE,
 			    current_frame->subName, 
-			    settings->call_state == CS_NORMAL ? PY_OWORDCALL : PY_FINISH_OWORDCALL);
+			    settings->call_state == CS_NORMAL ? PY_OWORDCALL : PY_FINISH_OWORDCALL,
+			    &current_frame->pystuff.impl->handler);
 	    CHKS(status == INTERP_ERROR, "pycall(%s.%s) failed", OWORD_MODULE, current_frame->subName) ;
 	    switch (status = handler_returned(settings, current_frame, current_frame->subName, true)) {
 	    case INTERP_EXECUTE_FINISH:
@@ -326,8 +327,7 @@ int Interp::execute_call(setup_pointer settings,
 	    if (remap->remap_py || remap->prolog_func || remap->epilog_func) {
 		CHKS(!PYUSABLE, "%s (remapped) uses Python functions, but the Python plugin is not available", 
 		     remap->name);
-		plist.append(*settings->pythis);   //self
-		current_frame->pystuff.impl->tupleargs = bp::tuple(plist);
+		current_frame->pystuff.impl->tupleargs = *settings->pyargs; // self
 		current_frame->pystuff.impl->kwargs = bp::dict();
 	    }
 	    if (remap->argspec && (strchr(remap->argspec, '@') == NULL)) {
@@ -340,7 +340,8 @@ int Interp::execute_call(setup_pointer settings,
 	case CS_REEXEC_PROLOG:
 	    if (remap->prolog_func) { 
 		status = pycall(settings, current_frame, REMAP_MODULE,remap->prolog_func,
-				settings->call_state == CS_NORMAL ? PY_PROLOG : PY_FINISH_PROLOG);
+				settings->call_state == CS_NORMAL ? PY_PROLOG : PY_FINISH_PROLOG,
+				&remap->prolog_handler);
 		CHKS(status == INTERP_ERROR, "pycall(%s.%s) failed", REMAP_MODULE, remap->prolog_func);
 		switch (status = handler_returned(settings, current_frame, current_frame->subName, false)) {
 		case INTERP_EXECUTE_FINISH:
@@ -357,7 +358,8 @@ int Interp::execute_call(setup_pointer settings,
 	case CS_REEXEC_PYBODY:
 	    if (remap->remap_py) { 
 		status = pycall(settings, current_frame, REMAP_MODULE, remap->remap_py,
-				settings->call_state == CS_NORMAL ? PY_BODY : PY_FINISH_BODY);
+				settings->call_state == CS_NORMAL ? PY_BODY : PY_FINISH_BODY,
+				&remap->remap_py_handler);
 		CHP(status);
 		switch (status = handler_returned(settings, current_frame, current_frame->subName, false)) {
 		case INTERP_EXECUTE_FINISH:
@@ -422,7 +424,8 @@ int Interp::execute_return(setup_pointer settings, context_pointer current_frame
 		    CHP(read_inputs(settings));
 		status = pycall(settings, current_frame, REMAP_MODULE,
 	    			cblock->executing_remap->epilog_func,
-				settings->call_state == CS_NORMAL ? PY_EPILOG : PY_FINISH_EPILOG);
+				settings->call_state == CS_NORMAL ? PY_EPILOG : PY_FINISH_EPILOG,
+				&cblock->executing_remap->epilog_handler);
 		CHP(status);
 		switch (status = handler_returned(settings, current_frame, current_frame->subName, false)) {
 		case INTERP_EXECUTE_FINISH:
@@ -0,0 +1,222 @@
+/********************************************************************
+ * Description: interp_profile.cc
+ *
+ *  Opt-in profiling of the interpreter: wall time and canon calls
+ *  spent in read() and execute(), charged to the call stack of the
+ *  block last read - the main program, the O-word subs and remaps
+ *  it is nested in, and the file and line.  Written on close() as a
+ *  report sorted by time per line and per sub or remap, and/or as
+ *  folded stacks ("main.ngc;o<sub>;sub.ngc:12 1234", microseconds)
+ *  for flamegraph.pl and compatible viewers.
+ *
+ *  Python handlers run within execute() of the block calling them, so
+ *  their time is charged to that line; with pycall_timing set,
+ *  pycall_stats has it per handler.
+ *
+ * Author: LinuxCNC developers
+ * License: GPL Version 2
+ * System: Linux
+ *
+ * Copyright (c) 2026 LinuxCNC developers
+ *
+ ********************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <set>
+#include <vector>
+#include "rs274ngc.hh"
+#include "rs274ngc_return.hh"
+#include "interp_internal.hh"
+#include "rs274ngc_interp.hh"
+
+static const char *base_name(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static double seconds_since(const struct timespec &t0)
+{
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+void Interp::set_profile(const char *report, const char *folded)
+{
+    _setup.profile.report = report ? report : "";
+    _setup.profile.folded = folded ? folded : "";
+    _setup.profile.current = NULL;
+    _setup.profile.stacks.clear();
+}
+
+// start timing unless nested in another read() or execute(); line is
+// true if this call reads the block the time is charged to
+void Interp::profile_begin(bool line)
+{
+    profile_state &p = _setup.profile;
+
+    if (p.depth++)
+	return;
+    p.mdi = false;
+    p.pending = line;
+    p.canon0 = GET_EXTERNAL_CANON_COUNT();
+    clock_gettime(CLOCK_MONOTONIC, &p.t0);
+}
+
+// after reading a block: charge the current call to its stack
+void Interp::profile_line(bool mdi)
+{
+    profile_state &p = _setup.profile;
+    std::string key;
+
+    if (!p.pending)
+	return;
+    p.pending = false;
+    p.mdi = p.mdi || mdi;
+
+    if (_setup.call_level > 0 && _setup.sub_context[0].filename &&
+	_setup.sub_context[0].filename[0])
+	key = base_name(_setup.sub_context[0].filename);
+    else if (!p.mdi && _setup.filename[0])
+	key = base_name(_setup.filename);
+    else
+	key = "MDI";
+
+    for (int i = 1; i <= _setup.call_level; i++) {
+	context_pointer frame = &_setup.sub_context[i];
+	const char *name = frame->subName ? frame->subName : "?";
+	if (frame->context_status & REMAP_FRAME)
+	    key += std::string(";remap:") + name;
+	else
+	    key += std::string(";o<") + name + ">";
+    }
+
+    if (!p.mdi || _setup.call_level > 0) {
+	char line[32];
+	snprintf(line, sizeof(line), ":%d", _setup.sequence_number);
+	key += std::string(";") + base_name(_setup.filename) + line;
+    }
+
+    p.current = &p.stacks[key];
+    p.current->blocks++;
+}
+
+void Interp::profile_end()
+{
+    profile_state &p = _setup.profile;
+
+    if (--p.depth)
+	return;
+    if (!p.current) {
+	// execute() before any read(): charge it to where we are
+	p.pending = true;
+	profile_line(false);
+	p.current->blocks--;
+    }
+    p.current->seconds += seconds_since(p.t0);
+    p.current->canon += GET_EXTERNAL_CANON_COUNT() - p.canon0;
+}
+
+struct profile_row {
+    std::string name;
+    profile_stat stat;
+    bool operator<(const profile_row &o) const {
+	return stat.seconds > o.stat.seconds;
+    }
+};
+
+static void add_stat(profile_stat &to, const profile_stat &from)
+{
+    to.blocks += from.blocks;
+    to.canon += from.canon;
+    to.seconds += from.seconds;
+}
+
+static void print_rows(FILE *f, std::map<std::string, profile_stat> &m,
+		       double total)
+{
+    std::vector<profile_row> rows;
+
+    for (std::map<std::string, profile_stat>::iterator it = m.begin();
+	 it != m.end(); ++it) {
+	profile_row row = { it->first, it->second };
+	rows.push_back(row);
+    }
+    std::sort(rows.begin(), rows.end());
+    fprintf(f, "#   seconds       %%   blocks    canon  where\n");
+    for (size_t i = 0; i < rows.size(); i++)
+	fprintf(f, "%11.6f  %5.1f%%  %7lu  %7ld  %s\n",
+		rows[i].stat.seconds,
+		total > 0 ? 100 * rows[i].stat.seconds / total : 0.,
+		rows[i].stat.blocks, rows[i].stat.canon,
+		rows[i].name.c_str());
+}
+
+// write the report and folded stacks set with set_profile(); does
+// nothing if nothing was profiled since, so close() after close() or
+// a failed open() keep the last program's
+int Interp::write_profile()
+{
+    profile_state &p = _setup.profile;
+    profile_stat_map &stacks = p.stacks;
+    profile_stat_map::iterator it;
+    FILE *f;
+
+    if (stacks.empty())
+	return INTERP_OK;
+
+    if (!p.report.empty()) {
+	std::map<std::string, profile_stat> lines, subs;
+	profile_stat total = {0, 0, 0.};
+
+	for (it = stacks.begin(); it != stacks.end(); ++it) {
+	    const std::string &key = it->first;
+	    size_t leaf = key.rfind(';');
+	    add_stat(total, it->second);
+	    add_stat(lines[leaf == std::string::npos ? key :
+			   key.substr(leaf + 1)], it->second);
+	    // a sub's time includes the subs and remaps it calls; count it
+	    // once per stack when it is recursive
+	    if (leaf == std::string::npos)
+		continue;
+	    std::set<std::string> seen;
+	    size_t start = key.find(';') + 1;
+	    while (start <= leaf) {
+		size_t end = key.find(';', start);
+		std::string name = key.substr(start, end - start);
+		if (seen.insert(name).second)
+		    add_stat(subs[name], it->second);
+		start = end + 1;
+	    }
+	}
+
+	f = fopen(p.report.c_str(), "w");
+	CHKS((f == NULL), _("Unable to open profile report '%s'"),
+	     p.report.c_str());
+	fprintf(f, "# interpreter profile: %.6f s, %lu blocks, "
+		"%ld canon calls\n", total.seconds, total.blocks, total.canon);
+	fprintf(f, "\n# lines, by time spent reading and executing them\n");
+	print_rows(f, lines, total.seconds);
+	if (!subs.empty()) {
+	    fprintf(f, "\n# subs and remaps, by time including their calls\n");
+	    print_rows(f, subs, total.seconds);
+	}
+	fclose(f);
+    }
+
+    if (!p.folded.empty()) {
+	f = fopen(p.folded.c_str(), "w");
+	CHKS((f == NULL), _("Unable to open profile stacks '%s'"),
+	     p.folded.c_str());
+	for (it = stacks.begin(); it != stacks.end(); ++it) {
+	    long usec = lround(it->second.seconds * 1e6);
+	    if (usec > 0)
+		fprintf(f, "%s %ld\n", it->first.c_str(), usec);
+	}
+	fclose(f);
+    }
+    return INTERP_OK;
+}
@@ -49,6 +49,7 @@ namespace bp = boost::python;
 #include <ctype.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <exception>
 
 #include "rs274ngc.hh"
@@ -113,13 +114,45 @@ bool Interp::is_pycallable(setup_pointer settings,
     return python_plugin->is_callable(module,funcname);
 }
 
+// adds the time it lives to a handler's pycall_stat
+struct pycall_timer {
+    pycall_stat *stat;
+    struct timespec t0;
+
+    pycall_timer(pycall_stat *s) : stat(s) {
+	if (stat) clock_gettime(CLOCK_MONOTONIC, &t0);
+    }
+    ~pycall_timer() {
+	struct timespec t1;
+	if (!stat) return;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	stat->seconds += (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    }
+};
+
+// the handler of [module.]funcname, made on its first call
+pyhandler *Interp::find_pyhandler(const char *module, const char *funcname)
+{
+    pyhandler *&handler = _setup.pyhandlers[module ? std::string(module) + "." + funcname : funcname];
+
+    if (!handler) {
+	handler = new pyhandler;
+	handler->funcname = strstore(funcname);
+	handler->stat.calls = 0;
+	handler->stat.seconds = 0.0;
+    }
+    return handler;
+}
+
 // all parameters to/results from Python calls go through the callframe, which looks a bit awkward
 // the reason is not to expose boost.python through the interpreter public interface
+// *handler, if given, keeps the handler of funcname between calls
 int Interp::pycall(setup_pointer settings,
 		   context_pointer frame,
 		   const char *module,
 		   const char *funcname,
-		   int calltype)
+		   int calltype,
+		   pyhandler **handler)
 {
     bp::object retval, function;
     std::string msg;
@@ -133,6 +166,21 @@ int Interp::pycall(setup_pointer settings,
     CHKS(!PYUSABLE, "pycall(%s): Pyhton plugin not initialized",funcname);
     frame->pystuff.impl->py_return_type = 0;
 
+    // a generator's continuations count towards the time of its call
+    pyhandler *h = NULL;
+    if (calltype != PY_EXECUTE) {
+	h = handler ? *handler : NULL;
+	if (!h || strcmp(h->funcname, funcname)) {
+	    h = find_pyhandler(module, funcname);
+	    if (handler)
+		*handler = h;
+	}
+	if ((calltype != PY_FINISH_OWORDCALL) && (calltype != PY_FINISH_PROLOG) &&
+	    (calltype != PY_FINISH_BODY) && (calltype != PY_FINISH_EPILOG))
+	    h->stat.calls++;
+    }
+    pycall_timer timer(h && _setup.pycall_timing ? &h->stat : NULL);
+
     switch (calltype) {
     case PY_EXECUTE: // just run a string
 	python_plugin->run_string(funcname, retval);
@@ -179,7 +227,7 @@ int Interp::pycall(setup_pointer settings,
 	}
 	break;
     default:
-	python_plugin->call(module,funcname, frame->pystuff.impl->tupleargs,frame->pystuff.impl->kwargs,retval);
+	python_plugin->call(module,funcname, h->callable, frame->pystuff.impl->tupleargs,frame->pystuff.impl->kwargs,retval);
 	CHKS(python_plugin->plugin_status() == PLUGIN_EXCEPTION,
 	     "pycall(%s):\n%s", funcname,
 	     python_plugin->last_exception().c_str());
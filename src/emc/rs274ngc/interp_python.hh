@@ -4,6 +4,9 @@
 #define BOOST_PYTHON_MAX_ARITY 4
 #endif
 #include <boost/python/object.hpp>
+#include "rs274ngc.hh"
+#include "interp_internal.hh"
+#include "python_plugin.hh"
 struct pycontext_impl {
     boost::python::object tupleargs; // the args tuple for Py functions
     boost::python::object kwargs; // the args dict for Py functions
@@ -12,5 +15,14 @@ struct pycontext_impl {
     int py_returned_int;
     // generator object next method as returned if Python function contained a yield statement
     boost::python::object generator_next; 
+    pyhandler *handler = nullptr;  // the O-word sub last called in this frame
+};
+
+// a Python remap handler or O-word sub, looked up once by Interp::pycall()
+// and then kept by its remap or frame
+struct pyhandler {
+    const char *funcname;
+    python_callable callable;
+    pycall_stat stat;
 };
 #endif
@@ -23,6 +23,8 @@
 #include <string.h>
 #include "rs274ngc_interp.hh"
 #include <boost/python/object.hpp>
+#include "python_plugin.hh"
+#include "interp_python.hh"
 
 #pragma GCC diagnostic error "-Wmissing-field-initializers"
 setup::setup() :
@@ -132,7 +134,8 @@ setup::setup() :
     stack_index(0),
     tool_offset{{0,0,0},0,0,0,0,0,0},
     pockets_max(0),
-    tool_table{},
+    tool_table(1),
+    tool_index(),
     traverse_rate (0.0),
     orient_offset (0.0),
 
@@ -179,6 +182,9 @@ setup::setup() :
     loop_on_main_m99(false),
     disable_g92_persistence(0),
     pythis(),
+    pyargs(),
+    pycall_timing(false),
+    profile(),
     on_abort_command(NULL),
     init_once(0)
 {
@@ -187,6 +193,9 @@ setup::setup() :
 setup::~setup() {
     assert(!pythis || Py_IsInitialized());
     if(pythis) delete pythis;
+    if(pyargs) delete pyargs;
+    for (pyhandler_map::iterator it = pyhandlers.begin(); it != pyhandlers.end(); ++it)
+	delete it->second;
 }
 
 block_struct::block_struct ()
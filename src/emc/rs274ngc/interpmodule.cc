@@ -23,6 +23,7 @@
 #define BOOST_PYTHON_MAX_ARITY 4
 #include <boost/python/class.hpp>
 #include <boost/python/def.hpp>
+#include <boost/python/dict.hpp>
 #include <boost/python/exception_translator.hpp>
 #include <boost/python/module.hpp>
 #include <boost/python/suite/indexing/map_indexing_suite.hpp>
@@ -39,6 +40,8 @@ extern int _task;  // zero in gcodemodule, 1 in milltask
 #include "interp_return.hh"
 #include "interp_internal.hh"
 #include "rs274ngc_interp.hh"
+#include "python_plugin.hh"
+#include "interp_python.hh"
 #include "units.h"
 #include "array1.hh"
 
@@ -116,6 +119,37 @@ static bp::object wrap_find_tool_pocket(Interp &interp, int toolno)
     return bp::make_tuple(status, pocket);
 }
 
+// {'module.funcname': (calls, seconds)} of the Python handlers called so
+// far; seconds stay 0 unless pycall_timing is set
+static bp::object get_pycall_stats(Interp &interp)
+{
+    bp::dict stats;
+
+    for (pyhandler_map::iterator it = interp._setup.pyhandlers.begin();
+	 it != interp._setup.pyhandlers.end(); ++it)
+	if (it->second->stat.calls)
+	    stats[it->first] = bp::make_tuple(it->second->stat.calls,
+					      it->second->stat.seconds);
+    return stats;
+}
+
+// remaps and frames keep pointers to the handlers, so zero them
+static void reset_pycall_stats(Interp &interp)
+{
+    for (pyhandler_map::iterator it = interp._setup.pyhandlers.begin();
+	 it != interp._setup.pyhandlers.end(); ++it) {
+	it->second->stat.calls = 0;
+	it->second->stat.seconds = 0.0;
+    }
+}
+
+static inline bool get_pycall_timing (Interp &interp)  {
+    return interp._setup.pycall_timing;
+}
+static inline void set_pycall_timing(Interp &interp, bool value)  {
+    interp._setup.pycall_timing = value;
+}
+
 
 // FIXME not sure if this is really needed
 static  ParamClass param_wrapper ( Interp & inst) {
@@ -706,6 +740,7 @@ static inline int get_pockets_max (Interp &interp)  {
 }
 static inline void set_pockets_max(Interp &interp, int value)  {
     interp._setup.pockets_max = value;
+    interp._setup.tool_table.resize(std::max(value, 1));
 }
 static inline int get_random_toolchanger (Interp &interp)  {
     return interp._setup.random_toolchanger;
@@ -843,6 +878,7 @@ BOOST_PYTHON_MODULE(interpreter) {
 	.def("set_errormsg", &setErrorMsg)
 	.def("get_errormsg", &Interp::getSavedError)
 	.def("stack", &errorStack)
+	.def("reset_pycall_stats", &reset_pycall_stats)
 	.def("synch", &Interp::synch)
 
 	// those will raise exceptions on return value < INTERP_MIN_ERROR  if throw_exceptions is set.
@@ -856,6 +892,8 @@ BOOST_PYTHON_MODULE(interpreter) {
 	.add_property("task", &get_task) // R/O
 	.add_property("filename", &get_filename) // R/O
 	.add_property("linetext", &get_linetext) // R/O
+	.add_property("pycall_stats", &get_pycall_stats) // R/O
+	.add_property("pycall_timing", &get_pycall_timing, &set_pycall_timing)
 	.add_property("tool_offset", &get_tool_offset, &set_tool_offset)
 	.add_property("arc_not_allowed", &get_arc_not_allowed, &set_arc_not_allowed)
 	.add_property("cutter_comp_firstmove",
@@ -45,8 +45,12 @@ void export_Arrays()
     pp::register_array_1< block, MAX_NESTED_REMAPS,
 	bp::return_internal_reference< 1, bp::default_call_policies > > ("BlocksArray");
     pp::register_array_1< double, RS274NGC_MAX_PARAMETERS > ("ParametersArray");
-    pp::register_array_1< CANON_TOOL_TABLE, CANON_POCKETS_MAX,
-	bp::return_internal_reference< 1, bp::default_call_policies > > ("ToolTableArray");
+    class_< tool_table_array >("ToolTableArray", no_init)
+	.def("__getitem__", &tool_table_array::item_ref, (bp::arg("index")),
+	     return_internal_reference< 1, default_call_policies >())
+	.def("__setitem__", &tool_table_array::set_item,
+	     (bp::arg("index"), bp::arg("value")))
+	.def("__len__", &tool_table_array::len);
     pp::register_array_1< context, INTERP_SUB_ROUTINE_LEVELS,
 	bp::return_internal_reference< 1, bp::default_call_policies > > ("SubcontextArray");
     pp::register_array_1< int, 16> ("GmodesArray");
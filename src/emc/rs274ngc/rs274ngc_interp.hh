@@ -127,6 +127,11 @@ public:
 
     void set_loglevel(int level);
 
+// profile read() and execute() per line, O-word sub and remap, writing a
+// sorted report and/or flamegraph stacks on close(); NULL or "" for none
+ void set_profile(const char *report, const char *folded);
+ int write_profile();
+
     // for now, public - for boost.python access
  int find_named_param(const char *nameBuf, int *status, double *value);
  int store_named_param(setup_pointer settings,const char *nameBuf, double value, int override_readonly = 0);
@@ -649,11 +654,13 @@ int read_inputs(setup_pointer settings);
 		       PY_EXECUTE,
 		       PY_PLUGIN_CALL
     };
+    pyhandler *find_pyhandler(const char *module, const char *funcname);
     int pycall(setup_pointer settings,
 	       context_pointer frame,
 	       const char *module,
 	       const char *funcname,
-	       int calltype);
+	       int calltype,
+	       pyhandler **handler = NULL);
     int py_execute(const char *cmd, bool as_file = false); // for (py, ....) comments
     int py_reload();
     FILE *find_ngc_file(setup_pointer settings,const char *basename, char *foundhere = NULL);
@@ -664,6 +671,12 @@ int read_inputs(setup_pointer settings);
 
     int unwind_call(int status, const char *file, int line, const char *function);
 
+    bool profiling() { return !_setup.profile.report.empty() ||
+	    !_setup.profile.folded.empty(); }
+    void profile_begin(bool line);
+    void profile_line(bool mdi);
+    void profile_end();
+
 
  int convert_straight_indexer(int anum, int jnum, block* blk, setup* settings);
  int issue_straight_index(int anum, int jnum, double end, int lineno, setup* settings);
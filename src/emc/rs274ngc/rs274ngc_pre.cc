@@ -141,6 +141,7 @@ Interp::Interp()
 	// wrapper instance on every init(), abandoning the old one and all user attributes
 	// tacked onto it, so make sure this is done exactly once
 	_setup.pythis = new boost::python::object(boost::cref(*this));
+	_setup.pyargs = new boost::python::object(bp::make_tuple(*_setup.pythis));
 	
 	// alias to 'interpreter.this' for the sake of ';py, .... ' comments
 	// besides 'this', eventually use proper instance names to handle
@@ -233,6 +234,8 @@ Called By: external programs
 int Interp::close()
 {
     logOword("close()");
+    if (profiling())
+	write_profile();
     // be "lazy" only if we're not aborting a call in progress
     // in which case we need to reset() the call stack
     // this does not reset the filename properly 
@@ -519,9 +522,13 @@ int Interp::_execute(const char *command)
 int Interp::execute(const char *command)
 {
     int status;
+    if (profiling())
+	profile_begin(command != NULL);
     if ((status = _execute(command)) > INTERP_MIN_ERROR) {
         unwind_call(status, __FILE__,__LINE__,__FUNCTION__);
     }
+    if (profiling())
+	profile_end();
     return status;
 }
 
@@ -759,6 +766,8 @@ int Interp::exit()
                              0) ?
                             RS274NGC_PARAMETER_FILE_NAME_DEFAULT :
                             file_name), _setup.parameters);
+  if (profiling())
+      write_profile();
   reset();
 
   // interpreter shutdown Python hook
@@ -979,6 +988,16 @@ int Interp::init()
           } else {
 	      _setup.on_abort_command = NULL;
           }
+          // opt-in profiling, written on close(); see interp_profile.cc
+          {
+              std::string report, folded;
+              if (NULL != (inistring = inifile.Find("PROFILE_REPORT", "RS274NGC")))
+                  report = inistring;
+              if (NULL != (inistring = inifile.Find("PROFILE_FOLDED", "RS274NGC")))
+                  folded = inistring;
+              if (report != _setup.profile.report || folded != _setup.profile.folded)
+                  set_profile(report.c_str(), folded.c_str());
+          }
 
 	  // initialize the Python plugin singleton
           if (NULL != (inistring = inifile.Find("TOPLEVEL", "PYTHON"))) {
@@ -1276,10 +1295,10 @@ void Interp::set_loop_on_main_m99(bool state) {
 Returned Value: int
    If any of the following errors occur, this returns the error code shown.
    Otherwise, this returns INTERP_OK.
-   1. _setup.tool_max is larger than CANON_TOOL_MAX: NCE_TOOL_MAX_TOO_LARGE
+   None.
 
 Side Effects:
-   _setup.tool_table[] is modified.
+   _setup.tool_table[] is resized to _setup.pockets_max and filled.
 
 Called By:
    Interp::synch
@@ -1288,8 +1307,8 @@ Called By:
 This function calls the canonical interface function GET_EXTERNAL_TOOL_TABLE
 to load the whole tool table into the _setup.
 
-The CANON_TOOL_MAX is an upper limit for this software. The
-_setup.tool_max is intended to be set for a particular machine.
+The table has as many pockets as the canonical interface reports, so
+it grows and shrinks with the tool table file.
 
 */
 
@@ -1297,17 +1316,14 @@ int Interp::load_tool_table()
 {
   int n;
 
-  CHKS((_setup.pockets_max > CANON_POCKETS_MAX), NCE_POCKET_MAX_TOO_LARGE);
+  // the table can have grown since init()
+  _setup.pockets_max = GET_EXTERNAL_POCKETS_MAX();
+  _setup.tool_table.resize(std::max(_setup.pockets_max, 1));
+  _setup.tool_index.clear();
   for (n = 0; n < _setup.pockets_max; n++) {
     _setup.tool_table[n] = GET_EXTERNAL_TOOL_TABLE(n);
-  }
-  for (; n < CANON_POCKETS_MAX; n++) {
-    _setup.tool_table[n].toolno = -1;
-    ZERO_EMC_POSE(_setup.tool_table[n].offset);
-    _setup.tool_table[n].diameter = 0;
-    _setup.tool_table[n].orientation = 0;
-    _setup.tool_table[n].frontangle = 0;
-    _setup.tool_table[n].backangle = 0;
+    if (_setup.tool_table[n].toolno != -1)
+      _setup.tool_index[_setup.tool_table[n].toolno] = n;
   }
   set_tool_parameters();
   return INTERP_OK;
@@ -1375,6 +1391,8 @@ int Interp::open(const char *filename) //!< string: the name of the input NC-pro
     }
   CHKS((_setup.file_pointer != NULL), NCE_A_FILE_IS_ALREADY_OPEN);
   CHKS((strlen(filename) > (LINELEN - 1)), NCE_FILE_NAME_TOO_LONG);
+  _setup.profile.current = NULL;
+  _setup.profile.stacks.clear();
   _setup.file_pointer = fopen(filename, "r");
   CHKS((_setup.file_pointer == NULL), NCE_UNABLE_TO_OPEN_FILE, filename);
   line = _setup.linetext;
@@ -1639,9 +1657,15 @@ int Interp::_read(const char *command)  //!< may be NULL or a string to read
 int Interp::read(const char *command) 
 {
     int status;
+    if (profiling())
+	profile_begin(true);
     if ((status = _read(command)) > INTERP_MIN_ERROR) {
 	unwind_call(status, __FILE__,__LINE__,__FUNCTION__);
     }
+    if (profiling()) {
+	profile_line(command != NULL);
+	profile_end();
+    }
     return status;
 }
 
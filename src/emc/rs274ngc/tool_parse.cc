@@ -22,14 +22,13 @@
 
 static bool scan_old_style(
 	char *buffer,
-	CANON_TOOL_TABLE toolTable[],
-	int fms[],
-	char *ttcomments[],
+	ToolTableSink &sink,
 	int random_toolchanger,
 	int &fakepocket) {
     int scanned, toolno, pocket, orientation;
     double zoffset, xoffset, diameter, frontangle, backangle;
     char comment[CANON_TOOL_ENTRY_LEN];
+    int pockets_max = sink.pockets_max();
 
     if((scanned = sscanf(buffer, "%d %d %lf %lf %lf %lf %lf %d %[^\n]",
 			 &toolno, &pocket, &zoffset, &xoffset, &diameter,
@@ -37,27 +36,28 @@ static bool scan_old_style(
        (scanned == 8 || scanned == 9)) {
 	if(!random_toolchanger) {
 	    fakepocket++;
-	    if(fakepocket >= CANON_POCKETS_MAX) {
+	    if(fakepocket >= pockets_max) {
 		printf("too many tools. skipping tool %d\n", toolno);
 		return true;
 	    }
-	    if(fms) fms[fakepocket] = pocket;
+	    sink.set_fms(fakepocket, pocket);
 	    pocket = fakepocket;
 	}
-	if (pocket < 0 || pocket >= CANON_POCKETS_MAX) {
-	    printf("max pocket number is %d. skipping tool %d\n", CANON_POCKETS_MAX-1, toolno);
+	if (pocket < 0 || pocket >= pockets_max) {
+	    printf("max pocket number is %d. skipping tool %d\n", pockets_max-1, toolno);
 	    return true;
 	} else {
 	    /* lathe tool */
-	    toolTable[pocket].toolno = toolno;
-	    toolTable[pocket].offset.tran.z = zoffset;
-	    toolTable[pocket].offset.tran.x = xoffset;
-	    toolTable[pocket].diameter = diameter;
+	    CANON_TOOL_TABLE &tool = sink.tool(pocket);
+	    tool.toolno = toolno;
+	    tool.offset.tran.z = zoffset;
+	    tool.offset.tran.x = xoffset;
+	    tool.diameter = diameter;
 
-	    toolTable[pocket].frontangle = frontangle;
-	    toolTable[pocket].backangle = backangle;
-	    toolTable[pocket].orientation = orientation;
-	    if(ttcomments && scanned == 9) strcpy(ttcomments[pocket], comment);
+	    tool.frontangle = frontangle;
+	    tool.backangle = backangle;
+	    tool.orientation = orientation;
+	    if(scanned == 9) sink.set_comment(pocket, comment);
 	    return true;
 	}
     } else if ((scanned = sscanf(buffer, "%d %d %lf %lf %[^\n]",
@@ -65,41 +65,80 @@ static bool scan_old_style(
 	       (scanned == 4 || scanned == 5)) {
 	if(!random_toolchanger) {
 	    fakepocket++;
-	    if(fakepocket >= CANON_POCKETS_MAX) {
+	    if(fakepocket >= pockets_max) {
 		printf("too many tools. skipping tool %d\n", toolno);
 		return true;
 	    }
-	    if(fms) fms[fakepocket] = pocket;
+	    sink.set_fms(fakepocket, pocket);
 	    pocket = fakepocket;
 	}
-	if (pocket < 0 || pocket >= CANON_POCKETS_MAX) {
-	    printf("max pocket number is %d. skipping tool %d\n", CANON_POCKETS_MAX-1, toolno);
+	if (pocket < 0 || pocket >= pockets_max) {
+	    printf("max pocket number is %d. skipping tool %d\n", pockets_max-1, toolno);
 	    return true;
 	} else {
 	    /* mill tool */
-	    toolTable[pocket].toolno = toolno;
-	    toolTable[pocket].offset.tran.z = zoffset;
-	    toolTable[pocket].diameter = diameter;
+	    CANON_TOOL_TABLE &tool = sink.tool(pocket);
+	    tool.toolno = toolno;
+	    tool.offset.tran.z = zoffset;
+	    tool.diameter = diameter;
 
 	    // these aren't used on a mill
-	    toolTable[pocket].frontangle = toolTable[pocket].backangle = 0.0;
-	    toolTable[pocket].offset.tran.x = 0.0;
-	    toolTable[pocket].orientation = 0;
-	    if(ttcomments && scanned == 5) strcpy(ttcomments[pocket], comment);
+	    tool.frontangle = tool.backangle = 0.0;
+	    tool.offset.tran.x = 0.0;
+	    tool.orientation = 0;
+	    if(scanned == 5) sink.set_comment(pocket, comment);
 	    return true;
 	}
     }
     return false;
 }
 
+namespace {
+/* loadToolTable into the fixed arrays of the C interface */
+class ArraySink : public ToolTableSink {
+public:
+    ArraySink(CANON_TOOL_TABLE *toolTable_, int *fms_, char **ttcomments_)
+	: toolTable(toolTable_), fms(fms_), ttcomments(ttcomments_) {}
+    int pockets_max() { return CANON_POCKETS_MAX; }
+    void clear(int first) {
+	for (int t = first; t < CANON_POCKETS_MAX; t++) {
+	    toolTable[t].toolno = -1;
+	    ZERO_EMC_POSE(toolTable[t].offset);
+	    toolTable[t].diameter = 0.0;
+	    toolTable[t].frontangle = 0.0;
+	    toolTable[t].backangle = 0.0;
+	    toolTable[t].orientation = 0;
+	    if(fms) fms[t] = 0;
+	    if(ttcomments) ttcomments[t][0] = '\0';
+	}
+    }
+    CANON_TOOL_TABLE &tool(int pocket) { return toolTable[pocket]; }
+    void set_fms(int pocket, int f) { if(fms) fms[pocket] = f; }
+    void set_comment(int pocket, const char *comment) {
+	if(ttcomments) strcpy(ttcomments[pocket], comment);
+    }
+private:
+    CANON_TOOL_TABLE *toolTable;
+    int *fms;
+    char **ttcomments;
+};
+}
+
 int loadToolTable(const char *filename,
 			 CANON_TOOL_TABLE toolTable[],
 			 int fms[],
 			 char *ttcomments[],
 			 int random_toolchanger)
+{
+    ArraySink sink(toolTable, fms, ttcomments);
+    return loadToolTable(filename, sink, random_toolchanger);
+}
+
+int loadToolTable(const char *filename, ToolTableSink &sink,
+			 int random_toolchanger)
 {
     int fakepocket = 0;
-    int t;
+    int pockets_max = sink.pockets_max();
     FILE *fp;
     char buffer[CANON_TOOL_ENTRY_LEN];
     char orig_line[CANON_TOOL_ENTRY_LEN];
@@ -113,16 +152,7 @@ int loadToolTable(const char *filename,
 	return -1;
     }
     // clear out tool table
-    for (t = random_toolchanger? 0: 1; t < CANON_POCKETS_MAX; t++) {
-        toolTable[t].toolno = -1;
-        ZERO_EMC_POSE(toolTable[t].offset);
-        toolTable[t].diameter = 0.0;
-        toolTable[t].frontangle = 0.0;
-        toolTable[t].backangle = 0.0;
-        toolTable[t].orientation = 0;
-        if(fms) fms[t] = 0;
-        if(ttcomments) ttcomments[t][0] = '\0';
-    }
+    sink.clear(random_toolchanger? 0: 1);
 
     /*
       Override 0's with codes from tool file
@@ -150,8 +180,8 @@ int loadToolTable(const char *filename,
         }
         strcpy(orig_line, buffer);
 
-        if(scan_old_style(buffer, toolTable, fms, ttcomments,
-                                random_toolchanger, fakepocket)) continue;
+        if(scan_old_style(buffer, sink, random_toolchanger, fakepocket))
+            continue;
 
         toolno = -1;
         diameter = frontangle = backangle = 0.0;
@@ -174,16 +204,16 @@ int loadToolTable(const char *filename,
                 }
                 if (!random_toolchanger) {
                     fakepocket++;
-                    if (fakepocket >= CANON_POCKETS_MAX) {
+                    if (fakepocket >= pockets_max) {
                         printf("too many tools. skipping tool %d\n", toolno);
                         valid = 0;
                         break;
                     }
-                    if(fms) fms[fakepocket] = pocket;
+                    sink.set_fms(fakepocket, pocket);
                     pocket = fakepocket;
                 }
-                if (pocket < 0 || pocket >= CANON_POCKETS_MAX) {
-                    printf("max pocket number is %d. skipping tool %d\n", CANON_POCKETS_MAX - 1, toolno);
+                if (pocket < 0 || pocket >= pockets_max) {
+                    printf("max pocket number is %d. skipping tool %d\n", pockets_max - 1, toolno);
                     valid = 0;
                     break;
                 }
@@ -248,20 +278,23 @@ int loadToolTable(const char *filename,
             token = strtok(NULL, " ");
         }
         if (valid) {
-            toolTable[pocket].toolno = toolno;
-            toolTable[pocket].offset = offset;
-            toolTable[pocket].diameter = diameter;
-            toolTable[pocket].frontangle = frontangle;
-            toolTable[pocket].backangle = backangle;
-            toolTable[pocket].orientation = orientation;
+            CANON_TOOL_TABLE &tool = sink.tool(pocket);
+            tool.toolno = toolno;
+            tool.offset = offset;
+            tool.diameter = diameter;
+            tool.frontangle = frontangle;
+            tool.backangle = backangle;
+            tool.orientation = orientation;
 
-            if (ttcomments && comment)
-                strcpy(ttcomments[pocket], comment);
+            if (comment)
+                sink.set_comment(pocket, comment);
         } else {
             fprintf(stderr, "Unrecognized line skipped: %s", orig_line);
         }
-        if (!random_toolchanger && toolTable[0].toolno == toolTable[pocket].toolno) {
-            toolTable[0] = toolTable[pocket];
+        // a bad P word leaves pocket out of range
+        if (!random_toolchanger && pocket > 0 && pocket < pockets_max &&
+                sink.tool(0).toolno == sink.tool(pocket).toolno) {
+            sink.tool(0) = sink.tool(pocket);
         }
     }
 
@@ -32,4 +32,24 @@ int loadToolTable(const char *filename,
 }
 #endif
 
+/* Where loadToolTable puts what it reads.  The array version above
+   is a sink over fixed CANON_POCKETS_MAX arrays; ToolStore (toolstore.hh)
+   is one that grows to fit the file. */
+class ToolTableSink {
+public:
+    virtual ~ToolTableSink() {}
+    /* number of pockets the sink can hold, including pocket 0 */
+    virtual int pockets_max() = 0;
+    /* empty pockets first and up */
+    virtual void clear(int first) = 0;
+    /* the entry for pocket, 0 <= pocket < pockets_max(); the sink grows
+       to hold it if it has to */
+    virtual CANON_TOOL_TABLE &tool(int pocket) = 0;
+    virtual void set_fms(int pocket, int fms) = 0;
+    virtual void set_comment(int pocket, const char *comment) = 0;
+};
+
+int loadToolTable(const char *filename, ToolTableSink &sink,
+	int random_toolchanger);
+
 #endif
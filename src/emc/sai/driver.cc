@@ -23,8 +23,9 @@
 #include "rs274ngc_return.hh"
 #include "inifile.hh"		// INIFILE
 #include "canon.hh"		// _parameter_file_name
+#include "canon_trace.hh"
 #include "config.h"		// LINELEN
-#include "tool_parse.h"
+#include "toolstore.hh"
 #include <stdio.h>    /* gets, etc. */
 #include <stdlib.h>   /* exit       */
 #include <string.h>   /* strcpy     */
@@ -312,7 +313,7 @@ int interpret_from_file( /* ARGUMENTS                  */
 Returned Value: int
   Returns 0 for success, nonzero for failure.  Failures can be caused by:
   1. The file named by the user cannot be opened.
-  2. Any error detected by loadToolTable()
+  2. Any error detected by ToolStore::load()
 
 Side Effects:
   Values in the tool table of the machine setup are changed,
@@ -334,7 +335,7 @@ int read_tool_file(  /* ARGUMENTS         */
       tool_file_name = buffer;
     }
 
-  return loadToolTable(tool_file_name, _tools, 0, 0, 0);
+  return _tools.load(tool_file_name, 0);
 }
 
 /************************************************************************/
@@ -547,6 +548,9 @@ int main (int argc, char ** argv)
   char *inifile = NULL;
   int log_level = -1;
   std::string interp;
+  char *tracefile = NULL;
+  char *profile_report = NULL;
+  char *profile_folded = NULL;
 
   do_next = 2;  /* 2=stop */
   block_delete = OFF;
@@ -557,7 +561,7 @@ int main (int argc, char ** argv)
   go_flag = 0;
 
   while(1) {
-      int c = getopt(argc, argv, "p:t:v:bsn:gi:l:T");
+      int c = getopt(argc, argv, "p:t:v:bsn:gi:l:To:P:F:");
       if(c == -1) break;
 
       switch(c) {
@@ -571,6 +575,9 @@ int main (int argc, char ** argv)
           case 'g': go_flag = !go_flag; break;
           case 'i': inifile = optarg; break;
           case 'T': _task = 1; break;
+          case 'o': tracefile = optarg; break;
+          case 'P': profile_report = optarg; break;
+          case 'F': profile_folded = optarg; break;
           case '?': default: goto usage;
       }
   }
@@ -580,7 +587,8 @@ int main (int argc, char ** argv)
 usage:
       fprintf(stderr,
             "Usage: %s [-p interp.so] [-t tool.tbl] [-v var-file.var] [-n 0|1|2]\n"
-            "          [-b] [-s] [-g] [input file [output file]]\n"
+            "          [-b] [-s] [-g] [-o trace-file] [-P report-file]\n"
+            "          [-F folded-file] [input file [output file]]\n"
             "\n"
             "    -p: Specify the pluggable interpreter to use\n"
             "    -t: Specify the .tbl (tool table) file to use\n"
@@ -595,6 +603,12 @@ usage:
             "    -i: specify the .ini file (default: no ini file)\n"
             "    -T: call task_init()\n"
             "    -l: specify the log_level (default: -1)\n"
+            "    -o: also write a binary canon trace of the input file,\n"
+            "        which task can run with the canterp interpreter\n"
+            "    -P: profile the interpreter, writing time and canon calls\n"
+            "        per line, O-word sub and remap, sorted, to report-file\n"
+            "    -F: profile the interpreter, writing the call stacks in\n"
+            "        flamegraph.pl's folded format to folded-file\n"
             , argv[0]);
       exit(1);
     }
@@ -670,6 +684,15 @@ usage:
   if (log_level != -1)
       interp_set_loglevel(log_level);
 
+  if (profile_report || profile_folded)
+    {
+      Interp *i = dynamic_cast<Interp*>(pinterp);
+      if (i)
+          i->set_profile(profile_report, profile_folded);
+      else
+          fprintf(stderr, "-P and -F need the built-in interpreter\n");
+    }
+
 
   if (argc == 1)
     status = interpret_from_keyboard(block_delete, print_stack);
@@ -681,10 +704,20 @@ usage:
           report_error(status, print_stack);
           exit(1);
         }
+      if (tracefile && canon_trace_open(tracefile, argv[1]) != 0)
+        {
+          fprintf(stderr, "could not open trace file %s\n", tracefile);
+          exit(1);
+        }
       status = interpret_from_file(do_next, block_delete, print_stack);
       file_name(buffer, 5);  /* called to exercise the function */
       file_name(buffer, 79); /* called to exercise the function */
       interp_close();
+      if (canon_trace_close() != 0)
+        {
+          fprintf(stderr, "could not write trace file %s\n", tracefile);
+          exit(1);
+        }
     }
   line_length();         /* called to exercise the function */
   sequence_number();     /* called to exercise the function */
@@ -32,14 +32,17 @@
 ********************************************************************/
 
 #include "canon.hh"
+#include "canon_trace.hh"
 #include "rs274ngc.hh"
 #include "rs274ngc_interp.hh"
+#include "toolstore.hh"
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <limits.h>
 
 /* where to print */
 //extern FILE * _outfile;
@@ -76,8 +79,7 @@ static double            _program_position_y = 0;
 static double            _program_position_z = 0;
 static double            _spindle_speed;
 static CANON_DIRECTION   _spindle_turning;
-int                      _pockets_max = CANON_POCKETS_MAX; /*Not static. Driver reads  */
-CANON_TOOL_TABLE         _tools[CANON_POCKETS_MAX]; /*Not static. Driver writes */
+ToolStore                _tools; /*Not static. Driver loads it */
 /* optional program stop */
 static bool optional_program_stop = ON; //set enabled by default (previous EMC behaviour)
 /* optional block delete */
@@ -207,12 +209,124 @@ void print_nc_line_number()
                    arg1,arg2,arg3,arg4,arg5,arg6,arg7,arg8,arg9,arg10,arg11,arg12,arg13,arg14); \
           } else
 
+/* Binary canon trace (see canon_trace.hh), written alongside the text
+output when the driver calls canon_trace_open().  Motion calls record
+their own line number, everything else the interpreter's current line. */
+
+static FILE * _tracefile = NULL;
+
+static void trace(int op, int line,
+                  int ndoubles, const double *doubles,
+                  int nints, const int *ints, const char *text)
+{
+  canon_trace_record r;
+  static const char pad[8] = {0};
+  size_t textlen, size, used;
+  int32_t i32;
+  int k;
+
+  if (_tracefile == NULL)
+    return;
+  textlen = text ? strlen(text) + 1 : 0;
+  if (textlen > 255)
+    textlen = 255;
+  r.op = op;
+  r.ndoubles = ndoubles;
+  r.nints = nints;
+  r.textlen = textlen;
+  r.line = (line < 0) ? interp_new.line() : line;
+  fwrite(&r, sizeof(r), 1, _tracefile);
+  fwrite(doubles, sizeof(double), ndoubles, _tracefile);
+  for (k = 0; k < nints; k++)
+    {
+      i32 = ints[k];
+      fwrite(&i32, sizeof(i32), 1, _tracefile);
+    }
+  if (textlen)
+    {
+      fwrite(text, 1, textlen - 1, _tracefile);
+      fputc(0, _tracefile);
+    }
+  size = canon_trace_record_size(&r);
+  used = sizeof(r) + ndoubles * sizeof(double) + nints * sizeof(int32_t)
+    + textlen;
+  fwrite(pad, 1, size - used, _tracefile);
+}
+
+static void trace0(int op)
+{trace(op, -1, 0, NULL, 0, NULL, NULL);}
+
+static void trace_double(int op, double d)
+{trace(op, -1, 1, &d, 0, NULL, NULL);}
+
+static void trace_int(int op, int i)
+{trace(op, -1, 0, NULL, 1, &i, NULL);}
+
+static void trace_pose(int op, int line,
+                       double x, double y, double z,
+                       double a, double b, double c,
+                       double u, double v, double w)
+{
+  double d[9] = {x, y, z, a, b, c, u, v, w};
+  trace(op, line, 9, d, 0, NULL, NULL);
+}
+
+/* A call the replay can't reproduce, because the program may depend on
+its outcome.  The trace is still written, but replaying it stops here. */
+static void trace_unsupported(const char *call)
+{
+  if (_tracefile == NULL)
+    return;
+  fprintf(stderr, "canon trace: %s at line %d can't be replayed\n",
+          call, interp_new.line());
+  trace(CANON_TRACE_UNSUPPORTED, -1, 0, NULL, 0, NULL, call);
+}
+
+int canon_trace_open(const char *filename, const char *source)
+{
+  canon_trace_header h;
+  char path[PATH_MAX];
+
+  _tracefile = fopen(filename, "wb");
+  if (_tracefile == NULL)
+    return -1;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, CANON_TRACE_MAGIC, CANON_TRACE_MAGIC_LEN);
+  h.version = CANON_TRACE_VERSION;
+  h.byte_order = CANON_TRACE_BYTE_ORDER;
+  if (source)
+    {
+      /* canterp reports this as its file name */
+      if (realpath(source, path))
+        source = path;
+      strncpy(h.source, source, sizeof(h.source) - 1);
+    }
+  canon_trace_fingerprint(&h.offsets, &h.tools);
+  fwrite(&h, sizeof(h), 1, _tracefile);
+  return 0;
+}
+
+int canon_trace_close()
+{
+  int result;
+
+  if (_tracefile == NULL)
+    return 0;
+  trace(CANON_TRACE_END, -1, 0, NULL, 0, NULL, NULL);
+  result = ferror(_tracefile);
+  if (fclose(_tracefile) != 0)
+    result = -1;
+  _tracefile = NULL;
+  return result ? -1 : 0;
+}
+
 /* Representation */
 
 void SET_XY_ROTATION(double t) {
   fprintf(_outfile, "%5d ", _line_number++);
   print_nc_line_number();
   fprintf(_outfile, "SET_XY_ROTATION(%.4f)\n", t);
+  trace_double(CANON_TRACE_SET_XY_ROTATION, t);
   // CJR XXX 
 }
     
@@ -225,6 +339,10 @@ void SET_G5X_OFFSET(int index,
   print_nc_line_number();
   fprintf(_outfile, "SET_G5X_OFFSET(%d, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f)\n",
           index, x, y, z, a, b, c);
+  {
+    double d[9] = {x, y, z, a, b, c, u, v, w};
+    trace(CANON_TRACE_SET_G5X_OFFSET, -1, 9, d, 1, &index, NULL);
+  }
   _program_position_x = _program_position_x + _g5x_x - x;
   _program_position_y = _program_position_y + _g5x_y - y;
   _program_position_z = _program_position_z + _g5x_z - z;
@@ -247,6 +365,7 @@ void SET_G92_OFFSET(double x, double y, double z,
   print_nc_line_number();
   fprintf(_outfile, "SET_G92_OFFSET(%.4f, %.4f, %.4f, %.4f, %.4f, %.4f)\n",
           x, y, z, a, b, c);
+  trace_pose(CANON_TRACE_SET_G92_OFFSET, -1, x, y, z, a, b, c, u, v, w);
   _program_position_x = _program_position_x + _g92_x - x;
   _program_position_y = _program_position_y + _g92_y - y;
   _program_position_z = _program_position_z + _g92_z - z;
@@ -264,6 +383,7 @@ void SET_G92_OFFSET(double x, double y, double z,
 
 void USE_LENGTH_UNITS(CANON_UNITS in_unit)
 {
+  trace_int(CANON_TRACE_USE_LENGTH_UNITS, in_unit);
   if (in_unit == CANON_UNITS_INCHES)
     {
       PRINT0("USE_LENGTH_UNITS(CANON_UNITS_INCHES)\n");
@@ -314,6 +434,7 @@ void USE_LENGTH_UNITS(CANON_UNITS in_unit)
 void SET_TRAVERSE_RATE(double rate)
 {
   PRINT1("SET_TRAVERSE_RATE(%.4f)\n", rate);
+  trace_double(CANON_TRACE_SET_TRAVERSE_RATE, rate);
   _traverse_rate = rate;
 }
 
@@ -336,6 +457,7 @@ void STRAIGHT_TRAVERSE( int line_number,
          , b /*BB*/
          , c /*CC*/
          );
+  trace_pose(CANON_TRACE_STRAIGHT_TRAVERSE, line_number, x, y, z, a, b, c, u, v, w);
   _program_position_x = x;
   _program_position_y = y;
   _program_position_z = z;
@@ -348,11 +470,13 @@ void STRAIGHT_TRAVERSE( int line_number,
 void SET_FEED_MODE(int mode)
 {
   PRINT1("SET_FEED_MODE(%d)\n", mode);
+  trace_int(CANON_TRACE_SET_FEED_MODE, mode);
   _feed_mode = mode;
 }
 void SET_FEED_RATE(double rate)
 {
   PRINT1("SET_FEED_RATE(%.4f)\n", rate);
+  trace_double(CANON_TRACE_SET_FEED_RATE, rate);
   _feed_rate = rate;
 }
 
@@ -360,10 +484,15 @@ void SET_FEED_REFERENCE(CANON_FEED_REFERENCE reference)
 {
   PRINT1("SET_FEED_REFERENCE(%s)\n",
          (reference == CANON_WORKPIECE) ? "CANON_WORKPIECE" : "CANON_XYZ");
+  trace_int(CANON_TRACE_SET_FEED_REFERENCE, reference);
 }
 
 extern void SET_MOTION_CONTROL_MODE(CANON_MOTION_MODE mode, double tolerance)
 {
+  {
+    int m = mode;
+    trace(CANON_TRACE_SET_MOTION_CONTROL_MODE, -1, 1, &tolerance, 1, &m, NULL);
+  }
   motion_tolerance = 0;
   if (mode == CANON_EXACT_STOP)
     {
@@ -389,6 +518,7 @@ extern void SET_NAIVECAM_TOLERANCE(double tolerance)
 {
   naivecam_tolerance = tolerance;
   PRINT1("SET_NAIVECAM_TOLERANCE(%.4f)\n", tolerance);
+  trace_double(CANON_TRACE_SET_NAIVECAM_TOLERANCE, tolerance);
 }
 
 void SELECT_PLANE(CANON_PLANE in_plane)
@@ -397,26 +527,31 @@ void SELECT_PLANE(CANON_PLANE in_plane)
          ((in_plane == CANON_PLANE_XY) ? "XY" :
           (in_plane == CANON_PLANE_YZ) ? "YZ" :
           (in_plane == CANON_PLANE_XZ) ? "XZ" : "UNKNOWN"));
+  trace_int(CANON_TRACE_SELECT_PLANE, in_plane);
   _active_plane = in_plane;
 }
 
 void SET_CUTTER_RADIUS_COMPENSATION(double radius)
-{PRINT1("SET_CUTTER_RADIUS_COMPENSATION(%.4f)\n", radius);}
+{trace_double(CANON_TRACE_SET_CUTTER_RADIUS_COMPENSATION, radius);
+ PRINT1("SET_CUTTER_RADIUS_COMPENSATION(%.4f)\n", radius);}
 
 void START_CUTTER_RADIUS_COMPENSATION(int side)
-{PRINT1("START_CUTTER_RADIUS_COMPENSATION(%s)\n",
+{trace_int(CANON_TRACE_START_CUTTER_RADIUS_COMPENSATION, side);
+ PRINT1("START_CUTTER_RADIUS_COMPENSATION(%s)\n",
         (side == CANON_SIDE_LEFT)  ? "LEFT"  :
         (side == CANON_SIDE_RIGHT) ? "RIGHT" : "UNKNOWN");
 }
 
 void STOP_CUTTER_RADIUS_COMPENSATION()
-{PRINT0 ("STOP_CUTTER_RADIUS_COMPENSATION()\n");}
+{trace0(CANON_TRACE_STOP_CUTTER_RADIUS_COMPENSATION);
+ PRINT0 ("STOP_CUTTER_RADIUS_COMPENSATION()\n");}
 
 void START_SPEED_FEED_SYNCH()
 {PRINT0 ("START_SPEED_FEED_SYNCH()\n");}
 
 void STOP_SPEED_FEED_SYNCH()
-{PRINT0 ("STOP_SPEED_FEED_SYNCH()\n");}
+{trace0(CANON_TRACE_STOP_SPEED_FEED_SYNCH);
+ PRINT0 ("STOP_SPEED_FEED_SYNCH()\n");}
 
 /* Machining Functions */
 
@@ -426,6 +561,7 @@ std::vector<CONTROL_POINT> nurbs_control_points, unsigned int k)
   fprintf(_outfile, "%5d ", _line_number++);
   print_nc_line_number();
   fprintf(_outfile, "NURBS_FEED(%lu, ...)\n", (unsigned long)nurbs_control_points.size());
+  trace_unsupported("NURBS_FEED");
 
   _program_position_x = nurbs_control_points[nurbs_control_points.size()].X;
   _program_position_y = nurbs_control_points[nurbs_control_points.size()].Y;
@@ -452,6 +588,11 @@ void ARC_FEED(int line_number,
          , b /*BB*/
          , c /*CC*/
          );
+  {
+    double d[11] = {first_end, second_end, first_axis, second_axis,
+                    axis_end_point, a, b, c, u, v, w};
+    trace(CANON_TRACE_ARC_FEED, line_number, 11, d, 1, &rotation, NULL);
+  }
   if (_active_plane == CANON_PLANE_XY)
     {
       _program_position_x = first_end;
@@ -494,6 +635,7 @@ void STRAIGHT_FEED(int line_number,
          , b /*BB*/
          , c /*CC*/
          );
+  trace_pose(CANON_TRACE_STRAIGHT_FEED, line_number, x, y, z, a, b, c, u, v, w);
   _program_position_x = x;
   _program_position_y = y;
   _program_position_z = z;
@@ -526,6 +668,7 @@ void STRAIGHT_PROBE(int line_number,
 
   fprintf(_outfile, "%5d ", _line_number++);
   print_nc_line_number();
+  trace_unsupported("STRAIGHT_PROBE");
   fprintf(_outfile, "STRAIGHT_PROBE(%.4f, %.4f, %.4f"
          ", %.4f" /*AA*/
          ", %.4f" /*BB*/
@@ -561,12 +704,17 @@ void RIGID_TAP(int line_number, double x, double y, double z)
     fprintf(_outfile, "%5d ", _line_number++);
     print_nc_line_number();
     fprintf(_outfile, "RIGID_TAP(%.4f, %.4f, %.4f)\n", x, y, z);
+    {
+      double d[3] = {x, y, z};
+      trace(CANON_TRACE_RIGID_TAP, line_number, 3, d, 0, NULL, NULL);
+    }
 
 }
 
 
 void DWELL(double seconds)
-{PRINT1("DWELL(%.4f)\n", seconds);}
+{trace_double(CANON_TRACE_DWELL, seconds);
+ PRINT1("DWELL(%.4f)\n", seconds);}
 
 /* Spindle Functions */
 void SPINDLE_RETRACT_TRAVERSE()
@@ -574,11 +722,13 @@ void SPINDLE_RETRACT_TRAVERSE()
 
 void SET_SPINDLE_MODE(double arg) {
   PRINT1("SET_SPINDLE_MODE(%.4f)\n", arg);
+  trace_double(CANON_TRACE_SET_SPINDLE_MODE, arg);
 }
 
 void START_SPINDLE_CLOCKWISE(int wait_for_atspeed)
 {
   PRINT0("START_SPINDLE_CLOCKWISE()\n");
+  trace_int(CANON_TRACE_START_SPINDLE_CLOCKWISE, wait_for_atspeed);
   _spindle_turning = ((_spindle_speed == 0) ? CANON_STOPPED :
                                                    CANON_CLOCKWISE);
 }
@@ -586,6 +736,7 @@ void START_SPINDLE_CLOCKWISE(int wait_for_atspeed)
 void START_SPINDLE_COUNTERCLOCKWISE(int wait_for_atspeed)
 {
   PRINT0("START_SPINDLE_COUNTERCLOCKWISE()\n");
+  trace_int(CANON_TRACE_START_SPINDLE_COUNTERCLOCKWISE, wait_for_atspeed);
   _spindle_turning = ((_spindle_speed == 0) ? CANON_STOPPED :
                                                    CANON_COUNTERCLOCKWISE);
 }
@@ -593,12 +744,14 @@ void START_SPINDLE_COUNTERCLOCKWISE(int wait_for_atspeed)
 void SET_SPINDLE_SPEED(double rpm)
 {
   PRINT1("SET_SPINDLE_SPEED(%.4f)\n", rpm);
+  trace_double(CANON_TRACE_SET_SPINDLE_SPEED, rpm);
   _spindle_speed = rpm;
 }
 
 void STOP_SPINDLE_TURNING()
 {
   PRINT0("STOP_SPINDLE_TURNING()\n");
+  trace0(CANON_TRACE_STOP_SPINDLE_TURNING);
   _spindle_turning = CANON_STOPPED;
 }
 
@@ -606,12 +759,14 @@ void SPINDLE_RETRACT()
 {PRINT0("SPINDLE_RETRACT()\n");}
 
 void ORIENT_SPINDLE(double orientation, int mode)
-{PRINT2("ORIENT_SPINDLE(%.4f, %d)\n", orientation,mode);
+{trace(CANON_TRACE_ORIENT_SPINDLE, -1, 1, &orientation, 1, &mode, NULL);
+ PRINT2("ORIENT_SPINDLE(%.4f, %d)\n", orientation,mode);
 }
 
 void WAIT_SPINDLE_ORIENT_COMPLETE(double timeout) 
 {
   PRINT1("SPINDLE_WAIT_ORIENT_COMPLETE(%.4f)\n", timeout);
+  trace_double(CANON_TRACE_WAIT_SPINDLE_ORIENT_COMPLETE, timeout);
 }
 
 void USE_NO_SPINDLE_FORCE()
@@ -620,16 +775,26 @@ void USE_NO_SPINDLE_FORCE()
 /* Tool Functions */
 void SET_TOOL_TABLE_ENTRY(int pocket, int toolno, EmcPose offset, double diameter,
                           double frontangle, double backangle, int orientation) {
-    _tools[pocket].toolno = toolno;
-    _tools[pocket].offset = offset;
-    _tools[pocket].diameter = diameter;
-    _tools[pocket].frontangle = frontangle;
-    _tools[pocket].backangle = backangle;
-    _tools[pocket].orientation = orientation;
+    CANON_TOOL_TABLE t;
+    t.toolno = toolno;
+    t.offset = offset;
+    t.diameter = diameter;
+    t.frontangle = frontangle;
+    t.backangle = backangle;
+    t.orientation = orientation;
+    _tools.set(pocket, t);
     PRINT14("SET_TOOL_TABLE_ENTRY(%d, %d, %.4f %.4f %.4f %.4f %.4f %.4f %.4f %.4f %.4f, %.4f, %.4f, %d)\n",
             pocket, toolno,
             offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b, offset.c, offset.u, offset.v, offset.w,
             frontangle, backangle, orientation);
+    {
+      double d[12] = {offset.tran.x, offset.tran.y, offset.tran.z,
+                      offset.a, offset.b, offset.c,
+                      offset.u, offset.v, offset.w,
+                      diameter, frontangle, backangle};
+      int i[3] = {pocket, toolno, orientation};
+      trace(CANON_TRACE_SET_TOOL_TABLE_ENTRY, -1, 12, d, 3, i, NULL);
+    }
 }
 
 void USE_TOOL_LENGTH_OFFSET(EmcPose offset)
@@ -637,21 +802,30 @@ void USE_TOOL_LENGTH_OFFSET(EmcPose offset)
     _tool_offset = offset;
     PRINT9("USE_TOOL_LENGTH_OFFSET(%.4f %.4f %.4f, %.4f %.4f %.4f, %.4f %.4f %.4f)\n",
          offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b, offset.c, offset.u, offset.v, offset.w);
+    trace_pose(CANON_TRACE_USE_TOOL_LENGTH_OFFSET, -1,
+               offset.tran.x, offset.tran.y, offset.tran.z,
+               offset.a, offset.b, offset.c, offset.u, offset.v, offset.w);
 }
 
 void CHANGE_TOOL(int slot)
 {
   PRINT1("CHANGE_TOOL(%d)\n", slot);
+  trace_int(CANON_TRACE_CHANGE_TOOL, slot);
   _active_slot = slot;
-  _tools[0] = _tools[slot];
+  _tools.set(0, _tools.get(slot));
 }
 
 void SELECT_POCKET(int slot, int tool)
-{PRINT1("SELECT_POCKET(%d)\n", slot);}
+{
+  int i[2] = {slot, tool};
+  PRINT1("SELECT_POCKET(%d)\n", slot);
+  trace(CANON_TRACE_SELECT_POCKET, -1, 0, NULL, 2, i, NULL);
+}
 
 void CHANGE_TOOL_NUMBER(int slot)
 {
   PRINT1("CHANGE_TOOL_NUMBER(%d)\n", slot);
+  trace_int(CANON_TRACE_CHANGE_TOOL_NUMBER, slot);
   _active_slot = slot;
 }
 
@@ -668,41 +842,52 @@ void CLAMP_AXIS(CANON_AXIS axis)
         (axis == CANON_AXIS_C) ? "CANON_AXIS_C" : "UNKNOWN");}
 
 void COMMENT(const char *s)
-{PRINT1("COMMENT(\"%s\")\n", s);}
+{trace(CANON_TRACE_COMMENT, -1, 0, NULL, 0, NULL, s);
+ PRINT1("COMMENT(\"%s\")\n", s);}
 
 void DISABLE_ADAPTIVE_FEED()
-{PRINT0("DISABLE_ADAPTIVE_FEED()\n");}
+{trace0(CANON_TRACE_DISABLE_ADAPTIVE_FEED);
+ PRINT0("DISABLE_ADAPTIVE_FEED()\n");}
 
 void DISABLE_FEED_HOLD()
-{PRINT0("DISABLE_FEED_HOLD()\n");}
+{trace0(CANON_TRACE_DISABLE_FEED_HOLD);
+ PRINT0("DISABLE_FEED_HOLD()\n");}
 
 void DISABLE_FEED_OVERRIDE()
-{PRINT0("DISABLE_FEED_OVERRIDE()\n"); fo_enable = false; }
+{PRINT0("DISABLE_FEED_OVERRIDE()\n"); fo_enable = false;
+ trace0(CANON_TRACE_DISABLE_FEED_OVERRIDE);}
 
 void DISABLE_SPEED_OVERRIDE()
-{PRINT0("DISABLE_SPEED_OVERRIDE()\n"); so_enable = false; }
+{PRINT0("DISABLE_SPEED_OVERRIDE()\n"); so_enable = false;
+ trace0(CANON_TRACE_DISABLE_SPEED_OVERRIDE);}
 
 void ENABLE_ADAPTIVE_FEED()
-{PRINT0("ENABLE_ADAPTIVE_FEED()\n");}
+{trace0(CANON_TRACE_ENABLE_ADAPTIVE_FEED);
+ PRINT0("ENABLE_ADAPTIVE_FEED()\n");}
 
 void ENABLE_FEED_HOLD()
-{PRINT0("ENABLE_FEED_HOLD()\n");}
+{trace0(CANON_TRACE_ENABLE_FEED_HOLD);
+ PRINT0("ENABLE_FEED_HOLD()\n");}
 
 void ENABLE_FEED_OVERRIDE()
-{PRINT0("ENABLE_FEED_OVERRIDE()\n"); fo_enable = true; }
+{PRINT0("ENABLE_FEED_OVERRIDE()\n"); fo_enable = true;
+ trace0(CANON_TRACE_ENABLE_FEED_OVERRIDE);}
 
 void ENABLE_SPEED_OVERRIDE()
-{PRINT0("ENABLE_SPEED_OVERRIDE()\n"); so_enable = true; }
+{PRINT0("ENABLE_SPEED_OVERRIDE()\n"); so_enable = true;
+ trace0(CANON_TRACE_ENABLE_SPEED_OVERRIDE);}
 
 void FLOOD_OFF()
 {
   PRINT0("FLOOD_OFF()\n");
+  trace0(CANON_TRACE_FLOOD_OFF);
   _flood = 0;
 }
 
 void FLOOD_ON()
 {
   PRINT0("FLOOD_ON()\n");
+  trace0(CANON_TRACE_FLOOD_ON);
   _flood = 1;
 }
 
@@ -711,37 +896,47 @@ void INIT_CANON()
 }
 
 void MESSAGE(char *s)
-{PRINT1("MESSAGE(\"%s\")\n", s);}
+{trace(CANON_TRACE_MESSAGE, -1, 0, NULL, 0, NULL, s);
+ PRINT1("MESSAGE(\"%s\")\n", s);}
 
 void LOG(char *s)
-{PRINT1("LOG(\"%s\")\n", s);}
+{trace_unsupported("LOG");
+ PRINT1("LOG(\"%s\")\n", s);}
 void LOGOPEN(char *s)
-{PRINT1("LOGOPEN(\"%s\")\n", s);}
+{trace_unsupported("LOGOPEN");
+ PRINT1("LOGOPEN(\"%s\")\n", s);}
 void LOGAPPEND(char *s)
-{PRINT1("LOGAPPEND(\"%s\")\n", s);}
+{trace_unsupported("LOGAPPEND");
+ PRINT1("LOGAPPEND(\"%s\")\n", s);}
 void LOGCLOSE()
-{PRINT0("LOGCLOSE()\n");}
+{trace_unsupported("LOGCLOSE");
+ PRINT0("LOGCLOSE()\n");}
 
 void MIST_OFF()
 {
   PRINT0("MIST_OFF()\n");
+  trace0(CANON_TRACE_MIST_OFF);
   _mist = 0;
 }
 
 void MIST_ON()
 {
   PRINT0("MIST_ON()\n");
+  trace0(CANON_TRACE_MIST_ON);
   _mist = 1;
 }
 
 void PALLET_SHUTTLE()
-{PRINT0("PALLET_SHUTTLE()\n");}
+{trace0(CANON_TRACE_PALLET_SHUTTLE);
+ PRINT0("PALLET_SHUTTLE()\n");}
 
 void TURN_PROBE_OFF()
-{PRINT0("TURN_PROBE_OFF()\n");}
+{trace0(CANON_TRACE_TURN_PROBE_OFF);
+ PRINT0("TURN_PROBE_OFF()\n");}
 
 void TURN_PROBE_ON()
-{PRINT0("TURN_PROBE_ON()\n");}
+{trace0(CANON_TRACE_TURN_PROBE_ON);
+ PRINT0("TURN_PROBE_ON()\n");}
 
 void UNCLAMP_AXIS(CANON_AXIS axis)
 {PRINT1("UNCLAMP_AXIS(%s)\n",
@@ -755,7 +950,8 @@ void UNCLAMP_AXIS(CANON_AXIS axis)
 /* Program Functions */
 
 void PROGRAM_STOP()
-{PRINT0("PROGRAM_STOP()\n");}
+{trace0(CANON_TRACE_PROGRAM_STOP);
+ PRINT0("PROGRAM_STOP()\n");}
 
 void SET_BLOCK_DELETE(bool state)
 {block_delete = state;} //state == ON, means we don't interpret lines starting with "/"
@@ -770,10 +966,12 @@ bool GET_OPTIONAL_PROGRAM_STOP()
 {return optional_program_stop;} //state == ON, means we stop
 
 void OPTIONAL_PROGRAM_STOP()
-{PRINT0("OPTIONAL_PROGRAM_STOP()\n");}
+{trace0(CANON_TRACE_OPTIONAL_PROGRAM_STOP);
+ PRINT0("OPTIONAL_PROGRAM_STOP()\n");}
 
 void PROGRAM_END()
-{PRINT0("PROGRAM_END()\n");}
+{trace0(CANON_TRACE_PROGRAM_END);
+ PRINT0("PROGRAM_END()\n");}
 
 
 /*************************************************************************/
@@ -803,16 +1001,25 @@ double GET_EXTERNAL_MOTION_CONTROL_TOLERANCE() { return motion_tolerance;}
 double GET_EXTERNAL_LENGTH_UNITS() {return 0.03937007874016;}
 int GET_EXTERNAL_FEED_HOLD_ENABLE() {return 1;}
 int GET_EXTERNAL_AXIS_MASK() {return 0x3f;} // XYZABC machine
+long GET_EXTERNAL_CANON_COUNT() {return _line_number;}
 double GET_EXTERNAL_ANGLE_UNITS() {return 1.0;}
 int GET_EXTERNAL_SELECTED_TOOL_SLOT() { return 0; }
 int GET_EXTERNAL_SPINDLE_OVERRIDE_ENABLE() {return so_enable;}
 void START_SPEED_FEED_SYNCH(double sync, bool vel)
-{PRINT2("START_SPEED_FEED_SYNC(%f,%d)\n", sync, vel);}
+{
+  int v = vel;
+  PRINT2("START_SPEED_FEED_SYNC(%f,%d)\n", sync, vel);
+  trace(CANON_TRACE_START_SPEED_FEED_SYNCH, -1, 1, &sync, 1, &v, NULL);
+}
 CANON_MOTION_MODE motion_mode;
 
 int GET_EXTERNAL_DIGITAL_INPUT(int index, int def) { return def; }
 double GET_EXTERNAL_ANALOG_INPUT(int index, double def) { return def; }
-int WAIT(int index, int input_type, int wait_type, double timeout) { return 0; }
+int WAIT(int index, int input_type, int wait_type, double timeout)
+{
+  trace_unsupported("WAIT");
+  return 0;
+}
 int UNLOCK_ROTARY(int line_no, int joint_num) {return 0;}
 int LOCK_ROTARY(int line_no, int joint_num) {return 0;}
 
@@ -1021,14 +1228,14 @@ extern int GET_EXTERNAL_TOOL_SLOT()
 /* Returns maximum number of pockets */
 int GET_EXTERNAL_POCKETS_MAX()
 {
-  return _pockets_max;
+  return _tools.pockets();
 }
 
 /* Returns the CANON_TOOL_TABLE structure associated with the tool
    in the given pocket */
 extern CANON_TOOL_TABLE GET_EXTERNAL_TOOL_TABLE(int pocket)
 {
-  return _tools[pocket];
+  return _tools.get(pocket);
 }
 
 /* Returns the system traverse rate */
@@ -1053,36 +1260,42 @@ int USER_DEFINED_FUNCTION_ADD(USER_DEFINED_FUNCTION_TYPE func, int num)
 void SET_MOTION_OUTPUT_BIT(int index)
 {
     PRINT1("SET_MOTION_OUTPUT_BIT(%d)\n", index);
+    trace_int(CANON_TRACE_SET_MOTION_OUTPUT_BIT, index);
     return;
 }
 
 void CLEAR_MOTION_OUTPUT_BIT(int index)
 {
     PRINT1("CLEAR_MOTION_OUTPUT_BIT(%d)\n", index);
+    trace_int(CANON_TRACE_CLEAR_MOTION_OUTPUT_BIT, index);
     return;
 }
 
 void SET_MOTION_OUTPUT_VALUE(int index, double value)
 {
     PRINT2("SET_MOTION_OUTPUT_VALUE(%d,%f)\n", index, value);
+    trace(CANON_TRACE_SET_MOTION_OUTPUT_VALUE, -1, 1, &value, 1, &index, NULL);
     return;
 }
 
 void SET_AUX_OUTPUT_BIT(int index)
 {
     PRINT1("SET_AUX_OUTPUT_BIT(%d)\n", index);
+    trace_int(CANON_TRACE_SET_AUX_OUTPUT_BIT, index);
     return;
 }
 
 void CLEAR_AUX_OUTPUT_BIT(int index)
 {
     PRINT1("CLEAR_AUX_OUTPUT_BIT(%d)\n", index);
+    trace_int(CANON_TRACE_CLEAR_AUX_OUTPUT_BIT, index);
     return;
 }
 
 void SET_AUX_OUTPUT_VALUE(int index, double value)
 {
     PRINT2("SET_AUX_OUTPUT_VALUE(%d,%f)\n", index, value);
+    trace(CANON_TRACE_SET_AUX_OUTPUT_VALUE, -1, 1, &value, 1, &index, NULL);
     return;
 }
 
@@ -1133,10 +1346,12 @@ double GET_EXTERNAL_TOOL_LENGTH_WOFFSET()
 
 void FINISH(void) {
     PRINT0("FINISH()\n");
+    trace0(CANON_TRACE_FINISH);
 }
 
 void START_CHANGE(void) {
     PRINT0("START_CHANGE()\n");
+    trace0(CANON_TRACE_START_CHANGE);
 }
 
 
@@ -1175,9 +1390,11 @@ void CANON_ERROR(const char *fmt, ...)
 void PLUGIN_CALL(int len, const char *call)
 {
     printf("PLUGIN_CALL(%d)\n",len);
+    trace_unsupported("PLUGIN_CALL");
 }
 
 void IO_PLUGIN_CALL(int len, const char *call)
 {
     printf("IO_PLUGIN_CALL(%d)\n",len);
+    trace_unsupported("IO_PLUGIN_CALL");
 }
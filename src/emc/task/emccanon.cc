@@ -42,6 +42,8 @@
 #include "canon_position.hh"		// data type for a machine position
 #include "interpl.hh"		// interp_list
 #include "emcglb.h"		// TRAJ_MAX_VELOCITY
+#include "toolstore.hh"		// ToolStore
+#include "task.hh"		// readahead_status_lock()
 
 //#define EMCCANON_DEBUG
 
@@ -357,8 +359,21 @@ static void to_prog(CANON_POSITION &e) {
     e.w = TO_PROG_LEN(e.w);
 }
 
+/* emcStatus as the interpreter may read it, which is a copy while it runs
+   on the readahead thread; see readahead_status_lock().  The copy is
+   locked while one of these exists, so don't nest them. */
+class ext_status {
+  public:
+    ext_status() : status(readahead_status_lock()) {}
+    ~ext_status() { readahead_status_unlock(); }
+    const EMC_STAT *operator->() const { return status; }
+  private:
+    const EMC_STAT *status;
+};
+
 static int axis_valid(int n) {
-    return emcStatus->motion.traj.axis_mask & (1<<n);
+    ext_status status;
+    return status->motion.traj.axis_mask & (1<<n);
 }
 
 static void canonUpdateEndPoint(double x, double y, double z, 
@@ -809,9 +824,165 @@ struct pt { double x, y, z, a, b, c, u, v, w; int line_no;};
 
 static std::vector<struct pt> chained_points;
 
+/* Naive CAM chaining collects consecutive STRAIGHT_FEEDs that can be
+   replaced by a single move staying within canon.naivecamTolerance of
+   every original vertex and chord.  A chain is first grown as a line;
+   once that fails it may continue as a circular arc through the start
+   point, its middle point and its last point. */
+enum chain_type { CHAIN_LINE, CHAIN_ARC };
+static chain_type chained_type = CHAIN_LINE;
+
+// Each new point is checked against every point already in the chain,
+// so the chain is cut here to bound the work per STRAIGHT_FEED and how
+// long motion waits for the chain to be flushed
+#define MAX_CHAINED_POINTS 1000
+// An arc is only worth fitting when it replaces at least this many segments
+#define MIN_ARC_CHAINED_POINTS 3
+
+struct fitted_arc {
+    PM_CARTESIAN center;
+    PM_CARTESIAN normal;
+    double radius;
+    double angle;
+};
+
+static PM_CARTESIAN pt_xyz(const struct pt &p) {
+    return PM_CARTESIAN(p.x, p.y, p.z);
+}
+
+/* Angle of p around center/normal, measured from the chain start
+   direction, in [0, 2pi) */
+static double arc_angle(const fitted_arc &arc, const PM_CARTESIAN &start_rel,
+                        const PM_CARTESIAN &p) {
+    PM_CARTESIAN rel = p - arc.center;
+    double theta = atan2(dot(cross(start_rel, rel), arc.normal),
+                         dot(start_rel, rel));
+    if(theta < 0) theta += 2 * M_PI;
+    return theta;
+}
+
+/* Fit the chained points (which start at canon.endPoint) with a single
+   arc in an arbitrary plane.  Returns false if any vertex or chord of the
+   original polyline would be further than the naive CAM tolerance from
+   the arc, or if the points do not advance monotonically around it. */
+static bool fit_arc(const std::vector<struct pt> &points, fitted_arc &arc) {
+    double tol = canon.naivecamTolerance;
+    size_t n = points.size();
+    if(n < MIN_ARC_CHAINED_POINTS) return false;
+
+    PM_CARTESIAN S = canon.endPoint.xyz();
+    PM_CARTESIAN M = pt_xyz(points[(n - 1) / 2]);
+    PM_CARTESIAN E = pt_xyz(points[n - 1]);
+
+    // Circle through three points
+    PM_CARTESIAN a = M - S, b = E - S;
+    PM_CARTESIAN axb = cross(a, b);
+    double axb2 = dot(axb, axb);
+    if(axb2 <= 1e-12 * dot(a, a) * dot(b, b)) return false;
+    arc.center = S + (dot(a, a) * cross(b, axb) + dot(b, b) * cross(axb, a))
+        / (2 * axb2);
+    arc.normal = unit(axb);
+    arc.radius = mag(S - arc.center);
+
+    PM_CARTESIAN start_rel = S - arc.center;
+    PM_CARTESIAN last = S;
+    double last_angle = 0;
+    for(size_t i = 0; i < n; i++) {
+        if(points[i].a != canon.endPoint.a || points[i].b != canon.endPoint.b
+                || points[i].c != canon.endPoint.c
+                || points[i].u != canon.endPoint.u
+                || points[i].v != canon.endPoint.v
+                || points[i].w != canon.endPoint.w)
+            return false;
+
+        PM_CARTESIAN P = pt_xyz(points[i]);
+        PM_CARTESIAN rel = P - arc.center;
+        if(fabs(dot(rel, arc.normal)) > tol) return false;
+        if(fabs(mag(rel) - arc.radius) > tol) return false;
+
+        double theta = arc_angle(arc, start_rel, P);
+        if(theta <= last_angle) return false;
+
+        // the chord may not stray further from the arc than its sagitta
+        double half = mag(P - last) / 2;
+        if(half > arc.radius) return false;
+        if(arc.radius - sqrt(arc.radius * arc.radius - half * half) > tol)
+            return false;
+
+        last = P;
+        last_angle = theta;
+    }
+    arc.angle = last_angle;
+    return true;
+}
+
+static void flush_arc(void) {
+    struct pt &pos = chained_points.back();
+    fitted_arc arc;
+    if(!fit_arc(chained_points, arc)) {
+        // can't happen: the chain was checked as each point was added
+        chained_type = CHAIN_LINE;
+        return;
+    }
+
+    CANON_POSITION endpt(pos.x, pos.y, pos.z, pos.a, pos.b, pos.c,
+                         pos.u, pos.v, pos.w);
+
+    // The plane is arbitrary, so use the most restrictive XYZ axis limits
+    double v_max_axes = 1e99, a_max_axes = 1e99;
+    for(int axis = 0; axis < 3; axis++) {
+        if(!axis_valid(axis)) continue;
+        v_max_axes = MIN(v_max_axes, FROM_EXT_LEN(emcAxisGetMaxVelocity(axis)));
+        a_max_axes = MIN(a_max_axes, FROM_EXT_LEN(emcAxisGetMaxAcceleration(axis)));
+    }
+    double a_max_normal = a_max_axes * sqrt(3.0)/2.0;
+    double v_max_planar = MIN(sqrt(a_max_normal * arc.radius), v_max_axes);
+    double length = arc.radius * arc.angle;
+
+    VelData veldata = getStraightVelocity(endpt);
+    double t_max = fmax(veldata.tmax, length / v_max_planar);
+    double v_max = length / t_max;
+
+    AccelData accdata = getStraightAcceleration(endpt);
+    double tt_max = fmax(accdata.tmax, length / a_max_axes);
+    double a_max = length / tt_max;
+
+    double vel = MIN(canon.linearFeedRate, v_max);
+    canon.cartesian_move = 1;
+
+#ifdef SHOW_JOINED_SEGMENTS
+    for(unsigned int i=0; i != chained_points.size(); i++) { printf(")"); }
+    printf("\n");
+#endif
+
+    EMC_TRAJ_CIRCULAR_MOVE circularMoveMsg;
+    circularMoveMsg.feed_mode = canon.feed_mode;
+    circularMoveMsg.end = to_ext_pose(endpt);
+    circularMoveMsg.center = to_ext_len(arc.center);
+    circularMoveMsg.normal = to_ext_len(arc.normal);
+    circularMoveMsg.turn = 0;
+    circularMoveMsg.type = EMC_MOTION_TYPE_ARC;
+    circularMoveMsg.vel = toExtVel(vel);
+    circularMoveMsg.ini_maxvel = toExtVel(v_max);
+    circularMoveMsg.acc = toExtAcc(a_max);
+    if((vel && a_max) || canon.synched) {
+        interp_list.set_line_number(pos.line_no);
+        interp_list.append(circularMoveMsg);
+    }
+    canonUpdateEndPoint(endpt);
+
+    chained_points.clear();
+    chained_type = CHAIN_LINE;
+}
+
 static void flush_segments(void) {
     if(chained_points.empty()) return;
 
+    if(chained_type == CHAIN_ARC) {
+        flush_arc();
+        if(chained_points.empty()) return;
+    }
+
     struct pt &pos = chained_points.back();
 
     double x = pos.x, y = pos.y, z = pos.z;
@@ -875,6 +1046,7 @@ static void flush_segments(void) {
     canonUpdateEndPoint(x, y, z, a, b, c, u, v, w);
 
     chained_points.clear();
+    chained_type = CHAIN_LINE;
 }
 
 static void get_last_pos(double &lx, double &ly, double &lz) {
@@ -890,27 +1062,23 @@ static void get_last_pos(double &lx, double &ly, double &lz) {
     }
 }
 
+static bool naivecam_enabled(void) {
+    return canon.motionMode == CANON_CONTINUOUS && canon.naivecamTolerance != 0;
+}
+
+/* ABCUVW may be chained along with XYZ as long as they move linearly with
+   the XYZ position; each is held to the same tolerance in its own units. */
 static bool
 linkable(double x, double y, double z, 
          double a, double b, double c, 
          double u, double v, double w) {
-    struct pt &pos = chained_points.back();
-    if(canon.motionMode != CANON_CONTINUOUS || canon.naivecamTolerance == 0)
+    if(!naivecam_enabled())
         return false;
-    //FIXME make this length controlled elsewhere?
-    if(chained_points.size() > 100) return false;
-
-    //If ABCUVW motion, then the tangent calculation fails?
-    // TODO is there a fundamental reason that we can't handle 9D motion here?
-    if(a != pos.a) return false;
-    if(b != pos.b) return false;
-    if(c != pos.c) return false;
-    if(u != pos.u) return false;
-    if(v != pos.v) return false;
-    if(w != pos.w) return false;
+    if(chained_points.size() >= MAX_CHAINED_POINTS) return false;
 
     if(x==canon.endPoint.x && y==canon.endPoint.y && z==canon.endPoint.z) return false;
     
+    double tol = canon.naivecamTolerance;
     for(std::vector<struct pt>::iterator it = chained_points.begin();
             it != chained_points.end(); it++) {
         PM_CARTESIAN M(x-canon.endPoint.x, y-canon.endPoint.y, z-canon.endPoint.z),
@@ -921,32 +1089,54 @@ linkable(double x, double y, double z,
         if(t0 > 1) t0 = 1;
 
         double D = mag(P - (B + t0 * M));
-        if(D > canon.naivecamTolerance) return false;
+        if(D > tol) return false;
+
+        if(fabs(it->a - (canon.endPoint.a + t0 * (a - canon.endPoint.a))) > tol) return false;
+        if(fabs(it->b - (canon.endPoint.b + t0 * (b - canon.endPoint.b))) > tol) return false;
+        if(fabs(it->c - (canon.endPoint.c + t0 * (c - canon.endPoint.c))) > tol) return false;
+        if(fabs(it->u - (canon.endPoint.u + t0 * (u - canon.endPoint.u))) > tol) return false;
+        if(fabs(it->v - (canon.endPoint.v + t0 * (v - canon.endPoint.v))) > tol) return false;
+        if(fabs(it->w - (canon.endPoint.w + t0 * (w - canon.endPoint.w))) > tol) return false;
     }
     return true;
 }
 
+/* Try to continue the chain, including the point just pushed, as an arc */
+static bool
+arc_linkable(void) {
+    if(!naivecam_enabled())
+        return false;
+    if(chained_points.size() > MAX_CHAINED_POINTS) return false;
+    fitted_arc arc;
+    return fit_arc(chained_points, arc);
+}
+
 static void
 see_segment(int line_number,
 	    double x, double y, double z, 
             double a, double b, double c,
             double u, double v, double w) {
-    bool changed_abc = (a != canon.endPoint.a)
-        || (b != canon.endPoint.b)
-        || (c != canon.endPoint.c);
+    pt pos = {x, y, z, a, b, c, u, v, w, line_number};
 
-    bool changed_uvw = (u != canon.endPoint.u)
-        || (v != canon.endPoint.v)
-        || (w != canon.endPoint.w);
+    if(chained_points.empty()) {
+        chained_points.push_back(pos);
+        return;
+    }
 
-    if(!chained_points.empty() && !linkable(x, y, z, a, b, c, u, v, w)) {
-        flush_segments();
+    if(chained_type == CHAIN_LINE && linkable(x, y, z, a, b, c, u, v, w)) {
+        chained_points.push_back(pos);
+        return;
     }
-    pt pos = {x, y, z, a, b, c, u, v, w, line_number};
+
     chained_points.push_back(pos);
-    if(changed_abc || changed_uvw) {
-        flush_segments();
+    if(arc_linkable()) {
+        chained_type = CHAIN_ARC;
+        return;
     }
+    chained_points.pop_back();
+
+    flush_segments();
+    chained_points.push_back(pos);
 }
 
 void FINISH() {
@@ -2518,31 +2708,29 @@ void CANON_ERROR(const char *fmt, ...)
     interp_list.append(operator_error_msg);
 }
 
+/* iocontrol's tool table, as of the last io status we got */
+static ToolStore &tool_store()
+{
+    static ToolStore tools;
+    ext_status status;
+
+    tools.follow(status->io.tool);
+    return tools;
+}
+
 /*
   GET_EXTERNAL_TOOL_TABLE(int pocket)
 
   Returns the tool table structure associated with pocket. Note that
-  pocket can run from 0 (by definition, the spindle), to pocket CANON_POCKETS_MAX - 1.
+  pocket can run from 0 (by definition, the spindle), to pocket
+  GET_EXTERNAL_POCKETS_MAX() - 1.
 
   Tool table is always in machine units.
 
   */
 CANON_TOOL_TABLE GET_EXTERNAL_TOOL_TABLE(int pocket)
 {
-    CANON_TOOL_TABLE retval;
-
-    if (pocket < 0 || pocket >= CANON_POCKETS_MAX) {
-	retval.toolno = -1;
-        ZERO_EMC_POSE(retval.offset);
-        retval.frontangle = 0.0;
-        retval.backangle = 0.0;
-	retval.diameter = 0.0;
-        retval.orientation = 0;
-    } else {
-	retval = emcStatus->io.tool.toolTable[pocket];
-    }
-
-    return retval;
+    return tool_store().get(pocket);
 }
 
 CANON_POSITION GET_EXTERNAL_POSITION()
@@ -2552,7 +2740,7 @@ CANON_POSITION GET_EXTERNAL_POSITION()
 
     chained_points.clear();
 
-    pos = emcStatus->motion.traj.position;
+    pos = ext_status()->motion.traj.position;
 
     // first update internal record of last position
     canonUpdateEndPoint(FROM_EXT_LEN(pos.tran.x), FROM_EXT_LEN(pos.tran.y), FROM_EXT_LEN(pos.tran.z),
@@ -2574,7 +2762,7 @@ CANON_POSITION GET_EXTERNAL_PROBE_POSITION()
 
     flush_segments();
 
-    pos = emcStatus->motion.traj.probedPosition;
+    pos = ext_status()->motion.traj.probedPosition;
 
     // first update internal record of last position
     pos.tran.x = FROM_EXT_LEN(pos.tran.x);
@@ -2608,7 +2796,7 @@ CANON_POSITION GET_EXTERNAL_PROBE_POSITION()
 
 int GET_EXTERNAL_PROBE_TRIPPED_VALUE()
 {
-    return emcStatus->motion.traj.probe_tripped;
+    return ext_status()->motion.traj.probe_tripped;
 }
 
 double GET_EXTERNAL_PROBE_VALUE()
@@ -2640,11 +2828,11 @@ double GET_EXTERNAL_FEED_RATE()
 // traverse rate wanted is in program units per minute
 double GET_EXTERNAL_TRAVERSE_RATE()
 {
-    double traverse;
+    double traverse = ext_status()->motion.traj.maxVelocity;
 
     // convert from external to program units
     traverse =
-	TO_PROG_LEN(FROM_EXT_LEN(emcStatus->motion.traj.maxVelocity));
+	TO_PROG_LEN(FROM_EXT_LEN(traverse));
 
     // now convert from per-sec to per-minute
     traverse *= 60.0;
@@ -2656,7 +2844,7 @@ double GET_EXTERNAL_LENGTH_UNITS(void)
 {
     double u;
 
-    u = emcStatus->motion.traj.linearUnits;
+    u = ext_status()->motion.traj.linearUnits;
 
     if (u == 0) {
 	CANON_ERROR("external length units are zero");
@@ -2670,7 +2858,7 @@ double GET_EXTERNAL_ANGLE_UNITS(void)
 {
     double u;
 
-    u = emcStatus->motion.traj.angularUnits;
+    u = ext_status()->motion.traj.angularUnits;
 
     if (u == 0) {
 	CANON_ERROR("external angle units are zero");
@@ -2682,12 +2870,12 @@ double GET_EXTERNAL_ANGLE_UNITS(void)
 
 int GET_EXTERNAL_MIST()
 {
-    return emcStatus->io.coolant.mist;
+    return ext_status()->io.coolant.mist;
 }
 
 int GET_EXTERNAL_FLOOD()
 {
-    return emcStatus->io.coolant.flood;
+    return ext_status()->io.coolant.flood;
 }
 
 double GET_EXTERNAL_SPEED()
@@ -2698,11 +2886,13 @@ double GET_EXTERNAL_SPEED()
 
 CANON_DIRECTION GET_EXTERNAL_SPINDLE()
 {
-    if (emcStatus->motion.spindle.speed == 0) {
+    double speed = ext_status()->motion.spindle.speed;
+
+    if (speed == 0) {
 	return CANON_STOPPED;
     }
 
-    if (emcStatus->motion.spindle.speed >= 0.0) {
+    if (speed >= 0.0) {
 	return CANON_CLOCKWISE;
     }
 
@@ -2711,7 +2901,7 @@ CANON_DIRECTION GET_EXTERNAL_SPINDLE()
 
 int GET_EXTERNAL_POCKETS_MAX()
 {
-    return CANON_POCKETS_MAX;
+    return tool_store().pockets();
 }
 
 char _parameter_file_name[LINELEN];	/* Not static.Driver
@@ -2880,7 +3070,7 @@ int GET_EXTERNAL_QUEUE_EMPTY(void)
 {
     flush_segments();
 
-    return emcStatus->motion.traj.queue == 0 ? 1 : 0;
+    return ext_status()->motion.traj.queue == 0 ? 1 : 0;
 }
 
 // Returns the "home pocket" of the tool currently in the spindle, ie the
@@ -2888,13 +3078,11 @@ int GET_EXTERNAL_QUEUE_EMPTY(void)
 // tool in the spindle.
 int GET_EXTERNAL_TOOL_SLOT()
 {
-    int toolno = emcStatus->io.tool.toolInSpindle;
-    int pocket;
+    int tool = ext_status()->io.tool.toolInSpindle;
+    int pocket = tool_store().find(tool);
 
-    for (pocket = 1; pocket < CANON_POCKETS_MAX; pocket++) {
-        if (emcStatus->io.tool.toolTable[pocket].toolno == toolno) {
-            return pocket;
-        }
+    if (pocket > 0) {
+        return pocket;
     }
 
     return 0;  // no tool in spindle
@@ -2906,41 +3094,46 @@ int GET_EXTERNAL_TOOL_SLOT()
 // run, or because an M6 tool change has completed), return -1.
 int GET_EXTERNAL_SELECTED_TOOL_SLOT()
 {
-    return emcStatus->io.tool.pocketPrepped;
+    return ext_status()->io.tool.pocketPrepped;
 }
 
 int GET_EXTERNAL_TC_FAULT()
 {
-    return emcStatus->io.fault;
+    return ext_status()->io.fault;
 }
 
 int GET_EXTERNAL_TC_REASON()
 {
-    return emcStatus->io.reason;
+    return ext_status()->io.reason;
 }
 
 int GET_EXTERNAL_FEED_OVERRIDE_ENABLE()
 {
-    return emcStatus->motion.traj.feed_override_enabled;
+    return ext_status()->motion.traj.feed_override_enabled;
 }
 
 int GET_EXTERNAL_SPINDLE_OVERRIDE_ENABLE()
 {
-    return emcStatus->motion.traj.spindle_override_enabled;
+    return ext_status()->motion.traj.spindle_override_enabled;
 }
 
 int GET_EXTERNAL_ADAPTIVE_FEED_ENABLE()
 {
-    return emcStatus->motion.traj.adaptive_feed_enabled;
+    return ext_status()->motion.traj.adaptive_feed_enabled;
 }
 
 int GET_EXTERNAL_FEED_HOLD_ENABLE()
 {
-    return emcStatus->motion.traj.feed_hold_enabled;
+    return ext_status()->motion.traj.feed_hold_enabled;
 }
 
 int GET_EXTERNAL_AXIS_MASK() {
-    return emcStatus->motion.traj.axis_mask;
+    return ext_status()->motion.traj.axis_mask;
+}
+
+long GET_EXTERNAL_CANON_COUNT()
+{
+    return interp_list.appended();
 }
 
 CANON_PLANE GET_EXTERNAL_PLANE()
@@ -2954,28 +3147,30 @@ int GET_EXTERNAL_DIGITAL_INPUT(int index, int def)
     if ((index < 0) || (index >= EMCMOT_MAX_DIO))
 	return -1;
 
-    if (emcStatus->task.input_timeout == 1)
+    ext_status status;
+    if (status->task.input_timeout == 1)
 	return -1;
 
 #ifdef INPUT_DEBUG
-    printf("GET_EXTERNAL_DIGITAL_INPUT called\n di[%d]=%d \n timeout=%d \n",index,emcStatus->motion.synch_di[index],emcStatus->task.input_timeout);
+    printf("GET_EXTERNAL_DIGITAL_INPUT called\n di[%d]=%d \n timeout=%d \n",index,status->motion.synch_di[index],status->task.input_timeout);
 #endif
-    return (emcStatus->motion.synch_di[index] != 0) ? 1 : 0;
+    return (status->motion.synch_di[index] != 0) ? 1 : 0;
 }
 
 double GET_EXTERNAL_ANALOG_INPUT(int index, double def)
 {
 /* returns current value of the analog input selected by index.*/
+    ext_status status;
 #ifdef INPUT_DEBUG
-    printf("GET_EXTERNAL_ANALOG_INPUT called\n ai[%d]=%g \n timeout=%d \n",index,emcStatus->motion.analog_input[index],emcStatus->task.input_timeout);
+    printf("GET_EXTERNAL_ANALOG_INPUT called\n ai[%d]=%g \n timeout=%d \n",index,status->motion.analog_input[index],status->task.input_timeout);
 #endif
     if ((index < 0) || (index >= EMCMOT_MAX_AIO))
 	return -1;
 
-    if (emcStatus->task.input_timeout == 1)
+    if (status->task.input_timeout == 1)
 	return -1;
 
-    return emcStatus->motion.analog_input[index];
+    return status->motion.analog_input[index];
 }
 
 
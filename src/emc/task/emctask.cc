@@ -28,6 +28,7 @@
 #include "canon.hh"		// CANON_VECTOR, GET_PROGRAM_ORIGIN()
 #include "rs274ngc_interp.hh"	// the interpreter
 #include "interp_return.hh"	// INTERP_FILE_NOT_OPEN
+#include "canon_trace.hh"	// CANON_TRACE_MAGIC
 #include "inifile.hh"
 #include "rcs_print.hh"
 #include "task.hh"		// emcTaskCommand etc
@@ -47,6 +48,14 @@ InterpBase *pinterp=0;
 #define interp (*pinterp)
 setup_pointer _is = 0; // helper for gdb hardware watchpoints FIXME
 
+/*
+  Canon traces written by 'rs274 -o' are run by canterp rather than by
+  the [TASK]INTERPRETER.  While one is open, pinterp points at canterp
+  and the configured interpreter is kept in main_interp.
+*/
+static InterpBase *main_interp = 0;
+static InterpBase *trace_interp = 0;
+
 
 /*
   format string for user-defined programs, e.g., "programs/M1%02d" means
@@ -176,6 +185,7 @@ int emcTaskHalt()
 
 int emcTaskAbort()
 {
+    readahead_join();
     emcMotionAbort();
 
     // clear out the pending command
@@ -413,8 +423,73 @@ static void print_interp_error(int retval)
     }
 }
 
+// read the header of 'file' into 'h' if it is a canon trace
+static int is_canon_trace(const char *file, canon_trace_header *h)
+{
+    FILE *fp = fopen(file, "r");
+    int result = 0;
+
+    if (fp) {
+	result = fread(h, 1, sizeof(*h), fp) == sizeof(*h)
+	    && !memcmp(h->magic, CANON_TRACE_MAGIC, CANON_TRACE_MAGIC_LEN);
+	fclose(fp);
+    }
+    return result;
+}
+
+static void restore_main_interp()
+{
+    if (main_interp) {
+	pinterp = main_interp;
+	main_interp = 0;
+    }
+}
+
+// open 'file' with the interpreter that can run it
+static int plan_open(const char *file)
+{
+    canon_trace_header h;
+
+    if (is_canon_trace(file, &h)) {
+	uint64_t offsets, tools;
+	// the replay re-issues the offsets and tool table entries the
+	// program set, starting from those it was interpreted with; have
+	// the interpreter save its parameters so the var file is current
+	(main_interp ? main_interp : pinterp)->synch();
+	canon_trace_fingerprint(&offsets, &tools);
+	if (h.version == CANON_TRACE_VERSION
+	    && h.byte_order == CANON_TRACE_BYTE_ORDER
+	    && (h.offsets != offsets || h.tools != tools)) {
+	    emcOperatorError(0, "can't run canon trace %s: it was made with "
+			     "other %s", file,
+			     h.offsets != offsets ? (h.tools != tools ?
+			     "offsets and tool table" : "offsets") :
+			     "tool table");
+	    return INTERP_ERROR;
+	}
+	if (!trace_interp) {
+	    trace_interp = interp_from_shlib("libcanterp.so");
+	    if (!trace_interp) {
+		emcOperatorError(0, "can't run canon trace %s: "
+				 "libcanterp.so not loaded", file);
+		return INTERP_ERROR;
+	    }
+	    trace_interp->init();
+	}
+	if (!main_interp) {
+	    main_interp = pinterp;
+	}
+	pinterp = trace_interp;
+    } else {
+	restore_main_interp();
+    }
+    return interp.open(file);
+}
+
 int emcTaskPlanInit()
 {
+    readahead_join();
+    restore_main_interp();
     if(!pinterp) {
 	IniFile inifile;
 	const char *inistring;
@@ -488,18 +563,21 @@ int emcTaskPlanClearWait()
 
 int emcTaskPlanSetOptionalStop(bool state)
 {
+    readahead_join();
     SET_OPTIONAL_PROGRAM_STOP(state);
     return 0;
 }
 
 int emcTaskPlanSetBlockDelete(bool state)
 {
+    readahead_join();
     SET_BLOCK_DELETE(state);
     return 0;
 }
 
 int emcTaskPlanSynch()
 {
+    readahead_join();
     int retval = interp.synch();
 
     if (emc_debug & EMC_DEBUG_INTERP) {
@@ -511,6 +589,8 @@ int emcTaskPlanSynch()
 
 void emcTaskPlanExit()
 {
+    readahead_join();
+    restore_main_interp();
     if (pinterp != NULL) {
         interp.exit();
     }
@@ -518,13 +598,14 @@ void emcTaskPlanExit()
 
 int emcTaskPlanOpen(const char *file)
 {
+    readahead_join();
     if (emcStatus != 0) {
 	emcStatus->task.motionLine = 0;
 	emcStatus->task.currentLine = 0;
 	emcStatus->task.readLine = 0;
     }
 
-    int retval = interp.open(file);
+    int retval = plan_open(file);
     if (retval > INTERP_MIN_ERROR) {
 	print_interp_error(retval);
 	return retval;
@@ -541,10 +622,11 @@ int emcTaskPlanOpen(const char *file)
 
 int emcTaskPlanRead()
 {
+    readahead_join();
     int retval = interp.read();
     if (retval == INTERP_FILE_NOT_OPEN) {
 	if (emcStatus->task.file[0] != 0) {
-	    retval = interp.open(emcStatus->task.file);
+	    retval = plan_open(emcStatus->task.file);
 	    if (retval > INTERP_MIN_ERROR) {
 		print_interp_error(retval);
 	    }
@@ -564,6 +646,7 @@ int emcTaskPlanRead()
 
 int emcTaskPlanExecute(const char *command)
 {
+    readahead_join();
     int inpos = emcStatus->motion.traj.inpos;	// 1 if in position, 0 if not.
 
     if (command != 0) {		// Command is 0 if in AUTO mode, non-null if in MDI mode.
@@ -589,6 +672,7 @@ int emcTaskPlanExecute(const char *command)
 
 int emcTaskPlanExecute(const char *command, int line_number)
 {
+    readahead_join();
     int retval = interp.execute(command, line_number);
     if (retval > INTERP_MIN_ERROR) {
 	print_interp_error(retval);
@@ -606,10 +690,13 @@ int emcTaskPlanExecute(const char *command, int line_number)
 
 int emcTaskPlanClose()
 {
+    readahead_join();
     int retval = interp.close();
     if (retval > INTERP_MIN_ERROR) {
 	print_interp_error(retval);
     }
+    // MDI goes to the configured interpreter again
+    restore_main_interp();
 
     taskplanopen = 0;
     return retval;
@@ -617,16 +704,26 @@ int emcTaskPlanClose()
 
 int emcTaskPlanReset()
 {
+    readahead_join();
     int retval = interp.reset();
     if (retval > INTERP_MIN_ERROR) {
 	print_interp_error(retval);
     }
+    if (main_interp) {
+	interp.close();
+	restore_main_interp();
+	retval = interp.reset();
+	if (retval > INTERP_MIN_ERROR) {
+	    print_interp_error(retval);
+	}
+    }
 
     return retval;
 }
 
 int emcTaskPlanLine()
 {
+    readahead_join();
     int retval = interp.line();
     
     if (emc_debug & EMC_DEBUG_INTERP) {
@@ -638,6 +735,7 @@ int emcTaskPlanLine()
 
 int emcTaskPlanLevel()
 {
+    readahead_join();
     int retval = interp.call_level();
 
     if (emc_debug & EMC_DEBUG_INTERP) {
@@ -649,6 +747,7 @@ int emcTaskPlanLevel()
 
 int emcTaskPlanCommand(char *cmd)
 {
+    readahead_join();
     char buf[LINELEN];
 
     strcpy(cmd, interp.command(buf, LINELEN));
@@ -682,20 +781,24 @@ int emcTaskUpdate(EMC_TASK_STAT * stat)
     // currentLine set in main
     // readLine set in main
 
-    char buf[LINELEN];
-    strcpy(stat->file, interp.file(buf, LINELEN));
-    // command set in main
+    // the interpreter is left alone while the readahead thread runs;
+    // these are refreshed once it has ended its batch
+    if (!readahead_busy()) {
+	char buf[LINELEN];
+	strcpy(stat->file, interp.file(buf, LINELEN));
+	// command set in main
 
-    // update active G and M codes
-    interp.active_g_codes(&stat->activeGCodes[0]);
-    interp.active_m_codes(&stat->activeMCodes[0]);
-    interp.active_settings(&stat->activeSettings[0]);
+	// update active G and M codes
+	interp.active_g_codes(&stat->activeGCodes[0]);
+	interp.active_m_codes(&stat->activeMCodes[0]);
+	interp.active_settings(&stat->activeSettings[0]);
 
-    //update state of optional stop
-    stat->optional_stop_state = GET_OPTIONAL_PROGRAM_STOP();
-    
-    //update state of block delete
-    stat->block_delete_state = GET_BLOCK_DELETE();
+	//update state of optional stop
+	stat->optional_stop_state = GET_OPTIONAL_PROGRAM_STOP();
+
+	//update state of block delete
+	stat->block_delete_state = GET_BLOCK_DELETE();
+    }
     
     stat->heartbeat++;
 
@@ -704,6 +807,7 @@ int emcTaskUpdate(EMC_TASK_STAT * stat)
 
 int emcAbortCleanup(int reason, const char *message)
 {
+    readahead_join();
     int status = interp.on_abort(reason,message);
     if (status > INTERP_MIN_ERROR)
 	print_interp_error(status);
@@ -56,6 +56,8 @@
 #include <unistd.h>		// fork()
 #include <sys/wait.h>		// waitpid(), WNOHANG, WIFEXITED
 #include <ctype.h>		// isspace()
+#include <pthread.h>		// interpreter readahead thread
+#include <typeinfo>		// typeid()
 #include <libintl.h>
 #include <locale.h>
 #include "usrmotintf.h"
@@ -190,6 +192,22 @@ int emcErrorBufferOKtoWrite(int space, const char *caller)
     return 0;
 }
 
+// the interpreter readahead thread reports errors too, so writes to the
+// error channel are serialized
+static pthread_mutex_t emcErrorBufferMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int emcErrorBufferWrite(NMLmsg &msg, const char *caller)
+{
+    int retval = -1;
+
+    pthread_mutex_lock(&emcErrorBufferMutex);
+    if (0 == emcErrorBufferOKtoWrite(msg.size * 2, caller)) {
+	retval = emcErrorBuffer->write(msg);
+    }
+    pthread_mutex_unlock(&emcErrorBufferMutex);
+
+    return retval;
+}
 
 // implementation of EMC error logger
 int emcOperatorError(int id, const char *fmt, ...)
@@ -197,9 +215,6 @@ int emcOperatorError(int id, const char *fmt, ...)
     EMC_OPERATOR_ERROR error_msg;
     va_list ap;
 
-    if ( emcErrorBufferOKtoWrite(sizeof(error_msg) * 2, "emcOperatorError"))
-	return -1;
-
     if (NULL == fmt) {
 	return -1;
     }
@@ -222,7 +237,7 @@ int emcOperatorError(int id, const char *fmt, ...)
 
     // write it
     rcs_print("%s\n", error_msg.error);
-    return emcErrorBuffer->write(error_msg);
+    return emcErrorBufferWrite(error_msg, "emcOperatorError");
 }
 
 int emcOperatorText(int id, const char *fmt, ...)
@@ -230,9 +245,6 @@ int emcOperatorText(int id, const char *fmt, ...)
     EMC_OPERATOR_TEXT text_msg;
     va_list ap;
 
-    if ( emcErrorBufferOKtoWrite(sizeof(text_msg) * 2, "emcOperatorText"))
-	return -1;
-
     // write args to NML message (ignore int text code)
     va_start(ap, fmt);
     vsnprintf(text_msg.text, sizeof(text_msg.text), fmt, ap);
@@ -242,7 +254,7 @@ int emcOperatorText(int id, const char *fmt, ...)
     text_msg.text[LINELEN - 1] = 0;
 
     // write it
-    return emcErrorBuffer->write(text_msg);
+    return emcErrorBufferWrite(text_msg, "emcOperatorText");
 }
 
 int emcOperatorDisplay(int id, const char *fmt, ...)
@@ -250,9 +262,6 @@ int emcOperatorDisplay(int id, const char *fmt, ...)
     EMC_OPERATOR_DISPLAY display_msg;
     va_list ap;
 
-    if ( emcErrorBufferOKtoWrite(sizeof(display_msg) * 2, "emcOperatorDisplay"))
-	return -1;
-
     // write args to NML message (ignore int display code)
     va_start(ap, fmt);
     vsnprintf(display_msg.display, sizeof(display_msg.display), fmt, ap);
@@ -262,7 +271,7 @@ int emcOperatorDisplay(int id, const char *fmt, ...)
     display_msg.display[LINELEN - 1] = 0;
 
     // write it
-    return emcErrorBuffer->write(display_msg);
+    return emcErrorBufferWrite(display_msg, "emcOperatorDisplay");
 }
 
 /*
@@ -485,11 +494,367 @@ static int checkInterpList(NML_INTERP_LIST * il, EMC_STAT * stat)
 }
 extern int emcTaskMopup();
 
+/*
+  Interpreter readahead thread.
+
+  With [TASK]INTERP_THREAD = 1 program lines are read and executed on a
+  worker thread instead of inside emcTaskPlan(), so a slow block (heavy
+  expressions, a long subroutine) no longer holds up command handling,
+  dispatch of interp_list and status updates.  Canon appends to
+  interp_list as before; the list serializes its own access, and reads
+  emcStatus through readahead_status_lock().  Nothing here takes the
+  Python GIL, so the thread is not used when Python is configured.
+
+  The task thread and the worker never use the interpreter at the same
+  time.  readahead_reading() hands the worker a batch of lines and picks
+  up the outcome on a later cycle.  Everything else on the task thread
+  that needs the interpreter calls readahead_join() first, which ends the
+  batch after the line in progress and applies its outcome.  Queue
+  busters still end a batch with INTERP_EXECUTE_FINISH and are resolved by
+  the usual wait/synch protocol on the task thread.
+*/
+enum readahead_state_t {
+    READAHEAD_IDLE,		// worker waiting for a batch
+    READAHEAD_BUSY,		// worker interpreting
+    READAHEAD_DONE		// batch ended, outcome not yet applied
+};
+
+static int readahead_thread_enabled = 0;	// [TASK]INTERP_THREAD
+static pthread_t readahead_thread;
+static pthread_mutex_t readahead_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t readahead_cond = PTHREAD_COND_INITIALIZER;
+static readahead_state_t readahead_state = READAHEAD_IDLE;
+static int readahead_stop = 0;		// end the batch after this line
+static int readahead_quit = 0;		// worker thread should exit
+
+// progress and outcome of the batch, written by the worker
+static int readahead_read_line = 0;
+static int readahead_call_level = 0;
+static char readahead_command[LINELEN];
+static int readahead_read_retval = INTERP_OK;
+static int readahead_exec_retval = INTERP_OK;
+
+// the parts of emcStatus canon reads, as of the last readahead_publish()
+static EMC_STAT *readahead_status = NULL;
+
+/* emcTaskPlanRead retval != INTERP_OK
+   Signal to the rest of the system that that the interp
+   is now in a paused state. */
+/*! \todo FIXME The test below *should* be reduced to:
+   readRetVal != INTERP_OK
+   (N.B. Watch for negative error codes.) */
+static int readahead_read_failed(int readRetval)
+{
+    return readRetval > INTERP_MIN_ERROR
+	|| readRetval == INTERP_ENDFILE
+	|| readRetval == INTERP_EXIT
+	|| readRetval == INTERP_EXECUTE_FINISH;
+}
+
+// act on the return value of emcTaskPlanExecute(0) for a program line
+static void readahead_executed(int execRetval)
+{
+    if (execRetval > INTERP_MIN_ERROR) {
+	emcStatus->task.interpState =
+	    EMC_TASK_INTERP_WAITING;
+	interp_list.clear();
+	emcAbortCleanup(EMC_ABORT_INTERPRETER_ERROR,
+			"interpreter error"); 
+    } else if (execRetval == -1
+	    || execRetval == INTERP_EXIT ) {
+	emcStatus->task.interpState =
+	    EMC_TASK_INTERP_WAITING;
+    } else if (execRetval == INTERP_EXECUTE_FINISH) {
+	// INTERP_EXECUTE_FINISH signifies
+	// that no more reading should be done until
+	// everything
+	// outstanding is completed
+	emcTaskPlanSetWait();
+	// and resynch interp WM
+	emcTaskQueueCommand(&taskPlanSynchCmd);
+    } else if (execRetval != 0) {
+	// end of file
+	emcStatus->task.interpState =
+	    EMC_TASK_INTERP_WAITING;
+	emcStatus->task.motionLine = 0;
+	emcStatus->task.readLine = 0;
+    } else {
+
+	// executed a good line
+    }
+}
+
+// worker side: interpret lines until something needs the task thread
+static void readahead_interpret(void)
+{
+    int count = 0;
+    int readRetval;
+    int execRetval = INTERP_OK;
+    int stop;
+    char command[LINELEN];
+
+    while (1) {
+	readRetval = emcTaskPlanRead();
+	if (readahead_read_failed(readRetval)) {
+	    break;
+	}
+	// got a good line
+	// record the line number and command
+	int line = emcTaskPlanLine();
+	emcTaskPlanCommand(command);
+	pthread_mutex_lock(&readahead_mutex);
+	readahead_read_line = line;
+	strcpy(readahead_command, command);
+	pthread_mutex_unlock(&readahead_mutex);
+
+	// and execute it
+	execRetval = emcTaskPlanExecute(0);
+
+	// line number may need update after
+	// returns from subprograms in external
+	// files
+	line = emcTaskPlanLine();
+	int level = emcTaskPlanLevel();
+	pthread_mutex_lock(&readahead_mutex);
+	readahead_read_line = line;
+	readahead_call_level = level;
+	stop = readahead_stop;
+	pthread_mutex_unlock(&readahead_mutex);
+
+	if (execRetval != 0 || stop
+		|| count++ >= emc_task_interp_max_len
+		|| interp_list.len() > emc_task_interp_max_len * 2/3) {
+	    break;
+	}
+    }
+
+    pthread_mutex_lock(&readahead_mutex);
+    readahead_read_retval = readRetval;
+    readahead_exec_retval = execRetval;
+    pthread_mutex_unlock(&readahead_mutex);
+}
+
+static void *readahead_main(void *arg)
+{
+    pthread_mutex_lock(&readahead_mutex);
+    while (!readahead_quit) {
+	if (readahead_state != READAHEAD_BUSY) {
+	    pthread_cond_wait(&readahead_cond, &readahead_mutex);
+	    continue;
+	}
+	pthread_mutex_unlock(&readahead_mutex);
+	readahead_interpret();
+	pthread_mutex_lock(&readahead_mutex);
+	readahead_state = READAHEAD_DONE;
+	pthread_cond_broadcast(&readahead_cond);
+    }
+    pthread_mutex_unlock(&readahead_mutex);
+    return NULL;
+}
+
+static int readahead_start(void)
+{
+    if (!readahead_thread_enabled) {
+	return 0;
+    }
+    // as for [PYTHON]TOPLEVEL, Task methods in Python rule the thread out
+    if (typeid(*task_methods) != typeid(Task)) {
+	rcs_print("task: Python Task methods in use, ignoring [TASK]INTERP_THREAD\n");
+	readahead_thread_enabled = 0;
+	return 0;
+    }
+    readahead_quit = 0;
+    readahead_status = new EMC_STAT;
+    readahead_publish();
+    if (0 != pthread_create(&readahead_thread, NULL, readahead_main, NULL)) {
+	rcs_print_error("can't create interpreter readahead thread\n");
+	readahead_thread_enabled = 0;
+	return -1;
+    }
+    return 0;
+}
+
+static void readahead_shutdown(void)
+{
+    if (!readahead_thread_enabled) {
+	return;
+    }
+    pthread_mutex_lock(&readahead_mutex);
+    readahead_stop = 1;
+    readahead_quit = 1;
+    pthread_cond_broadcast(&readahead_cond);
+    pthread_mutex_unlock(&readahead_mutex);
+    pthread_join(readahead_thread, NULL);
+    readahead_thread_enabled = 0;
+    delete readahead_status;
+    readahead_status = NULL;
+}
+
+/*
+  The worker must not read emcStatus while the task thread updates it, so
+  canon's GET_EXTERNAL_*() read it through readahead_status_lock(): on
+  the worker that is a copy of the fields they use, refreshed by
+  readahead_publish() on the task thread each cycle and before each
+  batch.  Elsewhere it is emcStatus itself.
+ */
+void readahead_publish(void)
+{
+    if (!readahead_thread_enabled || NULL == readahead_status) {
+	return;
+    }
+    pthread_mutex_lock(&readahead_mutex);
+    readahead_status->motion.traj = emcStatus->motion.traj;
+    readahead_status->motion.spindle = emcStatus->motion.spindle;
+    memcpy(readahead_status->motion.synch_di, emcStatus->motion.synch_di,
+	   sizeof(emcStatus->motion.synch_di));
+    memcpy(readahead_status->motion.analog_input,
+	   emcStatus->motion.analog_input,
+	   sizeof(emcStatus->motion.analog_input));
+    readahead_status->io = emcStatus->io;
+    readahead_status->task.input_timeout = emcStatus->task.input_timeout;
+    pthread_mutex_unlock(&readahead_mutex);
+}
+
+static int on_readahead_thread(void)
+{
+    return readahead_thread_enabled &&
+	pthread_equal(pthread_self(), readahead_thread);
+}
+
+const EMC_STAT *readahead_status_lock(void)
+{
+    if (!on_readahead_thread()) {
+	return emcStatus;
+    }
+    pthread_mutex_lock(&readahead_mutex);
+    return readahead_status;
+}
+
+void readahead_status_unlock(void)
+{
+    if (on_readahead_thread()) {
+	pthread_mutex_unlock(&readahead_mutex);
+    }
+}
+
+int readahead_busy(void)
+{
+    int busy;
+
+    if (!readahead_thread_enabled) {
+	return 0;
+    }
+    pthread_mutex_lock(&readahead_mutex);
+    busy = readahead_state == READAHEAD_BUSY;
+    pthread_mutex_unlock(&readahead_mutex);
+
+    return busy;
+}
+
+/*
+  readahead_join() waits for the readahead thread to end its batch and
+  applies the outcome, after which the task thread may use the
+  interpreter.  Does nothing when called on the readahead thread itself.
+ */
+void readahead_join(void)
+{
+    int readRetval, execRetval;
+
+    if (!readahead_thread_enabled || on_readahead_thread()) {
+	return;
+    }
+    pthread_mutex_lock(&readahead_mutex);
+    if (readahead_state == READAHEAD_IDLE) {
+	pthread_mutex_unlock(&readahead_mutex);
+	return;
+    }
+    readahead_stop = 1;
+    while (readahead_state == READAHEAD_BUSY) {
+	pthread_cond_wait(&readahead_cond, &readahead_mutex);
+    }
+    readahead_state = READAHEAD_IDLE;
+    readRetval = readahead_read_retval;
+    execRetval = readahead_exec_retval;
+    emcStatus->task.readLine = readahead_read_line;
+    strcpy(emcStatus->task.command, readahead_command);
+    pthread_mutex_unlock(&readahead_mutex);
+
+    if (readahead_read_failed(readRetval)) {
+	emcStatus->task.interpState = EMC_TASK_INTERP_WAITING;
+    } else {
+	readahead_executed(execRetval);
+    }
+}
+
+// call level of the interpreter, without waiting for the readahead thread
+static int readahead_plan_level(void)
+{
+    int level;
+
+    if (!readahead_busy()) {
+	return emcTaskPlanLevel();
+    }
+    pthread_mutex_lock(&readahead_mutex);
+    level = readahead_call_level;
+    pthread_mutex_unlock(&readahead_mutex);
+
+    return level;
+}
+
+// task side of the readahead thread, called in place of the inline loop
+static void readahead_reading_threaded(void)
+{
+    pthread_mutex_lock(&readahead_mutex);
+    readahead_state_t state = readahead_state;
+    if (state == READAHEAD_BUSY) {
+	emcStatus->task.readLine = readahead_read_line;
+	strcpy(emcStatus->task.command, readahead_command);
+    }
+    pthread_mutex_unlock(&readahead_mutex);
+
+    if (state == READAHEAD_BUSY) {
+	return;
+    }
+    if (state == READAHEAD_DONE) {
+	readahead_join();
+	if (emcStatus->task.interpState != EMC_TASK_INTERP_READING) {
+	    return;
+	}
+    }
+    if (interp_list.len() > emc_task_interp_max_len) {
+	return;
+    }
+    if (emcTaskPlanIsWait()) {
+	// delay reading of next line until all is done
+	if (interp_list.len() == 0 &&
+	    emcTaskCommand == 0 &&
+	    emcStatus->task.execState ==
+	    EMC_TASK_EXEC_DONE) {
+	    emcTaskPlanClearWait();
+	}
+	return;
+    }
+
+    readahead_publish();
+    pthread_mutex_lock(&readahead_mutex);
+    readahead_stop = 0;
+    readahead_state = READAHEAD_BUSY;
+    pthread_cond_broadcast(&readahead_cond);
+    pthread_mutex_unlock(&readahead_mutex);
+}
+
 void readahead_reading(void)
 {
     int readRetval;
     int execRetval;
 
+    // stepping over lines to run from a given line stays on this thread
+    if (readahead_thread_enabled && programStartLine == 0) {
+	readahead_reading_threaded();
+	return;
+    }
+    readahead_join();
+
 		if (interp_list.len() <= emc_task_interp_max_len) {
                     int count = 0;
 interpret_again:
@@ -503,20 +868,7 @@ interpret_again:
 			 }
 		    } else {
 			readRetval = emcTaskPlanRead();
-			/*! \todo MGS FIXME
-			   This if() actually evaluates to if (readRetval != INTERP_OK)...
-			   *** Need to look at all calls to things that return INTERP_xxx values! ***
-			   MGS */
-			if (readRetval > INTERP_MIN_ERROR
-				|| readRetval == INTERP_ENDFILE
-				|| readRetval == INTERP_EXIT
-				|| readRetval == INTERP_EXECUTE_FINISH) {
-			    /* emcTaskPlanRead retval != INTERP_OK
-			       Signal to the rest of the system that that the interp
-			       is now in a paused state. */
-			    /*! \todo FIXME The above test *should* be reduced to:
-			       readRetVal != INTERP_OK
-			       (N.B. Watch for negative error codes.) */
+			if (readahead_read_failed(readRetval)) {
 			    emcStatus->task.interpState =
 				EMC_TASK_INTERP_WAITING;
 			} else {
@@ -532,34 +884,7 @@ interpret_again:
 			    // returns from subprograms in external
 			    // files
 			    emcStatus->task.readLine = emcTaskPlanLine();
-			    if (execRetval > INTERP_MIN_ERROR) {
-				emcStatus->task.interpState =
-				    EMC_TASK_INTERP_WAITING;
-				interp_list.clear();
-				emcAbortCleanup(EMC_ABORT_INTERPRETER_ERROR,
-						"interpreter error"); 
-			    } else if (execRetval == -1
-				    || execRetval == INTERP_EXIT ) {
-				emcStatus->task.interpState =
-				    EMC_TASK_INTERP_WAITING;
-			    } else if (execRetval == INTERP_EXECUTE_FINISH) {
-				// INTERP_EXECUTE_FINISH signifies
-				// that no more reading should be done until
-				// everything
-				// outstanding is completed
-				emcTaskPlanSetWait();
-				// and resynch interp WM
-				emcTaskQueueCommand(&taskPlanSynchCmd);
-			    } else if (execRetval != 0) {
-				// end of file
-				emcStatus->task.interpState =
-				    EMC_TASK_INTERP_WAITING;
-                                emcStatus->task.motionLine = 0;
-                                emcStatus->task.readLine = 0;
-			    } else {
-
-				// executed a good line
-			    }
+			    readahead_executed(execRetval);
 
 			    // throw the results away if we're supposed to
 			    // read
@@ -2473,6 +2798,45 @@ if (stepping) {                                                            \
 }
 
 // executor function
+static int isMoveType(NMLTYPE type)
+{
+    return type == EMC_TRAJ_LINEAR_MOVE_TYPE ||
+	type == EMC_TRAJ_CIRCULAR_MOVE_TYPE;
+}
+
+/*
+  emcTaskIssueMoves() issues emcTaskCommand, a linear or circular move,
+  together with the moves queued right behind it on interp_list, so that
+  up to EMCMOT_MAX_SEGMENTS of them reach motion in one command instead
+  of one per task cycle.  Each move keeps its own motion id.  Following
+  moves are only taken while nothing would have made them wait: no
+  stepping, no pause, and IO done (their precondition).
+ */
+static int emcTaskIssueMoves(void)
+{
+    int retval;
+    int n = 1;
+
+    emcTrajBeginSegments();
+    retval = emcTaskIssueCommand(emcTaskCommand);
+    while (0 == retval && n < EMCMOT_MAX_SEGMENTS && !stepping &&
+	   emcStatus->task.interpState != EMC_TASK_INTERP_PAUSED &&
+	   emcStatus->io.status == RCS_DONE &&
+	   isMoveType(interp_list.peek_type())) {
+	emcTaskCommand = interp_list.get();
+	emcStatus->task.currentLine = interp_list.get_line_number();
+	emcStatus->task.callLevel = readahead_plan_level();
+	emcTrajSetMotionId(emcStatus->task.currentLine);
+	retval = emcTaskIssueCommand(emcTaskCommand);
+	n++;
+    }
+    if (0 != emcTrajEndSegments()) {
+	retval = -1;
+    }
+
+    return retval;
+}
+
 static int emcTaskExecute(void)
 {
     int retval = 0;
@@ -2546,7 +2910,7 @@ static int emcTaskExecute(void)
 		    emcTaskEager = 1;
 		    emcStatus->task.currentLine =
 			interp_list.get_line_number();
-		    emcStatus->task.callLevel = emcTaskPlanLevel();
+		    emcStatus->task.callLevel = readahead_plan_level();
 		    // and set it for all subsystems which use queued ids
 		    emcTrajSetMotionId(emcStatus->task.currentLine);
 		    if (emcStatus->motion.traj.queueFull) {
@@ -2560,7 +2924,12 @@ static int emcTaskExecute(void)
 		}
 	    } else {
 		// have an outstanding command
-		if (0 != emcTaskIssueCommand(emcTaskCommand)) {
+		if (isMoveType(emcTaskCommand->type)) {
+		    retval = emcTaskIssueMoves();
+		} else {
+		    retval = emcTaskIssueCommand(emcTaskCommand);
+		}
+		if (0 != retval) {
 		    emcStatus->task.execState = EMC_TASK_EXEC_ERROR;
 		    retval = -1;
 		} else {
@@ -3029,6 +3398,7 @@ static int emctask_shutdown(void)
     // shut down the subsystems
     if (0 != emcStatus) {
 	emcTaskHalt();
+	readahead_shutdown();
 	emcTaskPlanExit();
 	emcMotionHalt();
 	emcIoHalt();
@@ -3126,6 +3496,19 @@ static int iniLoad(const char *filename)
 	}
     }
 
+    if (NULL != (inistring = inifile.Find("INTERP_THREAD", "TASK"))) {
+	if (1 != sscanf(inistring, "%d", &readahead_thread_enabled)) {
+	    readahead_thread_enabled = 0;
+	}
+	// remaps, O-word subs and Python Task methods would run Python on
+	// both threads, and neither takes the GIL for it
+	if (readahead_thread_enabled &&
+		NULL != inifile.Find("TOPLEVEL", "PYTHON")) {
+	    rcs_print("task: [PYTHON]TOPLEVEL is set, ignoring [TASK]INTERP_THREAD\n");
+	    readahead_thread_enabled = 0;
+	}
+    }
+
     if (NULL != (inistring = inifile.Find("RS274NGC_STARTUP_CODE", "RS274NGC"))) {
 	// copy to global
 	strcpy(rs274ngc_startup_code, inistring);
@@ -3278,6 +3661,7 @@ int main(int argc, char *argv[])
 	emctask_shutdown();
 	exit(1);
     }
+    readahead_start();
     // set the default startup modes
     emcMotionAbort();
     emcSpindleAbort();
@@ -3325,6 +3709,7 @@ int main(int argc, char *argv[])
 
 	emcIoUpdate(&emcStatus->io);
 	emcMotionUpdate(&emcStatus->motion);
+	readahead_publish();
 	// synchronize subordinate states
 	if (emcStatus->io.aux.estop) {
 	    if (emcStatus->motion.traj.enabled) {
@@ -56,5 +56,12 @@ int emcTaskPlanCommand(char *cmd);
 
 int emcTaskUpdate(EMC_TASK_STAT * stat);
 
+// interpreter readahead thread, see emctaskmain.cc
+void readahead_join(void);
+int readahead_busy(void);
+void readahead_publish(void);
+const EMC_STAT *readahead_status_lock(void);
+void readahead_status_unlock(void);
+
 #endif
 
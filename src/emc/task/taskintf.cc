@@ -74,6 +74,11 @@ static struct AxisConfig_t AxisConfig[EMCMOT_MAX_AXIS];
 
 static emcmot_command_t emcmotCommand;
 
+// set between emcTrajBeginSegments() and emcTrajEndSegments(); lines and
+// circles are then collected in emcmotCommand.segments and go to motion
+// as one EMCMOT_SET_SEGMENTS command
+static int emcmotSegmentBatch = 0;
+
 __attribute__ ((unused))
 static int emcmotIoInited = 0;	// non-zero means io called init
 static int emcmotion_initialized = 0;	// non-zero means both
@@ -1341,6 +1346,80 @@ int emcTrajSetTermCond(int cond, double tolerance)
     return usrmotWriteEmcmotCommand(&emcmotCommand);
 }
 
+// sends the collected segments, a lone one as a plain line or circle
+static int emcTrajSendSegments()
+{
+    int n = emcmotCommand.nsegments;
+    int retval;
+
+    if (n == 0) {
+	return 0;
+    }
+    if (n == 1) {
+	emcmot_segment_t *seg = &emcmotCommand.segments[0];
+	emcmotCommand.command = seg->command;
+	emcmotCommand.pos = seg->pos;
+	emcmotCommand.center = seg->center;
+	emcmotCommand.normal = seg->normal;
+	emcmotCommand.turn = seg->turn;
+	emcmotCommand.motion_type = seg->motion_type;
+	emcmotCommand.vel = seg->vel;
+	emcmotCommand.ini_maxvel = seg->ini_maxvel;
+	emcmotCommand.acc = seg->acc;
+	emcmotCommand.id = seg->id;
+    } else {
+	emcmotCommand.command = EMCMOT_SET_SEGMENTS;
+	emcmotCommand.id = emcmotCommand.segments[n - 1].id;
+    }
+    retval = usrmotWriteEmcmotCommand(&emcmotCommand);
+    emcmotCommand.nsegments = 0;
+
+    return retval;
+}
+
+static int emcTrajQueueSegment(cmd_code_t command, EmcPose end,
+			       PM_CARTESIAN center, PM_CARTESIAN normal,
+			       int turn, int type, double vel,
+			       double ini_maxvel, double acc)
+{
+    emcmot_segment_t *seg = &emcmotCommand.segments[emcmotCommand.nsegments];
+
+    seg->command = command;
+    seg->pos = end;
+    seg->center.x = center.x;
+    seg->center.y = center.y;
+    seg->center.z = center.z;
+    seg->normal.x = normal.x;
+    seg->normal.y = normal.y;
+    seg->normal.z = normal.z;
+    seg->turn = turn;
+    seg->motion_type = type;
+    seg->vel = vel;
+    seg->ini_maxvel = ini_maxvel;
+    seg->acc = acc;
+    seg->id = TrajConfig.MotionId;
+
+    if (++emcmotCommand.nsegments == EMCMOT_MAX_SEGMENTS) {
+	return emcTrajSendSegments();
+    }
+    return 0;
+}
+
+int emcTrajBeginSegments()
+{
+    emcmotSegmentBatch = 1;
+    emcmotCommand.nsegments = 0;
+
+    return 0;
+}
+
+int emcTrajEndSegments()
+{
+    emcmotSegmentBatch = 0;
+
+    return emcTrajSendSegments();
+}
+
 int emcTrajLinearMove(EmcPose end, int type, double vel, double ini_maxvel, double acc,
                       int indexrotary)
 {
@@ -1353,6 +1432,12 @@ int emcTrajLinearMove(EmcPose end, int type, double vel, double ini_maxvel, doub
     }
 #endif
 
+    if (emcmotSegmentBatch) {
+	return emcTrajQueueSegment(EMCMOT_SET_LINE, end, PM_CARTESIAN(0, 0, 0),
+				   PM_CARTESIAN(0, 0, 0), indexrotary, type, vel,
+				   ini_maxvel, acc);
+    }
+
     emcmotCommand.command = EMCMOT_SET_LINE;
 
     emcmotCommand.pos = end;
@@ -1381,6 +1466,11 @@ int emcTrajCircularMove(EmcPose end, PM_CARTESIAN center,
     }
 #endif
 
+    if (emcmotSegmentBatch) {
+	return emcTrajQueueSegment(EMCMOT_SET_CIRCLE, end, center, normal,
+				   turn, type, vel, ini_maxvel, acc);
+    }
+
     emcmotCommand.command = EMCMOT_SET_CIRCLE;
 
     emcmotCommand.pos = end;
@@ -1620,6 +1710,24 @@ int emcPositionLoad() {
 }
 
 
+// Load [EMCMOT]COMP_GRID_FILE, if there is one, into motion's
+// compensation grid.
+static int emcCompGridLoad() {
+    IniFile ini;
+    const char *gridfile;
+
+    ini.Open(emc_inifile);
+    gridfile = ini.Find("COMP_GRID_FILE", "EMCMOT");
+    ini.Close();
+    if(!gridfile || !gridfile[0]) return 0;
+    if(usrmotLoadCompGrid(gridfile) != 0) {
+        rcs_print("%s: failed to load compensation grid %s\n", __FUNCTION__, gridfile);
+        return -1;
+    }
+    return 0;
+}
+
+
 int emcPositionSave() {
     IniFile ini;
     const char *posfile;
@@ -1679,6 +1787,10 @@ int emcMotionInit()
 	}
     }
 
+    if (0 != emcCompGridLoad()) {
+        return -1;
+    }
+
     // Ignore errors from emcPositionLoad(), because what are you going to do?
     (void)emcPositionLoad();
 
@@ -24,6 +24,8 @@
 #include <boost/python/implicit.hpp>
 #include <boost/python/module.hpp>
 #include <boost/python/overloads.hpp>
+#include <boost/python/copy_const_reference.hpp>
+#include <boost/python/return_value_policy.hpp>
 #include <boost/python/scope.hpp>
 #include "python_plugin.hh"
 #include "rs274ngc.hh"
@@ -38,11 +40,12 @@ namespace bp = boost::python;
 
 namespace pp = pyplusplus::containers::static_sized;
 
-#include "interp_array_types.hh"  // import activeMCodes,activeGCodes,activeSettings, toolTable
+#include "interp_array_types.hh"  // import activeMCodes,activeGCodes,activeSettings
 
 #include "rcs.hh"		// NML classes, nmlErrorFormat()
 #include "emc.hh"		// EMC NML
 #include "emc_nml.hh"
+#include "toolstore.hh"
 
 extern void emctask_quit(int sig);
 extern EMC_STAT *emcStatus;
@@ -176,12 +179,6 @@ typedef pp::array_1_t< int, ACTIVE_G_CODES> active_g_codes_array, (*active_g_cod
 typedef pp::array_1_t< int, ACTIVE_M_CODES> active_m_codes_array, (*active_m_codes_tw)( EMC_TASK_STAT &t );
 typedef pp::array_1_t< double, ACTIVE_SETTINGS> active_settings_array, (*active_settings_tw)( EMC_TASK_STAT &t );
 
-typedef pp::array_1_t< CANON_TOOL_TABLE, CANON_POCKETS_MAX> tool_array, (*tool_w)( EMC_TOOL_STAT &t );
-
-static  tool_array tool_wrapper ( EMC_TOOL_STAT & t) {
-    return tool_array(t.toolTable);
-}
-
 static  axis_array axis_wrapper ( EMC_MOTION_STAT & m) {
     return axis_array(m.axis);
 }
@@ -468,9 +465,23 @@ BOOST_PYTHON_MODULE(emctask) {
     class_ <EMC_TOOL_STAT, noncopyable>("EMC_TOOL_STAT",no_init)
 	.def_readwrite("pocketPrepped", &EMC_TOOL_STAT::pocketPrepped )
 	.def_readwrite("toolInSpindle", &EMC_TOOL_STAT::toolInSpindle )
-	.add_property( "toolTable",
-		       bp::make_function( tool_w(&tool_wrapper),
-					  bp::with_custodian_and_ward_postcall< 0, 1 >()))
+	.def_readonly("toolTableSerial", &EMC_TOOL_STAT::toolTableSerial )
+	.def_readonly("randomToolchanger", &EMC_TOOL_STAT::randomToolchanger )
+	;
+
+    // a Python task owns the tool table as iocontrol does, and
+    // publish()es its changes into emcstat.io.tool
+    class_ <ToolStore, noncopyable>("ToolStore")
+	.def("load", &ToolStore::load)
+	.def("save", &ToolStore::save)
+	.def("pockets", &ToolStore::pockets)
+	.def("get", &ToolStore::get, return_value_policy<copy_const_reference>())
+	.def("set", &ToolStore::set)
+	.def("swap", &ToolStore::swap)
+	.def("find", &ToolStore::find)
+	.def("fms", &ToolStore::fms)
+	.def("comment", &ToolStore::comment)
+	.def("publish", &ToolStore::publish)
 	;
 
     class_ <EMC_AUX_STAT, noncopyable>("EMC_AUX_STAT",no_init)
@@ -196,16 +196,12 @@ static inline int findSpiralApproximation(PmCircle const * const circ,
             /*u_tan->x,*/
             /*u_tan->y,*/
             /*u_tan->z);*/
-    pmCartScalMult(u_tan, dr, center_out);
     /*tp_debug_print(" circcenter = %f %f %f\n",*/
             /*circ->center.x,*/
             /*circ->center.y,*/
             /*circ->center.z);*/
-    pmCartCartAddEq(center_out, &circ->center);
-
-    PmCartesian r_adjust;
-    pmCartCartSub(base_pt, center_out, &r_adjust);
-    pmCartMag(&r_adjust, radius_out);
+    *center_out = pmCartAdd(pmCartScale(*u_tan, dr), circ->center);
+    *radius_out = pmCartLength(pmCartSub(*base_pt, *center_out));
 
     tp_debug_print(" adjusted center = %f %f %f\n",
             center_out->x,
@@ -231,16 +227,13 @@ static inline double findTrimAngle(PmCartesian const * const P,
         PmCartesian const * const center)
 {
     //Define vectors relative to circle center
-    PmCartesian u_P;
-    pmCartCartSub(P, center, &u_P);
+    PmCartesian u_P = pmCartSub(*P, *center);
     pmCartUnitEq(&u_P);
 
-    PmCartesian u_arccenter;
-    pmCartCartSub(arc_center, center, &u_arccenter);
+    PmCartesian u_arccenter = pmCartSub(*arc_center, *center);
     pmCartUnitEq(&u_arccenter);
 
-    double dot;
-    pmCartCartDot(&u_arccenter, &u_P, &dot);
+    double dot = pmCartDot(u_arccenter, u_P);
     double dphi = acos(saturate(dot,1.0));
     tp_debug_print(" dphi = %g\n",dphi);
     return dphi;
@@ -265,8 +258,7 @@ int checkTangentAngle(PmCircle const * const circ, SphericalArc const * const ar
     pmCartUnitEq(&u_arc);
 
     // Find angle between tangent unit vectors
-    double dot;
-    pmCartCartDot(&u_circ, &u_arc, &dot);
+    double dot = pmCartDot(u_circ, u_arc);
     double blend_angle = acos(saturate(dot,1.0));
 
     // Check against the maximum allowed tangent angle for the given velocity and acceleration
@@ -318,8 +310,7 @@ int pmCartCartParallel(PmCartesian const * const v1,
     PmCartesian u1,u2;
     pmCartUnit(v1, &u1);
     pmCartUnit(v2, &u2);
-    double dot;
-    pmCartCartDot(&u1, &u2, &dot);
+    double dot = pmCartDot(u1, u2);
     double theta = acos(fabs(dot));
     if (theta < tol) {
         return 1;
@@ -339,8 +330,7 @@ int pmCartCartParallel(PmCartesian const * const v1,
 int pmCircLineCoplanar(PmCircle const * const circ,
         PmCartLine const * const line, double tol)
 {
-    double dot;
-    int res = pmCartCartDot(&circ->normal, &line->uVec, &dot);
+    double dot = pmCartDot(circ->normal, line->uVec);
     tp_debug_print("normal = %.12g %.12g %.12g, uVec = %.12g %.12g %.12g, dot = %.12g\n",
             circ->normal.x,
             circ->normal.y,
@@ -349,7 +339,7 @@ int pmCircLineCoplanar(PmCircle const * const circ,
             line->uVec.y,
             line->uVec.z,
             dot);
-    if (fabs(dot) < tol && !res) {
+    if (fabs(dot) < tol) {
         return 1;
     } else {
         return 0;
@@ -366,11 +356,10 @@ int blendCoplanarCheck(PmCartesian const * const normal,
         return TP_ERR_MISSING_INPUT;
     }
 
-    double dot1, dot2;
-    int res1 = pmCartCartDot(normal, u1_tan, &dot1);
-    int res2 = pmCartCartDot(normal, u2_tan, &dot2);
+    double dot1 = pmCartDot(*normal, *u1_tan);
+    double dot2 = pmCartDot(*normal, *u2_tan);
 
-    if (fabs(dot1) < tol && fabs(dot2) < tol && !res1 && !res2) {
+    if (fabs(dot1) < tol && fabs(dot2) < tol) {
         return 1;
     } else {
         return 0;
@@ -388,8 +377,7 @@ int blendCoplanarCheck(PmCartesian const * const normal,
 int findIntersectionAngle(PmCartesian const * const u1,
         PmCartesian const * const u2, double * const theta)
 {
-    double dot;
-    pmCartCartDot(u1, u2, &dot);
+    double dot = pmCartDot(*u1, *u2);
 
     if (dot > 1.0 || dot < -1.0) {
         tp_debug_print("dot product %.16g outside domain of acos! u1 = %.16g %.16g %.16g, u2 = %.16g %.16g %.16g\n",
@@ -431,8 +419,7 @@ int calculateInscribedDiameter(PmCartesian const * const normal,
         return TP_ERR_MISSING_INPUT;
     }
 
-    double n_mag;
-    pmCartMagSq(normal, &n_mag);
+    double n_mag = pmCartLengthSq(*normal);
     double mag_err = fabs(1.0 - n_mag);
     if (mag_err > pmSqrt(TP_POS_EPSILON)) {
         /*rtapi_print_msg(RTAPI_MSG_ERR,"normal vector <%.12g,%.12f,%.12f> has magnitude error = %e\n",*/
@@ -447,9 +434,9 @@ int calculateInscribedDiameter(PmCartesian const * const normal,
 
     //Find perpendicular component of unit directions
     // FIXME use plane project?
-    pmCartScalMult(normal, -normal->x, &planar_x);
-    pmCartScalMult(normal, -normal->y, &planar_y);
-    pmCartScalMult(normal, -normal->z, &planar_z);
+    planar_x = pmCartScale(*normal, -normal->x);
+    planar_y = pmCartScale(*normal, -normal->y);
+    planar_z = pmCartScale(*normal, -normal->z);
 
     planar_x.x += 1.0;
     planar_y.y += 1.0;
@@ -464,10 +451,9 @@ int calculateInscribedDiameter(PmCartesian const * const normal,
     planar_y.y = fmax(planar_y.y,TP_POS_EPSILON);
     planar_z.z = fmax(planar_z.z,TP_POS_EPSILON);
 
-    double x_scale, y_scale, z_scale;
-    pmCartMag(&planar_x, &x_scale);
-    pmCartMag(&planar_y, &y_scale);
-    pmCartMag(&planar_z, &z_scale);
+    double x_scale = pmCartLength(planar_x);
+    double y_scale = pmCartLength(planar_y);
+    double z_scale = pmCartLength(planar_z);
 
     double x_extent=0, y_extent=0, z_extent=0;
     if (bounds->x != 0) {
@@ -672,12 +658,8 @@ int blendParamKinematics(BlendGeom3 * const geom,
     tp_debug_print("v_area = %f\n", v_area);
 
     // Get "base" of triangle
-    PmCartesian tmp1, tmp2, diff;
-    pmCartScalMult(&geom->u1, v_max1, &tmp1);
-    pmCartScalMult(&geom->u2, v_max2, &tmp2);
-    pmCartCartSub(&tmp2, &tmp1, &diff);
-    double base;
-    pmCartMag(&diff, &base);
+    double base = pmCartLength(pmCartSub(pmCartScale(geom->u2, v_max2),
+                pmCartScale(geom->u1, v_max1)));
     tp_debug_print("v_base = %f\n", base);
 
     double v_max_alt = 2.0 * v_area / base;
@@ -755,7 +737,7 @@ int blendInit3FromLineArc(BlendGeom3 * const geom, BlendParameters * const param
                 &blend_point);
         //Create new unit vector based on secant line
         // Direction is away from P (at start of segment)
-        pmCartCartSub(&blend_point, &geom->P,  &geom->u2);
+        geom->u2 = pmCartSub(blend_point, geom->P);
         pmCartUnitEq(&geom->u2);
         //Reduce theta proportionally to the angle between the secant and the normal
         param->theta = fmin(param->theta, geom->theta_tan - param->phi2_max / 4.0);
@@ -842,7 +824,7 @@ int blendInit3FromArcLine(BlendGeom3 * const geom, BlendParameters * const param
                 &blend_point);
         //Create new unit vector based on secant line
         // Direction is toward P (at end of segment)
-        pmCartCartSub(&geom->P, &blend_point, &geom->u1);
+        geom->u1 = pmCartSub(geom->P, blend_point);
         pmCartUnitEq(&geom->u1);
 
         //Reduce theta proportionally to the angle between the secant and the normal
@@ -963,7 +945,7 @@ int blendInit3FromArcArc(BlendGeom3 * const geom, BlendParameters * const param,
                 &blend_point);
         //Create new unit vector based on secant line
         // Direction is toward P (at end of segment)
-        pmCartCartSub(&geom->P, &blend_point, &geom->u1);
+        geom->u1 = pmCartSub(geom->P, blend_point);
         pmCartUnitEq(&geom->u1);
 
         //Reduce theta proportionally to the angle between the secant and the normal
@@ -978,7 +960,7 @@ int blendInit3FromArcArc(BlendGeom3 * const geom, BlendParameters * const param,
                 &blend_point);
         //Create new unit vector based on secant line
         // Direction is away from P (at start of segment)
-        pmCartCartSub(&blend_point, &geom->P,  &geom->u2);
+        geom->u2 = pmCartSub(blend_point, geom->P);
         pmCartUnitEq(&geom->u2);
 
         //Reduce theta proportionally to the angle between the secant and the normal
@@ -1228,8 +1210,7 @@ int blendFindPoints3(BlendPoints3 * const points, BlendGeom3 const * const geom,
     double center_dist = param->R_plan / sin(param->theta);
     tp_debug_print("center_dist = %f\n", center_dist);
 
-    pmCartScalMult(&geom->normal, center_dist, &points->arc_center);
-    pmCartCartAddEq(&points->arc_center, &geom->P);
+    points->arc_center = pmCartAdd(pmCartScale(geom->normal, center_dist), geom->P);
     tp_debug_print("arc_center = %f %f %f\n",
             points->arc_center.x,
             points->arc_center.y,
@@ -1237,8 +1218,7 @@ int blendFindPoints3(BlendPoints3 * const points, BlendGeom3 const * const geom,
 
     // Start point is d_plan away from intersection P in the
     // negative direction of u1
-    pmCartScalMult(&geom->u1, -param->d_plan, &points->arc_start);
-    pmCartCartAddEq(&points->arc_start, &geom->P);
+    points->arc_start = pmCartAdd(pmCartScale(geom->u1, -param->d_plan), geom->P);
     tp_debug_print("arc_start = %f %f %f\n",
             points->arc_start.x,
             points->arc_start.y,
@@ -1246,8 +1226,7 @@ int blendFindPoints3(BlendPoints3 * const points, BlendGeom3 const * const geom,
 
     // End point is d_plan away from intersection P in the
     // positive direction of u1
-    pmCartScalMult(&geom->u2, param->d_plan, &points->arc_end);
-    pmCartCartAddEq(&points->arc_end, &geom->P);
+    points->arc_end = pmCartAdd(pmCartScale(geom->u2, param->d_plan), geom->P);
     tp_debug_print("arc_end = %f %f %f\n",
             points->arc_end.x,
             points->arc_end.y,
@@ -1274,8 +1253,7 @@ int blendLineArcPostProcess(BlendPoints3 * const points, BlendPoints3 const * co
     tp_debug_print("d2 = %f\n", d2);
 
     //Get unit vector normal to line in plane, towards arc center
-    PmCartesian n1;
-    pmCartCartCross(&geom->binormal, &geom->u1, &n1);
+    PmCartesian n1 = pmCartCross(geom->binormal, geom->u1);
     pmCartUnitEq(&n1);
 
     tp_debug_print("n1 = %f %f %f\n",
@@ -1283,12 +1261,11 @@ int blendLineArcPostProcess(BlendPoints3 * const points, BlendPoints3 const * co
             n1.y,
             n1.z);
 
-    PmCartesian r_PC2;
-    pmCartCartSub(&geom->center2, &geom->P, &r_PC2);
+    PmCartesian r_PC2 = pmCartSub(geom->center2, geom->P);
 
     double c2_u,c2_n; //Components of C2-P on u1 and n1
-    pmCartCartDot(&r_PC2, &geom->u1, &c2_u);
-    pmCartCartDot(&r_PC2, &n1, &c2_n);
+    c2_u = pmCartDot(r_PC2, geom->u1);
+    c2_n = pmCartDot(r_PC2, n1);
 
     tp_debug_print("c2_u = %f, c2_n = %f\n",
             c2_u,
@@ -1312,23 +1289,17 @@ int blendLineArcPostProcess(BlendPoints3 * const points, BlendPoints3 const * co
         return TP_ERR_FAIL;
     }
 
-    PmCartesian C_u, C_n;
-
-    pmCartScalMult(&geom->u1, -d_L, &C_u);
-    pmCartScalMult(&n1, param->R_plan, &C_n);
-
-    PmCartesian r_PC;
     //Continue with correct solution, get actual center
-    pmCartCartAdd(&C_u, &C_n, &r_PC);
-    pmCartCartAdd(&geom->P, &r_PC, &points->arc_center);
+    PmCartesian r_PC = pmCartAdd(pmCartScale(geom->u1, -d_L),
+            pmCartScale(n1, param->R_plan));
+    points->arc_center = pmCartAdd(geom->P, r_PC);
     tp_debug_print("arc center = %f %f %f\n",
             points->arc_center.x,
             points->arc_center.y,
             points->arc_center.z);
 
     //Verify tolerances
-    double h;
-    pmCartMag(&r_PC, &h);
+    double h = pmCartLength(r_PC);
     tp_debug_print("center_dist = %f\n", h);
 
     double T_final = h - param->R_plan;
@@ -1366,8 +1337,7 @@ int blendArcLinePostProcess(BlendPoints3 * const points,
     tp_debug_print("d1 = %f\n", d1);
 
     //Get unit vector normal to line in plane, towards arc center
-    PmCartesian n2;
-    pmCartCartCross(&geom->binormal, &geom->u2, &n2);
+    PmCartesian n2 = pmCartCross(geom->binormal, geom->u2);
     pmCartUnitEq(&n2);
 
     tp_debug_print("n2 = %f %f %f\n",
@@ -1375,11 +1345,10 @@ int blendArcLinePostProcess(BlendPoints3 * const points,
             n2.y,
             n2.z);
 
-    PmCartesian r_PC1;
-    pmCartCartSub(&geom->center1, &geom->P, &r_PC1);
+    PmCartesian r_PC1 = pmCartSub(geom->center1, geom->P);
     double c1_u, c1_n; //Components of C1-P on u2 and n2
-    pmCartCartDot(&r_PC1, &geom->u2, &c1_u);
-    pmCartCartDot(&r_PC1, &n2, &c1_n);
+    c1_u = pmCartDot(r_PC1, geom->u2);
+    c1_n = pmCartDot(r_PC1, n2);
 
     double d_L; // badly named distance along line to intersection
     double A = 1;
@@ -1399,23 +1368,17 @@ int blendArcLinePostProcess(BlendPoints3 * const points,
         return TP_ERR_FAIL;
     }
 
-    PmCartesian C_u, C_n;
-
-    pmCartScalMult(&geom->u2, d_L, &C_u);
-    pmCartScalMult(&n2, param->R_plan, &C_n);
-
-    PmCartesian r_PC;
     //Continue with correct solution, get actual center
-    pmCartCartAdd(&C_u, &C_n, &r_PC);
-    pmCartCartAdd(&geom->P, &r_PC, &points->arc_center);
+    PmCartesian r_PC = pmCartAdd(pmCartScale(geom->u2, d_L),
+            pmCartScale(n2, param->R_plan));
+    points->arc_center = pmCartAdd(geom->P, r_PC);
     tp_debug_print("arc center = %f %f %f\n",
             points->arc_center.x,
             points->arc_center.y,
             points->arc_center.z);
 
     //Verify tolerances
-    double h;
-    pmCartMag(&r_PC, &h);
+    double h = pmCartLength(r_PC);
     tp_debug_print("center_dist = %f\n", h);
 
     double T_final = h - param->R_plan;
@@ -1456,10 +1419,8 @@ int blendArcArcPostProcess(BlendPoints3 * const points, BlendPoints3 const * con
     tp_debug_print("d1 = %f, d2 = %f\n", d1, d2);
 
     //Find "x" distance between C1 and C2
-    PmCartesian r_C1C2;
-    pmCartCartSub(&geom->center2, &geom->center1, &r_C1C2);
-    double c2x;
-    pmCartMag(&r_C1C2, &c2x);
+    PmCartesian r_C1C2 = pmCartSub(geom->center2, geom->center1);
+    double c2x = pmCartLength(r_C1C2);
 
     // Compute the new center location
 
@@ -1477,15 +1438,12 @@ int blendArcArcPostProcess(BlendPoints3 * const points, BlendPoints3 const * con
     }
 
     // Find the basis vector perpendicular to the binormal and uc
-    PmCartesian nc;
-    pmCartCartCross(&geom->binormal, &uc, &nc);
+    PmCartesian nc = pmCartCross(geom->binormal, uc);
 
     //Check if nc is in the same half-plane as the intersection normal. if not,
     //we need to flip it around to choose the correct solution.
-    double dot1;
-    pmCartCartDot(&geom->normal, &nc, &dot1);
-    if (dot1 < 0) {
-        pmCartNegEq(&nc);
+    if (pmCartDot(geom->normal, nc) < 0) {
+        nc = pmCartNegate(nc);
     }
     norm_err = pmCartUnitEq(&nc);
     if (norm_err) {
@@ -1493,37 +1451,27 @@ int blendArcArcPostProcess(BlendPoints3 * const points, BlendPoints3 const * con
     }
 
     //Find components of center position wrt circle 1 center.
-    PmCartesian c_x, c_y;
-    pmCartScalMult(&uc, Cx, &c_x);
-    pmCartScalMult(&nc, Cy, &c_y);
+    PmCartesian c_x = pmCartScale(uc, Cx);
+    PmCartesian c_y = pmCartScale(nc, Cy);
 
     //Get vector from P to first center
-    PmCartesian r_PC1;
-    pmCartCartSub(&geom->center1, &geom->P, &r_PC1);
+    PmCartesian r_PC1 = pmCartSub(geom->center1, geom->P);
 
     // Get "test vectors, relative distance from solution center to P
-    PmCartesian test1, test2;
-    pmCartCartAdd(&r_PC1, &c_x, &test1);
-    test2=test1;
+    PmCartesian test = pmCartAdd(r_PC1, c_x);
 
     //Add and subtract c_y component to get equivalent of two Y solutions
-    pmCartCartAddEq(&test1, &c_y);
-    pmCartCartSubEq(&test2, &c_y);
-
-    double mag1,mag2;
-    pmCartMag(&test1, &mag1);
-    pmCartMag(&test2, &mag2);
+    double mag1 = pmCartLength(pmCartAdd(test, c_y));
+    double mag2 = pmCartLength(pmCartSub(test, c_y));
 
     if (mag2 < mag1)
     {
         //negative solution is closer
-        pmCartNegEq(&c_y);
+        c_y = pmCartNegate(c_y);
     }
 
     //Continue with correct solution, get actual center
-    PmCartesian r_C1C;
-    pmCartCartAdd(&c_x, &c_y, &r_C1C);
-    pmCartCartAdd(&geom->center1, &r_C1C, &points->arc_center);
+    points->arc_center = pmCartAdd(geom->center1, pmCartAdd(c_x, c_y));
     tp_debug_print("arc center = %f %f %f\n",
             points->arc_center.x,
             points->arc_center.y,
@@ -1533,12 +1481,10 @@ int blendArcArcPostProcess(BlendPoints3 * const points, BlendPoints3 const * con
     PmCartesian r_C2C;
     pmCartCartSub(&points->arc_center, &geom->center2, &r_C2C);
 
-    PmCartesian r_PC;
-    pmCartCartSub(&points->arc_center, &geom->P, &r_PC);
+    PmCartesian r_PC = pmCartSub(points->arc_center, geom->P);
 
     //Verify tolerances
-    double h;
-    pmCartMag(&r_PC, &h);
+    double h = pmCartLength(r_PC);
     tp_debug_print("center_dist = %f\n", h);
 
     double T_final = h - param->R_plan;
@@ -1795,8 +1741,7 @@ int pmCircleAngleFromProgress(PmCircle const * const circle,
         double progress,
         double * const angle)
 {
-    double h2;
-    pmCartMagSq(&circle->rHelix, &h2);
+    double h2 = pmCartLengthSq(circle->rHelix);
     double s_end = pmSqrt(pmSq(fit->total_planar_length) + h2);
     // Parameterize by total progress along helix
     double t = progress / s_end;
@@ -36,13 +36,12 @@ int arcInitFromPoints(SphericalArc * const arc, PmCartesian const * const start,
     arc->end = *end;
     arc->center = *center;
 
-    pmCartCartSub(start, center, &arc->rStart);
-    pmCartCartSub(end, center, &arc->rEnd);
+    arc->rStart = pmCartSub(*start, *center);
+    arc->rEnd = pmCartSub(*end, *center);
 
     // Find the radii at start and end. These are identical for a perfect spherical arc
-    double radius0, radius1;
-    pmCartMag(&arc->rStart, &radius0);
-    pmCartMag(&arc->rEnd, &radius1);
+    double radius0 = pmCartLength(arc->rStart);
+    double radius1 = pmCartLength(arc->rEnd);
 
     tp_debug_print("radii are %g and %g\n",
             radius0,
@@ -58,14 +57,11 @@ int arcInitFromPoints(SphericalArc * const arc, PmCartesian const * const start,
     arc->radius = radius0;
 
     // Get unit vectors from center to start and center to end
-    PmCartesian u0, u1;
-    pmCartScalMult(&arc->rStart, 1.0 / radius0, &u0);
-    pmCartScalMult(&arc->rEnd, 1.0 / radius1, &u1);
+    PmCartesian u0 = pmCartScale(arc->rStart, 1.0 / radius0);
+    PmCartesian u1 = pmCartScale(arc->rEnd, 1.0 / radius1);
 
     // Find arc angle
-    double dot;
-    pmCartCartDot(&u0, &u1, &dot);
-    arc->angle = acos(dot);
+    arc->angle = acos(pmCartDot(u0, u1));
     tp_debug_print("spherical arc angle = %f\n", arc->angle);
 
     // Store spiral factor as radial difference. Archimedean spiral coef. a = spiral / angle
@@ -93,20 +89,16 @@ int arcPoint(SphericalArc const * const arc, double progress, PmCartesian * cons
     if (net_progress <= 0.0 && arc->line_length > 0) {
         tc_debug_print("net_progress = %f, line_length = %f\n", net_progress, arc->line_length);
         //Get position on line (not actually an angle in this case)
-        pmCartScalMult(&arc->uTan, net_progress, out);
-        pmCartCartAdd(out, &arc->start, out);
+        *out = pmCartAdd(pmCartScale(arc->uTan, net_progress), arc->start);
     } else {
         double angle_in = net_progress / arc->radius;
         tc_debug_print("angle_in = %f, angle_total = %f\n", angle_in, arc->angle);
         double scale0 = sin(arc->angle - angle_in) / arc->Sangle;
         double scale1 = sin(angle_in) / arc->Sangle;
 
-        PmCartesian interp0,interp1;
-        pmCartScalMult(&arc->rStart, scale0, &interp0);
-        pmCartScalMult(&arc->rEnd, scale1, &interp1);
-
-        pmCartCartAdd(&interp0, &interp1, out);
-        pmCartCartAdd(&arc->center, out, out);
+        PmCartesian interp = pmCartAdd(pmCartScale(arc->rStart, scale0),
+                pmCartScale(arc->rEnd, scale1));
+        *out = pmCartAdd(arc->center, interp);
     }
     return TP_ERR_OK;
 }
@@ -130,25 +122,22 @@ int arcFromLines(SphericalArc * const arc, PmCartLine const * const line1,
 
     //Calculate the normal direction of the arc from the difference
     //between the unit vectors
-    pmCartCartSub(&line2->uVec, &line1->uVec, &normal);
+    normal = pmCartSub(line2->uVec, line1->uVec);
     pmCartUnitEq(&normal);
-    pmCartScalMultEq(&normal, center_dist);
-    pmCartCartAdd(middle, &normal, &center);
+    center = pmCartAddScaled(*middle, normal, center_dist);
 
     //Calculate the binormal (vector perpendicular to the plane of the
     //arc)
-    pmCartCartCross(&line1->uVec, &line2->uVec, &binormal);
+    binormal = pmCartCross(line1->uVec, line2->uVec);
     pmCartUnitEq(&binormal);
 
     // Start point is blend_dist away from middle point in the
     // negative direction of line1
-    pmCartScalMult(&line1->uVec, -blend_dist, start);
-    pmCartCartAdd(start, middle, start);
+    *start = pmCartAdd(pmCartScale(line1->uVec, -blend_dist), *middle);
 
     // End point is blend_dist away from middle point in the positive
     // direction of line2
-    pmCartScalMult(&line2->uVec, blend_dist, end);
-    pmCartCartAddEq(end, middle);
+    *end = pmCartAdd(pmCartScale(line2->uVec, blend_dist), *middle);
 
     //Handle line portion of line-arc
     arc->uTan = line1->uVec;
@@ -165,10 +154,7 @@ int arcConvexTest(PmCartesian const * const center,
         PmCartesian const * const P, PmCartesian const * const uVec, int reverse_dir)
 {
     //Check if an arc-line intersection is concave or convex
-    double dot;
-    PmCartesian diff;
-    pmCartCartSub(P, center, &diff);
-    pmCartCartDot(&diff, uVec, &dot);
+    double dot = pmCartDot(pmCartSub(*P, *center), *uVec);
 
     tp_debug_print("convex test: dot = %f, reverse_dir = %d\n", dot, reverse_dir);
     int convex = (reverse_dir != 0) ^ (dot < 0);
@@ -186,16 +172,15 @@ int arcTangent(SphericalArc const * const arc, PmCartesian * const tan, int at_e
         r_perp = arc->rStart;
     }
 
-    pmCartCartCross(&arc->binormal, &r_perp, &r_tan);
+    r_tan = pmCartCross(arc->binormal, r_perp);
     //Get spiral component
     double dr = arc->spiral / arc->angle;
 
     //Get perpendicular component due to spiral
     PmCartesian d_perp;
     pmCartUnit(&r_perp, &d_perp);
-    pmCartScalMultEq(&d_perp, dr);
     //TODO error checks
-    pmCartCartAdd(&d_perp, &r_tan, tan);
+    *tan = pmCartAdd(pmCartScale(d_perp, dr), r_tan);
     pmCartUnitEq(tan);
 
     return TP_ERR_OK;
@@ -35,18 +35,17 @@ int tcCircleStartAccelUnitVector(TC_STRUCT const * const tc, PmCartesian * const
     PmCartesian tan, perp;
 
     pmCirclePoint(&tc->coords.circle.xyz, 0.0, &startpoint);
-    pmCartCartSub(&startpoint, &tc->coords.circle.xyz.center, &radius);
-    pmCartCartCross(&tc->coords.circle.xyz.normal, &radius, &tan);
+    radius = pmCartSub(startpoint, tc->coords.circle.xyz.center);
+    tan = pmCartCross(tc->coords.circle.xyz.normal, radius);
     pmCartUnitEq(&tan);
     //The unit vector's actual direction is adjusted by the normal
     //acceleration here. This unit vector is NOT simply the tangent
     //direction.
-    pmCartCartSub(&tc->coords.circle.xyz.center, &startpoint, &perp);
+    perp = pmCartSub(tc->coords.circle.xyz.center, startpoint);
     pmCartUnitEq(&perp);
 
-    pmCartScalMult(&tan, tc->maxaccel, &tan);
-    pmCartScalMultEq(&perp, pmSq(0.5 * tc->reqvel)/tc->coords.circle.xyz.radius);
-    pmCartCartAdd(&tan, &perp, out);
+    *out = pmCartAdd(pmCartScale(tan, tc->maxaccel),
+            pmCartScale(perp, pmSq(0.5 * tc->reqvel)/tc->coords.circle.xyz.radius));
     pmCartUnitEq(out);
     return 0;
 }
@@ -57,8 +56,8 @@ int tcCircleEndAccelUnitVector(TC_STRUCT const * const tc, PmCartesian * const o
     PmCartesian radius;
 
     pmCirclePoint(&tc->coords.circle.xyz, tc->coords.circle.xyz.angle, &endpoint);
-    pmCartCartSub(&endpoint, &tc->coords.circle.xyz.center, &radius);
-    pmCartCartCross(&tc->coords.circle.xyz.normal, &radius, out);
+    radius = pmCartSub(endpoint, tc->coords.circle.xyz.center);
+    *out = pmCartCross(tc->coords.circle.xyz.normal, radius);
     pmCartUnitEq(out);
     return 0;
 }
@@ -156,35 +155,28 @@ int pmCircleTangentVector(PmCircle const * const circle,
 
     PmCartesian startpoint;
     PmCartesian radius;
-    PmCartesian uTan, dHelix, dRadial;
+    PmCartesian uTan, dRadial;
 
     // Get vector in radial direction
     pmCirclePoint(circle, angle_in, &startpoint);
-    pmCartCartSub(&startpoint, &circle->center, &radius);
+    radius = pmCartSub(startpoint, circle->center);
 
     /* Find local tangent vector using planar normal. Assuming a differential
      * angle dtheta, the tangential component of the tangent vector is r *
      * dtheta. Since we're normalizing the vector anyway, assume dtheta = 1.
      */
-    pmCartCartCross(&circle->normal, &radius, &uTan);
-
-    // find dz/dtheta and get differential movement along helical axis
-    double h;
-    pmCartMag(&circle->rHelix, &h);
+    uTan = pmCartCross(circle->normal, radius);
 
     /* the binormal component of the tangent vector is (dz / dtheta) * dtheta.
      */
     double dz = 1.0 / circle->angle;
-    pmCartScalMult(&circle->rHelix, dz, &dHelix);
-
-    pmCartCartAddEq(&uTan, &dHelix);
+    uTan = pmCartAdd(uTan, pmCartScale(circle->rHelix, dz));
 
     /* The normal component is (dr / dtheta) * dtheta.
      */
     double dr = circle->spiral / circle->angle;
     pmCartUnit(&radius, &dRadial);
-    pmCartScalMultEq(&dRadial, dr);
-    pmCartCartAddEq(&uTan, &dRadial);
+    uTan = pmCartAdd(uTan, pmCartScale(dRadial, dr));
 
     //Normalize final output vector
     pmCartUnit(&uTan, out);
@@ -622,8 +614,7 @@ int pmCircle9Init(PmCircle9 * const circ9,
 double pmCircle9Target(PmCircle9 const * const circ9)
 {
 
-    double h2;
-    pmCartMagSq(&circ9->xyz.rHelix, &h2);
+    double h2 = pmCartLengthSq(circ9->xyz.rHelix);
     double helical_length = pmSqrt(pmSq(circ9->fit.total_planar_length) + h2);
 
     return helical_length;
@@ -688,8 +679,7 @@ int tcUpdateTargetFromCircle(TC_STRUCT * const tc)
         return TP_ERR_FAIL;
     }
 
-    double h2;
-    pmCartMagSq(&tc->coords.circle.xyz.rHelix, &h2);
+    double h2 = pmCartLengthSq(tc->coords.circle.xyz.rHelix);
     double helical_length = pmSqrt(pmSq(tc->coords.circle.fit.total_planar_length) + h2);
 
     tc->target = helical_length;
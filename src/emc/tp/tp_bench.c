@@ -0,0 +1,206 @@
+/********************************************************************
+* Description: tp_bench.c
+*   Microbenchmark for the trajectory planner.  Queues a program of
+*   short blended lines and arcs (which exercises blendmath.c and
+*   spherical_arc.c) and runs tpRunCycle until the program is done,
+*   timing both halves.  The sum of all commanded positions is printed
+*   as well, so two builds can be checked for giving the same path.
+*
+*   Usage: tp-bench [-n segments] [-r repeats] [-p period_ns]
+*
+*   It is not built by default or installed; 'make bench' in src/
+*   builds ../bin/tp-bench.
+*
+*   The planner is linked into the benchmark with stand-ins for the
+*   motion controller globals, so it runs without realtime.  The
+*   figures are the best of 'repeats' runs, which is what matters when
+*   comparing two builds of the same code.
+*
+* Author: LinuxCNC developers
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 LinuxCNC developers
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "rtapi.h"
+#include "posemath.h"
+#include "tc.h"
+#include "tp.h"
+#include "mot_priv.h"
+#include "motion_debug.h"
+#include "motion_types.h"
+#include "rtapi_math.h"
+
+#define BENCH_QUEUE_SIZE 2000
+
+/* stand-ins for the parts of motion the planner uses */
+static emcmot_status_t status;
+static emcmot_debug_t debug;
+static emcmot_config_t config;
+emcmot_status_t *emcmotStatus = &status;
+struct emcmot_debug_t *emcmotDebug = &debug;
+emcmot_config_t *emcmotConfig = &config;
+
+void emcmotDioWrite(int index, char value) { }
+void emcmotAioWrite(int index, double value) { }
+void emcmotSetRotaryUnlock(int axis, int unlock) { }
+int emcmotGetRotaryIsUnlocked(int axis) { return 1; }
+
+static TC_STRUCT queue[BENCH_QUEUE_SIZE];
+static TP_STRUCT tp;
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void setup(double period)
+{
+    EmcPose zero;
+    int i;
+
+    memset(&status, 0, sizeof(status));
+    memset(&debug, 0, sizeof(debug));
+    memset(&config, 0, sizeof(config));
+    status.net_feed_scale = 1.0;
+    status.vel = 100.0;
+    status.acc = 1000.0;
+    config.maxFeedScale = 1.0;
+    config.arcBlendEnable = 1;
+    config.arcBlendFallbackEnable = 0;
+    config.arcBlendOptDepth = 50;
+    config.arcBlendGapCycles = 4;
+    config.arcBlendRampFreq = 100.0;
+    config.arcBlendTangentKinkRatio = 0.1;
+    for (i = 0; i < EMCMOT_MAX_AXIS; i++) {
+        debug.axes[i].vel_limit = 100.0;
+        debug.axes[i].acc_limit = 1000.0;
+    }
+
+    memset(&zero, 0, sizeof(zero));
+    tpCreate(&tp, BENCH_QUEUE_SIZE, queue);
+    tpSetCycleTime(&tp, period);
+    tpSetPos(&tp, &zero);
+    tpSetVmax(&tp, status.vel, status.vel);
+    tpSetVlimit(&tp, status.vel);
+    tpSetAmax(&tp, status.acc);
+    tpSetTermCond(&tp, TC_TERM_COND_PARABOLIC, 0.01);
+}
+
+/* segment n of a program that spirals outward: mostly short lines at
+   slowly changing angles, every eighth segment an arc */
+static int add_segment(int n)
+{
+    double a = n * 0.15, r = 5.0 + n * 0.01;
+    EmcPose end;
+    PmCartesian center, normal;
+
+    memset(&end, 0, sizeof(end));
+    end.tran.x = r * cos(a);
+    end.tran.y = r * sin(a);
+    end.tran.z = 0.001 * n;
+    if (n % 8 == 7) {
+        center.x = 0.0;
+        center.y = 0.0;
+        center.z = end.tran.z;
+        normal.x = 0.0;
+        normal.y = 0.0;
+        normal.z = 1.0;
+        return tpAddCircle(&tp, end, center, normal, 0,
+            EMC_MOTION_TYPE_ARC, 50.0, 100.0, 1000.0, 0, 0);
+    }
+    return tpAddLine(&tp, end, EMC_MOTION_TYPE_FEED, 50.0, 100.0, 1000.0,
+        0, 0, -1);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: tp-bench [-n segments] [-r repeats] "
+        "[-p period_ns]\n");
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    int segments = 5000, repeats = 5, opt, rep, n;
+    long period = 1000000;
+    long long t, queue_ns, cycle_ns, cycle_max, cycles;
+    long long best_queue = -1, best_cycle = -1, best_max = -1;
+    long long total_cycles = 0;
+    double checksum = 0.0;
+    EmcPose pos;
+
+    while ((opt = getopt(argc, argv, "n:r:p:")) != -1) {
+        switch (opt) {
+        case 'n':
+            segments = atoi(optarg);
+            break;
+        case 'r':
+            repeats = atoi(optarg);
+            break;
+        case 'p':
+            period = atol(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind != argc || segments <= 0 || repeats <= 0 || period <= 0) {
+        usage();
+    }
+
+    for (rep = 0; rep < repeats; rep++) {
+        setup(period * 1e-9);
+        queue_ns = cycle_ns = cycle_max = cycles = 0;
+        checksum = 0.0;
+        n = 0;
+        while (n < segments || !tpIsDone(&tp)) {
+            /* keep the queue topped up like the motion controller does */
+            while (n < segments && tpQueueDepth(&tp) < BENCH_QUEUE_SIZE - 10) {
+                t = now_ns();
+                if (add_segment(n) != 0) {
+                    fprintf(stderr, "tp-bench: segment %d rejected\n", n);
+                    return 1;
+                }
+                queue_ns += now_ns() - t;
+                n++;
+            }
+            t = now_ns();
+            tpRunCycle(&tp, period);
+            t = now_ns() - t;
+            cycle_ns += t;
+            if (t > cycle_max) {
+                cycle_max = t;
+            }
+            cycles++;
+            tpGetPos(&tp, &pos);
+            checksum += pos.tran.x + pos.tran.y + pos.tran.z;
+        }
+        if (best_queue < 0 || queue_ns < best_queue) {
+            best_queue = queue_ns;
+        }
+        if (best_cycle < 0 || cycle_ns < best_cycle) {
+            best_cycle = cycle_ns;
+            best_max = cycle_max;
+        }
+        total_cycles = cycles;
+    }
+
+    printf("segments %d, cycles %lld, best of %d runs\n",
+        segments, total_cycles, repeats);
+    printf("tpAddLine/tpAddCircle: %8.1f ns per segment\n",
+        (double) best_queue / segments);
+    printf("tpRunCycle:            %8.1f ns per cycle (max %lld ns)\n",
+        (double) best_cycle / total_cycles, best_max);
+    printf("path checksum:         %.17g\n", checksum);
+    return 0;
+}
@@ -32,6 +32,7 @@
 #include "timer.hh"
 #include "nml_oi.hh"
 #include "rcs_print.hh"
+#include "toolstore.hh"
 
 #include <cmath>
 
@@ -82,6 +83,8 @@ struct pyStatChannel {
     PyObject_HEAD
     RCS_STAT_CHANNEL *c;
     EMC_STAT status;
+    ToolStore *tools;
+    PyObject *tool_table;	// tuple made from tools, until they change
 };
 
 struct pyCommandChannel {
@@ -265,11 +268,14 @@ static int Stat_init(pyStatChannel *self, PyObject *a, PyObject *k) {
     }
 
     self->c = c;
+    self->tools = new ToolStore;
     return 0;
 }
 
 static void Stat_dealloc(PyObject *self) {
     delete ((pyStatChannel*)self)->c;
+    delete ((pyStatChannel*)self)->tools;
+    Py_XDECREF(((pyStatChannel*)self)->tool_table);
     PyObject_Del(self);
 }
 
@@ -622,11 +628,12 @@ static PyStructSequence_Desc tool_result_desc = {
 
 static PyTypeObject ToolResultType;
 
-static PyObject *Stat_tool_table(pyStatChannel *s) {
-    PyObject *res = PyTuple_New(CANON_POCKETS_MAX);
+static PyObject *make_tool_table(ToolStore *tools) {
+    int pockets = tools->pockets();
+    PyObject *res = PyTuple_New(pockets);
     int j=0;
-    for(int i=0; i<CANON_POCKETS_MAX; i++) {
-        struct CANON_TOOL_TABLE &t = s->status.io.tool.toolTable[i];
+    for(int i=0; i<pockets; i++) {
+        const struct CANON_TOOL_TABLE &t = tools->get(i);
         PyObject *tool = PyStructSequence_New(&ToolResultType);
         PyStructSequence_SET_ITEM(tool, 0, PyInt_FromLong(t.toolno));
         PyStructSequence_SET_ITEM(tool, 1, PyFloat_FromDouble(t.offset.tran.x));
@@ -649,12 +656,20 @@ static PyObject *Stat_tool_table(pyStatChannel *s) {
     return res;
 }
 
+static PyObject *Stat_tool_table(pyStatChannel *s) {
+    if(s->tools->follow(s->status.io.tool) || !s->tool_table) {
+        Py_XDECREF(s->tool_table);
+        s->tool_table = make_tool_table(s->tools);
+    }
+    Py_XINCREF(s->tool_table);
+    return s->tool_table;
+}
+
 static PyObject *Stat_axes(pyStatChannel *s) {
     PyErr_WarnEx(PyExc_DeprecationWarning, "stat.axes is deprecated and will be removed in the future", 0);
     return PyInt_FromLong(s->status.motion.traj.deprecated_axes);
 }
 
-// XXX io.tool.toolTable
 // XXX EMC_JOINT_STAT motion.joint[]
 
 static PyGetSetDef Stat_getsetlist[] = {
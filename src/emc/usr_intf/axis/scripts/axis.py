@@ -1210,7 +1210,8 @@ def open_file_guts(f, filtered=False, addrecent=True):
                 if m == -1: continue
                 initcodes.append("M%d" % m)
         try:
-            result, seq = o.load_preview(f, canon, initcodes, interpname)
+            result, seq = o.load_preview(f, canon, initcodes, interpname,
+                                         preview_jobs)
         except KeyboardInterrupt:
             result, seq = 0, 0
         # According to the documentation, MIN_ERROR is the largest value that is
@@ -3384,6 +3385,7 @@ homing_order_defined = inifile.find("JOINT_0", "HOME_SEQUENCE") is not None
 update_ms = int(1000 * float(inifile.find("DISPLAY","CYCLE_TIME") or 0.020))
 
 interpname = inifile.find("TASK", "INTERPRETER") or ""
+preview_jobs = int(inifile.find("DISPLAY", "PREVIEW_JOBS") or 1)
 
 s = linuxcnc.stat();
 s.poll()
@@ -34,6 +34,7 @@
 #include "rcs_print.hh"
 #include "nml_oi.hh"
 #include "timer.hh"
+#include "toolstore.hh"
 
 /* Using halui: see the man page */
 
@@ -2160,14 +2161,14 @@ static void modify_hal_pins()
     if (emcStatus->io.tool.toolInSpindle == 0) {
         *(halui_data->tool_diameter) = 0.0;
     } else {
-        int pocket;
-        for (pocket = 0; pocket < CANON_POCKETS_MAX; pocket ++) {
-            if (emcStatus->io.tool.toolTable[pocket].toolno == emcStatus->io.tool.toolInSpindle) {
-                *(halui_data->tool_diameter) = emcStatus->io.tool.toolTable[pocket].diameter;
-                break;
-            }
-        }
-        if (pocket == CANON_POCKETS_MAX) {
+        static ToolStore tools;
+        tools.follow(emcStatus->io.tool);
+        // pocket 0 first, like the spindle is
+        int pocket = tools.get(0).toolno == emcStatus->io.tool.toolInSpindle ?
+            0 : tools.find(emcStatus->io.tool.toolInSpindle);
+        if (pocket >= 0) {
+            *(halui_data->tool_diameter) = tools.get(pocket).diameter;
+        } else {
             // didn't find the tool
             *(halui_data->tool_diameter) = 0.0;
         }
@@ -669,6 +669,552 @@ void MakeCalc(char * CalcString,int VerifyMode)
 	}
 }
 
+/* Compiled expressions */
+/* --------------------- */
+/* The compiler below follows the evaluator above step by step, but */
+/* instead of computing the values it writes ops for RunArithmCode( ), */
+/* a little stack machine : the expression string is parsed only once. */
+/* Anything the evaluator would complain about is not compiled, so */
+/* the string is still given to it (and the error shows the same way). */
+
+#define ARITHM_OP_CONST 0
+#define ARITHM_OP_VAR 1
+#define ARITHM_OP_NOT 2
+#define ARITHM_OP_ABS 3
+#define ARITHM_OP_MINI 4
+#define ARITHM_OP_MAXI 5
+#define ARITHM_OP_AVG 6
+#define ARITHM_OP_POW 7
+#define ARITHM_OP_MUL 8
+#define ARITHM_OP_DIV 9
+#define ARITHM_OP_MOD 10
+#define ARITHM_OP_ADD 11
+#define ARITHM_OP_SUB 12
+#define ARITHM_OP_AND 13
+#define ARITHM_OP_XOR 14
+#define ARITHM_OP_OR 15
+#define ARITHM_OP_COMPARE 16
+#define ARITHM_OP_STORE 17
+
+/* compare to do (Arg of ARITHM_OP_COMPARE) */
+#define COMPARE_GREATER 1
+#define COMPARE_LESS 2
+#define COMPARE_DIFFERENT 4
+#define COMPARE_EQUAL 8
+
+static StrArithmOp * CodeOp;
+static StrArithmOp * CodeEnd;
+
+static StrArithmOp * EmitOp(char Op, int Value)
+{
+	if ( CodeOp>=CodeEnd )
+	{
+		ErrorDesc = "Expression too long to compile";
+		return NULL;
+	}
+	CodeOp->Op = Op;
+	CodeOp->Arg = 0;
+	CodeOp->VarType = 0;
+	CodeOp->IndexType = -1;
+	CodeOp->Value = Value;
+	CodeOp->IndexOffset = -1;
+	return CodeOp++;
+}
+
+/* var at Expr : "@xxx/yyy@" or "@xxx/yyy[xxx/yyy]@", Expr is moved after it */
+static StrArithmOp * CompileVarRef(char Op)
+{
+	int VarType,VarOffset,IndexType,IndexOffset;
+	StrArithmOp * pOp;
+	if ( !IdentifyVarIndexedOrNot(Expr, &VarType, &VarOffset, &IndexType, &IndexOffset) )
+		return NULL;
+	/* flush var found */
+	Expr++;
+	do
+	{
+		Expr++;
+	}
+	while( (*Expr!='@') && (*Expr!='\0') );
+	if ( *Expr=='\0' )
+	{
+		ErrorDesc = "Bad var coding, should end with @";
+		return NULL;
+	}
+	Expr++;
+	pOp = EmitOp(Op, VarOffset);
+	if ( pOp )
+	{
+		pOp->VarType = VarType;
+		if ( IndexType!=-1 && IndexOffset!=-1 )
+		{
+			pOp->IndexType = IndexType;
+			pOp->IndexOffset = IndexOffset;
+		}
+	}
+	return pOp;
+}
+
+static void CompileOr(void);
+
+static void CompileFunction(void)
+{
+	char tcFonc[ 20 ], *pFonc;
+	char FoncOp = -1;
+	int NbrVars = 0;
+	StrArithmOp * pOp;
+
+	pFonc = tcFonc;
+	while((unsigned int)(pFonc-tcFonc)<sizeof(tcFonc)-1 && *Expr>='A' && *Expr<='Z')
+	{
+		*pFonc++ = *Expr;
+		Expr++;
+	}
+	*pFonc = '\0';
+
+	if ( *Expr=='\0' )
+	{
+		ErrorDesc = "Missing parenthesis";
+		return;
+	}
+	if ( !strcmp(tcFonc, "ABS") )
+	{
+		Expr++; /* ( */
+		if ( CompileVarRef( ARITHM_OP_VAR ) )
+			EmitOp( ARITHM_OP_ABS, 0 );
+		if ( *Expr=='\0' )
+			ErrorDesc = "Missing parenthesis";
+		Expr++; /* ) */
+		return;
+	}
+	if ( !strcmp(tcFonc, "MINI") )
+		FoncOp = ARITHM_OP_MINI;
+	if ( !strcmp(tcFonc, "MAXI") )
+		FoncOp = ARITHM_OP_MAXI;
+	if ( !strcmp(tcFonc, "MOY") || !strcmp(tcFonc, "AVG") )
+		FoncOp = ARITHM_OP_AVG;
+	if ( FoncOp==-1 )
+	{
+		ErrorDesc = "Unknown function";
+		return;
+	}
+	do
+	{
+		Expr++; /* ( -or- , */
+		if ( !CompileVarRef( ARITHM_OP_VAR ) )
+			return;
+		NbrVars++;
+		if ( *Expr=='\0' )
+		{
+			ErrorDesc = "Missing parenthesis";
+			return;
+		}
+	}
+	while( *Expr!=')' );
+	Expr++; /* ) */
+	pOp = EmitOp( FoncOp, 0 );
+	if ( pOp )
+		pOp->Arg = NbrVars;
+}
+
+static void CompileTerm(void)
+{
+	if ( ErrorDesc )
+		return;
+	if (*Expr=='(')
+	{
+		Expr++;
+		CompileOr();
+		if ( ErrorDesc )
+			return;
+		if (*Expr!=')')
+		{
+			ErrorDesc = "Missing parenthesis";
+			return;
+		}
+		Expr++;
+	}
+	else if ( (*Expr>='0' && *Expr<='9') || (*Expr=='$') || (*Expr=='-') )
+		EmitOp( ARITHM_OP_CONST, Constant() );
+	else if (*Expr>='A' && *Expr<='Z')
+		CompileFunction();
+	else if (*Expr=='@')
+		CompileVarRef( ARITHM_OP_VAR );
+	else if (*Expr=='!')
+	{
+		Expr++;
+		CompileTerm();
+		EmitOp( ARITHM_OP_NOT, 0 );
+	}
+	else
+	{
+		ErrorDesc = "Unknown term";
+	}
+}
+
+static void CompilePow(void)
+{
+	CompileTerm();
+	while(*Expr=='^')
+	{
+		if ( ErrorDesc )
+			break;
+		Expr++;
+		CompilePow();
+		EmitOp( ARITHM_OP_POW, 0 );
+	}
+}
+
+static void CompileMulDivMod(void)
+{
+	CompilePow();
+	while(1)
+	{
+		if ( ErrorDesc )
+			break;
+		if (*Expr=='*')
+		{
+			Expr++;
+			CompilePow();
+			EmitOp( ARITHM_OP_MUL, 0 );
+		}
+		else
+		if (*Expr=='/')
+		{
+			Expr++;
+			CompilePow();
+			EmitOp( ARITHM_OP_DIV, 0 );
+		}
+		else
+		if (*Expr=='%')
+		{
+			Expr++;
+			CompilePow();
+			EmitOp( ARITHM_OP_MOD, 0 );
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+static void CompileAddSub(void)
+{
+	CompileMulDivMod();
+	while(1)
+	{
+		if ( ErrorDesc )
+			break;
+		if (*Expr=='+')
+		{
+			Expr++;
+			CompileMulDivMod();
+			EmitOp( ARITHM_OP_ADD, 0 );
+		}
+		else
+		if (*Expr=='-')
+		{
+			Expr++;
+			CompileMulDivMod();
+			EmitOp( ARITHM_OP_SUB, 0 );
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+static void CompileAnd(void)
+{
+	CompileAddSub();
+	while( !ErrorDesc && *Expr=='&' )
+	{
+		Expr++;
+		CompileAddSub();
+		EmitOp( ARITHM_OP_AND, 0 );
+	}
+}
+static void CompileXor(void)
+{
+	CompileAnd();
+	while( !ErrorDesc && *Expr=='^' )
+	{
+		Expr++;
+		CompileAnd();
+		EmitOp( ARITHM_OP_XOR, 0 );
+	}
+}
+static void CompileOr(void)
+{
+	CompileXor();
+	while( !ErrorDesc && *Expr=='|' )
+	{
+		Expr++;
+		CompileXor();
+		EmitOp( ARITHM_OP_OR, 0 );
+	}
+}
+
+/* start/end of compiling in Code[MaxOps], return number of ops or -1 */
+static void CompileStart(StrArithmOp * Code, int MaxOps)
+{
+	CodeOp = Code;
+	CodeEnd = Code + (MaxOps<ARITHM_EXPR_SIZE?MaxOps:ARITHM_EXPR_SIZE);
+	ErrorDesc = NULL;
+	/* errors are not displayed : the expression will be evaluated */
+	UnderVerify = TRUE;
+}
+static int CompileEnd(StrArithmOp * Code)
+{
+	UnderVerify = FALSE;
+	if ( ErrorDesc )
+		return -1;
+	return CodeOp-Code;
+}
+
+/* Same as EvalCompare( ), the ops leave the result of the compare */
+int CompileEvalCompare(char * CompareString, StrArithmOp * Code, int MaxOps)
+{
+	char * SecondExpr = NULL;
+	char StrCopy[ARITHM_EXPR_SIZE+1];
+	char * SearchSep;
+	char * CutFirst;
+	int Found = FALSE;
+	StrArithmOp * pOp;
+
+	CompileStart( Code, MaxOps );
+	if (*CompareString=='\0' || *CompareString=='#')
+	{
+		EmitOp( ARITHM_OP_CONST, 0 );
+		return CompileEnd( Code );
+	}
+
+	/* zeroed, so parsing stops at the end of the string */
+	memset(StrCopy,0,sizeof(StrCopy));
+	strcpy(StrCopy,CompareString);
+	CutFirst = StrCopy;
+	SearchSep = CompareString;
+	do
+	{
+		if ( (*SearchSep=='>') || (*SearchSep=='<') || (*SearchSep=='=') )
+		{
+			Found = TRUE;
+			*CutFirst = '\0';
+			CutFirst++;
+			SecondExpr = CutFirst;
+			if ( *CutFirst=='=' || *CutFirst=='>')
+			{
+				CutFirst++;
+				SecondExpr = CutFirst;
+			}
+		}
+		else
+		{
+			SearchSep++;
+			CutFirst++;
+		}
+	}
+	while (*SearchSep!='\0' && !Found);
+	if ( !Found )
+	{
+		ErrorDesc = "Missing < or > or = or ... to make compare";
+		return CompileEnd( Code );
+	}
+	Expr = StrCopy;
+	CompileOr();
+	if ( !ErrorDesc )
+	{
+		Expr = SecondExpr;
+		CompileOr();
+	}
+	pOp = EmitOp( ARITHM_OP_COMPARE, 0 );
+	if ( pOp )
+	{
+		if ( *SearchSep=='>' )
+			pOp->Arg |= COMPARE_GREATER;
+		if ( *SearchSep=='<' && *(SearchSep+1)!='>' )
+			pOp->Arg |= COMPARE_LESS;
+		if ( *SearchSep=='<' && *(SearchSep+1)=='>' )
+			pOp->Arg |= COMPARE_DIFFERENT;
+		if ( *SearchSep=='=' || *(SearchSep+1)=='=' )
+			pOp->Arg |= COMPARE_EQUAL;
+	}
+	return CompileEnd( Code );
+}
+
+/* Same as MakeCalc( ), the ops store the result in the target var */
+int CompileMakeCalc(char * CalcString, StrArithmOp * Code, int MaxOps)
+{
+	char StrCopy[ARITHM_EXPR_SIZE+1];
+	int TargetVarType,TargetVarOffset,IndexType,IndexOffset;
+	char * Before;
+	int Found = FALSE;
+	StrArithmOp * pOp;
+
+	CompileStart( Code, MaxOps );
+	if (*CalcString=='\0' || *CalcString=='#')
+		return CompileEnd( Code );
+
+	memset(StrCopy,0,sizeof(StrCopy));
+	strcpy(StrCopy,CalcString);
+	Expr = StrCopy;
+	if ( !IdentifyVarIndexedOrNot(Expr, &TargetVarType, &TargetVarOffset, &IndexType, &IndexOffset) )
+		return CompileEnd( Code );
+	Expr++;
+	do
+	{
+		Expr++;
+	}
+	while( (*Expr!='@') && (*Expr!='\0') );
+	if ( *Expr=='\0' )
+	{
+		ErrorDesc = "Bad var coding, should end with @";
+		return CompileEnd( Code );
+	}
+	Expr++;
+	do
+	{
+		Before = Expr;
+		if (*Expr==':')
+			Expr++;
+		if (*Expr=='=')
+		{
+			Found = TRUE;
+			Expr++;
+		}
+		if (*Expr==' ')
+			Expr++;
+	}
+	while( !Found && *Expr!='\0' && Expr!=Before );
+	while( *Expr==' ')
+		Expr++;
+	if ( !Found )
+	{
+		ErrorDesc = "Missing := to make operate";
+		return CompileEnd( Code );
+	}
+	CompileOr();
+	pOp = EmitOp( ARITHM_OP_STORE, TargetVarOffset );
+	if ( pOp )
+	{
+		pOp->VarType = TargetVarType;
+		if ( IndexType!=-1 && IndexOffset!=-1 )
+		{
+			pOp->IndexType = IndexType;
+			pOp->IndexOffset = IndexOffset;
+		}
+	}
+	return CompileEnd( Code );
+}
+
+/* Run ops compiled by CompileEvalCompare( ) or CompileMakeCalc( ), */
+/* return the value left on the stack (result of the compare) */
+arithmtype RunArithmCode(StrArithmOp * Code, int NbrOps)
+{
+	arithmtype Stack[ ARITHM_EXPR_SIZE ];
+	arithmtype Res;
+	int Top = -1;
+	int Offset, Scan;
+	StrArithmOp * pOp;
+	StrArithmOp * pEnd = Code+NbrOps;
+
+	for ( pOp=Code; pOp<pEnd; pOp++ )
+	{
+		switch( pOp->Op )
+		{
+			case ARITHM_OP_CONST:
+				Stack[ ++Top ] = pOp->Value;
+				break;
+			case ARITHM_OP_VAR:
+				Offset = pOp->Value;
+				if ( pOp->IndexType!=-1 )
+					Offset += ReadVar( pOp->IndexType, pOp->IndexOffset );
+				Stack[ ++Top ] = (arithmtype)ReadVar( pOp->VarType, Offset );
+				break;
+			case ARITHM_OP_NOT:
+				Stack[ Top ] = Stack[ Top ]?0:1;
+				break;
+			case ARITHM_OP_ABS:
+				if ( Stack[ Top ]<0 )
+					Stack[ Top ] = Stack[ Top ] * -1;
+				break;
+			case ARITHM_OP_MINI:
+			case ARITHM_OP_MAXI:
+			case ARITHM_OP_AVG:
+				Top = Top-pOp->Arg+1;
+				Res = pOp->Op==ARITHM_OP_MINI?0x7FFFFFFF:(pOp->Op==ARITHM_OP_MAXI?(int)0x80000000:0);
+				for ( Scan=Top; Scan<Top+pOp->Arg; Scan++ )
+				{
+					if ( pOp->Op==ARITHM_OP_AVG )
+						Res = Res + Stack[ Scan ];
+					else if ( pOp->Op==ARITHM_OP_MINI?Stack[ Scan ]<Res:Stack[ Scan ]>Res )
+						Res = Stack[ Scan ];
+				}
+				if ( pOp->Op==ARITHM_OP_AVG )
+					Res = Res/pOp->Arg;
+				Stack[ Top ] = Res;
+				break;
+			case ARITHM_OP_POW:
+				Top--;
+				Stack[ Top ] = pow_int( Stack[ Top ], Stack[ Top+1 ] );
+				break;
+			case ARITHM_OP_MUL:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] * Stack[ Top+1 ];
+				break;
+			case ARITHM_OP_DIV:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] / Stack[ Top+1 ];
+				break;
+			case ARITHM_OP_MOD:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] % Stack[ Top+1 ];
+				break;
+			case ARITHM_OP_ADD:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] + Stack[ Top+1 ];
+				break;
+			case ARITHM_OP_SUB:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] - Stack[ Top+1 ];
+				break;
+			case ARITHM_OP_AND:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] & Stack[ Top+1 ];
+				break;
+			case ARITHM_OP_XOR:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] ^ Stack[ Top+1 ];
+				break;
+			case ARITHM_OP_OR:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] | Stack[ Top+1 ];
+				break;
+			case ARITHM_OP_COMPARE:
+				Top--;
+				Res = 0;
+				if ( (pOp->Arg&COMPARE_GREATER) && Stack[ Top ]>Stack[ Top+1 ] )
+					Res = 1;
+				if ( (pOp->Arg&COMPARE_LESS) && Stack[ Top ]<Stack[ Top+1 ] )
+					Res = 1;
+				if ( (pOp->Arg&COMPARE_DIFFERENT) && Stack[ Top ]!=Stack[ Top+1 ] )
+					Res = 1;
+				if ( (pOp->Arg&COMPARE_EQUAL) && Stack[ Top ]==Stack[ Top+1 ] )
+					Res = 1;
+				Stack[ Top ] = Res;
+				break;
+			case ARITHM_OP_STORE:
+				Offset = pOp->Value;
+				if ( pOp->IndexType!=-1 )
+					Offset += ReadVar( pOp->IndexType, pOp->IndexOffset );
+				WriteVar( pOp->VarType, Offset, (int)Stack[ Top-- ] );
+				break;
+		}
+	}
+	return Top>=0?Stack[ Top ]:0;
+}
+
 /* Used one time after user input to verify syntax only */
 /* return NULL if ok, else pointer on error description */
 char * VerifySyntaxForEvalCompare(char * StringToVerify)
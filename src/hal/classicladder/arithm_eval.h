@@ -24,5 +24,8 @@ arithmtype AddSub(void);
 arithmtype Or(void);
 char * VerifySyntaxForEvalCompare(char * StringToVerify);
 char * VerifySyntaxForMakeCalc(char * StringToVerify);
+int CompileEvalCompare(char * CompareString, StrArithmOp * Code, int MaxOps);
+int CompileMakeCalc(char * CalcString, StrArithmOp * Code, int MaxOps);
+arithmtype RunArithmCode(StrArithmOp * Code, int NbrOps);
 
 
@@ -84,6 +84,9 @@ StrSection * SectionArray;
 StrSequential * Sequential;
 #endif
 StrSymbol * SymbolArray;
+StrCompiledRung * CompiledRungArray;
+StrRungOp * RungOpArray;
+StrArithmOp * ArithmOpArray;
 
 #ifdef GTK_INTERFACE
 /* used for the editor */
@@ -192,6 +195,10 @@ int ClassicLadder_AllocAll()
     bytes += pSizesInfos->nbr_arithm_expr * sizeof(StrArithmExpr);
     bytes += pSizesInfos->nbr_sections * sizeof(StrSection);
     bytes += pSizesInfos->nbr_symbols * sizeof(StrSymbol);
+    // Rungs and expressions compiled by calc.c
+    bytes += NBR_COMPILED_BANKS * pSizesInfos->nbr_rungs * sizeof(StrCompiledRung);
+    bytes += NBR_COMPILED_BANKS * pSizesInfos->nbr_rungs * RUNG_OPS_PER_RUNG * sizeof(StrRungOp);
+    bytes += NBR_COMPILED_BANKS * pSizesInfos->nbr_arithm_expr * ARITHM_OPS_PER_EXPR * sizeof(StrArithmOp);
     
 #ifdef SEQUENTIAL_SUPPORT
     bytes += sizeof(StrSequential);
@@ -308,6 +315,12 @@ int ClassicLadder_AllocAll()
     Sequential = (StrSequential *) pByte;	
   	  pByte += sizeof(StrSequential);
 #endif
+    CompiledRungArray = (StrCompiledRung *) pByte;
+	   pByte += NBR_COMPILED_BANKS * pSizesInfos->nbr_rungs * sizeof(StrCompiledRung);
+    ArithmOpArray = (StrArithmOp *) pByte;
+	   pByte += NBR_COMPILED_BANKS * pSizesInfos->nbr_arithm_expr * ARITHM_OPS_PER_EXPR * sizeof(StrArithmOp);
+    RungOpArray = (StrRungOp *) pByte;
+	   pByte += NBR_COMPILED_BANKS * pSizesInfos->nbr_rungs * RUNG_OPS_PER_RUNG * sizeof(StrRungOp);
     VarWordArray = (int *) pByte;
  	   pByte += SIZE_VAR_WORD_ARRAY * sizeof(int);
     VarFloatArray =(double *) pByte;
@@ -316,6 +329,11 @@ int ClassicLadder_AllocAll()
     VarArray = (TYPE_FOR_BOOL_VAR *) pByte;
 
 	InitInfosGene( );
+#ifdef RTAPI
+	// nothing compiled until the user space part loads a program
+	InfosGene->CompiledBank = 0;
+	InitCompiledRungs( );
+#endif
 
 return TRUE;
 }
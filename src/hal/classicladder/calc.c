@@ -70,6 +70,7 @@ void InitRungs()
 	InfosGene->LastRung = 0;
 	InfosGene->CurrentRung = 0;
 	RungArray[0].Used = TRUE;
+	InitCompiledRungs( );
 }
 /* Set DynamicVarBak (Element) to the right value before calculating the rungs */
 /* for detecting rising/falling edges used in some elements */
@@ -204,6 +205,9 @@ void PrepareAllDatasBeforeRun( )
 #ifdef SEQUENTIAL_SUPPORT
 	PrepareSequential( );
 #endif
+#ifndef RTAPI
+	CompileAllRungs( );
+#endif
 }
 
 void InitArithmExpr()
@@ -383,27 +387,8 @@ int CalcTypeOutputCall(int x,int y,StrRung * UpdateRung)
 // Marc added a control pin to the old timers to add features
 // For EMC, force (C) control pin to always be true so it doesn't
 // break older programs
-void CalcTypeTimer(int x,int y,StrRung * UpdateRung)
+void RefreshTimer(StrTimer * Timer)
 {
-    StrTimer * Timer;
-    Timer = &TimerArray[UpdateRung->Element[x][y].VarNum];
-    // directly connected to the "left"? if yes, ON !
-    if (x==0)
-    {
-        Timer->InputEnable = 1;
-    }
-    else
-    {
-        Timer->InputEnable = StateOnLeft(x-1,y,UpdateRung);
-    }
-    if (x==0)
-    {
-        Timer->InputControl = 1;
-    }
-    else
-    {
-        Timer->InputControl = StateOnLeft(x-1,y+1,UpdateRung);
-    }
     if (!Timer->InputEnable)
     {
         Timer->OutputRunning = 0;
@@ -427,23 +412,35 @@ void CalcTypeTimer(int x,int y,StrRung * UpdateRung)
             Timer->OutputDone = 1;
         }
     }
-    UpdateRung->Element[x][y].DynamicOutput = Timer->OutputDone;
-    UpdateRung->Element[x][y+1].DynamicOutput = Timer->OutputRunning;
 }
-/* Element : Monostable (2x2 Blocks) */
-void CalcTypeMonostable(int x,int y,StrRung * UpdateRung)
+void CalcTypeTimer(int x,int y,StrRung * UpdateRung)
 {
-    StrMonostable * Monostable;
-    Monostable = &MonostableArray[UpdateRung->Element[x][y].VarNum];
+    StrTimer * Timer;
+    Timer = &TimerArray[UpdateRung->Element[x][y].VarNum];
     // directly connected to the "left"? if yes, ON !
     if (x==0)
     {
-        Monostable->Input = 1;
+        Timer->InputEnable = 1;
     }
     else
     {
-        Monostable->Input = StateOnLeft(x-1,y,UpdateRung);
+        Timer->InputEnable = StateOnLeft(x-1,y,UpdateRung);
+    }
+    if (x==0)
+    {
+        Timer->InputControl = 1;
     }
+    else
+    {
+        Timer->InputControl = StateOnLeft(x-1,y+1,UpdateRung);
+    }
+    RefreshTimer(Timer);
+    UpdateRung->Element[x][y].DynamicOutput = Timer->OutputDone;
+    UpdateRung->Element[x][y+1].DynamicOutput = Timer->OutputRunning;
+}
+/* Element : Monostable (2x2 Blocks) */
+void RefreshMonostable(StrMonostable * Monostable)
+{
     /* detecting impulse on input, the monostable is not retriggerable */
     if (Monostable->Input && !Monostable->InputBak && (Monostable->Value==0) )
     {
@@ -455,32 +452,32 @@ void CalcTypeMonostable(int x,int y,StrRung * UpdateRung)
     else
         Monostable->OutputRunning = 0;
     Monostable->InputBak = Monostable->Input;
+}
+void CalcTypeMonostable(int x,int y,StrRung * UpdateRung)
+{
+    StrMonostable * Monostable;
+    Monostable = &MonostableArray[UpdateRung->Element[x][y].VarNum];
+    // directly connected to the "left"? if yes, ON !
+    if (x==0)
+    {
+        Monostable->Input = 1;
+    }
+    else
+    {
+        Monostable->Input = StateOnLeft(x-1,y,UpdateRung);
+    }
+    RefreshMonostable(Monostable);
     UpdateRung->Element[x][y].DynamicOutput = Monostable->OutputRunning;
 }
 #endif
 /* Element : Counter (2x4 Blocks) */
-void CalcTypeCounter(int x,int y,StrRung * UpdateRung)
+/* Counter logic, with its inputs already set */
+void RefreshCounter(int CounterNbr)
 {
-	int CounterNbr = UpdateRung->Element[x][y].VarNum;
 	StrCounter * Counter = &CounterArray[ CounterNbr ];
 	char DoneResult, EmptyResult, FullResult;
 	int CurrentValue = ReadVar( VAR_COUNTER_VALUE, CounterNbr );
 	int PresetValue = ReadVar( VAR_COUNTER_PRESET, CounterNbr );
-	// directly connected to the "left"? if yes, ON !
-	if ( x==0 )
-	{
-		Counter->InputReset = 1;
-		Counter->InputPreset = 1;
-		Counter->InputCountUp = 1;
-		Counter->InputCountDown = 1;
-	}
-	else
-	{
-		Counter->InputReset = StateOnLeft(x-1,y,UpdateRung);
-		Counter->InputPreset = StateOnLeft(x-1,y+1,UpdateRung);
-		Counter->InputCountUp = StateOnLeft(x-1,y+2,UpdateRung);
-		Counter->InputCountDown = StateOnLeft(x-1,y+3,UpdateRung);
-	}
 	if ( Counter->InputCountUp && Counter->InputCountUpBak==0 )
 	{
 		Counter->ValueBak = CurrentValue;
@@ -511,9 +508,6 @@ void CalcTypeCounter(int x,int y,StrRung * UpdateRung)
 	DoneResult = ( CurrentValue==PresetValue )?1:0;
 	EmptyResult = ( CurrentValue==9999 && Counter->ValueBak==0 )?1:0;
 	FullResult = ( CurrentValue==0 && Counter->ValueBak==9999 )?1:0;
-	UpdateRung->Element[x][y + 1].DynamicOutput = DoneResult;
-	UpdateRung->Element[x][y].DynamicOutput = EmptyResult;
-	UpdateRung->Element[x][y + 2].DynamicOutput = FullResult;
 
 	// now update public vars
 	// (we could have directly written in the counter structure)
@@ -524,25 +518,40 @@ void CalcTypeCounter(int x,int y,StrRung * UpdateRung)
 	WriteVar( VAR_COUNTER_PRESET, CounterNbr, PresetValue );
 	WriteVar( VAR_COUNTER_VALUE, CounterNbr, CurrentValue );
 }
+void CalcTypeCounter(int x,int y,StrRung * UpdateRung)
+{
+	int CounterNbr = UpdateRung->Element[x][y].VarNum;
+	StrCounter * Counter = &CounterArray[ CounterNbr ];
+	// directly connected to the "left"? if yes, ON !
+	if ( x==0 )
+	{
+		Counter->InputReset = 1;
+		Counter->InputPreset = 1;
+		Counter->InputCountUp = 1;
+		Counter->InputCountDown = 1;
+	}
+	else
+	{
+		Counter->InputReset = StateOnLeft(x-1,y,UpdateRung);
+		Counter->InputPreset = StateOnLeft(x-1,y+1,UpdateRung);
+		Counter->InputCountUp = StateOnLeft(x-1,y+2,UpdateRung);
+		Counter->InputCountDown = StateOnLeft(x-1,y+3,UpdateRung);
+	}
+	RefreshCounter(CounterNbr);
+	UpdateRung->Element[x][y + 1].DynamicOutput = Counter->OutputDone;
+	UpdateRung->Element[x][y].DynamicOutput = Counter->OutputEmpty;
+	UpdateRung->Element[x][y + 2].DynamicOutput = Counter->OutputFull;
+}
 /* Element : New IEC Timer with many modes (2x2 Blocks) */
-void CalcTypeTimerIEC(int x,int y,StrRung * UpdateRung)
+/* IEC Timer logic, with its input already set */
+void RefreshTimerIEC(int TimerNbr)
 {
-	int TimerNbr = UpdateRung->Element[x][y].VarNum;
 	StrTimerIEC * TimerIEC = &NewTimerArray[ TimerNbr ];
 	int CurrentValue = ReadVar( VAR_TIMER_IEC_VALUE, TimerNbr );
 	int PresetValue = ReadVar( VAR_TIMER_IEC_PRESET, TimerNbr );
 	char OutputResult = ReadVar( VAR_TIMER_IEC_DONE, TimerNbr );
 
 	char DoIncTime = FALSE;
-	// directly connected to the "left"? if yes, ON !
-	if (x==0)
-	{
-		TimerIEC->Input = 1;
-	}
-	else
-	{
-		TimerIEC->Input = StateOnLeft(x-1,y,UpdateRung);
-	}
 	switch( TimerIEC->TimerMode )
 	{
 		case TIMER_IEC_MODE_ON:
@@ -610,7 +619,6 @@ void CalcTypeTimerIEC(int x,int y,StrRung * UpdateRung)
 		}
 	}
 	TimerIEC->InputBak = TimerIEC->Input;
-	UpdateRung->Element[x][y].DynamicOutput = OutputResult;
 	// now update public vars
 	// (we could have directly written in the IEC Timer structure)
 	// (but on another project, vars can be mapped in another way)
@@ -618,6 +626,22 @@ void CalcTypeTimerIEC(int x,int y,StrRung * UpdateRung)
 	WriteVar( VAR_TIMER_IEC_PRESET, TimerNbr, PresetValue );
 	WriteVar( VAR_TIMER_IEC_VALUE, TimerNbr, CurrentValue );
 }
+void CalcTypeTimerIEC(int x,int y,StrRung * UpdateRung)
+{
+	int TimerNbr = UpdateRung->Element[x][y].VarNum;
+	StrTimerIEC * TimerIEC = &NewTimerArray[ TimerNbr ];
+	// directly connected to the "left"? if yes, ON !
+	if (x==0)
+	{
+		TimerIEC->Input = 1;
+	}
+	else
+	{
+		TimerIEC->Input = StateOnLeft(x-1,y,UpdateRung);
+	}
+	RefreshTimerIEC(TimerNbr);
+	UpdateRung->Element[x][y].DynamicOutput = TimerIEC->Output;
+}
 
 /* Element : Compar (3 Horizontal Blocks) */
 char CalcTypeCompar(int x,int y,StrRung * UpdateRung)
@@ -749,6 +773,454 @@ int RefreshRung(StrRung * Rung, int * JumpTo)
 }
 
 
+/* Compiled rungs */
+/* -------------- */
+/* RefreshRung( ) walks the whole grid of a rung at each scan and */
+/* follows the vertical connections to get the state on the left of */
+/* each element. CompileRung( ) does that walk once: it lists the */
+/* elements in the same order, each with the rows of the column on its */
+/* left that feed its inputs, and compiles the arithmetic expressions. */
+/* Rows of that column that no element of the rung writes are constant, */
+/* so they are folded into LEFT_ON or left out. RunCompiledRung( ) then */
+/* does the same as RefreshRung( ) with this list of ops. */
+/* The user space part compiles the rungs after loading and when the */
+/* editor changed them, never the realtime scan. It compiles into the */
+/* bank of the compiled arrays that the scans don't use, and then */
+/* publishes it by switching InfosGene->CompiledBank, which a scan */
+/* reads once when it starts. */
+
+#define LEFT_ON 0x80	/* input on, whatever the column on the left */
+#define LEFT_RAIL 0xc0	/* element against the left rail */
+#define VAR_IN_VARARRAY -1	/* VarNum is an index in VarArray */
+
+#define COMPILED_RUNGS(Bank) (&CompiledRungArray[(Bank)*NBR_RUNGS])
+#define RUNG_OPS(Bank) (&RungOpArray[(Bank)*NBR_RUNG_OPS])
+#define ARITHM_OPS(Bank) (&ArithmOpArray[(Bank)*NBR_ARITHM_OPS])
+
+/* bank used by the scan running */
+static StrCompiledRung * ScanCompiledRungs;
+static StrRungOp * ScanRungOps;
+static StrArithmOp * ScanArithmOps;
+
+/* no rung compiled: they are all interpreted */
+void InitCompiledRungs(void)
+{
+    int Bank,NumRung;
+    for (Bank=0;Bank<NBR_COMPILED_BANKS;Bank++)
+    {
+        for (NumRung=0;NumRung<NBR_RUNGS;NumRung++)
+            COMPILED_RUNGS(Bank)[NumRung].NbrOps = -1;
+    }
+}
+
+#ifndef RTAPI
+/* bank being compiled */
+static StrRungOp * CompileRungOps;
+static StrArithmOp * CompileArithmOps;
+static int NbrRungOpsUsed;
+static int NbrArithmOpsUsed;
+
+/* Rows of the column on the left ORed by StateOnLeft(x,y,Rung) */
+static unsigned char CompileLeft(int x,int y,StrRung * Rung,char * Written)
+{
+    unsigned char Rows;
+    int PosY;
+    if (x<=0)
+        return LEFT_ON;
+    Rows = 1<<y;
+    /* Up */
+    PosY = y;
+    while( PosY>0 && Rung->Element[x][PosY].ConnectedWithTop )
+    {
+        PosY--;
+        Rows |= 1<<PosY;
+    }
+    /* Down */
+    PosY = y+1;
+    while( PosY<RUNG_HEIGHT && Rung->Element[x][PosY].ConnectedWithTop )
+    {
+        Rows |= 1<<PosY;
+        PosY++;
+    }
+    /* outputs never written keep their state */
+    for (PosY=0;PosY<RUNG_HEIGHT;PosY++)
+    {
+        if ( (Rows & (1<<PosY)) && !Written[(x-1)*RUNG_HEIGHT+PosY] )
+        {
+            if (Rung->Element[x-1][PosY].DynamicOutput)
+                return LEFT_ON;
+            Rows &= ~(1<<PosY);
+        }
+    }
+    return Rows;
+}
+
+/* Compile the rung in RungOpArray[ ], FALSE if it can't be */
+static int CompileRung(StrRung * Rung,StrCompiledRung * Compiled)
+{
+    char Written[RUNG_WIDTH*RUNG_HEIGHT];
+    StrElement * Ele;
+    StrRungOp * Op;
+    int x,y,NbrOutputs,NbrRows,Input,VarIndex,NbrArithmOps;
+    char * Expr;
+
+    /* outputs of the elements, set at each refresh */
+    memset(Written,0,sizeof(Written));
+    for (x=0;x<RUNG_WIDTH;x++)
+    {
+        for (y=0;y<RUNG_HEIGHT;y++)
+        {
+            NbrOutputs = 0;
+            NbrRows = 1;
+            switch(Rung->Element[x][y].Type)
+            {
+                case ELE_INPUT:
+                case ELE_INPUT_NOT:
+                case ELE_RISING_INPUT:
+                case ELE_FALLING_INPUT:
+                case ELE_CONNECTION:
+                case ELE_TIMER_IEC:
+#ifdef OLD_TIMERS_MONOS_SUPPORT
+                case ELE_MONOSTABLE:
+#endif
+                    NbrOutputs = 1;
+                    break;
+#ifdef OLD_TIMERS_MONOS_SUPPORT
+                case ELE_TIMER:
+                    NbrOutputs = 2;
+                    NbrRows = 2;
+                    break;
+#endif
+                case ELE_COUNTER:
+                    NbrOutputs = 3;
+                    NbrRows = 4;
+                    break;
+                case ELE_COMPAR:
+                    NbrOutputs = 1;
+                    /* fall through */
+                case ELE_OUTPUT_OPERATE:
+                    if ( x<2 )
+                        return FALSE;
+                    break;
+            }
+            if ( y+NbrRows>RUNG_HEIGHT )
+                return FALSE;
+            memset(&Written[x*RUNG_HEIGHT+y],1,NbrOutputs);
+        }
+    }
+
+    Compiled->FirstOp = NbrRungOpsUsed;
+    for (x=0;x<RUNG_WIDTH;x++)
+    {
+        for (y=0;y<RUNG_HEIGHT;y++)
+        {
+            if ( NbrRungOpsUsed>=NBR_RUNG_OPS )
+                return FALSE;
+            Ele = &Rung->Element[x][y];
+            Op = &CompileRungOps[NbrRungOpsUsed];
+            Op->Op = Ele->Type;
+            Op->Cell = x*RUNG_HEIGHT+y;
+            Op->LeftCell = x>0?(x-1)*RUNG_HEIGHT:0;
+            Op->VarType = Ele->VarType;
+            Op->VarNum = Ele->VarNum;
+            switch(Ele->Type)
+            {
+                case ELE_FREE:
+                case ELE_UNUSABLE:
+                    Op->Op = ELE_FREE;
+                    Op->Left[0] = CompileLeft(x,y,Rung,Written);
+                    break;
+                case ELE_INPUT:
+                case ELE_INPUT_NOT:
+                case ELE_RISING_INPUT:
+                case ELE_FALLING_INPUT:
+                    VarIndex = VarArrayIndex(Ele->VarType,Ele->VarNum);
+                    if ( VarIndex>=0 )
+                    {
+                        Op->VarType = VAR_IN_VARARRAY;
+                        Op->VarNum = VarIndex;
+                    }
+                    /* fall through */
+                case ELE_CONNECTION:
+                    Op->Left[0] = x==0?LEFT_RAIL:CompileLeft(x,y,Rung,Written);
+                    break;
+#ifdef OLD_TIMERS_MONOS_SUPPORT
+                case ELE_TIMER:
+                case ELE_MONOSTABLE:
+#endif
+                case ELE_COUNTER:
+                case ELE_TIMER_IEC:
+                    /* inputs on the left of the left column of the block */
+                    Op->LeftCell = x>1?(x-2)*RUNG_HEIGHT:0;
+                    NbrRows = Ele->Type==ELE_COUNTER?4:(Ele->Type==ELE_TIMER?2:1);
+                    for (Input=0;Input<NbrRows;Input++)
+                        Op->Left[Input] = CompileLeft(x-1,y+Input,Rung,Written);
+                    break;
+                case ELE_COMPAR:
+                case ELE_OUTPUT_OPERATE:
+                    Expr = ArithmExpr[Ele->VarNum].Expr;
+                    if ( Ele->Type==ELE_COMPAR )
+                        NbrArithmOps = CompileEvalCompare(Expr,&CompileArithmOps[NbrArithmOpsUsed],NBR_ARITHM_OPS-NbrArithmOpsUsed);
+                    else
+                        NbrArithmOps = CompileMakeCalc(Expr,&CompileArithmOps[NbrArithmOpsUsed],NBR_ARITHM_OPS-NbrArithmOpsUsed);
+                    /* if not compiled (-1), the string is evaluated */
+                    Op->VarType = NbrArithmOps;
+                    if ( NbrArithmOps>=0 )
+                    {
+                        Op->VarNum = NbrArithmOpsUsed;
+                        NbrArithmOpsUsed += NbrArithmOps;
+                    }
+                    /* inputs on the left of the 3 blocks */
+                    Op->LeftCell = x>2?(x-3)*RUNG_HEIGHT:0;
+                    if ( x==2 && Ele->Type==ELE_COMPAR )
+                        Op->Left[0] = LEFT_RAIL;
+                    else
+                        Op->Left[0] = CompileLeft(x-2,y,Rung,Written);
+                    break;
+                case ELE_OUTPUT:
+                case ELE_OUTPUT_NOT:
+                case ELE_OUTPUT_SET:
+                case ELE_OUTPUT_RESET:
+                case ELE_OUTPUT_JUMP:
+                case ELE_OUTPUT_CALL:
+                    Op->Left[0] = CompileLeft(x,y,Rung,Written);
+                    break;
+                default:
+                    continue;
+            }
+            NbrRungOpsUsed++;
+        }
+    }
+    Compiled->NbrOps = NbrRungOpsUsed-Compiled->FirstOp;
+    return TRUE;
+}
+
+/* Compile all the rungs used (the others are interpreted, if used later) */
+/* in the bank not used by the scans, then make the scans use it */
+void CompileAllRungs(void)
+{
+    int Bank = 1-InfosGene->CompiledBank;
+    StrCompiledRung * Compiled = COMPILED_RUNGS(Bank);
+    int NumRung;
+    int NbrNotCompiled = 0;
+    int ArithmOpsBefore;
+    CompileRungOps = RUNG_OPS(Bank);
+    CompileArithmOps = ARITHM_OPS(Bank);
+    NbrRungOpsUsed = 0;
+    NbrArithmOpsUsed = 0;
+    for (NumRung=0;NumRung<NBR_RUNGS;NumRung++)
+    {
+        Compiled[NumRung].NbrOps = -1;
+        if ( RungArray[NumRung].Used && !nocompile )
+        {
+            ArithmOpsBefore = NbrArithmOpsUsed;
+            if ( !CompileRung(&RungArray[NumRung],&Compiled[NumRung]) )
+            {
+                Compiled[NumRung].NbrOps = -1;
+                NbrRungOpsUsed = Compiled[NumRung].FirstOp;
+                NbrArithmOpsUsed = ArithmOpsBefore;
+                NbrNotCompiled++;
+            }
+        }
+    }
+    if ( NbrNotCompiled>0 )
+        debug_printf("%d rungs not compiled (too large), they are interpreted\n",NbrNotCompiled);
+    __sync_synchronize( );
+    InfosGene->CompiledBank = Bank;
+    /* a scan started before still uses the other bank, which is */
+    /* compiled in next time */
+    WaitEndOfScan( );
+}
+
+/* The scans interpret this rung from now on, before the editor */
+/* changes it under its compiled ops (until CompileAllRungs( ) again) */
+void UncompileRung(int NumRung)
+{
+    COMPILED_RUNGS(InfosGene->CompiledBank)[NumRung].NbrOps = -1;
+    WaitEndOfScan( );
+}
+#endif
+
+/* State on the left of an element, from the rows of the column there */
+static inline char LeftState(StrElement * Column,unsigned char Rows)
+{
+    if (Rows & LEFT_ON)
+        return 1;
+    for ( ; Rows; Rows>>=1,Column++)
+    {
+        if ( (Rows & 1) && Column->DynamicOutput )
+            return 1;
+    }
+    return 0;
+}
+
+/* Same as RefreshRung( ), with the ops of a compiled rung */
+static int RunCompiledRung(StrRung * Rung,StrCompiledRung * Compiled)
+{
+    StrElement * Elements = &Rung->Element[0][0];
+    StrRungOp * Op = &ScanRungOps[Compiled->FirstOp];
+    StrRungOp * EndOp = Op+Compiled->NbrOps;
+    StrElement * Ele;
+    StrElement * Left;
+    char State,StateElement,StateVar;
+    int SectionToCall;
+
+    for ( ; Op<EndOp; Op++ )
+    {
+        Ele = &Elements[Op->Cell];
+        Left = &Elements[Op->LeftCell];
+        switch(Op->Op)
+        {
+            case ELE_FREE:
+                Ele->DynamicInput = LeftState(Left,Op->Left[0]);
+                break;
+            case ELE_INPUT:
+            case ELE_INPUT_NOT:
+            case ELE_RISING_INPUT:
+            case ELE_FALLING_INPUT:
+                if ( Op->VarType==VAR_IN_VARARRAY )
+                    StateElement = VarArray[Op->VarNum];
+                else
+                    StateElement = ReadVar(Op->VarType,Op->VarNum);
+                if ( Op->Op==ELE_INPUT_NOT || Op->Op==ELE_FALLING_INPUT )
+                    StateElement = !StateElement;
+                StateVar = StateElement;
+                if ( Op->Op==ELE_RISING_INPUT || Op->Op==ELE_FALLING_INPUT )
+                {
+                    if (StateElement && Ele->DynamicVarBak)
+                        StateElement = 0;
+                }
+                Ele->DynamicState = StateElement;
+                if ( Op->Left[0]==LEFT_RAIL )
+                {
+                    State = StateElement;
+                }
+                else
+                {
+                    Ele->DynamicInput = LeftState(Left,Op->Left[0]);
+                    State = StateElement && Ele->DynamicInput;
+                }
+                Ele->DynamicOutput = State;
+                Ele->DynamicVarBak = StateVar;
+                break;
+            case ELE_CONNECTION:
+                if ( Op->Left[0]==LEFT_RAIL )
+                {
+                    State = 1;
+                }
+                else
+                {
+                    Ele->DynamicInput = LeftState(Left,Op->Left[0]);
+                    State = Ele->DynamicInput;
+                }
+                Ele->DynamicState = State;
+                Ele->DynamicOutput = State;
+                break;
+#ifdef OLD_TIMERS_MONOS_SUPPORT
+            case ELE_TIMER:
+                TimerArray[Op->VarNum].InputEnable = LeftState(Left,Op->Left[0]);
+                TimerArray[Op->VarNum].InputControl = LeftState(Left,Op->Left[1]);
+                RefreshTimer(&TimerArray[Op->VarNum]);
+                Ele[0].DynamicOutput = TimerArray[Op->VarNum].OutputDone;
+                Ele[1].DynamicOutput = TimerArray[Op->VarNum].OutputRunning;
+                break;
+            case ELE_MONOSTABLE:
+                MonostableArray[Op->VarNum].Input = LeftState(Left,Op->Left[0]);
+                RefreshMonostable(&MonostableArray[Op->VarNum]);
+                Ele->DynamicOutput = MonostableArray[Op->VarNum].OutputRunning;
+                break;
+#endif
+            case ELE_COUNTER:
+                CounterArray[Op->VarNum].InputReset = LeftState(Left,Op->Left[0]);
+                CounterArray[Op->VarNum].InputPreset = LeftState(Left,Op->Left[1]);
+                CounterArray[Op->VarNum].InputCountUp = LeftState(Left,Op->Left[2]);
+                CounterArray[Op->VarNum].InputCountDown = LeftState(Left,Op->Left[3]);
+                RefreshCounter(Op->VarNum);
+                Ele[1].DynamicOutput = CounterArray[Op->VarNum].OutputDone;
+                Ele[0].DynamicOutput = CounterArray[Op->VarNum].OutputEmpty;
+                Ele[2].DynamicOutput = CounterArray[Op->VarNum].OutputFull;
+                break;
+            case ELE_TIMER_IEC:
+                NewTimerArray[Op->VarNum].Input = LeftState(Left,Op->Left[0]);
+                RefreshTimerIEC(Op->VarNum);
+                Ele->DynamicOutput = NewTimerArray[Op->VarNum].Output;
+                break;
+            case ELE_COMPAR:
+                if ( Op->VarType>=0 )
+                    StateElement = RunArithmCode(&ScanArithmOps[Op->VarNum],Op->VarType);
+                else
+                    StateElement = EvalCompare(ArithmExpr[Ele->VarNum].Expr);
+                Ele->DynamicState = StateElement;
+                if ( Op->Left[0]==LEFT_RAIL )
+                {
+                    State = StateElement;
+                }
+                else
+                {
+                    /* input drawn on the first block */
+                    Ele[-2*RUNG_HEIGHT].DynamicInput = LeftState(Left,Op->Left[0]);
+                    State = StateElement && Ele[-2*RUNG_HEIGHT].DynamicInput;
+                }
+                Ele->DynamicOutput = State;
+                break;
+            case ELE_OUTPUT:
+            case ELE_OUTPUT_NOT:
+                State = LeftState(Left,Op->Left[0]);
+                Ele->DynamicInput = State;
+                Ele->DynamicState = State;
+                if ( Op->Op==ELE_OUTPUT_NOT )
+                    State = !State;
+                WriteVar(Op->VarType,Op->VarNum,State);
+                break;
+            case ELE_OUTPUT_SET:
+            case ELE_OUTPUT_RESET:
+                State = LeftState(Left,Op->Left[0]);
+                Ele->DynamicInput = State;
+                Ele->DynamicState = State;
+                if (State)
+                    WriteVar(Op->VarType,Op->VarNum,Op->Op==ELE_OUTPUT_SET?1:0);
+                break;
+            case ELE_OUTPUT_JUMP:
+                State = LeftState(Left,Op->Left[0]);
+                Ele->DynamicInput = State;
+                Ele->DynamicState = State;
+                // we abort the refresh of the rung immediately...
+                if (State)
+                    return Op->VarNum;
+                break;
+            case ELE_OUTPUT_CALL:
+                State = LeftState(Left,Op->Left[0]);
+                SectionToCall = -1;
+                if (State)
+                    SectionToCall = SearchSubRoutineWithItsNumber( Op->VarNum );
+                Ele->DynamicInput = State;
+                Ele->DynamicState = State;
+                if ( SectionToCall!=-1 )
+                {
+                    StrSection * pSubRoutineSection = &SectionArray[ SectionToCall ];
+                    if ( pSubRoutineSection->Used && pSubRoutineSection->SubRoutineNumber>=0 )
+                        RefreshASection( pSubRoutineSection ); //recursive call! ;-)
+                    else
+                        debug_printf("Refresh rungs aborted - call to a sub-routine undefined or programmed as main !!!");
+                }
+                break;
+            case ELE_OUTPUT_OPERATE:
+                State = LeftState(Left,Op->Left[0]);
+                if (State)
+                {
+                    if ( Op->VarType>=0 )
+                        RunArithmCode(&ScanArithmOps[Op->VarNum],Op->VarType);
+                    else
+                        MakeCalc(ArithmExpr[Ele->VarNum].Expr,FALSE /* verify mode */);
+                }
+                Ele->DynamicInput = State;
+                Ele->DynamicState = State;
+                break;
+        }
+    }
+    return -1;
+}
+
 // we refresh all the rungs of this section.
 // we can (J)ump to another rung in this section.
 // we can arrive here with a sub-routine (C)all coil (another section, recursively) !
@@ -760,7 +1232,10 @@ void RefreshASection( StrSection * pSection )
 	int MadLoopBreak = 0;
 	do
 	{
-		RefreshRung(&RungArray[NumRung], &Goto);
+		if ( ScanCompiledRungs[NumRung].NbrOps>=0 )
+			Goto = RunCompiledRung(&RungArray[NumRung], &ScanCompiledRungs[NumRung]);
+		else
+			RefreshRung(&RungArray[NumRung], &Goto);
 
 		if ( Goto!=-1 )
 		{
@@ -795,9 +1270,18 @@ void ClassicLadder_RefreshAllSections()
 {
 	int ScanMainSection;
 	StrSection * pScanSection;
+	int Bank;
 
 	CycleStart();
 
+	// the bank of compiled rungs for the whole scan (see CompileAllRungs( ))
+	InfosGene->UnderCalculationPleaseWait = TRUE;
+	__sync_synchronize( );
+	Bank = InfosGene->CompiledBank;
+	ScanCompiledRungs = COMPILED_RUNGS(Bank);
+	ScanRungOps = RUNG_OPS(Bank);
+	ScanArithmOps = ARITHM_OPS(Bank);
+
 	for ( ScanMainSection=0; ScanMainSection<NBR_SECTIONS; ScanMainSection++ )
 	{
 
@@ -821,6 +1305,8 @@ void ClassicLadder_RefreshAllSections()
 	}// for( )
 
 	CycleEnd();
+	__sync_synchronize( );
+	InfosGene->UnderCalculationPleaseWait = FALSE;
 //TODO: times measures should be moved directly in the module task
 // time measurement has been moved to module_hal.c for EMC
 }
@@ -28,5 +28,8 @@ void PrepareAllDatasBeforeRun(void);
 void InitArithmExpr(void);
 void InitIOConf( void );
 void RefreshASection( StrSection * pSection );
+void InitCompiledRungs( void );
+void CompileAllRungs( void );
+void UncompileRung( int NumRung );
 void ClassicLadder_RefreshAllSections(void);
 void CopyRungToRung(StrRung * RungSrc,StrRung * RungDest);
@@ -75,7 +75,7 @@
 #endif
 
 int cl_remote;
-int nogui = 0,modmaster=0,modslave=0,pathswitch=0;;
+int nogui = 0,nocompile=0,modmaster=0,modslave=0,pathswitch=0;;
 int ModbusServerPort = 9502; // Standard "502" requires root privileges...
 int CyclicThreadRunning = 0;
 char  *NewPath;
@@ -113,6 +113,7 @@ void display_help (void)
 	       "   --modslave         initialize modbus slave I/O (TCP only- B and W variables accesable\n"
 	       "   --modbus_port=portnumber  used for modbus slave using TCP ( ethernet )\n"
 	       "   --debug            sets the RTAPI debuglevel for printing debug messages\n"
+	       "   --nocompile        interpret the rungs at each scan instead of compiling them\n"
 	       "Please also note that the classicladder realtime module must be loaded first\n"
 	       "eg: loadrt classicladder_rt    for default number of ladder objects\n"  
 			    );
@@ -137,6 +138,7 @@ void process_options (int argc, char *argv[])
 			{"debug",no_argument,0,'d'},
 			{"modbus_port", required_argument, 0, 'p'},
 			{"newpath", required_argument, 0, 'f'},
+			{"nocompile", no_argument, 0, 'i'},
 			{0, 0, 0, 0},
 		};
 
@@ -171,6 +173,9 @@ void process_options (int argc, char *argv[])
 				NewPath = ( optarg );
 				pathswitch=1;
 				break;
+			case 'i':
+				nocompile = 1;
+				break;
 			case '?':
 				error = 1;
 				break;
@@ -202,6 +207,15 @@ void DoPauseMilliSecs( int Time )
 	nanosleep( &time, NULL );
 	//usleep( Time*1000 );
 }
+// wait for the end of a scan that may have started before a change
+void WaitEndOfScan( void )
+{
+	__sync_synchronize( );
+	while( InfosGene->UnderCalculationPleaseWait==TRUE )
+	{
+		DoPauseMilliSecs( 1 );
+	}
+}
 void StopRunIfRunning( void )
 {
 	if (InfosGene->LadderState==STATE_RUN)
@@ -284,6 +284,46 @@ typedef struct StrArithmExpr
 	char Expr[ARITHM_EXPR_SIZE];
 }StrArithmExpr;
 
+/* an arithmetic expression compiled by arithm_eval.c for calc.c */
+typedef struct StrArithmOp
+{
+	char Op;
+	char Arg;	/* number of vars of a function, or compare to do */
+	short VarType;
+	short IndexType;	/* -1 if the var is not indexed */
+	int Value;	/* constant, or offset of the var */
+	int IndexOffset;
+}StrArithmOp;
+
+/* a rung compiled by calc.c: the elements to refresh, in the same
+   order as RefreshRung( ) but with empty blocks left out */
+typedef struct StrRungOp
+{
+	unsigned char Op;	/* element type */
+	unsigned char Cell;	/* element refreshed, as x*RUNG_HEIGHT+y */
+	unsigned char LeftCell;	/* top of the column the inputs come from */
+	unsigned char Left[4];	/* for each input, rows of that column ORed together */
+	short VarType;	/* or number of compiled arithmetic ops (-1 if none) */
+	int VarNum;	/* or index in VarArray, or first compiled arithmetic op */
+}StrRungOp;
+
+typedef struct StrCompiledRung
+{
+	int FirstOp;
+	int NbrOps;	/* -1 if not compiled, RefreshRung( ) is used */
+}StrCompiledRung;
+
+/* room for the compiled rungs (one op per element at most) and the
+   compiled expressions, on average per expression (an expression that
+   doesn't fit is interpreted) */
+#define RUNG_OPS_PER_RUNG (RUNG_WIDTH*RUNG_HEIGHT)
+#define ARITHM_OPS_PER_EXPR (ARITHM_EXPR_SIZE/2)
+#define NBR_RUNG_OPS (NBR_RUNGS*RUNG_OPS_PER_RUNG)
+#define NBR_ARITHM_OPS (NBR_ARITHM_EXPR*ARITHM_OPS_PER_EXPR)
+/* all of it is there twice: the scans use the bank */
+/* InfosGene->CompiledBank while the editor compiles in the other */
+#define NBR_COMPILED_BANKS 2
+
 #define DEVICE_TYPE_DIRECT_ACCESS 0	/* used inb( ) and outb( ) calls */
 #define DEVICE_TYPE_COMEDI 100	/* /dev/comedi0 and following */
 
@@ -313,6 +353,8 @@ typedef struct StrInfosGene
 	int UnderCalculationPleaseWait;
 	int LadderStoppedToRunBack;
 	char CmdRefreshVarsBits;
+	/* bank of the compiled rungs used by the scans (see calc.c) */
+	int CompiledBank;
 	
 	int BlockWidth;
 	int BlockHeight;
@@ -413,6 +455,7 @@ typedef struct StrSymbol
 
 void ClassicLadderEndOfAppli( void );
 void DoPauseMilliSecs( int Time );
+void WaitEndOfScan( void );
 void StopRunIfRunning( void );
 void RunBackIfStopped( void );
 
@@ -440,5 +483,6 @@ void UpdateSizesOfConvVarNameTable( void );
 extern int compId;
 #endif
 extern int nogui;
+extern int nocompile;
 extern int modmaster;
 extern int modslave;
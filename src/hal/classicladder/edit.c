@@ -827,6 +827,7 @@ void DeleteCurrentRung()
 				}
 			}
 		}
+		CompileAllRungs( );
 	}
 }
 
@@ -846,6 +847,9 @@ void ApplyRungEdited()
 	int PrevNew;
 	int NextNew;
 	save_label_comment_edited();
+	/* the scans must not run the ops compiled from the old rung on the */
+	/* new one: they interpret it until it is compiled again below */
+	UncompileRung( EditDatas.NumRung );
 	CopyRungToRung(&EditDatas.Rung,&RungArray[EditDatas.NumRung]);
 	ApplyNewArithmExpr();
 
@@ -911,6 +915,7 @@ void ApplyRungEdited()
 	DrawRungs();
 	autorize_prevnext_buttons(TRUE);
 	InfosGene->AskConfirmationToQuit = TRUE;
+	CompileAllRungs( );
 }
 
 
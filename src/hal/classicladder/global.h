@@ -40,6 +40,9 @@ extern StrSequential *Sequential;
 extern StrSequential EditSeqDatas;
 #endif
 extern StrSymbol * SymbolArray;
+extern StrCompiledRung * CompiledRungArray;
+extern StrRungOp * RungOpArray;
+extern StrArithmOp * ArithmOpArray;
 
 extern StrEditRung EditDatas;
 extern StrArithmExpr * EditArithmExpr;
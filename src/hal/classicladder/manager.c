@@ -31,6 +31,7 @@
 #include "global.h"
 #include "edit.h"
 #include "manager.h"
+#include "calc.h"
 
 void InitSections( void )
 {
@@ -190,6 +191,8 @@ int AddSection( char * NewSectionName, int TypeLanguageSection, int SubRoutineNb
 			}
 		}
 #endif
+		if ( FreeFound )
+			CompileAllRungs( );
 	}
 	return FreeFound;
 }
@@ -244,6 +247,7 @@ void DelSection( char * SectionNameToErase )
 			}
 			RungArray[ InfosGene->LastRung ].Used = FALSE;
 		}
+		CompileAllRungs( );
 	}
 }
 
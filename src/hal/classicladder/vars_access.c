@@ -123,6 +123,28 @@ int ReadVar(int TypeVar,int Offset)
 	return 0;
 }
 
+/* Index in VarArray of a boolean var, as read by ReadVar( ), */
+/* or -1 if the var is not stored there */
+int VarArrayIndex(int TypeVar,int Offset)
+{
+	switch(TypeVar)
+	{
+		case VAR_MEM_BIT:
+			return Offset;
+		case VAR_ERROR_BIT:
+			return NBR_STEPS+NBR_BITS+NBR_PHYS_INPUTS+NBR_PHYS_OUTPUTS+Offset;
+#ifdef SEQUENTIAL_SUPPORT
+		case VAR_STEP_ACTIVITY:
+			return NBR_BITS+NBR_PHYS_INPUTS+NBR_PHYS_OUTPUTS+Offset;
+#endif
+		case VAR_PHYS_INPUT:
+			return NBR_BITS+Offset;
+		case VAR_PHYS_OUTPUT:
+			return NBR_BITS+NBR_PHYS_INPUTS+Offset;
+	}
+	return -1;
+}
+
 void WriteVar(int TypeVar,int NumVar,int Value)
 {
 	switch(TypeVar)
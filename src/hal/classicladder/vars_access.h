@@ -16,6 +16,7 @@
 void InitVars(void);
 int ReadVar(int TypeVar,int Offset);
 void WriteVar(int TypeVar,int NumVar,int Value);
+int VarArrayIndex(int TypeVar,int Offset);
 
 /* these are only useful for the MAT-connected version */
 void DoneVars(void);
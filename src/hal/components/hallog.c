@@ -0,0 +1,557 @@
+/********************************************************************
+* Description:  hallog.c
+*               Reader and writer for the compressed column format
+*               used by the HAL data logger.  See hallog.h.
+*
+* License: GPL Version 2
+*
+********************************************************************/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "hallog.h"
+
+/* worst case encoded size of one value: a 10 byte varint */
+#define MAX_VALUE_BYTES	10
+
+struct hallog_writer {
+    FILE *fp;
+    int ncols;
+    hal_type_t types[HALLOG_MAX_COLS];
+    int rows;
+    long long size;
+    unsigned long long sample[HALLOG_BLOCK_ROWS];
+    long long time[HALLOG_BLOCK_ROWS];
+    union hal_stream_data *values;
+    unsigned char *buf;
+};
+
+struct hallog_reader {
+    FILE *fp;
+    int ncols;
+    hal_type_t types[HALLOG_MAX_COLS];
+    char *names[HALLOG_MAX_COLS];
+    hallog_block_t block;
+    unsigned char *buf;
+    size_t bufsize;
+};
+
+/***********************************************************************
+*                       PRIMITIVE ENCODERS                             *
+************************************************************************/
+
+static unsigned char *put_u32(unsigned char *p, rtapi_u32 v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+    return p + 4;
+}
+
+static unsigned char *put_u64(unsigned char *p, rtapi_u64 v)
+{
+    p = put_u32(p, (rtapi_u32)v);
+    return put_u32(p, (rtapi_u32)(v >> 32));
+}
+
+static rtapi_u32 get_u32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((rtapi_u32)p[3] << 24);
+}
+
+static rtapi_u64 get_u64(const unsigned char *p)
+{
+    return get_u32(p) | ((rtapi_u64)get_u32(p + 4) << 32);
+}
+
+static unsigned char *put_varint(unsigned char *p, rtapi_u64 v)
+{
+    while (v >= 0x80) {
+	*p++ = (v & 0x7f) | 0x80;
+	v >>= 7;
+    }
+    *p++ = v;
+    return p;
+}
+
+static unsigned char *put_zigzag(unsigned char *p, rtapi_s64 v)
+{
+    return put_varint(p, ((rtapi_u64)v << 1) ^ (rtapi_u64)(v >> 63));
+}
+
+/* returns 0 and advances *pp, or -1 if the varint runs past end */
+static int get_varint(const unsigned char **pp, const unsigned char *end,
+    rtapi_u64 *v)
+{
+    const unsigned char *p = *pp;
+    rtapi_u64 r = 0;
+    int shift;
+
+    for (shift = 0; shift < 64; shift += 7) {
+	if (p >= end) {
+	    return -1;
+	}
+	r |= (rtapi_u64)(*p & 0x7f) << shift;
+	if (!(*p++ & 0x80)) {
+	    *pp = p;
+	    *v = r;
+	    return 0;
+	}
+    }
+    return -1;
+}
+
+static int get_zigzag(const unsigned char **pp, const unsigned char *end,
+    rtapi_s64 *v)
+{
+    rtapi_u64 u;
+
+    if (get_varint(pp, end, &u) < 0) {
+	return -1;
+    }
+    *v = (rtapi_s64)(u >> 1) ^ -(rtapi_s64)(u & 1);
+    return 0;
+}
+
+static rtapi_u64 float_bits(real_t f)
+{
+    rtapi_u64 u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static real_t bits_float(rtapi_u64 u)
+{
+    real_t f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+/***********************************************************************
+*                              WRITER                                  *
+************************************************************************/
+
+hallog_writer_t *hallog_writer_open(const char *path, int ncols,
+    char **names, const hal_type_t *types)
+{
+    hallog_writer_t *w;
+    unsigned char hdr[16];
+    int n;
+
+    if (ncols < 0 || ncols > HALLOG_MAX_COLS) {
+	errno = EINVAL;
+	return NULL;
+    }
+    w = calloc(1, sizeof(*w));
+    if (!w) {
+	return NULL;
+    }
+    w->ncols = ncols;
+    memcpy(w->types, types, ncols * sizeof(*types));
+    w->values = calloc(HALLOG_BLOCK_ROWS * (ncols ? ncols : 1),
+	sizeof(*w->values));
+    w->buf = malloc((size_t)HALLOG_BLOCK_ROWS * (ncols + 2) * MAX_VALUE_BYTES
+	+ 4 * (ncols + 2));
+    w->fp = fopen(path, "wb");
+    if (!w->values || !w->buf || !w->fp) {
+	int e = errno;
+	if (w->fp) fclose(w->fp);
+	free(w->values);
+	free(w->buf);
+	free(w);
+	errno = e;
+	return NULL;
+    }
+    memcpy(hdr, HALLOG_MAGIC, 8);
+    put_u32(hdr + 8, HALLOG_VERSION);
+    put_u32(hdr + 12, ncols);
+    fwrite(hdr, 1, sizeof(hdr), w->fp);
+    w->size = sizeof(hdr);
+    for (n = 0; n < ncols; n++) {
+	size_t len = strlen(names[n]);
+	if (len > 255) {
+	    len = 255;
+	}
+	fputc(types[n], w->fp);
+	fputc(len, w->fp);
+	fwrite(names[n], 1, len, w->fp);
+	w->size += 2 + len;
+    }
+    if (fflush(w->fp) != 0) {
+	int e = errno;
+	hallog_writer_close(w);
+	errno = e;
+	return NULL;
+    }
+    return w;
+}
+
+int hallog_write(hallog_writer_t *w, unsigned long long sample,
+    long long time, const union hal_stream_data *values)
+{
+    w->sample[w->rows] = sample;
+    w->time[w->rows] = time;
+    memcpy(w->values + w->rows * w->ncols, values,
+	w->ncols * sizeof(*values));
+    if (++w->rows == HALLOG_BLOCK_ROWS) {
+	return hallog_writer_flush(w);
+    }
+    return 0;
+}
+
+/* encodes column 'col' of the buffered rows at p, returns the end */
+static unsigned char *encode_column(hallog_writer_t *w, int col,
+    unsigned char *p)
+{
+    const union hal_stream_data *v = w->values + col;
+    int ncols = w->ncols, rows = w->rows, i;
+    rtapi_s64 prev = 0;
+    rtapi_u64 prevf = 0;
+    unsigned char bits = 0;
+
+    switch (w->types[col]) {
+    case HAL_BIT:
+	for (i = 0; i < rows; i++, v += ncols) {
+	    if (v->b) {
+		bits |= 1 << (i & 7);
+	    }
+	    if ((i & 7) == 7) {
+		*p++ = bits;
+		bits = 0;
+	    }
+	}
+	if (rows & 7) {
+	    *p++ = bits;
+	}
+	break;
+    case HAL_S32:
+	for (i = 0; i < rows; i++, v += ncols) {
+	    p = put_zigzag(p, v->s - prev);
+	    prev = v->s;
+	}
+	break;
+    case HAL_U32:
+	for (i = 0; i < rows; i++, v += ncols) {
+	    p = put_zigzag(p, (rtapi_s64)v->u - prev);
+	    prev = v->u;
+	}
+	break;
+    case HAL_FLOAT:
+	for (i = 0; i < rows; i++, v += ncols) {
+	    rtapi_u64 cur = float_bits(v->f), x = cur ^ prevf;
+	    int lead, trail, n;
+	    prevf = cur;
+	    if (x == 0) {
+		*p++ = 0;
+		continue;
+	    }
+	    lead = __builtin_clzll(x) / 8;
+	    trail = __builtin_ctzll(x) / 8;
+	    n = 8 - lead - trail;
+	    *p++ = (trail << 4) | n;
+	    x >>= trail * 8;
+	    while (n--) {
+		*p++ = x;
+		x >>= 8;
+	    }
+	}
+	break;
+    default:
+	break;
+    }
+    return p;
+}
+
+int hallog_writer_flush(hallog_writer_t *w)
+{
+    unsigned char hdr[28], *p, *len;
+    rtapi_s64 dt, prev_dt = 0;
+    int i, col;
+
+    if (w->rows == 0) {
+	return 0;
+    }
+    p = w->buf;
+    /* sample numbers */
+    len = p;
+    p += 4;
+    for (i = 1; i < w->rows; i++) {
+	p = put_varint(p, w->sample[i] - w->sample[i - 1]);
+    }
+    put_u32(len, p - len - 4);
+    /* timestamps */
+    len = p;
+    p += 4;
+    for (i = 1; i < w->rows; i++) {
+	dt = w->time[i] - w->time[i - 1];
+	p = put_zigzag(p, dt - prev_dt);
+	prev_dt = dt;
+    }
+    put_u32(len, p - len - 4);
+    /* logged pins */
+    for (col = 0; col < w->ncols; col++) {
+	len = p;
+	p = encode_column(w, col, p + 4);
+	put_u32(len, p - len - 4);
+    }
+    put_u32(hdr, HALLOG_BLOCK_MAGIC);
+    put_u32(hdr + 4, w->rows);
+    put_u32(hdr + 8, p - w->buf);
+    put_u64(hdr + 12, w->sample[0]);
+    put_u64(hdr + 20, w->time[0]);
+    w->rows = 0;
+    if (fwrite(hdr, 1, sizeof(hdr), w->fp) != sizeof(hdr) ||
+	fwrite(w->buf, 1, p - w->buf, w->fp) != (size_t)(p - w->buf) ||
+	fflush(w->fp) != 0) {
+	return errno ? -errno : -EIO;
+    }
+    w->size += sizeof(hdr) + (p - w->buf);
+    return 0;
+}
+
+long long hallog_writer_size(hallog_writer_t *w)
+{
+    return w->size;
+}
+
+int hallog_writer_close(hallog_writer_t *w)
+{
+    int retval = hallog_writer_flush(w);
+
+    if (fclose(w->fp) != 0 && retval == 0) {
+	retval = -errno;
+    }
+    free(w->values);
+    free(w->buf);
+    free(w);
+    return retval;
+}
+
+/***********************************************************************
+*                              READER                                  *
+************************************************************************/
+
+hallog_reader_t *hallog_reader_open(const char *path)
+{
+    hallog_reader_t *r;
+    unsigned char hdr[16];
+    int n, c;
+
+    r = calloc(1, sizeof(*r));
+    if (!r) {
+	return NULL;
+    }
+    r->fp = fopen(path, "rb");
+    if (!r->fp) {
+	free(r);
+	return NULL;
+    }
+    if (fread(hdr, 1, sizeof(hdr), r->fp) != sizeof(hdr) ||
+	memcmp(hdr, HALLOG_MAGIC, 8) != 0 ||
+	get_u32(hdr + 8) != HALLOG_VERSION ||
+	get_u32(hdr + 12) > HALLOG_MAX_COLS) {
+	goto bad;
+    }
+    r->ncols = get_u32(hdr + 12);
+    for (n = 0; n < r->ncols; n++) {
+	int len;
+	if ((c = fgetc(r->fp)) == EOF) {
+	    goto bad;
+	}
+	r->types[n] = c;
+	if (c != HAL_BIT && c != HAL_FLOAT && c != HAL_S32 && c != HAL_U32) {
+	    goto bad;
+	}
+	if ((len = fgetc(r->fp)) == EOF) {
+	    goto bad;
+	}
+	r->names[n] = calloc(1, len + 1);
+	if (!r->names[n] ||
+	    fread(r->names[n], 1, len, r->fp) != (size_t)len) {
+	    goto bad;
+	}
+    }
+    r->block.sample = malloc(HALLOG_BLOCK_ROWS * sizeof(*r->block.sample));
+    r->block.time = malloc(HALLOG_BLOCK_ROWS * sizeof(*r->block.time));
+    r->block.values = malloc(HALLOG_BLOCK_ROWS * (r->ncols ? r->ncols : 1)
+	* sizeof(*r->block.values));
+    if (!r->block.sample || !r->block.time || !r->block.values) {
+	hallog_reader_close(r);
+	return NULL;
+    }
+    return r;
+bad:
+    hallog_reader_close(r);
+    errno = EINVAL;
+    return NULL;
+}
+
+int hallog_reader_columns(hallog_reader_t *r)
+{
+    return r->ncols;
+}
+
+const char *hallog_reader_name(hallog_reader_t *r, int col)
+{
+    return r->names[col];
+}
+
+hal_type_t hallog_reader_type(hallog_reader_t *r, int col)
+{
+    return r->types[col];
+}
+
+/* decodes one column of 'rows' values from [p, end) */
+static int decode_column(hallog_reader_t *r, int col, int rows,
+    const unsigned char *p, const unsigned char *end)
+{
+    union hal_stream_data *v = r->block.values + col;
+    int ncols = r->ncols, i;
+    rtapi_s64 d, prev = 0;
+    rtapi_u64 prevf = 0;
+
+    switch (r->types[col]) {
+    case HAL_BIT:
+	if (end - p < (rows + 7) / 8) {
+	    return -1;
+	}
+	for (i = 0; i < rows; i++, v += ncols) {
+	    v->b = (p[i >> 3] >> (i & 7)) & 1;
+	}
+	break;
+    case HAL_S32:
+    case HAL_U32:
+	for (i = 0; i < rows; i++, v += ncols) {
+	    if (get_zigzag(&p, end, &d) < 0) {
+		return -1;
+	    }
+	    prev += d;
+	    if (r->types[col] == HAL_S32) {
+		v->s = prev;
+	    } else {
+		v->u = prev;
+	    }
+	}
+	break;
+    case HAL_FLOAT:
+	for (i = 0; i < rows; i++, v += ncols) {
+	    rtapi_u64 x = 0;
+	    int trail, n, b;
+	    if (p >= end) {
+		return -1;
+	    }
+	    trail = *p >> 4;
+	    n = *p++ & 0x0f;
+	    if (n > 8 || trail + n > 8 || end - p < n) {
+		return -1;
+	    }
+	    for (b = 0; b < n; b++) {
+		x |= (rtapi_u64)*p++ << (8 * b);
+	    }
+	    prevf ^= x << (8 * trail);
+	    v->f = bits_float(prevf);
+	}
+	break;
+    default:
+	return -1;
+    }
+    return 0;
+}
+
+int hallog_read_block(hallog_reader_t *r, hallog_block_t **blk)
+{
+    unsigned char hdr[28];
+    const unsigned char *p, *end, *col_end;
+    rtapi_u32 rows, payload, len;
+    rtapi_u64 d;
+    rtapi_s64 dd, dt = 0;
+    int i, col;
+
+    /* a short header or payload is a block cut off by a crash */
+    if (fread(hdr, 1, sizeof(hdr), r->fp) != sizeof(hdr)) {
+	return 0;
+    }
+    rows = get_u32(hdr + 4);
+    payload = get_u32(hdr + 8);
+    if (get_u32(hdr) != HALLOG_BLOCK_MAGIC || rows == 0 ||
+	rows > HALLOG_BLOCK_ROWS) {
+	return -EINVAL;
+    }
+    if (payload > r->bufsize) {
+	unsigned char *nb = realloc(r->buf, payload);
+	if (!nb) {
+	    return -ENOMEM;
+	}
+	r->buf = nb;
+	r->bufsize = payload;
+    }
+    if (fread(r->buf, 1, payload, r->fp) != payload) {
+	return 0;
+    }
+    p = r->buf;
+    end = r->buf + payload;
+    r->block.sample[0] = get_u64(hdr + 12);
+    r->block.time[0] = get_u64(hdr + 20);
+    for (col = -2; col < r->ncols; col++) {
+	if (end - p < 4 || (len = get_u32(p)) > (rtapi_u32)(end - p - 4)) {
+	    return -EINVAL;
+	}
+	p += 4;
+	col_end = p + len;
+	if (col == -2) {
+	    for (i = 1; i < (int)rows; i++) {
+		if (get_varint(&p, col_end, &d) < 0) {
+		    return -EINVAL;
+		}
+		r->block.sample[i] = r->block.sample[i - 1] + d;
+	    }
+	} else if (col == -1) {
+	    for (i = 1; i < (int)rows; i++) {
+		if (get_zigzag(&p, col_end, &dd) < 0) {
+		    return -EINVAL;
+		}
+		dt += dd;
+		r->block.time[i] = r->block.time[i - 1] + dt;
+	    }
+	} else if (decode_column(r, col, rows, p, col_end) < 0) {
+	    return -EINVAL;
+	}
+	p = col_end;
+    }
+    r->block.rows = rows;
+    *blk = &r->block;
+    return rows;
+}
+
+void hallog_reader_close(hallog_reader_t *r)
+{
+    int n;
+
+    if (r->fp) {
+	fclose(r->fp);
+    }
+    for (n = 0; n < HALLOG_MAX_COLS; n++) {
+	free(r->names[n]);
+    }
+    free(r->block.sample);
+    free(r->block.time);
+    free(r->block.values);
+    free(r->buf);
+    free(r);
+}
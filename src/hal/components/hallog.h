@@ -0,0 +1,78 @@
+/********************************************************************
+* Description:  hallog.h
+*               File format and reader/writer library for the HAL
+*               data logger ('logger', 'hallogger', 'hallogdump').
+*
+* License: GPL Version 2
+*
+********************************************************************/
+#ifndef HALLOG_H
+#define HALLOG_H
+
+/** A log file starts with a header naming every logged column and its
+    HAL type, followed by any number of blocks of up to
+    HALLOG_BLOCK_ROWS records.  All integers are little endian.
+
+    header:  "HALLOG1\n"  u32 version  u32 ncols
+             ncols * { u8 type  u8 namelen  char name[namelen] }
+
+    block:   u32 HALLOG_BLOCK_MAGIC  u32 rows  u32 payload_len
+             u64 first sample number  s64 first timestamp (ns)
+             (ncols + 2) * { u32 len  u8 data[len] }
+
+    Inside a block the data is stored one column after the other, the
+    sample numbers first, then the timestamps, then the logged pins:
+
+    sample   varint of the difference to the previous sample number;
+             anything but 1 means records were lost in between
+    time     zigzag varint of the change in the sample interval, which
+             is 0 for most records of a periodic thread
+    bit      packed eight records to a byte
+    s32/u32  zigzag varint of the difference to the previous value
+    float    the value XORed with the previous one; a control byte
+             holds the number of trailing zero bytes (high nibble) and
+             of significant bytes (low nibble) of the result, 0 means
+             the value did not change
+
+    A file cut short by a crash loses at most its last block.
+*/
+
+#include <stdio.h>
+#include "hal.h"
+
+#define HALLOG_MAGIC		"HALLOG1\n"
+#define HALLOG_VERSION		1
+#define HALLOG_BLOCK_MAGIC	0x4b4c4248	/* "HBLK" */
+#define HALLOG_BLOCK_ROWS	4096
+#define HALLOG_MAX_COLS		HAL_STREAM_MAX_PINS
+
+typedef struct hallog_writer hallog_writer_t;
+typedef struct hallog_reader hallog_reader_t;
+
+/* one decoded block; values holds rows * ncols entries, row by row */
+typedef struct {
+    int rows;
+    unsigned long long *sample;
+    long long *time;
+    union hal_stream_data *values;
+} hallog_block_t;
+
+/* all functions returning int return a negative errno on failure */
+
+extern hallog_writer_t *hallog_writer_open(const char *path, int ncols,
+    char **names, const hal_type_t *types);
+extern int hallog_write(hallog_writer_t *w, unsigned long long sample,
+    long long time, const union hal_stream_data *values);
+extern int hallog_writer_flush(hallog_writer_t *w);
+extern long long hallog_writer_size(hallog_writer_t *w);
+extern int hallog_writer_close(hallog_writer_t *w);
+
+extern hallog_reader_t *hallog_reader_open(const char *path);
+extern int hallog_reader_columns(hallog_reader_t *r);
+extern const char *hallog_reader_name(hallog_reader_t *r, int col);
+extern hal_type_t hallog_reader_type(hallog_reader_t *r, int col);
+/* returns the number of rows decoded into *blk, 0 at end of file */
+extern int hallog_read_block(hallog_reader_t *r, hallog_block_t **blk);
+extern void hallog_reader_close(hallog_reader_t *r);
+
+#endif
@@ -0,0 +1,311 @@
+/********************************************************************
+* Description:  logger.c
+*               A HAL component that captures a set of HAL pins once
+*               per thread period, together with an RTAPI timestamp,
+*               so that 'hallogger' can record them to a file.
+*
+* License: GPL Version 2
+*
+********************************************************************/
+/** This file, 'logger.c', is the realtime part of a HAL data logger.
+    It works like 'sampler', but every record written to the stream
+    also carries the value of rtapi_get_time() at the moment the pins
+    were read.  The user space program 'hallogger' drains the stream
+    and writes the records to a compressed file (see hallog.h), and
+    'hallogdump' turns ranges of that file back into CSV.
+
+    Loading:
+
+    loadrt logger depth=4096 cfg=uffb
+
+    The first two elements of the stream hold the low and high 32
+    bits of the timestamp, so at most HAL_STREAM_MAX_PINS - 2 pins
+    can be logged by one channel.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include "rtapi.h"              /* RTAPI realtime OS API */
+#include "rtapi_app.h"          /* RTAPI realtime module decls */
+#include "hal.h"                /* HAL public API decls */
+#include "streamer.h"		/* decls and such for fifos */
+#include "rtapi_errno.h"
+#include "rtapi_string.h"
+
+/* module information */
+MODULE_DESCRIPTION("Realtime HAL Data Logger");
+MODULE_LICENSE("GPL");
+static char *cfg[MAX_LOGGERS];	/* config string, no default */
+RTAPI_MP_ARRAY_STRING(cfg,MAX_LOGGERS,"config string");
+static int depth[MAX_LOGGERS];	/* depth of fifo, default 0 */
+RTAPI_MP_ARRAY_INT(depth,MAX_LOGGERS,"fifo depth");
+
+/* stream elements ahead of the user pins: timestamp low, high, and the
+   record number, which counts lost records too */
+#define LOGGER_META_ELEMENTS	3
+
+/***********************************************************************
+*                STRUCTURES AND GLOBAL VARIABLES                       *
+************************************************************************/
+
+/* this structure contains the HAL shared memory data for one logger */
+
+typedef struct {
+    hal_stream_t fifo;		/* pointer to user/RT fifo */
+    hal_s32_t *curr_depth;	/* pin: current fifo depth */
+    hal_bit_t *full;		/* pin: overrun flag */
+    hal_bit_t *enable;		/* pin: enable logging */
+    hal_s32_t *overruns;	/* pin: number of records lost */
+    rtapi_u32 record;		/* number of the last record, written or not */
+    int num_pins;
+    pin_data_t pins[HAL_STREAM_MAX_PINS - LOGGER_META_ELEMENTS];
+} logger_t;
+
+/* other globals */
+static int comp_id;		/* component ID */
+static int nloggers;
+static logger_t *loggers;
+
+/***********************************************************************
+*                  LOCAL FUNCTION DECLARATIONS                         *
+************************************************************************/
+
+static int init_logger(int num, logger_t *log);
+static void log_pins(void *arg, long period);
+
+/***********************************************************************
+*                       INIT AND EXIT CODE                             *
+************************************************************************/
+
+int rtapi_app_main(void)
+{
+    int n, retval;
+    char types[HAL_STREAM_MAX_PINS + 1];
+
+    comp_id = hal_init("logger");
+    if (comp_id < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "LOGGER: ERROR: hal_init() failed\n");
+	return -EINVAL;
+    }
+
+    loggers = hal_malloc(MAX_LOGGERS * sizeof(logger_t));
+    if (loggers == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "LOGGER: ERROR: hal_malloc() failed\n");
+	hal_exit(comp_id);
+	return -ENOMEM;
+    }
+    /* validate config info */
+    for ( n = 0 ; n < MAX_LOGGERS ; n++ ) {
+	if (( cfg[n] == NULL ) || ( *cfg[n] == '\0' ) || ( depth[n] <= 0 )) {
+	    break;
+	}
+	if (strlen(cfg[n]) > HAL_STREAM_MAX_PINS - LOGGER_META_ELEMENTS) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"LOGGER: ERROR: config string '%s' has more than %d pins\n",
+		cfg[n], HAL_STREAM_MAX_PINS - LOGGER_META_ELEMENTS);
+	    retval = -EINVAL;
+	    goto fail;
+	}
+	rtapi_snprintf(types, sizeof(types), "uuu%s", cfg[n]);
+	retval = hal_stream_create(&loggers[n].fifo, comp_id,
+	    LOGGER_SHMEM_KEY+n, depth[n], types);
+	if(retval < 0) {
+	    goto fail;
+	}
+	nloggers++;
+	retval = init_logger(n, &loggers[n]);
+	if(retval < 0) {
+	    goto fail;
+	}
+    }
+    if ( n == 0 ) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "LOGGER: ERROR: no channels specified\n");
+	hal_exit(comp_id);
+	return -EINVAL;
+    }
+
+    hal_ready(comp_id);
+    return 0;
+fail:
+    for(n=0; n<nloggers; n++) hal_stream_detach(&loggers[n].fifo);
+    hal_exit(comp_id);
+    return retval;
+}
+
+void rtapi_app_exit(void)
+{
+    int i;
+    for(i=0; i<nloggers; i++) hal_stream_detach(&loggers[i].fifo);
+    hal_exit(comp_id);
+}
+
+/***********************************************************************
+*                       REALTIME LOGGING FUNCTION                      *
+************************************************************************/
+
+static void log_pins(void *arg, long period)
+{
+    logger_t *log;
+    pin_data_t *pptr;
+    union hal_stream_data data[HAL_STREAM_MAX_PINS], *dptr;
+    long long now;
+    int n;
+
+    log = arg;
+    if ( ! *(log->enable) ) {
+	*(log->curr_depth) = hal_stream_depth(&log->fifo);
+	*(log->full) = !hal_stream_writable(&log->fifo);
+	return;
+    }
+    /* timestamp first, so it is as close to the pin reads as possible */
+    now = rtapi_get_time();
+    data[0].u = (rtapi_u32)now;
+    data[1].u = (rtapi_u32)((unsigned long long)now >> 32);
+    data[2].u = ++log->record;
+    pptr = log->pins;
+    dptr = data + LOGGER_META_ELEMENTS;
+    for ( n = 0 ; n < log->num_pins ; n++ ) {
+	switch ( hal_stream_element_type(&log->fifo,
+		    n + LOGGER_META_ELEMENTS) ) {
+	case HAL_FLOAT:
+	    dptr->f = *(pptr->hfloat);
+	    break;
+	case HAL_BIT:
+	    dptr->b = *(pptr->hbit) ? 1 : 0;
+	    break;
+	case HAL_U32:
+	    dptr->u = *(pptr->hu32);
+	    break;
+	case HAL_S32:
+	    dptr->s = *(pptr->hs32);
+	    break;
+	default:
+	    break;
+	}
+	dptr++;
+	pptr++;
+    }
+    if ( hal_stream_write(&log->fifo, data) < 0) {
+	/* fifo is full, the record is lost; the reader sees the gap
+	   in the record numbers, this pin makes it visible in HAL */
+	(*log->overruns)++;
+	*(log->full) = 1;
+	*(log->curr_depth) = hal_stream_maxdepth(&log->fifo);
+    } else {
+	*(log->full) = 0;
+	*(log->curr_depth) = hal_stream_depth(&log->fifo);
+    }
+}
+
+/***********************************************************************
+*                   LOCAL FUNCTION DEFINITIONS                         *
+************************************************************************/
+
+static int init_logger(int num, logger_t *log)
+{
+    int retval, usefp, n;
+    pin_data_t *pptr;
+    hal_type_t type;
+    char buf[HAL_NAME_LEN + 1];
+
+    /* export "standard" pins */
+    retval = hal_pin_bit_newf(HAL_OUT, &(log->full), comp_id,
+	"logger.%d.full", num);
+    if (retval != 0 ) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "LOGGER: ERROR: 'full' pin export failed\n");
+	return -EIO;
+    }
+    retval = hal_pin_bit_newf(HAL_IN, &(log->enable), comp_id,
+	"logger.%d.enable", num);
+    if (retval != 0 ) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "LOGGER: ERROR: 'enable' pin export failed\n");
+	return -EIO;
+    }
+    retval = hal_pin_s32_newf(HAL_OUT, &(log->curr_depth), comp_id,
+	"logger.%d.curr-depth", num);
+    if (retval != 0 ) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "LOGGER: ERROR: 'curr-depth' pin export failed\n");
+	return -EIO;
+    }
+    retval = hal_pin_s32_newf(HAL_IO, &(log->overruns), comp_id,
+	"logger.%d.overruns", num);
+    if (retval != 0 ) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "LOGGER: ERROR: 'overruns' pin export failed\n");
+	return -EIO;
+    }
+    *(log->full) = 0;
+    *(log->enable) = 1;
+    *(log->curr_depth) = 0;
+    *(log->overruns) = 0;
+    log->num_pins = hal_stream_element_count(&log->fifo)
+	- LOGGER_META_ELEMENTS;
+    pptr = log->pins;
+    usefp = 0;
+    /* export user specified pins (the ones that are logged) */
+    for ( n = 0 ; n < log->num_pins ; n++ ) {
+	type = hal_stream_element_type(&log->fifo, n + LOGGER_META_ELEMENTS);
+	rtapi_snprintf(buf, sizeof(buf), "logger.%d.pin.%d", num, n);
+	retval = hal_pin_new(buf, type, HAL_IN, (void **)pptr, comp_id );
+	if (retval != 0 ) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"LOGGER: ERROR: pin '%s' export failed\n", buf);
+	    return -EIO;
+	}
+	switch ( type ) {
+	case HAL_FLOAT:
+	    *(pptr->hfloat) = 0.0;
+	    usefp = 1;
+	    break;
+	case HAL_BIT:
+	    *(pptr->hbit) = 0;
+	    break;
+	case HAL_U32:
+	    *(pptr->hu32) = 0;
+	    break;
+	case HAL_S32:
+	    *(pptr->hs32) = 0;
+	    break;
+	default:
+	    break;
+	}
+	pptr++;
+    }
+    /* export logging function */
+    rtapi_snprintf(buf, sizeof(buf), "logger.%d", num);
+    retval = hal_export_funct(buf, log_pins, log, usefp, 0, comp_id);
+    if (retval != 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "LOGGER: ERROR: function export failed\n");
+	return retval;
+    }
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+/********************************************************************
+* Description:  logger_dump.c
+*               Exports records from a 'hallogger' file as CSV.
+*
+* License: GPL Version 2
+*
+********************************************************************/
+/** 'hallogdump' reads a file written by 'hallogger' and prints a
+    range of its records as comma separated values, one line per
+    record, preceded by a line of column names.  The first two
+    columns are the sample number and the time in seconds since the
+    first record of the file.
+
+    Invoking:
+
+    hallogdump [-f first] [-l last] [-b begin] [-e end] [-g] filename
+
+    'first' and 'last' limit the output to a range of sample numbers,
+    'begin' and 'end' to a range of times (in seconds since the first
+    record).  '-g' prints a 'gap' line wherever records were lost.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"                /* HAL public API decls */
+#include "hallog.h"
+
+static void usage(void)
+{
+    fprintf(stderr,
+	"usage: hallogdump [-f first] [-l last] [-b begin] [-e end] [-g] "
+	"filename\n");
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long long first = 0, last = ~0ULL, prev = 0;
+    double begin = -1.0, end = -1.0, t;
+    long long t0 = 0;
+    int gaps = 0, have_t0 = 0, have_prev = 0;
+    int opt, ncols, rows, i, col;
+    char *cp;
+    hallog_reader_t *r;
+    hallog_block_t *blk;
+
+    while ((opt = getopt(argc, argv, "f:l:b:e:g")) != -1) {
+	switch (opt) {
+	case 'f':
+	    first = strtoull(optarg, &cp, 10);
+	    if (*cp) usage();
+	    break;
+	case 'l':
+	    last = strtoull(optarg, &cp, 10);
+	    if (*cp) usage();
+	    break;
+	case 'b':
+	    begin = strtod(optarg, &cp);
+	    if (*cp) usage();
+	    break;
+	case 'e':
+	    end = strtod(optarg, &cp);
+	    if (*cp) usage();
+	    break;
+	case 'g':
+	    gaps = 1;
+	    break;
+	default:
+	    usage();
+	}
+    }
+    if (optind != argc - 1) {
+	usage();
+    }
+    r = hallog_reader_open(argv[optind]);
+    if (!r) {
+	perror(argv[optind]);
+	return 1;
+    }
+    ncols = hallog_reader_columns(r);
+    printf("sample,time");
+    for (col = 0; col < ncols; col++) {
+	printf(",%s", hallog_reader_name(r, col));
+    }
+    printf("\n");
+    while ((rows = hallog_read_block(r, &blk)) > 0) {
+	if (!have_t0) {
+	    t0 = blk->time[0];
+	    have_t0 = 1;
+	}
+	for (i = 0; i < rows; i++) {
+	    union hal_stream_data *v = blk->values + i * ncols;
+	    unsigned long long s = blk->sample[i];
+	    t = (blk->time[i] - t0) * 1e-9;
+	    if (s < first || s > last || (begin >= 0 && t < begin)) {
+		continue;
+	    }
+	    if (end >= 0 && t > end) {
+		goto done;
+	    }
+	    if (gaps && have_prev && s != prev + 1) {
+		printf("gap,%llu\n", s - prev - 1);
+	    }
+	    prev = s;
+	    have_prev = 1;
+	    printf("%llu,%.9f", s, t);
+	    for (col = 0; col < ncols; col++) {
+		switch (hallog_reader_type(r, col)) {
+		case HAL_FLOAT:
+		    printf(",%.17g", v[col].f);
+		    break;
+		case HAL_BIT:
+		    printf(",%d", v[col].b ? 1 : 0);
+		    break;
+		case HAL_U32:
+		    printf(",%lu", (unsigned long)v[col].u);
+		    break;
+		case HAL_S32:
+		    printf(",%ld", (long)v[col].s);
+		    break;
+		default:
+		    break;
+		}
+	    }
+	    printf("\n");
+	}
+	if (blk->sample[rows - 1] > last) {
+	    break;
+	}
+    }
+done:
+    hallog_reader_close(r);
+    if (rows < 0) {
+	errno = -rows;
+	perror(argv[optind]);
+	return 1;
+    }
+    return 0;
+}
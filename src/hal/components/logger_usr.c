@@ -0,0 +1,352 @@
+/********************************************************************
+* Description:  logger_usr.c
+*               User space part of "logger", a HAL component that
+*		records timestamped HAL pin values to a compressed
+*		log file.
+*
+* License: GPL Version 2
+*
+********************************************************************/
+/** This file, 'logger_usr.c', is the user part of the HAL data
+    logger.  The realtime module 'logger' writes one record per
+    thread period to a stream in shared memory; 'hallogger' drains
+    that stream and stores the records in the block format described
+    in hallog.h.  Lost records show up as gaps in the sample numbers
+    of the file and in the logger.N.overruns pin.
+
+    Invoking:
+
+    hallogger [-c chan_num] [-n num_samples] [-m megabytes] filename
+
+    'chan_num', if present, specifies the logger channel to use.
+    The default is channel zero.
+
+    'num_samples', if present, specifies the number of records to
+    write, after which the program will exit.  If omitted it will
+    log continuously until killed.
+
+    'megabytes', if present, limits the size of the log file.  When
+    the file grows past the limit it is renamed to 'filename.1'
+    (replacing any older one) and a new file is started, so the last
+    one to two limits worth of data are always kept.
+
+    Each column of the file is named after the signal linked to the
+    logger pin, or after the pin itself if it is not linked.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"                /* HAL public API decls */
+#include "../hal_priv.h"	/* private HAL decls */
+#include "streamer.h"
+#include "hallog.h"
+
+/* stream elements ahead of the user pins: timestamp low, high and the
+   record number */
+#define LOGGER_META_ELEMENTS	3
+
+/* buffered records are written out at least this often */
+#define FLUSH_INTERVAL_NS	1000000000LL
+
+/* how long to sleep when the FIFO is empty; a FIFO must hold records
+   for much longer than this, or it overruns again after every drain */
+#define POLL_INTERVAL_US	1000
+
+/***********************************************************************
+*                         GLOBAL VARIABLES                             *
+************************************************************************/
+
+int comp_id = -1;	/* -1 means hal_init() not called yet */
+int exitval = 1;	/* program return code - 1 means error */
+int ignore_sig = 0;	/* used to flag critical regions */
+char comp_name[HAL_NAME_LEN+1];	/* name for this instance of logger */
+
+static int num_cols;
+static char *col_names[HALLOG_MAX_COLS];
+static hal_type_t col_types[HALLOG_MAX_COLS];
+
+/***********************************************************************
+*                            MAIN PROGRAM                              *
+************************************************************************/
+
+/* signal handler */
+static sig_atomic_t stop;
+static void quit(int sig)
+{
+    if ( ignore_sig ) {
+	return;
+    }
+    stop = 1;
+}
+
+static long long mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* names each column after the signal on logger.<channel>.pin.<n> */
+static int get_column_names(int channel, hal_stream_t *stream)
+{
+    char buf[HAL_NAME_LEN + 1];
+    hal_pin_t *pin;
+    hal_sig_t *sig;
+    const char *name;
+    int n;
+
+    num_cols = hal_stream_element_count(stream) - LOGGER_META_ELEMENTS;
+    rtapi_mutex_get(&(hal_data->mutex));
+    for ( n = 0 ; n < num_cols ; n++ ) {
+	col_types[n] = hal_stream_element_type(stream,
+	    n + LOGGER_META_ELEMENTS);
+	snprintf(buf, sizeof(buf), "logger.%d.pin.%d", channel, n);
+	name = buf;
+	pin = halpr_find_pin_by_name(buf);
+	if ( pin && pin->signal != 0 ) {
+	    sig = SHMPTR(pin->signal);
+	    name = sig->name;
+	}
+	col_names[n] = strdup(name);
+	if ( !col_names[n] ) {
+	    rtapi_mutex_give(&(hal_data->mutex));
+	    return -ENOMEM;
+	}
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    return 0;
+}
+
+static hallog_writer_t *rotate(hallog_writer_t *w, const char *path)
+{
+    char old[4096];
+    int res;
+
+    res = hallog_writer_close(w);
+    if ( res < 0 ) {
+	errno = -res;
+	perror(path);
+	return NULL;
+    }
+    snprintf(old, sizeof(old), "%s.1", path);
+    if ( rename(path, old) < 0 ) {
+	perror(old);
+	return NULL;
+    }
+    w = hallog_writer_open(path, num_cols, col_names, col_types);
+    if ( !w ) {
+	perror(path);
+    }
+    return w;
+}
+
+int main(int argc, char **argv)
+{
+    int n, channel, res;
+    long int samples;
+    long long max_size, last_flush;
+    rtapi_u32 record, last_record = 0;
+    int have_last = 0;
+    unsigned long long sample = 0, lost = 0;
+    char *cp, *cp2, *path;
+    hal_stream_t stream;
+    hallog_writer_t *w = NULL;
+
+    /* set return code to "fail", clear it later if all goes well */
+    exitval = 1;
+    stream.shmem_id = -1;
+    channel = 0;
+    samples = -1;  /* -1 means run forever */
+    max_size = 0;  /* 0 means no limit */
+    for ( n = 1 ; n < argc ; n++ ) {
+	cp = argv[n];
+	if ( *cp != '-' ) {
+	    break;
+	}
+	switch ( *(++cp) ) {
+	case 'c':
+	    if (( *(++cp) == '\0' ) && ( ++n < argc )) {
+		cp = argv[n];
+	    }
+	    channel = strtol(cp, &cp2, 10);
+	    if (( *cp2 ) || ( channel < 0 ) || ( channel >= MAX_LOGGERS )) {
+		fprintf(stderr,"ERROR: invalid channel number '%s'\n", cp );
+		exit(1);
+	    }
+	    break;
+	case 'n':
+	    if (( *(++cp) == '\0' ) && ( ++n < argc )) {
+		cp = argv[n];
+	    }
+	    samples = strtol(cp, &cp2, 10);
+	    if (( *cp2 ) || ( samples < 0 )) {
+		fprintf(stderr, "ERROR: invalid sample count '%s'\n", cp );
+		exit(1);
+	    }
+	    break;
+	case 'm':
+	    if (( *(++cp) == '\0' ) && ( ++n < argc )) {
+		cp = argv[n];
+	    }
+	    max_size = strtol(cp, &cp2, 10);
+	    if (( *cp2 ) || ( max_size <= 0 )) {
+		fprintf(stderr, "ERROR: invalid size limit '%s'\n", cp );
+		exit(1);
+	    }
+	    max_size *= 1024 * 1024;
+	    break;
+	default:
+	    fprintf(stderr,"ERROR: unknown option '%s'\n", cp );
+	    exit(1);
+	    break;
+	}
+    }
+    if ( n != argc - 1 ) {
+	fprintf(stderr, "ERROR: exactly one filename must be specified\n");
+	exit(1);
+    }
+    path = argv[n];
+    /* register signal handlers - if the process is killed
+       we need to call hal_exit() to free the shared memory */
+    signal(SIGINT, quit);
+    signal(SIGTERM, quit);
+    signal(SIGPIPE, quit);
+    /* create a unique module name, to allow for multiple loggers */
+    snprintf(comp_name, sizeof(comp_name), "hallogger%d", getpid());
+    /* connect to the HAL */
+    ignore_sig = 1;
+    comp_id = hal_init(comp_name);
+    ignore_sig = 0;
+    /* check result */
+    if (comp_id < 0) {
+	fprintf(stderr, "ERROR: hal_init() failed: %d\n", comp_id );
+	goto out;
+    }
+    hal_ready(comp_id);
+    res = hal_stream_attach(&stream, comp_id, LOGGER_SHMEM_KEY+channel, 0);
+    if (res < 0) {
+	errno = -res;
+	perror("hal_stream_attach");
+	goto out;
+    }
+    res = get_column_names(channel, &stream);
+    if (res < 0) {
+	errno = -res;
+	perror("hallogger");
+	goto out;
+    }
+    w = hallog_writer_open(path, num_cols, col_names, col_types);
+    if ( !w ) {
+	perror(path);
+	goto out;
+    }
+    last_flush = mono_ns();
+    while ( samples != 0 ) {
+	union hal_stream_data buf[num_cols + LOGGER_META_ELEMENTS];
+	long long stamp;
+	res = 0;
+	/* like hal_stream_wait_readable(), but buffered records still
+	   reach the file when the logger is disabled or its thread stops */
+	while ( !hal_stream_readable(&stream) && !stop && res == 0 ) {
+	    if ( mono_ns() - last_flush >= FLUSH_INTERVAL_NS ) {
+		res = hallog_writer_flush(w);
+		last_flush = mono_ns();
+	    }
+	    usleep(POLL_INTERVAL_US);
+	}
+	if(stop) break;
+	if ( res == 0 ) {
+	    res = hal_stream_read(&stream, buf, NULL);
+	    if (res < 0) {
+		errno = -res;
+		perror("hal_stream_read");
+		goto out;
+	    }
+	    /* the logger numbers every record, written or lost; extend
+	       the 32 bit number so gaps survive wraparound */
+	    record = buf[2].u;
+	    if ( have_last && record - last_record != 1 ) {
+		lost += record - last_record - 1;
+	    }
+	    sample += have_last ? record - last_record : record - 1;
+	    last_record = record;
+	    have_last = 1;
+	    stamp = (long long)(((rtapi_u64)buf[1].u << 32) | buf[0].u);
+	    res = hallog_write(w, sample, stamp, buf + LOGGER_META_ELEMENTS);
+	}
+	if ( res == 0 && mono_ns() - last_flush >= FLUSH_INTERVAL_NS ) {
+	    res = hallog_writer_flush(w);
+	    last_flush = mono_ns();
+	}
+	if ( res < 0 ) {
+	    errno = -res;
+	    perror(path);
+	    goto out;
+	}
+	if ( max_size && hallog_writer_size(w) >= max_size ) {
+	    w = rotate(w, path);
+	    if ( !w ) {
+		goto out;
+	    }
+	}
+	if ( samples > 0 ) {
+	    samples--;
+	}
+    }
+    /* run was succesfull */
+    exitval = 0;
+
+out:
+    ignore_sig = 1;
+    if ( w ) {
+	res = hallog_writer_close(w);
+	if ( res < 0 ) {
+	    errno = -res;
+	    perror(path);
+	    exitval = 1;
+	}
+    }
+    if ( lost ) {
+	fprintf(stderr, "hallogger: %llu records lost to overruns\n", lost);
+    }
+    hal_stream_detach(&stream);
+    if ( comp_id >= 0 ) {
+	hal_exit(comp_id);
+    }
+    for ( n = 0 ; n < num_cols ; n++ ) {
+	free(col_names[n]);
+    }
+    return exitval;
+}
@@ -12,10 +12,12 @@
 
 #define MAX_STREAMERS		8
 #define MAX_SAMPLERS		8
+#define MAX_LOGGERS		8
 #define MAX_PINS 		20
 #define MAX_SHMEM 		128000
 #define STREAMER_SHMEM_KEY 	0x48535430
 #define SAMPLER_SHMEM_KEY	0x48534130
+#define LOGGER_SHMEM_KEY	0x48534C30
 
 /* this struct lives in HAL shared memory */
 
@@ -0,0 +1,88 @@
+/********************************************************************
+* Description:  watch.c
+*               A HAL component that looks for changed values on
+*               behalf of user space watchers.
+*
+* License: GPL Version 2
+*
+********************************************************************/
+/** This file, 'watch.c', is the realtime half of the HAL watch API
+    (see hal_watch_new() in hal.h).  It exports a single function,
+    'watch.scan', which compares every watched pin, signal and
+    parameter with the value it reported last, and queues the changes
+    for the user space programs that are waiting for them.
+
+    Loading:
+
+    loadrt watch
+    addf watch.scan servo-thread
+
+    Add 'watch.scan' after the functions whose results should be
+    watched.  It doesn't use floating point.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include "rtapi.h"              /* RTAPI realtime OS API */
+#include "rtapi_app.h"          /* RTAPI realtime module decls */
+#include "hal.h"                /* HAL public API decls */
+#include "rtapi_errno.h"
+
+/* module information */
+MODULE_DESCRIPTION("Change notification for HAL watches");
+MODULE_LICENSE("GPL");
+
+static int comp_id;		/* component ID */
+
+static void scan(void *arg, long period)
+{
+    hal_watch_scan();
+}
+
+int rtapi_app_main(void)
+{
+    int retval;
+
+    comp_id = hal_init("watch");
+    if (comp_id < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "WATCH: ERROR: hal_init() failed\n");
+	return -EINVAL;
+    }
+    retval = hal_export_funct("watch.scan", scan, 0, 0, 0, comp_id);
+    if (retval != 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "WATCH: ERROR: function export failed\n");
+	hal_exit(comp_id);
+	return retval;
+    }
+    hal_ready(comp_id);
+    return 0;
+}
+
+void rtapi_app_exit(void)
+{
+    hal_exit(comp_id);
+}
@@ -197,15 +197,13 @@ extern int hal_exit(int comp_id);
     allocated space, or NULL (0) on error.  The returned pointer
     will be properly aligned for any variable HAL supports (see
     HAL_TYPE below.)
-    The allocator is very simple, and there is no 'free'.  It is
-    assumed that a component will allocate all the memory it needs
-    during initialization.  The entire HAL shared memory area is
-    freed when the last component calls hal_exit().  This means
-    that if you continuously install and remove one component
-    while other components are present, you eventually will fill
-    up the shared memory and an install will fail.  Removing
-    all components completely clears memory and you start
-    fresh.
+    The memory is zeroed.  There is no 'free', it is assumed that a
+    component will allocate all the memory it needs during
+    initialization.  Memory allocated between hal_init() and
+    hal_ready() belongs to that component, and is freed together
+    with its pins and parameters when it calls hal_exit(), so
+    components can be installed and removed any number of times.
+    Memory allocated at any other time is never freed.
 */
 extern void *hal_malloc(long int size);
 
@@ -653,6 +651,16 @@ extern int hal_export_funct(const char *name, void (*funct) (void *, long),
 extern int hal_create_thread(const char *name, unsigned long period_nsec,
     int uses_fp);
 
+/** hal_create_thread_cpu() is the same as hal_create_thread(), but
+    runs the thread on CPU 'cpu_id'.  A 'cpu_id' of -1 lets RTAPI
+    choose; in uspace realtime, threads are then spread over the
+    isolated CPUs (isolcpus= or nohz_full=) in the order they are
+    created.  Each thread exports a pin '<name>.overruns' that counts
+    the periods in which the thread started late.
+*/
+extern int hal_create_thread_cpu(const char *name, unsigned long period_nsec,
+    int uses_fp, int cpu_id);
+
 /** hal_thread_delete() deletes a realtime thread.
     'name' is the name of the thread, which must have been created
     by 'hal_create_thread()'.
@@ -715,6 +723,47 @@ extern int hal_start_threads(void);
 */
 extern int hal_stop_threads(void);
 
+#ifdef ULAPI
+/***********************************************************************
+*                    BATCH CONFIGURATION FUNCTIONS                     *
+************************************************************************/
+
+/** hal_begin_batch() starts collecting configuration changes into a
+    batch instead of making them one at a time.  Until the batch is
+    committed or aborted, hal_signal_new(), hal_link(),
+    hal_param_set() and hal_add_funct_to_thread() only check their
+    arguments and queue the change, and hal_batch_net(),
+    hal_batch_setp() and hal_batch_sets() may be used to queue the
+    equivalents of halcmd's 'net', 'setp' and 'sets'.
+    hal_commit_batch() then makes all queued changes in order while
+    holding the HAL mutex once, looking names up through a temporary
+    index.  If any change fails, the ones already made are taken back
+    and the HAL is left as it was before the batch; either way the
+    batch is closed.  hal_abort_batch() discards the queued changes.
+    A process may have only one batch open at a time, and it is not
+    visible to other processes until it is committed.  Only changes
+    made through the functions listed above are part of the batch.
+    All of these return 0, or a negative error code.
+    hal_batch_active() returns non-zero while a batch is open.
+    Call only from user space.
+*/
+extern int hal_begin_batch(void);
+extern int hal_commit_batch(void);
+extern int hal_abort_batch(void);
+extern int hal_batch_active(void);
+
+/** hal_batch_net() links pin 'pin_name' to signal 'sig_name', first
+    creating the signal with the type of the pin if it does not exist
+    yet.  hal_batch_setp() sets a parameter, or an input pin that is
+    not linked, and hal_batch_sets() sets a signal that has no writer;
+    'value' is parsed according to the type of the object when the
+    batch is committed.
+*/
+extern int hal_batch_net(const char *sig_name, const char *pin_name);
+extern int hal_batch_setp(const char *name, const char *value);
+extern int hal_batch_sets(const char *name, const char *value);
+#endif /* ULAPI */
+
 /** HAL 'constructor' typedef
     If it is not NULL, this points to a function which can construct a new
     instance of its component.  Return value is >=0 for success,
@@ -777,6 +826,70 @@ extern bool hal_stream_writable(hal_stream_t *stream);
 extern void hal_stream_wait_writable(hal_stream_t *stream, sig_atomic_t *stop);
 #endif
 
+/***********************************************************************
+*                  WATCH (CHANGE NOTIFICATION) FUNCTIONS               *
+************************************************************************/
+
+/** A watch lets a user space program wait for a set of pins, signals
+    or parameters to change, instead of polling them.  The realtime
+    function 'watch.scan' (from the 'watch' component) compares them
+    with the values it reported last, and queues the ones that
+    changed for the watch's reader, waking it if it is waiting.
+    Values are only seen as often as the thread that runs
+    'watch.scan', and a value that changes back and forth between
+    scans is reported once, or not at all.
+*/
+typedef struct {
+    int index;			/* item, as returned by hal_watch_add() */
+    hal_type_t type;		/* its data type */
+    union hal_stream_data value;	/* its new value */
+} hal_watch_event_t;
+
+typedef struct {
+    int comp_id;
+    struct hal_watch_shm *shm;
+} hal_watch_t;
+
+/** 'watch.scan' calls this once per thread period */
+extern void hal_watch_scan(void);
+
+#ifdef ULAPI
+/** hal_watch_new() creates an empty watch for component 'comp_id',
+    with room for 'max_items' items and 'depth' - 1 queued changes.
+    The watch belongs to the component and is deleted with it.
+    Returns 0 on success or a negative error code.
+*/
+extern int hal_watch_new(hal_watch_t *watch, int comp_id, int max_items,
+    int depth);
+/** hal_watch_add() adds the pin, signal or parameter 'name' to the
+    watch.  Returns its index (0 for the first item, 1 for the next
+    one and so on) or a negative error code.  The current value of a
+    new item is reported by the next scan, changed or not.
+*/
+extern int hal_watch_add(hal_watch_t *watch, const char *name);
+extern hal_type_t hal_watch_type(hal_watch_t *watch, int index);
+/** hal_watch_read() copies up to 'max' queued changes to 'events',
+    oldest first, and returns how many it copied.  It doesn't block.
+*/
+extern int hal_watch_read(hal_watch_t *watch, hal_watch_event_t *events,
+    int max);
+extern bool hal_watch_readable(hal_watch_t *watch);
+/** hal_watch_wait() blocks until a change is queued, or for at most
+    'timeout_ns' nanoseconds if that is not negative.  Returns 1 if
+    changes are queued, 0 on timeout, -EINTR if a signal arrived.
+    'timeout_ns' is a long long so that 32 bit targets can wait for
+    more than about 2 seconds.
+*/
+extern int hal_watch_wait(hal_watch_t *watch, long long timeout_ns);
+/** number of scans that found the queue full; the changes are not
+    lost, just reported later */
+extern int hal_watch_overruns(hal_watch_t *watch);
+/** hal_watch_delete() frees a watch.  Returns -EBUSY, and leaves its
+    memory to be freed with the component, if 'watch.scan' is stuck.
+*/
+extern int hal_watch_delete(hal_watch_t *watch);
+#endif /* ULAPI */
+
 RTAPI_END_DECLS
 
 #endif /* HAL_H */
@@ -71,7 +71,18 @@ MODULE_LICENSE("GPL");
 #if defined(ULAPI)
 #include <sys/types.h>		/* pid_t */
 #include <unistd.h>		/* getpid() */
+#include <stdlib.h>		/* malloc() */
+#include <ctype.h>		/* isspace() */
+#include <strings.h>		/* strcasecmp() */
 #include <time.h>
+#include <errno.h>
+#endif
+
+#if !defined(__KERNEL__)
+#include <limits.h>		/* INT_MAX, LLONG_MAX */
+#include <unistd.h>		/* syscall() */
+#include <sys/syscall.h>	/* SYS_futex */
+#include <linux/futex.h>	/* FUTEX_WAIT, FUTEX_WAKE */
 #endif
 
 char *hal_shmem_base = 0;
@@ -92,28 +103,42 @@ static int lib_mem_id = 0;	/* RTAPI shmem ID for library module */
 */
 static int init_hal_data(void);
 
-/** The 'shmalloc_xx()' functions allocate blocks of shared memory.
-    Each function allocates a block that is 'size' bytes long.
-    If 'size' is 3 or more, the block is aligned on a 4 byte
-    boundary.  If 'size' is 2, it is aligned on a 2 byte boundary,
-    and if 'size' is 1, it is unaligned.
-    These functions do not test a mutex - they are called from
+/** 'shmalloc_dn()' allocates a block of shared memory that is
+    'size' bytes long.  If 'size' is 3 or more, the block is aligned
+    on a 4 byte boundary.  If 'size' is 2, it is aligned on a 2 byte
+    boundary, and if 'size' is 1, it is unaligned.
+    It starts at the top of shared memory and works down, and is
+    used to allocate the structures that are accessed only
+    occaisionally during init.
+    Data that will be accessed by realtime code comes from the
+    bottom of shared memory instead, one page at a time (see
+    'hal_slab_t' in hal_priv.h).  'slab_alloc()' allocates 'size'
+    bytes of zeroed memory on behalf of component 'owner' (0 for
+    memory that belongs to no component), aligned on an 8 byte
+    boundary.  'slab_free()' returns a block from 'slab_alloc()',
+    and 'free_slabs()' returns every page owned by 'comp'.
+    'malloc_owner()' finds the component that 'hal_malloc()'
+    allocates for - the most recent one of this process that has
+    not called hal_ready() yet.
+    None of these functions test a mutex - they are called from
     within the hal library by code that already has the mutex.
-    (The public function 'hal_malloc()' is a wrapper that gets the
-    mutex and then calls 'shmalloc_up()'.)
-    The only difference between the two functions is the location
-    of the allocated memory.  'shmalloc_up()' allocates from the
-    base of shared memory and works upward, while 'shmalloc_dn()'
-    starts at the top and works down.
-    This is done to improve realtime performance.  'shmalloc_up()'
-    is used to allocate data that will be accessed by realtime
-    code, while 'shmalloc_dn()' is used to allocate the much
-    larger structures that are accessed only occaisionally during
-    init.  This groups all the realtime data together, inproving
+    This groups all the realtime data together, inproving
     cache performance.
 */
-static void *shmalloc_up(long int size);
 static void *shmalloc_dn(long int size);
+static void *slab_alloc(hal_comp_t * owner, long int size);
+static void slab_free(void *block);
+static void free_slabs(hal_comp_t * comp);
+static hal_comp_t *malloc_owner(void);
+
+/** 'watch_forget()' stops all watches from looking at 'object', a
+    pin, signal or param that is about to be freed.  'watch_remove_owned()'
+    takes the watches of 'comp' off the list before its memory is freed.
+    Both wait for a running 'watch.scan' to finish, and return -EBUSY if
+    it doesn't within a second; the memory must then not be freed.
+*/
+static int watch_forget(void *object);
+static int watch_remove_owned(hal_comp_t * comp);
 
 /** The alloc_xxx_struct() functions allocate a structure of the
     appropriate type and return a pointer to it, or 0 if they fail.
@@ -125,9 +150,9 @@ static void *shmalloc_dn(long int size);
     grabbed the hal_data mutex.
 */
 hal_comp_t *halpr_alloc_comp_struct(void);
-static hal_pin_t *alloc_pin_struct(void);
+static hal_pin_t *alloc_pin_struct(hal_comp_t * owner);
 static hal_sig_t *alloc_sig_struct(void);
-static hal_param_t *alloc_param_struct(void);
+static hal_param_t *alloc_param_struct(hal_comp_t * owner);
 static hal_oldname_t *halpr_alloc_oldname_struct(void);
 #ifdef RTAPI
 static hal_funct_t *alloc_funct_struct(void);
@@ -159,6 +184,44 @@ static void free_thread_struct(hal_thread_t * thread);
 static void thread_task(void *arg);
 #endif /* RTAPI */
 
+/** The following functions do the work of the public functions of the
+    same purpose once the objects have been looked up, so the batch
+    code below can share them.  They assume that the caller has
+    already grabbed the hal_data mutex.
+    'new_signal()' creates signal 'name', which must not exist yet,
+    and returns it in '*sig' if 'sig' is not NULL.  'link_pin()' links
+    'pin' to 'sig'.  'add_funct_entry()' adds 'funct' to 'thread' at
+    'position', and returns the new entry in '*entry' if 'entry' is not
+    NULL.  'set_param_value()' stores 'value', which must be of type
+    'type', in 'param'.
+*/
+static int new_signal(const char *name, hal_type_t type, hal_sig_t **sig);
+static int link_pin(hal_pin_t *pin, hal_sig_t *sig);
+static int add_funct_entry(hal_funct_t *funct, hal_thread_t *thread,
+    int position, hal_funct_entry_t **entry);
+static int set_param_value(hal_param_t *param, hal_type_t type,
+    const hal_data_u *value);
+
+#ifdef ULAPI
+/** While a batch is open (see 'hal_begin_batch()') the public
+    functions that change the configuration only check their arguments
+    and queue the change with 'batch_queue()'.
+*/
+typedef enum {
+    BATCH_NEWSIG,		/* hal_signal_new(name, type) */
+    BATCH_LINK,			/* hal_link(name, arg) */
+    BATCH_NET,			/* hal_batch_net(arg, name) */
+    BATCH_ADDF,			/* hal_add_funct_to_thread(name, arg, position) */
+    BATCH_PARAM,		/* hal_param_set(name, type, value) */
+    BATCH_SETP,			/* hal_batch_setp(name, arg) */
+    BATCH_SETS			/* hal_batch_sets(name, arg) */
+} batch_kind_t;
+
+static int batch_open = 0;
+static int batch_queue(batch_kind_t kind, const char *name, const char *arg,
+    hal_type_t type, int position, const hal_data_u *value);
+#endif /* ULAPI */
+
 /***********************************************************************
 *                  PUBLIC (API) FUNCTION CODE                          *
 ************************************************************************/
@@ -270,6 +333,7 @@ int hal_init(const char *name)
     comp->ready = 0;
     comp->shmem_base = hal_shmem_base;
     comp->insmod_args = 0;
+    comp->slab_ptr = 0;
     rtapi_snprintf(comp->name, sizeof(comp->name), "%s", hal_name);
     /* insert new structure at head of list */
     comp->next_ptr = hal_data->comp_list_ptr;
@@ -325,25 +389,8 @@ int hal_exit(int comp_id)
     *prev = comp->next_ptr;
     /* save component name for later */
     rtapi_snprintf(name, sizeof(name), "%s", comp->name);
-    /* get rid of the component */
+    /* get rid of the component, and the memory it allocated */
     free_comp_struct(comp);
-/*! \todo Another #if 0 */
-#if 0
-    /*! \todo FIXME - this is the beginning of a two pronged approach to managing
-       shared memory.  Prong 1 - re-init the shared memory allocator whenever 
-       it is known to be safe.  Prong 2 - make a better allocator that can
-       reclaim memory allocated by components when those components are
-       removed. To be finished later. */
-    /* was that the last component? */
-    if (hal_data->comp_list_ptr == 0) {
-	/* yes, are there any signals or threads defined? */
-	if ((hal_data->sig_list_ptr == 0) && (hal_data->thread_list_ptr == 0)) {
-	    /* no, invalidate "magic" number so shmem will be re-inited when
-	       a new component is loaded */
-	    hal_data->magic = 0;
-	}
-    }
-#endif
     /* release mutex */
     rtapi_mutex_give(&(hal_data->mutex));
     --ref_cnt;
@@ -379,7 +426,7 @@ void *hal_malloc(long int size)
     /* get the mutex */
     rtapi_mutex_get(&(hal_data->mutex));
     /* allocate memory */
-    retval = shmalloc_up(size);
+    retval = slab_alloc(malloc_owner(), size);
     /* release the mutex */
     rtapi_mutex_give(&(hal_data->mutex));
     /* check return value */
@@ -671,7 +718,7 @@ int hal_pin_new(const char *name, hal_type_t type, hal_pin_dir_t dir,
 	return -EINVAL;
     }
     /* allocate a new variable structure */
-    new = alloc_pin_struct();
+    new = alloc_pin_struct(comp);
     if (new == 0) {
 	/* alloc failed */
 	rtapi_mutex_give(&(hal_data->mutex));
@@ -853,11 +900,7 @@ int hal_pin_alias(const char *pin_name, const char *alias)
 
 int hal_signal_new(const char *name, hal_type_t type)
 {
-
-    rtapi_intptr_t *prev, next;
-    int cmp;
-    hal_sig_t *new, *ptr;
-    void *data_addr;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -875,6 +918,11 @@ int hal_signal_new(const char *name, hal_type_t type)
 	    "HAL: ERROR: signal_new called while HAL is locked\n");
 	return -EPERM;
     }
+#ifdef ULAPI
+    if (batch_open) {
+	return batch_queue(BATCH_NEWSIG, name, NULL, type, 0, NULL);
+    }
+#endif
 
     rtapi_print_msg(RTAPI_MSG_DBG, "HAL: creating signal '%s'\n", name);
     /* get mutex before accessing shared data */
@@ -886,88 +934,9 @@ int hal_signal_new(const char *name, hal_type_t type)
 	    "HAL: ERROR: duplicate signal '%s'\n", name);
 	return -EINVAL;
     }
-    /* allocate memory for the signal value */
-/*
-because accesses will later be through pointer of type hal_data_u,
-allocate something that big.  Otherwise, gcc -fsanitize=undefined will
-issue diagnostics like
-    hal/hal_lib.c:3203:35: runtime error: member access within misaligned address 0x7fcf3d11f10b for type 'union hal_data_u', which requires 8 byte alignment
-on accesses through hal_data_u.
-
-This does increase memory usage somewhat, but is required for compliance
-with the C standard.
-*/
-    switch (type) {
-    case HAL_BIT:
-    case HAL_S32:
-    case HAL_U32:
-    case HAL_FLOAT:
-        data_addr = shmalloc_up(sizeof(hal_data_u));
-	break;
-    default:
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: illegal signal type %d'\n", type);
-	return -EINVAL;
-	break;
-    }
-    /* allocate a new signal structure */
-    new = alloc_sig_struct();
-    if ((new == 0) || (data_addr == 0)) {
-	/* alloc failed */
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: insufficient memory for signal '%s'\n", name);
-	return -ENOMEM;
-    }
-    /* initialize the signal value */
-    switch (type) {
-    case HAL_BIT:
-	*((hal_bit_t *) data_addr) = 0;
-	break;
-    case HAL_S32:
-	*((hal_s32_t *) data_addr) = 0;
-        break;
-    case HAL_U32:
-	*((hal_u32_t *) data_addr) = 0;
-        break;
-    case HAL_FLOAT:
-	*((hal_float_t *) data_addr) = 0.0;
-	break;
-    default:
-	break;
-    }
-    /* initialize the structure */
-    new->data_ptr = SHMOFF(data_addr);
-    new->type = type;
-    new->readers = 0;
-    new->writers = 0;
-    new->bidirs = 0;
-    rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
-    /* search list for 'name' and insert new structure */
-    prev = &(hal_data->sig_list_ptr);
-    next = *prev;
-    while (1) {
-	if (next == 0) {
-	    /* reached end of list, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	ptr = SHMPTR(next);
-	cmp = strcmp(ptr->name, new->name);
-	if (cmp > 0) {
-	    /* found the right place for it, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	/* didn't find it yet, look at next one */
-	prev = &(ptr->next_ptr);
-	next = *prev;
-    }
+    retval = new_signal(name, type, NULL);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return retval;
 }
 
 int hal_signal_delete(const char *name)
@@ -1019,8 +988,7 @@ int hal_link(const char *pin_name, const char *sig_name)
 {
     hal_pin_t *pin;
     hal_sig_t *sig;
-    hal_comp_t *comp;
-    void **data_ptr_addr, *data_addr;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -1043,6 +1011,11 @@ int hal_link(const char *pin_name, const char *sig_name)
 	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: signal name not given\n");
 	return -EINVAL;
     }
+#ifdef ULAPI
+    if (batch_open) {
+	return batch_queue(BATCH_LINK, pin_name, sig_name, 0, 0, NULL);
+    }
+#endif
     rtapi_print_msg(RTAPI_MSG_DBG,
 	"HAL: linking pin '%s' to '%s'\n", pin_name, sig_name);
     /* get mutex before accessing data structures */
@@ -1065,99 +1038,10 @@ int hal_link(const char *pin_name, const char *sig_name)
 	    "HAL: ERROR: signal '%s' not found\n", sig_name);
 	return -EINVAL;
     }
-    /* found both pin and signal, are they already connected? */
-    if (SHMPTR(pin->signal) == sig) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_WARN,
-	    "HAL: Warning: pin '%s' already linked to '%s'\n", pin_name, sig_name);
-	return 0;
-    }
-    /* is the pin connected to something else? */
-    if(pin->signal) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	sig = SHMPTR(pin->signal);
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: pin '%s' is linked to '%s', cannot link to '%s'\n",
-	    pin_name, sig->name, sig_name);
-	return -EINVAL;
-    }
-    /* check types */
-    if (pin->type != sig->type) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: type mismatch '%s' <- '%s'\n", pin_name, sig_name);
-	return -EINVAL;
-    }
-    /* linking output pin to sig that already has output or I/O pins? */
-    if ((pin->dir == HAL_OUT) && ((sig->writers > 0) || (sig->bidirs > 0 ))) {
-	/* yes, can't do that */
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: signal '%s' already has output or I/O pin(s)\n", sig_name);
-	return -EINVAL;
-    }
-    /* linking bidir pin to sig that already has output pin? */
-    if ((pin->dir == HAL_IO) && (sig->writers > 0)) {
-	/* yes, can't do that */
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: signal '%s' already has output pin\n", sig_name);
-	return -EINVAL;
-    }
-    /* everything is OK, make the new link */
-    data_ptr_addr = SHMPTR(pin->data_ptr_addr);
-    comp = SHMPTR(pin->owner_ptr);
-    data_addr = comp->shmem_base + sig->data_ptr;
-    *data_ptr_addr = data_addr;
-    bool drive_pin_default_value_onto_signal =
-        ( pin->dir != HAL_IN || sig->readers == 0 )
-            && ( sig->writers == 0 ) && ( sig->bidirs == 0 );
-    if (drive_pin_default_value_onto_signal) {
-	/* this is the first pin for this signal, copy value from pin's "dummy" field */
-	data_addr = hal_shmem_base + sig->data_ptr;
-
-        // assure proper typing on assignment, assigning a hal_data_u is
-        // a surefire cause for memory corrupion as hal_data_u is larger
-        // than hal_bit_t, hal_s32_t, and hal_u32_t - this works only for 
-        // hal_float_t (!)
-        // my old, buggy code:
-        //*((hal_data_u *)data_addr) = pin->dummysig;
-
-        switch (pin->type) {
-        case HAL_BIT:
-            *((hal_bit_t *) data_addr) = pin->dummysig.b;
-            break;
-        case HAL_S32:
-            *((hal_s32_t *) data_addr) = pin->dummysig.s;
-            break;
-        case HAL_U32:
-            *((hal_u32_t *) data_addr) = pin->dummysig.u;
-            break;
-        case HAL_FLOAT:
-            *((hal_float_t *) data_addr) = pin->dummysig.f;
-            break;
-        default:
-            rtapi_print_msg(RTAPI_MSG_ERR,
-                          "HAL: BUG: pin '%s' has invalid type %d !!\n",
-                          pin->name, pin->type);
-            return -EINVAL;
-        }
-    }
-    /* update the signal's reader/writer/bidir counts */
-    if ((pin->dir & HAL_IN) != 0) {
-	sig->readers++;
-    }
-    if (pin->dir == HAL_OUT) {
-	sig->writers++;
-    }
-    if (pin->dir == HAL_IO) {
-	sig->bidirs++;
-    }
-    /* and update the pin */
-    pin->signal = SHMOFF(sig);
+    retval = link_pin(pin, sig);
     /* done, release the mutex and return */
     rtapi_mutex_give(&(hal_data->mutex));
-    return 0;
+    return retval;
 }
 
 int hal_unlink(const char *pin_name)
@@ -1355,7 +1239,7 @@ int hal_param_new(const char *name, hal_type_t type, hal_param_dir_t dir, void *
 	return -EINVAL;
     }
     /* allocate a new parameter structure */
-    new = alloc_param_struct();
+    new = alloc_param_struct(comp);
     if (new == 0) {
 	/* alloc failed */
 	rtapi_mutex_give(&(hal_data->mutex));
@@ -1430,7 +1314,8 @@ int hal_param_s32_set(const char *name, signed long value)
 int hal_param_set(const char *name, hal_type_t type, void *value_addr)
 {
     hal_param_t *param;
-    void *d_ptr;
+    hal_data_u value;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -1443,6 +1328,30 @@ int hal_param_set(const char *name, hal_type_t type, void *value_addr)
 	    "HAL: ERROR: param_set called while HAL locked\n");
 	return -EPERM;
     }
+    /* convert the value to its HAL representation */
+    switch (type) {
+    case HAL_BIT:
+	value.b = *((int *) value_addr) != 0;
+	break;
+    case HAL_FLOAT:
+	value.f = *((double *) value_addr);
+	break;
+    case HAL_S32:
+	value.s = *((signed long *) value_addr);
+	break;
+    case HAL_U32:
+	value.u = *((unsigned long *) value_addr);
+	break;
+    default:
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: bad type %d setting param\n", type);
+	return -EINVAL;
+    }
+#ifdef ULAPI
+    if (batch_open) {
+	return batch_queue(BATCH_PARAM, name, NULL, type, 0, &value);
+    }
+#endif
     
     rtapi_print_msg(RTAPI_MSG_DBG, "HAL: setting parameter '%s'\n", name);
     /* get mutex before accessing shared data */
@@ -1457,48 +1366,9 @@ int hal_param_set(const char *name, hal_type_t type, void *value_addr)
 	    "HAL: ERROR: parameter '%s' not found\n", name);
 	return -EINVAL;
     }
-    /* found it, is type compatible? */
-    if (param->type != type) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: type mismatch setting param '%s'\n", name);
-	return -EINVAL;
-    }
-    /* is it read only? */
-    if (param->dir == HAL_RO) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: param '%s' is not writable\n", name);
-	return -EINVAL;
-    }
-    /* everything is OK, set the value */
-    d_ptr = SHMPTR(param->data_ptr);
-    switch (param->type) {
-    case HAL_BIT:
-	if (*((int *) value_addr) == 0) {
-	    *(hal_bit_t *) (d_ptr) = 0;
-	} else {
-	    *(hal_bit_t *) (d_ptr) = 1;
-	}
-	break;
-    case HAL_FLOAT:
-	*((hal_float_t *) (d_ptr)) = *((double *) (value_addr));
-	break;
-    case HAL_S32:
-	*((hal_s32_t *) (d_ptr)) = *((signed long *) (value_addr));
-	break;
-    case HAL_U32:
-	*((hal_u32_t *) (d_ptr)) = *((unsigned long *) (value_addr));
-	break;
-    default:
-	/* Shouldn't get here, but just in case... */
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: bad type %d setting param\n", param->type);
-	return -EINVAL;
-    }
+    retval = set_param_value(param, type, &value);
     rtapi_mutex_give(&(hal_data->mutex));
-    return 0;
+    return retval;
 }
 
 int hal_param_alias(const char *param_name, const char *alias)
@@ -1759,6 +1629,12 @@ int hal_export_funct(const char *name, void (*funct) (void *, long),
 }
 
 int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
+{
+    return hal_create_thread_cpu(name, period_nsec, uses_fp, -1);
+}
+
+int hal_create_thread_cpu(const char *name, unsigned long period_nsec,
+    int uses_fp, int cpu_id)
 {
     int next, cmp, prev_priority;
     int retval, n;
@@ -1818,6 +1694,7 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
     }
     /* initialize the structure */
     new->uses_fp = uses_fp;
+    new->cpu_id = cpu_id;
     rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
     /* have to create and start a task to run the thread */
     if (hal_data->thread_list_ptr == 0) {
@@ -1887,10 +1764,21 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
 	return -EINVAL;
     }
     new->task_id = retval;
-    /* start task */
-    retval = rtapi_task_start(new->task_id, new->period);
-    if (retval < 0) {
-	rtapi_mutex_give(&(hal_data->mutex));
+    if (cpu_id != -1) {
+	retval = rtapi_task_set_cpu(new->task_id, cpu_id);
+	if (retval < 0) {
+	    rtapi_task_delete(new->task_id);
+	    rtapi_mutex_give(&(hal_data->mutex));
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL_LIB: could not place thread %s on cpu %d: %d\n",
+		name, cpu_id, retval);
+	    return -EINVAL;
+	}
+    }
+    /* start task */
+    retval = rtapi_task_start(new->task_id, new->period);
+    if (retval < 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL_LIB: could not start task for thread %s: %d\n", name, retval);
 	return -EINVAL;
@@ -1923,6 +1811,13 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
         return -EINVAL;
     }
     *(new->runtime) = 0;
+
+    if (hal_pin_s32_newf(HAL_OUT, &(new->overruns), new->comp_id,"%s.overruns",new->name)) {
+        rtapi_print_msg(RTAPI_MSG_ERR,
+           "HAL: ERROR: fail to create pin '%s.overruns'\n", new->name);
+        return -EINVAL;
+    }
+    *(new->overruns) = 0;
     hal_ready(new->comp_id);
 
     rtapi_print_msg(RTAPI_MSG_DBG, "HAL: thread created\n");
@@ -1984,9 +1879,7 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 {
     hal_thread_t *thread;
     hal_funct_t *funct;
-    hal_list_t *list_root, *list_entry;
-    int n;
-    hal_funct_entry_t *funct_entry;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -1999,33 +1892,36 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	    "HAL: ERROR: add_funct_to_thread called while HAL is locked\n");
 	return -EPERM;
     }
-
-    rtapi_print_msg(RTAPI_MSG_DBG,
-	"HAL: adding function '%s' to thread '%s'\n",
-	funct_name, thread_name);
-    /* get mutex before accessing data structures */
-    rtapi_mutex_get(&(hal_data->mutex));
     /* make sure position is valid */
     if (position == 0) {
 	/* zero is not allowed */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: bad position: 0\n");
 	return -EINVAL;
     }
     /* make sure we were given a function name */
     if (funct_name == 0) {
 	/* no name supplied */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: missing function name\n");
 	return -EINVAL;
     }
     /* make sure we were given a thread name */
     if (thread_name == 0) {
 	/* no name supplied */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: missing thread name\n");
 	return -EINVAL;
     }
+#ifdef ULAPI
+    if (batch_open) {
+	return batch_queue(BATCH_ADDF, funct_name, thread_name, 0, position,
+	    NULL);
+    }
+#endif
+
+    rtapi_print_msg(RTAPI_MSG_DBG,
+	"HAL: adding function '%s' to thread '%s'\n",
+	funct_name, thread_name);
+    /* get mutex before accessing data structures */
+    rtapi_mutex_get(&(hal_data->mutex));
     /* search function list for the function */
     funct = halpr_find_funct_by_name(funct_name);
     if (funct == 0) {
@@ -2035,13 +1931,6 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	    "HAL: ERROR: function '%s' not found\n", funct_name);
 	return -EINVAL;
     }
-    /* found the function, is it available? */
-    if ((funct->users > 0) && (funct->reentrant == 0)) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: function '%s' may only be added to one thread\n", funct_name);
-	return -EINVAL;
-    }
     /* search thread list for thread_name */
     thread = halpr_find_thread_by_name(thread_name);
     if (thread == 0) {
@@ -2051,65 +1940,9 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	    "HAL: ERROR: thread '%s' not found\n", thread_name);
 	return -EINVAL;
     }
-    /* ok, we have thread and function, are they compatible? */
-    if ((funct->uses_fp) && (!thread->uses_fp)) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: function '%s' needs FP\n", funct_name);
-	return -EINVAL;
-    }
-    /* find insertion point */
-    list_root = &(thread->funct_list);
-    list_entry = list_root;
-    n = 0;
-    if (position > 0) {
-	/* insertion is relative to start of list */
-	while (++n < position) {
-	    /* move further into list */
-	    list_entry = list_next(list_entry);
-	    if (list_entry == list_root) {
-		/* reached end of list */
-		rtapi_mutex_give(&(hal_data->mutex));
-		rtapi_print_msg(RTAPI_MSG_ERR,
-		    "HAL: ERROR: position '%d' is too high\n", position);
-		return -EINVAL;
-	    }
-	}
-    } else {
-	/* insertion is relative to end of list */
-	while (--n > position) {
-	    /* move further into list */
-	    list_entry = list_prev(list_entry);
-	    if (list_entry == list_root) {
-		/* reached end of list */
-		rtapi_mutex_give(&(hal_data->mutex));
-		rtapi_print_msg(RTAPI_MSG_ERR,
-		    "HAL: ERROR: position '%d' is too low\n", position);
-		return -EINVAL;
-	    }
-	}
-	/* want to insert before list_entry, so back up one more step */
-	list_entry = list_prev(list_entry);
-    }
-    /* allocate a funct entry structure */
-    funct_entry = alloc_funct_entry_struct();
-    if (funct_entry == 0) {
-	/* alloc failed */
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: insufficient memory for thread->function link\n");
-	return -ENOMEM;
-    }
-    /* init struct contents */
-    funct_entry->funct_ptr = SHMOFF(funct);
-    funct_entry->arg = funct->arg;
-    funct_entry->funct = funct->funct;
-    /* add the entry to the list */
-    list_add_after((hal_list_t *) funct_entry, list_entry);
-    /* update the function usage count */
-    funct->users++;
+    retval = add_funct_entry(funct, thread, position, NULL);
     rtapi_mutex_give(&(hal_data->mutex));
-    return 0;
+    return retval;
 }
 
 int hal_del_funct_from_thread(const char *funct_name, const char *thread_name)
@@ -2243,108 +2076,638 @@ int hal_stop_threads(void)
     return 0;
 }
 
+#ifdef ULAPI
 /***********************************************************************
-*                    PRIVATE FUNCTION CODE                             *
+*                    BATCH CONFIGURATION FUNCTIONS                     *
 ************************************************************************/
 
-hal_list_t *list_prev(hal_list_t * entry)
+/* a queued change, and what is needed to take it back once applied */
+typedef struct {
+    batch_kind_t kind;
+    hal_type_t type;		/* signal type, or the type of 'value' */
+    int position;		/* position for BATCH_ADDF */
+    char *name;			/* pin, param, signal or function name */
+    char *arg;			/* signal, thread or value string */
+    hal_data_u value;		/* value for BATCH_PARAM */
+    /* filled in by batch_apply() */
+    hal_pin_t *pin;		/* pin that was linked */
+    hal_sig_t *new_sig;		/* signal that was created */
+    hal_funct_entry_t *entry;	/* thread entry that was added */
+    void *data;			/* value that was changed */
+    hal_type_t data_type;
+    hal_data_u old_value;	/* 'data' or pin's dummysig before */
+    hal_data_u old_sig_value;	/* signal value before a link */
+} batch_op_t;
+
+/* name lookups during a commit */
+typedef struct {
+    halpr_index_t pins, params, sigs, functs;
+} batch_index_t;
+
+static batch_op_t *batch_ops = 0;
+static int batch_len = 0;
+static int batch_size = 0;
+
+static int batch_queue(batch_kind_t kind, const char *name, const char *arg,
+    hal_type_t type, int position, const hal_data_u *value)
 {
-    /* this function is only needed because of memory mapping */
-    return SHMPTR(entry->prev);
+    batch_op_t *op;
+    size_t len;
+    int size;
+
+    if (batch_len == batch_size) {
+	size = batch_size ? 2 * batch_size : 64;
+	op = realloc(batch_ops, size * sizeof(batch_op_t));
+	if (op == 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: insufficient memory for batch\n");
+	    return -ENOMEM;
+	}
+	batch_ops = op;
+	batch_size = size;
+    }
+    op = &batch_ops[batch_len];
+    memset(op, 0, sizeof(batch_op_t));
+    /* one allocation holds both strings */
+    len = strlen(name) + 1;
+    op->name = malloc(len + (arg ? strlen(arg) + 1 : 0));
+    if (op->name == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: insufficient memory for batch\n");
+	return -ENOMEM;
+    }
+    memcpy(op->name, name, len);
+    if (arg) {
+	op->arg = op->name + len;
+	strcpy(op->arg, arg);
+    }
+    op->kind = kind;
+    op->type = type;
+    op->position = position;
+    if (value) {
+	op->value = *value;
+    }
+    batch_len++;
+    return 0;
 }
 
-hal_list_t *list_next(hal_list_t * entry)
+static void batch_free(void)
 {
-    /* this function is only needed because of memory mapping */
-    return SHMPTR(entry->next);
+    int n;
+
+    for (n = 0; n < batch_len; n++) {
+	free(batch_ops[n].name);
+    }
+    free(batch_ops);
+    batch_ops = 0;
+    batch_len = 0;
+    batch_size = 0;
+    batch_open = 0;
 }
 
-void list_init_entry(hal_list_t * entry)
+static void load_value(hal_type_t type, void *d_ptr, hal_data_u *value)
 {
-    int entry_n;
+    switch (type) {
+    case HAL_BIT:
+	value->b = *((hal_bit_t *) d_ptr);
+	break;
+    case HAL_FLOAT:
+	value->f = *((hal_float_t *) d_ptr);
+	break;
+    case HAL_S32:
+	value->s = *((hal_s32_t *) d_ptr);
+	break;
+    case HAL_U32:
+	value->u = *((hal_u32_t *) d_ptr);
+	break;
+    default:
+	break;
+    }
+}
 
-    entry_n = SHMOFF(entry);
-    entry->next = entry_n;
-    entry->prev = entry_n;
+static void store_value(hal_type_t type, void *d_ptr, const hal_data_u *value)
+{
+    switch (type) {
+    case HAL_BIT:
+	*((hal_bit_t *) d_ptr) = value->b;
+	break;
+    case HAL_FLOAT:
+	*((hal_float_t *) d_ptr) = value->f;
+	break;
+    case HAL_S32:
+	*((hal_s32_t *) d_ptr) = value->s;
+	break;
+    case HAL_U32:
+	*((hal_u32_t *) d_ptr) = value->u;
+	break;
+    default:
+	break;
+    }
 }
 
-void list_add_after(hal_list_t * entry, hal_list_t * prev)
+/* accepts the same value strings as halcmd's 'setp' and 'sets' */
+static int parse_value(hal_type_t type, const char *str, const char *name,
+    hal_data_u *value)
 {
-    int entry_n, prev_n, next_n;
-    hal_list_t *next;
+    char *cp;
 
-    /* messiness needed because of memory mapping */
-    entry_n = SHMOFF(entry);
-    prev_n = SHMOFF(prev);
-    next_n = prev->next;
-    next = SHMPTR(next_n);
-    /* insert the entry */
-    entry->next = next_n;
-    entry->prev = prev_n;
-    prev->next = entry_n;
-    next->prev = entry_n;
+    switch (type) {
+    case HAL_BIT:
+	if ((strcmp("1", str) == 0) || (strcasecmp("TRUE", str) == 0)) {
+	    value->b = 1;
+	    return 0;
+	}
+	if ((strcmp("0", str) == 0) || (strcasecmp("FALSE", str) == 0)) {
+	    value->b = 0;
+	    return 0;
+	}
+	break;
+    case HAL_FLOAT:
+	value->f = strtod(str, &cp);
+	if ((cp != str) && ((*cp == '\0') || isspace(*cp))) {
+	    return 0;
+	}
+	break;
+    case HAL_S32:
+	value->s = strtol(str, &cp, 0);
+	if ((cp != str) && ((*cp == '\0') || isspace(*cp))) {
+	    return 0;
+	}
+	break;
+    case HAL_U32:
+	value->u = strtoul(str, &cp, 0);
+	if ((cp != str) && ((*cp == '\0') || isspace(*cp))) {
+	    return 0;
+	}
+	break;
+    default:
+	break;
+    }
+    rtapi_print_msg(RTAPI_MSG_ERR,
+	"HAL: ERROR: value '%s' invalid for '%s'\n", str, name);
+    return -EINVAL;
 }
 
-void list_add_before(hal_list_t * entry, hal_list_t * next)
+static hal_pin_t *batch_find_pin(batch_index_t *ix, const char *name)
 {
-    int entry_n, prev_n, next_n;
-    hal_list_t *prev;
+    hal_pin_t *pin;
 
-    /* messiness needed because of memory mapping */
-    entry_n = SHMOFF(entry);
-    next_n = SHMOFF(next);
-    prev_n = next->prev;
-    prev = SHMPTR(prev_n);
-    /* insert the entry */
-    entry->next = next_n;
-    entry->prev = prev_n;
-    prev->next = entry_n;
-    next->prev = entry_n;
+    pin = halpr_index_find(&ix->pins, name);
+    if (pin == 0) {
+	/* the index only knows the current names, not old ones */
+	pin = halpr_find_pin_by_name(name);
+    }
+    return pin;
 }
 
-hal_list_t *list_remove_entry(hal_list_t * entry)
+static hal_param_t *batch_find_param(batch_index_t *ix, const char *name)
 {
-    int entry_n;
-    hal_list_t *prev, *next;
+    hal_param_t *param;
 
-    /* messiness needed because of memory mapping */
-    entry_n = SHMOFF(entry);
-    prev = SHMPTR(entry->prev);
-    next = SHMPTR(entry->next);
-    /* remove the entry */
-    prev->next = entry->next;
-    next->prev = entry->prev;
-    entry->next = entry_n;
-    entry->prev = entry_n;
-    return next;
+    param = halpr_index_find(&ix->params, name);
+    if (param == 0) {
+	param = halpr_find_param_by_name(name);
+    }
+    return param;
 }
 
-hal_comp_t *halpr_find_comp_by_name(const char *name)
+/* makes a value change, remembering the old value */
+static void batch_store(batch_op_t *op, hal_type_t type, void *d_ptr,
+    const hal_data_u *value)
 {
-    int next;
-    hal_comp_t *comp;
+    op->data = d_ptr;
+    op->data_type = type;
+    load_value(type, d_ptr, &(op->old_value));
+    store_value(type, d_ptr, value);
+}
 
-    /* search component list for 'name' */
-    next = hal_data->comp_list_ptr;
-    while (next != 0) {
-	comp = SHMPTR(next);
-	if (strcmp(comp->name, name) == 0) {
-	    /* found a match */
-	    return comp;
+static int batch_link(batch_op_t *op, batch_index_t *ix)
+{
+    hal_pin_t *pin;
+    hal_sig_t *sig;
+    int retval;
+
+    pin = batch_find_pin(ix, op->name);
+    if (pin == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: pin '%s' not found\n", op->name);
+	return -EINVAL;
+    }
+    sig = halpr_index_find(&ix->sigs, op->arg);
+    if ((sig == 0) && (op->kind == BATCH_NET)) {
+	/* create the signal with the type of its first pin */
+	if (strlen(op->arg) > HAL_NAME_LEN) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: signal name '%s' is too long\n", op->arg);
+	    return -EINVAL;
 	}
-	/* didn't find it yet, look at next one */
-	next = comp->next_ptr;
+	retval = new_signal(op->arg, pin->type, &(op->new_sig));
+	if (retval != 0) {
+	    return retval;
+	}
+	halpr_index_add(&ix->sigs, op->new_sig);
+	sig = op->new_sig;
     }
-    /* if loop terminates, we reached end of list with no match */
-    return 0;
+    if (sig == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: signal '%s' not found\n", op->arg);
+	return -EINVAL;
+    }
+    if (SHMPTR(pin->signal) == sig) {
+	/* already linked, nothing to take back */
+	return link_pin(pin, sig);
+    }
+    op->old_value = pin->dummysig;
+    op->old_sig_value = *((hal_data_u *) SHMPTR(sig->data_ptr));
+    retval = link_pin(pin, sig);
+    if (retval == 0) {
+	op->pin = pin;
+    }
+    return retval;
 }
 
-hal_pin_t *halpr_find_pin_by_name(const char *name)
+static int batch_apply(batch_op_t *op, batch_index_t *ix)
 {
-    int next;
     hal_pin_t *pin;
-    hal_oldname_t *oldname;
-
+    hal_param_t *param;
+    hal_sig_t *sig;
+    hal_funct_t *funct;
+    hal_thread_t *thread;
+    hal_data_u value;
+    int retval;
+
+    switch (op->kind) {
+    case BATCH_NEWSIG:
+	if (halpr_index_find(&ix->sigs, op->name) != 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: duplicate signal '%s'\n", op->name);
+	    return -EINVAL;
+	}
+	retval = new_signal(op->name, op->type, &(op->new_sig));
+	if (retval == 0) {
+	    halpr_index_add(&ix->sigs, op->new_sig);
+	}
+	return retval;
+    case BATCH_LINK:
+    case BATCH_NET:
+	return batch_link(op, ix);
+    case BATCH_ADDF:
+	funct = halpr_index_find(&ix->functs, op->name);
+	if (funct == 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: function '%s' not found\n", op->name);
+	    return -EINVAL;
+	}
+	thread = halpr_find_thread_by_name(op->arg);
+	if (thread == 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: thread '%s' not found\n", op->arg);
+	    return -EINVAL;
+	}
+	return add_funct_entry(funct, thread, op->position, &(op->entry));
+    case BATCH_PARAM:
+	param = batch_find_param(ix, op->name);
+	if (param == 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: parameter '%s' not found\n", op->name);
+	    return -EINVAL;
+	}
+	load_value(param->type, SHMPTR(param->data_ptr), &value);
+	retval = set_param_value(param, op->type, &(op->value));
+	if (retval == 0) {
+	    op->data = SHMPTR(param->data_ptr);
+	    op->data_type = param->type;
+	    op->old_value = value;
+	}
+	return retval;
+    case BATCH_SETP:
+	param = batch_find_param(ix, op->name);
+	if (param != 0) {
+	    if (param->dir == HAL_RO) {
+		rtapi_print_msg(RTAPI_MSG_ERR,
+		    "HAL: ERROR: param '%s' is not writable\n", op->name);
+		return -EINVAL;
+	    }
+	    retval = parse_value(param->type, op->arg, op->name, &value);
+	    if (retval == 0) {
+		batch_store(op, param->type, SHMPTR(param->data_ptr), &value);
+	    }
+	    return retval;
+	}
+	pin = batch_find_pin(ix, op->name);
+	if (pin == 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: parameter or pin '%s' not found\n", op->name);
+	    return -EINVAL;
+	}
+	if (pin->dir == HAL_OUT) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: pin '%s' is not writable\n", op->name);
+	    return -EINVAL;
+	}
+	if (pin->signal != 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: pin '%s' is connected to a signal\n", op->name);
+	    return -EINVAL;
+	}
+	retval = parse_value(pin->type, op->arg, op->name, &value);
+	if (retval == 0) {
+	    batch_store(op, pin->type, &(pin->dummysig), &value);
+	}
+	return retval;
+    case BATCH_SETS:
+	sig = halpr_index_find(&ix->sigs, op->name);
+	if (sig == 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: signal '%s' not found\n", op->name);
+	    return -EINVAL;
+	}
+	if (sig->writers > 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: signal '%s' already has writer(s)\n", op->name);
+	    return -EINVAL;
+	}
+	retval = parse_value(sig->type, op->arg, op->name, &value);
+	if (retval == 0) {
+	    batch_store(op, sig->type, SHMPTR(sig->data_ptr), &value);
+	}
+	return retval;
+    }
+    return -EINVAL;
+}
+
+/* takes back whatever batch_apply() did for 'op' */
+static void batch_undo(batch_op_t *op)
+{
+    rtapi_intptr_t *prev;
+    hal_sig_t *sig;
+
+    if (op->pin) {
+	sig = SHMPTR(op->pin->signal);
+	unlink_pin(op->pin);
+	op->pin->dummysig = op->old_value;
+	*((hal_data_u *) SHMPTR(sig->data_ptr)) = op->old_sig_value;
+    }
+    if (op->new_sig) {
+	/* all its links have been taken back, remove it from the list */
+	prev = &(hal_data->sig_list_ptr);
+	while (*prev != SHMOFF(op->new_sig)) {
+	    sig = SHMPTR(*prev);
+	    prev = &(sig->next_ptr);
+	}
+	*prev = op->new_sig->next_ptr;
+	free_sig_struct(op->new_sig);
+    }
+    if (op->entry) {
+	list_remove_entry((hal_list_t *) op->entry);
+	free_funct_entry_struct(op->entry);
+    }
+    if (op->data) {
+	store_value(op->data_type, op->data, &(op->old_value));
+    }
+}
+
+int hal_begin_batch(void)
+{
+    if (hal_data == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: begin_batch called before init\n");
+	return -EINVAL;
+    }
+    if (batch_open) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: a batch is already open\n");
+	return -EBUSY;
+    }
+    batch_open = 1;
+    return 0;
+}
+
+int hal_batch_active(void)
+{
+    return batch_open;
+}
+
+int hal_batch_net(const char *sig_name, const char *pin_name)
+{
+    if (!batch_open) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: batch_net called without a batch\n");
+	return -EINVAL;
+    }
+    if ((sig_name == 0) || (pin_name == 0)) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: pin or signal name not given\n");
+	return -EINVAL;
+    }
+    return batch_queue(BATCH_NET, pin_name, sig_name, 0, 0, NULL);
+}
+
+int hal_batch_setp(const char *name, const char *value)
+{
+    if (!batch_open) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: batch_setp called without a batch\n");
+	return -EINVAL;
+    }
+    return batch_queue(BATCH_SETP, name, value, 0, 0, NULL);
+}
+
+int hal_batch_sets(const char *name, const char *value)
+{
+    if (!batch_open) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: batch_sets called without a batch\n");
+	return -EINVAL;
+    }
+    return batch_queue(BATCH_SETS, name, value, 0, 0, NULL);
+}
+
+int hal_abort_batch(void)
+{
+    if (!batch_open) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: abort_batch called without a batch\n");
+	return -EINVAL;
+    }
+    rtapi_print_msg(RTAPI_MSG_DBG,
+	"HAL: discarding batch of %d changes\n", batch_len);
+    batch_free();
+    return 0;
+}
+
+int hal_commit_batch(void)
+{
+    batch_index_t ix;
+    batch_op_t *op;
+    int n, new_sigs = 0, config = 0, values = 0, retval;
+
+    if (!batch_open) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: commit_batch called without a batch\n");
+	return -EINVAL;
+    }
+    for (op = batch_ops; op < batch_ops + batch_len; op++) {
+	if ((op->kind == BATCH_NEWSIG) || (op->kind == BATCH_NET)) {
+	    new_sigs++;
+	}
+	if ((op->kind == BATCH_PARAM) || (op->kind == BATCH_SETP)
+	    || (op->kind == BATCH_SETS)) {
+	    values = 1;
+	} else {
+	    config = 1;
+	}
+    }
+    if ((config && (hal_data->lock & HAL_LOCK_CONFIG))
+	|| (values && (hal_data->lock & HAL_LOCK_PARAMS))) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: commit_batch called while HAL locked\n");
+	batch_free();
+	return -EPERM;
+    }
+    rtapi_print_msg(RTAPI_MSG_DBG,
+	"HAL: committing batch of %d changes\n", batch_len);
+    memset(&ix, 0, sizeof(ix));
+    /* get mutex before accessing shared data, and keep it until the
+       whole batch is either applied or taken back */
+    rtapi_mutex_get(&(hal_data->mutex));
+    retval = halpr_index_build(&ix.pins, hal_data->pin_list_ptr,
+	offsetof(hal_pin_t, name), 0);
+    if (retval == 0) retval = halpr_index_build(&ix.params,
+	hal_data->param_list_ptr, offsetof(hal_param_t, name), 0);
+    if (retval == 0) retval = halpr_index_build(&ix.sigs,
+	hal_data->sig_list_ptr, offsetof(hal_sig_t, name), new_sigs);
+    if (retval == 0) retval = halpr_index_build(&ix.functs,
+	hal_data->funct_list_ptr, offsetof(hal_funct_t, name), 0);
+    if (retval != 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: insufficient memory for batch\n");
+    }
+    n = 0;
+    while ((retval == 0) && (n < batch_len)) {
+	retval = batch_apply(&batch_ops[n++], &ix);
+    }
+    if (retval != 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: batch failed at change %d of %d, rolling back\n",
+	    n, batch_len);
+	/* newest first; the failed change may have been made in part */
+	while (n > 0) {
+	    batch_undo(&batch_ops[--n]);
+	}
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    halpr_index_free(&ix.pins);
+    halpr_index_free(&ix.params);
+    halpr_index_free(&ix.sigs);
+    halpr_index_free(&ix.functs);
+    batch_free();
+    return retval;
+}
+#endif /* ULAPI */
+
+/***********************************************************************
+*                    PRIVATE FUNCTION CODE                             *
+************************************************************************/
+
+hal_list_t *list_prev(hal_list_t * entry)
+{
+    /* this function is only needed because of memory mapping */
+    return SHMPTR(entry->prev);
+}
+
+hal_list_t *list_next(hal_list_t * entry)
+{
+    /* this function is only needed because of memory mapping */
+    return SHMPTR(entry->next);
+}
+
+void list_init_entry(hal_list_t * entry)
+{
+    int entry_n;
+
+    entry_n = SHMOFF(entry);
+    entry->next = entry_n;
+    entry->prev = entry_n;
+}
+
+void list_add_after(hal_list_t * entry, hal_list_t * prev)
+{
+    int entry_n, prev_n, next_n;
+    hal_list_t *next;
+
+    /* messiness needed because of memory mapping */
+    entry_n = SHMOFF(entry);
+    prev_n = SHMOFF(prev);
+    next_n = prev->next;
+    next = SHMPTR(next_n);
+    /* insert the entry */
+    entry->next = next_n;
+    entry->prev = prev_n;
+    prev->next = entry_n;
+    next->prev = entry_n;
+}
+
+void list_add_before(hal_list_t * entry, hal_list_t * next)
+{
+    int entry_n, prev_n, next_n;
+    hal_list_t *prev;
+
+    /* messiness needed because of memory mapping */
+    entry_n = SHMOFF(entry);
+    next_n = SHMOFF(next);
+    prev_n = next->prev;
+    prev = SHMPTR(prev_n);
+    /* insert the entry */
+    entry->next = next_n;
+    entry->prev = prev_n;
+    prev->next = entry_n;
+    next->prev = entry_n;
+}
+
+hal_list_t *list_remove_entry(hal_list_t * entry)
+{
+    int entry_n;
+    hal_list_t *prev, *next;
+
+    /* messiness needed because of memory mapping */
+    entry_n = SHMOFF(entry);
+    prev = SHMPTR(entry->prev);
+    next = SHMPTR(entry->next);
+    /* remove the entry */
+    prev->next = entry->next;
+    next->prev = entry->prev;
+    entry->next = entry_n;
+    entry->prev = entry_n;
+    return next;
+}
+
+hal_comp_t *halpr_find_comp_by_name(const char *name)
+{
+    int next;
+    hal_comp_t *comp;
+
+    /* search component list for 'name' */
+    next = hal_data->comp_list_ptr;
+    while (next != 0) {
+	comp = SHMPTR(next);
+	if (strcmp(comp->name, name) == 0) {
+	    /* found a match */
+	    return comp;
+	}
+	/* didn't find it yet, look at next one */
+	next = comp->next_ptr;
+    }
+    /* if loop terminates, we reached end of list with no match */
+    return 0;
+}
+
+hal_pin_t *halpr_find_pin_by_name(const char *name)
+{
+    int next;
+    hal_pin_t *pin;
+    hal_oldname_t *oldname;
+
     /* search pin list for 'name' */
     next = hal_data->pin_list_ptr;
     while (next != 0) {
@@ -2589,6 +2952,75 @@ hal_pin_t *halpr_find_pin_by_sig(hal_sig_t * sig, hal_pin_t * start)
     return 0;
 }
 
+#ifdef ULAPI
+static unsigned index_hash(const char *s)
+{
+    unsigned h = 2166136261u;
+
+    /* FNV-1a */
+    while (*s) {
+	h ^= (unsigned char) *s++;
+	h *= 16777619u;
+    }
+    return h;
+}
+
+int halpr_index_build(halpr_index_t *ix, rtapi_intptr_t list,
+    size_t name_offset, int extra)
+{
+    rtapi_intptr_t next;
+    unsigned n = extra, size = 16;
+
+    for (next = list; next != 0; next = *(rtapi_intptr_t *) SHMPTR(next)) {
+	n++;
+    }
+    /* keep the table at most half full */
+    while (size < 2 * n) {
+	size *= 2;
+    }
+    ix->objs = calloc(size, sizeof(void *));
+    if (ix->objs == 0) {
+	return -ENOMEM;
+    }
+    ix->mask = size - 1;
+    ix->name_offset = name_offset;
+    for (next = list; next != 0; next = *(rtapi_intptr_t *) SHMPTR(next)) {
+	halpr_index_add(ix, SHMPTR(next));
+    }
+    return 0;
+}
+
+void halpr_index_add(halpr_index_t *ix, void *obj)
+{
+    unsigned h;
+
+    h = index_hash((char *) obj + ix->name_offset) & ix->mask;
+    while (ix->objs[h] != 0) {
+	h = (h + 1) & ix->mask;
+    }
+    ix->objs[h] = obj;
+}
+
+void *halpr_index_find(halpr_index_t *ix, const char *name)
+{
+    unsigned h;
+
+    for (h = index_hash(name) & ix->mask; ix->objs[h] != 0;
+	    h = (h + 1) & ix->mask) {
+	if (strcmp((char *) ix->objs[h] + ix->name_offset, name) == 0) {
+	    return ix->objs[h];
+	}
+    }
+    return 0;
+}
+
+void halpr_index_free(halpr_index_t *ix)
+{
+    free(ix->objs);
+    ix->objs = 0;
+}
+#endif /* ULAPI */
+
 /***********************************************************************
 *                     LOCAL FUNCTION CODE                              *
 ************************************************************************/
@@ -2730,6 +3162,7 @@ static void thread_task(void *arg)
     hal_funct_entry_t *funct_root, *funct_entry;
     long long int start_time, end_time;
     long long int thread_start_time;
+    long overruns;
 
     thread = arg;
     while (1) {
@@ -2767,6 +3200,10 @@ static void thread_task(void *arg)
 	    if ( *(thread->runtime) > thread->maxtime) {
 	        thread->maxtime = *(thread->runtime);
 	    }
+	    overruns = rtapi_task_overruns(thread->task_id);
+	    if (overruns >= 0) {
+		*(thread->overruns) = (hal_s32_t)overruns;
+	    }
 	}
 	/* wait until next period */
 	rtapi_wait();
@@ -2806,53 +3243,29 @@ static int init_hal_data(void)
     hal_data->threads_running = 0;
     hal_data->oldname_free_ptr = 0;
     hal_data->comp_free_ptr = 0;
-    hal_data->pin_free_ptr = 0;
     hal_data->sig_free_ptr = 0;
-    hal_data->param_free_ptr = 0;
     hal_data->funct_free_ptr = 0;
     hal_data->pending_constructor = 0;
     hal_data->constructor_prefix[0] = 0;
     list_init_entry(&(hal_data->funct_entry_free));
     hal_data->thread_free_ptr = 0;
     hal_data->exact_base_period = 0;
-    /* set up for shmalloc_xx() */
-    hal_data->shmem_bot = sizeof(hal_data_t);
+    /* set up for shmalloc_dn() and the pages */
+    hal_data->page_base = (sizeof(hal_data_t) + 7) & (~7);
+    hal_data->free_run_ptr = 0;
+    hal_data->pages_free = 0;
+    hal_data->shared_slab_ptr = 0;
+    hal_data->watch_list_ptr = 0;
+    hal_data->watch_scanners = 0;
+    hal_data->shmem_bot = hal_data->page_base;
     hal_data->shmem_top = HAL_SIZE;
+    hal_data->shmem_avail = hal_data->shmem_top - hal_data->shmem_bot;
     hal_data->lock = HAL_LOCK_NONE;
     /* done, release mutex */
     rtapi_mutex_give(&(hal_data->mutex));
     return 0;
 }
 
-static void *shmalloc_up(long int size)
-{
-    long int tmp_bot;
-    void *retval;
-
-    /* deal with alignment requirements */
-    tmp_bot = hal_data->shmem_bot;
-    if (size >= 8) {
-	/* align on 8 byte boundary */
-	tmp_bot = (tmp_bot + 7) & (~7);
-    } else if (size >= 4) {
-	/* align on 4 byte boundary */
-	tmp_bot = (tmp_bot + 3) & (~3);
-    } else if (size == 2) {
-	/* align on 2 byte boundary */
-	tmp_bot = (tmp_bot + 1) & (~1);
-    }
-    /* is there enough memory available? */
-    if ((hal_data->shmem_top - tmp_bot) < size) {
-	/* no */
-	return 0;
-    }
-    /* memory is available, allocate it */
-    retval = SHMPTR(tmp_bot);
-    hal_data->shmem_bot = tmp_bot + size;
-    hal_data->shmem_avail = hal_data->shmem_top - hal_data->shmem_bot;
-    return retval;
-}
-
 static void *shmalloc_dn(long int size)
 {
     long int tmp_top;
@@ -2879,10 +3292,235 @@ static void *shmalloc_dn(long int size)
     /* memory is available, allocate it */
     retval = SHMPTR(tmp_top);
     hal_data->shmem_top = tmp_top;
-    hal_data->shmem_avail = hal_data->shmem_top - hal_data->shmem_bot;
+    hal_data->shmem_avail = hal_data->shmem_top - hal_data->shmem_bot +
+	hal_data->pages_free * HAL_PAGE_SIZE;
     return retval;
 }
 
+/* block sizes of the slabs, the last one is HAL_SLAB_MAX */
+static const int slab_sizes[] = {
+    8, 16, 32, 48, 64, 96, 128, 192, 256, 320, HAL_SLAB_MAX
+};
+
+/* the head of the list of runs that belong to 'owner' */
+static rtapi_intptr_t *slab_list(hal_comp_t * owner)
+{
+    if (owner == 0) {
+	return &(hal_data->shared_slab_ptr);
+    }
+    return &(owner->slab_ptr);
+}
+
+/* takes a run of 'pages' pages, first fit from the free runs, else
+   from the bottom of free shmem */
+static hal_slab_t *alloc_pages(int pages)
+{
+    rtapi_intptr_t *prev, next;
+    hal_slab_t *run, *rest;
+    long int size;
+
+    size = (long int) pages * HAL_PAGE_SIZE;
+    prev = &(hal_data->free_run_ptr);
+    next = *prev;
+    while (next != 0) {
+	run = SHMPTR(next);
+	if (run->pages >= pages) {
+	    if (run->pages > pages) {
+		/* split it, the rest stays on the free list */
+		rest = SHMPTR(next + size);
+		rest->pages = run->pages - pages;
+		rest->next_ptr = run->next_ptr;
+		*prev = SHMOFF(rest);
+	    } else {
+		*prev = run->next_ptr;
+	    }
+	    hal_data->pages_free -= pages;
+	    hal_data->shmem_avail -= size;
+	    run->pages = pages;
+	    return run;
+	}
+	prev = &(run->next_ptr);
+	next = *prev;
+    }
+    if ((hal_data->shmem_top - hal_data->shmem_bot) < size) {
+	/* out of memory */
+	return 0;
+    }
+    run = SHMPTR(hal_data->shmem_bot);
+    hal_data->shmem_bot += size;
+    hal_data->shmem_avail -= size;
+    run->pages = pages;
+    return run;
+}
+
+/* puts 'run' back on the free list, merging it with its neighbours;
+   a free run that ends at the bottom of free shmem goes back there */
+static void free_pages(hal_slab_t * run)
+{
+    rtapi_intptr_t *prev, *before_prev, off;
+    hal_slab_t *before, *after;
+
+    hal_data->pages_free += run->pages;
+    hal_data->shmem_avail += (long int) run->pages * HAL_PAGE_SIZE;
+    /* find its place in the list */
+    off = SHMOFF(run);
+    before = 0;
+    before_prev = 0;
+    prev = &(hal_data->free_run_ptr);
+    while ((*prev != 0) && (*prev < off)) {
+	before_prev = prev;
+	before = SHMPTR(*prev);
+	prev = &(before->next_ptr);
+    }
+    run->next_ptr = *prev;
+    *prev = off;
+    if (run->next_ptr == off + run->pages * HAL_PAGE_SIZE) {
+	after = SHMPTR(run->next_ptr);
+	run->pages += after->pages;
+	run->next_ptr = after->next_ptr;
+    }
+    if ((before != 0) &&
+	(SHMOFF(before) + before->pages * HAL_PAGE_SIZE == off)) {
+	before->pages += run->pages;
+	before->next_ptr = run->next_ptr;
+	run = before;
+	prev = before_prev;
+    }
+    if (SHMOFF(run) + run->pages * HAL_PAGE_SIZE == hal_data->shmem_bot) {
+	/* it is the last run, and borders on free shmem */
+	*prev = 0;
+	hal_data->shmem_bot = SHMOFF(run);
+	hal_data->pages_free -= run->pages;
+    }
+}
+
+static void *slab_alloc(hal_comp_t * owner, long int size)
+{
+    rtapi_intptr_t *list, next;
+    hal_slab_t *slab;
+    int *block;
+    int n, off;
+
+    list = slab_list(owner);
+    if (size > HAL_SLAB_MAX) {
+	/* too big for a slab, it gets a run of its own */
+	slab = alloc_pages((size + sizeof(hal_slab_t) + HAL_PAGE_SIZE - 1) /
+	    HAL_PAGE_SIZE);
+	if (slab == 0) {
+	    return 0;
+	}
+	slab->owner_ptr = owner ? SHMOFF(owner) : 0;
+	slab->block_size = 0;
+	slab->used = 1;
+	slab->free_ptr = 0;
+	slab->next_ptr = *list;
+	*list = SHMOFF(slab);
+	memset(slab + 1, 0, size);
+	return slab + 1;
+    }
+    n = 0;
+    while (slab_sizes[n] < size) {
+	n++;
+    }
+    /* look for a slab of that size with a free block */
+    next = *list;
+    while (next != 0) {
+	slab = SHMPTR(next);
+	if ((slab->block_size == slab_sizes[n]) && (slab->free_ptr != 0)) {
+	    break;
+	}
+	next = slab->next_ptr;
+    }
+    if (next == 0) {
+	/* none, start a new one */
+	slab = alloc_pages(1);
+	if (slab == 0) {
+	    return 0;
+	}
+	slab->owner_ptr = owner ? SHMOFF(owner) : 0;
+	slab->block_size = slab_sizes[n];
+	slab->used = 0;
+	/* chain all blocks, lowest address first */
+	slab->free_ptr = 0;
+	off = sizeof(hal_slab_t) +
+	    ((HAL_PAGE_SIZE - sizeof(hal_slab_t)) / slab->block_size - 1) *
+	    slab->block_size;
+	while (off >= (int) sizeof(hal_slab_t)) {
+	    block = (int *) ((char *) slab + off);
+	    *block = slab->free_ptr;
+	    slab->free_ptr = SHMOFF(block);
+	    off -= slab->block_size;
+	}
+	slab->next_ptr = *list;
+	*list = SHMOFF(slab);
+    }
+    block = SHMPTR(slab->free_ptr);
+    slab->free_ptr = *block;
+    slab->used++;
+    memset(block, 0, slab->block_size);
+    return block;
+}
+
+static void slab_free(void *block)
+{
+    rtapi_intptr_t *prev, off;
+    hal_slab_t *slab;
+
+    /* the header is at the start of the block's page */
+    off = SHMOFF(block) - hal_data->page_base;
+    slab = SHMPTR(hal_data->page_base + (off & ~(HAL_PAGE_SIZE - 1)));
+    slab->used--;
+    if (slab->block_size != 0) {
+	*((int *) block) = slab->free_ptr;
+	slab->free_ptr = SHMOFF(block);
+    }
+    if (slab->used > 0) {
+	return;
+    }
+    /* nothing left in use, unlink it from its owner and free it */
+    prev = slab_list(slab->owner_ptr ? SHMPTR(slab->owner_ptr) : 0);
+    while (*prev != SHMOFF(slab)) {
+	prev = &(((hal_slab_t *) SHMPTR(*prev))->next_ptr);
+    }
+    *prev = slab->next_ptr;
+    free_pages(slab);
+}
+
+static void free_slabs(hal_comp_t * comp)
+{
+    hal_slab_t *slab;
+
+    while (comp->slab_ptr != 0) {
+	slab = SHMPTR(comp->slab_ptr);
+	comp->slab_ptr = slab->next_ptr;
+	free_pages(slab);
+    }
+}
+
+static hal_comp_t *malloc_owner(void)
+{
+    rtapi_intptr_t next;
+    hal_comp_t *comp;
+
+    /* newest first, so a component that creates another one while it
+       initializes (a thread, for example) gets its memory back */
+    next = hal_data->comp_list_ptr;
+    while (next != 0) {
+	comp = SHMPTR(next);
+#ifdef RTAPI
+	if (!comp->ready && (comp->type == 1)) {
+	    return comp;
+	}
+#else /* ULAPI */
+	if (!comp->ready && (comp->type == 0) && (comp->pid == getpid())) {
+	    return comp;
+	}
+#endif
+	next = comp->next_ptr;
+    }
+    return 0;
+}
+
 hal_comp_t *halpr_alloc_comp_struct(void)
 {
     hal_comp_t *p;
@@ -2905,38 +3543,18 @@ hal_comp_t *halpr_alloc_comp_struct(void)
 	p->mem_id = 0;
 	p->type = 0;
 	p->shmem_base = 0;
+	p->insmod_args = 0;
+	p->slab_ptr = 0;
 	p->name[0] = '\0';
     }
     return p;
 }
 
-static hal_pin_t *alloc_pin_struct(void)
+static hal_pin_t *alloc_pin_struct(hal_comp_t * owner)
 {
-    hal_pin_t *p;
-
-    /* check the free list */
-    if (hal_data->pin_free_ptr != 0) {
-	/* found a free structure, point to it */
-	p = SHMPTR(hal_data->pin_free_ptr);
-	/* unlink it from the free list */
-	hal_data->pin_free_ptr = p->next_ptr;
-	p->next_ptr = 0;
-    } else {
-	/* nothing on free list, allocate a brand new one */
-	p = shmalloc_dn(sizeof(hal_pin_t));
-    }
-    if (p) {
-	/* make sure it's empty */
-	p->next_ptr = 0;
-	p->data_ptr_addr = 0;
-	p->owner_ptr = 0;
-	p->type = 0;
-	p->dir = 0;
-	p->signal = 0;
-	memset(&p->dummysig, 0, sizeof(hal_data_u));
-	p->name[0] = '\0';
-    }
-    return p;
+    /* pins live in their component's pages, so the dummy signals of
+       unlinked pins sit next to the component's own data */
+    return slab_alloc(owner, sizeof(hal_pin_t));
 }
 
 static hal_sig_t *alloc_sig_struct(void)
@@ -2967,30 +3585,9 @@ static hal_sig_t *alloc_sig_struct(void)
     return p;
 }
 
-static hal_param_t *alloc_param_struct(void)
+static hal_param_t *alloc_param_struct(hal_comp_t * owner)
 {
-    hal_param_t *p;
-
-    /* check the free list */
-    if (hal_data->param_free_ptr != 0) {
-	/* found a free structure, point to it */
-	p = SHMPTR(hal_data->param_free_ptr);
-	/* unlink it from the free list */
-	hal_data->param_free_ptr = p->next_ptr;
-	p->next_ptr = 0;
-    } else {
-	/* nothing on free list, allocate a brand new one */
-	p = shmalloc_dn(sizeof(hal_param_t));
-    }
-    if (p) {
-	/* make sure it's empty */
-	p->next_ptr = 0;
-	p->data_ptr = 0;
-	p->owner_ptr = 0;
-	p->type = 0;
-	p->name[0] = '\0';
-    }
-    return p;
+    return slab_alloc(owner, sizeof(hal_param_t));
 }
 
 static hal_oldname_t *halpr_alloc_oldname_struct(void)
@@ -3165,6 +3762,16 @@ static void free_comp_struct(hal_comp_t * comp)
 	}
 	next = *prev;
     }
+    /* free its memory, including the args string that halcmd added */
+    if (comp->insmod_args != 0) {
+	slab_free(SHMPTR(comp->insmod_args));
+	comp->insmod_args = 0;
+    }
+    if (watch_remove_owned(comp) == 0) {
+	free_slabs(comp);
+    }
+    /* otherwise a scan may still be in one of its watches, so its
+       memory is leaked rather than handed to the next component */
     /* now we can delete the component itself */
     /* clear contents of struct */
     comp->comp_id = 0;
@@ -3177,77 +3784,368 @@ static void free_comp_struct(hal_comp_t * comp)
     hal_data->comp_free_ptr = SHMOFF(comp);
 }
 
-static void unlink_pin(hal_pin_t * pin)
+static void unlink_pin(hal_pin_t * pin)
+{
+    hal_sig_t *sig;
+    hal_comp_t *comp;
+    void **data_ptr_addr;
+    hal_data_u *dummy_addr, *sig_data_addr;
+
+    /* is this pin linked to a signal? */
+    if (pin->signal != 0) {
+	/* yes, need to unlink it */
+	sig = SHMPTR(pin->signal);
+	/* make pin's 'data_ptr' point to its dummy signal */
+	data_ptr_addr = SHMPTR(pin->data_ptr_addr);
+	comp = SHMPTR(pin->owner_ptr);
+	dummy_addr = comp->shmem_base + SHMOFF(&(pin->dummysig));
+	*data_ptr_addr = dummy_addr;
+
+	/* copy current signal value to dummy */
+	sig_data_addr = (hal_data_u *)(hal_shmem_base + sig->data_ptr);
+	dummy_addr = (hal_data_u *)(hal_shmem_base + SHMOFF(&(pin->dummysig)));
+
+	switch (pin->type) {
+	case HAL_BIT:
+	    dummy_addr->b = sig_data_addr->b;
+	    break;
+	case HAL_S32:
+	    dummy_addr->s = sig_data_addr->s;
+	    break;
+	case HAL_U32:
+	    dummy_addr->u = sig_data_addr->u;
+	    break;
+	case HAL_FLOAT:
+	    dummy_addr->f = sig_data_addr->f;
+	    break;
+	default:
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+			  "HAL: BUG: pin '%s' has invalid type %d !!\n",
+			  pin->name, pin->type);
+	}
+
+	/* update the signal's reader/writer counts */
+	if ((pin->dir & HAL_IN) != 0) {
+	    sig->readers--;
+	}
+	if (pin->dir == HAL_OUT) {
+	    sig->writers--;
+	}
+	if (pin->dir == HAL_IO) {
+	    sig->bidirs--;
+	}
+	/* mark pin as unlinked */
+	pin->signal = 0;
+    }
+}
+
+static int new_signal(const char *name, hal_type_t type, hal_sig_t **sig)
+{
+    rtapi_intptr_t *prev, next;
+    int cmp;
+    hal_sig_t *new, *ptr;
+    void *data_addr;
+
+    /* allocate memory for the signal value */
+/*
+because accesses will later be through pointer of type hal_data_u,
+allocate something that big.  Otherwise, gcc -fsanitize=undefined will
+issue diagnostics like
+    hal/hal_lib.c:3203:35: runtime error: member access within misaligned address 0x7fcf3d11f10b for type 'union hal_data_u', which requires 8 byte alignment
+on accesses through hal_data_u.
+
+This does increase memory usage somewhat, but is required for compliance
+with the C standard.
+*/
+    switch (type) {
+    case HAL_BIT:
+    case HAL_S32:
+    case HAL_U32:
+    case HAL_FLOAT:
+        data_addr = slab_alloc(0, sizeof(hal_data_u));
+	break;
+    default:
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: illegal signal type %d'\n", type);
+	return -EINVAL;
+	break;
+    }
+    /* allocate a new signal structure */
+    new = alloc_sig_struct();
+    if ((new == 0) || (data_addr == 0)) {
+	/* alloc failed */
+	if (data_addr != 0) {
+	    slab_free(data_addr);
+	}
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: insufficient memory for signal '%s'\n", name);
+	return -ENOMEM;
+    }
+    /* initialize the signal value */
+    switch (type) {
+    case HAL_BIT:
+	*((hal_bit_t *) data_addr) = 0;
+	break;
+    case HAL_S32:
+	*((hal_s32_t *) data_addr) = 0;
+        break;
+    case HAL_U32:
+	*((hal_u32_t *) data_addr) = 0;
+        break;
+    case HAL_FLOAT:
+	*((hal_float_t *) data_addr) = 0.0;
+	break;
+    default:
+	break;
+    }
+    /* initialize the structure */
+    new->data_ptr = SHMOFF(data_addr);
+    new->type = type;
+    new->readers = 0;
+    new->writers = 0;
+    new->bidirs = 0;
+    rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
+    /* search list for 'name' and insert new structure */
+    prev = &(hal_data->sig_list_ptr);
+    next = *prev;
+    while (next != 0) {
+	ptr = SHMPTR(next);
+	cmp = strcmp(ptr->name, new->name);
+	if (cmp > 0) {
+	    /* found the right place for it, insert here */
+	    break;
+	}
+	/* didn't find it yet, look at next one */
+	prev = &(ptr->next_ptr);
+	next = *prev;
+    }
+    new->next_ptr = next;
+    *prev = SHMOFF(new);
+    if (sig) {
+	*sig = new;
+    }
+    return 0;
+}
+
+static int link_pin(hal_pin_t *pin, hal_sig_t *sig)
+{
+    hal_sig_t *old_sig;
+    hal_comp_t *comp;
+    void **data_ptr_addr, *data_addr;
+
+    /* found both pin and signal, are they already connected? */
+    if (SHMPTR(pin->signal) == sig) {
+	rtapi_print_msg(RTAPI_MSG_WARN,
+	    "HAL: Warning: pin '%s' already linked to '%s'\n", pin->name, sig->name);
+	return 0;
+    }
+    /* is the pin connected to something else? */
+    if(pin->signal) {
+	old_sig = SHMPTR(pin->signal);
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: pin '%s' is linked to '%s', cannot link to '%s'\n",
+	    pin->name, old_sig->name, sig->name);
+	return -EINVAL;
+    }
+    /* check types */
+    if (pin->type != sig->type) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: type mismatch '%s' <- '%s'\n", pin->name, sig->name);
+	return -EINVAL;
+    }
+    /* linking output pin to sig that already has output or I/O pins? */
+    if ((pin->dir == HAL_OUT) && ((sig->writers > 0) || (sig->bidirs > 0 ))) {
+	/* yes, can't do that */
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: signal '%s' already has output or I/O pin(s)\n", sig->name);
+	return -EINVAL;
+    }
+    /* linking bidir pin to sig that already has output pin? */
+    if ((pin->dir == HAL_IO) && (sig->writers > 0)) {
+	/* yes, can't do that */
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: signal '%s' already has output pin\n", sig->name);
+	return -EINVAL;
+    }
+    /* everything is OK, make the new link */
+    data_ptr_addr = SHMPTR(pin->data_ptr_addr);
+    comp = SHMPTR(pin->owner_ptr);
+    data_addr = comp->shmem_base + sig->data_ptr;
+    *data_ptr_addr = data_addr;
+    bool drive_pin_default_value_onto_signal =
+        ( pin->dir != HAL_IN || sig->readers == 0 )
+            && ( sig->writers == 0 ) && ( sig->bidirs == 0 );
+    if (drive_pin_default_value_onto_signal) {
+	/* this is the first pin for this signal, copy value from pin's "dummy" field */
+	data_addr = hal_shmem_base + sig->data_ptr;
+
+        // assure proper typing on assignment, assigning a hal_data_u is
+        // a surefire cause for memory corrupion as hal_data_u is larger
+        // than hal_bit_t, hal_s32_t, and hal_u32_t - this works only for 
+        // hal_float_t (!)
+        // my old, buggy code:
+        //*((hal_data_u *)data_addr) = pin->dummysig;
+
+        switch (pin->type) {
+        case HAL_BIT:
+            *((hal_bit_t *) data_addr) = pin->dummysig.b;
+            break;
+        case HAL_S32:
+            *((hal_s32_t *) data_addr) = pin->dummysig.s;
+            break;
+        case HAL_U32:
+            *((hal_u32_t *) data_addr) = pin->dummysig.u;
+            break;
+        case HAL_FLOAT:
+            *((hal_float_t *) data_addr) = pin->dummysig.f;
+            break;
+        default:
+            rtapi_print_msg(RTAPI_MSG_ERR,
+                          "HAL: BUG: pin '%s' has invalid type %d !!\n",
+                          pin->name, pin->type);
+            return -EINVAL;
+        }
+    }
+    /* update the signal's reader/writer/bidir counts */
+    if ((pin->dir & HAL_IN) != 0) {
+	sig->readers++;
+    }
+    if (pin->dir == HAL_OUT) {
+	sig->writers++;
+    }
+    if (pin->dir == HAL_IO) {
+	sig->bidirs++;
+    }
+    /* and update the pin */
+    pin->signal = SHMOFF(sig);
+    return 0;
+}
+
+static int add_funct_entry(hal_funct_t *funct, hal_thread_t *thread,
+    int position, hal_funct_entry_t **entry)
+{
+    hal_list_t *list_root, *list_entry;
+    int n;
+    hal_funct_entry_t *funct_entry;
+
+    /* is the function available? */
+    if ((funct->users > 0) && (funct->reentrant == 0)) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: function '%s' may only be added to one thread\n",
+	    funct->name);
+	return -EINVAL;
+    }
+    /* are thread and function compatible? */
+    if ((funct->uses_fp) && (!thread->uses_fp)) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: function '%s' needs FP\n", funct->name);
+	return -EINVAL;
+    }
+    /* find insertion point */
+    list_root = &(thread->funct_list);
+    list_entry = list_root;
+    n = 0;
+    if (position > 0) {
+	/* insertion is relative to start of list */
+	while (++n < position) {
+	    /* move further into list */
+	    list_entry = list_next(list_entry);
+	    if (list_entry == list_root) {
+		/* reached end of list */
+		rtapi_print_msg(RTAPI_MSG_ERR,
+		    "HAL: ERROR: position '%d' is too high\n", position);
+		return -EINVAL;
+	    }
+	}
+    } else {
+	/* insertion is relative to end of list */
+	while (--n > position) {
+	    /* move further into list */
+	    list_entry = list_prev(list_entry);
+	    if (list_entry == list_root) {
+		/* reached end of list */
+		rtapi_print_msg(RTAPI_MSG_ERR,
+		    "HAL: ERROR: position '%d' is too low\n", position);
+		return -EINVAL;
+	    }
+	}
+	/* want to insert before list_entry, so back up one more step */
+	list_entry = list_prev(list_entry);
+    }
+    /* allocate a funct entry structure */
+    funct_entry = alloc_funct_entry_struct();
+    if (funct_entry == 0) {
+	/* alloc failed */
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: insufficient memory for thread->function link\n");
+	return -ENOMEM;
+    }
+    /* init struct contents */
+    funct_entry->funct_ptr = SHMOFF(funct);
+    funct_entry->arg = funct->arg;
+    funct_entry->funct = funct->funct;
+    /* add the entry to the list */
+    list_add_after((hal_list_t *) funct_entry, list_entry);
+    /* update the function usage count */
+    funct->users++;
+    if (entry) {
+	*entry = funct_entry;
+    }
+    return 0;
+}
+
+static int set_param_value(hal_param_t *param, hal_type_t type,
+    const hal_data_u *value)
 {
-    hal_sig_t *sig;
-    hal_comp_t *comp;
-    void **data_ptr_addr;
-    hal_data_u *dummy_addr, *sig_data_addr;
-
-    /* is this pin linked to a signal? */
-    if (pin->signal != 0) {
-	/* yes, need to unlink it */
-	sig = SHMPTR(pin->signal);
-	/* make pin's 'data_ptr' point to its dummy signal */
-	data_ptr_addr = SHMPTR(pin->data_ptr_addr);
-	comp = SHMPTR(pin->owner_ptr);
-	dummy_addr = comp->shmem_base + SHMOFF(&(pin->dummysig));
-	*data_ptr_addr = dummy_addr;
-
-	/* copy current signal value to dummy */
-	sig_data_addr = (hal_data_u *)(hal_shmem_base + sig->data_ptr);
-	dummy_addr = (hal_data_u *)(hal_shmem_base + SHMOFF(&(pin->dummysig)));
-
-	switch (pin->type) {
-	case HAL_BIT:
-	    dummy_addr->b = sig_data_addr->b;
-	    break;
-	case HAL_S32:
-	    dummy_addr->s = sig_data_addr->s;
-	    break;
-	case HAL_U32:
-	    dummy_addr->u = sig_data_addr->u;
-	    break;
-	case HAL_FLOAT:
-	    dummy_addr->f = sig_data_addr->f;
-	    break;
-	default:
-	    rtapi_print_msg(RTAPI_MSG_ERR,
-			  "HAL: BUG: pin '%s' has invalid type %d !!\n",
-			  pin->name, pin->type);
-	}
+    void *d_ptr;
 
-	/* update the signal's reader/writer counts */
-	if ((pin->dir & HAL_IN) != 0) {
-	    sig->readers--;
-	}
-	if (pin->dir == HAL_OUT) {
-	    sig->writers--;
-	}
-	if (pin->dir == HAL_IO) {
-	    sig->bidirs--;
-	}
-	/* mark pin as unlinked */
-	pin->signal = 0;
+    /* is type compatible? */
+    if (param->type != type) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: type mismatch setting param '%s'\n", param->name);
+	return -EINVAL;
+    }
+    /* is it read only? */
+    if (param->dir == HAL_RO) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: param '%s' is not writable\n", param->name);
+	return -EINVAL;
+    }
+    /* everything is OK, set the value */
+    d_ptr = SHMPTR(param->data_ptr);
+    switch (param->type) {
+    case HAL_BIT:
+	*((hal_bit_t *) (d_ptr)) = value->b;
+	break;
+    case HAL_FLOAT:
+	*((hal_float_t *) (d_ptr)) = value->f;
+	break;
+    case HAL_S32:
+	*((hal_s32_t *) (d_ptr)) = value->s;
+	break;
+    case HAL_U32:
+	*((hal_u32_t *) (d_ptr)) = value->u;
+	break;
+    default:
+	/* Shouldn't get here, but just in case... */
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: bad type %d setting param\n", param->type);
+	return -EINVAL;
     }
+    return 0;
 }
 
 static void free_pin_struct(hal_pin_t * pin)
 {
 
     unlink_pin(pin);
-    /* clear contents of struct */
     if ( pin->oldname != 0 ) free_oldname_struct(SHMPTR(pin->oldname));
-    pin->data_ptr_addr = 0;
-    pin->owner_ptr = 0;
-    pin->type = 0;
-    pin->dir = 0;
-    pin->signal = 0;
-    memset(&pin->dummysig, 0, sizeof(hal_data_u));
-    pin->name[0] = '\0';
-    /* add it to free list */
-    pin->next_ptr = hal_data->pin_free_ptr;
-    hal_data->pin_free_ptr = SHMOFF(pin);
+    if (watch_forget(pin) != 0) {
+	/* a scan may still read it, leave it allocated */
+	return;
+    }
+    /* give it back to its component's pages */
+    slab_free(pin);
 }
 
 static void free_sig_struct(hal_sig_t * sig)
@@ -3262,6 +4160,14 @@ static void free_sig_struct(hal_sig_t * sig)
 	/* check for another pin linked to the signal */
 	pin = halpr_find_pin_by_sig(sig, pin);
     }
+    if (watch_forget(sig) != 0) {
+	/* a scan may still read it, leave it allocated */
+	return;
+    }
+    /* free the value */
+    if (sig->data_ptr != 0) {
+	slab_free(SHMPTR(sig->data_ptr));
+    }
     /* clear contents of struct */
     sig->data_ptr = 0;
     sig->type = 0;
@@ -3276,15 +4182,13 @@ static void free_sig_struct(hal_sig_t * sig)
 
 static void free_param_struct(hal_param_t * p)
 {
-    /* clear contents of struct */
     if ( p->oldname != 0 ) free_oldname_struct(SHMPTR(p->oldname));
-    p->data_ptr = 0;
-    p->owner_ptr = 0;
-    p->type = 0;
-    p->name[0] = '\0';
-    /* add it to free list (params use the same struct as src vars) */
-    p->next_ptr = hal_data->param_free_ptr;
-    hal_data->param_free_ptr = SHMOFF(p);
+    if (watch_forget(p) != 0) {
+	/* a scan may still read it, leave it allocated */
+	return;
+    }
+    /* give it back to its component's pages */
+    slab_free(p);
 }
 
 static void free_oldname_struct(hal_oldname_t * oldname)
@@ -3714,6 +4618,414 @@ int hal_stream_num_underruns(hal_stream_t *stream) {
     return stream->fifo->num_underruns;
 }
 
+/***********************************************************************
+*                    WATCH (CHANGE NOTIFICATION) CODE                  *
+************************************************************************/
+
+static hal_watch_item_t *watch_items(struct hal_watch_shm *w)
+{
+    return (hal_watch_item_t *) (w + 1);
+}
+
+static hal_watch_entry_t *watch_ring(struct hal_watch_shm *w)
+{
+    return (hal_watch_entry_t *) (watch_items(w) + w->max_items);
+}
+
+/* waits until no 'watch.scan' is running, so that whatever it might
+   be looking at can be freed; -EBUSY if one is still running after a
+   second, a realtime thread that stopped in the middle of it */
+static int watch_quiesce(void)
+{
+    int n;
+
+    for (n = 0; n < 100000; n++) {
+	if (atomic_load(&hal_data->watch_scanners) == 0) {
+	    return 0;
+	}
+	rtapi_delay(10000);
+    }
+    rtapi_print_msg(RTAPI_MSG_ERR,
+	"HAL: ERROR: watch.scan did not finish, not freeing its data\n");
+    return -EBUSY;
+}
+
+/* unlinks 'w' from the watch list, the caller frees it if this
+   returns 0 */
+static int watch_unlink(struct hal_watch_shm *w)
+{
+    rtapi_intptr_t *prev;
+
+    prev = &(hal_data->watch_list_ptr);
+    while (*prev != 0) {
+	if (*prev == SHMOFF(w)) {
+	    *prev = w->next_ptr;
+	    return watch_quiesce();
+	}
+	prev = &(((struct hal_watch_shm *) SHMPTR(*prev))->next_ptr);
+    }
+    return 0;
+}
+
+static int watch_forget(void *object)
+{
+    rtapi_intptr_t next;
+    struct hal_watch_shm *w;
+    hal_watch_item_t *item;
+    int n, found;
+
+    found = 0;
+    next = hal_data->watch_list_ptr;
+    while (next != 0) {
+	w = SHMPTR(next);
+	item = watch_items(w);
+	for (n = 0; n < w->num_items; n++, item++) {
+	    if (item->object == SHMOFF(object)) {
+		item->object = 0;
+		found = 1;
+	    }
+	}
+	next = w->next_ptr;
+    }
+    if (found) {
+	return watch_quiesce();
+    }
+    return 0;
+}
+
+static int watch_remove_owned(hal_comp_t * comp)
+{
+    rtapi_intptr_t next;
+    struct hal_watch_shm *w;
+    int retval = 0;
+
+    next = hal_data->watch_list_ptr;
+    while (next != 0) {
+	w = SHMPTR(next);
+	next = w->next_ptr;
+	if (SHMPTR(w->owner_ptr) == comp) {
+	    /* its memory goes with the rest of the component's */
+	    if (watch_unlink(w) != 0) {
+		retval = -EBUSY;
+	    }
+	}
+    }
+    return retval;
+}
+
+#ifdef RTAPI
+static hal_data_u *watch_value(hal_watch_item_t * item)
+{
+    hal_pin_t *pin;
+    hal_sig_t *sig;
+    hal_param_t *param;
+
+    switch (item->kind) {
+    case HAL_WATCH_PIN:
+	pin = SHMPTR(item->object);
+	if (pin->signal == 0) {
+	    return &(pin->dummysig);
+	}
+	sig = SHMPTR(pin->signal);
+	return SHMPTR(sig->data_ptr);
+    case HAL_WATCH_SIG:
+	sig = SHMPTR(item->object);
+	return SHMPTR(sig->data_ptr);
+    default:
+	param = SHMPTR(item->object);
+	return SHMPTR(param->data_ptr);
+    }
+}
+
+/* compares without floating point, so 'watch.scan' doesn't need it */
+static int watch_changed(hal_type_t type, hal_data_u * a, hal_data_u * b)
+{
+    switch (type) {
+    case HAL_BIT:
+	return a->b != b->b;
+    case HAL_S32:
+	return a->s != b->s;
+    case HAL_U32:
+	return a->u != b->u;
+    default:
+	return memcmp((const void *) &a->f, (const void *) &b->f,
+	    sizeof(hal_float_t)) != 0;
+    }
+}
+
+static void watch_wake(struct hal_watch_shm *w)
+{
+#if !defined(__KERNEL__)
+    syscall(SYS_futex, &w->seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+    /* in kernel space there is no way to wake the reader, it polls */
+}
+
+void hal_watch_scan(void)
+{
+    rtapi_intptr_t next;
+    struct hal_watch_shm *w;
+    hal_watch_item_t *item;
+    hal_watch_entry_t *entry;
+    hal_data_u value;
+    int n, num, in, out, added;
+
+    __sync_fetch_and_add(&hal_data->watch_scanners, 1);
+    next = atomic_load_explicit(&hal_data->watch_list_ptr,
+	memory_order_acquire);
+    while (next != 0) {
+	w = SHMPTR(next);
+	num = atomic_load_explicit(&w->num_items, memory_order_acquire);
+	in = w->in;
+	out = atomic_load_explicit(&w->out, memory_order_acquire);
+	added = 0;
+	item = watch_items(w);
+	for (n = 0; n < num; n++, item++) {
+	    if (item->object == 0) {
+		continue;
+	    }
+	    value = *watch_value(item);
+	    if (!item->fresh && !watch_changed(item->type, &value, &item->last)) {
+		continue;
+	    }
+	    if ((in + 1) % w->depth == out) {
+		/* ring is full, a later scan finds the rest */
+		w->overruns++;
+		break;
+	    }
+	    entry = watch_ring(w) + in;
+	    entry->index = n;
+	    entry->value = value;
+	    in = (in + 1) % w->depth;
+	    item->last = value;
+	    item->fresh = 0;
+	    added = 1;
+	}
+	if (added) {
+	    atomic_store_explicit(&w->in, in, memory_order_release);
+	    __sync_fetch_and_add(&w->seq, 1);
+	    if (atomic_load(&w->sleeping)) {
+		watch_wake(w);
+	    }
+	}
+	next = w->next_ptr;
+    }
+    __sync_fetch_and_sub(&hal_data->watch_scanners, 1);
+}
+#endif /* RTAPI */
+
+#ifdef ULAPI
+int hal_watch_new(hal_watch_t *watch, int comp_id, int max_items, int depth)
+{
+    hal_comp_t *comp;
+    struct hal_watch_shm *w;
+
+    watch->comp_id = -1;
+    watch->shm = 0;
+    if (hal_data == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: watch_new called before init\n");
+	return -EINVAL;
+    }
+    if ((max_items < 1) || (depth < 2)) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: watch needs at least 1 item and a depth of 2\n");
+	return -EINVAL;
+    }
+    rtapi_mutex_get(&(hal_data->mutex));
+    comp = halpr_find_comp_by_id(comp_id);
+    if (comp == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: component %d not found\n", comp_id);
+	return -EINVAL;
+    }
+    w = slab_alloc(comp, sizeof(struct hal_watch_shm) +
+	max_items * sizeof(hal_watch_item_t) +
+	depth * sizeof(hal_watch_entry_t));
+    if (w == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: insufficient memory for watch\n");
+	return -ENOMEM;
+    }
+    w->owner_ptr = SHMOFF(comp);
+    w->max_items = max_items;
+    w->depth = depth;
+    /* insert at head of list, the scan may be walking it */
+    w->next_ptr = hal_data->watch_list_ptr;
+    atomic_store_explicit(&hal_data->watch_list_ptr, SHMOFF(w),
+	memory_order_release);
+    rtapi_mutex_give(&(hal_data->mutex));
+    watch->comp_id = comp_id;
+    watch->shm = w;
+    return 0;
+}
+
+int hal_watch_add(hal_watch_t *watch, const char *name)
+{
+    struct hal_watch_shm *w;
+    hal_watch_item_t *item;
+    hal_pin_t *pin;
+    hal_sig_t *sig;
+    hal_param_t *param;
+    int n;
+
+    w = watch->shm;
+    rtapi_mutex_get(&(hal_data->mutex));
+    n = w->num_items;
+    if (n == w->max_items) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: watch is full, cannot add '%s'\n", name);
+	return -ENOSPC;
+    }
+    item = watch_items(w) + n;
+    if ((pin = halpr_find_pin_by_name(name)) != 0) {
+	item->object = SHMOFF(pin);
+	item->kind = HAL_WATCH_PIN;
+	item->type = pin->type;
+    } else if ((sig = halpr_find_sig_by_name(name)) != 0) {
+	item->object = SHMOFF(sig);
+	item->kind = HAL_WATCH_SIG;
+	item->type = sig->type;
+    } else if ((param = halpr_find_param_by_name(name)) != 0) {
+	item->object = SHMOFF(param);
+	item->kind = HAL_WATCH_PARAM;
+	item->type = param->type;
+    } else {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: no pin, signal or parameter named '%s'\n", name);
+	return -ENOENT;
+    }
+    /* the first scan reports the current value */
+    item->fresh = 1;
+    atomic_store_explicit(&w->num_items, n + 1, memory_order_release);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return n;
+}
+
+hal_type_t hal_watch_type(hal_watch_t *watch, int index)
+{
+    return watch_items(watch->shm)[index].type;
+}
+
+bool hal_watch_readable(hal_watch_t *watch)
+{
+    return atomic_load_explicit(&watch->shm->in, memory_order_acquire) !=
+	watch->shm->out;
+}
+
+int hal_watch_read(hal_watch_t *watch, hal_watch_event_t *events, int max)
+{
+    struct hal_watch_shm *w;
+    hal_watch_entry_t *entry;
+    int n, in, out;
+
+    w = watch->shm;
+    in = atomic_load_explicit(&w->in, memory_order_acquire);
+    out = w->out;
+    for (n = 0; (n < max) && (out != in); n++) {
+	entry = watch_ring(w) + out;
+	events[n].index = entry->index;
+	events[n].type = watch_items(w)[entry->index].type;
+	switch (events[n].type) {
+	case HAL_BIT:
+	    events[n].value.b = entry->value.b;
+	    break;
+	case HAL_S32:
+	    events[n].value.s = entry->value.s;
+	    break;
+	case HAL_U32:
+	    events[n].value.u = entry->value.u;
+	    break;
+	default:
+	    events[n].value.f = entry->value.f;
+	    break;
+	}
+	out = (out + 1) % w->depth;
+    }
+    atomic_store_explicit(&w->out, out, memory_order_release);
+    return n;
+}
+
+int hal_watch_wait(hal_watch_t *watch, long long timeout_ns)
+{
+    struct hal_watch_shm *w;
+    struct timespec now, ts, *tsp;
+    long long left, deadline;
+    int seq;
+
+    w = watch->shm;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    deadline = now.tv_sec * 1000000000LL + now.tv_nsec;
+    if (timeout_ns > LLONG_MAX - deadline) {
+	/* the deadline can't be represented, wait forever */
+	timeout_ns = -1;
+    }
+    deadline += timeout_ns;
+    while (!hal_watch_readable(watch)) {
+	left = -1;
+	if (timeout_ns >= 0) {
+	    clock_gettime(CLOCK_MONOTONIC, &now);
+	    left = deadline - (now.tv_sec * 1000000000LL + now.tv_nsec);
+	    if (left <= 0) {
+		return 0;
+	    }
+	}
+	/* a realtime thread in kernel space can't wake us, so poll */
+	if (rtapi_is_kernelspace() && ((left < 0) || (left > 10000000))) {
+	    left = 10000000;
+	}
+	/* don't overflow a 32 bit time_t, the loop waits again */
+	if (left > INT_MAX * 1000000000LL) {
+	    left = INT_MAX * 1000000000LL;
+	}
+	tsp = 0;
+	if (left >= 0) {
+	    ts.tv_sec = left / 1000000000;
+	    ts.tv_nsec = left % 1000000000;
+	    tsp = &ts;
+	}
+	seq = atomic_load(&w->seq);
+	atomic_store(&w->sleeping, 1);
+	if (!hal_watch_readable(watch) &&
+	    (syscall(SYS_futex, &w->seq, FUTEX_WAIT, seq, tsp, NULL, 0) < 0) &&
+	    (errno == EINTR)) {
+	    atomic_store(&w->sleeping, 0);
+	    return -EINTR;
+	}
+	atomic_store(&w->sleeping, 0);
+    }
+    return 1;
+}
+
+int hal_watch_overruns(hal_watch_t *watch)
+{
+    return watch->shm->overruns;
+}
+
+int hal_watch_delete(hal_watch_t *watch)
+{
+    int retval;
+
+    if (watch->shm == 0) {
+	return 0;
+    }
+    rtapi_mutex_get(&(hal_data->mutex));
+    retval = watch_unlink(watch->shm);
+    if (retval == 0) {
+	slab_free(watch->shm);
+    }
+    /* otherwise it stays allocated until the component exits */
+    rtapi_mutex_give(&(hal_data->mutex));
+    watch->shm = 0;
+    watch->comp_id = -1;
+    return retval;
+}
+#endif /* ULAPI */
+
 #ifdef RTAPI
 /* only export symbols when we're building a kernel module */
 
@@ -3762,6 +5074,7 @@ EXPORT_SYMBOL(hal_set_constructor);
 EXPORT_SYMBOL(hal_export_funct);
 
 EXPORT_SYMBOL(hal_create_thread);
+EXPORT_SYMBOL(hal_create_thread_cpu);
 
 EXPORT_SYMBOL(hal_add_funct_to_thread);
 EXPORT_SYMBOL(hal_del_funct_from_thread);
@@ -3800,4 +5113,5 @@ EXPORT_SYMBOL_GPL(hal_stream_element_count);
 EXPORT_SYMBOL_GPL(hal_stream_element_type);
 EXPORT_SYMBOL_GPL(hal_stream_num_overruns);
 EXPORT_SYMBOL_GPL(hal_stream_num_underruns);
+EXPORT_SYMBOL_GPL(hal_watch_scan);
 #endif /* rtapi */
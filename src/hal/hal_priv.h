@@ -154,6 +154,32 @@ typedef struct {
     char name[HAL_NAME_LEN + 1];	/* the original name */
 } hal_oldname_t;
 
+/** HAL memory pages.
+    Memory for realtime data - everything from 'hal_malloc()', signal
+    values, and the pin and parameter structs that hold unlinked pin
+    values - is handed out in pages of HAL_PAGE_SIZE bytes, taken from
+    the bottom of free shmem.  Every run of pages starts with a
+    'hal_slab_t'.  A slab is a single page that is cut into blocks of
+    one size class; a request bigger than HAL_SLAB_MAX gets a run of
+    its own.  Runs belong to the component that was initializing when
+    they were allocated and are all returned when it calls hal_exit(),
+    so a component's instance data and its pins share a few pages and
+    loading and unloading it leaves nothing behind.  A block can also
+    be freed on its own, a slab goes back to the free runs when its
+    last block is freed.
+*/
+typedef struct {
+    rtapi_intptr_t next_ptr;	/* next run of the owner, or next free run */
+    rtapi_intptr_t owner_ptr;	/* owning component, 0 if shared */
+    int pages;			/* length of the run in pages */
+    int block_size;		/* size of a slab's blocks, 0 if not a slab */
+    int used;			/* number of blocks in use */
+    int free_ptr;		/* first free block of a slab */
+} hal_slab_t;
+
+#define HAL_PAGE_SIZE 1024
+#define HAL_SLAB_MAX  (((HAL_PAGE_SIZE - (int)sizeof(hal_slab_t)) / 2) & ~7)
+
 /* Master HAL data structure
    There is a single instance of this structure in the machine.
    It resides at the base of the HAL shared memory block, where it
@@ -184,15 +210,19 @@ typedef struct {
     int threads_running;	/* non-zero if threads are started */
     rtapi_intptr_t oldname_free_ptr;	/* list of free oldname structs */
     rtapi_intptr_t comp_free_ptr;		/* list of free component structs */
-    rtapi_intptr_t pin_free_ptr;		/* list of free pin structs */
     rtapi_intptr_t sig_free_ptr;		/* list of free signal structs */
-    rtapi_intptr_t param_free_ptr;		/* list of free parameter structs */
     rtapi_intptr_t funct_free_ptr;		/* list of free function structs */
     hal_list_t funct_entry_free;	/* list of free funct entry structs */
     rtapi_intptr_t thread_free_ptr;	/* list of free thread structs */
     int exact_base_period;      /* if set, pretend that rtapi satisfied our
 				   period request exactly */
     unsigned char lock;         /* hal locking, can be one of the HAL_LOCK_* types */
+    rtapi_intptr_t page_base;		/* offset of the first page */
+    rtapi_intptr_t free_run_ptr;	/* free page runs, in address order */
+    int pages_free;			/* number of pages on free_run_ptr */
+    rtapi_intptr_t shared_slab_ptr;	/* page runs not owned by a component */
+    rtapi_intptr_t watch_list_ptr;	/* root of linked list of watches */
+    int watch_scanners;		/* number of 'watch.scan' calls running */
 } hal_data_t;
 
 /** HAL 'component' data structure.
@@ -211,6 +241,7 @@ typedef struct {
     char name[HAL_NAME_LEN + 1];	/* component name */
     constructor make;
     int insmod_args;		/* args passed to insmod when loaded */
+    rtapi_intptr_t slab_ptr;	/* page runs owned by this component */
 } hal_comp_t;
 
 /** HAL 'pin' data structure.
@@ -298,9 +329,11 @@ typedef struct {
     int uses_fp;		/* floating point flag */
     long int period;		/* period of the thread, in nsec */
     int priority;		/* priority of the thread */
+    int cpu_id;			/* requested CPU, or -1 for automatic */
     int task_id;		/* ID of the task that runs this thread */
     hal_s32_t* runtime;	/* (pin) duration of last run, in CPU cycles */
     hal_s32_t maxtime;	/* (param) duration of longest run, in CPU cycles */
+    hal_s32_t* overruns;	/* (pin) number of late periods */
     hal_list_t funct_list;	/* list of functions to run */
     char name[HAL_NAME_LEN + 1];	/* thread name */
     int comp_id;
@@ -329,8 +362,8 @@ typedef struct {
 */
 
 #define HAL_KEY   0x48414C32	/* key used to open HAL shared memory */
-#define HAL_VER   0x0000000F	/* version code */
-#define HAL_SIZE  (85*4096)
+#define HAL_VER   0x00000012	/* version code */
+#define HAL_SIZE  (128*4096)
 #define HAL_PSEUDO_COMP_PREFIX "__" /* prefix to identify a pseudo component */
 
 /* These pointers are set by hal_init() to point to the shmem block
@@ -427,6 +460,31 @@ extern hal_funct_t *halpr_find_funct_by_owner(hal_comp_t * owner,
 */
 extern hal_pin_t *halpr_find_pin_by_sig(hal_sig_t * sig, hal_pin_t * start);
 
+#ifdef ULAPI
+/** 'halpr_index_t' is a hash table of the objects on one of the HAL
+    lists, for code that looks up many names at once and would
+    otherwise walk the list for each of them.  Every HAL object has
+    its 'next_ptr' first, 'name_offset' locates the name.
+    'halpr_index_build()' indexes the list that starts at 'list' and
+    leaves room for 'extra' objects to be added later with
+    'halpr_index_add()'; it returns 0 or -ENOMEM.  'halpr_index_find()'
+    returns the object called 'name', or NULL.  An index does not
+    follow changes made to the list, so the caller must hold the
+    mutex from building the index until it is freed.
+*/
+typedef struct {
+    void **objs;
+    unsigned mask;
+    size_t name_offset;
+} halpr_index_t;
+
+extern int halpr_index_build(halpr_index_t *ix, rtapi_intptr_t list,
+    size_t name_offset, int extra);
+extern void halpr_index_add(halpr_index_t *ix, void *obj);
+extern void *halpr_index_find(halpr_index_t *ix, const char *name);
+extern void halpr_index_free(halpr_index_t *ix);
+#endif /* ULAPI */
+
 #define HAL_STREAM_MAGIC_NUM		0x4649464F
 struct hal_stream_shm {
     unsigned int magic;
@@ -441,5 +499,46 @@ struct hal_stream_shm {
 };
 
 extern int halpr_parse_types(hal_type_t type[HAL_STREAM_MAX_PINS], const char *fcg);
+
+/** HAL 'watch' data structures.
+    A watch lives in the pages of the component that created it and
+    is on hal_data->watch_list_ptr, where the realtime 'watch.scan'
+    function finds it.  Each scan compares every item with the value
+    it last reported and appends the changed ones to the ring, which
+    the reader drains from user space.  If the ring fills up, the
+    remaining changes are simply found again by a later scan.
+*/
+#define HAL_WATCH_PIN	1
+#define HAL_WATCH_SIG	2
+#define HAL_WATCH_PARAM	3
+
+typedef struct {
+    int object;			/* pin, signal or param, 0 if deleted */
+    int kind;			/* HAL_WATCH_PIN, _SIG or _PARAM */
+    hal_type_t type;		/* data type */
+    int fresh;			/* report on the next scan, changed or not */
+    hal_data_u last;		/* value last reported */
+} hal_watch_item_t;
+
+typedef struct {
+    int index;			/* index of the item that changed */
+    hal_data_u value;		/* its new value */
+} hal_watch_entry_t;
+
+struct hal_watch_shm {
+    rtapi_intptr_t next_ptr;	/* next watch in linked list */
+    int owner_ptr;		/* component that owns the watch */
+    int max_items;		/* size of the item table */
+    int num_items;		/* items in use */
+    int depth;			/* size of the ring */
+    volatile int in;		/* next entry written by the scan */
+    volatile int out;		/* next entry read by the reader */
+    volatile int seq;		/* bumped when entries are added */
+    volatile int sleeping;	/* nonzero while the reader waits on 'seq' */
+    int overruns;		/* scans that found the ring full */
+    /* followed by hal_watch_item_t[max_items] and
+       hal_watch_entry_t[depth] */
+};
+
 RTAPI_END_DECLS
 #endif /* HAL_PRIV_H */
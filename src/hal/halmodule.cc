@@ -922,6 +922,10 @@ PyObject *set_p(PyObject *self, PyObject *args) {
 	return NULL;
     }
     //printf("INFO HALMODULE -- settting pin / param - name:%s value:%s\n",name,value);
+    if(hal_batch_active()) {
+        // checked and set when the batch is committed
+        return PyBool_FromLong(hal_batch_setp(name, value) != 0);
+    }
     // get mutex before accessing shared data 
     rtapi_mutex_get(&(hal_data->mutex));
     // search param list for name 
@@ -971,6 +975,36 @@ PyObject *set_p(PyObject *self, PyObject *args) {
     return PyBool_FromLong(retval != 0);
 }
 
+PyObject *begin_batch(PyObject *self, PyObject *args) {
+    if(!SHMPTR(0)) {
+	PyErr_Format(PyExc_RuntimeError,
+		"Cannot call before creating component");
+	return NULL;
+    }
+    int result = hal_begin_batch();
+    if(result < 0) return pyhal_error(result);
+    Py_RETURN_NONE;
+}
+
+PyObject *commit_batch(PyObject *self, PyObject *args) {
+    if(!hal_batch_active()) {
+	PyErr_Format(PyExc_RuntimeError, "No batch to commit");
+	return NULL;
+    }
+    int result = hal_commit_batch();
+    if(result < 0) return pyhal_error(result);
+    Py_RETURN_NONE;
+}
+
+PyObject *abort_batch(PyObject *self, PyObject *args) {
+    if(!hal_batch_active()) {
+	PyErr_Format(PyExc_RuntimeError, "No batch to abort");
+	return NULL;
+    }
+    hal_abort_batch();
+    Py_RETURN_NONE;
+}
+
 struct shmobject {
     PyObject_HEAD
     halobject *comp;
@@ -1349,6 +1383,179 @@ PyTypeObject stream_type = {
 };
 
 
+struct watchobj {
+    PyObject_HEAD
+    hal_watch_t watch;
+    halobject *comp;
+    PyObject *names;
+};
+
+static int pywatch_init(PyObject *_self, PyObject *args, PyObject *kw) {
+    watchobj *self = (watchobj *)_self;
+    PyObject *names;
+    int depth = 256;
+
+    if(!PyArg_ParseTuple(args, "O!O|i:hal.watch",
+                &halobject_type, &self->comp, &names, &depth))
+        return -1;
+    Py_INCREF(self->comp);
+    self->names = PySequence_Tuple(names);
+    if(!self->names) return -1;
+
+    int n = PyTuple_GET_SIZE(self->names);
+    int r = hal_watch_new(&self->watch, self->comp->hal_id, n ? n : 1, depth);
+    if(r < 0) { pyhal_error(r); return -1; }
+    for(int i=0; i<n; i++) {
+        char *name = PyString_AsString(PyTuple_GET_ITEM(self->names, i));
+        if(!name) return -1;
+        r = hal_watch_add(&self->watch, name);
+        if(r < 0) { pyhal_error(r); return -1; }
+    }
+    return 0;
+}
+
+static bool watch_valid(watchobj *self) {
+    if(!self->watch.shm || self->comp->hal_id <= 0) {
+        PyErr_Format(PyExc_RuntimeError,
+            "Invalid operation on closed HAL component");
+        return false;
+    }
+    return true;
+}
+
+static PyObject *watch_changes(watchobj *self) {
+    hal_watch_event_t events[64];
+    PyObject *r = PyList_New(0);
+    if(!r) return 0;
+
+    int n;
+    do {
+        n = hal_watch_read(&self->watch, events, 64);
+        for(int i=0; i<n; i++) {
+            PyObject *v;
+            switch(events[i].type) {
+            case HAL_BIT: v = to_python(events[i].value.b); break;
+            case HAL_FLOAT: v = to_python(events[i].value.f); break;
+            case HAL_S32: v = to_python(events[i].value.s); break;
+            case HAL_U32: v = to_python(events[i].value.u); break;
+            default: Py_INCREF(Py_None); v = Py_None; break;
+            }
+            PyObject *t = v ? Py_BuildValue("(ON)",
+                PyTuple_GET_ITEM(self->names, events[i].index), v) : 0;
+            if(!t || PyList_Append(r, t) < 0) {
+                Py_XDECREF(t);
+                Py_DECREF(r);
+                return 0;
+            }
+            Py_DECREF(t);
+        }
+    } while(n == 64);
+    return r;
+}
+
+PyObject *watch_read(PyObject *_self, PyObject *unused) {
+    watchobj *self = (watchobj *)_self;
+    if(!watch_valid(self)) return 0;
+    return watch_changes(self);
+}
+
+PyObject *watch_wait(PyObject *_self, PyObject *args) {
+    watchobj *self = (watchobj *)_self;
+    double timeout = -1;
+    if(!PyArg_ParseTuple(args, "|d:hal.watch.wait", &timeout)) return 0;
+    if(!watch_valid(self)) return 0;
+
+    // clamp before converting, a timeout too large (or NaN) for
+    // long long nanoseconds waits forever
+    long long timeout_ns = -1;
+    if(timeout >= 0 && timeout < LLONG_MAX / 1e9)
+        timeout_ns = (long long)(timeout * 1e9);
+
+    int r;
+    Py_BEGIN_ALLOW_THREADS
+    r = hal_watch_wait(&self->watch, timeout_ns);
+    Py_END_ALLOW_THREADS
+    if(r == -EINTR && PyErr_CheckSignals() < 0) return 0;
+    return watch_changes(self);
+}
+
+static PyMethodDef watch_methods[] = {
+    {"read", watch_read, METH_NOARGS,
+        "read() -> [(name, value), ...]: The changes since the last read, oldest first"},
+    {"wait", watch_wait, METH_VARARGS,
+        "wait([timeout]) -> [(name, value), ...]: Like read, but first block until something changes or 'timeout' seconds pass"},
+    {NULL},
+};
+
+PyObject *watch_overruns(PyObject *_self, void *unused) {
+    watchobj *self = reinterpret_cast<watchobj*>(_self);
+    if(!watch_valid(self)) return 0;
+    return to_python(hal_watch_overruns(&self->watch));
+}
+
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+static PyGetSetDef watch_getset[] = {
+    {"overruns", watch_overruns, NULL, NULL, NULL},
+    {}
+};
+#pragma GCC diagnostic warning "-Wwrite-strings"
+
+static void pywatch_delete(PyObject *_self) {
+    watchobj *self = reinterpret_cast<watchobj*>(_self);
+    // after the component exits, its watch is already gone
+    if(self->comp && self->comp->hal_id > 0)
+        hal_watch_delete(&self->watch);
+    Py_XDECREF(self->names);
+    Py_XDECREF(self->comp);
+    self->ob_type->tp_free(self);
+}
+
+static
+PyTypeObject watch_type = {
+    PyObject_HEAD_INIT(NULL)
+    0,                         /*ob_size*/
+    "hal.watch",               /*tp_name*/
+    sizeof(watchobj),          /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    pywatch_delete,            /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,        /*tp_flags*/
+    "HAL Watch",               /*tp_doc*/
+    0,                         /*tp_traverse*/
+    0,                         /*tp_clear*/
+    0,                         /*tp_richcompare*/
+    0,                         /*tp_weaklistoffset*/
+    0,                         /*tp_iter*/
+    0,                         /*tp_iternext*/
+    watch_methods,             /*tp_methods*/
+    0,                         /*tp_members*/
+    watch_getset,              /*tp_getset*/
+    0,                         /*tp_base*/
+    0,                         /*tp_dict*/
+    0,                         /*tp_descr_get*/
+    0,                         /*tp_descr_set*/
+    0,                         /*tp_dictoffset*/
+    pywatch_init,              /*tp_init*/
+    0,                         /*tp_alloc*/
+    PyType_GenericNew,         /*tp_new*/
+    0,                         /*tp_free*/
+    0,                         /*tp_is_gc*/
+};
+
+
 PyMethodDef module_methods[] = {
     {"pin_has_writer", pin_has_writer, METH_VARARGS,
 	"Return a FALSE value if a pin has no writers and TRUE if it does"},
@@ -1366,6 +1573,12 @@ PyMethodDef module_methods[] = {
 	"connect(pin_name, signal_name): Connect the named pin to the named signal."},
     {"set_p", set_p, METH_VARARGS,
 	"set pin value"},
+    {"begin_batch", begin_batch, METH_NOARGS,
+	"begin_batch(): Queue the changes made by new_sig, connect and set_p until commit_batch or abort_batch."},
+    {"commit_batch", commit_batch, METH_NOARGS,
+	"commit_batch(): Make all queued changes at once.  If one fails, none are made."},
+    {"abort_batch", abort_batch, METH_NOARGS,
+	"abort_batch(): Discard the queued changes."},
     {NULL},
 };
 
@@ -1407,10 +1620,12 @@ void init_hal(void) {
     PyType_Ready(&shm_type);
     PyType_Ready(&halpin_type);
     PyType_Ready(&stream_type);
+    PyType_Ready(&watch_type);
     PyModule_AddObject(m, "component", (PyObject*)&halobject_type);
     PyModule_AddObject(m, "shm", (PyObject*)&shm_type);
     PyModule_AddObject(m, "item", (PyObject*)&halpin_type);
     PyModule_AddObject(m, "stream", (PyObject*)&stream_type);
+    PyModule_AddObject(m, "watch", (PyObject*)&watch_type);
 
     PyModule_AddIntConstant(m, "MSG_NONE", RTAPI_MSG_NONE);
     PyModule_AddIntConstant(m, "MSG_ERR", RTAPI_MSG_ERR);
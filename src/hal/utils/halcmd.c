@@ -121,6 +121,10 @@ int halcmd_startup(int quiet) {
 }
 
 void halcmd_shutdown(void) {
+    if (hal_batch_active()) {
+        halcmd_error("'begin' without 'commit', batch discarded\n");
+        hal_abort_batch();
+    }
     /* tell the signal handler we might have the mutex */
     hal_flag = 1;
     hal_exit(comp_id);
@@ -134,36 +138,41 @@ void halcmd_shutdown(void) {
 #define FUNCT(x) ((halcmd_func_t)x)
 
 struct halcmd_command halcmd_commands[] = {
-    {"addf",    FUNCT(do_addf_cmd),    A_TWO | A_PLUS },
+    {"abort",   FUNCT(do_abort_cmd),   A_ZERO | A_BATCH },
+    {"addf",    FUNCT(do_addf_cmd),    A_TWO | A_PLUS | A_BATCH },
     {"alias",   FUNCT(do_alias_cmd),   A_THREE },
+    {"begin",   FUNCT(do_begin_cmd),   A_ZERO },
+    {"commit",  FUNCT(do_commit_cmd),  A_ZERO | A_BATCH },
     {"delf",    FUNCT(do_delf_cmd),    A_TWO | A_OPTIONAL },
     {"delsig",  FUNCT(do_delsig_cmd),  A_ONE },
-    {"echo",    FUNCT(do_echo_cmd),    A_ZERO },
-    {"getp",    FUNCT(do_getp_cmd),    A_ONE },
-    {"gets",    FUNCT(do_gets_cmd),    A_ONE },
-    {"ptype",   FUNCT(do_ptype_cmd),   A_ONE },
-    {"stype",   FUNCT(do_stype_cmd),   A_ONE },
-    {"help",    FUNCT(do_help_cmd),    A_ONE | A_OPTIONAL },
-    {"linkpp",  FUNCT(do_linkpp_cmd),  A_TWO | A_REMOVE_ARROWS },
-    {"linkps",  FUNCT(do_linkps_cmd),  A_TWO | A_REMOVE_ARROWS },
-    {"linksp",  FUNCT(do_linksp_cmd),  A_TWO | A_REMOVE_ARROWS },
-    {"list",    FUNCT(do_list_cmd),    A_ONE | A_PLUS },
+    {"echo",    FUNCT(do_echo_cmd),    A_ZERO | A_BATCH },
+    {"getp",    FUNCT(do_getp_cmd),    A_ONE | A_BATCH },
+    {"gets",    FUNCT(do_gets_cmd),    A_ONE | A_BATCH },
+    {"ptype",   FUNCT(do_ptype_cmd),   A_ONE | A_BATCH },
+    {"stype",   FUNCT(do_stype_cmd),   A_ONE | A_BATCH },
+    {"help",    FUNCT(do_help_cmd),    A_ONE | A_OPTIONAL | A_BATCH },
+    {"linkpp",  FUNCT(do_linkpp_cmd),  A_TWO | A_REMOVE_ARROWS | A_BATCH },
+    {"linkps",  FUNCT(do_linkps_cmd),  A_TWO | A_REMOVE_ARROWS | A_BATCH },
+    {"linksp",  FUNCT(do_linksp_cmd),  A_TWO | A_REMOVE_ARROWS | A_BATCH },
+    {"list",    FUNCT(do_list_cmd),    A_ONE | A_PLUS | A_BATCH },
     {"loadrt",  FUNCT(do_loadrt_cmd),  A_ONE | A_PLUS },
     {"loadusr", FUNCT(do_loadusr_cmd), A_PLUS | A_TILDE },
     {"lock",    FUNCT(do_lock_cmd),    A_ONE | A_OPTIONAL },
-    {"net",     FUNCT(do_net_cmd),     A_ONE | A_PLUS | A_REMOVE_ARROWS },
-    {"newsig",  FUNCT(do_newsig_cmd),  A_TWO },
+    {"net",     FUNCT(do_net_cmd),     A_ONE | A_PLUS | A_REMOVE_ARROWS | A_BATCH },
+    {"newsig",  FUNCT(do_newsig_cmd),  A_TWO | A_BATCH },
+    {"restore", FUNCT(do_restore_cmd), A_ONE | A_TILDE },
     {"save",    FUNCT(do_save_cmd),    A_TWO | A_OPTIONAL | A_TILDE },
     {"setexact_for_test_suite_only", FUNCT(do_setexact_cmd), A_ZERO },
-    {"setp",    FUNCT(do_setp_cmd),    A_TWO },
-    {"sets",    FUNCT(do_sets_cmd),    A_TWO },
-    {"show",    FUNCT(do_show_cmd),    A_ONE | A_OPTIONAL | A_PLUS},
-    {"source",  FUNCT(do_source_cmd),  A_ONE | A_TILDE },
+    {"setp",    FUNCT(do_setp_cmd),    A_TWO | A_BATCH },
+    {"sets",    FUNCT(do_sets_cmd),    A_TWO | A_BATCH },
+    {"show",    FUNCT(do_show_cmd),    A_ONE | A_OPTIONAL | A_PLUS | A_BATCH},
+    {"snapshot", FUNCT(do_snapshot_cmd), A_ONE | A_TILDE },
+    {"source",  FUNCT(do_source_cmd),  A_ONE | A_TILDE | A_BATCH },
     {"start",   FUNCT(do_start_cmd),   A_ZERO},
-    {"status",  FUNCT(do_status_cmd),  A_ONE | A_OPTIONAL },
+    {"status",  FUNCT(do_status_cmd),  A_ONE | A_OPTIONAL | A_BATCH },
     {"stop",    FUNCT(do_stop_cmd),    A_ZERO},
     {"unalias", FUNCT(do_unalias_cmd), A_TWO },
-    {"unecho",  FUNCT(do_unecho_cmd),  A_ZERO },
+    {"unecho",  FUNCT(do_unecho_cmd),  A_ZERO | A_BATCH },
     {"unlinkp", FUNCT(do_unlinkp_cmd), A_ONE },
     {"unload",  FUNCT(do_unload_cmd),  A_ONE },
     {"unloadrt", FUNCT(do_unloadrt_cmd), A_ONE },
@@ -325,6 +334,12 @@ static int parse_cmd1(char **argv) {
 	    nargs = command->type & 0xff,
 	    posargs;
 
+	if(hal_batch_active() && !(command->type & A_BATCH)) {
+	    halcmd_error("'%s' is not allowed between 'begin' and 'commit'\n",
+		command->name);
+	    return -EINVAL;
+	}
+
 	if(command->type & A_REMOVE_ARROWS) {
 	    int s, d;
 	    for(s=d=0; argv[s] && argv[s][0]; s++) {
@@ -455,16 +470,21 @@ int halcmd_parse_cmd(char *tokens[])
 
     hal_flag = 1;
     retval = parse_cmd1(tokens);
+    if(retval != 0 && hal_batch_active()) {
+        /* a batch is all or nothing */
+        hal_abort_batch();
+        halcmd_error("batch aborted, no changes made\n");
+    }
     hal_flag = 0;
     return retval;
 }
 
-/* tokenize() sets an array of pointers to each non-whitespace
-   token in the input line.  It expects that variable substitution
-   and comment removal have already been done, and that any
-   trailing newline has been removed.
+/* halcmd_tokenize() sets an array of MAX_TOK+1 pointers to each
+   non-whitespace token in the input line.  It expects that variable
+   substitution and comment removal have already been done, and that
+   any trailing newline has been removed.
 */
-static int tokenize(char *cmd_buf, char **tokens)
+int halcmd_tokenize(char *cmd_buf, char **tokens)
 {
     enum { BETWEEN_TOKENS,
            IN_TOKEN,
@@ -848,7 +868,7 @@ int halcmd_preprocess_line ( char *line, char **tokens )
 	return -2;
     }
     /* split cmd_buff into tokens */
-    retval = tokenize(cmd_buf, tokens);
+    retval = halcmd_tokenize(cmd_buf, tokens);
     if (retval != 0) {
 	return -3;
     }
@@ -45,6 +45,7 @@ extern int halcmd_startup(int quiet);
 extern void halcmd_shutdown();
 extern int halcmd_parse_cmd(char * tokens[]);
 extern int halcmd_parse_line(char * line);
+extern int halcmd_tokenize(char *cmd_buf, char **tokens);
 extern void halcmd_shutdown(void);
 extern int prompt_mode, echo_mode, errorcount, halcmd_done;
 extern int halcmd_preprocess_line ( char *line, char **tokens);
@@ -71,6 +72,7 @@ enum halcmd_argtype {
     A_REMOVE_ARROWS = 0x200, /* removes any arrows from command */
     A_OPTIONAL = 0x400,      /* arguments may be NULL */
     A_TILDE = 0x800,         /* tilde-expand all arguments */
+    A_BATCH = 0x1000,        /* allowed between 'begin' and 'commit' */
 };
 
 typedef int(*halcmd_func_t)(void);
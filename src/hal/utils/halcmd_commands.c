@@ -55,6 +55,7 @@
 #include <errno.h>
 #include <time.h>
 #include <fnmatch.h>
+#include <stddef.h>
 
 
 static int unloadrt_comp(char *mod_name);
@@ -250,6 +251,7 @@ int do_source_cmd(char *hal_filename) {
     int lineno_save = halcmd_get_linenumber();
     int linenumber = 1;
     char *filename_save = strdup(halcmd_get_filename());
+    int in_batch = hal_batch_active();
 
     if(!f) {
         fprintf(stderr, "Could not open hal file '%s': %s\n",
@@ -274,6 +276,12 @@ int do_source_cmd(char *hal_filename) {
         result = halcmd_parse_line(buf);
         if(result != 0) break;
     }
+    if(result == 0 && !in_batch && hal_batch_active()) {
+        /* a batch must end in the file that began it */
+        halcmd_error("'begin' without 'commit', batch discarded\n");
+        hal_abort_batch();
+        result = -EINVAL;
+    }
 
     halcmd_set_linenumber(lineno_save);
     halcmd_set_filename(filename_save);
@@ -460,6 +468,19 @@ int do_net_cmd(char *signal, char *pins[]) {
     hal_sig_t *sig;
     int i, retval;
 
+    if(hal_batch_active()) {
+        /* queue the links, they are checked when the batch is committed */
+        if(!pins[0] || !*pins[0]) {
+            halcmd_error("'net' requires at least one pin, none given\n");
+            return -EINVAL;
+        }
+        for(i=0; pins[i] && *pins[i]; i++) {
+            retval = hal_batch_net(signal, pins[i]);
+            if(retval != 0) return retval;
+        }
+        return 0;
+    }
+
     rtapi_mutex_get(&(hal_data->mutex));
     /* see if signal already exists */
     sig = halpr_find_sig_by_name(signal);
@@ -698,6 +719,9 @@ int do_setp_cmd(char *name, char *value)
     void *d_ptr;
 
     halcmd_info("setting parameter '%s' to '%s'\n", name, value);
+    if (hal_batch_active()) {
+	return hal_batch_setp(name, value);
+    }
     /* get mutex before accessing shared data */
     rtapi_mutex_get(&(hal_data->mutex));
     /* search param list for name */
@@ -840,6 +864,9 @@ int do_sets_cmd(char *name, char *value)
     void *d_ptr;
 
     rtapi_print_msg(RTAPI_MSG_DBG, "setting signal '%s'\n", name);
+    if (hal_batch_active()) {
+	return hal_batch_sets(name, value);
+    }
     /* get mutex before accessing shared data */
     rtapi_mutex_get(&(hal_data->mutex));
     /* search signal list for name */
@@ -2121,14 +2148,14 @@ static void print_mem_status()
     active = count_list(hal_data->comp_list_ptr);
     recycled = count_list(hal_data->comp_free_ptr);
     halcmd_output("  active/recycled components: %d/%d\n", active, recycled);
+    // count free pages, pins and params give theirs back to them
+    halcmd_output("  free pages:                 %d\n", hal_data->pages_free);
     // count pins
     active = count_list(hal_data->pin_list_ptr);
-    recycled = count_list(hal_data->pin_free_ptr);
-    halcmd_output("  active/recycled pins:       %d/%d\n", active, recycled);
+    halcmd_output("  active pins:                %d\n", active);
     // count parameters
     active = count_list(hal_data->param_list_ptr);
-    recycled = count_list(hal_data->param_free_ptr);
-    halcmd_output("  active/recycled parameters: %d/%d\n", active, recycled);
+    halcmd_output("  active parameters:          %d\n", active);
     // count aliases
     rtapi_mutex_get(&(hal_data->mutex));
     next = hal_data->pin_list_ptr;
@@ -2712,6 +2739,682 @@ static void save_unconnected_input_pin_values(FILE *dst)
     }
 }
 
+/* A snapshot holds the end result of a configuration rather than the
+   commands that built it: the components with their load arguments,
+   the aliases, every signal with the pins linked to it, the values of
+   writable parameters, unconnected input pins and undriven signals,
+   and the functions of every thread in order.  Restoring it needs no
+   parsing and resolves each name once through a hash index, instead
+   of one list search per command.
+
+   Every record has the same layout:
+	u8 kind  u8 type  u8 dir  u8 has_value  u64 value
+	u16 len  name[len] '\0'  u16 len  arg[len] '\0'
+   with integers in little endian byte order.  'arg' holds the load
+   arguments of a component, the original name of an alias, the signal
+   of a link or the thread of a function.
+*/
+
+#define SNAP_MAGIC	"HALSNAP1"
+#define SNAP_REC_FIXED	12
+
+enum {
+    SNAP_COMP = 'C',		/* type: 1 realtime, 0 user space */
+    SNAP_PIN_ALIAS = 'A',
+    SNAP_PARAM_ALIAS = 'a',
+    SNAP_SIG = 'S',
+    SNAP_LINK = 'L',
+    SNAP_PARAM = 'P',
+    SNAP_PIN = 'I',		/* value of an unconnected input pin */
+    SNAP_ADDF = 'F',
+    SNAP_END = 'E'
+};
+
+typedef struct {
+    int kind;
+    int type;
+    int dir;
+    int has_value;
+    rtapi_u64 value;
+    char *name;
+    char *arg;
+    int applied;		/* loaded or aliased by this restore */
+} snap_rec_t;
+
+static void snap_put_u16(FILE *dst, unsigned v)
+{
+    fputc(v & 0xff, dst);
+    fputc((v >> 8) & 0xff, dst);
+}
+
+static void snap_put_rec(FILE *dst, int kind, int type, int dir,
+    int has_value, rtapi_u64 value, const char *name, const char *arg)
+{
+    size_t len;
+    int n;
+
+    fputc(kind, dst);
+    fputc(type, dst);
+    fputc(dir, dst);
+    fputc(has_value, dst);
+    for (n = 0; n < 8; n++) {
+	fputc((value >> (8 * n)) & 0xff, dst);
+    }
+    len = strlen(name);
+    snap_put_u16(dst, len);
+    fwrite(name, 1, len + 1, dst);
+    len = strlen(arg);
+    snap_put_u16(dst, len);
+    fwrite(arg, 1, len + 1, dst);
+}
+
+static rtapi_u64 snap_get_value(hal_type_t type, void *d_ptr)
+{
+    rtapi_u64 v = 0;
+    real_t f;
+
+    switch (type) {
+    case HAL_BIT:
+	v = *(hal_bit_t *) d_ptr ? 1 : 0;
+	break;
+    case HAL_FLOAT:
+	f = *(hal_float_t *) d_ptr;
+	memcpy(&v, &f, sizeof(v));
+	break;
+    case HAL_S32:
+	v = (rtapi_u32) *(hal_s32_t *) d_ptr;
+	break;
+    case HAL_U32:
+	v = *(hal_u32_t *) d_ptr;
+	break;
+    default:
+	break;
+    }
+    return v;
+}
+
+static void snap_set_value(hal_type_t type, void *d_ptr, rtapi_u64 v)
+{
+    real_t f;
+
+    switch (type) {
+    case HAL_BIT:
+	*(hal_bit_t *) d_ptr = v != 0;
+	break;
+    case HAL_FLOAT:
+	memcpy(&f, &v, sizeof(f));
+	*(hal_float_t *) d_ptr = f;
+	break;
+    case HAL_S32:
+	*(hal_s32_t *) d_ptr = (rtapi_s32) v;
+	break;
+    case HAL_U32:
+	*(hal_u32_t *) d_ptr = (rtapi_u32) v;
+	break;
+    default:
+	break;
+    }
+}
+
+int do_snapshot_cmd(char *filename)
+{
+    FILE *dst;
+    int next, i, ncomps = 0;
+    hal_comp_t *comp;
+    hal_pin_t *pin;
+    hal_sig_t *sig;
+    hal_param_t *param;
+    hal_oldname_t *oldname;
+    hal_thread_t *tptr;
+    hal_list_t *list_root, *list_entry;
+    hal_funct_t *funct;
+
+    dst = fopen(filename, "wb");
+    if (dst == NULL) {
+	halcmd_error("Can't open snapshot file '%s': %s\n", filename,
+	    strerror(errno));
+	return -1;
+    }
+    fwrite(SNAP_MAGIC, 1, 8, dst);
+    rtapi_mutex_get(&(hal_data->mutex));
+    /* components, in the order they were loaded; user space ones only
+       matter if the configuration refers to their pins or params */
+    for (next = hal_data->comp_list_ptr; next != 0; next = comp->next_ptr) {
+	comp = SHMPTR(next);
+	ncomps++;
+    }
+    {
+	hal_comp_t *comps[ncomps ? ncomps : 1];
+	i = 0;
+	for (next = hal_data->comp_list_ptr; next; next = comp->next_ptr) {
+	    comp = SHMPTR(next);
+	    comps[i++] = comp;
+	}
+	while (i--) {
+	    comp = comps[i];
+	    if (comp->type == 1) {
+		snap_put_rec(dst, SNAP_COMP, 1, 0, 0, 0, comp->name,
+		    comp->insmod_args ? (char *) SHMPTR(comp->insmod_args) : "");
+	    } else if (comp->type == 0 && (halpr_find_pin_by_owner(comp, 0)
+		    || halpr_find_param_by_owner(comp, 0))) {
+		snap_put_rec(dst, SNAP_COMP, 0, 0, 0, 0, comp->name, "");
+	    }
+	}
+    }
+    for (next = hal_data->pin_list_ptr; next != 0; next = pin->next_ptr) {
+	pin = SHMPTR(next);
+	if (pin->oldname != 0) {
+	    oldname = SHMPTR(pin->oldname);
+	    snap_put_rec(dst, SNAP_PIN_ALIAS, 0, 0, 0, 0, pin->name,
+		oldname->name);
+	}
+    }
+    for (next = hal_data->param_list_ptr; next != 0; next = param->next_ptr) {
+	param = SHMPTR(next);
+	if (param->oldname != 0) {
+	    oldname = SHMPTR(param->oldname);
+	    snap_put_rec(dst, SNAP_PARAM_ALIAS, 0, 0, 0, 0, param->name,
+		oldname->name);
+	}
+    }
+    /* signals; the value only matters if no pin drives the signal */
+    for (next = hal_data->sig_list_ptr; next != 0; next = sig->next_ptr) {
+	sig = SHMPTR(next);
+	i = sig->writers == 0 && sig->bidirs == 0;
+	snap_put_rec(dst, SNAP_SIG, sig->type, 0, i,
+	    i ? snap_get_value(sig->type, SHMPTR(sig->data_ptr)) : 0,
+	    sig->name, "");
+    }
+    for (next = hal_data->pin_list_ptr; next != 0; next = pin->next_ptr) {
+	pin = SHMPTR(next);
+	if (pin->signal != 0) {
+	    sig = SHMPTR(pin->signal);
+	    snap_put_rec(dst, SNAP_LINK, pin->type, pin->dir, 0, 0,
+		pin->name, sig->name);
+	} else if (pin->dir != HAL_OUT) {
+	    snap_put_rec(dst, SNAP_PIN, pin->type, pin->dir, 1,
+		snap_get_value(pin->type, &(pin->dummysig)), pin->name, "");
+	}
+    }
+    for (next = hal_data->param_list_ptr; next != 0; next = param->next_ptr) {
+	param = SHMPTR(next);
+	if (param->dir != HAL_RO) {
+	    snap_put_rec(dst, SNAP_PARAM, param->type, param->dir, 1,
+		snap_get_value(param->type, SHMPTR(param->data_ptr)),
+		param->name, "");
+	}
+    }
+    for (next = hal_data->thread_list_ptr; next != 0; next = tptr->next_ptr) {
+	tptr = SHMPTR(next);
+	list_root = &(tptr->funct_list);
+	for (list_entry = list_next(list_root); list_entry != list_root;
+		list_entry = list_next(list_entry)) {
+	    funct = SHMPTR(((hal_funct_entry_t *) list_entry)->funct_ptr);
+	    snap_put_rec(dst, SNAP_ADDF, 0, 0, 0, 0, funct->name, tptr->name);
+	}
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    snap_put_rec(dst, SNAP_END, 0, 0, 0, 0, "", "");
+    if (ferror(dst) | fclose(dst)) {
+	halcmd_error("Error writing snapshot file '%s'\n", filename);
+	return -1;
+    }
+    halcmd_info("HAL snapshot written to '%s'\n", filename);
+    return 0;
+}
+
+/* reads a whole snapshot into memory; the records point into *buf */
+static int snap_read(char *filename, char **buf, snap_rec_t **recs,
+    int *nrecs)
+{
+    FILE *src;
+    long size;
+    unsigned char *p, *end;
+    snap_rec_t *rec;
+    size_t len;
+    int n, max;
+
+    src = fopen(filename, "rb");
+    if (src == NULL) {
+	halcmd_error("Can't open snapshot file '%s': %s\n", filename,
+	    strerror(errno));
+	return -1;
+    }
+    fseek(src, 0, SEEK_END);
+    size = ftell(src);
+    rewind(src);
+    *buf = malloc(size > 0 ? size : 1);
+    if (*buf == NULL || size < 8 || fread(*buf, 1, size, src) != (size_t) size
+	    || memcmp(*buf, SNAP_MAGIC, 8) != 0) {
+	fclose(src);
+	halcmd_error("'%s' is not a HAL snapshot\n", filename);
+	return -1;
+    }
+    fclose(src);
+    /* every record takes at least SNAP_REC_FIXED + 6 bytes */
+    max = size / (SNAP_REC_FIXED + 6) + 1;
+    *recs = malloc(max * sizeof(snap_rec_t));
+    if (*recs == NULL) {
+	halcmd_error("Out of memory reading '%s'\n", filename);
+	return -1;
+    }
+    p = (unsigned char *) *buf + 8;
+    end = (unsigned char *) *buf + size;
+    for (rec = *recs; ; rec++) {
+	if (end - p < SNAP_REC_FIXED + 6) {
+	    break;
+	}
+	rec->kind = p[0];
+	rec->type = p[1];
+	rec->dir = p[2];
+	rec->has_value = p[3];
+	rec->applied = 0;
+	rec->value = 0;
+	for (n = 7; n >= 0; n--) {
+	    rec->value = (rec->value << 8) | p[4 + n];
+	}
+	p += SNAP_REC_FIXED;
+	len = p[0] | (p[1] << 8);
+	if ((size_t) (end - p) < len + 5 || p[2 + len] != '\0') {
+	    break;
+	}
+	rec->name = (char *) p + 2;
+	p += len + 3;
+	len = p[0] | (p[1] << 8);
+	if ((size_t) (end - p) < len + 3 || p[2 + len] != '\0') {
+	    break;
+	}
+	rec->arg = (char *) p + 2;
+	p += len + 3;
+	if (rec->kind == SNAP_END) {
+	    *nrecs = rec - *recs;
+	    return 0;
+	}
+    }
+    halcmd_error("Snapshot '%s' is truncated or corrupt\n", filename);
+    return -1;
+}
+
+/* loads the realtime modules of the snapshot that are not loaded yet,
+   and checks that the loaded ones got the same arguments */
+static int snap_load_comps(snap_rec_t *recs, int nrecs)
+{
+    char args_buf[MAX_CMD_LEN + 1], *args[MAX_TOK + 1];
+    const char *loaded_args;
+    hal_comp_t *comp;
+    snap_rec_t *rec;
+    int found, errors = 0;
+
+    for (rec = recs; rec < recs + nrecs; rec++) {
+	if (rec->kind != SNAP_COMP) {
+	    continue;
+	}
+	rtapi_mutex_get(&(hal_data->mutex));
+	comp = halpr_find_comp_by_name(rec->name);
+	found = comp != 0;
+	loaded_args = "";
+	if (comp && comp->insmod_args) {
+	    loaded_args = SHMPTR(comp->insmod_args);
+	}
+	if (found && rec->type == 1 && strcmp(loaded_args, rec->arg) != 0) {
+	    halcmd_error("module '%s' is loaded with arguments '%s', "
+		"snapshot has '%s'\n", rec->name, loaded_args, rec->arg);
+	    errors++;
+	}
+	rtapi_mutex_give(&(hal_data->mutex));
+	if (found) {
+	    continue;
+	}
+	if (rec->type != 1) {
+	    halcmd_error("user space component '%s' must be loaded before "
+		"restore\n", rec->name);
+	    errors++;
+	    continue;
+	}
+	/* split the arguments the way loadrt got them, quotes and all */
+	snprintf(args_buf, sizeof(args_buf), "%s", rec->arg);
+	if (halcmd_tokenize(args_buf, args) != 0) {
+	    errors++;
+	    continue;
+	}
+	args[MAX_TOK] = "";
+	if (do_loadrt_cmd(rec->name, args) != 0) {
+	    errors++;
+	} else {
+	    rec->applied = 1;
+	}
+    }
+    return errors ? -EINVAL : 0;
+}
+
+static int snap_apply_aliases(snap_rec_t *recs, int nrecs)
+{
+    snap_rec_t *rec;
+    int exists, retval;
+
+    for (rec = recs; rec < recs + nrecs; rec++) {
+	if (rec->kind != SNAP_PIN_ALIAS && rec->kind != SNAP_PARAM_ALIAS) {
+	    continue;
+	}
+	rtapi_mutex_get(&(hal_data->mutex));
+	if (rec->kind == SNAP_PIN_ALIAS) {
+	    exists = halpr_find_pin_by_name(rec->name) != 0;
+	} else {
+	    exists = halpr_find_param_by_name(rec->name) != 0;
+	}
+	rtapi_mutex_give(&(hal_data->mutex));
+	if (exists) {
+	    continue;
+	}
+	if (rec->kind == SNAP_PIN_ALIAS) {
+	    retval = hal_pin_alias(rec->arg, rec->name);
+	} else {
+	    retval = hal_param_alias(rec->arg, rec->name);
+	}
+	if (retval != 0) {
+	    halcmd_error("alias '%s' for '%s' failed\n", rec->name, rec->arg);
+	    return retval;
+	}
+	rec->applied = 1;
+    }
+    return 0;
+}
+
+/* undoes the aliases and module loads of a restore that failed later */
+static void snap_rollback(snap_rec_t *recs, int nrecs)
+{
+    snap_rec_t *rec;
+
+    /* aliases first, while their components are still there */
+    for (rec = recs + nrecs - 1; rec >= recs; rec--) {
+	if (!rec->applied) {
+	    continue;
+	}
+	if (rec->kind == SNAP_PIN_ALIAS) {
+	    hal_pin_alias(rec->arg, NULL);
+	} else if (rec->kind == SNAP_PARAM_ALIAS) {
+	    hal_param_alias(rec->arg, NULL);
+	} else {
+	    continue;
+	}
+	rec->applied = 0;
+    }
+    for (rec = recs + nrecs - 1; rec >= recs; rec--) {
+	if (rec->applied && rec->kind == SNAP_COMP) {
+	    unloadrt_comp(rec->name);
+	    rec->applied = 0;
+	}
+    }
+}
+
+/* checks every record against the loaded components before anything
+   is changed; caller holds the HAL mutex */
+static int snap_validate(snap_rec_t *recs, int nrecs, halpr_index_t *pins,
+    halpr_index_t *params, halpr_index_t *sigs, halpr_index_t *functs,
+    halpr_index_t *threads)
+{
+    snap_rec_t *rec;
+    hal_pin_t *pin;
+    hal_param_t *param;
+    hal_sig_t *sig;
+    hal_thread_t *tptr;
+    int errors = 0;
+
+    for (rec = recs; rec < recs + nrecs; rec++) {
+	switch (rec->kind) {
+	case SNAP_SIG:
+	    sig = halpr_index_find(sigs, rec->name);
+	    if (sig && sig->type != rec->type) {
+		halcmd_error("signal '%s' exists with type %s, snapshot has "
+		    "%s\n", rec->name, data_type(sig->type),
+		    data_type(rec->type));
+		errors++;
+	    }
+	    break;
+	case SNAP_LINK:
+	case SNAP_PIN:
+	    pin = halpr_index_find(pins, rec->name);
+	    if (pin == 0) {
+		halcmd_error("pin '%s' not found\n", rec->name);
+		errors++;
+	    } else if (pin->type != rec->type || pin->dir != rec->dir) {
+		halcmd_error("pin '%s' is %s %s, snapshot has %s %s\n",
+		    rec->name, data_type(pin->type), pin_data_dir(pin->dir),
+		    data_type(rec->type), pin_data_dir(rec->dir));
+		errors++;
+	    } else if (pin->signal != 0) {
+		sig = SHMPTR(pin->signal);
+		if (rec->kind == SNAP_PIN || strcmp(sig->name, rec->arg) != 0) {
+		    halcmd_error("pin '%s' is already linked to '%s'\n",
+			rec->name, sig->name);
+		    errors++;
+		}
+	    }
+	    break;
+	case SNAP_PARAM:
+	    param = halpr_index_find(params, rec->name);
+	    if (param == 0) {
+		halcmd_error("parameter '%s' not found\n", rec->name);
+		errors++;
+	    } else if (param->type != rec->type || param->dir == HAL_RO) {
+		halcmd_error("parameter '%s' is %s %s, snapshot has %s %s\n",
+		    rec->name, data_type(param->type),
+		    param_data_dir(param->dir), data_type(rec->type),
+		    param_data_dir(rec->dir));
+		errors++;
+	    }
+	    break;
+	case SNAP_ADDF:
+	    tptr = halpr_index_find(threads, rec->arg);
+	    if (halpr_index_find(functs, rec->name) == 0) {
+		halcmd_error("function '%s' not found\n", rec->name);
+		errors++;
+	    }
+	    if (tptr == 0) {
+		halcmd_error("thread '%s' not found\n", rec->arg);
+		errors++;
+	    } else if (list_next(&(tptr->funct_list)) != &(tptr->funct_list)) {
+		halcmd_error("thread '%s' already has functions\n", rec->arg);
+		errors++;
+		/* report each thread once */
+		while (rec + 1 < recs + nrecs && rec[1].kind == SNAP_ADDF
+			&& strcmp(rec[1].arg, rec->arg) == 0) {
+		    rec++;
+		}
+	    }
+	    break;
+	default:
+	    break;
+	}
+    }
+    return errors ? -EINVAL : 0;
+}
+
+int do_restore_cmd(char *filename)
+{
+    char *buf = NULL;
+    snap_rec_t *recs = NULL, *rec;
+    halpr_index_t pins = {0}, params = {0}, sigs = {0}, functs = {0},
+	threads = {0};
+    hal_pin_t *pin;
+    hal_param_t *param;
+    hal_sig_t *sig;
+    int nrecs = 0, retval, nsigs = 0, nlinks = 0, nvalues = 0, nfuncts = 0;
+    int nlocked = 0, indexed;
+    struct timespec start, stop;
+
+    if (hal_get_lock() & HAL_LOCK_CONFIG) {
+	halcmd_error("HAL is locked, restoring a snapshot is not permitted\n");
+	return -EPERM;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    retval = snap_read(filename, &buf, &recs, &nrecs);
+    if (retval == 0) {
+	retval = snap_load_comps(recs, nrecs);
+    }
+    if (retval == 0) {
+	retval = snap_apply_aliases(recs, nrecs);
+    }
+    if (retval != 0) {
+	goto out;
+    }
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    retval = halpr_index_build(&pins, hal_data->pin_list_ptr,
+	offsetof(hal_pin_t, name), 0);
+    if (retval == 0) retval = halpr_index_build(&params,
+	hal_data->param_list_ptr, offsetof(hal_param_t, name), 0);
+    if (retval == 0) retval = halpr_index_build(&sigs,
+	hal_data->sig_list_ptr, offsetof(hal_sig_t, name), 0);
+    if (retval == 0) retval = halpr_index_build(&functs,
+	hal_data->funct_list_ptr, offsetof(hal_funct_t, name), 0);
+    if (retval == 0) retval = halpr_index_build(&threads,
+	hal_data->thread_list_ptr, offsetof(hal_thread_t, name), 0);
+    if (retval == 0) {
+	retval = snap_validate(recs, nrecs, &pins, &params, &sigs, &functs,
+	    &threads);
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    if (retval != 0) {
+	halcmd_error("snapshot '%s' does not match the loaded components\n",
+	    filename);
+	goto out;
+    }
+
+    /* build the graph as one batch, so that a failure leaves the HAL
+       as it was; nothing above has changed it */
+    retval = hal_begin_batch();
+    for (rec = recs; rec < recs + nrecs && retval == 0; rec++) {
+	switch (rec->kind) {
+	case SNAP_SIG:
+	    if (halpr_index_find(&sigs, rec->name) == 0) {
+		retval = hal_signal_new(rec->name, rec->type);
+		nsigs++;
+	    }
+	    break;
+	case SNAP_LINK:
+	    pin = halpr_index_find(&pins, rec->name);
+	    if (pin->signal == 0) {
+		retval = hal_link(rec->name, rec->arg);
+		nlinks++;
+	    }
+	    break;
+	case SNAP_ADDF:
+	    retval = hal_add_funct_to_thread(rec->name, rec->arg, -1);
+	    nfuncts++;
+	    break;
+	default:
+	    break;
+	}
+    }
+    if (retval == 0) {
+	retval = hal_commit_batch();
+    } else if (hal_batch_active()) {
+	hal_abort_batch();
+    }
+    if (retval != 0) {
+	halcmd_error("restoring '%s' failed, no changes made\n", filename);
+	goto out;
+    }
+
+    /* then set all values in one go; the graph is in place now, so
+       this must not fail half way */
+    rtapi_mutex_get(&(hal_data->mutex));
+    halpr_index_free(&sigs);
+    indexed = halpr_index_build(&sigs, hal_data->sig_list_ptr,
+	offsetof(hal_sig_t, name), 0) == 0;
+    for (rec = recs; rec < recs + nrecs; rec++) {
+	switch (rec->kind) {
+	case SNAP_SIG:
+	    sig = indexed ? halpr_index_find(&sigs, rec->name)
+		: halpr_find_sig_by_name(rec->name);
+	    if (rec->has_value && sig->writers == 0 && sig->bidirs == 0) {
+		snap_set_value(sig->type, SHMPTR(sig->data_ptr), rec->value);
+		nvalues++;
+	    }
+	    break;
+	case SNAP_PIN:
+	    pin = halpr_index_find(&pins, rec->name);
+	    snap_set_value(pin->type, &(pin->dummysig), rec->value);
+	    nvalues++;
+	    break;
+	case SNAP_PARAM:
+	    if (hal_data->lock & HAL_LOCK_PARAMS) {
+		nlocked++;
+		break;
+	    }
+	    param = halpr_index_find(&params, rec->name);
+	    snap_set_value(param->type, SHMPTR(param->data_ptr), rec->value);
+	    nvalues++;
+	    break;
+	default:
+	    break;
+	}
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    if (nlocked) {
+	halcmd_warning("HAL parameters are locked, %d values not restored\n",
+	    nlocked);
+    }
+    halcmd_info("Restored '%s': %d signals, %d links, %d values, "
+	"%d functions in %.1f ms\n", filename, nsigs, nlinks, nvalues,
+	nfuncts, (stop.tv_sec - start.tv_sec) * 1e3
+	+ (stop.tv_nsec - start.tv_nsec) * 1e-6);
+
+out:
+    if (retval != 0 && recs != NULL) {
+	/* leave the HAL as it was before the restore */
+	snap_rollback(recs, nrecs);
+    }
+    halpr_index_free(&pins);
+    halpr_index_free(&params);
+    halpr_index_free(&sigs);
+    halpr_index_free(&functs);
+    halpr_index_free(&threads);
+    free(recs);
+    free(buf);
+    return retval;
+}
+
+int do_begin_cmd(void)
+{
+    int retval;
+
+    retval = hal_begin_batch();
+    if (retval != 0) {
+	halcmd_error("begin failed\n");
+    }
+    return retval;
+}
+
+int do_commit_cmd(void)
+{
+    int retval;
+
+    if (!hal_batch_active()) {
+	halcmd_error("'commit' without 'begin'\n");
+	return -EINVAL;
+    }
+    retval = hal_commit_batch();
+    if (retval == 0) {
+	halcmd_info("Batch committed\n");
+    } else {
+	halcmd_error("commit failed, no changes made\n");
+    }
+    return retval;
+}
+
+int do_abort_cmd(void)
+{
+    if (!hal_batch_active()) {
+	halcmd_error("'abort' without 'begin'\n");
+	return -EINVAL;
+    }
+    halcmd_info("Batch aborted\n");
+    return hal_abort_batch();
+}
+
 int do_setexact_cmd() {
     int retval = 0;
     rtapi_mutex_get(&(hal_data->mutex));
@@ -2891,6 +3594,33 @@ int do_help_cmd(char *command)
         printf("  If 'type' is omitted (or type is 'all'), does the equivalent of:\n");
 	printf("  'comp', 'alias', 'sigu', 'netla', 'param', and 'thread'.\n\n");
         printf("  See the man page ($man halcmd) for save option details\n");
+    } else if (strcmp(command, "snapshot") == 0) {
+	printf("snapshot filename\n");
+	printf("  Writes the complete HAL configuration (components, signals,\n");
+	printf("  links, parameter and pin values, thread functions) to a\n");
+	printf("  binary snapshot that 'restore' can load in one step.\n");
+    } else if (strcmp(command, "restore") == 0) {
+	printf("restore filename\n");
+	printf("  Rebuilds the HAL configuration saved by 'snapshot'.  Missing\n");
+	printf("  realtime modules are loaded with their saved arguments; user\n");
+	printf("  space components must already be running.  No signal, link\n");
+	printf("  or value is changed unless every pin, parameter, function\n");
+	printf("  and thread in the snapshot exists with the same type and\n");
+	printf("  direction.\n");
+    } else if (strcmp(command, "begin") == 0) {
+	printf("begin\n");
+	printf("  Starts a batch.  The 'net', 'newsig', 'linkps', 'linksp',\n");
+	printf("  'setp', 'sets' and 'addf' commands that follow are only\n");
+	printf("  queued, and are made all at once by 'commit'.  Commands that\n");
+	printf("  cannot be batched are refused until 'commit' or 'abort'.\n");
+    } else if (strcmp(command, "commit") == 0) {
+	printf("commit\n");
+	printf("  Makes the changes queued since 'begin'.  If any of them fails,\n");
+	printf("  the ones already made are taken back and the HAL is left as\n");
+	printf("  it was before 'begin'.\n");
+    } else if (strcmp(command, "abort") == 0) {
+	printf("abort\n");
+	printf("  Discards the changes queued since 'begin'.\n");
     } else if (strcmp(command, "start") == 0) {
 	printf("start\n");
 	printf("  Starts all realtime threads.\n");
@@ -2956,6 +3686,8 @@ static void print_help_commands(void)
     printf("  source              Execute commands from another .hal file\n");
     printf("  status              Display status information\n");
     printf("  save                Print config as commands\n");
+    printf("  snapshot, restore   Save/restore config as a binary snapshot\n");
+    printf("  begin, commit, abort  Make a block of changes all at once\n");
     printf("  start, stop         Start/stop realtime threads\n");
     printf("  alias, unalias      Add or remove pin or parameter name aliases\n");
     printf("  echo, unecho        Echo commands from stdin to stderr\n");
@@ -83,6 +83,11 @@ extern int do_unloadusr_cmd(char *mod_name);
 extern int do_loadusr_cmd(char *args[]);
 extern int do_waitusr_cmd(char *comp_name);
 extern int do_save_cmd(char *type, char *filename);
+extern int do_snapshot_cmd(char *filename);
+extern int do_restore_cmd(char *filename);
+extern int do_begin_cmd(void);
+extern int do_commit_cmd(void);
+extern int do_abort_cmd(void);
 extern int do_setexact_cmd(void);
 
 pid_t hal_systemv_nowait(char *const argv[]);
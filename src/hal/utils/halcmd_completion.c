@@ -51,6 +51,7 @@ static const char *command_table[] = {
     "linkps", "linksp", "linkpp", "unlinkp",
     "net", "newsig", "delsig", "getp", "gets", "setp", "sets", "ptype", "stype",
     "addf", "delf", "show", "list", "status", "save", "source",
+    "snapshot", "restore", "begin", "commit", "abort",
     "start", "stop", "quit", "exit", "help", "alias", "unalias", 
     NULL,
 };
@@ -716,7 +717,8 @@ char **halcmd_completer(const char *text, int start, int end, hal_completer_func
         result = func(text, rtcomp_generator);
     } else if(startswith(buffer, "unload ") && argno == 1) {
         result = func(text, comp_generator);
-    } else if(startswith(buffer, "source ") && argno == 1) {
+    } else if((startswith(buffer, "source ") || startswith(buffer, "snapshot ")
+            || startswith(buffer, "restore ")) && argno == 1) {
         rtapi_mutex_give(&(hal_data->mutex));
         // leaves rl_attempted_completion_over = 0 to complete from filesystem
         return 0;
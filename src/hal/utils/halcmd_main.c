@@ -283,7 +283,10 @@ int main(int argc, char **argv)
 	    }
 	}
     }
-    /* all done */
+    /* all done; an unfinished batch is discarded by halcmd_shutdown() */
+    if ( hal_batch_active() ) {
+	errorcount++;
+    }
     halcmd_shutdown();
     if ( errorcount > 0 ) {
 	return 1;
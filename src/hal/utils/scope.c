@@ -105,6 +105,8 @@ int main(int argc, gchar * argv[])
     int num_samples = SCOPE_NUM_SAMPLES_DEFAULT;
     char *ifilename = "autosave.halscope";
     char *ofilename = "autosave.halscope";
+    char *sfilename = NULL;
+    int stream_triggered = 0;
 
     bindtextdomain("linuxcnc", EMC2_PO_DIR);
     setlocale(LC_MESSAGES,"");
@@ -118,13 +120,13 @@ int main(int argc, gchar * argv[])
 
     while(1) {
         int c;
-        c = getopt(argc, argv, "hi:o:");
+        c = getopt(argc, argv, "hi:o:r:t:");
         if(c == -1) break;
         switch(c) {
          case 'h':
             rtapi_print_msg(RTAPI_MSG_ERR,
             _("Usage:\n  halscope [-h] [-i infile] [-o outfile]"
-            " [num_samples]\n"));
+            " [-r|-t streamfile] [num_samples]\n"));
             return -1;
             break;
          case 'i':
@@ -133,6 +135,12 @@ int main(int argc, gchar * argv[])
          case 'o':
             ofilename = optarg;
             break;
+         case 'r':
+         case 't':
+            /* continuous recording, -t keeps only trigger windows */
+            sfilename = optarg;
+            stream_triggered = (c == 't');
+            break;
         }
     }
     if(argc > optind) num_samples = atoi(argv[argc-1]);
@@ -210,10 +218,14 @@ int main(int argc, gchar * argv[])
     gtk_widget_show(ctrl_usr->main_win);
     /* read the saved config file */
     read_config_file(ifilename);
+    if (sfilename != NULL) {
+	start_stream_record(sfilename, stream_triggered);
+    }
     /* arrange for periodic call of heartbeat() */
     gtk_timeout_add(100, heartbeat, NULL);
     /* enter the main loop */
     gtk_main();
+    stop_stream_record();
     write_config_file(ofilename);
 
     return (0);
@@ -228,6 +240,9 @@ int main(int argc, gchar * argv[])
 
 static int heartbeat(gpointer data)
 {
+    if (stream_failed()) {
+	stop_stream_record();
+    }
     refresh_state_info();
     /* check watchdog */
     if (ctrl_shm->watchdog < 10) {
@@ -238,9 +253,12 @@ static int heartbeat(gpointer data)
     if (ctrl_usr->pending_restart && ctrl_shm->state == IDLE) {
         ctrl_usr->pending_restart = 0;
         ctrl_usr->run_mode = ctrl_usr->old_run_mode;
-        if(ctrl_usr->run_mode != STOP) {
+        if(ctrl_usr->run_mode != STOP || stream_recording()) {
             start_capture();
         }
+    } else if (stream_recording() && ctrl_shm->state == IDLE) {
+	/* recording keeps going regardless of the run mode */
+	start_capture();
     }
     if (ctrl_usr->display_refresh_timer > 0) {
 	/* decrement timer, did it time out? */
@@ -253,6 +271,9 @@ static int heartbeat(gpointer data)
         if(!gtk_window_is_active(GTK_WINDOW(ctrl_usr->main_win)))
             gtk_window_set_urgency_hint(GTK_WINDOW(ctrl_usr->main_win), TRUE);
 	capture_complete();
+    } else if (ctrl_shm->state == STREAM) {
+	stream_copy_data();
+	refresh_display();
     } else if (ctrl_usr->run_mode == ROLL) capture_cont();
     return 1;
 }
@@ -328,6 +349,9 @@ void start_capture(void)
 	}
     }
     ctrl_shm->pre_trig = (ctrl_shm->rec_len-2) * ctrl_usr->trig.position;
+    if (ctrl_shm->stream) {
+	stream_prepare();
+    }
     ctrl_shm->state = INIT;
 }
 
@@ -366,6 +390,7 @@ void capture_copy_data(void) {
 	    src = ctrl_usr->buffer;
 	}
     }
+    display_data_changed();
 }
 
 void capture_cont()
@@ -521,11 +546,44 @@ static void save_configuration(int junk) {
 }
 
 
+static void do_record_stream(GtkWidget *w, GtkFileSelection *fs) {
+    int triggered;
+    triggered = GPOINTER_TO_INT(gtk_object_get_data(GTK_OBJECT(fs), "triggered"));
+    start_stream_record((char *)gtk_file_selection_get_filename(fs), triggered);
+}
+
+static void record_stream(int triggered) {
+    GtkWidget *filew;
+    filew = gtk_file_selection_new(triggered ?
+            _("Record Trigger Windows To:") : _("Record Stream To:"));
+    gtk_object_set_data(GTK_OBJECT(filew), "triggered", GINT_TO_POINTER(triggered));
+    gtk_signal_connect (GTK_OBJECT (filew), "destroy",
+        (GtkSignalFunc) gtk_widget_destroy, &filew);
+    gtk_signal_connect (GTK_OBJECT (GTK_FILE_SELECTION (filew)->ok_button),
+                        "clicked", (GtkSignalFunc) do_record_stream, filew );
+    //link ok to destroy, otherwise the window stays open
+    gtk_signal_connect_object (GTK_OBJECT (GTK_FILE_SELECTION
+                                            (filew)->ok_button),
+                               "clicked", (GtkSignalFunc) gtk_widget_destroy,
+                               GTK_OBJECT (filew));
+    gtk_signal_connect_object (GTK_OBJECT (GTK_FILE_SELECTION
+                                            (filew)->cancel_button),
+                               "clicked", (GtkSignalFunc) gtk_widget_destroy,
+                               GTK_OBJECT (filew));
+    gtk_file_selection_set_select_multiple(GTK_FILE_SELECTION(filew), FALSE);
+    gtk_dialog_run(GTK_DIALOG(filew));
+}
+
+static void stop_recording(int junk) {
+    stop_stream_record();
+}
+
 static void define_menubar(GtkWidget *vboxtop) {
     GtkWidget *file_rootmenu, *help_rootmenu;
     GtkWidget *menubar, *filemenu, 
               *fileopenconfiguration, *filesaveconfiguration, 
               *fileopendatafile, *filesavedatafile,
+              *filerecordstream, *filerecordtrig, *filestoprecord,
               *filequit, *sep1, *sep2;
     GtkWidget *helpmenu, *helpabout;
     GtkWidget *vbox;
@@ -562,6 +620,24 @@ static void define_menubar(GtkWidget *vboxtop) {
     gtk_signal_connect_object(GTK_OBJECT(filesavedatafile), "activate", 
             GTK_SIGNAL_FUNC(log_popup), 0);
     gtk_widget_show(filesavedatafile);
+
+    filerecordstream = gtk_menu_item_new_with_mnemonic(_("_Record Stream..."));
+    gtk_menu_append(GTK_MENU(filemenu), filerecordstream);
+    gtk_signal_connect_object(GTK_OBJECT(filerecordstream), "activate", 
+            GTK_SIGNAL_FUNC(record_stream), 0);
+    gtk_widget_show(filerecordstream);
+
+    filerecordtrig = gtk_menu_item_new_with_mnemonic(_("Record _Trigger Windows..."));
+    gtk_menu_append(GTK_MENU(filemenu), filerecordtrig);
+    gtk_signal_connect_object(GTK_OBJECT(filerecordtrig), "activate", 
+            GTK_SIGNAL_FUNC(record_stream), GINT_TO_POINTER(1));
+    gtk_widget_show(filerecordtrig);
+
+    filestoprecord = gtk_menu_item_new_with_mnemonic(_("Stop Recordin_g"));
+    gtk_menu_append(GTK_MENU(filemenu), filestoprecord);
+    gtk_signal_connect_object(GTK_OBJECT(filestoprecord), "activate", 
+            GTK_SIGNAL_FUNC(stop_recording), 0);
+    gtk_widget_show(filestoprecord);
     
     gtk_menu_append(GTK_MENU(filemenu), sep2);
     gtk_widget_show(sep2);
@@ -72,6 +72,8 @@ static int handle_scroll(GtkWidget *widget, GdkEventScroll *event, gpointer data
 static void conflict_avoid(int *y, int h);
 static int conflict_avoid_dy(int y, int h, int dy);
 static void conflict_reset(int height);
+static void build_envelopes(void);
+static double sample_value(scope_data_t *dptr, hal_type_t type);
 
 /***********************************************************************
 *                       PUBLIC FUNCTIONS                               *
@@ -102,6 +104,7 @@ void init_display(void)
 void invalidate_channel(int chan)
 {
     ctrl_usr->vert.data_offset[chan - 1] = -1;
+    display_data_changed();
 }
 
 void invalidate_all_channels(void)
@@ -111,6 +114,7 @@ void invalidate_all_channels(void)
     for (n = 0; n < 16; n++) {
 	ctrl_usr->vert.data_offset[n] = -1;
     }
+    display_data_changed();
 }
 
 void request_display_refresh(int delay)
@@ -127,48 +131,175 @@ void request_display_refresh(int delay)
 
 static int motion_x = -1, motion_y = -1;
 
-static void calculate_offset(int chan_num) {
-    int n;
-    scope_chan_t *chan = &(ctrl_usr->chan[chan_num]);
-    scope_data_t *dptr =
-        ctrl_usr->disp_buf + ctrl_usr->vert.data_offset[chan_num];
-    int type = chan->data_type;
+/* Every capture gets a min/max pyramid per channel: level 0 holds the
+   sample values as doubles, level L the min and max of each block of
+   2^L samples.  Drawing a zoomed out record then costs one or two
+   block lookups per pixel column instead of a pass over every sample.
+   The pyramid is rebuilt lazily after display_data_changed(), and the
+   resulting polyline of each channel is cached so that refreshes that
+   only move the cursor or the trigger line don't recompute it.
+*/
 
-    double sum=0, value;
+#define ENV_MAX_LEVELS 32
+
+typedef struct {
+    int len;			/* samples in level 0 */
+    int levels;			/* number of valid levels */
+    double *min[ENV_MAX_LEVELS];	/* level 0 is the samples themselves */
+    double *max[ENV_MAX_LEVELS];
+    double mean;		/* of the valid samples, for AC offset */
+} scope_env_t;
+
+typedef struct {
+    GdkPoint *points;		/* cached polyline */
+    int npoints, alloc;
+    unsigned int generation;	/* data_generation it was built for */
+    int start, end, height;	/* display geometry it was built for */
+    double xscale, xoffset, yscale, yfoffset, ypoffset;
+} scope_wave_cache_t;
+
+static unsigned int data_generation = 1;
+static unsigned int env_generation;
+static scope_env_t envelope[16];
+static scope_wave_cache_t wave_cache[16];
+
+void display_data_changed(void)
+{
+    data_generation++;
+}
 
-    if(!chan->ac_offset) return;
+static double sample_value(scope_data_t *dptr, hal_type_t type)
+{
+    switch (type) {
+    case HAL_BIT:
+	return dptr->d_u8 ? 1.0 : 0.0;
+    case HAL_FLOAT:
+	return dptr->d_real;
+    case HAL_S32:
+	return dptr->d_s32;
+    case HAL_U32:
+	return dptr->d_u32;
+    default:
+	return 0.0;
+    }
+}
 
-    for(n=0; n < ctrl_usr->samples; n++) {
-	switch (type) {
-	case HAL_BIT:
-	    if (dptr->d_u8) {
-		value = 1.0;
-	    } else {
-		value = 0.0;
-	    };
-	    break;
-	case HAL_FLOAT:
-	    value = dptr->d_real;
-	    break;
-	case HAL_S32:
-	    value = dptr->d_s32;
-	    break;
-	case HAL_U32:
-	    value = dptr->d_u32;
-	    break;
-	default:
-	    value = 0.0;
-	    break;
-        }
-        sum = sum + value;
+static void build_envelopes(void)
+{
+    int chan_num, n, len, plen, nlen, lev, sample_len;
+    scope_env_t *env;
+    scope_data_t *dptr;
+    hal_type_t type;
+    double sum, *lo, *hi, *plo, *phi;
+
+    if (env_generation == data_generation) {
+	return;
     }
-    if(n == 0) {
-        chan->vert_offset = 0;
-    } else {
-        chan->vert_offset = sum / n;
+    env_generation = data_generation;
+    /* every record the display can show is rec_len samples long */
+    len = ctrl_shm->rec_len;
+    sample_len = ctrl_shm->sample_len;
+    for (chan_num = 0; chan_num < 16; chan_num++) {
+	env = &(envelope[chan_num]);
+	for (lev = 0; lev < env->levels; lev++) {
+	    free(env->min[lev]);
+	    if (lev > 0) {
+		free(env->max[lev]);
+	    }
+	}
+	env->levels = 0;
+	env->len = 0;
+	env->mean = 0.0;
+	if (ctrl_usr->vert.data_offset[chan_num] < 0 || len <= 0) {
+	    continue;
+	}
+	type = ctrl_usr->chan[chan_num].data_type;
+	dptr = ctrl_usr->disp_buf + ctrl_usr->vert.data_offset[chan_num];
+	lo = malloc(len * sizeof(double));
+	if (lo == NULL) {
+	    continue;
+	}
+	sum = 0.0;
+	for (n = 0; n < len; n++) {
+	    lo[n] = sample_value(dptr, type);
+	    if (n < ctrl_usr->samples) {
+		sum += lo[n];
+	    }
+	    dptr += sample_len;
+	}
+	if (ctrl_usr->samples > 0) {
+	    env->mean = sum / ctrl_usr->samples;
+	}
+	env->min[0] = env->max[0] = lo;
+	env->levels = 1;
+	env->len = len;
+	/* each level halves the previous one, an odd last sample is
+	   paired with itself */
+	plen = len;
+	while (plen > 1 && env->levels < ENV_MAX_LEVELS) {
+	    plo = env->min[env->levels - 1];
+	    phi = env->max[env->levels - 1];
+	    nlen = (plen + 1) / 2;
+	    lo = malloc(nlen * sizeof(double));
+	    hi = malloc(nlen * sizeof(double));
+	    if (lo == NULL || hi == NULL) {
+		free(lo);
+		free(hi);
+		break;
+	    }
+	    for (n = 0; n < nlen; n++) {
+		lo[n] = plo[2 * n];
+		hi[n] = phi[2 * n];
+		if (2 * n + 1 < plen) {
+		    if (plo[2 * n + 1] < lo[n]) {
+			lo[n] = plo[2 * n + 1];
+		    }
+		    if (phi[2 * n + 1] > hi[n]) {
+			hi[n] = phi[2 * n + 1];
+		    }
+		}
+	    }
+	    env->min[env->levels] = lo;
+	    env->max[env->levels] = hi;
+	    env->levels++;
+	    plen = nlen;
+	}
     }
 }
 
+/* min and max of samples [n0, n1) of one channel.  Blocks are aligned,
+   so the range may be widened by less than one block at each end,
+   which is less than a pixel at the level chosen here. */
+static void envelope_minmax(scope_env_t *env, int n0, int n1,
+    double *min, double *max)
+{
+    int lev, i, i1;
+
+    lev = 0;
+    while (lev + 1 < env->levels && (2 << lev) <= n1 - n0) {
+	lev++;
+    }
+    i = n0 >> lev;
+    i1 = (n1 - 1) >> lev;
+    *min = env->min[lev][i];
+    *max = env->max[lev][i];
+    for (i++; i <= i1; i++) {
+	if (env->min[lev][i] < *min) {
+	    *min = env->min[lev][i];
+	}
+	if (env->max[lev][i] > *max) {
+	    *max = env->max[lev][i];
+	}
+    }
+}
+
+static void calculate_offset(int chan_num) {
+    scope_chan_t *chan = &(ctrl_usr->chan[chan_num]);
+
+    if(!chan->ac_offset) return;
+    chan->vert_offset = envelope[chan_num].mean;
+}
+
 void refresh_display(void)
 {
     int n;
@@ -229,6 +360,9 @@ void refresh_display(void)
     clear_display_window();
     draw_grid();
 
+    /* make sure the min/max pyramids match the display buffer */
+    build_envelopes();
+
     /* calculate offsets for AC-offset channels */
     for (n = 0; n < 16; n++) {
         if (vert->chan_enabled[n]) calculate_offset(n);
@@ -769,43 +903,166 @@ void draw_baseline(int chan_num, int highlight) {
 // #define DRAW_STEPPED
 // #define DRAW_SMOOTH
 
-void draw_waveform(int chan_num, int highlight)
+static int wave_y(double fy, double yfoffset, double yscale, double ypoffset)
 {
-    scope_data_t *dptr;
-    int start, end, n, sample_len;
-    scope_disp_t *disp;
-    scope_chan_t *chan;
-    double xscale, xoffset;
-    double yscale, yfoffset, ypoffset, fy, prev_fy = 0.;
-    hal_type_t type;
-    int x1, y1, x2, y2, miny, maxy, midx, ct, pn;
-    int first=1;
-    scope_horiz_t *horiz = &(ctrl_usr->horiz);
+    scope_disp_t *disp = &(ctrl_usr->disp);
+    int y;
+
+    y = ((fy - yfoffset) * yscale) + ypoffset;
+    if (y < -disp->height) {
+	y = -disp->height;
+    } else if (y > 2 * disp->height) {
+	y = 2 * disp->height;
+    }
+    return COORDINATE_CLIP(y);
+}
+
+/* returns the polyline for one channel, rebuilding it only if the data
+   or the display geometry changed since it was last built */
+static scope_wave_cache_t *wave_points(int chan_num)
+{
+    scope_disp_t *disp = &(ctrl_usr->disp);
+    scope_chan_t *chan = &(ctrl_usr->chan[chan_num - 1]);
+    scope_env_t *env = &(envelope[chan_num - 1]);
+    scope_wave_cache_t *wc = &(wave_cache[chan_num - 1]);
+    double xscale, xoffset, yscale, yfoffset, ypoffset, lo, hi;
+    int start, end, n, n1, pn, need, x1, y1, x2, y2, ya, yb, col, midx;
+    GdkPoint *points;
 
-    cursor_valid = 0;
-    disp = &(ctrl_usr->disp);
-    chan = &(ctrl_usr->chan[chan_num - 1]);
-    /* calculate a bunch of local vars */
-    sample_len = ctrl_shm->sample_len;
     xscale = disp->pixels_per_sample;
     xoffset = disp->horiz_offset;
-    miny = -disp->height;
-    maxy = 2 * disp->height;
-    type = chan->data_type;
     yscale = disp->height / (-10.0 * chan->scale);
     yfoffset = chan->vert_offset;
     ypoffset = chan->position * disp->height;
-    /* point to first sample in the record for this channel */
-    dptr = ctrl_usr->disp_buf + ctrl_usr->vert.data_offset[chan_num - 1];
-    /* point to first one that gets displayed */
     start = disp->start_sample;
     end = disp->end_sample;
-    ct = end - start + 1;
-    GdkPoint points[2*ct];
-    pn = 0;
-    n = start;
-    dptr += n * sample_len;
+    /* rec_len may have changed since the data was captured */
+    if (end > env->len - 1) {
+	end = env->len - 1;
+    }
+    if (wc->generation == env_generation && wc->start == start
+	&& wc->end == disp->end_sample && wc->height == disp->height
+	&& wc->xscale == xscale && wc->xoffset == xoffset
+	&& wc->yscale == yscale && wc->yfoffset == yfoffset
+	&& wc->ypoffset == ypoffset) {
+	return wc;
+    }
+    wc->generation = env_generation;
+    wc->start = start;
+    wc->end = disp->end_sample;
+    wc->height = disp->height;
+    wc->xscale = xscale;
+    wc->xoffset = xoffset;
+    wc->yscale = yscale;
+    wc->yfoffset = yfoffset;
+    wc->ypoffset = ypoffset;
+    wc->npoints = 0;
+    if (env->levels == 0 || end < start) {
+	return wc;
+    }
+    /* worst case is two points per sample or per pixel column */
+    need = 2 * (end - start + 1) + 2;
+    if (xscale < 1 && need > 2 * disp->width + 6) {
+	need = 2 * disp->width + 6;
+    }
+    if (need > wc->alloc) {
+	free(wc->points);
+	wc->points = malloc(need * sizeof(GdkPoint));
+	wc->alloc = wc->points ? need : 0;
+	if (wc->points == NULL) {
+	    return wc;
+	}
+    }
+    points = wc->points;
+    x1 = COORDINATE_CLIP((int)((start * xscale) - xoffset));
+    y1 = wave_y(env->min[0][start], yfoffset, yscale, ypoffset);
+    points[0].x = x1;
+    points[0].y = y1;
+    pn = 1;
+    if (xscale < 1) {
+	/* several samples per pixel column: draw the min/max envelope
+	   of each column, entering it from the end nearest the
+	   previous column */
+	n = start + 1;
+	while (n <= end) {
+	    col = (n * xscale) - xoffset;
+	    n1 = ((col + 1) + xoffset) / xscale;
+	    if (n1 <= n) {
+		n1 = n + 1;
+	    }
+	    while (n1 <= end && (int)((n1 * xscale) - xoffset) <= col) {
+		n1++;
+	    }
+	    if (n1 > end + 1) {
+		n1 = end + 1;
+	    }
+	    envelope_minmax(env, n, n1, &lo, &hi);
+	    x2 = COORDINATE_CLIP(col);
+	    ya = wave_y(hi, yfoffset, yscale, ypoffset);
+	    yb = wave_y(lo, yfoffset, yscale, ypoffset);
+	    if (abs(yb - y1) < abs(ya - y1)) {
+		y2 = ya;
+		ya = yb;
+		yb = y2;
+	    }
+	    if (points[pn - 1].x != x2 || points[pn - 1].y != ya) {
+		points[pn].x = x2;
+		points[pn].y = ya;
+		pn++;
+	    }
+	    if (yb != ya) {
+		points[pn].x = x2;
+		points[pn].y = yb;
+		pn++;
+	    }
+	    y1 = yb;
+	    n = n1;
+	}
+    } else {
+	for (n = start + 1; n <= end; n++) {
+	    x2 = COORDINATE_CLIP((int)((n * xscale) - xoffset));
+	    y2 = wave_y(env->min[0][n], yfoffset, yscale, ypoffset);
+#if defined(DRAW_SMOOTH)
+	    /* this is a smoothed line display */
+	    points[pn].x = x2; points[pn].y = y2; pn++;
+#elif defined(DRAW_STEPPED)
+	    /* this is a stepped one */
+	    points[pn].x = x1; points[pn].y = y2; pn++;
+	    points[pn].x = x2; points[pn].y = y2; pn++;
+#else
+	    /* this is halfway between the two extremes */
+	    midx = (x1 + x2) / 2;
+	    if(midx != x2) {
+		points[pn].x = midx; points[pn].y = y2; pn++;
+	    }
+	    points[pn].x = x2; points[pn].y = y2; pn++;
+#endif
+	    x1 = x2;
+	}
+    }
+    /* a single point is not a line */
+    wc->npoints = (pn > 1) ? pn : 0;
+    return wc;
+}
+
+void draw_waveform(int chan_num, int highlight)
+{
+    scope_disp_t *disp;
+    scope_chan_t *chan;
+    scope_env_t *env;
+    scope_wave_cache_t *wc;
+    double xscale, xoffset, yscale, yfoffset, ypoffset;
+    int n, x2, y2;
+    scope_horiz_t *horiz = &(ctrl_usr->horiz);
 
+    cursor_valid = 0;
+    disp = &(ctrl_usr->disp);
+    chan = &(ctrl_usr->chan[chan_num - 1]);
+    env = &(envelope[chan_num - 1]);
+    wc = wave_points(chan_num);
+    if (wc->npoints == 0) {
+	return;
+    }
 
     /* set color to draw */
     if (highlight) {
@@ -813,115 +1070,60 @@ void draw_waveform(int chan_num, int highlight)
     } else {
 	gdk_gc_set_foreground(disp->context, &(disp->color_normal[chan_num-1]));
     }
+    lines(chan_num, wc->points, wc->npoints);
+    if (!DRAWING) {
+	return;
+    }
 
-    x1 = y1 = 0;
-    while (n <= end) {
-	/* calc x coordinate of this point */
-	x2 = (n * xscale) - xoffset;
-	/* calc y coordinate of this point */
-	switch (type) {
-	case HAL_BIT:
-	    if (dptr->d_u8) {
-		fy = 1.0;
-	    } else {
-		fy = 0.0;
-	    };
-	    break;
-	case HAL_FLOAT:
-	    fy = dptr->d_real;
-	    break;
-	case HAL_S32:
-	    fy = dptr->d_s32;
-	    break;
-	case HAL_U32:
-	    fy = dptr->d_u32;
-	    break;
-	default:
-	    fy = 0.0;
-	    break;
+    xscale = disp->pixels_per_sample;
+    xoffset = disp->horiz_offset;
+    yscale = disp->height / (-10.0 * chan->scale);
+    yfoffset = chan->vert_offset;
+    ypoffset = chan->position * disp->height;
+    if (highlight) {
+	/* cursor is on the first sample at or right of the mouse */
+	n = disp->start_sample + 1;
+	if (xscale > 0 && (motion_x + xoffset) / xscale - 1 > n) {
+	    n = (motion_x + xoffset) / xscale - 1;
 	}
-	y2 = ((fy - yfoffset) * yscale) + ypoffset;
-	if (y2 < miny) {
-	    y2 = miny;
-	} else if (y2 > maxy) {
-	    y2 = maxy;
+	while (n <= wc->end && (int)((n * xscale) - xoffset) < motion_x) {
+	    n++;
 	}
-        x1 = COORDINATE_CLIP(x1);
-        x2 = COORDINATE_CLIP(x2);
-        y1 = COORDINATE_CLIP(y1);
-        y2 = COORDINATE_CLIP(y2);
-	/* don't draw segment ending at first point */
-	if (n > start) {
-            if(pn == 0) {
-                points[pn].x = x1; points[pn].y = y1; pn++;
-            }
-            if(xscale < 1) {
-                if(points[pn-1].x != x2 || points[pn-1].y != y2) {
-                    points[pn].x = x2; points[pn].y = y2; pn++;
-                }
-            } else {
-#if defined(DRAW_SMOOTH)
-                /* this is a smoothed line display */
-                points[pn].x = x2; points[pn].y = y2; pn++;
-#elif defined(DRAW_STEPPED)
-                /* this is a stepped one */
-                points[pn].x = x1; points[pn].y = y2; pn++;
-                points[pn].x = x2; points[pn].y = y2; pn++;
-#else
-                /* this is halfway between the two extremes */
-                midx = (x1 + x2) / 2;
-                if(midx != x2) {
-                    points[pn].x = midx; points[pn].y = y2; pn++;
-                }
-                points[pn].x = x2; points[pn].y = y2; pn++;
-#endif
-            }
-	    if(first && highlight && DRAWING && x2 >= motion_x) {
-		    first = 0;
-		    gdk_draw_arc(disp->win, disp->context, TRUE,
-				x2-3, y2-3, 7, 7, 0, 360*64);
-                    cursor_prev_value = prev_fy;
-                    cursor_value = fy;
-                    cursor_time = (n - ctrl_shm->pre_trig)*horiz->sample_period;
-                    cursor_valid = 1;
-	    }
+	if (n <= wc->end && n < env->len) {
+	    x2 = COORDINATE_CLIP((int)((n * xscale) - xoffset));
+	    y2 = wave_y(env->min[0][n], yfoffset, yscale, ypoffset);
+	    gdk_draw_arc(disp->win, disp->context, TRUE,
+		x2-3, y2-3, 7, 7, 0, 360*64);
+	    cursor_prev_value = env->min[0][n - 1];
+	    cursor_value = env->min[0][n];
+	    cursor_time = (n - ctrl_shm->pre_trig)*horiz->sample_period;
+	    cursor_valid = 1;
 	}
-	/* end of this segment is start of next one */
-	x1 = x2;
-	y1 = y2;
-
-	/* point to next sample */
-	dptr += sample_len;
-	n++;
-        prev_fy = fy;
-    }
-    if(pn) {
-        lines(chan_num, points, pn);
-        if(DRAWING) {
-            PangoLayout *p;
-            int y = points[0].y;
-            char scale[HAL_NAME_LEN];
-            char buffer[2 * HAL_NAME_LEN];
-            int h;
-            PangoRectangle r;
-
-            format_scale_value(scale, sizeof(scale), chan->scale);
-            snprintf(buffer, sizeof(buffer), "%s\n%s", chan->name, scale);
-            p=gtk_widget_create_pango_layout(disp->drawing, buffer);
-            pango_layout_get_extents(p, NULL, &r);
-            h = PANGO_PIXELS(r.height);
-
-            if(y < 0 || y+h > disp->height)
-                // if the first sample isn't visible, try the zero value
-                y = (0-yfoffset) * yscale + ypoffset;
-            if(y < 0 || y+h > disp->height)
-                // if that's not visible either, try the offset value
-                y = ypoffset;
-
-            conflict_avoid(&y, h);
-            gdk_draw_layout(disp->win, disp->context, 5, y, p);
-            g_object_unref(p);
-        }
+    }
+    {
+        PangoLayout *p;
+        int y = wc->points[0].y;
+        char scale[HAL_NAME_LEN];
+        char buffer[2 * HAL_NAME_LEN];
+        int h;
+        PangoRectangle r;
+
+        format_scale_value(scale, sizeof(scale), chan->scale);
+        snprintf(buffer, sizeof(buffer), "%s\n%s", chan->name, scale);
+        p=gtk_widget_create_pango_layout(disp->drawing, buffer);
+        pango_layout_get_extents(p, NULL, &r);
+        h = PANGO_PIXELS(r.height);
+
+        if(y < 0 || y+h > disp->height)
+            // if the first sample isn't visible, try the zero value
+            y = (0-yfoffset) * yscale + ypoffset;
+        if(y < 0 || y+h > disp->height)
+            // if that's not visible either, try the offset value
+            y = ypoffset;
+
+        conflict_avoid(&y, h);
+        gdk_draw_layout(disp->win, disp->context, 5, y, p);
+        g_object_unref(p);
     }
 }
 
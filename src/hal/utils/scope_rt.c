@@ -38,6 +38,7 @@
 #include "../hal_priv.h"	/* HAL private API decls */
 #include "scope_rt.h"		/* scope related declarations */
 #include "rtapi_string.h"
+#include "rtapi_atomic.h"
 
 /* module information */
 MODULE_AUTHOR("John Kasunich");
@@ -72,6 +73,7 @@ static void init_shm_control_struct(void);
 
 static void sample(void *arg, long period);
 static void capture_sample(void);
+static void stream_sample(void);
 static int check_trigger(void);
 
 /***********************************************************************
@@ -182,6 +184,21 @@ static void sample(void *arg, long period)
 	    ctrl_rt->data_type[n] = ctrl_shm->data_type[n];
 	    ctrl_rt->data_len[n] = ctrl_shm->data_len[n];
 	}
+	if (ctrl_shm->stream) {
+	    /* continuous capture, reset the ring */
+	    ctrl_shm->stream_head = 0;
+	    ctrl_shm->stream_tail = 0;
+	    ctrl_shm->stream_dropped = 0;
+	    ctrl_shm->trig_head = 0;
+	    ctrl_shm->trig_tail = 0;
+	    ctrl_rt->trig_lost = 0;
+	    ctrl_shm->stream_session++;
+	    ctrl_rt->stream_slots = ctrl_shm->buf_len / ctrl_shm->sample_len;
+	    /* dummy call to preset 'compare_result' */
+	    check_trigger();
+	    ctrl_shm->state = STREAM;
+	    break;
+	}
 	/* set next state */
 	ctrl_shm->state = PRE_TRIG;
 	break;
@@ -232,6 +249,9 @@ static void sample(void *arg, long period)
     case DONE:
 	/* do nothing while GUI displays waveform */
 	break;
+    case STREAM:
+	stream_sample();
+	break;
     default:
 	/* shouldn't get here - if we do, set a legal state */
 	ctrl_shm->state = IDLE;
@@ -282,6 +302,48 @@ static void capture_sample(void)
     }
 }
 
+/* In STREAM state the buffer is a ring of 'buf_len / sample_len'
+   whole samples.  'curr' advances and wraps exactly as it does for a
+   normal capture, so sample number N lives in slot N % ring size.
+   Samples are only written into slots the user has already consumed,
+   and trigger events are reported by sample number; it is up to the
+   user code to cut pre- and post-trigger windows out of the stream.
+*/
+static void stream_sample(void)
+{
+    unsigned int head, tail, trig_head, trig_tail;
+
+    head = ctrl_shm->stream_head;
+    tail = atomic_load_explicit(&ctrl_shm->stream_tail, memory_order_acquire);
+    if (head - tail >= ctrl_rt->stream_slots) {
+	/* user code fell behind, ring is full */
+	ctrl_shm->stream_dropped++;
+	return;
+    }
+    capture_sample();
+    atomic_store_explicit(&ctrl_shm->stream_head, head + 1,
+	memory_order_release);
+    if (check_trigger()) {
+	trig_head = ctrl_shm->trig_head;
+	trig_tail = atomic_load_explicit(&ctrl_shm->trig_tail,
+	    memory_order_acquire);
+	if (trig_head - trig_tail >= SCOPE_TRIG_RING) {
+	    /* trigger ring is full, the next stored event reports it */
+	    ctrl_rt->trig_lost++;
+	} else {
+	    ctrl_shm->trig_ring[trig_head % SCOPE_TRIG_RING].seq = head;
+	    ctrl_shm->trig_ring[trig_head % SCOPE_TRIG_RING].lost =
+		ctrl_rt->trig_lost;
+	    ctrl_rt->trig_lost = 0;
+	    atomic_store_explicit(&ctrl_shm->trig_head, trig_head + 1,
+		memory_order_release);
+	}
+	/* the stream never stops, so re-arm for the next one */
+	ctrl_shm->force_trig = 0;
+	ctrl_rt->auto_timer = 0;
+    }
+}
+
 // TODO: type-independent way to get high bit
 // #define SIGN_BIT (~(((ireal_t)~(ireal_t)0)>>1))
 static int check_trigger(void)
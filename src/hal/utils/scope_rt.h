@@ -49,6 +49,8 @@ typedef struct {
     scope_data_t *buffer;	/* ptr to buffer (kernel mapping) */
     int mult_cntr;		/* used to divide by 'mult' */
     int auto_timer;		/* delay timer for auto triggering */
+    unsigned int stream_slots;	/* ring size in samples when streaming */
+    unsigned int trig_lost;	/* triggers not stored since the last one */
     char data_len[16];		/* data size for each channel */
     void *data_addr[16];	/* pointers to data for each channel */
     hal_type_t data_type[16];	/* data type for each channel */
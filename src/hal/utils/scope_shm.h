@@ -43,6 +43,7 @@
 
 #define SCOPE_SHM_KEY  0x130CF406
 #define SCOPE_NUM_SAMPLES_DEFAULT 16000
+#define SCOPE_TRIG_RING 64	/* trigger events held while streaming */
 
 typedef enum {
     IDLE = 0,			/* waiting for run command */
@@ -51,7 +52,8 @@ typedef enum {
     TRIG_WAIT,			/* waiting for trigger */
     POST_TRIG,			/* acquiring post-trigger data */
     DONE,			/* data acquisition complete */
-    RESET			/* data acquisition interrupted */
+    RESET,			/* data acquisition interrupted */
+    STREAM			/* continuous acquisition into ring */
 } scope_state_t;
 
 /* this struct holds a single value - one sample of one channel */
@@ -91,6 +93,25 @@ typedef struct {
     int data_offset[16];	/* U data addr in shmem for each channel */
     hal_type_t data_type[16];	/* U data type for each channel */
     char data_len[16];		/* U data size, 0 if not to be acquired */
+    /* continuous capture: when 'stream' is set at INIT the buffer is
+       used as a ring of whole samples.  'stream_head' and
+       'stream_tail' count samples (modulo 2^32); the RT code never
+       overwrites a sample the user has not consumed, it counts it in
+       'stream_dropped' instead.  Trigger events go into the small ring
+       'trig_ring' the same way: 'trig_head' and 'trig_tail' count
+       events, a trigger that finds the ring full is not stored but
+       added to the 'lost' count of the next one that is. */
+    int stream;			/* U non-zero selects continuous capture */
+    int stream_session;		/* R incremented each time streaming starts */
+    unsigned int stream_head;	/* R samples written to the ring */
+    unsigned int stream_tail;	/* RU samples consumed by user code */
+    unsigned int stream_dropped;	/* R samples lost because ring was full */
+    unsigned int trig_head;	/* R trigger events written to trig_ring */
+    unsigned int trig_tail;	/* RU trigger events consumed by user code */
+    struct {
+	unsigned int seq;	/* R sample number of the trigger */
+	unsigned int lost;	/* R triggers not stored just before this one */
+    } trig_ring[SCOPE_TRIG_RING];
 } scope_shm_control_t;
 
 #endif /* HALSC_SHM_H */
@@ -0,0 +1,500 @@
+/** This file, 'scope_stream.c', implements continuous capture for
+    halscope.  The realtime part of the scope writes every sample into
+    a ring (see 'stream_sample()' in scope_rt.c), and a thread in this
+    file drains that ring into a compact binary recording, either
+    completely or only in windows around trigger events.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "rtapi_atomic.h"
+
+#include <gtk/gtk.h>
+#include "miscgtk.h"		/* generic GTK stuff */
+#include "scope_usr.h"		/* scope related declarations */
+
+/***********************************************************************
+*                         DOCUMENTATION                                *
+************************************************************************/
+
+/* A recording starts with the 16 byte file header 'scope_stream_file_t'
+   and is followed by records.  Each record is a 'scope_stream_rec_t'
+   followed by a payload that depends on 'kind'.  All values are in
+   host byte order.
+
+   SCOPE_REC_HEADER	starts a capture session, 'count' is the number of
+			channels.  Payload is the sample period in ns as a
+			64 bit int, then 'count' scope_stream_chan_t.  A
+			new session (and sample numbering from zero)
+			begins every time the scope is restarted.
+   SCOPE_REC_DATA	'count' consecutive samples starting at sample
+			number 'seq', each one scope_data_t per channel,
+			in header order.
+   SCOPE_REC_MINMAX	follows every DATA record; 'count' and 'seq' are
+			the same, payload is a min and a max double per
+			channel, for fast overviews of long recordings.
+   SCOPE_REC_TRIGGER	trigger event at sample number 'seq'.  'count' is
+			the number of events since the previous record,
+			more than one means the realtime trigger ring
+			was full and the others were lost.
+   SCOPE_REC_GAP	'count' samples were lost before sample 'seq'
+			because the ring overflowed.
+
+   In triggered mode DATA records only cover the window from
+   'pre_trig' samples before to 'rec_len - pre_trig' samples after
+   each trigger, overlapping windows are merged.
+*/
+
+/***********************************************************************
+*                         TYPEDEFS AND DEFINES                         *
+************************************************************************/
+
+#define STREAM_CHUNK		1024	/* max samples per DATA record */
+#define STREAM_POLL_US		10000	/* drain interval */
+
+/***********************************************************************
+*                         LOCAL VARIABLES                              *
+************************************************************************/
+
+static struct {
+    FILE *fp;			/* recording, NULL when not recording */
+    int triggered;		/* only record windows around triggers */
+    pthread_t thread;		/* drain thread */
+    pthread_mutex_t lock;	/* protects everything below */
+    volatile int stop;		/* tells drain thread to exit */
+    volatile int failed;	/* drain thread gave up, see stream_failed() */
+    /* channel layout, captured by the GUI in stream_prepare() */
+    int nchan;
+    scope_stream_chan_t chan[16];
+    long long period_ns;
+    int pre_trig, post_trig;
+    /* state of the current session */
+    int session;		/* ctrl_shm->stream_session, 0 = none */
+    unsigned long long seq;	/* samples consumed this session */
+    unsigned int dropped;	/* last value of stream_dropped */
+    unsigned int trig_tail;	/* trigger events consumed */
+    unsigned long long write_until;	/* end of current trigger window */
+    /* history of recent samples, for pre-trigger data and display */
+    scope_data_t *hist;
+    int hist_len;		/* size of history in samples */
+    int sample_len;		/* stride of one sample, in scope_data_t */
+    /* DATA record being assembled */
+    scope_data_t *chunk;
+    unsigned long long chunk_seq;
+    int chunk_n;
+} st = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+/***********************************************************************
+*                  LOCAL FUNCTION PROTOTYPES                           *
+************************************************************************/
+
+static void *drain_thread(void *arg);
+static int start_session(void);
+static void end_session(void);
+static void drain(void);
+static void append_sample(unsigned long long n, scope_data_t *src);
+static void flush_chunk(void);
+static void write_rec(int kind, int count, unsigned long long seq,
+    const void *payload, size_t len);
+static double sample_value(scope_data_t *dptr, hal_type_t type);
+
+/***********************************************************************
+*                        PUBLIC FUNCTION CODE                          *
+************************************************************************/
+
+int start_stream_record(char *filename, int triggered)
+{
+    scope_stream_file_t hdr;
+
+    if (st.fp != NULL) {
+	stop_stream_record();
+    }
+    st.fp = fopen(filename, "wb");
+    if (st.fp == NULL) {
+	fprintf(stderr, "halscope: stream file '%s' could not be created\n",
+	    filename);
+	return -1;
+    }
+    /* the drain thread writes in small pieces, buffer them */
+    setvbuf(st.fp, NULL, _IOFBF, 1 << 20);
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SCOPE_STREAM_MAGIC, sizeof(hdr.magic));
+    hdr.version = SCOPE_STREAM_VERSION;
+    fwrite(&hdr, sizeof(hdr), 1, st.fp);
+    st.triggered = triggered;
+    st.session = 0;
+    st.stop = 0;
+    st.failed = 0;
+    if (pthread_create(&st.thread, NULL, drain_thread, NULL) != 0) {
+	fprintf(stderr, "halscope: could not start stream thread\n");
+	fclose(st.fp);
+	st.fp = NULL;
+	return -1;
+    }
+    /* restart the scope with the ring enabled */
+    ctrl_shm->stream = 1;
+    prepare_scope_restart();
+    fprintf(stderr, "halscope: recording %s to '%s'\n",
+	triggered ? "trigger windows" : "all samples", filename);
+    return 0;
+}
+
+void stop_stream_record(void)
+{
+    if (st.fp == NULL) {
+	return;
+    }
+    st.stop = 1;
+    pthread_join(st.thread, NULL);
+    fclose(st.fp);
+    st.fp = NULL;
+    ctrl_shm->stream = 0;
+    prepare_scope_restart();
+    fprintf(stderr, "halscope: recording stopped\n");
+}
+
+int stream_recording(void)
+{
+    return st.fp != NULL;
+}
+
+/* true when the drain thread stopped on an error, the GUI then ends the
+   recording with stop_stream_record() */
+int stream_failed(void)
+{
+    return st.fp != NULL && st.failed;
+}
+
+/* called by start_capture() just before it sets the INIT state, so the
+   channel layout can be captured from the GUI thread */
+void stream_prepare(void)
+{
+    int n;
+    scope_chan_t *chan;
+    scope_stream_chan_t *sc;
+
+    pthread_mutex_lock(&st.lock);
+    /* the previous session may not have been closed yet */
+    end_session();
+    st.nchan = 0;
+    for (n = 0; n < 16; n++) {
+	if (ctrl_shm->data_len[n] == 0) {
+	    continue;
+	}
+	chan = &(ctrl_usr->chan[n]);
+	sc = &(st.chan[st.nchan++]);
+	memset(sc, 0, sizeof(*sc));
+	sc->chan_num = n + 1;
+	sc->type = chan->data_type;
+	if (chan->name != NULL) {
+	    strncpy(sc->name, chan->name, sizeof(sc->name) - 1);
+	}
+    }
+    st.period_ns = (long long)ctrl_usr->horiz.thread_period_ns * ctrl_shm->mult;
+    st.pre_trig = ctrl_shm->pre_trig;
+    st.post_trig = ctrl_shm->rec_len - ctrl_shm->pre_trig;
+    pthread_mutex_unlock(&st.lock);
+}
+
+/* copies the most recent 'rec_len' samples into the display buffer,
+   the streaming equivalent of capture_copy_data() */
+void stream_copy_data(void)
+{
+    int n, offs, samples;
+    unsigned long long first;
+    scope_data_t *dst;
+
+    offs = 0;
+    for (n = 0; n < 16; n++) {
+	if (ctrl_shm->data_len[n] > 0) {
+	    ctrl_usr->vert.data_offset[n] = offs++;
+	} else {
+	    ctrl_usr->vert.data_offset[n] = -1;
+	}
+    }
+    pthread_mutex_lock(&st.lock);
+    samples = 0;
+    if (st.session != 0) {
+	samples = ctrl_shm->rec_len;
+	if ((unsigned long long)samples > st.seq) {
+	    samples = st.seq;
+	}
+    }
+    dst = ctrl_usr->disp_buf;
+    first = st.seq - samples;
+    for (n = 0; n < samples; n++) {
+	memcpy(dst, st.hist + ((first + n) % st.hist_len) * st.sample_len,
+	    st.sample_len * sizeof(scope_data_t));
+	dst += st.sample_len;
+    }
+    ctrl_usr->samples = samples;
+    pthread_mutex_unlock(&st.lock);
+    display_data_changed();
+}
+
+/***********************************************************************
+*                         LOCAL FUNCTION CODE                          *
+************************************************************************/
+
+static void *drain_thread(void *arg)
+{
+    while (!st.stop) {
+	pthread_mutex_lock(&st.lock);
+	if (ctrl_shm->state != STREAM) {
+	    /* scope is being restarted, wait for the new session */
+	    end_session();
+	} else {
+	    if (st.session != ctrl_shm->stream_session) {
+		end_session();
+		if (start_session() < 0) {
+		    st.failed = 1;
+		    pthread_mutex_unlock(&st.lock);
+		    return NULL;
+		}
+	    }
+	    drain();
+	}
+	pthread_mutex_unlock(&st.lock);
+	usleep(STREAM_POLL_US);
+    }
+    pthread_mutex_lock(&st.lock);
+    if (ctrl_shm->state == STREAM && st.session == ctrl_shm->stream_session) {
+	/* pick up whatever arrived since the last poll */
+	drain();
+    }
+    end_session();
+    pthread_mutex_unlock(&st.lock);
+    return NULL;
+}
+
+static int start_session(void)
+{
+    char payload[sizeof(long long) + sizeof(st.chan)];
+    int slots;
+
+    st.seq = 0;
+    st.dropped = 0;
+    st.trig_tail = 0;
+    st.write_until = 0;
+    st.chunk_n = 0;
+    st.sample_len = ctrl_shm->sample_len;
+    /* a trigger is seen up to one full ring after its sample was
+       drained, keep enough history to still cut its pre-trigger window */
+    slots = ctrl_shm->buf_len / ctrl_shm->sample_len;
+    st.hist_len = slots + ctrl_shm->rec_len;
+    st.hist = malloc(sizeof(scope_data_t) * st.hist_len * st.sample_len);
+    st.chunk = malloc(sizeof(scope_data_t) * STREAM_CHUNK * st.nchan);
+    if (st.hist == NULL || st.chunk == NULL) {
+	fprintf(stderr, "halscope: out of memory for stream buffers\n");
+	free(st.hist);
+	free(st.chunk);
+	st.hist = NULL;
+	st.chunk = NULL;
+	return -1;
+    }
+    st.session = ctrl_shm->stream_session;
+    memcpy(payload, &st.period_ns, sizeof(long long));
+    memcpy(payload + sizeof(long long), st.chan,
+	st.nchan * sizeof(scope_stream_chan_t));
+    write_rec(SCOPE_REC_HEADER, st.nchan, 0, payload,
+	sizeof(long long) + st.nchan * sizeof(scope_stream_chan_t));
+    return 0;
+}
+
+static void end_session(void)
+{
+    if (st.session == 0) {
+	return;
+    }
+    flush_chunk();
+    fflush(st.fp);
+    free(st.hist);
+    free(st.chunk);
+    st.hist = NULL;
+    st.chunk = NULL;
+    st.session = 0;
+}
+
+static void drain(void)
+{
+    unsigned int head, tail, trig_head, trig_tail, dropped;
+    unsigned int slots, slot;
+    unsigned long long t, start, end;
+    scope_data_t *src, *dst;
+
+    /* read the trigger ring head before 'head', so every trigger
+       sample is among the samples drained below */
+    trig_head = atomic_load_explicit(&ctrl_shm->trig_head,
+	memory_order_acquire);
+    head = atomic_load_explicit(&ctrl_shm->stream_head, memory_order_acquire);
+    dropped = ctrl_shm->stream_dropped;
+    tail = (unsigned int)st.seq;
+    if (dropped != st.dropped) {
+	flush_chunk();
+	write_rec(SCOPE_REC_GAP, dropped - st.dropped, st.seq, NULL, 0);
+	st.dropped = dropped;
+    }
+    slots = ctrl_shm->buf_len / st.sample_len;
+    slot = tail % slots;
+    while (tail != head) {
+	src = ctrl_usr->buffer + slot * st.sample_len;
+	dst = st.hist + (st.seq % st.hist_len) * st.sample_len;
+	memcpy(dst, src, st.sample_len * sizeof(scope_data_t));
+	if (!st.triggered || st.seq < st.write_until) {
+	    append_sample(st.seq, dst);
+	}
+	st.seq++;
+	tail++;
+	if (++slot >= slots) {
+	    slot = 0;
+	}
+    }
+    /* hand the consumed slots back to the realtime code */
+    atomic_store_explicit(&ctrl_shm->stream_tail, tail, memory_order_release);
+    for (trig_tail = st.trig_tail; trig_tail != trig_head; trig_tail++) {
+	/* next trigger, its sample number relative to this session */
+	t = st.seq - (unsigned int)(tail
+	    - ctrl_shm->trig_ring[trig_tail % SCOPE_TRIG_RING].seq);
+	if (st.triggered) {
+	    /* write the part of its window that is already in history,
+	       a later trigger in the same pass writes its own window */
+	    start = (t > (unsigned long long)st.pre_trig) ? t - st.pre_trig : 0;
+	    if (start < st.write_until) {
+		start = st.write_until;
+	    }
+	    if (st.seq > (unsigned long long)st.hist_len
+		&& start < st.seq - st.hist_len) {
+		start = st.seq - st.hist_len;
+	    }
+	    end = t + st.post_trig;
+	    if (end > st.seq) {
+		end = st.seq;
+	    }
+	    for (; start < end; start++) {
+		append_sample(start,
+		    st.hist + (start % st.hist_len) * st.sample_len);
+	    }
+	    if (st.write_until < t + st.post_trig) {
+		st.write_until = t + st.post_trig;
+	    }
+	}
+	flush_chunk();
+	write_rec(SCOPE_REC_TRIGGER,
+	    1 + ctrl_shm->trig_ring[trig_tail % SCOPE_TRIG_RING].lost, t,
+	    NULL, 0);
+    }
+    /* hand the consumed trigger entries back as well */
+    st.trig_tail = trig_tail;
+    atomic_store_explicit(&ctrl_shm->trig_tail, trig_tail,
+	memory_order_release);
+}
+
+static void append_sample(unsigned long long n, scope_data_t *src)
+{
+    if (st.chunk_n > 0
+	&& (st.chunk_n == STREAM_CHUNK || n != st.chunk_seq + st.chunk_n)) {
+	flush_chunk();
+    }
+    if (st.chunk_n == 0) {
+	st.chunk_seq = n;
+    }
+    /* the ring only holds acquired channels, so the first 'nchan'
+       entries of a sample are exactly the recorded ones */
+    memcpy(st.chunk + st.chunk_n * st.nchan, src,
+	st.nchan * sizeof(scope_data_t));
+    st.chunk_n++;
+}
+
+static void flush_chunk(void)
+{
+    double minmax[32], v;
+    scope_data_t *dptr;
+    int n, c;
+
+    if (st.chunk_n == 0) {
+	return;
+    }
+    write_rec(SCOPE_REC_DATA, st.chunk_n, st.chunk_seq, st.chunk,
+	st.chunk_n * st.nchan * sizeof(scope_data_t));
+    for (c = 0; c < st.nchan; c++) {
+	minmax[2 * c] = minmax[2 * c + 1] = sample_value(st.chunk + c,
+	    st.chan[c].type);
+    }
+    dptr = st.chunk;
+    for (n = 0; n < st.chunk_n; n++) {
+	for (c = 0; c < st.nchan; c++) {
+	    v = sample_value(dptr++, st.chan[c].type);
+	    if (v < minmax[2 * c]) {
+		minmax[2 * c] = v;
+	    }
+	    if (v > minmax[2 * c + 1]) {
+		minmax[2 * c + 1] = v;
+	    }
+	}
+    }
+    write_rec(SCOPE_REC_MINMAX, st.chunk_n, st.chunk_seq, minmax,
+	st.nchan * 2 * sizeof(double));
+    st.chunk_n = 0;
+}
+
+static void write_rec(int kind, int count, unsigned long long seq,
+    const void *payload, size_t len)
+{
+    scope_stream_rec_t rec;
+
+    rec.kind = kind;
+    rec.count = count;
+    rec.seq = seq;
+    if (fwrite(&rec, sizeof(rec), 1, st.fp) != 1
+	|| (len > 0 && fwrite(payload, len, 1, st.fp) != 1)) {
+	fprintf(stderr, "halscope: error writing stream file\n");
+    }
+}
+
+static double sample_value(scope_data_t *dptr, hal_type_t type)
+{
+    switch (type) {
+    case HAL_BIT:
+	return dptr->d_u8 ? 1.0 : 0.0;
+    case HAL_FLOAT:
+	return dptr->d_real;
+    case HAL_S32:
+	return dptr->d_s32;
+    case HAL_U32:
+	return dptr->d_u32;
+    default:
+	return 0.0;
+    }
+}
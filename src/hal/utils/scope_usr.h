@@ -194,6 +194,37 @@ typedef struct {
 	GtkWidget *log_prefs_label;
 } scope_log_t;
 
+/* on-disk format of continuous recordings, see scope_stream.c */
+
+#define SCOPE_STREAM_MAGIC "HALSCSTR"
+#define SCOPE_STREAM_VERSION 1
+
+typedef enum {
+    SCOPE_REC_HEADER = 0,	/* session start, channel layout */
+    SCOPE_REC_DATA,		/* block of consecutive samples */
+    SCOPE_REC_MINMAX,		/* per channel min/max of previous DATA */
+    SCOPE_REC_TRIGGER,		/* trigger event */
+    SCOPE_REC_GAP		/* samples lost to ring overflow */
+} scope_stream_rec_kind_t;
+
+typedef struct {
+    char magic[8];		/* SCOPE_STREAM_MAGIC, not terminated */
+    rtapi_u32 version;		/* SCOPE_STREAM_VERSION */
+    rtapi_u32 reserved;
+} scope_stream_file_t;
+
+typedef struct {
+    rtapi_u32 kind;		/* scope_stream_rec_kind_t */
+    rtapi_u32 count;		/* samples, channels or events */
+    rtapi_u64 seq;		/* sample number within session */
+} scope_stream_rec_t;
+
+typedef struct {
+    rtapi_u32 chan_num;		/* scope channel, 1-16 */
+    rtapi_u32 type;		/* hal_type_t */
+    char name[HAL_NAME_LEN + 1];	/* pin, signal or param name */
+} scope_stream_chan_t;
+
 /* this is the master user space control structure */
 
 typedef enum { STOP = 0, NORMAL, SINGLE, ROLL } scope_run_mode_t;
@@ -255,6 +286,7 @@ void capture_cont(void);
 void start_capture(void);
 void request_display_refresh(int delay);
 void refresh_display(void);
+void display_data_changed(void);
 void refresh_trigger(void);
 void invalidate_channel(int chan);
 void invalidate_all_channels(void);
@@ -296,4 +328,12 @@ int set_trigger_mode(int mode);
 int set_run_mode(int mode);
 void prepare_scope_restart(void);
 void log_popup(int);
+
+/* continuous capture to disk, in scope_stream.c */
+int start_stream_record(char *filename, int triggered);
+void stop_stream_record(void);
+int stream_recording(void);
+int stream_failed(void);
+void stream_prepare(void);
+void stream_copy_data(void);
 #endif /* HALSC_USR_H */
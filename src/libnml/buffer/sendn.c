@@ -23,6 +23,8 @@
 #include <sys/socket.h>		/* send(), recv(), socket(), accept(),
 				   bind(), listen() */
 #include <sys/time.h>		/* struct timeval */
+#include <sys/uio.h>		/* writev(), struct iovec */
+#include <poll.h>		/* poll() */
 #include "sendn.h"		/* sendn() */
 #include "rcs_print.hh"		/* rcs_print_error() */
 #include "_timer.h"		/* etime(), esleep() */
@@ -117,3 +119,81 @@ int sendn(int fd, const void *vptr, int n, int _flags, double _timeout)
     rcs_print_debug(PRINT_SOCKET_WRITE_SIZE, "wrote %d bytes to %d\n", n, fd);
     return (n);
 }
+
+/* Write all the buffers described by iov[0..iovcnt-1] to a descriptor
+   with as few system calls as possible.  Unlike sendn() the descriptor
+   is not selected before the first write, so a header and its payload
+   normally leave in a single writev() and, with TCP_NODELAY set, in a
+   single segment.  poll() is only used to wait when the socket buffer is
+   full.  The iov array is modified to track partial writes. */
+int sendvn(int fd, struct iovec *iov, int iovcnt, double _timeout)
+{
+    ssize_t nwritten;
+    int total = 0;
+    int poll_ret;
+    int timeout_millis;
+    double start_time;
+    struct pollfd pfd;
+
+    start_time = etime();
+    while (iovcnt > 0 && iov->iov_len == 0) {
+	iov++;
+	iovcnt--;
+    }
+    while (iovcnt > 0) {
+	nwritten = writev(fd, iov, iovcnt);
+	if (nwritten < 0) {
+	    if (errno == EINTR) {
+		continue;
+	    }
+	    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+		rcs_print_error("Send error: %d = %s\n", errno,
+		    strerror(errno));
+		return -1;
+	    }
+	    nwritten = 0;
+	}
+	total += nwritten;
+	while (iovcnt > 0 && (size_t) nwritten >= iov->iov_len) {
+	    nwritten -= iov->iov_len;
+	    iov++;
+	    iovcnt--;
+	}
+	if (iovcnt == 0) {
+	    break;
+	}
+	iov->iov_base = (char *) iov->iov_base + nwritten;
+	iov->iov_len -= nwritten;
+
+	timeout_millis = -1;
+	if (_timeout > 0.0) {
+	    double timeleft = start_time + _timeout - etime();
+	    if (timeleft <= 0.0) {
+		if (print_sendn_timeout_errors) {
+		    rcs_print_error
+			("sendvn(fd=%d, iovcnt=%d, double _timeout=%f) timed out.\n",
+			fd, iovcnt, _timeout);
+		}
+		sendn_timedout = 1;
+		return -1;
+	    }
+	    timeout_millis = (int) (timeleft * 1000.0) + 1;
+	}
+	pfd.fd = fd;
+	pfd.events = POLLOUT;
+	pfd.revents = 0;
+	poll_ret = poll(&pfd, 1, timeout_millis);
+	if (poll_ret < 0 && errno != EINTR) {
+	    rcs_print_error("Error in poll: %d -> %s\n", errno,
+		strerror(errno));
+	    return -1;
+	}
+	if (poll_ret > 0 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) {
+	    rcs_print_error("sendvn(fd=%d): socket closed.\n", fd);
+	    return -1;
+	}
+    }
+    rcs_print_debug(PRINT_SOCKET_WRITE_SIZE, "wrote %d bytes to %d\n", total,
+	fd);
+    return total;
+}
@@ -24,8 +24,10 @@ extern "C" {
 #endif
 
 #include <stddef.h>		/* size_t */
+#include <sys/uio.h>		/* struct iovec */
 
     int sendn(int fd, const void *vptr, int n, int flags, double timeout);
+    int sendvn(int fd, struct iovec *iov, int iovcnt, double timeout);
 
 #ifdef __cplusplus
 };
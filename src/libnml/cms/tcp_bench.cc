@@ -0,0 +1,192 @@
+/********************************************************************
+* Description: tcp_bench.cc
+*   Latency benchmark for CMS_SERVER_REMOTE_TCP_PORT.
+*
+*   Opens an increasing number of client connections to a running NML
+*   TCP server (normally on the loopback interface) and has every client
+*   issue back to back read requests for one buffer, the way a remote
+*   GUI or DRO polls EMC_STAT.  For each client count the round trip
+*   times of all requests are collected and printed as one table row.
+*
+* Author:
+* License: LGPL Version 2
+* System: Linux
+*
+* Last change:
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <vector>
+#include <algorithm>
+
+#include "cms.hh"		/* CMS_READ_ACCESS */
+#include "rem_msg.hh"		/* REMOTE_CMS_READ_REQUEST_TYPE */
+#include "tcp_opts.hh"		/* set_tcp_socket_options() */
+extern "C" {
+#include "recvn.h"		/* recvn() */
+#include "sendn.h"		/* sendn() */
+}
+
+struct bench_client {
+    pthread_t thread;
+    struct sockaddr_in address;
+    int buffer_number;
+    int requests;
+    int failed;
+    std::vector<double> latencies;
+};
+
+static void putbe32(char *addr, uint32_t val) {
+    val = htonl(val);
+    memcpy(addr, &val, sizeof(val));
+}
+
+static uint32_t getbe32(char *addr) {
+    uint32_t val;
+    memcpy(&val, addr, sizeof(val));
+    return ntohl(val);
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *bench_client_run(void *arg)
+{
+    bench_client *c = (bench_client *) arg;
+    char header[20];
+    std::vector<char> data;
+    uint32_t serial_number = 0;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || set_tcp_socket_options(fd) < 0 ||
+	connect(fd, (struct sockaddr *) &c->address, sizeof(c->address)) < 0) {
+	perror("nml-tcp-bench: connect");
+	c->failed = 1;
+	if (fd >= 0) close(fd);
+	return 0;
+    }
+    c->latencies.reserve(c->requests);
+    for (int i = 0; i < c->requests; i++) {
+	putbe32(header, serial_number);
+	putbe32(header + 4, REMOTE_CMS_READ_REQUEST_TYPE);
+	putbe32(header + 8, c->buffer_number);
+	putbe32(header + 12, CMS_READ_ACCESS);
+	putbe32(header + 16, 0);	/* last_id_read: always get data */
+	double start = now();
+	if (sendn(fd, header, 20, 0, 5.0) < 0 ||
+	    recvn(fd, header, 20, 0, 5.0, NULL) < 0) {
+	    c->failed = 1;
+	    break;
+	}
+	uint32_t size = getbe32(header + 8);
+	if (size > 0) {
+	    data.resize(size);
+	    if (recvn(fd, &data[0], size, 0, 5.0, NULL) < 0) {
+		c->failed = 1;
+		break;
+	    }
+	}
+	c->latencies.push_back(now() - start);
+	serial_number++;
+    }
+    putbe32(header, serial_number);
+    putbe32(header + 4, REMOTE_CMS_CLOSE_CHANNEL_REQUEST_TYPE);
+    putbe32(header + 8, c->buffer_number);
+    sendn(fd, header, 20, 0, 1.0);
+    close(fd);
+    return 0;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+	"usage: %s [-h host] [-p port] [-b buffer_number] [-n requests]\n"
+	"          [-c max_clients]\n"
+	"Measure read request latency of a running NML TCP server for\n"
+	"1, 2, 4 ... max_clients concurrent clients.\n", name);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    const char *host = "127.0.0.1";
+    int port = 5005;
+    int buffer_number = 1;
+    int requests = 10000;
+    int max_clients = 16;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "h:p:b:n:c:")) != -1) {
+	switch (opt) {
+	case 'h': host = optarg; break;
+	case 'p': port = atoi(optarg); break;
+	case 'b': buffer_number = atoi(optarg); break;
+	case 'n': requests = atoi(optarg); break;
+	case 'c': max_clients = atoi(optarg); break;
+	default: usage(argv[0]);
+	}
+    }
+    if (requests < 1 || max_clients < 1) {
+	usage(argv[0]);
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    struct hostent *he = gethostbyname(host);
+    if (NULL == he) {
+	fprintf(stderr, "nml-tcp-bench: unknown host %s\n", host);
+	return 1;
+    }
+    memcpy(&address.sin_addr, he->h_addr_list[0], sizeof(address.sin_addr));
+
+    printf("%8s %12s %10s %10s %10s %10s\n", "clients", "requests/s",
+	"mean(us)", "p50(us)", "p99(us)", "max(us)");
+    for (int nclients = 1; nclients <= max_clients; nclients *= 2) {
+	std::vector<bench_client> clients(nclients);
+	double start = now();
+	for (int i = 0; i < nclients; i++) {
+	    clients[i].address = address;
+	    clients[i].buffer_number = buffer_number;
+	    clients[i].requests = requests;
+	    clients[i].failed = 0;
+	    pthread_create(&clients[i].thread, NULL, bench_client_run,
+		&clients[i]);
+	}
+	std::vector<double> all;
+	for (int i = 0; i < nclients; i++) {
+	    pthread_join(clients[i].thread, NULL);
+	    if (clients[i].failed) {
+		fprintf(stderr, "nml-tcp-bench: client %d failed\n", i);
+		return 1;
+	    }
+	    all.insert(all.end(), clients[i].latencies.begin(),
+		clients[i].latencies.end());
+	}
+	double elapsed = now() - start;
+	std::sort(all.begin(), all.end());
+	double sum = 0.0;
+	for (size_t i = 0; i < all.size(); i++) {
+	    sum += all[i];
+	}
+	printf("%8d %12.0f %10.1f %10.1f %10.1f %10.1f\n", nclients,
+	    all.size() / elapsed, 1e6 * sum / all.size(),
+	    1e6 * all[all.size() / 2], 1e6 * all[(all.size() * 99) / 100],
+	    1e6 * all.back());
+    }
+    return 0;
+}
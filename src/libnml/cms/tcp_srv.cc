@@ -31,6 +31,9 @@ extern "C" {
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>		/* epoll_create1(), epoll_wait() */
+#include <sys/uio.h>		/* struct iovec */
+#include <poll.h>		/* poll() */
 #include <errno.h>		/* errno */
 #include <signal.h>		// SIGPIPE, signal()
 
@@ -133,8 +136,11 @@ CMS_SERVER_REMOTE_PORT(_cms_server)
     client_ports = (LinkedList *) NULL;
     connection_socket = 0;
     connection_port = 0;
-    maxfdpl = 0;
+    epoll_fd = -1;
+    clients_closing = 0;
     dtimeout = 20.0;
+    subscription_updates_sent = 0;
+    subscription_updates_coalesced = 0;
 
     memset(&server_socket_address, 0, sizeof(server_socket_address));
     server_socket_address.sin_family = AF_INET;
@@ -147,13 +153,8 @@ CMS_SERVER_REMOTE_PORT(_cms_server)
 	return;
     }
     polling_enabled = 0;
-    memset(&select_timeout, 0, sizeof(select_timeout));
-    select_timeout.tv_sec = 30;
-    select_timeout.tv_usec = 30;
     subscription_buffers = NULL;
     current_poll_interval_millis = 30000;
-    memset(&read_fd_set, 0, sizeof(read_fd_set));
-    memset(&write_fd_set, 0, sizeof(write_fd_set));
 }
 
 CMS_SERVER_REMOTE_TCP_PORT::~CMS_SERVER_REMOTE_TCP_PORT()
@@ -219,6 +220,10 @@ void CMS_SERVER_REMOTE_TCP_PORT::unregister_port()
 	close(connection_socket);
 	connection_socket = 0;
     }
+    if (epoll_fd >= 0) {
+	close(epoll_fd);
+	epoll_fd = -1;
+    }
 }
 
 int CMS_SERVER_REMOTE_TCP_PORT::accept_local_port_cms(CMS * _cms)
@@ -301,208 +306,379 @@ static void handle_pipe_error(int signum)
     rcs_print_error("SIGPIPE intercepted.\n");
 }
 
+/* The server is driven by a single epoll set holding the listening socket
+   (registered with a NULL data pointer) and one entry per connected client
+   whose data pointer is the CLIENT_TCP_PORT itself, so a ready event leads
+   straight to its client without walking client_ports. */
 void CMS_SERVER_REMOTE_TCP_PORT::run()
 {
     int bytes_ready;
     int ready_descriptors;
+    int timeout_millis;
+    struct epoll_event ev;
+    struct epoll_event events[MAX_TCP_EPOLL_EVENTS];
     if (NULL == client_ports) {
 	rcs_print_error("CMS_SERVER: List of client ports is NULL.\n");
 	return;
     }
-    CLIENT_TCP_PORT *new_client_port, *client_port_to_check;
-    FD_ZERO(&read_fd_set);
-    FD_ZERO(&write_fd_set);
-    FD_SET(connection_socket, &read_fd_set);
-    maxfdpl = connection_socket + 1;
+    CLIENT_TCP_PORT *client_port_to_check;
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+	rcs_print_error("server: epoll_create1 error.(errno = %d | %s)\n",
+	    errno, strerror(errno));
+	return;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connection_socket, &ev) < 0) {
+	rcs_print_error("server: epoll_ctl error.(errno = %d | %s)\n",
+	    errno, strerror(errno));
+	return;
+    }
     signal(SIGPIPE, handle_pipe_error);
     rcs_print_debug(PRINT_CMS_CONFIG_INFO,
 	"running server for TCP port %d (connection_socket = %d).\n",
 	ntohs(server_socket_address.sin_port), connection_socket);
 
     cms_server_count++;
-    fd_set read_fd_set_copy, write_fd_set_copy;
-    FD_ZERO(&read_fd_set_copy);
-    FD_ZERO(&write_fd_set_copy);
-    FD_SET(connection_socket, &read_fd_set_copy);
 
     while (1) {
-	if (polling_enabled) {
-	    memcpy(&read_fd_set_copy, &read_fd_set, sizeof(fd_set));
-	    memcpy(&write_fd_set_copy, &write_fd_set, sizeof(fd_set));
-	    select_timeout.tv_sec = current_poll_interval_millis / 1000;
-	    select_timeout.tv_usec =
-		(current_poll_interval_millis % 1000) * 1000;
-	    ready_descriptors =
-		select(maxfdpl, &read_fd_set, &write_fd_set,
-		(fd_set *) NULL, (timeval *) & select_timeout);
-	    if (ready_descriptors == 0) {
-		update_subscriptions();
-		memcpy(&read_fd_set, &read_fd_set_copy, sizeof(fd_set));
-		memcpy(&write_fd_set, &write_fd_set_copy, sizeof(fd_set));
-		continue;
-	    }
-	} else {
-	    ready_descriptors =
-		select(maxfdpl, &read_fd_set, &write_fd_set,
-		(fd_set *) NULL, (timeval *) NULL);
-
+	timeout_millis = polling_enabled ? current_poll_interval_millis : -1;
+	ready_descriptors =
+	    epoll_wait(epoll_fd, events, MAX_TCP_EPOLL_EVENTS,
+	    timeout_millis);
+	if (ready_descriptors == 0) {
+	    update_subscriptions();
+	    close_failed_clients();
+	    continue;
 	}
 	if (ready_descriptors < 0) {
-	    rcs_print_error("server: select error.(errno = %d | %s)\n",
-		errno, strerror(errno));
+	    if (errno != EINTR) {
+		rcs_print_error("server: epoll_wait error.(errno = %d | %s)\n",
+		    errno, strerror(errno));
+	    }
+	    continue;
 	}
 	if (NULL == client_ports) {
 	    rcs_print_error("CMS_SERVER: List of client ports is NULL.\n");
 	    return;
 	}
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (FD_ISSET(client_port_to_check->socket_fd, &read_fd_set)) {
-		ioctl(client_port_to_check->socket_fd, FIONREAD,
-		    (caddr_t) & bytes_ready);
-		if (bytes_ready <= 0) {
+	for (int i = 0; i < ready_descriptors; i++) {
+	    client_port_to_check = (CLIENT_TCP_PORT *) events[i].data.ptr;
+	    if (NULL == client_port_to_check) {
+		accept_client_port();
+		continue;
+	    }
+	    bytes_ready = read_client_port(client_port_to_check);
+	    if (bytes_ready <= 0) {
+		if (bytes_ready == 0) {
 		    rcs_print_debug(PRINT_SOCKET_CONNECT,
 			"Socket closed by host with IP address %s.\n",
 			inet_ntoa(client_port_to_check->address.sin_addr));
-		    if (NULL != client_port_to_check->subscriptions) {
-			TCP_CLIENT_SUBSCRIPTION_INFO *clnt_sub_info =
-			    (TCP_CLIENT_SUBSCRIPTION_INFO *)
-			    client_port_to_check->subscriptions->get_head();
-			while (NULL != clnt_sub_info) {
-			    if (NULL != clnt_sub_info->sub_buf_info &&
-				clnt_sub_info->subscription_list_id >= 0) {
-				if (NULL !=
-				    clnt_sub_info->sub_buf_info->
-				    sub_clnt_info) {
-				    clnt_sub_info->sub_buf_info->
-					sub_clnt_info->
-					delete_node(clnt_sub_info->
-					subscription_list_id);
-				    if (clnt_sub_info->sub_buf_info->
-					sub_clnt_info->list_size < 1) {
-					delete clnt_sub_info->sub_buf_info->
-					    sub_clnt_info;
-					clnt_sub_info->sub_buf_info->
-					    sub_clnt_info = NULL;
-					if (NULL != subscription_buffers
-					    && clnt_sub_info->sub_buf_info->
-					    list_id >= 0) {
-					    subscription_buffers->
-						delete_node(clnt_sub_info->
-						sub_buf_info->list_id);
-					    delete clnt_sub_info->
-						sub_buf_info;
-					    clnt_sub_info->sub_buf_info =
-						NULL;
-					}
-				    }
-				    clnt_sub_info->sub_buf_info = NULL;
-				}
-				delete clnt_sub_info;
-				clnt_sub_info =
-				    (TCP_CLIENT_SUBSCRIPTION_INFO *)
-				    client_port_to_check->subscriptions->
-				    get_next();
-			    }
-			    delete client_port_to_check->subscriptions;
-			    client_port_to_check->subscriptions = NULL;
-			    recalculate_polling_interval();
-			}
-		    }
-		    if (client_port_to_check->threadId > 0
-			&& client_port_to_check->blocking) {
-			blocking_thread_kill(client_port_to_check->threadId);
-		    }
-		    close(client_port_to_check->socket_fd);
-		    FD_CLR(client_port_to_check->socket_fd, &read_fd_set);
-		    client_port_to_check->socket_fd = -1;
-		    delete client_port_to_check;
-		    client_ports->delete_current_node();
-		} else {
-		    if (client_port_to_check->blocking) {
-			if (client_port_to_check->threadId > 0) {
-			    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
-				"Data received from %s:%d when it should be blocking (bytes_ready=%d).\n",
-				inet_ntoa
-				(client_port_to_check->address.
-				    sin_addr),
-				client_port_to_check->socket_fd, bytes_ready);
-			    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
-				"Killing handler %d.\n",
-				client_port_to_check->threadId);
-
-			    blocking_thread_kill
-				(client_port_to_check->threadId);
-#if 0
-			    *((uint32_t *) temp_buffer) =
-				htonl(client_port_to_check->serial_number);
-			    *((uint32_t *) temp_buffer + 1) =
-				htonl((unsigned long)
-				CMS_SERVER_SIDE_ERROR);
-			    putbe32(temp_buffer + 8, 0);	/* size
-									 */
-			    putbe32(temp_buffer + 12, 0);	/* write_id
-									 */
-			    putbe32(temp_buffer + 16, 0);	/* was_read
-									 */
-			    sendn(client_port_to_check->socket_fd,
-				temp_buffer, 20, 0, dtimeout);
-#endif
-			    client_port_to_check->threadId = 0;
-			    client_port_to_check->blocking = 0;
-			}
-		    }
-		    handle_request(client_port_to_check);
 		}
-		ready_descriptors--;
-	    } else {
-		FD_SET(client_port_to_check->socket_fd, &read_fd_set);
+		if (bytes_ready != -EAGAIN) {
+		    close_client_port(client_port_to_check);
+		}
+		continue;
 	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
-	}
-	if (FD_ISSET(connection_socket, &read_fd_set)
-	    && ready_descriptors > 0) {
-	    ready_descriptors--;
-	    socklen_t client_address_length;
-	    new_client_port = new CLIENT_TCP_PORT();
-	    client_address_length = sizeof(new_client_port->address);
-	    new_client_port->socket_fd = accept(connection_socket,
-		(struct sockaddr *)
-		&new_client_port->address, &client_address_length);
-	    current_clients++;
-	    if (current_clients > max_clients) {
-		max_clients = current_clients;
+	    if (client_port_to_check->blocking) {
+		if (client_port_to_check->threadId > 0) {
+		    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
+			"Data received from %s:%d when it should be blocking (bytes_ready=%d).\n",
+			inet_ntoa(client_port_to_check->address.sin_addr),
+			client_port_to_check->socket_fd, bytes_ready);
+		    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
+			"Killing handler %d.\n",
+			client_port_to_check->threadId);
+
+		    blocking_thread_kill(client_port_to_check->threadId);
+		    client_port_to_check->threadId = 0;
+		    client_port_to_check->blocking = 0;
+		}
 	    }
-	    if (new_client_port->socket_fd < 0) {
-		rcs_print_error("server: accept error -- %d %s \n", errno,
-		    strerror(errno));
-		continue;
+	    handle_request(client_port_to_check);
+	    if (client_port_to_check->closing) {
+		close_client_port(client_port_to_check);
 	    }
-	    rcs_print_debug(PRINT_SOCKET_CONNECT,
-		"Socket opened by host with IP address %s.\n",
-		inet_ntoa(new_client_port->address.sin_addr));
-	    new_client_port->serial_number = 0;
-	    new_client_port->blocking = 0;
-	    if (NULL != client_ports) {
-		client_ports->store_at_tail(new_client_port,
-		    sizeof(new_client_port), 0);
+	}
+	update_subscriptions();
+	close_failed_clients();
+    }
+}
+
+void CMS_SERVER_REMOTE_TCP_PORT::accept_client_port()
+{
+    socklen_t client_address_length;
+    struct epoll_event ev;
+    CLIENT_TCP_PORT *new_client_port = new CLIENT_TCP_PORT();
+    client_address_length = sizeof(new_client_port->address);
+    new_client_port->socket_fd = accept(connection_socket,
+	(struct sockaddr *) &new_client_port->address,
+	&client_address_length);
+    if (new_client_port->socket_fd < 0) {
+	rcs_print_error("server: accept error -- %d %s \n", errno,
+	    strerror(errno));
+	delete new_client_port;
+	return;
+    }
+    current_clients++;
+    if (current_clients > max_clients) {
+	max_clients = current_clients;
+    }
+    rcs_print_debug(PRINT_SOCKET_CONNECT,
+	"Socket opened by host with IP address %s.\n",
+	inet_ntoa(new_client_port->address.sin_addr));
+    /* Replies are written header and payload together, so there is
+       nothing to gain from Nagle's algorithm delaying them. */
+    set_tcp_socket_options(new_client_port->socket_fd);
+    new_client_port->serial_number = 0;
+    new_client_port->blocking = 0;
+    new_client_port->list_id =
+	client_ports->store_at_tail(new_client_port,
+	sizeof(new_client_port), 0);
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = new_client_port;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, new_client_port->socket_fd,
+	    &ev) < 0) {
+	rcs_print_error("server: epoll_ctl error.(errno = %d | %s)\n",
+	    errno, strerror(errno));
+	close_client_port(new_client_port);
+    }
+}
+
+void CMS_SERVER_REMOTE_TCP_PORT::close_client_port(CLIENT_TCP_PORT *
+    _client_tcp_port)
+{
+    if (NULL != _client_tcp_port->subscriptions) {
+	remove_all_subscriptions(_client_tcp_port);
+    }
+    if (_client_tcp_port->threadId > 0 && _client_tcp_port->blocking) {
+	blocking_thread_kill(_client_tcp_port->threadId);
+    }
+    if (_client_tcp_port->closing) {
+	clients_closing--;
+    }
+    if (_client_tcp_port->socket_fd >= 0) {
+	if (epoll_fd >= 0) {
+	    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, _client_tcp_port->socket_fd,
+		NULL);
+	}
+	close(_client_tcp_port->socket_fd);
+	_client_tcp_port->socket_fd = -1;
+	current_clients--;
+    }
+    client_ports->delete_node(_client_tcp_port->list_id);
+    delete _client_tcp_port;
+}
+
+void CMS_SERVER_REMOTE_TCP_PORT::remove_all_subscriptions(CLIENT_TCP_PORT *
+    _client_tcp_port)
+{
+    TCP_CLIENT_SUBSCRIPTION_INFO *clnt_sub_info =
+	(TCP_CLIENT_SUBSCRIPTION_INFO *) _client_tcp_port->subscriptions->
+	get_head();
+    while (NULL != clnt_sub_info) {
+	TCP_BUFFER_SUBSCRIPTION_INFO *buf_info = clnt_sub_info->sub_buf_info;
+	if (NULL != buf_info && NULL != buf_info->sub_clnt_info) {
+	    buf_info->sub_clnt_info->delete_node(clnt_sub_info->
+		buffer_list_id);
+	    if (buf_info->sub_clnt_info->list_size < 1) {
+		if (NULL != subscription_buffers && buf_info->list_id >= 0) {
+		    subscription_buffers->delete_node(buf_info->list_id);
+		}
+		delete buf_info;
 	    }
-	    if (maxfdpl < new_client_port->socket_fd + 1) {
-		maxfdpl = new_client_port->socket_fd + 1;
+	}
+	clnt_sub_info->sub_buf_info = NULL;
+	delete clnt_sub_info;
+	clnt_sub_info =
+	    (TCP_CLIENT_SUBSCRIPTION_INFO *) _client_tcp_port->subscriptions->
+	    get_next();
+    }
+    delete _client_tcp_port->subscriptions;
+    _client_tcp_port->subscriptions = NULL;
+    recalculate_polling_interval();
+}
+
+/* Send a reply header and its payload with a single gathered write instead
+   of copying the payload behind the header in temp_buffer. */
+int CMS_SERVER_REMOTE_TCP_PORT::send_reply(CLIENT_TCP_PORT * _client_tcp_port,
+    char *header, int header_size, void *data, long size)
+{
+    struct iovec iov[2];
+    iov[0].iov_base = header;
+    iov[0].iov_len = header_size;
+    iov[1].iov_base = data;
+    iov[1].iov_len = (NULL != data && size > 0) ? size : 0;
+    if (_client_tcp_port->closing) {
+	return -1;
+    }
+    if (sendvn(_client_tcp_port->socket_fd, iov, 2, dtimeout) < 0) {
+	_client_tcp_port->errors++;
+	mark_client_closing(_client_tcp_port);
+	return -1;
+    }
+    return 0;
+}
+
+/* Any failed send may have left part of a reply on the stream, after
+   which the client can no longer find the start of the next one, so the
+   client is closed instead of being counted an error and kept.  Sends
+   happen while walking client and subscription lists, so the client is
+   only marked here and closed by run() once it is safe to delete it. */
+int CMS_SERVER_REMOTE_TCP_PORT::send_to_client(CLIENT_TCP_PORT *
+    _client_tcp_port, void *data, int size)
+{
+    if (_client_tcp_port->closing) {
+	return -1;
+    }
+    if (sendn(_client_tcp_port->socket_fd, data, size, 0, dtimeout) < 0) {
+	_client_tcp_port->errors++;
+	mark_client_closing(_client_tcp_port);
+	return -1;
+    }
+    return size;
+}
+
+void CMS_SERVER_REMOTE_TCP_PORT::mark_client_closing(CLIENT_TCP_PORT *
+    _client_tcp_port)
+{
+    if (!_client_tcp_port->closing) {
+	_client_tcp_port->closing = 1;
+	clients_closing++;
+    }
+}
+
+void CMS_SERVER_REMOTE_TCP_PORT::close_failed_clients()
+{
+    if (clients_closing <= 0 || NULL == client_ports) {
+	return;
+    }
+    CLIENT_TCP_PORT *client =
+	(CLIENT_TCP_PORT *) client_ports->get_head();
+    while (NULL != client) {
+	if (client->closing) {
+	    close_client_port(client);
+	    client = (CLIENT_TCP_PORT *) client_ports->get_head();
+	    continue;
+	}
+	client = (CLIENT_TCP_PORT *) client_ports->get_next();
+    }
+}
+
+/* Requests are read without blocking into the client's input buffer, so
+   a client sending a partial request cannot stall the others; it is
+   handled once all of it has arrived.  Returns the number of bytes
+   read, 0 when the peer closed the connection, -EAGAIN when nothing
+   was available and -1 on errors. */
+int CMS_SERVER_REMOTE_TCP_PORT::read_client_port(CLIENT_TCP_PORT *
+    _client_tcp_port)
+{
+    long total = 0;
+    while (1) {
+	if (_client_tcp_port->inbuf_size - _client_tcp_port->inbuf_len <
+	    0x1000) {
+	    long new_size = _client_tcp_port->inbuf_size * 2;
+	    if (new_size < 0x2000) {
+		new_size = 0x2000;
 	    }
-	    FD_SET(new_client_port->socket_fd, &read_fd_set);
-	} else {
-	    FD_SET(connection_socket, &read_fd_set);
+	    char *new_buf =
+		(char *) realloc(_client_tcp_port->inbuf, new_size);
+	    if (NULL == new_buf) {
+		rcs_print_error("server: out of memory for client input.\n");
+		return -1;
+	    }
+	    _client_tcp_port->inbuf = new_buf;
+	    _client_tcp_port->inbuf_size = new_size;
 	}
-	if (0 != ready_descriptors) {
-	    rcs_print_error("%d descriptors ready but not serviced.\n",
-		ready_descriptors);
+	ssize_t n = recv(_client_tcp_port->socket_fd,
+	    _client_tcp_port->inbuf + _client_tcp_port->inbuf_len,
+	    _client_tcp_port->inbuf_size - _client_tcp_port->inbuf_len,
+	    MSG_DONTWAIT);
+	if (n > 0) {
+	    _client_tcp_port->inbuf_len += n;
+	    total += n;
+	    continue;
 	}
-	update_subscriptions();
+	if (n == 0) {
+	    return total > 0 ? total : 0;
+	}
+	if (errno == EINTR) {
+	    continue;
+	}
+	if (errno == EAGAIN || errno == EWOULDBLOCK) {
+	    return total > 0 ? total : -EAGAIN;
+	}
+	rcs_print_error("server: recv error.(errno = %d | %s)\n",
+	    errno, strerror(errno));
+	return -1;
     }
 }
 
+/* Takes the next size bytes of the request being handled from the input
+   buffer; request_size() made sure they are all there. */
+int CMS_SERVER_REMOTE_TCP_PORT::recv_from_client(CLIENT_TCP_PORT *
+    _client_tcp_port, void *data, long size)
+{
+    if (_client_tcp_port->inbuf_pos + size > _client_tcp_port->inbuf_len) {
+	return -1;
+    }
+    memcpy(data, _client_tcp_port->inbuf + _client_tcp_port->inbuf_pos,
+	size);
+    _client_tcp_port->inbuf_pos += size;
+    return size;
+}
+
+/* The length of the request at the start of the input buffer, from its
+   header: 0 while the header is incomplete, -1 for a request that
+   cannot be valid. */
+long CMS_SERVER_REMOTE_TCP_PORT::request_size(CLIENT_TCP_PORT *
+    _client_tcp_port, CMS_SERVER * server)
+{
+    char *header = _client_tcp_port->inbuf;
+    long size = 20;
+    if (_client_tcp_port->inbuf_len < 20) {
+	return 0;
+    }
+    long request_type = ntohl(*((uint32_t *) header + 1));
+    long buffer_number = ntohl(*((uint32_t *) header + 2));
+    int subdivided = max_total_subdivisions > 1 &&
+	server->get_total_subdivisions(buffer_number) > 1;
+    switch (request_type) {
+    case REMOTE_CMS_SET_DIAG_INFO_REQUEST_TYPE:
+	size += 68;
+	break;
+    case REMOTE_CMS_BLOCKING_READ_REQUEST_TYPE:
+	size += subdivided ? 8 : 4;
+	break;
+    case REMOTE_CMS_READ_REQUEST_TYPE:
+	size += subdivided ? 4 : 0;
+	break;
+    case REMOTE_CMS_WRITE_REQUEST_TYPE:
+	{
+	    long data_size = ntohl(*((uint32_t *) header + 4));
+	    if (data_size < 0 || data_size > server->maximum_cms_size) {
+		rcs_print_error("server: write of %ld bytes is too large.\n",
+		    data_size);
+		return -1;
+	    }
+	    size += (subdivided ? 4 : 0) + data_size;
+	}
+	break;
+    case REMOTE_CMS_GET_KEYS_REQUEST_TYPE:
+	size += 16;
+	break;
+    case REMOTE_CMS_LOGIN_REQUEST_TYPE:
+	size += 32;
+	break;
+    default:
+	break;
+    }
+    return size;
+}
+
 static int tcpsvr_handle_blocking_request_sigint_count = 0;
 static int tcpsvr_last_sig = 0;
 
@@ -644,7 +820,6 @@ void *tcpsvr_handle_blocking_request(void *_req)
 void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
     _client_tcp_port)
 {
-    CLIENT_TCP_PORT *client_port_to_check = NULL;
     pid_t pid = getpid();
     pid_t tid = 0;
     CMS_SERVER *server;
@@ -660,32 +835,38 @@ void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
 	current_user_info = get_connected_user(_client_tcp_port->socket_fd);
     }
 
-    if (_client_tcp_port->errors >= _client_tcp_port->max_errors) {
-	rcs_print_error("Too many errors - closing connection(%d)\n",
-	    _client_tcp_port->socket_fd);
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (client_port_to_check->socket_fd ==
-		_client_tcp_port->socket_fd) {
-		delete client_port_to_check;
-		client_ports->delete_current_node();
-	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
+    while (!_client_tcp_port->closing) {
+	long size = request_size(_client_tcp_port, server);
+	if (size < 0) {
+	    rcs_print_error("Invalid request from client port (%d) from %s\n",
+		_client_tcp_port->socket_fd,
+		inet_ntoa(_client_tcp_port->address.sin_addr));
+	    mark_client_closing(_client_tcp_port);
+	    break;
 	}
-	close(_client_tcp_port->socket_fd);
-	current_clients--;
-	FD_CLR(_client_tcp_port->socket_fd, &read_fd_set);
-	_client_tcp_port->socket_fd = -1;
+	if (size == 0 || size > _client_tcp_port->inbuf_len) {
+	    break;
+	}
+	memcpy(temp_buffer, _client_tcp_port->inbuf, 20);
+	_client_tcp_port->inbuf_pos = 20;
+	handle_one_request(_client_tcp_port, server);
+	_client_tcp_port->inbuf_len -= size;
+	memmove(_client_tcp_port->inbuf, _client_tcp_port->inbuf + size,
+	    _client_tcp_port->inbuf_len);
+	_client_tcp_port->inbuf_pos = 0;
     }
+}
 
-    if (recvn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, -1, NULL) < 0) {
-	rcs_print_error("Can not read from client port (%d) from %s\n",
-	    _client_tcp_port->socket_fd,
-	    inet_ntoa(_client_tcp_port->address.sin_addr));
-	_client_tcp_port->errors++;
+void CMS_SERVER_REMOTE_TCP_PORT::handle_one_request(CLIENT_TCP_PORT *
+    _client_tcp_port, CMS_SERVER * server)
+{
+    if (_client_tcp_port->errors >= _client_tcp_port->max_errors) {
+	rcs_print_error("Too many errors - closing connection(%d)\n",
+	    _client_tcp_port->socket_fd);
+	mark_client_closing(_client_tcp_port);
 	return;
     }
+
     long request_type, buffer_number, received_serial_number;
     received_serial_number = getbe32(temp_buffer);
     if (received_serial_number != _client_tcp_port->serial_number) {
@@ -713,6 +894,9 @@ void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
 
     switch_function(_client_tcp_port,
 	server, request_type, buffer_number, received_serial_number);
+    if (request_type == REMOTE_CMS_CLOSE_CHANNEL_REQUEST_TYPE) {
+	return;
+    }
 
     if (NULL != _client_tcp_port->diag_info &&
 	NULL != server->last_local_port_used && server->diag_enabled) {
@@ -733,7 +917,6 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
     long request_type, long buffer_number, long received_serial_number)
 {
     int total_subdivisions = 1;
-    CLIENT_TCP_PORT *client_port_to_check = NULL;
     switch (request_type) {
     case REMOTE_CMS_SET_DIAG_INFO_REQUEST_TYPE:
 	{
@@ -741,9 +924,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		_client_tcp_port->diag_info =
 		    new REMOTE_SET_DIAG_INFO_REQUEST();
 	    }
-	    if (recvn
-		(_client_tcp_port->socket_fd, server->set_diag_info_buf, 68,
-		    0, -1, NULL) < 0) {
+	    if (recv_from_client(_client_tcp_port, server->set_diag_info_buf, 68) < 0) {
 		rcs_print_error
 		    ("Can not read from client port (%d) from %s\n",
 		    _client_tcp_port->socket_fd,
@@ -784,9 +965,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    if (NULL == diagreply) {
 		putbe32(temp_buffer, _client_tcp_port->serial_number);
 		putbe32(temp_buffer+4, CMS_SERVER_SIDE_ERROR);
-		if (sendn
-		    (_client_tcp_port->socket_fd, temp_buffer, 24, 0,
-			dtimeout) < 0) {
+		if (send_to_client(_client_tcp_port, temp_buffer, 24) < 0) {
 		    _client_tcp_port->errors++;
 		}
 		return;
@@ -794,9 +973,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    if (NULL == diagreply->cdi) {
 		putbe32(temp_buffer, _client_tcp_port->serial_number);
 		putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
-		if (sendn
-		    (_client_tcp_port->socket_fd, temp_buffer, 24, 0,
-			dtimeout) < 0) {
+		if (send_to_client(_client_tcp_port, temp_buffer, 24) < 0) {
 		    _client_tcp_port->errors++;
 		}
 		return;
@@ -943,9 +1120,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    }
 	    *((uint32_t *) temp_buffer + 6) = htonl(dpi_count);
 	    *((uint32_t *) temp_buffer + 7) = htonl(dpi_offset);
-	    if (sendn
-		(_client_tcp_port->socket_fd, temp_buffer, dpi_offset, 0,
-		    dtimeout) < 0) {
+	    if (send_to_client(_client_tcp_port, temp_buffer, dpi_offset) < 0) {
 		_client_tcp_port->errors++;
 		return;
 	    }
@@ -965,18 +1140,14 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		putbe32(temp_buffer, _client_tcp_port->serial_number);
 		putbe32(temp_buffer + 4, namereply->status);
 		strncpy(temp_buffer + 8, namereply->name, 31);
-		if (sendn
-		    (_client_tcp_port->socket_fd, temp_buffer, 40, 0,
-			dtimeout) < 0) {
+		if (send_to_client(_client_tcp_port, temp_buffer, 40) < 0) {
 		    _client_tcp_port->errors++;
 		    return;
 		}
 	    } else {
 		putbe32(temp_buffer, _client_tcp_port->serial_number);
 		putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
-		if (sendn
-		    (_client_tcp_port->socket_fd, temp_buffer, 40, 0,
-			dtimeout) < 0) {
+		if (send_to_client(_client_tcp_port, temp_buffer, 40) < 0) {
 		    _client_tcp_port->errors++;
 		    return;
 		}
@@ -1009,10 +1180,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		    server->get_total_subdivisions(buffer_number);
 	    }
 	    if (total_subdivisions > 1) {
-		if (recvn
-		    (_client_tcp_port->socket_fd,
-			(char *) (((uint32_t *) temp_buffer) + 5), 8, 0, -1,
-			NULL) < 0) {
+		if (recv_from_client(_client_tcp_port, (char *) (((uint32_t *) temp_buffer) + 5), 8) < 0) {
 		    rcs_print_error
 			("Can not read from client port (%d) from %s\n",
 			_client_tcp_port->socket_fd,
@@ -1023,10 +1191,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		blocking_read_req->subdiv =
 		    ntohl(*((uint32_t *) temp_buffer + 6));
 	    } else {
-		if (recvn
-		    (_client_tcp_port->socket_fd,
-			(char *) (((uint32_t *) temp_buffer) + 5), 4, 0, -1,
-			NULL) < 0) {
+		if (recv_from_client(_client_tcp_port, (char *) (((uint32_t *) temp_buffer) + 5), 4) < 0) {
 		    rcs_print_error
 			("Can not read from client port (%d) from %s\n",
 			_client_tcp_port->socket_fd,
@@ -1060,8 +1225,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		putbe32(temp_buffer + 8, 0);	/* size */
 		putbe32(temp_buffer + 12, 0);	/* write_id */
 		putbe32(temp_buffer + 16, 0);	/* was_read */
-		sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0,
-		    dtimeout);
+		send_to_client(_client_tcp_port, temp_buffer, 20);
 		return;
 	    }
 #else
@@ -1083,8 +1247,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		putbe32(temp_buffer + 8, 0);
 		putbe32(temp_buffer + 12, 0);
 		putbe32(temp_buffer + 16, 0);
-		sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0,
-		    dtimeout);
+		send_to_client(_client_tcp_port, temp_buffer, 20);
 		break;
 
 	    default:		// parent;
@@ -1101,7 +1264,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer + 8, 0);	/* size */
 	    putbe32(temp_buffer + 12, 0);	/* write_id */
 	    putbe32(temp_buffer + 16, 0);	/* was_read */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 20);
 	    return;
 
 #endif
@@ -1121,10 +1284,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		server->get_total_subdivisions(buffer_number);
 	}
 	if (total_subdivisions > 1) {
-	    if (recvn
-		(_client_tcp_port->socket_fd,
-		    (char *) (((uint32_t *) temp_buffer) + 5), 4, 0, -1,
-		    NULL) < 0) {
+	    if (recv_from_client(_client_tcp_port, (char *) (((uint32_t *) temp_buffer) + 5), 4) < 0) {
 		rcs_print_error
 		    ("Can not read from client port (%d) from %s\n",
 		    _client_tcp_port->socket_fd,
@@ -1143,7 +1303,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer + 8, 0);
 	    putbe32(temp_buffer + 12, 0);
 	    putbe32(temp_buffer + 16, 0);
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 20);
 	    return;
 	}
 	putbe32(temp_buffer, _client_tcp_port->serial_number);
@@ -1151,32 +1311,8 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	putbe32(temp_buffer + 8, server->read_reply->size);
 	putbe32(temp_buffer + 12, server->read_reply->write_id);
 	putbe32(temp_buffer + 16, server->read_reply->was_read);
-	if (server->read_reply->size < (0x2000 - 20)
-	    && server->read_reply->size > 0) {
-	    memcpy(temp_buffer + 20, server->read_reply->data,
-		server->read_reply->size);
-	    if (sendn
-		(_client_tcp_port->socket_fd, temp_buffer,
-		    20 + server->read_reply->size, 0, dtimeout) < 0) {
-		_client_tcp_port->errors++;
-		return;
-	    }
-	} else {
-	    if (sendn
-		(_client_tcp_port->socket_fd, temp_buffer, 20, 0,
-		    dtimeout) < 0) {
-		_client_tcp_port->errors++;
-		return;
-	    }
-	    if (server->read_reply->size > 0) {
-		if (sendn
-		    (_client_tcp_port->socket_fd, server->read_reply->data,
-			server->read_reply->size, 0, dtimeout) < 0) {
-		    _client_tcp_port->errors++;
-		    return;
-		}
-	    }
-	}
+	send_reply(_client_tcp_port, temp_buffer, 20,
+	    server->read_reply->data, server->read_reply->size);
 	break;
 
     case REMOTE_CMS_WRITE_REQUEST_TYPE:
@@ -1189,10 +1325,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		server->get_total_subdivisions(buffer_number);
 	}
 	if (total_subdivisions > 1) {
-	    if (recvn
-		(_client_tcp_port->socket_fd,
-		    (char *) (((uint32_t *) temp_buffer) + 5), 4, 0, -1,
-		    NULL) < 0) {
+	    if (recv_from_client(_client_tcp_port, (char *) (((uint32_t *) temp_buffer) + 5), 4) < 0) {
 		rcs_print_error
 		    ("Can not read from client port (%d) from %s\n",
 		    _client_tcp_port->socket_fd,
@@ -1205,9 +1338,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    server->write_req.subdiv = 0;
 	}
 	if (server->write_req.size > 0) {
-	    if (recvn
-		(_client_tcp_port->socket_fd, server->write_req.data,
-		    server->write_req.size, 0, -1, NULL) < 0) {
+	    if (recv_from_client(_client_tcp_port, server->write_req.data, server->write_req.size) < 0) {
 		_client_tcp_port->errors++;
 		return;
 	    }
@@ -1222,16 +1353,13 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	        putbe32(temp_buffer, reply->write_id);
 		putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
 		putbe32(temp_buffer + 8, 0);	/* was_read */
-		sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0,
-		    dtimeout);
+		send_to_client(_client_tcp_port, temp_buffer, 12);
 		return;
 	    }
 	    putbe32(temp_buffer, reply->write_id);
 	    putbe32(temp_buffer + 4, reply->status);
 	    putbe32(temp_buffer + 8, reply->was_read);
-	    if (sendn
-		(_client_tcp_port->socket_fd, temp_buffer, 12, 0,
-		    dtimeout) < 0) {
+	    if (send_to_client(_client_tcp_port, temp_buffer, 12) < 0) {
 		_client_tcp_port->errors++;
 	    }
 	} else {
@@ -1253,7 +1381,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
 	    putbe32(temp_buffer + 8, 0);	/* was_read */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 12);
 	    return;
 	}
 	putbe32(temp_buffer, _client_tcp_port->serial_number);
@@ -1261,7 +1389,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    htonl(server->check_if_read_reply->status);
 	*((uint32_t *) temp_buffer + 2) =
 	    htonl(server->check_if_read_reply->was_read);
-	if (sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout) <
+	if (send_to_client(_client_tcp_port, temp_buffer, 12) <
 	    0) {
 	    _client_tcp_port->errors++;
 	}
@@ -1279,7 +1407,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
 	    putbe32(temp_buffer + 8, 0);	/* was_read */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 12);
 	    return;
 	}
 	putbe32(temp_buffer, _client_tcp_port->serial_number);
@@ -1287,7 +1415,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    htonl(server->get_msg_count_reply->status);
 	*((uint32_t *) temp_buffer + 2) =
 	    htonl(server->get_msg_count_reply->count);
-	if (sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout) <
+	if (send_to_client(_client_tcp_port, temp_buffer, 12) <
 	    0) {
 	    _client_tcp_port->errors++;
 	}
@@ -1305,7 +1433,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
 	    putbe32(temp_buffer + 8, 0);	/* was_read */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 12);
 	    return;
 	}
 	putbe32(temp_buffer, _client_tcp_port->serial_number);
@@ -1313,7 +1441,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    htonl(server->get_queue_length_reply->status);
 	*((uint32_t *) temp_buffer + 2) =
 	    htonl(server->get_queue_length_reply->queue_length);
-	if (sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout) <
+	if (send_to_client(_client_tcp_port, temp_buffer, 12) <
 	    0) {
 	    _client_tcp_port->errors++;
 	}
@@ -1331,7 +1459,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
 	    putbe32(temp_buffer + 8, 0);	/* was_read */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 12);
 	    return;
 	}
 	putbe32(temp_buffer, _client_tcp_port->serial_number);
@@ -1339,7 +1467,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    htonl(server->get_space_available_reply->status);
 	*((uint32_t *) temp_buffer + 2) =
 	    htonl(server->get_space_available_reply->space_available);
-	if (sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout) <
+	if (send_to_client(_client_tcp_port, temp_buffer, 12) <
 	    0) {
 	    _client_tcp_port->errors++;
 	}
@@ -1355,12 +1483,12 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    rcs_print_error("Server could not process request.\n");
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 8);
 	    return;
 	}
 	putbe32(temp_buffer, _client_tcp_port->serial_number);
 	putbe32(temp_buffer + 4, server->clear_reply->status);
-	if (sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout) <
+	if (send_to_client(_client_tcp_port, temp_buffer, 8) <
 	    0) {
 	    _client_tcp_port->errors++;
 	}
@@ -1372,30 +1500,12 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	break;
 
     case REMOTE_CMS_CLOSE_CHANNEL_REQUEST_TYPE:
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (client_port_to_check->socket_fd ==
-		_client_tcp_port->socket_fd) {
-		break;
-	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
-	}
-	FD_CLR(_client_tcp_port->socket_fd, &read_fd_set);
-	close(_client_tcp_port->socket_fd);
-	current_clients--;
-	if (NULL != _client_tcp_port->subscriptions) {
-	    remove_subscription_client(_client_tcp_port, buffer_number);
-	}
-	_client_tcp_port->socket_fd = -1;
-	delete _client_tcp_port;
-	client_ports->delete_current_node();
+	mark_client_closing(_client_tcp_port);
 	break;
 
     case REMOTE_CMS_GET_KEYS_REQUEST_TYPE:
 	server->get_keys_req.buffer_number = buffer_number;
-	if (recvn(_client_tcp_port->socket_fd,
-		server->get_keys_req.name, 16, 0, -1, NULL) < 0) {
+	if (recv_from_client(_client_tcp_port, server->get_keys_req.name, 16) < 0) {
 	    _client_tcp_port->errors++;
 	    return;
 	}
@@ -1408,7 +1518,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    server->gen_random_key(((char *) temp_buffer) + 4, 2);
 	    server->gen_random_key(((char *) temp_buffer) + 12, 2);
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 20);
 	    return;
 	} else {
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
@@ -1417,20 +1527,18 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    memcpy(((char *) temp_buffer) + 12, server->get_keys_reply->key2,
 		8);
 	    /* successful ? */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 20);
 	    return;
 	}
 	break;
 
     case REMOTE_CMS_LOGIN_REQUEST_TYPE:
 	server->login_req.buffer_number = buffer_number;
-	if (recvn(_client_tcp_port->socket_fd,
-		server->login_req.name, 16, 0, -1, NULL) < 0) {
+	if (recv_from_client(_client_tcp_port, server->login_req.name, 16) < 0) {
 	    _client_tcp_port->errors++;
 	    return;
 	}
-	if (recvn(_client_tcp_port->socket_fd,
-		server->login_req.passwd, 16, 0, -1, NULL) < 0) {
+	if (recv_from_client(_client_tcp_port, server->login_req.passwd, 16) < 0) {
 	    _client_tcp_port->errors++;
 	    return;
 	}
@@ -1441,13 +1549,13 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    rcs_print_error("Server could not process request.\n");
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, 0);	/* not successful */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 8);
 	    return;
 	} else {
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, server->login_reply->success);
 	    /* successful ? */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 8);
 	    return;
 	}
 	break;
@@ -1465,7 +1573,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    rcs_print_error("Server could not process request.\n");
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, 0);	/* not successful */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 8);
 	    return;
 	} else {
 	    if (server->set_subscription_reply->success) {
@@ -1489,7 +1597,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    *((uint32_t *) temp_buffer + 1) =
 		htonl(server->set_subscription_reply->success);
 	    /* successful ? */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout);
+	    send_to_client(_client_tcp_port, temp_buffer, 8);
 	    return;
 	}
 	break;
@@ -1554,7 +1662,8 @@ void CMS_SERVER_REMOTE_TCP_PORT::add_subscription_client(int buffer_number,
 	temp_clnt_info->subscription_list_id =
 	    clnt->subscriptions->store_at_tail(temp_clnt_info,
 	    sizeof(*temp_clnt_info), 0);
-	buf_info->sub_clnt_info->store_at_tail(temp_clnt_info,
+	temp_clnt_info->buffer_list_id =
+	    buf_info->sub_clnt_info->store_at_tail(temp_clnt_info,
 	    sizeof(*temp_clnt_info), 0);
     }
     temp_clnt_info->subscription_type = subscription_type;
@@ -1565,6 +1674,9 @@ void CMS_SERVER_REMOTE_TCP_PORT::add_subscription_client(int buffer_number,
 void CMS_SERVER_REMOTE_TCP_PORT::remove_subscription_client(CLIENT_TCP_PORT *
     clnt, int buffer_number)
 {
+    if (NULL == clnt->subscriptions) {
+	return;
+    }
     TCP_CLIENT_SUBSCRIPTION_INFO *temp_clnt_info =
 	(TCP_CLIENT_SUBSCRIPTION_INFO *) clnt->subscriptions->get_head();
     while (temp_clnt_info != NULL) {
@@ -1572,7 +1684,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::remove_subscription_client(CLIENT_TCP_PORT *
 	    if (NULL != temp_clnt_info->sub_buf_info) {
 		if (NULL != temp_clnt_info->sub_buf_info->sub_clnt_info) {
 		    temp_clnt_info->sub_buf_info->sub_clnt_info->
-			delete_node(temp_clnt_info->subscription_list_id);
+			delete_node(temp_clnt_info->buffer_list_id);
 		    if (temp_clnt_info->sub_buf_info->sub_clnt_info->
 			list_size == 0) {
 			subscription_buffers->delete_node(temp_clnt_info->
@@ -1584,6 +1696,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::remove_subscription_client(CLIENT_TCP_PORT *
 		    }
 		}
 	    }
+	    clnt->subscriptions->delete_current_node();
 	    delete temp_clnt_info;
 	    temp_clnt_info = NULL;
 	    break;
@@ -1598,6 +1711,9 @@ void CMS_SERVER_REMOTE_TCP_PORT::recalculate_polling_interval()
 {
     int min_poll_interval_millis = 30000;
     polling_enabled = 0;
+    if (NULL == subscription_buffers) {
+	return;
+    }
     TCP_BUFFER_SUBSCRIPTION_INFO *buf_info =
 	(TCP_BUFFER_SUBSCRIPTION_INFO *) subscription_buffers->get_head();
     while (NULL != buf_info) {
@@ -1613,6 +1729,14 @@ void CMS_SERVER_REMOTE_TCP_PORT::recalculate_polling_interval()
 		    temp_clnt_info->poll_interval_millis;
 		polling_enabled = 1;
 	    }
+	    /* Variable subscriptions are pushed as soon as the buffer
+	       changes, so check them at the finest interval available
+	       rather than only when some other request wakes us up. */
+	    if (temp_clnt_info->subscription_type ==
+		CMS_VARIABLE_SUBSCRIPTION) {
+		min_poll_interval_millis = 0;
+		polling_enabled = 1;
+	    }
 	    temp_clnt_info = (TCP_CLIENT_SUBSCRIPTION_INFO *)
 		buf_info->sub_clnt_info->get_next();
 	}
@@ -1624,9 +1748,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::recalculate_polling_interval()
     } else {
 	current_poll_interval_millis = ((int) (clk_tck() * 1000.0));
     }
-    select_timeout.tv_sec = current_poll_interval_millis / 1000;
-    select_timeout.tv_usec = (current_poll_interval_millis % 1000) * 1000;
-    dtimeout = (current_poll_interval_millis + 10) * 1000.0;
+    dtimeout = (current_poll_interval_millis + 10) / 1000.0;
     if (dtimeout < 0.5) {
 	dtimeout = 0.5;
     }
@@ -1689,34 +1811,27 @@ void CMS_SERVER_REMOTE_TCP_PORT::update_subscriptions()
 		    CMS_VARIABLE_SUBSCRIPTION)
 		&& temp_clnt_info->last_id_read !=
 		server->read_reply->write_id) {
-		temp_clnt_info->last_id_read = server->read_reply->write_id;
-		temp_clnt_info->last_sub_sent_time = cur_time;
-		temp_clnt_info->clnt_port->serial_number++;
-		putbe32(temp_buffer, temp_clnt_info->clnt_port->serial_number);
-		if (server->read_reply->size < 0x2000 - 20
-		    && server->read_reply->size > 0) {
-		    memcpy(temp_buffer + 20, server->read_reply->data,
-			server->read_reply->size);
-		    if (sendn
-			(temp_clnt_info->clnt_port->socket_fd, temp_buffer,
-			    20 + server->read_reply->size, 0, dtimeout) < 0) {
-			temp_clnt_info->clnt_port->errors++;
-			return;
-		    }
+		/* A client that has not drained the previous update yet
+		   is skipped rather than blocking the whole server in
+		   sendvn().  Its last_id_read is left alone, so it gets
+		   only the newest message once its socket is writable
+		   again and intermediate updates are coalesced. */
+		struct pollfd pfd;
+		pfd.fd = temp_clnt_info->clnt_port->socket_fd;
+		pfd.events = POLLOUT;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, 0) != 1 || !(pfd.revents & POLLOUT)) {
+		    subscription_updates_coalesced++;
 		} else {
-		    if (sendn(temp_clnt_info->clnt_port->socket_fd,
-			    temp_buffer, 20, 0, dtimeout) < 0) {
-			temp_clnt_info->clnt_port->errors++;
-			return;
-		    }
-		    if (server->read_reply->size > 0) {
-			if (sendn(temp_clnt_info->clnt_port->socket_fd,
-				server->read_reply->data,
-				server->read_reply->size, 0, dtimeout) < 0) {
-			    temp_clnt_info->clnt_port->errors++;
-			    return;
-			}
-		    }
+		    temp_clnt_info->last_id_read =
+			server->read_reply->write_id;
+		    temp_clnt_info->last_sub_sent_time = cur_time;
+		    temp_clnt_info->clnt_port->serial_number++;
+		    putbe32(temp_buffer,
+			temp_clnt_info->clnt_port->serial_number);
+		    send_reply(temp_clnt_info->clnt_port, temp_buffer, 20,
+			server->read_reply->data, server->read_reply->size);
+		    subscription_updates_sent++;
 		}
 	    }
 	    if (temp_clnt_info->last_id_read < buf_info->min_last_id) {
@@ -1755,6 +1870,7 @@ TCP_CLIENT_SUBSCRIPTION_INFO::TCP_CLIENT_SUBSCRIPTION_INFO()
     poll_interval_millis = 30000;
     last_sub_sent_time = 0.0;
     subscription_list_id = -1;
+    buffer_list_id = -1;
     buffer_number = -1;
     subscription_paused = 0;
     last_id_read = 0;
@@ -1768,6 +1884,7 @@ TCP_CLIENT_SUBSCRIPTION_INFO::~TCP_CLIENT_SUBSCRIPTION_INFO()
     poll_interval_millis = 30000;
     last_sub_sent_time = 0.0;
     subscription_list_id = -1;
+    buffer_list_id = -1;
     buffer_number = -1;
     subscription_paused = 0;
     last_id_read = 0;
@@ -1784,12 +1901,18 @@ CLIENT_TCP_PORT::CLIENT_TCP_PORT()
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = htonl(INADDR_ANY);
     socket_fd = -1;
+    list_id = -1;
     subscriptions = NULL;
     tid = -1;
     pid = -1;
     blocking_read_req = NULL;
     threadId = 0;
     diag_info = NULL;
+    inbuf = NULL;
+    inbuf_size = 0;
+    inbuf_len = 0;
+    inbuf_pos = 0;
+    closing = 0;
 }
 
 CLIENT_TCP_PORT::~CLIENT_TCP_PORT()
@@ -1809,6 +1932,10 @@ CLIENT_TCP_PORT::~CLIENT_TCP_PORT()
 	delete subscriptions;
 	subscriptions = NULL;
     }
+    if (NULL != inbuf) {
+	free(inbuf);
+	inbuf = NULL;
+    }
 #ifdef NO_THREADS
     if (NULL != blocking_read_req) {
 	delete blocking_read_req;
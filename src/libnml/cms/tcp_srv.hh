@@ -42,6 +42,7 @@ extern "C" {
 #endif
 
 #define MAX_TCP_BUFFER_SIZE 16
+#define MAX_TCP_EPOLL_EVENTS 64
 class CLIENT_TCP_PORT;
 
 class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
@@ -53,10 +54,24 @@ class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
     void register_port();
     void unregister_port();
     double dtimeout;
+    long subscription_updates_sent;
+    long subscription_updates_coalesced;
   protected:
-      fd_set read_fd_set, write_fd_set;
+    int epoll_fd;
     void handle_request(CLIENT_TCP_PORT *);
-    int maxfdpl;
+    void handle_one_request(CLIENT_TCP_PORT *, CMS_SERVER * server);
+    int read_client_port(CLIENT_TCP_PORT *);
+    long request_size(CLIENT_TCP_PORT *, CMS_SERVER * server);
+    int recv_from_client(CLIENT_TCP_PORT *, void *data, long size);
+    int send_to_client(CLIENT_TCP_PORT *, void *data, int size);
+    void mark_client_closing(CLIENT_TCP_PORT *);
+    void close_failed_clients();
+    int clients_closing;
+    void accept_client_port();
+    void close_client_port(CLIENT_TCP_PORT *);
+    void remove_all_subscriptions(CLIENT_TCP_PORT *);
+    int send_reply(CLIENT_TCP_PORT *, char *header, int header_size,
+	void *data, long size);
     LinkedList *client_ports;
     LinkedList *subscription_buffers;
     int connection_socket;
@@ -66,7 +81,6 @@ class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
     char temp_buffer[0x2000];
     int current_poll_interval_millis;
     int polling_enabled;
-    struct timeval select_timeout;
     void update_subscriptions();
     void add_subscription_client(int buffer_number, int subscription_type,
 	int poll_interval_millis, CLIENT_TCP_PORT * clnt);
@@ -97,6 +111,7 @@ class TCP_CLIENT_SUBSCRIPTION_INFO {
     int poll_interval_millis;
     double last_sub_sent_time;
     int subscription_list_id;
+    int buffer_list_id;
     int buffer_number;
     int subscription_paused;
     int last_id_read;
@@ -114,6 +129,7 @@ class CLIENT_TCP_PORT {
     int errors, max_errors;
     struct sockaddr_in address;
     int socket_fd;
+    int list_id;
     LinkedList *subscriptions;
     pid_t tid;
     pid_t pid;
@@ -125,6 +141,9 @@ class CLIENT_TCP_PORT {
 #endif
     TCPSVR_BLOCKING_READ_REQUEST *blocking_read_req;
     REMOTE_SET_DIAG_INFO_REQUEST *diag_info;
+    char *inbuf;		/* requests read but not handled yet */
+    long inbuf_size, inbuf_len, inbuf_pos;
+    int closing;		/* close once it is safe to delete */
 
 };
 
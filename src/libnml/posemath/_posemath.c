@@ -787,7 +787,7 @@ int pmCartCartCompare(PmCartesian const * const v1, PmCartesian const * const v2
 
 int pmCartCartDot(PmCartesian const * const v1, PmCartesian const * const v2, double *d)
 {
-    *d = v1->x * v2->x + v1->y * v2->y + v1->z * v2->z;
+    *d = pmCartDot(*v1, *v2);
 
     return pmErrno = 0;
 }
@@ -818,16 +818,14 @@ int pmCartCartCross(PmCartesian const * const v1, PmCartesian const * const v2,
     if (vout == v1 || vout == v2) {
         return pmErrno = PM_IMPL_ERR;
     }
-    vout->x = v1->y * v2->z - v1->z * v2->y;
-    vout->y = v1->z * v2->x - v1->x * v2->z;
-    vout->z = v1->x * v2->y - v1->y * v2->x;
+    *vout = pmCartCross(*v1, *v2);
 
     return pmErrno = 0;
 }
 
 int pmCartMag(PmCartesian const * const v, double *d)
 {
-    *d = pmSqrt(pmSq(v->x) + pmSq(v->y) + pmSq(v->z));
+    *d = pmSqrt(pmCartLengthSq(*v));
 
     return pmErrno = 0;
 }
@@ -835,7 +833,7 @@ int pmCartMag(PmCartesian const * const v, double *d)
 /** Find square of magnitude of a vector (useful for some calculations to save a sqrt).*/
 int pmCartMagSq(PmCartesian const * const v, double *d)
 {
-    *d = pmSq(v->x) + pmSq(v->y) + pmSq(v->z);
+    *d = pmCartLengthSq(*v);
 
     return pmErrno = 0;
 }
@@ -843,7 +841,7 @@ int pmCartMagSq(PmCartesian const * const v, double *d)
 int pmCartCartDisp(PmCartesian const * const v1, PmCartesian const * const v2,
         double *d)
 {
-    *d = pmSqrt(pmSq(v2->x - v1->x) + pmSq(v2->y - v1->y) + pmSq(v2->z - v1->z));
+    *d = pmSqrt(pmCartLengthSq(pmCartSub(*v2, *v1)));
 
     return pmErrno = 0;
 }
@@ -851,9 +849,7 @@ int pmCartCartDisp(PmCartesian const * const v1, PmCartesian const * const v2,
 int pmCartCartAdd(PmCartesian const * const v1, PmCartesian const * const v2,
         PmCartesian * const vout)
 {
-    vout->x = v1->x + v2->x;
-    vout->y = v1->y + v2->y;
-    vout->z = v1->z + v2->z;
+    *vout = pmCartAdd(*v1, *v2);
 
     return pmErrno = 0;
 }
@@ -861,19 +857,16 @@ int pmCartCartAdd(PmCartesian const * const v1, PmCartesian const * const v2,
 int pmCartCartSub(PmCartesian const * const v1, PmCartesian const * const v2,
         PmCartesian * const vout)
 {
-    vout->x = v1->x - v2->x;
-    vout->y = v1->y - v2->y;
-    vout->z = v1->z - v2->z;
+    *vout = pmCartSub(*v1, *v2);
 
     return pmErrno = 0;
 }
 
 int pmCartScalMult(PmCartesian const * const v1, double d, PmCartesian * const vout)
 {
-    if (v1 != vout) {
-        *vout = *v1;
-    }
-    return pmCartScalMultEq(vout, d);
+    *vout = pmCartScale(*v1, d);
+
+    return pmErrno = 0;
 }
 
 int pmCartScalDiv(PmCartesian const * const v1, double d, PmCartesian * const vout)
@@ -895,9 +888,7 @@ int pmCartNeg(PmCartesian const * const v1, PmCartesian * const vout)
 
 int pmCartNegEq(PmCartesian * const v1)
 {
-    v1->x = -v1->x;
-    v1->y = -v1->y;
-    v1->z = -v1->z;
+    *v1 = pmCartNegate(*v1);
 
     return pmErrno = 0;
 }
@@ -923,9 +914,7 @@ int pmCartInvEq(PmCartesian * const v)
         return pmErrno = PM_NORM_ERR;
     }
 
-    v->x /= size_sq;
-    v->y /= size_sq;
-    v->z /= size_sq;
+    *v = pmCartDivide(*v, size_sq);
 
     return pmErrno = 0;
 }
@@ -954,28 +943,21 @@ int pmCartAbs(PmCartesian const * const v, PmCartesian * const vout)
 
 int pmCartCartAddEq(PmCartesian * const v, PmCartesian const * const v_add)
 {
-    v->x += v_add->x;
-    v->y += v_add->y;
-    v->z += v_add->z;
+    *v = pmCartAdd(*v, *v_add);
 
     return pmErrno = 0;
 }
 
 int pmCartCartSubEq(PmCartesian * const v, PmCartesian const * const v_sub)
 {
-    v->x -= v_sub->x;
-    v->y -= v_sub->y;
-    v->z -= v_sub->z;
+    *v = pmCartSub(*v, *v_sub);
 
     return pmErrno = 0;
 }
 
 int pmCartScalMultEq(PmCartesian * const v, double d)
 {
-
-    v->x *= d;
-    v->y *= d;
-    v->z *= d;
+    *v = pmCartScale(*v, d);
 
     return pmErrno = 0;
 }
@@ -991,16 +973,14 @@ int pmCartScalDivEq(PmCartesian * const v, double d)
         return pmErrno = PM_DIV_ERR;
     }
 
-    v->x /= d;
-    v->y /= d;
-    v->z /= d;
+    *v = pmCartDivide(*v, d);
 
     return pmErrno = 0;
 }
 
 int pmCartUnitEq(PmCartesian * const v)
 {
-    double size = pmSqrt(pmSq(v->x) + pmSq(v->y) + pmSq(v->z));
+    double size = pmSqrt(pmCartLengthSq(*v));
 
     if (size == 0.0) {
 #ifdef PM_PRINT_ERROR
@@ -1009,9 +989,7 @@ int pmCartUnitEq(PmCartesian * const v)
         return pmErrno = PM_NORM_ERR;
     }
 
-    v->x /= size;
-    v->y /= size;
-    v->z /= size;
+    *v = pmCartDivide(*v, size);
 
     return pmErrno = 0;
 }
@@ -1247,9 +1225,7 @@ int pmMatInv(PmRotationMatrix const * const m, PmRotationMatrix * const mout)
 
 int pmMatCartMult(PmRotationMatrix const * const m, PmCartesian const * const v, PmCartesian * const vout)
 {
-    vout->x = m->x.x * v->x + m->y.x * v->y + m->z.x * v->z;
-    vout->y = m->x.y * v->x + m->y.y * v->y + m->z.y * v->z;
-    vout->z = m->x.z * v->x + m->y.z * v->y + m->z.z * v->z;
+    *vout = pmMatApply(m, *v);
 
     return pmErrno = 0;
 }
@@ -1257,17 +1233,7 @@ int pmMatCartMult(PmRotationMatrix const * const m, PmCartesian const * const v,
 int pmMatMatMult(PmRotationMatrix const * const m1, PmRotationMatrix const * const m2,
     PmRotationMatrix * const mout)
 {
-    mout->x.x = m1->x.x * m2->x.x + m1->y.x * m2->x.y + m1->z.x * m2->x.z;
-    mout->x.y = m1->x.y * m2->x.x + m1->y.y * m2->x.y + m1->z.y * m2->x.z;
-    mout->x.z = m1->x.z * m2->x.x + m1->y.z * m2->x.y + m1->z.z * m2->x.z;
-
-    mout->y.x = m1->x.x * m2->y.x + m1->y.x * m2->y.y + m1->z.x * m2->y.z;
-    mout->y.y = m1->x.y * m2->y.x + m1->y.y * m2->y.y + m1->z.y * m2->y.z;
-    mout->y.z = m1->x.z * m2->y.x + m1->y.z * m2->y.y + m1->z.z * m2->y.z;
-
-    mout->z.x = m1->x.x * m2->z.x + m1->y.x * m2->z.y + m1->z.x * m2->z.z;
-    mout->z.y = m1->x.y * m2->z.x + m1->y.y * m2->z.y + m1->z.y * m2->z.z;
-    mout->z.z = m1->x.z * m2->z.x + m1->y.z * m2->z.y + m1->z.z * m2->z.z;
+    *mout = pmMatMul(m1, m2);
 
     return pmErrno = 0;
 }
@@ -1409,18 +1375,7 @@ int pmQuatQuatMult(PmQuaternion const * const q1, PmQuaternion const * const q2,
 	return pmErrno = PM_ERR;
     }
 
-    qout->s = q1->s * q2->s - q1->x * q2->x - q1->y * q2->y - q1->z * q2->z;
-
-    if (qout->s >= 0.0) {
-	qout->x = q1->s * q2->x + q1->x * q2->s + q1->y * q2->z - q1->z * q2->y;
-	qout->y = q1->s * q2->y - q1->x * q2->z + q1->y * q2->s + q1->z * q2->x;
-	qout->z = q1->s * q2->z + q1->x * q2->y - q1->y * q2->x + q1->z * q2->s;
-    } else {
-	qout->s *= -1;
-	qout->x = -q1->s * q2->x - q1->x * q2->s - q1->y * q2->z + q1->z * q2->y;
-	qout->y = -q1->s * q2->y + q1->x * q2->z - q1->y * q2->s - q1->z * q2->x;
-	qout->z = -q1->s * q2->z - q1->x * q2->y + q1->y * q2->x - q1->z * q2->s;
-    }
+    *qout = pmQuatMul(*q1, *q2);
 
 #ifdef PM_DEBUG
     if (!pmQuatIsNorm(q1) || !pmQuatIsNorm(q2)) {
@@ -1436,15 +1391,7 @@ int pmQuatQuatMult(PmQuaternion const * const q1, PmQuaternion const * const q2,
 
 int pmQuatCartMult(PmQuaternion const * const q1, PmCartesian const * const v2, PmCartesian * const vout)
 {
-    PmCartesian c;
-
-    c.x = q1->y * v2->z - q1->z * v2->y;
-    c.y = q1->z * v2->x - q1->x * v2->z;
-    c.z = q1->x * v2->y - q1->y * v2->x;
-
-    vout->x = v2->x + 2.0 * (q1->s * c.x + q1->y * c.z - q1->z * c.y);
-    vout->y = v2->y + 2.0 * (q1->s * c.y + q1->z * c.x - q1->x * c.z);
-    vout->z = v2->z + 2.0 * (q1->s * c.z + q1->x * c.y - q1->y * c.x);
+    *vout = pmQuatApply(*q1, *v2);
 
 #ifdef PM_DEBUG
     if (!pmQuatIsNorm(q1)) {
@@ -1676,17 +1623,14 @@ int pmCartLineInit(PmCartLine * const line, PmCartesian const * const start, PmC
 
 int pmCartLinePoint(PmCartLine const * const line, double len, PmCartesian * const point)
 {
-    int r1 = 0, r2 = 0;
-
     if (line->tmag_zero) {
         *point = line->end;
     } else {
         /* return start + len * uVec */
-        r1 = pmCartScalMult(&line->uVec, len, point);
-        r2 = pmCartCartAdd(&line->start, point, point);
+        *point = pmCartAddScaled(line->start, line->uVec, len);
     }
 
-    return pmErrno = (r1 || r2) ? PM_NORM_ERR : 0;
+    return pmErrno = 0;
 }
 
 
@@ -1865,8 +1809,8 @@ int pmCircleInit(PmCircle * const circle,
   */
 int pmCirclePoint(PmCircle const * const circle, double angle, PmCartesian * const point)
 {
-    PmCartesian par, perp;
-    double scale;
+    PmCartesian radial, unit;
+    double scale, mag;
 
 #ifdef PM_DEBUG
     if (0 == circle || 0 == point) {
@@ -1878,12 +1822,10 @@ int pmCirclePoint(PmCircle const * const circle, double angle, PmCartesian * con
     }
 #endif
 
-    /* compute components rel to center */
-    pmCartScalMult(&circle->rTan, cos(angle), &par);
-    pmCartScalMult(&circle->rPerp, sin(angle), &perp);
-
-    /* add to get radius vector rel to center */
-    pmCartCartAdd(&par, &perp, point);
+    /* radius vector rel to center */
+    radial = pmCartAdd(pmCartScale(circle->rTan, cos(angle)),
+        pmCartScale(circle->rPerp, sin(angle)));
+    *point = radial;
 
     /* get scale for spiral, helix interpolation */
     if (circle->angle == 0.0) {
@@ -1895,16 +1837,15 @@ int pmCirclePoint(PmCircle const * const circle, double angle, PmCartesian * con
     scale = angle / circle->angle;
 
     /* add scaled vector in radial dir for spiral */
-    pmCartUnit(point, &par);
-    pmCartScalMult(&par, scale * circle->spiral, &par);
-    pmCartCartAdd(point, &par, point);
+    mag = pmCartLength(radial);
+    unit = mag != 0.0 ? pmCartDivide(radial, mag) : radial;
+    radial = pmCartAddScaled(radial, unit, scale * circle->spiral);
 
     /* add scaled vector in helix dir */
-    pmCartScalMult(&circle->rHelix, scale, &perp);
-    pmCartCartAdd(point, &perp, point);
+    radial = pmCartAddScaled(radial, circle->rHelix, scale);
 
     /* add to center vector for final result */
-    pmCartCartAdd(&circle->center, point, point);
+    *point = pmCartAdd(circle->center, radial);
 
     return pmErrno = 0;
 }
@@ -950,6 +950,130 @@ extern "C" {
     extern int pmCirclePoint(PmCircle const * const circle, double angle, PmCartesian * const point);
     extern int pmCircleStretch(PmCircle * const circ, double new_angle, int from_end);
 
+/* inline core
+
+   Value versions of the PmCartesian, PmQuaternion and PmRotationMatrix
+   arithmetic above.  They take and return structs instead of pointers
+   and leave pmErrno alone, so the compiler can inline them, keep the
+   components in registers and vectorise across calls; the pointer
+   functions are wrappers around them.  None of them can fail, so
+   callers that need the divide-by-zero checks (pmCartUnit,
+   pmCartScalDiv) still use the pointer versions.  They are meant for
+   the inner loops of the trajectory planner and the kinematics. */
+
+#define PM_INLINE static inline
+
+    PM_INLINE PmCartesian pmCart(double x, double y, double z)
+    {
+	PmCartesian v = { x, y, z };
+	return v;
+    }
+
+    PM_INLINE PmCartesian pmCartAdd(PmCartesian a, PmCartesian b)
+    {
+	return pmCart(a.x + b.x, a.y + b.y, a.z + b.z);
+    }
+
+    PM_INLINE PmCartesian pmCartSub(PmCartesian a, PmCartesian b)
+    {
+	return pmCart(a.x - b.x, a.y - b.y, a.z - b.z);
+    }
+
+    PM_INLINE PmCartesian pmCartScale(PmCartesian a, double d)
+    {
+	return pmCart(a.x * d, a.y * d, a.z * d);
+    }
+
+/* a / d, with the same rounding as dividing each component */
+    PM_INLINE PmCartesian pmCartDivide(PmCartesian a, double d)
+    {
+	return pmCart(a.x / d, a.y / d, a.z / d);
+    }
+
+/* a + b * d */
+    PM_INLINE PmCartesian pmCartAddScaled(PmCartesian a, PmCartesian b, double d)
+    {
+	return pmCart(a.x + b.x * d, a.y + b.y * d, a.z + b.z * d);
+    }
+
+    PM_INLINE PmCartesian pmCartNegate(PmCartesian a)
+    {
+	return pmCart(-a.x, -a.y, -a.z);
+    }
+
+    PM_INLINE double pmCartDot(PmCartesian a, PmCartesian b)
+    {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    PM_INLINE PmCartesian pmCartCross(PmCartesian a, PmCartesian b)
+    {
+	return pmCart(a.y * b.z - a.z * b.y,
+	    a.z * b.x - a.x * b.z,
+	    a.x * b.y - a.y * b.x);
+    }
+
+    PM_INLINE double pmCartLengthSq(PmCartesian a)
+    {
+	return pmSq(a.x) + pmSq(a.y) + pmSq(a.z);
+    }
+
+/* like pmCartMag, without the fuzz check in pmSqrt that a sum of
+   squares never needs */
+    PM_INLINE double pmCartLength(PmCartesian a)
+    {
+	return __builtin_sqrt(pmCartLengthSq(a));
+    }
+
+    PM_INLINE PmCartesian pmMatApply(PmRotationMatrix const * const m, PmCartesian v)
+    {
+	return pmCart(m->x.x * v.x + m->y.x * v.y + m->z.x * v.z,
+	    m->x.y * v.x + m->y.y * v.y + m->z.y * v.z,
+	    m->x.z * v.x + m->y.z * v.y + m->z.z * v.z);
+    }
+
+    PM_INLINE PmRotationMatrix pmMatMul(PmRotationMatrix const * const m1,
+	PmRotationMatrix const * const m2)
+    {
+	PmRotationMatrix m;
+
+	m.x = pmMatApply(m1, m2->x);
+	m.y = pmMatApply(m1, m2->y);
+	m.z = pmMatApply(m1, m2->z);
+	return m;
+    }
+
+/* q1 * q2, with the scalar part made non-negative */
+    PM_INLINE PmQuaternion pmQuatMul(PmQuaternion q1, PmQuaternion q2)
+    {
+	PmQuaternion q;
+
+	q.s = q1.s * q2.s - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z;
+	if (q.s >= 0.0) {
+	    q.x = q1.s * q2.x + q1.x * q2.s + q1.y * q2.z - q1.z * q2.y;
+	    q.y = q1.s * q2.y - q1.x * q2.z + q1.y * q2.s + q1.z * q2.x;
+	    q.z = q1.s * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.s;
+	} else {
+	    q.s *= -1;
+	    q.x = -q1.s * q2.x - q1.x * q2.s - q1.y * q2.z + q1.z * q2.y;
+	    q.y = -q1.s * q2.y + q1.x * q2.z - q1.y * q2.s - q1.z * q2.x;
+	    q.z = -q1.s * q2.z - q1.x * q2.y + q1.y * q2.x - q1.z * q2.s;
+	}
+	return q;
+    }
+
+/* v rotated by the unit quaternion q */
+    PM_INLINE PmCartesian pmQuatApply(PmQuaternion q, PmCartesian v)
+    {
+	PmCartesian c = pmCart(q.y * v.z - q.z * v.y,
+	    q.z * v.x - q.x * v.z,
+	    q.x * v.y - q.y * v.x);
+
+	return pmCart(v.x + 2.0 * (q.s * c.x + q.y * c.z - q.z * c.y),
+	    v.y + 2.0 * (q.s * c.y + q.z * c.x - q.x * c.z),
+	    v.z + 2.0 * (q.s * c.z + q.x * c.y - q.y * c.x));
+    }
+
 /* slicky macros for item-by-item copying between C and C++ structs */
 
 #define toCart(src,dst) {(dst)->x = (src).x; (dst)->y = (src).y; (dst)->z = (src).z;}
@@ -817,6 +817,38 @@ int rtapi_task_start(int task_id, unsigned long int period_nsec)
     return retval;
 }
 
+int rtapi_task_set_cpu(int task_id, int cpu)
+{
+    task_data *task;
+
+    /* validate task ID */
+    if ((task_id < 1) || (task_id > RTAPI_MAX_TASKS)) {
+	return -EINVAL;
+    }
+    /* point to the task's data */
+    task = &(task_array[task_id]);
+    /* only a task that has not been started can be moved */
+    if (task->state != PAUSED) {
+	return -EINVAL;
+    }
+    if (cpu == -1) {
+	cpu = rtapi_data->rt_cpu;
+    }
+    if ((cpu < 0) || (cpu >= NR_CPUS) || !cpu_online(cpu)) {
+	return -EINVAL;
+    }
+    rt_set_runnable_on_cpuid(ostask_array[task_id], cpu);
+    rtapi_print_msg(RTAPI_MSG_DBG, "RTAPI: task %02d on cpu %d\n",
+	task_id, cpu);
+    return 0;
+}
+
+long rtapi_task_overruns(int task_id)
+{
+    /* RTAI does not report missed periods per task */
+    return -ENOSYS;
+}
+
 void rtapi_wait(void)
 {
     int result = rt_task_wait_period();
@@ -1713,6 +1745,8 @@ EXPORT_SYMBOL(rtapi_prio_next_lower);
 EXPORT_SYMBOL(rtapi_task_new);
 EXPORT_SYMBOL(rtapi_task_delete);
 EXPORT_SYMBOL(rtapi_task_start);
+EXPORT_SYMBOL(rtapi_task_set_cpu);
+EXPORT_SYMBOL(rtapi_task_overruns);
 EXPORT_SYMBOL(rtapi_wait);
 EXPORT_SYMBOL(rtapi_task_resume);
 EXPORT_SYMBOL(rtapi_task_pause);
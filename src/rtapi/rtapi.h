@@ -384,6 +384,23 @@ RTAPI_BEGIN_DECLS
 */
     extern int rtapi_task_start(int task_id, unsigned long int period_nsec);
 
+/** 'rtapi_task_set_cpu()' selects the CPU that 'task_id' will run on.
+    'cpu' is a CPU number, or -1 to let RTAPI place the task (the
+    default).  It only has an effect if called before rtapi_task_start().
+    Returns 0, or a negative error code if 'task_id' or 'cpu' is not
+    valid or the RTOS cannot place tasks.
+    Call only from within init/cleanup code, not from realtime tasks.
+*/
+    extern int rtapi_task_set_cpu(int task_id, int cpu);
+
+/** 'rtapi_task_overruns()' returns the number of periods in which
+    'task_id' was released late because it (or a higher priority task)
+    did not finish within its period, or a negative error code if the
+    RTOS does not keep this count.
+    May be called from init/cleanup code, and from within realtime tasks.
+*/
+    extern long rtapi_task_overruns(int task_id);
+
 /** 'rtapi_wait()' suspends execution of the current task until the
     next period.  The task must be periodic, if not, the result is
     undefined.  The function will return at the beginning of the
@@ -60,6 +60,8 @@ struct rtapi_task {
   long period;
   struct timespec nextstart;
   unsigned ratio;
+  int cpu;			/* requested cpu, or -1 for automatic placement */
+  unsigned long overruns;	/* periods in which the task started late */
   void *arg;
   void (*taskcode) (void*);	/* pointer to task function */
 };
@@ -80,6 +82,8 @@ struct RtapiApp
     static int allocate_task_id();
     static struct rtapi_task *get_task(int task_id);
     void unexpected_realtime_delay(rtapi_task *task, int nperiod=1);
+    int task_set_cpu(int task_id, int cpu);
+    long task_overruns(int task_id);
     virtual int task_delete(int id) = 0;
     virtual int task_start(int task_id, unsigned long period_nsec) = 0;
     virtual int task_pause(int task_id) = 0;
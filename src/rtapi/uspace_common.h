@@ -263,10 +263,18 @@ int rtapi_get_msg_level() {
 #define rdtscll(val) ((val) = rtapi_get_time())
 #endif
 
+#ifdef RTAPI
+/* set by rtapi_app when the realtime threads run on a simulated clock */
+extern int rtapi_virtual_time;
+#endif
+
 long long rtapi_get_clocks(void)
 {
     long long int retval;
 
+#ifdef RTAPI
+    if(rtapi_virtual_time) return rtapi_get_time();
+#endif
     rdtscll(retval);
     return retval;
 }
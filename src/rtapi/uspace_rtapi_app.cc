@@ -583,25 +583,51 @@ struct rtapi_module {
 rtapi_task::rtapi_task()
     : magic{}, id{}, owner{}, stacksize{}, prio{},
       period{}, nextstart{},
-      ratio{}, arg{}, taskcode{}
+      ratio{}, cpu{-1}, overruns{}, arg{}, taskcode{}
 {}
 
 namespace
 {
 struct PosixTask : rtapi_task
 {
-    PosixTask() : rtapi_task{}, thr{}
+    PosixTask() : rtapi_task{}, thr{}, virtual_ready{}
     {}
 
     pthread_t thr;                /* thread's context */
+    bool virtual_ready;           /* scheduled by the virtual clock */
 };
 
+static long long timespec_to_ns(const struct timespec &ts) {
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static struct timespec ns_to_timespec(long long ns) {
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000LL;
+    ts.tv_nsec = ns % 1000000000LL;
+    return ts;
+}
+
 struct Posix : RtapiApp
 {
-    Posix(int policy = SCHED_FIFO) : RtapiApp(policy), do_thread_lock(policy != SCHED_FIFO) {
+    // A negative virtual_speed selects the wall clock.  Otherwise threads
+    // run back to back against a simulated clock, at most virtual_speed
+    // times faster than real time (0 = as fast as possible).
+    Posix(int policy = SCHED_FIFO, double virtual_speed = -1)
+        : RtapiApp(policy),
+          do_thread_lock(policy != SCHED_FIFO || virtual_speed >= 0),
+          virtual_time(virtual_speed >= 0), virtual_speed(virtual_speed),
+          virtual_starting(0) {
         pthread_once(&key_once, init_key);
         if(do_thread_lock)
             pthread_mutex_init(&thread_lock, 0);
+        if(virtual_time) {
+            pthread_cond_init(&virtual_cond, 0);
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            virtual_now = virtual_origin = wall_origin = timespec_to_ns(now);
+            rtapi_virtual_time = 1;
+        }
     }
     int task_delete(int id);
     int task_start(int task_id, unsigned long period_nsec);
@@ -619,6 +645,15 @@ struct Posix : RtapiApp
     bool do_thread_lock;
     pthread_mutex_t thread_lock;
 
+    void virtual_wait(PosixTask *task);
+    PosixTask *virtual_next_task();
+    bool virtual_time;
+    double virtual_speed;
+    pthread_cond_t virtual_cond;
+    std::atomic<int> virtual_starting;
+    std::atomic<long long> virtual_now;
+    long long virtual_origin, wall_origin;
+
     static pthread_once_t key_once;
     static pthread_key_t key;
     static void init_key(void) {
@@ -626,9 +661,10 @@ struct Posix : RtapiApp
     }
 
     long long do_get_time(void) {
+        if(virtual_time) return virtual_now;
         struct timespec ts;
         clock_gettime(CLOCK_MONOTONIC, &ts);
-        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+        return timespec_to_ns(ts);
     }
 
     void do_delay(long ns);
@@ -774,6 +810,13 @@ static int harden_rt()
 
 static RtapiApp *makeApp()
 {
+    if(getenv("RTAPI_VIRTUAL_TIME"))
+    {
+        double speed = atof(getenv("RTAPI_VIRTUAL_TIME"));
+        if(speed < 0) speed = 0;
+        rtapi_print_msg(RTAPI_MSG_ERR, "Note: Using POSIX virtual time\n");
+        return new Posix(SCHED_OTHER, speed);
+    }
     if(euid != 0 || harden_rt() < 0)
     {
         rtapi_print_msg(RTAPI_MSG_ERR, "Note: Using POSIX non-realtime\n");
@@ -810,6 +853,8 @@ RtapiApp &App()
 /* data for all tasks */
 struct rtapi_task *task_array[MAX_TASKS];
 
+int rtapi_virtual_time;
+
 /* Priority functions.  Uspace uses POSIX task priorities. */
 
 int RtapiApp::prio_highest()
@@ -878,6 +923,7 @@ int RtapiApp::task_new(void (*taskcode) (void*), void *arg,
   task->stacksize = stacksize;
   task->taskcode = taskcode;
   task->prio = prio;
+  task->cpu = -1;
   task->magic = TASK_MAGIC;
   task_array[n] = task;
 
@@ -898,6 +944,7 @@ rtapi_task *RtapiApp::get_task(int task_id) {
 
 void RtapiApp::unexpected_realtime_delay(rtapi_task *task, int nperiod) {
     static int printed = 0;
+    task->overruns += nperiod;
     if(!printed)
     {
         rtapi_print_msg(RTAPI_MSG_ERR,
@@ -909,6 +956,20 @@ void RtapiApp::unexpected_realtime_delay(rtapi_task *task, int nperiod) {
     }
 }
 
+int RtapiApp::task_set_cpu(int task_id, int cpu) {
+    rtapi_task *task = get_task(task_id);
+    if(!task) return -EINVAL;
+    if(cpu < -1 || cpu >= CPU_SETSIZE) return -EINVAL;
+    task->cpu = cpu;
+    return 0;
+}
+
+long RtapiApp::task_overruns(int task_id) {
+    rtapi_task *task = get_task(task_id);
+    if(!task) return -EINVAL;
+    return task->overruns;
+}
+
 int Posix::task_delete(int id)
 {
   auto task = ::rtapi_get_task<PosixTask>(id);
@@ -916,21 +977,76 @@ int Posix::task_delete(int id)
 
   pthread_cancel(task->thr);
   pthread_join(task->thr, 0);
-  task->magic = 0;
-  task_array[id] = 0;
+  if(task->overruns)
+      rtapi_print_msg(RTAPI_MSG_INFO, "task %d: %lu overruns\n",
+              task->id, task->overruns);
+  if(virtual_time) {
+      // the remaining tasks may have been waiting for this one's turn
+      pthread_mutex_lock(&thread_lock);
+      task->magic = 0;
+      task_array[id] = 0;
+      pthread_cond_broadcast(&virtual_cond);
+      pthread_mutex_unlock(&thread_lock);
+  } else {
+      task->magic = 0;
+      task_array[id] = 0;
+  }
   delete task;
   return 0;
 }
 
-static int find_rt_cpu_number() {
-    if(getenv("RTAPI_CPU_NUMBER")) return atoi(getenv("RTAPI_CPU_NUMBER"));
+// parse a kernel style cpu list such as "2-3,5", appending to 'cpus'
+static void parse_cpu_list(const char *s, std::vector<int> &cpus) {
+    while(*s) {
+        char *end;
+        long lo = strtol(s, &end, 10);
+        if(end == s) break;
+        long hi = lo;
+        s = end;
+        if(*s == '-') {
+            hi = strtol(s + 1, &end, 10);
+            if(end == s + 1) break;
+            s = end;
+        }
+        for(long i=lo; i<=hi && i<CPU_SETSIZE; i++) {
+            if(i >= 0 && std::find(cpus.begin(), cpus.end(), i) == cpus.end())
+                cpus.push_back(i);
+        }
+        if(*s != ',') break;
+        s++;
+    }
+}
+
+#ifdef __linux__
+static void read_cpu_list(const char *path, std::vector<int> &cpus) {
+    FILE *f = fopen(path, "r");
+    if(!f) return;
+    char buf[1024];
+    if(fgets(buf, sizeof(buf), f)) parse_cpu_list(buf, cpus);
+    fclose(f);
+}
+#endif
+
+// Returns the cpus that realtime tasks are placed on, in the order in
+// which tasks are assigned to them.  RTAPI_CPU_NUMBER may give a single
+// cpu or a list; otherwise the isolated (isolcpus= / nohz_full=) cpus
+// are used from the highest numbered down, falling back to the last cpu
+// this process may run on.
+static std::vector<int> find_rt_cpu_numbers() {
+    std::vector<int> result;
+    if(getenv("RTAPI_CPU_NUMBER")) {
+        parse_cpu_list(getenv("RTAPI_CPU_NUMBER"), result);
+        return result;
+    }
 
 #ifdef __linux__
     cpu_set_t cpuset_orig;
     int r = sched_getaffinity(getpid(), sizeof(cpuset_orig), &cpuset_orig);
-    if(r < 0)
+    if(r < 0) {
         // if getaffinity fails, (it shouldn't be able to), just use CPU#0
-        return 0;
+        result.push_back(0);
+        return result;
+    }
 
     cpu_set_t cpuset;
     CPU_ZERO(&cpuset);
@@ -960,14 +1076,22 @@ static int find_rt_cpu_number() {
         CPU_AND(&cpuset, &cpuset_orig, &cpuset);
     }
 
+    std::vector<int> isolated;
+    read_cpu_list("/sys/devices/system/cpu/isolated", isolated);
+    read_cpu_list("/sys/devices/system/cpu/nohz_full", isolated);
+    std::sort(isolated.rbegin(), isolated.rend());
+    for(size_t i=0; i<isolated.size(); i++) {
+        if(CPU_ISSET(isolated[i], &cpuset)) result.push_back(isolated[i]);
+    }
+    if(!result.empty()) return result;
+
     int top = -1;
     for(int i=0; i<CPU_SETSIZE; i++) {
         if(CPU_ISSET(i, &cpuset)) top = i;
     }
-    return top;
-#else
-    return (-1);
+    if(top != -1) result.push_back(top);
 #endif
+    return result;
 }
 
 int Posix::task_start(int task_id, unsigned long int period_nsec)
@@ -997,8 +1121,15 @@ int Posix::task_start(int task_id, unsigned long int period_nsec)
   if(pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED) < 0)
       return -errno;
   if(nprocs > 1) {
-      const static int rt_cpu_number = find_rt_cpu_number();
+      const static std::vector<int> rt_cpu_numbers = find_rt_cpu_numbers();
+      static int next_rt_cpu;
+      int rt_cpu_number = task->cpu;
+      if(rt_cpu_number == -1 && !rt_cpu_numbers.empty())
+          rt_cpu_number = rt_cpu_numbers[
+              next_rt_cpu++ % rt_cpu_numbers.size()];
       if(rt_cpu_number != -1) {
+          rtapi_print_msg(RTAPI_MSG_INFO, "task %d: cpu %d\n",
+                  task->id, rt_cpu_number);
 #ifdef __FreeBSD__
           cpuset_t cpuset;
 #else
@@ -1010,8 +1141,12 @@ int Posix::task_start(int task_id, unsigned long int period_nsec)
                return -errno;
       }
   }
-  if(pthread_create(&task->thr, &attr, &wrapper, reinterpret_cast<void*>(task)) < 0)
+  // running tasks hold off until the new one has joined the virtual clock
+  if(virtual_time) virtual_starting++;
+  if(pthread_create(&task->thr, &attr, &wrapper, reinterpret_cast<void*>(task)) < 0) {
+      if(virtual_time) virtual_starting--;
       return -errno;
+  }
 
   return 0;
 }
@@ -1040,9 +1175,16 @@ void *Posix::wrapper(void *arg)
   if(papp.do_thread_lock)
       pthread_mutex_lock(&papp.thread_lock);
 
-  struct timespec now;
-  clock_gettime(RTAPI_CLOCK, &now);
-  rtapi_timespec_advance(task->nextstart, now, task->period);
+  if(papp.virtual_time) {
+      task->nextstart = ns_to_timespec(papp.virtual_now);
+      static_cast<PosixTask*>(task)->virtual_ready = true;
+      papp.virtual_starting--;
+      pthread_cond_broadcast(&papp.virtual_cond);
+  } else {
+      struct timespec now;
+      clock_gettime(RTAPI_CLOCK, &now);
+      rtapi_timespec_advance(task->nextstart, now, task->period);
+  }
 
   /* call the task function with the task argument */
   (task->taskcode) (task->arg);
@@ -1065,7 +1207,56 @@ int Posix::task_self() {
     return task->id;
 }
 
+// The started task that is due first; ties go to the higher priority
+// (faster) task, then to the lower task id, so runs are repeatable.
+PosixTask *Posix::virtual_next_task() {
+    PosixTask *next = nullptr;
+    for(int n=0; n<MAX_TASKS; n++) {
+        rtapi_task *t = task_array[n];
+        if(!t || t == TASK_MAGIC_INIT || t->magic != TASK_MAGIC) continue;
+        PosixTask *task = static_cast<PosixTask*>(t);
+        if(!task->virtual_ready) continue;
+        if(!next || rtapi_timespec_less(task->nextstart, next->nextstart)
+                || (!rtapi_timespec_less(next->nextstart, task->nextstart)
+                    && task->prio > next->prio))
+            next = task;
+    }
+    return next;
+}
+
+static void unlock_thread_lock(void *lock) {
+    pthread_mutex_unlock(static_cast<pthread_mutex_t*>(lock));
+}
+
+// Called with thread_lock held, which is given up while waiting for this
+// task's turn and while sleeping to pace the virtual clock, and also when
+// the task is cancelled at either.  Instead of sleeping until the next
+// period, the virtual clock jumps to the start of the next one that is due.
+void Posix::virtual_wait(PosixTask *task) {
+    rtapi_timespec_advance(task->nextstart, task->nextstart, task->period);
+    pthread_cond_broadcast(&virtual_cond);
+    pthread_cleanup_push(unlock_thread_lock, &thread_lock);
+    pthread_testcancel();
+    while(virtual_starting || virtual_next_task() != task)
+        pthread_cond_wait(&virtual_cond, &thread_lock);
+    long long start = timespec_to_ns(task->nextstart);
+    if(start > virtual_now) virtual_now = start;
+    pthread_cleanup_pop(0);
+    if(virtual_speed > 0) {
+        struct timespec wall = ns_to_timespec(wall_origin +
+                (long long)((virtual_now - virtual_origin) / virtual_speed));
+        pthread_mutex_unlock(&thread_lock);
+        rtapi_clock_nanosleep(RTAPI_CLOCK, TIMER_ABSTIME, &wall, nullptr, nullptr);
+        pthread_testcancel();
+        pthread_mutex_lock(&thread_lock);
+    }
+}
+
 void Posix::wait() {
+    if(virtual_time) {
+        virtual_wait(reinterpret_cast<PosixTask*>(pthread_getspecific(key)));
+        return;
+    }
     if(do_thread_lock)
         pthread_mutex_unlock(&thread_lock);
     pthread_testcancel();
@@ -1158,6 +1349,16 @@ int rtapi_task_start(int task_id, unsigned long period_nsec)
     return App().task_start(task_id, period_nsec);
 }
 
+int rtapi_task_set_cpu(int task_id, int cpu)
+{
+    return App().task_set_cpu(task_id, cpu);
+}
+
+long rtapi_task_overruns(int task_id)
+{
+    return App().task_overruns(task_id);
+}
+
 int rtapi_task_pause(int task_id)
 {
     return App().task_pause(task_id);
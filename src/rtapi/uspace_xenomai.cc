@@ -49,7 +49,10 @@ struct XenomaiApp : RtapiApp {
         cpu_set_t cpuset;
         CPU_ZERO(&cpuset);
         int nprocs = sysconf( _SC_NPROCESSORS_ONLN );
-        CPU_SET(nprocs-1, &cpuset); // assumes processor numbers are contiguous
+        if(task->cpu != -1)
+            CPU_SET(task->cpu, &cpuset);
+        else
+            CPU_SET(nprocs-1, &cpuset); // assumes processor numbers are contiguous
 
         pthread_attr_t attr;
         if(pthread_attr_init(&attr) < 0)
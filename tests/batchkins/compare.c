@@ -0,0 +1,219 @@
+/* Compare batchkins_inverse() and batchkins_forward() with the
+   kinematicsInverse() and kinematicsForward() of the realtime module
+   this is linked with, pose by pose, and print how many poses had no
+   solution and how many did not make the round trip: out of reach of
+   the scara, whose inverse clamps them onto its reach. */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtapi.h"
+#include "hal.h"
+#include "kinematics.h"
+#include "batchkins.h"
+
+#define N 2000
+/* what the realtime module leaves unset */
+#define UNSET 12345.25
+
+extern int rtapi_app_main(void);
+extern hal_float_t *stub_pin(const char *name);
+
+static unsigned long seed = 1;
+
+static double uniform(double lo, double hi)
+{
+    seed = seed * 1103515245 + 12345;
+    return lo + (hi - lo) * ((seed >> 16) & 0x7fff) / 32767.;
+}
+
+static void to_pose(const double *p, EmcPose *pos)
+{
+    pos->tran.x = p[0]; pos->tran.y = p[1]; pos->tran.z = p[2];
+    pos->a = p[3]; pos->b = p[4]; pos->c = p[5];
+    pos->u = p[6]; pos->v = p[7]; pos->w = p[8];
+}
+
+static void from_pose(const EmcPose *pos, double *p)
+{
+    p[0] = pos->tran.x; p[1] = pos->tran.y; p[2] = pos->tran.z;
+    p[3] = pos->a; p[4] = pos->b; p[5] = pos->c;
+    p[6] = pos->u; p[7] = pos->v; p[8] = pos->w;
+}
+
+static int same(double a, double b)
+{
+    if (isnan(a) || isnan(b)) {
+	return isnan(a) && isnan(b);
+    }
+    return fabs(a - b) <= 1e-9 * (1 + fabs(a));
+}
+
+static int any_nan(const double *v, int n)
+{
+    int j;
+
+    for (j = 0; j < n; j++) {
+	if (isnan(v[j])) {
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+/* compare the batch result for n poses with the realtime one, where
+   the realtime module set a coordinate or found no solution; the
+   first failure must be the one the batch reports */
+static int check(const char *what, const double *rt, const int *failed,
+                 const double *batch, long first)
+{
+    long i, expect = -1, count = 0;
+    int j, errors = 0;
+
+    for (i = 0; i < N; i++) {
+	const double *r = rt + i * BATCHKINS_COORDS;
+	const double *b = batch + i * BATCHKINS_COORDS;
+
+	if (failed[i]) {
+	    count++;
+	    if (expect < 0) {
+		expect = i;
+	    }
+	    if (!any_nan(b, 3)) {
+		printf("%s %s %ld: solved, but not by the module\n",
+		       KINS_NAME, what, i);
+		errors++;
+	    }
+	    continue;
+	}
+	for (j = 0; j < BATCHKINS_COORDS; j++) {
+	    if (r[j] != UNSET && !same(r[j], b[j])) {
+		printf("%s %s %ld.%d: %.17g, module %.17g\n",
+		       KINS_NAME, what, i, j, b[j], r[j]);
+		errors++;
+	    }
+	}
+    }
+    if (first != expect) {
+	printf("%s %s: first without solution %ld, module %ld\n",
+	       KINS_NAME, what, first, expect);
+	errors++;
+    }
+    printf("%s %s: %d poses, %ld without a solution\n",
+	   KINS_NAME, what, N, count);
+    return errors;
+}
+
+int main(void)
+{
+    static double poses[N * BATCHKINS_COORDS], joints[N * BATCHKINS_COORDS];
+    static double rt[N * BATCHKINS_COORDS], batch[N * BATCHKINS_COORDS];
+    static int failed[N], unsolved[N];
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    KINEMATICS_INVERSE_FLAGS iflags = 0;
+    double lo[BATCHKINS_COORDS], hi[BATCHKINS_COORDS];
+    batchkins_t kins;
+    EmcPose pos;
+    long i, missed = 0;
+    int j, errors = 0;
+
+    if (rtapi_app_main() || batchkins_init(&kins, KINS_TYPE)) {
+	return 1;
+    }
+    for (j = 0; j < BATCHKINS_COORDS; j++) {
+	lo[j] = j < 3 ? -500 : -180;
+	hi[j] = j < 3 ? 500 : 180;
+    }
+    switch (KINS_TYPE) {
+    case BATCHKINS_XYZAC_TRT:
+	*stub_pin("xyzac-trt-kins.y-offset") = kins.param[0] = 12.5;
+	*stub_pin("xyzac-trt-kins.z-offset") = kins.param[1] = -40;
+	*stub_pin("xyzac-trt-kins.tool-offset") = kins.param[2] = 3.25;
+	break;
+    case BATCHKINS_XYZBC_TRT:
+	*stub_pin("xyzbc-trt-kins.x-offset") = kins.param[0] = -7.5;
+	*stub_pin("xyzbc-trt-kins.z-offset") = kins.param[1] = 25;
+	*stub_pin("xyzbc-trt-kins.tool-offset") = kins.param[2] = 1.75;
+	break;
+    case BATCHKINS_SCARAKINS:
+	/* the reach is D2 + D4 +- D6: 540..640 */
+	lo[0] = lo[1] = -800;
+	hi[0] = hi[1] = 800;
+	iflags = kins.iflags = 1;
+	break;
+    case BATCHKINS_LINEARDELTAKINS:
+	/* reachable within L of each tower only: around the middle */
+	lo[0] = lo[1] = -250;
+	hi[0] = hi[1] = 250;
+	break;
+    default:
+	break;
+    }
+
+    for (i = 0; i < N; i++) {
+	for (j = 0; j < BATCHKINS_COORDS; j++) {
+	    poses[i * BATCHKINS_COORDS + j] = uniform(lo[j], hi[j]);
+	}
+    }
+    /* and a pose with no numbers at all */
+    poses[N / 2 * BATCHKINS_COORDS] = NAN;
+
+    for (i = 0; i < N; i++) {
+	double *r = rt + i * BATCHKINS_COORDS;
+
+	for (j = 0; j < BATCHKINS_COORDS; j++) {
+	    r[j] = UNSET;
+	}
+	to_pose(poses + i * BATCHKINS_COORDS, &pos);
+	failed[i] = kinematicsInverse(&pos, r, &iflags, &fflags) != 0
+	    || any_nan(r, BATCHKINS_COORDS);
+    }
+    errors += check("inverse", rt, failed,
+		    joints, batchkins_inverse(&kins, poses, joints, N));
+    memcpy(unsolved, failed, sizeof(failed));
+
+    /* forward from the joints found, where there were some, and from
+       those which do not make a pose, for lineardeltakins */
+    for (i = 0; i < N; i++) {
+	double *jt = joints + i * BATCHKINS_COORDS;
+
+	if (!unsolved[i]) {
+	    continue;
+	}
+	for (j = 0; j < BATCHKINS_COORDS; j++) {
+	    jt[j] = uniform(-100, 100);
+	}
+	if (KINS_TYPE == BATCHKINS_LINEARDELTAKINS) {
+	    jt[0] = jt[1] + 2 * kins.param[1];
+	}
+    }
+    for (i = 0; i < N; i++) {
+	double *r = rt + i * BATCHKINS_COORDS;
+
+	for (j = 0; j < BATCHKINS_COORDS; j++) {
+	    r[j] = UNSET;
+	}
+	to_pose(r, &pos);
+	failed[i] = kinematicsForward(joints + i * BATCHKINS_COORDS,
+				      &pos, &fflags, &iflags) != 0;
+	from_pose(&pos, r);
+	failed[i] = failed[i] || any_nan(r, BATCHKINS_COORDS);
+    }
+    errors += check("forward", rt, failed,
+		    batch, batchkins_forward(&kins, joints, batch, N));
+
+    /* the poses the forward kinematics don't return to */
+    for (i = 0; i < N; i++) {
+	const double *p = poses + i * BATCHKINS_COORDS;
+	const double *b = batch + i * BATCHKINS_COORDS;
+
+	if (!unsolved[i]
+	    && hypot(hypot(p[0] - b[0], p[1] - b[1]), p[2] - b[2]) > 1e-6) {
+	    missed++;
+	}
+    }
+    printf("%s round trip: %ld poses out of reach\n", KINS_NAME, missed);
+
+    return errors != 0;
+}
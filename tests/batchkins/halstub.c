@@ -0,0 +1,72 @@
+/* Just enough of HAL to load a kinematics module into a test program:
+   pins are plain memory, found again by name with stub_pin(). */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtapi.h"
+#include "hal.h"
+
+#define MAX_PINS 16
+
+static struct {
+    char name[HAL_NAME_LEN + 1];
+    hal_float_t *value;
+} pins[MAX_PINS];
+static int npins;
+
+hal_float_t *stub_pin(const char *name)
+{
+    int i;
+
+    for (i = 0; i < npins; i++) {
+	if (!strcmp(pins[i].name, name)) {
+	    return pins[i].value;
+	}
+    }
+    fprintf(stderr, "no pin %s\n", name);
+    exit(1);
+}
+
+int hal_init(const char *name) { return 1; }
+int hal_ready(int comp_id) { return 0; }
+int hal_exit(int comp_id) { return 0; }
+
+void *hal_malloc(long int size)
+{
+    return calloc(1, size);
+}
+
+int hal_pin_float_new(const char *name, hal_pin_dir_t dir,
+                      hal_float_t **data_ptr_addr, int comp_id)
+{
+    if (npins == MAX_PINS) {
+	return -ENOMEM;
+    }
+    snprintf(pins[npins].name, sizeof(pins[npins].name), "%s", name);
+    pins[npins].value = *data_ptr_addr = hal_malloc(sizeof(hal_float_t));
+    npins++;
+    return 0;
+}
+
+int hal_pin_float_newf(hal_pin_dir_t dir, hal_float_t **data_ptr_addr,
+                       int comp_id, const char *fmt, ...)
+{
+    char name[HAL_NAME_LEN + 1];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(name, sizeof(name), fmt, ap);
+    va_end(ap);
+    return hal_pin_float_new(name, dir, data_ptr_addr, comp_id);
+}
+
+void rtapi_print_msg(msg_level_t level, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
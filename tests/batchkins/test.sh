@@ -0,0 +1,15 @@
+#!/bin/sh
+# build compare.c with each realtime kinematics module in turn
+set -e
+for kins in trivkins:TRIVKINS corexykins:COREXYKINS \
+        xyzac-trt-kins:XYZAC_TRT xyzbc-trt-kins:XYZBC_TRT \
+        scarakins:SCARAKINS lineardeltakins:LINEARDELTAKINS; do
+    name=${kins%:*}
+    gcc -std=gnu99 -DRTAPI -I$EMC2_HOME/include \
+        -DKINS_NAME=\"$name\" -DKINS_TYPE=BATCHKINS_${kins#*:} \
+        compare.c halstub.c $EMC2_HOME/src/emc/kinematics/$name.c \
+        -L$EMC2_HOME/lib -Wl,-rpath,$EMC2_HOME/lib -lbatchkins -lm \
+        -o compare
+    ./compare
+done
+rm -f compare
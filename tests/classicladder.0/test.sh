@@ -0,0 +1,74 @@
+#!/bin/sh
+# runs each example program with its rungs compiled and with them
+# interpreted (--nocompile), from the same inputs, and compares the
+# outputs of every scan
+EXAMPLES=$EMC2_HOME/src/hal/classicladder/projects_examples
+TMPDIR=`mktemp -d /tmp/classicladder.XXXXXX`
+trap "rm -rf $TMPDIR" 0 1 2 3 9 15
+SCANS=2000
+
+pins() { # first, last, format
+    for i in `seq $1 $2`; do printf "$3" $i; done
+}
+
+run() { # program, output, classicladder options
+    {
+    echo "setexact_for_test_suite_only"
+    echo "loadrt threads name1=fast period1=1000000"
+    echo "loadrt classicladder_rt numBits=500 numWords=120" \
+        "numPhysInputs=50 numPhysOutputs=50"
+    echo "loadrt threadtest count=1"
+    echo "loadrt bitslice count=1 personality=32"
+    echo "loadrt conv_u32_s32 count=1"
+    echo "loadrt sampler cfg=`pins 1 21 b`,`pins 1 21 b`,`pins 1 8 b``pins 1 10 s`" \
+        "depth=8192,8192,8192"
+    # the inputs follow the bits of a counter of scans
+    echo "net count threadtest.0.count => bitslice.0.in conv-u32-s32.0.in"
+    echo "net count-s32 conv-u32-s32.0.out =>`pins 0 9 ' classicladder.0.s32in-%02d'`"
+    for k in `seq 0 31`; do
+        echo "net b$k bitslice.0.out-`printf %02d $k` =>" \
+            `pins $k 49 'x%d\n' | awk -F x 'NR % 32 == 1 { printf " classicladder.0.in-%02d", $2 }'`
+    done
+    for i in `seq 0 49`; do
+        echo "net out$i classicladder.0.out-`printf %02d $i` sampler.$((i / 21)).pin.$((i % 21))"
+    done
+    for i in `seq 0 9`; do
+        echo "net s32out$i classicladder.0.s32out-`printf %02d $i` sampler.2.pin.$((i + 8))"
+    done
+    echo "addf threadtest.0.increment fast"
+    echo "addf bitslice.0 fast"
+    echo "addf conv-u32-s32.0 fast"
+    echo "addf classicladder.0.refresh fast"
+    echo "addf sampler.0 fast"
+    echo "addf sampler.1 fast"
+    echo "addf sampler.2 fast"
+    echo "loadusr -w classicladder --nogui $3 $1"
+    echo "start"
+    echo "loadusr -w halsampler -c 0 -n $SCANS $TMPDIR/out.0"
+    echo "loadusr -w halsampler -c 1 -n $SCANS $TMPDIR/out.1"
+    echo "loadusr -w halsampler -c 2 -n $SCANS $TMPDIR/out.2"
+    } > $TMPDIR/run.hal
+    rm -f $TMPDIR/out.*
+    halrun -f $TMPDIR/run.hal 1>&2 || exit 1
+    paste -d ' ' $TMPDIR/out.0 $TMPDIR/out.1 $TMPDIR/out.2 > $2
+}
+
+changing=0
+for program in example.clp example2.clp example_many_sections.clp \
+        example_sequential.clp test_call_subroutines.clp \
+        IndexedVar_used_in_function.clp; do
+    run $EXAMPLES/$program $TMPDIR/compiled
+    run $EXAMPLES/$program $TMPDIR/interpreted --nocompile
+    if cmp -s $TMPDIR/compiled $TMPDIR/interpreted; then
+        echo "$program: same"
+    else
+        echo "$program: compiled rungs differ"
+        diff $TMPDIR/interpreted $TMPDIR/compiled | head -20 1>&2
+    fi
+    if [ `sort -u $TMPDIR/compiled | wc -l` -gt 1 ]; then
+        changing=$((changing + 1))
+    fi
+done
+if [ $changing -eq 0 ]; then
+    echo "the outputs never changed"
+fi
@@ -0,0 +1,123 @@
+// Write 1D and 2D compensation grid files, read them with
+// emcmotCompGridRead() and print the corrections emcmot_comp_grid_eval()
+// interpolates between their points, as motion would apply them.
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "compgrid.h"
+
+struct dim { int32_t joint, count; double origin, spacing; };
+
+static void write_grid(const char *file, int dims, const dim *dim,
+                       const std::vector<int32_t> &outputs,
+                       const std::vector<double> &values)
+{
+    FILE *fp = fopen(file, "wb");
+    int32_t n = dims, k = outputs.size();
+
+    fwrite(EMCMOT_COMP_GRID_MAGIC, 8, 1, fp);
+    fwrite(&n, sizeof(n), 1, fp);
+    fwrite(&k, sizeof(k), 1, fp);
+    for (int d = 0; d < dims; d++) {
+        fwrite(&dim[d].joint, sizeof(int32_t), 1, fp);
+        fwrite(&dim[d].count, sizeof(int32_t), 1, fp);
+        fwrite(&dim[d].origin, sizeof(double), 1, fp);
+        fwrite(&dim[d].spacing, sizeof(double), 1, fp);
+    }
+    fwrite(&outputs[0], sizeof(int32_t), k, fp);
+    fwrite(&values[0], sizeof(double), values.size(), fp);
+    fclose(fp);
+}
+
+static std::vector<char> buf(sizeof(emcmot_comp_grid_t) + 1000 * sizeof(float));
+static emcmot_comp_grid_t *grid = (emcmot_comp_grid_t *) &buf[0];
+
+static int read_grid(const char *file, long capacity)
+{
+    grid->capacity = capacity;
+    return emcmotCompGridRead(file, grid);
+}
+
+// the grid's value at a point: 0.01 x^2 and -x/100
+static double f1(int out, double x)
+{
+    return out ? -x / 100 : 0.01 * x * x;
+}
+
+// and in 2D: x y + x^2 / 4, of which only x^2 isn't bilinear
+static double f2(double x, double y)
+{
+    return x * y + x * x / 4;
+}
+
+int main()
+{
+    // 1D: joint 0 from -10 to 10 in steps of 5, correcting joints 0 and 2
+    dim d1[] = {{0, 5, -10, 5}};
+    std::vector<double> v1;
+    for (int i = 0; i < 5; i++) {
+        v1.push_back(f1(0, -10 + 5 * i));
+        v1.push_back(f1(1, -10 + 5 * i));
+    }
+    write_grid("grid1.bin", 1, d1, std::vector<int32_t>{0, 2}, v1);
+    if (read_grid("grid1.bin", 1000)) {
+        return 1;
+    }
+    printf("1D: %d outputs, joints %d and %d, %ld coefficients\n",
+           grid->outputs, grid->output_joint[0], grid->output_joint[1],
+           grid->size);
+    const double x1[] = {-20, -10, -7.5, -5, -1, 0, 2.5, 9, 10, 30};
+    for (double x : x1) {
+        double corr[2];
+        emcmot_comp_grid_eval(grid, &x, corr);
+        printf("%6.2f  %9.6f %9.6f\n", x, corr[0], corr[1]);
+    }
+
+    // 2D: joint 0 from 0 to 4 in steps of 2, joint 1 from -1 to 0.5 in
+    // steps of 0.5, correcting joint 1
+    dim d2[] = {{0, 3, 0, 2}, {1, 4, -1, 0.5}};
+    std::vector<double> v2;
+    for (int j = 0; j < 4; j++) {
+        for (int i = 0; i < 3; i++) {
+            v2.push_back(f2(2 * i, -1 + 0.5 * j));
+        }
+    }
+    write_grid("grid2.bin", 2, d2, std::vector<int32_t>{1}, v2);
+    if (read_grid("grid2.bin", 1000)) {
+        return 1;
+    }
+    printf("2D: %d output, joint %d, %ld coefficients\n",
+           grid->outputs, grid->output_joint[0], grid->size);
+    const double p2[][2] = {
+        {0, -1}, {2, 0}, {4, 0.5}, {1, -0.75}, {3, 0.25}, {0.5, -0.1},
+        {3.9, 0.45}, {-3, 2}, {6, -3}, {1, 9}};
+    for (auto &p : p2) {
+        double corr;
+        emcmot_comp_grid_eval(grid, p, &corr);
+        printf("%6.2f %6.2f  %9.6f\n", p[0], p[1], corr);
+    }
+
+    // between the points it is bilinear in each cell: exact for x y,
+    // and linear in x for x^2
+    double worst = 0;
+    for (double x = 0; x <= 4; x += 0.125) {
+        for (double y = -1; y <= 0.5; y += 0.0625) {
+            double p[2] = {x, y}, corr;
+            double x0 = floor(x / 2) * 2, x1 = x0 + 2;
+            if (x1 > 4) {
+                x0 = 2; x1 = 4;
+            }
+            double sq = (x0 * x0 * (x1 - x) + x1 * x1 * (x - x0)) / 2;
+            emcmot_comp_grid_eval(grid, p, &corr);
+            worst = fmax(worst, fabs(corr - (x * y + sq / 4)));
+        }
+    }
+    printf("2D: worst error inside the grid %s\n",
+           worst < 1e-5 ? "below 1e-5" : "too big");
+
+    // too big for the room motion has
+    printf("2D in 20 coefficients: %s\n",
+           read_grid("grid2.bin", 20) ? "refused" : "read");
+    return 0;
+}
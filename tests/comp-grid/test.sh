@@ -0,0 +1,6 @@
+#!/bin/sh
+set -e
+g++ -std=gnu++11 -I$EMC2_HOME/include -I$EMC2_HOME/src/emc/motion \
+    gridtest.cc $EMC2_HOME/src/emc/motion/compgrid.cc -o gridtest
+./gridtest
+rm -f gridtest grid1.bin grid2.bin
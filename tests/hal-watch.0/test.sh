@@ -0,0 +1,42 @@
+#!/bin/sh
+realtime start
+halcmd loadrt threads name1=fast period1=1000000
+halcmd loadrt watch
+halcmd addf watch.scan fast
+halcmd newsig s s32
+halcmd newsig f float
+halcmd start
+python <<EOF2
+import hal
+import subprocess
+h = hal.component("x")
+try:
+    p = h.newpin("out", hal.HAL_BIT, hal.HAL_OUT)
+    h.ready()
+    w = hal.watch(h, ["x.out", "s", "f"])
+
+    # the first scan reports everything, in no particular order
+    def show(changes):
+        print sorted(changes)
+
+    show(w.wait(5))
+    print w.wait(0.1)
+    h["out"] = 1
+    show(w.wait(5))
+    subprocess.call(["halcmd", "sets", "f", "2.5"])
+    show(w.wait(5))
+    subprocess.call(["halcmd", "sets", "s", "-3"])
+    subprocess.call(["halcmd", "sets", "s", "4"])
+    while True:
+        c = w.wait(5)
+        if not c or c[-1] == ("s", 4): break
+    print c[-1]
+except:
+    import traceback
+    print "Exception:", traceback.format_exc()
+    raise
+finally:
+    h.exit()
+EOF2
+halcmd stop
+realtime stop
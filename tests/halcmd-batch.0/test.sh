@@ -0,0 +1,9 @@
+#!/bin/sh
+realtime start
+halcmd -f good.hal
+if halcmd -f bad.hal 2>/dev/null; then
+    echo "failed batch was committed"
+fi
+halcmd save
+halcmd unload all
+realtime stop
@@ -0,0 +1,28 @@
+#!/bin/sh
+realtime start
+halcmd -f setup.hal
+halcmd snapshot snap.bin
+halcmd save > before.hal
+halcmd unload all
+
+halcmd restore snap.bin
+halcmd save > after.hal
+if cmp -s before.hal after.hal; then
+    echo "restore reproduces the configuration"
+fi
+halcmd unload all
+
+# stepgen loaded with other arguments: the modules and aliases the
+# restore added before noticing must be gone again
+halcmd loadrt stepgen step_type=1
+halcmd save > pre.hal
+if halcmd restore snap.bin 2>/dev/null; then
+    echo "mismatching snapshot was restored"
+fi
+halcmd save > post.hal
+if cmp -s pre.hal post.hal; then
+    echo "failed restore changes nothing"
+fi
+halcmd unload all
+realtime stop
+rm -f snap.bin before.hal after.hal pre.hal post.hal
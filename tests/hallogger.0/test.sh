@@ -0,0 +1,31 @@
+#!/bin/sh
+TMPDIR=`mktemp -d /tmp/hallogger.XXXXXX`
+trap "rm -rf $TMPDIR" 0 1 2 3 9 15
+
+cat > $TMPDIR/test.hal <<EOT
+loadrt threads name1=fast period1=100000 name2=slow period2=1000000
+loadrt threadtest count=2
+loadrt logger cfg=ub,u depth=16384,256
+
+net count <= threadtest.0.count
+net count => logger.0.pin.0
+net total threadtest.1.count => logger.1.pin.0
+setp logger.0.pin.1 1
+
+addf threadtest.0.increment fast
+addf threadtest.1.increment fast
+addf logger.0 fast
+addf logger.1 fast
+
+addf threadtest.0.reset slow
+
+start
+loadusr -w hallogger -n 3500 $TMPDIR/test.hlog
+# logger.1 has overrun its small FIFO long before this
+loadusr -w hallogger -c 1 -n 400 $TMPDIR/overrun.hlog
+EOT
+
+halrun -f $TMPDIR/test.hal 1>&2 || exit 1
+hallogdump -g $TMPDIR/test.hlog
+echo overrun
+hallogdump -g $TMPDIR/overrun.hlog
@@ -0,0 +1,67 @@
+#!/usr/bin/env python
+# Checks a halscope stream recording of threadtest.0.count, which counts
+# up by one every sample: the records must be well formed, and the data
+# must be consecutive apart from the samples a GAP record reports lost.
+import struct
+import sys
+
+HEADER, DATA, MINMAX, TRIGGER, GAP = range(5)
+
+data = open(sys.argv[1], "rb").read()
+if data[:8] != b"HALSCSTR":
+    print("bad magic")
+    sys.exit(1)
+pos = 16
+
+def record(pos):
+    return struct.unpack_from("=IIQ", data, pos) + (pos + 16,)
+
+def data_size(pos, count, nchan):
+    # scope_data_t is 4 or 8 bytes depending on real_t, find which size
+    # puts the matching MINMAX record right after this payload
+    for size in (8, 4):
+        end = pos + count * nchan * size
+        if end + 16 <= len(data):
+            kind, c, seq, _ = record(end)
+            if kind == MINMAX and c == count:
+                return size
+    return None
+
+sessions = samples = gaps = 0
+last = None
+nchan = 0
+while pos < len(data):
+    kind, count, seq, pos = record(pos)
+    if kind == HEADER:
+        sessions += 1
+        nchan = count
+        name = data[pos + 8 + 8:pos + 8 + 56].split(b"\0")[0]
+        pos += 8 + count * 56
+        last = None
+    elif kind == DATA:
+        size = data_size(pos, count, nchan)
+        if size is None:
+            print("DATA record at %d without MINMAX" % pos)
+            sys.exit(1)
+        for n in range(count):
+            value = struct.unpack_from("=I", data, pos + n * nchan * size)[0]
+            if last is not None and value != (last + 1) & 0xffffffff:
+                print("sample %d: %d follows %d" % (seq + n, value, last))
+                sys.exit(1)
+            last = value
+        samples += count
+        pos += count * nchan * size
+    elif kind == MINMAX:
+        pos += nchan * 2 * 8
+    elif kind == TRIGGER:
+        pass
+    elif kind == GAP:
+        gaps += 1
+        last = None
+    else:
+        print("unknown record kind %d" % kind)
+        sys.exit(1)
+
+print("recorded: %s" % (sessions > 0))
+print("channel: %s" % name.decode())
+print("enough samples: %s" % (samples > 10000))
@@ -0,0 +1,26 @@
+#!/bin/sh
+TMPDIR=`mktemp -d /tmp/halscope-stream.XXXXXX`
+trap "rm -rf $TMPDIR" 0 1 2 3 9 15
+
+cat > $TMPDIR/test.halscope <<EOT
+THREAD fast
+MAXCHAN 4
+HMULT 1
+CHAN 1
+PIN threadtest.0.count
+RMODE 0
+EOT
+
+realtime start
+halcmd loadrt threads name1=fast period1=100000
+halcmd loadrt threadtest count=1
+halcmd addf threadtest.0.increment fast
+halcmd start
+# record for a few seconds, SIGTERM makes halscope close the recording
+xvfb-run -a sh -c "halscope -i $TMPDIR/test.halscope \
+    -o $TMPDIR/out.halscope -r $TMPDIR/test.stream & \
+    sleep 5; kill -TERM \$!; wait \$!"
+halcmd stop
+realtime stop
+
+python checkstream.py $TMPDIR/test.stream
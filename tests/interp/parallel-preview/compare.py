@@ -0,0 +1,112 @@
+#!/usr/bin/env python
+# Parse a long generated program serially and with 4 worker processes,
+# and check that the preview canon gets the same calls in both.
+import os
+import random
+import shutil
+import sys
+import tempfile
+import gcode
+
+class Canon:
+    def __init__(self, parameter_file):
+        self.parameter_file = parameter_file
+        self.calls = []
+
+    def __getattr__(self, attr):
+        if attr.startswith('__'): raise AttributeError(attr)
+        def record(*args):
+            self.calls.append((attr,) + args)
+        return record
+
+    def next_line(self, linecode):
+        self.calls.append(('next_line', linecode.sequence_number,
+            linecode.gcodes, linecode.mcodes, linecode.feed_rate,
+            linecode.speed))
+
+    def get_external_length_units(self): return 0.03937007874015748
+    def get_external_angular_units(self): return 1.0
+    def get_axis_mask(self): return 0x3f # (x y z a b c)
+    def get_block_delete(self): return True
+    def get_pockets_max(self): return 10
+    def get_tool(self, pocket):
+        return pocket, 0., 0., 0.1 * pocket, 0., 0., 0., 0., 0., 0., \
+            pocket, 0., 0., 0
+    def check_abort(self): return False
+
+def program(f, lines):
+    r = random.Random(47)
+    f.write("G21 G17 G90 G94 F600 S1000\nG0 X0 Y0 Z0\n")
+    n = 2
+    linear = True # lines with just coordinates move like the last move
+    while n < lines:
+        k = r.randrange(100)
+        x, y, z = r.uniform(-50, 50), r.uniform(-50, 50), r.uniform(-5, 5)
+        if k < 45:
+            f.write("G1 X%.3f Y%.3f Z%.3f\n" % (x, y, z))
+            linear = True
+        elif k < 60:
+            f.write("%sX%.3f Y%.3f\n" % ("" if linear else "G1 ", x, y))
+            linear = True
+        elif k < 70:
+            f.write("G0 X%.3f Y%.3f Z%.3f A%.1f\n" % (x, y, z, r.uniform(0, 360)))
+            linear = True
+        elif k < 85:
+            # a full circle from wherever we are
+            f.write("G%d I%.3f J%.3f F%d\n" % (r.choice((2, 3)),
+                r.uniform(1, 10), r.uniform(1, 10), r.randrange(100, 1000)))
+            linear = False
+        elif k < 88:
+            f.write("G18 G3 X%.3f Z%.3f R%.3f\nG17\n" % (x, z, 200.0))
+            linear = False
+            n += 1
+        elif k < 91:
+            f.write("T%d M6\nG43\n" % r.randrange(1, 10))
+            n += 1
+        elif k < 94:
+            f.write("G10 L2 P%d X%.3f Y%.3f Z%.3f\n" % (r.randrange(1, 3),
+                r.uniform(-5, 5), r.uniform(-5, 5), r.uniform(-1, 1)))
+        elif k < 96:
+            f.write("G10 L1 P%d Z%.3f R%.3f\n" % (r.randrange(1, 10),
+                r.uniform(0, 20), r.uniform(0.5, 3)))
+        elif k < 98:
+            f.write("G%d\n" % r.choice((54, 55)))
+        else:
+            f.write("/M%d (block delete %d)\n" % (r.choice((7, 8, 9)), n))
+        n += 1
+    f.write("M2\n")
+    return n + 1
+
+def parse(name, parameters, jobs):
+    shutil.copy(parameters, parameters + ".run")
+    canon = Canon(parameters + ".run")
+    result, seq = gcode.parse(name, canon, [], "", jobs)
+    return result, seq, canon.calls
+
+tmp = tempfile.mkdtemp()
+try:
+    name = os.path.join(tmp, "program.ngc")
+    f = open(name, "w")
+    lines = program(f, 100000)
+    f.close()
+    parameters = os.path.join(tmp, "test.var")
+    open(parameters, "w").close()
+
+    serial = parse(name, parameters, 1)
+    parallel = parse(name, parameters, 4)
+    if serial[0] > gcode.MIN_ERROR:
+        raise SystemExit("%s at line %d" % (gcode.strerror(serial[0]), serial[1]))
+    print("%d lines, %d calls" % (lines, len(serial[2])))
+    if parallel[:2] != serial[:2]:
+        print("different result: %s, serial %s" % (parallel[:2], serial[:2]))
+    for i, (a, b) in enumerate(zip(parallel[2], serial[2])):
+        if a != b:
+            print("call %d differs: %s, serial %s" % (i, a, b))
+            break
+    else:
+        if len(parallel[2]) != len(serial[2]):
+            print("%d calls, serial %d" % (len(parallel[2]), len(serial[2])))
+        else:
+            print("same with 4 jobs")
+finally:
+    shutil.rmtree(tmp)
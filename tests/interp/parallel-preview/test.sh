@@ -0,0 +1,2 @@
+#!/bin/sh
+python compare.py
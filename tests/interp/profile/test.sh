@@ -0,0 +1,15 @@
+#!/bin/bash
+rs274 -i test.ini -P report -F folded -g main.ngc > /dev/null || exit 1
+
+# five calls of the four lines of sub.ngc, the three of the remap
+awk '$5 == "o<sub>" || $5 == "remap:m400" { print $5, "blocks:", $3 }' report
+
+# "stack;file:line microseconds", every stack starts at main.ngc
+if grep -qv '^main\.ngc\(;o<[a-z0-9_]*>\|;remap:[a-z0-9_]*\)*;[a-z0-9_]*\.ngc:[0-9]* [0-9]*$' folded; then
+    echo "malformed folded stacks:"
+    cat folded
+fi
+grep -q '^main\.ngc;o<sub>;sub\.ngc:2 ' folded && echo "sub line in folded stacks"
+grep -q '^main\.ngc;remap:m400;m400\.ngc:2 ' folded && echo "remap line in folded stacks"
+rm -f report folded
+exit 0
@@ -0,0 +1,64 @@
+#!/usr/bin/env python
+
+import linuxcnc
+
+import os
+import sys
+import time
+
+
+#
+# connect to LinuxCNC
+#
+
+c = linuxcnc.command()
+s = linuxcnc.stat()
+e = linuxcnc.error_channel()
+
+def wait_idle():
+    c.wait_complete()
+    while True:
+        s.poll()
+        if s.interp_state == linuxcnc.INTERP_IDLE:
+            return
+        time.sleep(.01)
+
+
+#
+# Come out of E-stop, turn the machine on, and switch to Auto mode.
+#
+
+c.state(linuxcnc.STATE_ESTOP_RESET)
+c.state(linuxcnc.STATE_ON)
+c.mode(linuxcnc.MODE_AUTO)
+
+
+#
+# run $PROGRAM
+#
+
+c.program_open(os.environ['PROGRAM'])
+c.auto(linuxcnc.AUTO_RUN, 0)
+wait_idle()
+
+
+#
+# $REFUSE was made with the offsets the program started from, which it
+# changed; task must not run it
+#
+
+if 'REFUSE' in os.environ:
+    c.program_open(os.environ['REFUSE'])
+    c.wait_complete()
+    start = time.time()
+    while time.time() - start < 5:
+        error = e.poll()
+        if error:
+            print error[1]
+            if 'other offsets' in error[1]:
+                sys.exit(0)
+        time.sleep(.01)
+    print "%s was not refused" % os.environ['REFUSE']
+    sys.exit(1)
+
+sys.exit(0)
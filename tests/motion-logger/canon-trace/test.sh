@@ -0,0 +1,15 @@
+#!/bin/bash -e
+
+rm -f out.motion-logger result.* program.trace
+
+# every run starts from the same offsets; the program changes them
+cp pristine.params test.var
+rs274 -t tool.tbl -v test.var -o program.trace program.ngc /dev/null
+
+cp pristine.params test.var
+PROGRAM=program.ngc REFUSE=program.trace linuxcnc -r test.ini
+mv out.motion-logger result.direct
+
+cp pristine.params test.var
+PROGRAM=program.trace linuxcnc -r test.ini
+mv out.motion-logger result.trace
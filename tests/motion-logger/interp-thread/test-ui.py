@@ -0,0 +1 @@
+../mountaindew/test-ui.py
\ No newline at end of file
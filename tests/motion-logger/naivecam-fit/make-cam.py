@@ -0,0 +1,71 @@
+#!/usr/bin/env python
+# Generates cam.ngc, a stand-in for dense CAM output: every contour is
+# sampled into short G1 moves the way most posts emit surface finishing
+# passes.  Rerun this script after changing it and commit the result.
+
+import math
+
+out = open("cam.ngc", "w")
+def w(s):
+    out.write(s + "\n")
+
+def p(x, y, z):
+    w("G1 X%.4f Y%.4f Z%.4f" % (x, y, z))
+
+w("G21 G17 G90 G40 G49")
+w("G64 P0.02 Q0.01")
+w("F1200")
+w("G0 X10 Y0 Z1")
+w("G1 Z-1")
+
+# Circular finishing pass, 0.1mm chords
+r = 10.0
+n = int(2 * math.pi * r / 0.1)
+for i in range(1, n + 1):
+    t = 2 * math.pi * i / n
+    p(r * math.cos(t), r * math.sin(t), -1)
+
+# Rounded rectangle with 0.05mm sampled fillets and straight sides
+# sampled at 0.5mm
+def line(x0, y0, x1, y1, z, step):
+    m = max(1, int(math.hypot(x1 - x0, y1 - y0) / step))
+    for i in range(1, m + 1):
+        p(x0 + (x1 - x0) * i / m, y0 + (y1 - y0) * i / m, z)
+
+def fillet(cx, cy, rad, a0, a1, z, step):
+    m = max(1, int(abs(a1 - a0) * rad / step))
+    for i in range(1, m + 1):
+        a = a0 + (a1 - a0) * i / m
+        p(cx + rad * math.cos(a), cy + rad * math.sin(a), z)
+
+w("G0 Z1")
+w("G0 X20 Y-15")
+w("G1 Z-1")
+line(20, -15, 40, -15, -1, 0.5)
+fillet(40, -10, 5, -math.pi / 2, 0, -1, 0.05)
+line(45, -10, 45, 10, -1, 0.5)
+fillet(40, 10, 5, 0, math.pi / 2, -1, 0.05)
+line(40, 15, 20, 15, -1, 0.5)
+fillet(20, 10, 5, math.pi / 2, math.pi, -1, 0.05)
+line(15, 10, 15, -10, -1, 0.5)
+fillet(20, -10, 5, math.pi, 3 * math.pi / 2, -1, 0.05)
+
+# Free-form contour in the XZ plane, like a 3D finishing raster
+w("G0 Z1")
+w("G0 X-30 Y30")
+w("G1 Z0")
+for i in range(1, 601):
+    x = -30 + 60.0 * i / 600
+    p(x, 30, 3 * math.sin(x / 6.0) + 0.5 * math.sin(x / 2.0))
+
+# Helical ramp: not planar, so it may only be joined as lines
+w("G0 Z1")
+w("G0 X5 Y-30")
+w("G1 Z0")
+for i in range(1, 721):
+    t = 2 * math.pi * i / 360
+    p(5 * math.cos(t), -30 + 5 * math.sin(t), -i / 360.0)
+
+w("G0 Z1")
+w("M2")
+out.close()
@@ -0,0 +1,71 @@
+#!/usr/bin/env python
+
+import linuxcnc
+import subprocess
+import sys
+import time
+
+
+def getp(name):
+    value = subprocess.check_output(["halcmd", "getp", name]).strip()
+    if value in ("TRUE", "FALSE"):
+        return value == "TRUE"
+    return int(value)
+
+def hist(stage):
+    return [getp("motion.servo.%s.hist-%02d" % (stage, n)) for n in range(12)]
+
+def fail(msg):
+    print msg
+    sys.exit(1)
+
+
+c = linuxcnc.command()
+s = linuxcnc.stat()
+e = linuxcnc.error_channel()
+
+c.state(linuxcnc.STATE_ESTOP_RESET)
+c.state(linuxcnc.STATE_ON)
+c.mode(linuxcnc.MODE_AUTO)
+
+# the trajectory planner only runs in coordinated mode, so its time is
+# non-zero while the program moves
+c.program_open("test.ngc")
+c.auto(linuxcnc.AUTO_RUN, 0)
+tp_time = 0
+start = time.time()
+while time.time() - start < 10:
+    tp_time = max(tp_time, getp("motion.servo.tp.time"))
+    s.poll()
+    if s.interp_state == linuxcnc.INTERP_IDLE and tp_time:
+        break
+    time.sleep(.01)
+if not tp_time:
+    fail("motion.servo.tp.time stayed 0")
+
+for stage in ("inputs", "pos-cmds", "tp", "output"):
+    if getp("motion.servo.%s.tmax" % stage) == 0:
+        fail("motion.servo.%s.tmax is 0" % stage)
+    if sum(hist(stage)) == 0:
+        fail("motion.servo.%s.hist-NN are all 0" % stage)
+
+# with the machine off the planner doesn't run, so after a reset its
+# maximum stays 0 and every cycle counts in hist-00
+c.state(linuxcnc.STATE_OFF)
+c.wait_complete()
+start = time.time()
+while getp("motion.servo.tp.time") and time.time() - start < 5:
+    time.sleep(.01)
+subprocess.check_call(["halcmd", "setp", "motion.servo.stage-reset", "1"])
+time.sleep(.1)
+if getp("motion.servo.stage-reset"):
+    fail("motion.servo.stage-reset was not cleared")
+if getp("motion.servo.tp.tmax"):
+    fail("motion.servo.tp.tmax was not reset")
+if sum(hist("tp")[1:]):
+    fail("motion.servo.tp.hist-01 and up were not reset")
+if hist("tp")[0] == 0:
+    fail("motion.servo.tp.hist-00 does not count idle cycles")
+
+print "stage times ok"
+sys.exit(0)
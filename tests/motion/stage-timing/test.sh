@@ -0,0 +1,5 @@
+#!/bin/bash
+
+linuxcnc -r motion-test.ini
+exit $?
+
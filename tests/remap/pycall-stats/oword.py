@@ -0,0 +1,2 @@
+def square(self, x):
+    return x * x
@@ -0,0 +1,15 @@
+from interpreter import INTERP_OK
+
+def m410(self, **words):
+    self.execute("(m410 first version)")
+    return INTERP_OK
+
+def m410_again(self, **words):
+    self.execute("(m410 second version)")
+    return INTERP_OK
+
+# calls per handler, leaving out the timings which vary from run to run
+def show_stats(self):
+    stats = self.pycall_stats
+    print("pycall_stats: %s" % ", ".join(["%s=%d" % (k, stats[k][0])
+                                          for k in sorted(stats.keys())]))
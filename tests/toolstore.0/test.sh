@@ -0,0 +1,11 @@
+#!/bin/sh
+set -xe
+
+TOPDIR=`readlink -f ../..`
+INCLUDE=$TOPDIR/include
+LIB=$TOPDIR/lib
+
+g++ -o toolstore-test toolstore-test.cc \
+    -I $INCLUDE -L $LIB -Wl,-rpath,$LIB -llinuxcnc -lnml
+./toolstore-test
+rm -f toolstore-test
@@ -0,0 +1,96 @@
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <stdio.h>
+#include "emc_nml.hh"
+#include "toolstore.hh"
+
+// the fixed size of the tool table before ToolStore
+#define OLD_POCKETS_MAX 56
+
+static void show(const char *what, const ToolStore &s) {
+    printf("%s: %d pockets, T1 in %d, T2 in %d, T100 in %d, T200 in %d\n",
+        what, s.pockets(), s.find(1), s.find(2), s.find(100), s.find(200));
+}
+
+static CANON_TOOL_TABLE tool(int toolno, double z) {
+    CANON_TOOL_TABLE t = ToolStore().get(0);
+    t.toolno = toolno;
+    t.offset.tran.z = z;
+    return t;
+}
+
+int main() {
+    EMC_TOOL_STAT stat;
+    ToolStore owner, follower;
+    FILE *fp;
+
+    // random toolchanger: P is the pocket, so P100 grows the table
+    fp = fopen("random.tbl", "w");
+    fprintf(fp, "T1 P1 Z1 ;one\nT2 P2 Z2 ;two\nT100 P100 Z100 ;hundred\n");
+    fclose(fp);
+
+    owner.load("random.tbl", 1);
+    owner.publish(stat);
+    printf("load: serial %d, changes %d\n", stat.toolTableSerial, stat.changes);
+    printf("follow: %d\n", follower.follow(stat));
+    show("follower", follower);
+    printf("follow again: %d\n", follower.follow(stat));
+
+    // one pocket past the old limit, sent as a change
+    owner.set(OLD_POCKETS_MAX + 144, tool(200, 200));
+    owner.publish(stat);
+    printf("set: serial %d, changes %d\n", stat.toolTableSerial, stat.changes);
+    printf("follow: %d\n", follower.follow(stat));
+    show("follower", follower);
+    printf("T200 z: %g\n", follower.get(follower.find(200)).offset.tran.z);
+
+    // more pockets than fit in one status: save and reload
+    owner.swap(1, 2);
+    owner.set(150, tool(150, 150));
+    owner.set(60, tool(100, 60));
+    owner.save("random.tbl", 1);
+    owner.publish(stat);
+    printf("save: serial %d, changes %d\n", stat.toolTableSerial, stat.changes);
+    printf("follow: %d\n", follower.follow(stat));
+    show("follower", follower);
+    printf("pocket 60: T%d z %g, pocket 150: T%d\n",
+        follower.get(60).toolno, follower.get(60).offset.tran.z,
+        follower.get(150).toolno);
+
+    // a follower that missed a serial reloads too
+    ToolStore late;
+    owner.set(3, tool(3, 3));
+    owner.save("random.tbl", 1);
+    owner.publish(stat);
+    owner.set(4, tool(4, 4));
+    owner.save("random.tbl", 1);
+    owner.publish(stat);
+    printf("late follow: %d\n", late.follow(stat));
+    show("late", late);
+
+    // nonrandom toolchanger: swap() carries the P word along
+    fp = fopen("nonrandom.tbl", "w");
+    fprintf(fp, "T1 P5 ;five\nT2 P7 ;seven\n");
+    fclose(fp);
+    owner.load("nonrandom.tbl", 0);
+    owner.swap(1, 2);
+    printf("swapped: T%d P%d %s, T%d P%d %s\n",
+        owner.get(1).toolno, owner.fms(1), owner.comment(1),
+        owner.get(2).toolno, owner.fms(2), owner.comment(2));
+
+    remove("random.tbl");
+    remove("nonrandom.tbl");
+    return 0;
+}
@@ -0,0 +1,30 @@
+#!/bin/sh
+used() {
+    halcmd status mem | sed -n 's|.*used/total shared memory: *\([0-9]*\)/.*|\1|p'
+}
+
+cycle() {
+    halcmd loadrt stepgen step_type=0,2 ctrl_type=p,v
+    halcmd net cycle-sig stepgen.0.counts
+    halcmd setp stepgen.1.position-scale 100
+    halcmd unloadrt stepgen
+    halcmd delsig cycle-sig
+}
+
+realtime start
+# the first cycle leaves reusable structs on the free lists, take the
+# baseline after it
+cycle
+base=`used`
+i=0
+while [ $i -lt 20 ]; do
+    cycle
+    i=$((i+1))
+done
+now=`used`
+if [ "$now" = "$base" ]; then
+    echo "shared memory back to baseline"
+else
+    echo "shared memory used went from $base to $now"
+fi
+realtime stop